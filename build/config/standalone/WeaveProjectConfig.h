@@ -31,15 +31,50 @@
 
 #define WEAVE_CONFIG_EVENT_LOGGING_NUM_EXTERNAL_CALLBACKS 2
 
+// Let up to 4 application threads stage events without contending on the event log.
+#define WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS 4
+
+// Enable keeping the event log in a memory-mapped file (e.g. MappedFileEventLog).
+#define WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE 1
+
+// Offer to compress events uploaded over BDX.
+#define WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION 1
 
 #define WDM_UPDATE_MAX_ITEMS_IN_TRAIT_DIRTY_PATH_STORE 300
 
+// Index the paths pending update, so that bulk updates do not scan the whole set for every path.
+#define WDM_UPDATE_PENDING_SET_INDEX_SIZE 1024
+
+// Share encoded data elements between subscriptions to the same trait instance.
+#define WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE 8
+
+// Read new events out of the log once for all the subscriptions that are caught up to them.
+#define WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE 1024
+
+// Allocate the subscription handler and trait instance pools from the heap.  Build with
+// -DWDM_PUBLISHER_ENABLE_DYNAMIC_POOLS=0 to test the statically allocated pools instead.
+#ifndef WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+#define WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS 1
+#endif
+
+// Let each established subscription pipeline up to 4 notifies.
+#define WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION 4
+
+// Let the publisher checkpoint its subscriptions and resume them after a restart.
+#define WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT 1
+
 // Uncomment this for a large Tunnel MTU.
 //#define WEAVE_CONFIG_TUNNEL_INTERFACE_MTU                           (9000)
 
 // Max number of Bindings per WeaveExchangeManager
 #define WEAVE_CONFIG_MAX_BINDINGS 8
 
+// Decode up to 8 messages per TCP read together.
+#define WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE 8
+
+// Enable saving session keys in a session key store (e.g. MappedFileSessionKeyStore).
+#define WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE 1
+
 // Enable support functions for parsing command-line arguments
 #define WEAVE_CONFIG_ENABLE_ARG_PARSER 1
 
@@ -199,6 +199,8 @@ public:
     void SetEventCallback(EventCallback aEventCallback);
     WeaveConnection *GetConnection() const;
     WeaveExchangeManager *GetExchangeManager() const;
+    bool IsUDPTransport(void) const;
+    bool IsWRMTransport(void) const;
 
     enum
     {
@@ -557,6 +559,16 @@ inline WeaveConnection *Binding::GetConnection() const
     return mCon;
 }
 
+inline bool Binding::IsUDPTransport(void) const
+{
+    return mTransportOption == kTransport_UDP || mTransportOption == kTransport_UDP_WRM;
+}
+
+inline bool Binding::IsWRMTransport(void) const
+{
+    return mTransportOption == kTransport_UDP_WRM;
+}
+
 inline bool Binding::GetFlag(uint8_t flag) const
 {
     return (mFlags & flag) != 0;
@@ -30,6 +30,7 @@
 #define __STDC_LIMIT_MACROS
 #endif
 #include <stdint.h>
+#include <string.h>
 
 #include <Weave/Core/WeaveCore.h>
 #include <Weave/Core/WeaveEncoding.h>
@@ -129,6 +130,94 @@ exit:
     return err;
 }
 
+/**
+ * @brief
+ *   Copies the leading bytes of the WeaveCircularTLVBuffer to the
+ *   end of another WeaveCircularTLVBuffer
+ *
+ * The bytes are copied as they are, without being parsed, so the
+ * caller is expected to pass the length of one or more whole
+ * top-level elements.  No element is evicted from the destination to
+ * make space for the copy, and this buffer is left unchanged.
+ *
+ * @param[inout] ioDestination The buffer to copy the bytes to.
+ *
+ * @param[in] inLength         The number of bytes to copy.
+ *
+ * @retval #WEAVE_NO_ERROR               On success.
+ *
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT This buffer holds fewer than
+ *                                       inLength bytes.
+ *
+ * @retval #WEAVE_ERROR_NO_MEMORY        The destination does not have
+ *                                       inLength bytes available.
+ */
+WEAVE_ERROR WeaveCircularTLVBuffer::CopyHead(WeaveCircularTLVBuffer &ioDestination, size_t inLength)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    size_t copied = 0;
+
+    VerifyOrExit(inLength <= mQueueLength, err = WEAVE_ERROR_INVALID_ARGUMENT);
+    VerifyOrExit(inLength <= ioDestination.AvailableDataLength(), err = WEAVE_ERROR_NO_MEMORY);
+
+    // Either side may wrap around, so copy in up to three contiguous pieces.
+    while (copied < inLength)
+    {
+        const size_t srcOffset = ((mQueueHead - mQueue) + copied) % mQueueSize;
+        uint8_t *dst = ioDestination.QueueTail();
+        size_t len = inLength - copied;
+
+        if (len > mQueueSize - srcOffset)
+        {
+            len = mQueueSize - srcOffset;
+        }
+
+        if (len > ioDestination.mQueueSize - static_cast<size_t>(dst - ioDestination.mQueue))
+        {
+            len = ioDestination.mQueueSize - (dst - ioDestination.mQueue);
+        }
+
+        memcpy(dst, mQueue + srcOffset, len);
+
+        ioDestination.mQueueLength += len;
+        copied += len;
+    }
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   Restores the state of a WeaveCircularTLVBuffer whose backing store
+ *   has outlived it, e.g. because it is kept in a file.
+ *
+ * The data is not checked; the caller is expected to have saved the
+ * state from QueueHead() and DataLength() along with it.
+ *
+ * @param[in] inHeadOffset   Offset of the head of the queue in the
+ *                           backing store.
+ *
+ * @param[in] inDataLength   Length of the data in the queue.
+ *
+ * @retval #WEAVE_NO_ERROR               On success.
+ *
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT The state does not fit in the
+ *                                       backing store.
+ */
+WEAVE_ERROR WeaveCircularTLVBuffer::Restore(size_t inHeadOffset, size_t inDataLength)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(inHeadOffset < mQueueSize && inDataLength <= mQueueSize, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    mQueueHead = mQueue + inHeadOffset;
+    mQueueLength = inDataLength;
+
+exit:
+    return err;
+}
+
 /**
  * @brief
  *   Get additional space for the TLVWriter.  In actuality, the
@@ -435,6 +524,7 @@ void CircularTLVReader::Init(WeaveCircularTLVBuffer *buf)
     mElemTag = AnonymousTag;
     mElemLenOrVal = 0;
     mContainerType = kTLVType_NotSpecified;
+    mIndex = NULL;
     SetContainerOpen(false);
     ImplicitProfileId = kProfileIdNotSpecified;
     AppData = NULL;
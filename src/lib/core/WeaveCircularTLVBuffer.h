@@ -70,6 +70,8 @@ public:
     inline size_t GetQueueSize(void) { return mQueueSize; }
 
     WEAVE_ERROR EvictHead(void);
+    WEAVE_ERROR CopyHead(WeaveCircularTLVBuffer &ioDestination, size_t inLength);
+    WEAVE_ERROR Restore(size_t inHeadOffset, size_t inDataLength);
 
     static WEAVE_ERROR GetNewBufferFunct(TLVWriter& ioWriter, uintptr_t& inBufHandle, uint8_t *& outBufStart, uint32_t& outBufLen);
     static WEAVE_ERROR FinalizeBufferFunct(TLVWriter& ioWriter, uintptr_t inBufHandle, uint8_t *inBufStart, uint32_t inBufLen);
@@ -754,17 +754,41 @@
 #define WEAVE_CONFIG_AES_USE_EXPANDED_KEY                   0
 #endif // WEAVE_CONFIG_AES_USE_EXPANDED_KEY
 
+/**
+ *  @def WEAVE_CONFIG_AES_CTR_BULK_BLOCK_COUNT
+ *
+ *  @brief
+ *    The number of counter blocks the CTR mode implementation
+ *    encrypts per iteration when processing large inputs.
+ *
+ *    When the AES-NI implementation is enabled the blocks are run
+ *    through the AES rounds interleaved, keeping the AES unit's
+ *    pipeline full.  Other implementations encrypt the blocks one at a
+ *    time, but still benefit from the wide XOR of the keystream into
+ *    the payload.  The CTR mode object uses this many blocks of stack
+ *    space for the keystream buffer.
+ *
+ */
+#ifndef WEAVE_CONFIG_AES_CTR_BULK_BLOCK_COUNT
+#if WEAVE_CONFIG_AES_IMPLEMENTATION_AESNI
+#define WEAVE_CONFIG_AES_CTR_BULK_BLOCK_COUNT               8
+#else
+#define WEAVE_CONFIG_AES_CTR_BULK_BLOCK_COUNT               1
+#endif
+#endif // WEAVE_CONFIG_AES_CTR_BULK_BLOCK_COUNT
+
 
 /**
  *  @name Weave SHA1 and SHA256 Hash Algorithms Implementation Configuration.
  *
  *  @brief
- *    The following definitions enable one of three potential Weave
+ *    The following definitions enable one of four potential Weave
  *    hash implementation options:
  *
  *      * #WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM
  *      * #WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT
  *      * #WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL
+ *      * #WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
  *
  *    Note that these options are mutually exclusive and only one of
  *    these options should be set.
@@ -780,8 +804,9 @@
  *    implementation of the Weave SHA1 and SHA256 hashes.
  *
  *  @note This configuration is mutual exclusive with
- *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT and
- *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL.
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT,
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL and
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE.
  *
  */
 #ifndef WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM
@@ -798,8 +823,9 @@
  *    mincrypt library of Android core.
  *
  *  @note This configuration is mutual exclusive with
- *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM and
- *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL.
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM,
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL and
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE.
  *
  */
 #ifndef WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT
@@ -814,21 +840,45 @@
  *    implementation of the Weave SHA1 and SHA256 hash functions.
  *
  *  @note This configuration is mutual exclusive with
- *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM and
- *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT.
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM,
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT and
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE.
  *
  */
 #ifndef WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL
 #define WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL            1
 #endif // WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL
 
+/**
+ *  @def WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+ *
+ *  @brief
+ *    Enable (1) or disable (0) support for a Weave-provided native
+ *    implementation of the Weave SHA1 and SHA256 hash functions.
+ *
+ *    On x86 targets built with GCC or Clang, the implementation
+ *    probes the CPU on first use and selects SHA-NI block functions
+ *    when available, falling back to portable C otherwise.  Hashing
+ *    of multiple independent messages through AddDataMultiple() is
+ *    spread across AVX2 lanes on CPUs that have AVX2 but not SHA-NI.
+ *
+ *  @note This configuration is mutual exclusive with
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM,
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT and
+ *        #WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL.
+ *
+ */
+#ifndef WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+#define WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE             0
+#endif // WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+
 /**
  *  @}
  */
 
-#if ((WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM + WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT + WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL) != 1)
-#error "Please assert exactly one of WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM, WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT, or WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL."
-#endif // ((WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM + WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT + WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL) != 1)
+#if ((WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM + WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT + WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL + WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE) != 1)
+#error "Please assert exactly one of WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM, WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT, WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL, or WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE."
+#endif // ((WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM + WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT + WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL + WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE) != 1)
 
 
 /**
@@ -941,6 +991,25 @@
 #define WEAVE_CONFIG_MAX_TUNNELS                            1
 #endif // WEAVE_CONFIG_MAX_TUNNELS
 
+/**
+ *  @def WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE
+ *
+ *  @brief
+ *    Maximum number of messages a Weave connection decodes together
+ *    when a single read delivers several complete messages.
+ *
+ *    Messages in a batch are decrypted reusing the expanded AES key of
+ *    the previous message when they share a session key, and their
+ *    integrity checks are computed together with
+ *    HMACSHA1::AddDataMultiple().  Each batch entry costs roughly 250
+ *    bytes of stack in the connection receive path.  A value of 1
+ *    decodes messages one at a time.
+ *
+ */
+#ifndef WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE
+#define WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE                  1
+#endif // WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE
+
 /**
  *  @def WEAVE_CONFIG_MAX_SESSION_KEYS
  *
@@ -952,6 +1021,52 @@
 #define WEAVE_CONFIG_MAX_SESSION_KEYS                       WEAVE_CONFIG_MAX_CONNECTIONS
 #endif // WEAVE_CONFIG_MAX_SESSION_KEYS
 
+/**
+ *  @def WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+ *
+ *  @brief
+ *    Enable support for saving established session keys in an external
+ *    session key store (see WeaveSessionKeyStoreBase).
+ *
+ *    When a store is attached to the fabric state, session keys that are
+ *    not bound to a connection are saved as they are established and
+ *    looked up in the store when not found in the session key table.
+ *    This allows sessions to survive a restart and to be shared by several
+ *    processes serving the same node id.
+ *
+ */
+#ifndef WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+#define WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE               0
+#endif // WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+
+/**
+ *  @def WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS
+ *
+ *  @brief
+ *    Number of session key records in a file created by
+ *    MappedFileSessionKeyStore.
+ *
+ */
+#ifndef WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS
+#define WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS 256
+#endif // WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS
+
+/**
+ *  @def WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MSG_ID_EPOCH
+ *
+ *  @brief
+ *    Number of message ids MappedFileSessionKeyStore reserves for a
+ *    stored session each time the file is synced to disk.
+ *
+ *    Following a crash, message ids for the session resume at the end
+ *    of the last reserved block.  Larger values reduce the number of disk
+ *    syncs at the cost of skipping more message ids after a crash.
+ *
+ */
+#ifndef WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MSG_ID_EPOCH
+#define WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MSG_ID_EPOCH 1024
+#endif // WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MSG_ID_EPOCH
+
 /**
  *  @def WEAVE_CONFIG_MAX_APPLICATION_EPOCH_KEYS
  *
@@ -34,6 +34,7 @@
 #include <inttypes.h>
 
 #include <Weave/Core/WeaveCore.h>
+#include <Weave/Support/crypto/WeaveCrypto.h>
 #include <Weave/Support/logging/WeaveLogging.h>
 #include <Weave/Support/CodeUtils.h>
 
@@ -1281,6 +1282,13 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
     WEAVE_ERROR err;
     WeaveConnection *con = (WeaveConnection *) endPoint->AppState;
     WeaveMessageLayer *msgLayer = con->MessageLayer;
+    IPPacketInfo packetInfo;
+    WeaveMessageLayer::DecodedMessage decodedMsgs[WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE];
+    uint8_t numDecodedMsgs = 0;
+    uint8_t nextDecodedMsg = 0;
+
+    packetInfo.Clear();
+    con->GetPeerAddressInfo(packetInfo);
 
     // While in a state that allows receiving, process the received data...
     while (data != NULL &&
@@ -1292,22 +1300,31 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
 #endif
           ))
     {
-        IPPacketInfo        packetInfo;
-        WeaveMessageInfo    msgInfo;
+        WeaveMessageInfo*   msgInfo;
         uint8_t*            payload;
         uint16_t            payloadLen;
         PacketBuffer*       payloadBuf = NULL;
         uint16_t            frameLen;
 
-        packetInfo.Clear();
-        con->GetPeerAddressInfo(packetInfo);
+        // Once all previously decoded messages have been dispatched, attempt to decode a batch of
+        // messages from the head of the received data.
+        if (nextDecodedMsg == numDecodedMsgs)
+        {
+            for (uint8_t i = 0; i < WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE; i++)
+            {
+                decodedMsgs[i].MsgInfo.Clear();
+                decodedMsgs[i].MsgInfo.InPacketInfo = &packetInfo;
+                decodedMsgs[i].MsgInfo.InCon = con;
+            }
 
-        msgInfo.Clear();
-        msgInfo.InPacketInfo = &packetInfo;
-        msgInfo.InCon = con;
+            nextDecodedMsg = 0;
+            err = msgLayer->DecodeMessagesWithLength(data, con->PeerNodeId, con, decodedMsgs, WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE,
+                                                     &numDecodedMsgs, &frameLen);
+        }
+        else
+            err = WEAVE_NO_ERROR;
 
-        // Attempt to parse an message from the head of the received data.
-        err = msgLayer->DecodeMessageWithLength(data, con->PeerNodeId, con, &msgInfo, &payload, &payloadLen, &frameLen);
+        msgInfo = &decodedMsgs[nextDecodedMsg].MsgInfo;
 
         // If the data buffer contains only part of a message...
         if (err == WEAVE_ERROR_MESSAGE_INCOMPLETE)
@@ -1331,6 +1348,21 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
                 break;
         }
 
+        // If we have a decoded message, remove it from the head of the received data and apply duplicate
+        // message detection to it.
+        if (err == WEAVE_NO_ERROR)
+        {
+            WeaveMessageLayer::DecodedMessage &decodedMsg = decodedMsgs[nextDecodedMsg++];
+
+            payload = decodedMsg.Payload;
+            payloadLen = decodedMsg.PayloadLen;
+            frameLen = decodedMsg.FrameLen;
+
+            data->SetStart(data->Start() + frameLen);
+
+            err = msgLayer->FinishDecodeMessage(decodedMsg, con);
+        }
+
         // If we successfully parsed a message, open the TCP receive window by the size of the message.
         if (err == WEAVE_NO_ERROR)
             err = endPoint->AckReceive(frameLen);
@@ -1338,7 +1370,7 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
         // Verify that destination node identifier refers to the local node.
         if (err == WEAVE_NO_ERROR)
         {
-            if (msgInfo.DestNodeId != msgLayer->FabricState->LocalNodeId && msgInfo.DestNodeId != kAnyNodeId)
+            if (msgInfo->DestNodeId != msgLayer->FabricState->LocalNodeId && msgInfo->DestNodeId != kAnyNodeId)
                 err = WEAVE_ERROR_INVALID_DESTINATION_NODE_ID;
         }
 
@@ -1386,7 +1418,7 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
                     data = NULL;
                 }
 
-                msgLayer->SecurityMgr->SendKeyErrorMsg(&msgInfo, NULL, con, err);
+                msgLayer->SecurityMgr->SendKeyErrorMsg(msgInfo, NULL, con, err);
             }
 
             con->DisconnectOnError(err);
@@ -1394,20 +1426,20 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
         }
 
         //Check if message carries tunneled data and needs to be sent to Tunnel Agent
-        if (msgInfo.MessageVersion == kWeaveMessageVersion_V2)
+        if (msgInfo->MessageVersion == kWeaveMessageVersion_V2)
         {
-            if (msgInfo.Flags & kWeaveMessageFlag_TunneledData)
+            if (msgInfo->Flags & kWeaveMessageFlag_TunneledData)
             {
 #if WEAVE_CONFIG_ENABLE_TUNNELING
                 // Dispatch the tunneled data message to the application if it is not a duplicate.
                 // Although TCP guarantees in-order, at-most-once delivery in normal conditions,
                 // checking for and eliminating duplicate tunneled messages here prevents replay
                 // of messages by a malicious man-in-the-middle.
-                if (!(msgInfo.Flags & kWeaveMessageFlag_DuplicateMessage))
+                if (!(msgInfo->Flags & kWeaveMessageFlag_DuplicateMessage))
                 {
                     if (con->OnTunneledMessageReceived)
                     {
-                        con->OnTunneledMessageReceived(con, &msgInfo, payloadBuf);
+                        con->OnTunneledMessageReceived(con, msgInfo, payloadBuf);
                     }
                     else
                     {
@@ -1421,7 +1453,7 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
             {
                 if (con->OnMessageReceived)
                 {
-                    con->OnMessageReceived(con, &msgInfo, payloadBuf);
+                    con->OnMessageReceived(con, msgInfo, payloadBuf);
                 }
                 else
                 {
@@ -1431,13 +1463,13 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
 
             }
         }
-        else if (msgInfo.MessageVersion == kWeaveMessageVersion_V1)
+        else if (msgInfo->MessageVersion == kWeaveMessageVersion_V1)
         {
             // Pass the message header and payload to the application.
             // NOTE that when this function returns, the state of the connection may have changed.
             if (con->OnMessageReceived)
             {
-                con->OnMessageReceived(con, &msgInfo, payloadBuf);
+                con->OnMessageReceived(con, msgInfo, payloadBuf);
             }
             else
             {
@@ -1459,6 +1491,9 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
             if (endPoint->State == TCPEndPoint::kState_Connected ||
                 endPoint->State == TCPEndPoint::kState_SendShutdown)
             {
+                // Re-encrypt any decoded messages that were not dispatched, so they are decoded again.
+                msgLayer->RestoreDecodedMessages(decodedMsgs + nextDecodedMsg, numDecodedMsgs - nextDecodedMsg);
+
                 endPoint->PutBackReceivedData(data);
                 data = NULL;
             }
@@ -1468,6 +1503,9 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
         if (data != NULL)
             PacketBuffer::Free(data);
     }
+
+    // Don't leave the message keys saved by the batch decode on the stack.
+    nl::Weave::Crypto::ClearSecretData((uint8_t *) decodedMsgs, sizeof(decodedMsgs));
 }
 
 void WeaveConnection::HandleTcpConnectionClosed(TCPEndPoint *endPoint, INET_ERROR err)
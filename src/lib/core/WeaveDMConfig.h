@@ -316,6 +316,25 @@
 #define WDM_PUBLISHER_MAX_NUM_PATH_GROUPS 8
 #endif // WDM_PUBLISHER_MAX_NUM_PATH_GROUPS
 
+/**
+ *  @def WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+ *
+ *  @brief
+ *    Enable (1) or disable (0) heap allocation of the publisher's
+ *    subscription handler and trait instance pools.
+ *
+ *    When enabled, the pools initially hold WDM_MAX_NUM_SUBSCRIPTION_HANDLERS
+ *    handlers and WDM_PUBLISHER_MAX_NUM_PATH_GROUPS trait instances.  Their
+ *    limits may be changed at run time with
+ *    SubscriptionEngine::ConfigurePublisherPools(), and the trait instance
+ *    pool grows on demand up to its limit.  When disabled, both pools are
+ *    statically allocated.
+ *
+ */
+#ifndef WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+#define WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS 0
+#endif // WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+
 /**
  *  @def WDM_CLIENT_MAX_NUM_UPDATABLE_TRAITS
  *
@@ -398,6 +417,49 @@
 #define WDM_PUBLISHER_INTERMEDIATE_SOLVER_MAX_MERGE_HANDLE_SET 4
 #endif
 
+/**
+ *  @def WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE
+ *
+ *  @brief
+ *    Determines the number of encoded data elements the notification engine keeps for reuse across
+ *    subscriptions. When several subscribers are notified of the same change to a trait instance, the
+ *    data element is encoded once and copied into the notifies of the other subscribers. Entries are
+ *    invalidated whenever the trait instance is marked dirty.
+ *
+ *    Set to 0 to disable the cache.
+ *
+ */
+#ifndef WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE
+#define WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE 0
+#endif
+
+/**
+ *  @def WDM_PUBLISHER_DATA_ELEMENT_CACHE_ENTRY_SIZE
+ *
+ *  @brief
+ *    Determines the maximum size, in bytes, of an encoded data element held in the data element cache.
+ *    Larger data elements are encoded separately for each subscription.
+ *
+ */
+#ifndef WDM_PUBLISHER_DATA_ELEMENT_CACHE_ENTRY_SIZE
+#define WDM_PUBLISHER_DATA_ELEMENT_CACHE_ENTRY_SIZE 256
+#endif
+
+/**
+ *  @def WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE
+ *
+ *  @brief
+ *    Determines the size, in bytes, of the encoded event list fragment the notification engine keeps for each
+ *    importance level. During a run of the notification engine, events are read out of the log once for all the
+ *    subscriptions that are caught up to the same event, and the fragment is copied into each of their notifies.
+ *
+ *    Set to 0 to read the log separately for each subscription.
+ *
+ */
+#ifndef WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE
+#define WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE 0
+#endif
+
 /**
  *  @def WDM_UPDATE_MAX_ITEMS_IN_TRAIT_DIRTY_PATH_STORE
  *
@@ -410,6 +472,20 @@
 #define WDM_UPDATE_MAX_ITEMS_IN_TRAIT_DIRTY_PATH_STORE  10
 #endif
 
+/**
+ *  @def WDM_UPDATE_PENDING_SET_INDEX_SIZE
+ *
+ *  @brief
+ *    Determines the number of entries of the index kept over the set of paths pending update. With an index,
+ *    adding a path to the set and checking a path against it take time proportional to the depth of the schema
+ *    rather than to the number of pending paths. Each pending path takes up to one entry per level of its path;
+ *    if the index fills up, the set falls back to scanning until it empties. Set to 0 to disable the index.
+ *
+ */
+#ifndef WDM_UPDATE_PENDING_SET_INDEX_SIZE
+#define WDM_UPDATE_PENDING_SET_INDEX_SIZE 0
+#endif
+
 /**
  *  @def WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT
  *
@@ -423,6 +499,80 @@
 #define WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT 4
 #endif
 
+/**
+ *  @def WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION
+ *
+ *  @brief
+ *    Controls the maximum number of notifies that an established subscription can have in flight at any given time. With a
+ *    value of 1, each notify waits for the previous one to be confirmed. Larger values let a subscription pipeline notifies to a
+ *    high-latency subscriber when its trait data or event backlog spans many packets; confirmations are still retired in order.
+ *    New subscriptions use the full depth; it can be lowered per subscription with SubscriptionHandler::SetNotifyPipelineDepth().
+ *    Priming notifies are always sent one at a time. Must not exceed 255.
+ *
+ */
+#ifndef WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION
+#define WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION 1
+#endif
+
+/**
+ *  @def WDM_PUBLISHER_DEFAULT_NOTIFY_MIN_INTERVAL_MSEC
+ *
+ *  @brief
+ *    The default notification coalescing interval for new subscriptions, in milliseconds. Data changes on an established
+ *    subscription are held until no further change has been seen for this long, so that rapid updates to the same
+ *    properties are merged into a single notify. Zero disables coalescing. Can be changed per subscription with
+ *    SubscriptionHandler::SetNotifyCoalescing().
+ *
+ */
+#ifndef WDM_PUBLISHER_DEFAULT_NOTIFY_MIN_INTERVAL_MSEC
+#define WDM_PUBLISHER_DEFAULT_NOTIFY_MIN_INTERVAL_MSEC 0
+#endif
+
+/**
+ *  @def WDM_PUBLISHER_DEFAULT_NOTIFY_MAX_LATENCY_MSEC
+ *
+ *  @brief
+ *    The default upper bound, in milliseconds, on how long a data change may be held for coalescing before it is
+ *    notified, regardless of further changes. Must not be less than WDM_PUBLISHER_DEFAULT_NOTIFY_MIN_INTERVAL_MSEC.
+ *
+ */
+#ifndef WDM_PUBLISHER_DEFAULT_NOTIFY_MAX_LATENCY_MSEC
+#define WDM_PUBLISHER_DEFAULT_NOTIFY_MAX_LATENCY_MSEC 0
+#endif
+
+/**
+ *  @def WDM_PUBLISHER_DEFAULT_DELTA_NOTIFICATIONS
+ *
+ *  @brief
+ *    Whether new subscriptions receive delta notifications by default. In delta mode, the intermediate graph solver sends
+ *    each changed property of a trait instance as its own data element, instead of a single data element at the lowest
+ *    common ancestor of the changes that also carries unchanged siblings, whenever doing so yields a smaller encoding.
+ *    Can be changed per subscription with SubscriptionHandler::SetDeltaNotifications().
+ *
+ */
+#ifndef WDM_PUBLISHER_DEFAULT_DELTA_NOTIFICATIONS
+#define WDM_PUBLISHER_DEFAULT_DELTA_NOTIFICATIONS 0
+#endif
+
+/**
+ *  @def WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+ *
+ *  @brief
+ *    Enable SubscriptionEngine::CheckpointSubscriptions() and SubscriptionEngine::RestoreSubscriptions(), with which a
+ *    publisher can save its established subscriptions before a restart and resume them afterwards, so that subscribers keep
+ *    receiving notifies without having to subscribe again. The application is responsible for storing the checkpoint.
+ *
+ *    The checkpoint records the version of each published trait instance, which is restored on resumption. The application
+ *    has to restore its published data before resuming subscriptions, and to make any later change through its data
+ *    sources, so that the restored versions match the data. Subscriptions secured with a CASE or PASE session can only be
+ *    resumed if the session is kept in a session key store (see #WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE); others are not
+ *    checkpointed, and their subscribers have to subscribe again.
+ *
+ */
+#ifndef WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+#define WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT 0
+#endif
+
 /**
  * The auto-generated schema tables key off this define to enable/disable certain fields in the tables. Enable this for now, but remove this define
  * once it has been similarly removed from the auto-generated code since all products are expected to need dictionary support, so the savings in flash/ram
@@ -177,4 +177,54 @@
 #define WEAVE_CONFIG_EVENT_LOGGING_NUM_EXTERNAL_CALLBACKS 0
 #endif
 
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS
+ *
+ * @brief
+ *   The number of rings in which application threads may stage
+ *   events without taking the event logging critical section.
+ *   Staged events are merged into the event buffers on the Weave
+ *   thread.  Each ring must only be written to by one thread.  By
+ *   default, events can only be logged directly.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS
+#define WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS 0
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_SIZE
+ *
+ * @brief
+ *   The size, in bytes, of each event staging ring.  Must be a power
+ *   of two.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_SIZE
+#define WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_SIZE 1024
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE
+ *
+ * @brief
+ *   Enable MappedFileEventLog, which places the event buffers in a
+ *   memory-mapped file so that logged events survive a restart of
+ *   the process.  Only available on POSIX platforms.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE
+#define WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE 0
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+ *
+ * @brief
+ *   Let LogBDXUpload offer to compress the uploaded events with
+ *   EventStreamCompressor.  The events are only compressed if the
+ *   receiver accepts the encoding in its SendAccept.  Costs about
+ *   4kB of RAM in each LogBDXUpload.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+#define WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION 0
+#endif
+
 #endif /* WEAVEEVENTLOGGINGCONFIG_H */
@@ -189,6 +189,20 @@ void WeaveSessionKey::Clear(void)
  * Signals the session as NOT having been active in the recent past.
  */
 
+/**
+ * @fn bool WeaveSessionKey::IsStored() const
+ *
+ * @return True if the session has been saved in the fabric state's session key store.
+ */
+
+/**
+ * @fn void WeaveSessionKey::SetStored(bool val)
+ *
+ * Sets a flag indicating whether the session has been saved in the fabric state's session key store.
+ *
+ * @param[in] val The value to set the kFlag_IsStored flag to.
+ */
+
 WeaveFabricState::WeaveFabricState()
 {
     State = kState_NotInitialized;
@@ -217,6 +231,9 @@ WEAVE_ERROR WeaveFabricState::Init(GroupKeyStoreBase *groupKeyStore)
 #endif
 
     GroupKeyStore = groupKeyStore;
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    SessionKeyStore = NULL;
+#endif
 
     FabricId = kFabricIdNotSpecified;
     LocalNodeId = 1;
@@ -335,6 +352,13 @@ void WeaveFabricState::SetSessionKey(WeaveSessionKey *sessionKey, uint8_t encTyp
     sessionKey->RcvFlags = 0;
     sessionKey->AuthMode = authMode;
 
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    // Sessions bound to a connection end with the connection, and shared sessions depend
+    // on in-memory end node state, so only save the remaining sessions.
+    if (SessionKeyStore != NULL && sessionKey->BoundCon == NULL && !sessionKey->IsSharedSession())
+        SaveSessionKey(sessionKey);
+#endif
+
 #if WEAVE_CONFIG_SECURITY_TEST_MODE && WEAVE_DETAIL_LOGGING
     if (LogKeys)
     {
@@ -365,6 +389,13 @@ void WeaveFabricState::RemoveSessionKey(WeaveSessionKey *sessionKey, bool wasIdl
     WeaveLogDetail(MessageLayer, "Removing %ssession key: Id=%04" PRIX16 " Peer=%016" PRIX64,
             (wasIdle) ? "idle " : "", sessionKey->MsgEncKey.KeyId, sessionKey->NodeId);
 
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    // Idle sessions are only evicted from the session key table; the stored copy remains
+    // available to this and other processes until it expires.
+    if (sessionKey->IsStored() && !wasIdle && SessionKeyStore != NULL)
+        SessionKeyStore->DeleteSessionKey(sessionKey->MsgEncKey.KeyId, sessionKey->NodeId);
+#endif
+
     if (sessionKey->IsSharedSession())
     {
         SharedSessionEndNode *endNode = SharedSessionsNodes;
@@ -614,6 +645,25 @@ WEAVE_ERROR WeaveFabricState::GetSessionState(uint64_t remoteNodeId,
             return (sessionKey->MsgEncKey.EncType == kWeaveEncryptionType_None) ? WEAVE_ERROR_KEY_NOT_FOUND : WEAVE_ERROR_WRONG_ENCRYPTION_TYPE;
         if (sessionKey->BoundCon != NULL && sessionKey->BoundCon != con)
             return WEAVE_ERROR_INVALID_USE_OF_SESSION_KEY;
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+        if (sessionKey->IsStored())
+        {
+            StoredSessionMsgIdCounter *msgIdCounter = &StoredMsgIdCounters[sessionKey - SessionKeys];
+
+            // If message ids can no longer be allocated for the session, the session has expired or
+            // been removed from the store by another process, so remove the local copy as well.
+            if (!msgIdCounter->IsValid())
+            {
+                sessionKey->SetStored(false);
+                RemoveSessionKey(sessionKey);
+                return WEAVE_ERROR_KEY_NOT_FOUND;
+            }
+
+            outSessionState = WeaveSessionState(&sessionKey->MsgEncKey, sessionKey->AuthMode, msgIdCounter, &sessionKey->MaxRcvdMsgId, &sessionKey->RcvFlags);
+            outSessionState.SetStoredSession(msgIdCounter);
+            break;
+        }
+#endif
         outSessionState = WeaveSessionState(&sessionKey->MsgEncKey, sessionKey->AuthMode, &sessionKey->NextMsgId, &sessionKey->MaxRcvdMsgId, &sessionKey->RcvFlags);
         break;
 
@@ -1257,6 +1307,87 @@ void WeaveFabricState::HandleConnectionClosed(WeaveConnection *con)
     }
 }
 
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+
+// StoredSessionMsgIdCounter Members
+
+StoredSessionMsgIdCounter::StoredSessionMsgIdCounter(void)
+{
+    mStore = NULL;
+    mPeerNodeId = kNodeIdNotSpecified;
+    mKeyId = WeaveKeyId::kNone;
+}
+
+/**
+ * Initialize the counter for a stored session key, allocating the first message id from the store.
+ *
+ * @param[in] store               The session key store holding the key.
+ * @param[in] keyId               Weave key identifier.
+ * @param[in] peerNodeId          The node identifier of the peer.
+ *
+ * @retval #WEAVE_NO_ERROR        On success.
+ * @retval other                  Errors returned by the session key store.
+ */
+WEAVE_ERROR StoredSessionMsgIdCounter::Init(WeaveSessionKeyStoreBase *store, uint16_t keyId, uint64_t peerNodeId)
+{
+    mStore = store;
+    mPeerNodeId = peerNodeId;
+    mKeyId = keyId;
+
+    return Advance();
+}
+
+/**
+ * Allocate the next message id from the session key store.
+ *
+ * If the allocation fails the counter becomes invalid and keeps its current (used) value.
+ */
+WEAVE_ERROR StoredSessionMsgIdCounter::Advance(void)
+{
+    WEAVE_ERROR err;
+
+    VerifyOrExit(mStore != NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    err = mStore->AllocMessageId(mKeyId, mPeerNodeId, mCounterValue);
+    if (err != WEAVE_NO_ERROR)
+        mStore = NULL;
+
+exit:
+    return err;
+}
+
+/**
+ * Merge the highest message id received by any process sharing the stored session into the
+ * local receive state.  Ids up to that point are treated as received.
+ */
+void StoredSessionMsgIdCounter::SyncReceiveState(uint32_t& maxRcvdMsgId, WeaveSessionState::ReceiveFlagsType& rcvFlags)
+{
+    uint32_t storedMaxRcvdMsgId;
+    WeaveSessionState::ReceiveFlagsType storedRcvFlags;
+
+    if (mStore == NULL || mStore->GetMaxRcvdMsgId(mKeyId, mPeerNodeId, storedMaxRcvdMsgId, storedRcvFlags) != WEAVE_NO_ERROR ||
+        storedRcvFlags == 0)
+        return;
+
+    if ((rcvFlags & WeaveSessionState::kReceiveFlags_MessageIdSynchronized) == 0 ||
+        (int32_t)(storedMaxRcvdMsgId - maxRcvdMsgId) > 0)
+    {
+        maxRcvdMsgId = storedMaxRcvdMsgId;
+        rcvFlags = storedRcvFlags;
+    }
+}
+
+/**
+ * Share the highest message id received locally with the other processes using the stored session.
+ */
+void StoredSessionMsgIdCounter::SaveReceiveState(uint32_t maxRcvdMsgId)
+{
+    if (mStore != NULL)
+        mStore->UpdateMaxRcvdMsgId(mKeyId, mPeerNodeId, maxRcvdMsgId);
+}
+
+#endif // WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+
 // WeaveSessionState Members
 
 WeaveSessionState::WeaveSessionState(void)
@@ -1266,6 +1397,9 @@ WeaveSessionState::WeaveSessionState(void)
     NextMsgId = NULL;
     MaxMsgIdRcvd = NULL;
     RcvFlags = NULL;
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    StoredSession = NULL;
+#endif
 }
 
 WeaveSessionState::WeaveSessionState(WeaveMsgEncryptionKey *msgEncKey, WeaveAuthMode authMode,
@@ -1276,6 +1410,9 @@ WeaveSessionState::WeaveSessionState(WeaveMsgEncryptionKey *msgEncKey, WeaveAuth
     NextMsgId = nextMsgId;
     MaxMsgIdRcvd = maxMsgIdRcvd;
     RcvFlags = rcvFlags;
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    StoredSession = NULL;
+#endif
 }
 
 uint32_t WeaveSessionState::NewMessageId(void)
@@ -1311,6 +1448,12 @@ bool WeaveSessionState::IsDuplicateMessage(uint32_t msgId)
     //        prior to the max id message (i.e. *MaxMsgIdRcvd - 1), bit 1 represents the message immediately
     //        prior to that message, and so on.
 
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    // Messages received by other processes sharing a stored session count as received here too.
+    if (StoredSession != NULL)
+        StoredSession->SyncReceiveState(*MaxMsgIdRcvd, *RcvFlags);
+#endif
+
     // If message Id is not synchronized.
     if (MessageIdNotSynchronized())
     {
@@ -1420,6 +1563,10 @@ bool WeaveSessionState::IsDuplicateMessage(uint32_t msgId)
     *RcvFlags = kReceiveFlags_MessageIdSynchronized | msgIdFlags | (*RcvFlags & ~kReceiveFlags_MessageIdFlagsMask);
 
 exit:
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    if (!isDup && StoredSession != NULL)
+        StoredSession->SaveReceiveState(*MaxMsgIdRcvd);
+#endif
     return isDup;
 }
 
@@ -1466,6 +1613,13 @@ WEAVE_ERROR WeaveFabricState::FindSessionKey(uint16_t keyId, uint64_t peerNodeId
         }
     }
 
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    // Load the key from the session key store if it is there. This is also done when creating a key
+    // so that new keys do not collide with stored keys established by other processes.
+    if (SessionKeyStore != NULL && LoadSessionKey(keyId, peerNodeId, freeRec, retRec) == WEAVE_NO_ERROR)
+        return WEAVE_NO_ERROR;
+#endif
+
     if (!create)
         return WEAVE_ERROR_KEY_NOT_FOUND;
 
@@ -1575,6 +1729,119 @@ void WeaveFabricState::SetDelegate(FabricStateDelegate *aDelegate)
     Delegate = aDelegate;
 }
 
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+
+void WeaveFabricState::SetSessionKeyStore(WeaveSessionKeyStoreBase *sessionKeyStore)
+{
+    // Sessions saved in the previous store can no longer allocate message ids, so drop their local copies.
+    if (sessionKeyStore != SessionKeyStore)
+    {
+        WeaveSessionKey *sessionKey = SessionKeys;
+        for (int i = 0; i < WEAVE_CONFIG_MAX_SESSION_KEYS; i++, sessionKey++)
+            if (sessionKey->IsAllocated() && sessionKey->IsStored())
+                RemoveSessionKey(sessionKey, true);
+    }
+
+    SessionKeyStore = sessionKeyStore;
+}
+
+/**
+ * Save an established session key in the session key store.
+ *
+ * Failure to save the key is logged but otherwise ignored; the session remains usable
+ * by the local process.
+ */
+void WeaveFabricState::SaveSessionKey(WeaveSessionKey *sessionKey)
+{
+    WEAVE_ERROR err;
+
+    err = SessionKeyStore->StoreSessionKey(*sessionKey);
+    SuccessOrExit(err);
+
+    err = StoredMsgIdCounters[sessionKey - SessionKeys].Init(SessionKeyStore, sessionKey->MsgEncKey.KeyId, sessionKey->NodeId);
+    if (err != WEAVE_NO_ERROR)
+    {
+        SessionKeyStore->DeleteSessionKey(sessionKey->MsgEncKey.KeyId, sessionKey->NodeId);
+        ExitNow();
+    }
+
+    sessionKey->SetStored(true);
+
+exit:
+    if (err != WEAVE_NO_ERROR)
+        WeaveLogError(MessageLayer, "Failed to store session key: Id=%04" PRIX16 " Peer=%016" PRIX64 ", %s",
+                sessionKey->MsgEncKey.KeyId, sessionKey->NodeId, ErrorStr(err));
+}
+
+/**
+ * Load a session key from the session key store into the session key table.
+ *
+ * If the session key table is full, a stored session that is not currently in use is
+ * evicted to make room; it will be loaded again from the store when next needed.
+ *
+ * @param[in] keyId               Weave key identifier.
+ * @param[in] peerNodeId          The node identifier of the peer.
+ * @param[in] freeRec             A free entry in the session key table, or NULL if there is none.
+ * @param[out] retRec             A pointer reference to the loaded session key.
+ *
+ * @retval #WEAVE_ERROR_TOO_MANY_KEYS      If no entry can be made available for the key.
+ * @retval #WEAVE_NO_ERROR                 On success.
+ * @retval other                           Errors returned by the session key store.
+ */
+WEAVE_ERROR WeaveFabricState::LoadSessionKey(uint16_t keyId, uint64_t peerNodeId, WeaveSessionKey *freeRec, WeaveSessionKey *& retRec)
+{
+    WEAVE_ERROR err;
+    WeaveSessionKey storedKey;
+    WeaveSessionKey *sessionKey = freeRec;
+
+    if (sessionKey == NULL)
+    {
+        WeaveSessionKey *curRec = SessionKeys;
+        for (int i = 0; i < WEAVE_CONFIG_MAX_SESSION_KEYS; i++, curRec++)
+        {
+            if (curRec->IsAllocated() && curRec->IsStored() && curRec->BoundCon == NULL && curRec->ReserveCount == 0 &&
+                (sessionKey == NULL || !curRec->IsRecentlyActive()))
+            {
+                sessionKey = curRec;
+                if (!curRec->IsRecentlyActive())
+                    break;
+            }
+        }
+        VerifyOrExit(sessionKey != NULL, err = WEAVE_ERROR_TOO_MANY_KEYS);
+    }
+
+    storedKey.Init();
+
+    err = SessionKeyStore->RetrieveSessionKey(keyId, peerNodeId, storedKey);
+    SuccessOrExit(err);
+
+    if (sessionKey->IsAllocated())
+        RemoveSessionKey(sessionKey, true);
+
+    err = StoredMsgIdCounters[sessionKey - SessionKeys].Init(SessionKeyStore, keyId, peerNodeId);
+    SuccessOrExit(err);
+
+    sessionKey->NodeId = storedKey.NodeId;
+    sessionKey->MsgEncKey = storedKey.MsgEncKey;
+    sessionKey->AuthMode = storedKey.AuthMode;
+    sessionKey->Flags = storedKey.Flags;
+    sessionKey->MaxRcvdMsgId = storedKey.MaxRcvdMsgId;
+    sessionKey->RcvFlags = storedKey.RcvFlags;
+    sessionKey->SetStored(true);
+    sessionKey->MarkRecentlyActive();
+
+    WeaveLogDetail(MessageLayer, "Loaded stored session key: Id=%04" PRIX16 " Peer=%016" PRIX64,
+            sessionKey->MsgEncKey.KeyId, sessionKey->NodeId);
+
+    retRec = sessionKey;
+
+exit:
+    storedKey.Clear();
+    return err;
+}
+
+#endif // WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+
 bool WeaveFabricState::RemoveIdleSessionKeys()
 {
     WeaveSessionKey *sessionKey;
@@ -309,6 +309,10 @@ public:
     WeaveEncryptionKey EncKey;                          /**< The secret key material. */
 };
 
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+class StoredSessionMsgIdCounter;
+#endif
+
 /**
  * @class WeaveSessionState
  *
@@ -339,10 +343,17 @@ public:
     bool MessageIdNotSynchronized(void);
     bool IsDuplicateMessage(uint32_t msgId);
 
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    void SetStoredSession(StoredSessionMsgIdCounter *storedSession) { StoredSession = storedSession; }
+#endif
+
 private:
     MonotonicallyIncreasingCounter *NextMsgId;
     uint32_t *MaxMsgIdRcvd;
     ReceiveFlagsType *RcvFlags;
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    StoredSessionMsgIdCounter *StoredSession;
+#endif
 };
 
 /**
@@ -361,6 +372,8 @@ public:
         kFlag_IsRemoveOnIdle         = 0x04,            /**< The session should be removed when idle (only applies to sessions
                                                              that are not bound to a connection). */
         kFlag_RecentlyActive         = 0x08,            /**< The session was recently active. */
+        kFlag_IsStored               = 0x10,            /**< The session has been saved in the fabric state's session
+                                                             key store. */
     };
 
     uint64_t NodeId;                                    /**< The id of the node with which the session key is shared. */
@@ -387,8 +400,73 @@ public:
     bool IsRecentlyActive() const       { return GetFlag(Flags, kFlag_RecentlyActive); }
     void MarkRecentlyActive()           { SetFlag(Flags, kFlag_RecentlyActive); }
     void ClearRecentlyActive()          { ClearFlag(Flags, kFlag_RecentlyActive); }
+    bool IsStored() const               { return GetFlag(Flags, kFlag_IsStored); }
+    void SetStored(bool val)            { SetFlag(Flags, kFlag_IsStored, val); }
+};
+
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+
+/**
+ * @class WeaveSessionKeyStoreBase
+ *
+ * @brief
+ *   The definition of the Weave session key store class.  Functions in this class
+ *   are called by WeaveFabricState to save established session keys outside of its
+ *   session key table and to look them up again, possibly from another process.
+ *
+ *   Because a stored session may be used by several processes at once, the store
+ *   also allocates the message ids used to send messages under stored session keys,
+ *   and tracks the highest message id received under them so that a message accepted
+ *   by one process is rejected as a duplicate by the others, and after a restart.
+ */
+class NL_DLL_EXPORT WeaveSessionKeyStoreBase
+{
+public:
+
+    // Manage session key storage.
+    virtual WEAVE_ERROR StoreSessionKey(const WeaveSessionKey& sessionKey) = 0;
+    virtual WEAVE_ERROR RetrieveSessionKey(uint16_t keyId, uint64_t peerNodeId, WeaveSessionKey& sessionKey) = 0;
+    virtual WEAVE_ERROR DeleteSessionKey(uint16_t keyId, uint64_t peerNodeId) = 0;
+
+    // Allocate a message id for sending under a stored session key.
+    virtual WEAVE_ERROR AllocMessageId(uint16_t keyId, uint64_t peerNodeId, uint32_t& msgId) = 0;
+
+    // Track the highest message id received under a stored session key.
+    virtual WEAVE_ERROR GetMaxRcvdMsgId(uint16_t keyId, uint64_t peerNodeId, uint32_t& maxRcvdMsgId,
+                                        WeaveSessionState::ReceiveFlagsType& rcvFlags) = 0;
+    virtual WEAVE_ERROR UpdateMaxRcvdMsgId(uint16_t keyId, uint64_t peerNodeId, uint32_t msgId) = 0;
+};
+
+/**
+ * @class StoredSessionMsgIdCounter
+ *
+ * @brief
+ *   A message id counter for a session key saved in a session key store.  The value
+ *   of the counter is always a message id that has been allocated from the store but
+ *   not yet used.  The counter also shares the session's received message ids with
+ *   the store.
+ */
+class StoredSessionMsgIdCounter : public MonotonicallyIncreasingCounter
+{
+public:
+    StoredSessionMsgIdCounter(void);
+
+    WEAVE_ERROR Init(WeaveSessionKeyStoreBase *store, uint16_t keyId, uint64_t peerNodeId);
+    virtual WEAVE_ERROR Advance(void);
+
+    void SyncReceiveState(uint32_t& maxRcvdMsgId, WeaveSessionState::ReceiveFlagsType& rcvFlags);
+    void SaveReceiveState(uint32_t maxRcvdMsgId);
+
+    bool IsValid(void) const            { return mStore != NULL; }
+
+private:
+    WeaveSessionKeyStoreBase *mStore;
+    uint64_t mPeerNodeId;
+    uint16_t mKeyId;
 };
 
+#endif // WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+
 /**
  * @class WeaveMsgEncryptionKeyCache
  *
@@ -489,6 +567,9 @@ public:
     uint16_t DefaultSubnet;
     uint8_t State;                                      // [READ ONLY] State of the Weave Fabric State object
     nl::Weave::Profiles::Security::AppKeys::GroupKeyStoreBase *GroupKeyStore;
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    WeaveSessionKeyStoreBase *SessionKeyStore;          // [READ ONLY] The attached session key store, or NULL.
+#endif
 
 #if WEAVE_CONFIG_SECURITY_TEST_MODE
     uint64_t DebugFabricId;
@@ -580,6 +661,22 @@ public:
      */
     void SetDelegate(FabricStateDelegate *aDelegate);
 
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    /**
+     * This method attaches a session key store to the fabric state.
+     *
+     * Once attached, session keys that are not bound to a connection are saved in the
+     * store as they are established, and session keys that are not found in the session
+     * key table are loaded from the store.  Stored session keys are deleted from the
+     * store when they are explicitly removed, but not when they are removed for being
+     * idle.
+     *
+     * @param[in] sessionKeyStore               The session key store. It can be NULL to
+     *                                          detach the current store.
+     */
+    void SetSessionKeyStore(WeaveSessionKeyStoreBase *sessionKeyStore);
+#endif
+
 #if WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC
     void OnMsgCounterSyncRespRcvd(uint64_t peerNodeId, uint32_t peerMsgId, uint32_t requestorMsgCounter);
     void OnMsgCounterSyncReqSent(uint32_t messageId);
@@ -607,6 +704,10 @@ private:
     MonotonicallyIncreasingCounter NextUnencUDPMsgId;
     MonotonicallyIncreasingCounter NextUnencTCPMsgId;
     WeaveSessionKey SessionKeys[WEAVE_CONFIG_MAX_SESSION_KEYS];
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    // Message id counters for stored session keys, indexed in parallel with SessionKeys.
+    StoredSessionMsgIdCounter StoredMsgIdCounters[WEAVE_CONFIG_MAX_SESSION_KEYS];
+#endif
 #if WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC
     PersistedCounter NextGroupKeyMsgId;
 
@@ -655,6 +756,11 @@ private:
 
     bool FindSharedSessionEndNode(uint64_t endNodeId, const WeaveSessionKey *sessionKey);
 
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    void SaveSessionKey(WeaveSessionKey *sessionKey);
+    WEAVE_ERROR LoadSessionKey(uint16_t keyId, uint64_t peerNodeId, WeaveSessionKey *freeRec, WeaveSessionKey *& retRec);
+#endif
+
 #if WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC
     void StartMsgCounterSyncTimer(void);
     static void OnMsgCounterSyncRespTimeout(System::Layer* aSystemLayer, void* aAppState, System::Error aError);
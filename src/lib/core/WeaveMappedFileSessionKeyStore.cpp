@@ -0,0 +1,649 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a Weave session key store backed by a
+ *      memory-mapped file.
+ *
+ */
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <Weave/Core/WeaveCore.h>
+#include <Weave/Core/WeaveMappedFileSessionKeyStore.h>
+
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <Weave/Support/CodeUtils.h>
+#include <Weave/Support/crypto/WeaveCrypto.h>
+#include <Weave/Support/logging/WeaveLogging.h>
+
+namespace nl {
+namespace Weave {
+
+using namespace nl::Weave::Crypto;
+
+enum
+{
+    kFileMagic                      = 0x534B5357,   // "WSKS"
+    kFileVersion                    = 2,
+
+    kRecordState_Empty              = 0,            // Never used; ends a probe sequence.
+    kRecordState_InUse              = 1,
+    kRecordState_Deleted            = 2,
+
+    kStoredSessionFlags             = WeaveSessionKey::kFlag_IsLocallyInitiated | WeaveSessionKey::kFlag_IsRemoveOnIdle,
+};
+
+// Set in KeyRecord::MaxRcvdMsgId once a message has been received under the key; the low 32 bits
+// hold the highest message id received.
+static const uint64_t kMaxRcvdMsgId_Valid = 1ULL << 32;
+
+struct MappedFileSessionKeyStore::FileHeader
+{
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t RecordSize;
+    uint32_t MaxKeys;
+    uint32_t Reserved;
+};
+
+struct MappedFileSessionKeyStore::KeyRecord
+{
+    // Message id state, updated in place without the file lock by all processes sharing the file, and
+    // so not covered by the MAC.  NextMsgId is instead checked against MsgIdLimit when the key is loaded.
+    volatile uint32_t NextMsgId;                        // The next message id to allocate.
+    volatile uint8_t State;
+    uint8_t Reserved1[3];
+    volatile uint64_t MaxRcvdMsgId;                     // kMaxRcvdMsgId_Valid | the highest message id received, or 0.
+
+    // Session key state, covered by the MAC.
+    uint32_t MsgIdLimit;                                // Message ids below this value are reserved on disk.
+    uint32_t Reserved2;
+    uint64_t PeerNodeId;
+    uint64_t ExpiryTime;                                // Seconds since the POSIX epoch; 0 if the record does not expire.
+    uint16_t KeyId;
+    uint16_t AuthMode;
+    uint8_t EncType;
+    uint8_t Flags;
+    uint8_t Reserved3[2];
+    WeaveEncryptionKey EncKey;
+
+    uint8_t MAC[HMACSHA256::kDigestLength];
+};
+
+const size_t MappedFileSessionKeyStore::kFileLength =
+    sizeof(MappedFileSessionKeyStore::FileHeader) + WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS * sizeof(MappedFileSessionKeyStore::KeyRecord);
+
+static uint32_t ProbeStartIndex(uint16_t keyId, uint64_t peerNodeId)
+{
+    uint32_t hash = (uint32_t)peerNodeId ^ (uint32_t)(peerNodeId >> 32) ^ keyId;
+
+    return (hash * 2654435761U) % WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS;
+}
+
+MappedFileSessionKeyStore::MappedFileSessionKeyStore(void)
+{
+    mFD = -1;
+    mMapping = NULL;
+    mKeyLifetime = 0;
+    mStoreKeyLen = 0;
+}
+
+/**
+ * Open or create a session key store file.
+ *
+ * Records that have expired are removed, and message ids for the remaining records
+ * resume at the end of their last reserved block.
+ *
+ * @param[in] path                The path of the store file.
+ * @param[in] storeKey            The key used to compute record MACs.  All processes
+ *                                sharing the file must use the same key.
+ * @param[in] storeKeyLen         The length of storeKey.
+ * @param[in] keyLifetimeSec      Number of seconds after which stored session keys expire,
+ *                                or 0 if they do not expire.
+ *
+ * @retval #WEAVE_ERROR_INCORRECT_STATE        If the store is already open.
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT       If the arguments are invalid.
+ * @retval #WEAVE_ERROR_PERSISTED_STORAGE_FAIL If the file is not a compatible store file.
+ * @retval #WEAVE_NO_ERROR                     On success.
+ * @retval other                               POSIX errors opening or mapping the file, or
+ *                                             errors reading the real time clock.
+ */
+WEAVE_ERROR MappedFileSessionKeyStore::Init(const char *path, const uint8_t *storeKey, uint16_t storeKeyLen, uint32_t keyLifetimeSec)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    struct stat st;
+    FileHeader *header;
+    void *mapping;
+    uint64_t now;
+    bool isNewFile;
+    bool locked = false;
+
+    VerifyOrExit(mMapping == NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(path != NULL && storeKey != NULL && storeKeyLen > 0 && storeKeyLen <= kMaxStoreKeyLength,
+                 err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    memcpy(mStoreKey, storeKey, storeKeyLen);
+    mStoreKeyLen = storeKeyLen;
+    mKeyLifetime = keyLifetimeSec;
+
+    err = GetCurrentTime(now);
+    SuccessOrExit(err);
+
+    mFD = open(path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    VerifyOrExit(mFD >= 0, err = System::MapErrorPOSIX(errno));
+
+    err = LockFile();
+    SuccessOrExit(err);
+    locked = true;
+
+    VerifyOrExit(fstat(mFD, &st) == 0, err = System::MapErrorPOSIX(errno));
+
+    isNewFile = (st.st_size == 0);
+    if (isNewFile)
+        VerifyOrExit(ftruncate(mFD, kFileLength) == 0, err = System::MapErrorPOSIX(errno));
+    else
+        VerifyOrExit((size_t)st.st_size == kFileLength, err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+
+    mapping = mmap(NULL, kFileLength, PROT_READ | PROT_WRITE, MAP_SHARED, mFD, 0);
+    VerifyOrExit(mapping != MAP_FAILED, err = System::MapErrorPOSIX(errno));
+    mMapping = (uint8_t *)mapping;
+
+    header = (FileHeader *)mMapping;
+    if (isNewFile)
+    {
+        header->Magic = kFileMagic;
+        header->Version = kFileVersion;
+        header->RecordSize = sizeof(KeyRecord);
+        header->MaxKeys = WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS;
+        header->Reserved = 0;
+    }
+    else
+    {
+        VerifyOrExit(header->Magic == kFileMagic && header->Version == kFileVersion &&
+                     header->RecordSize == sizeof(KeyRecord) &&
+                     header->MaxKeys == WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS,
+                     err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+    }
+
+    for (uint32_t i = 0; i < WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS; i++)
+    {
+        KeyRecord *rec = GetRecord(i);
+
+        if (rec->State != kRecordState_InUse)
+            continue;
+
+        if (IsExpired(rec, now))
+        {
+            ReleaseRecord(i);
+            continue;
+        }
+
+        // Resume message ids at the end of the reserved block.  If other processes are using the
+        // file this skips some ids, but it guarantees that ids used before a crash are not reused.
+        while (true)
+        {
+            uint32_t nextMsgId = rec->NextMsgId;
+            uint32_t msgIdLimit = rec->MsgIdLimit;
+            if (nextMsgId >= msgIdLimit || __sync_bool_compare_and_swap(&rec->NextMsgId, nextMsgId, msgIdLimit))
+                break;
+        }
+    }
+
+    // Turn the deleted records at the end of each probe sequence back into empty ones, so that
+    // lookups of missing keys stop early.
+    for (uint32_t i = 0; i < WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS; i++)
+        if (GetRecord(i)->State == kRecordState_Deleted)
+            ReleaseRecord(i);
+
+    VerifyOrExit(msync(mMapping, kFileLength, MS_SYNC) == 0, err = System::MapErrorPOSIX(errno));
+
+exit:
+    if (locked)
+        UnlockFile();
+    if (err != WEAVE_NO_ERROR)
+    {
+        WeaveLogError(MessageLayer, "Failed to open session key store %s: %s", (path != NULL) ? path : "", ErrorStr(err));
+        if (mFD >= 0)
+            Shutdown();
+    }
+    return err;
+}
+
+/**
+ * Close the session key store file.  Stored session keys remain in the file.
+ */
+WEAVE_ERROR MappedFileSessionKeyStore::Shutdown(void)
+{
+    if (mMapping != NULL)
+    {
+        munmap(mMapping, kFileLength);
+        mMapping = NULL;
+    }
+
+    if (mFD >= 0)
+    {
+        close(mFD);
+        mFD = -1;
+    }
+
+    ClearSecretData(mStoreKey, sizeof(mStoreKey));
+    mStoreKeyLen = 0;
+
+    return WEAVE_NO_ERROR;
+}
+
+WEAVE_ERROR MappedFileSessionKeyStore::StoreSessionKey(const WeaveSessionKey& sessionKey)
+{
+    WEAVE_ERROR err;
+    KeyRecord *rec;
+    uint64_t now;
+    bool locked = false;
+
+    VerifyOrExit(mMapping != NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    err = GetCurrentTime(now);
+    SuccessOrExit(err);
+
+    err = LockFile();
+    SuccessOrExit(err);
+    locked = true;
+
+    // Replace an existing record for the key, otherwise take the first free or expired
+    // record in the key's probe sequence.
+    rec = FindRecord(sessionKey.MsgEncKey.KeyId, sessionKey.NodeId);
+    if (rec == NULL)
+    {
+        uint32_t index = ProbeStartIndex(sessionKey.MsgEncKey.KeyId, sessionKey.NodeId);
+        for (uint32_t i = 0; i < WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS; i++)
+        {
+            KeyRecord *curRec = GetRecord((index + i) % WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS);
+            if (curRec->State != kRecordState_InUse || IsExpired(curRec, now))
+            {
+                rec = curRec;
+                break;
+            }
+        }
+    }
+    VerifyOrExit(rec != NULL, err = WEAVE_ERROR_TOO_MANY_KEYS);
+
+    // Hide the record from lock-free lookups while it is being written.
+    rec->State = kRecordState_Deleted;
+    __sync_synchronize();
+
+    rec->NextMsgId = 0;
+    rec->MaxRcvdMsgId = ((sessionKey.RcvFlags & WeaveSessionState::kReceiveFlags_MessageIdSynchronized) != 0)
+        ? kMaxRcvdMsgId_Valid | sessionKey.MaxRcvdMsgId : 0;
+    rec->MsgIdLimit = WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MSG_ID_EPOCH;
+    rec->Reserved2 = 0;
+    rec->PeerNodeId = sessionKey.NodeId;
+    rec->ExpiryTime = (mKeyLifetime != 0) ? now + mKeyLifetime : 0;
+    rec->KeyId = sessionKey.MsgEncKey.KeyId;
+    rec->AuthMode = sessionKey.AuthMode;
+    rec->EncType = sessionKey.MsgEncKey.EncType;
+    rec->Flags = sessionKey.Flags & kStoredSessionFlags;
+    memset(rec->Reserved1, 0, sizeof(rec->Reserved1));
+    memset(rec->Reserved3, 0, sizeof(rec->Reserved3));
+    rec->EncKey = sessionKey.MsgEncKey.EncKey;
+    ComputeRecordMAC(rec, rec->MAC);
+
+    __sync_synchronize();
+    rec->State = kRecordState_InUse;
+
+    err = SyncRecord(rec);
+
+exit:
+    if (locked)
+        UnlockFile();
+    return err;
+}
+
+WEAVE_ERROR MappedFileSessionKeyStore::RetrieveSessionKey(uint16_t keyId, uint64_t peerNodeId, WeaveSessionKey& sessionKey)
+{
+    WEAVE_ERROR err;
+    KeyRecord *rec;
+    uint64_t now;
+    uint8_t mac[HMACSHA256::kDigestLength];
+    bool locked = false;
+
+    VerifyOrExit(mMapping != NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    err = GetCurrentTime(now);
+    SuccessOrExit(err);
+
+    err = LockFile();
+    SuccessOrExit(err);
+    locked = true;
+
+    rec = FindRecord(keyId, peerNodeId);
+    VerifyOrExit(rec != NULL, err = WEAVE_ERROR_KEY_NOT_FOUND);
+
+    if (IsExpired(rec, now))
+    {
+        ReleaseRecord(rec);
+        ExitNow(err = WEAVE_ERROR_KEY_NOT_FOUND);
+    }
+
+    // The next message id must lie within or after the last block reserved on disk.
+    ComputeRecordMAC(rec, mac);
+    if (!ConstantTimeCompare(mac, rec->MAC, sizeof(mac)) ||
+        (int32_t)(rec->NextMsgId - (rec->MsgIdLimit - WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MSG_ID_EPOCH)) < 0)
+    {
+        WeaveLogError(MessageLayer, "Stored session key failed integrity check: Id=%04" PRIX16 " Peer=%016" PRIX64,
+                keyId, peerNodeId);
+        ExitNow(err = WEAVE_ERROR_INTEGRITY_CHECK_FAILED);
+    }
+
+    sessionKey.NodeId = rec->PeerNodeId;
+    sessionKey.MsgEncKey.KeyId = rec->KeyId;
+    sessionKey.MsgEncKey.EncType = rec->EncType;
+    sessionKey.MsgEncKey.EncKey = rec->EncKey;
+    sessionKey.AuthMode = rec->AuthMode;
+    sessionKey.Flags = rec->Flags & kStoredSessionFlags;
+    GetMaxRcvdMsgId(rec, sessionKey.MaxRcvdMsgId, sessionKey.RcvFlags);
+
+exit:
+    if (locked)
+        UnlockFile();
+    ClearSecretData(mac, sizeof(mac));
+    return err;
+}
+
+WEAVE_ERROR MappedFileSessionKeyStore::DeleteSessionKey(uint16_t keyId, uint64_t peerNodeId)
+{
+    WEAVE_ERROR err;
+    KeyRecord *rec;
+    bool locked = false;
+
+    VerifyOrExit(mMapping != NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    err = LockFile();
+    SuccessOrExit(err);
+    locked = true;
+
+    rec = FindRecord(keyId, peerNodeId);
+    VerifyOrExit(rec != NULL, err = WEAVE_ERROR_KEY_NOT_FOUND);
+
+    ReleaseRecord(rec);
+
+    err = SyncRecord(rec);
+
+exit:
+    if (locked)
+        UnlockFile();
+    return err;
+}
+
+/**
+ * Allocate a message id for sending under a stored session key.
+ *
+ * Message ids are allocated from a counter in the shared mapping without taking the file
+ * lock.  When the allocated id reaches the end of the block reserved on disk, the next
+ * block is reserved and the record is synced before the id is returned.  A session whose
+ * record has expired is reported as not found at that point.
+ */
+WEAVE_ERROR MappedFileSessionKeyStore::AllocMessageId(uint16_t keyId, uint64_t peerNodeId, uint32_t& msgId)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    KeyRecord *rec;
+    uint32_t newMsgId;
+
+    VerifyOrExit(mMapping != NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    rec = FindRecord(keyId, peerNodeId);
+    VerifyOrExit(rec != NULL, err = WEAVE_ERROR_KEY_NOT_FOUND);
+
+    newMsgId = __sync_fetch_and_add(&rec->NextMsgId, 1);
+
+    // Verify the record was not deleted or reused while the id was being allocated.
+    VerifyOrExit(rec->State == kRecordState_InUse && rec->KeyId == keyId && rec->PeerNodeId == peerNodeId,
+                 err = WEAVE_ERROR_KEY_NOT_FOUND);
+
+    if (newMsgId >= rec->MsgIdLimit)
+    {
+        uint64_t now;
+
+        err = GetCurrentTime(now);
+        SuccessOrExit(err);
+
+        VerifyOrExit(!IsExpired(rec, now), err = WEAVE_ERROR_KEY_NOT_FOUND);
+
+        err = LockFile();
+        SuccessOrExit(err);
+
+        if (newMsgId >= rec->MsgIdLimit)
+        {
+            rec->MsgIdLimit = newMsgId + WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MSG_ID_EPOCH;
+            ComputeRecordMAC(rec, rec->MAC);
+            err = SyncRecord(rec);
+        }
+
+        UnlockFile();
+        SuccessOrExit(err);
+    }
+
+    msgId = newMsgId;
+
+exit:
+    return err;
+}
+
+/**
+ * Get the highest message id received under a stored session key, by any process sharing the file.
+ */
+WEAVE_ERROR MappedFileSessionKeyStore::GetMaxRcvdMsgId(uint16_t keyId, uint64_t peerNodeId, uint32_t& maxRcvdMsgId,
+                                                       WeaveSessionState::ReceiveFlagsType& rcvFlags)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    KeyRecord *rec;
+
+    VerifyOrExit(mMapping != NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    rec = FindRecord(keyId, peerNodeId);
+    VerifyOrExit(rec != NULL, err = WEAVE_ERROR_KEY_NOT_FOUND);
+
+    GetMaxRcvdMsgId(rec, maxRcvdMsgId, rcvFlags);
+
+exit:
+    return err;
+}
+
+/**
+ * Record that a message has been received under a stored session key.
+ *
+ * The highest received message id is raised in the shared mapping without taking the file
+ * lock, so it is seen at once by other processes and survives a restart of the process.  It
+ * is written back to disk by the kernel rather than synced, so an abrupt loss of power can
+ * lose the most recent updates.
+ */
+WEAVE_ERROR MappedFileSessionKeyStore::UpdateMaxRcvdMsgId(uint16_t keyId, uint64_t peerNodeId, uint32_t msgId)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    KeyRecord *rec;
+
+    VerifyOrExit(mMapping != NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    rec = FindRecord(keyId, peerNodeId);
+    VerifyOrExit(rec != NULL, err = WEAVE_ERROR_KEY_NOT_FOUND);
+
+    while (true)
+    {
+        uint64_t maxRcvdMsgId = rec->MaxRcvdMsgId;
+
+        // Message ids wrap, so compare them the same way WeaveSessionState::IsDuplicateMessage() does.
+        if ((maxRcvdMsgId & kMaxRcvdMsgId_Valid) != 0 && (int32_t)(msgId - (uint32_t)maxRcvdMsgId) <= 0)
+            break;
+
+        if (__sync_bool_compare_and_swap(&rec->MaxRcvdMsgId, maxRcvdMsgId, kMaxRcvdMsgId_Valid | msgId))
+            break;
+    }
+
+exit:
+    return err;
+}
+
+void MappedFileSessionKeyStore::GetMaxRcvdMsgId(const KeyRecord *rec, uint32_t& maxRcvdMsgId, WeaveSessionState::ReceiveFlagsType& rcvFlags)
+{
+    uint64_t storedMaxRcvdMsgId = rec->MaxRcvdMsgId;
+
+    // Ids at or below the stored maximum may have been received by any process, so treat them all as received.
+    if ((storedMaxRcvdMsgId & kMaxRcvdMsgId_Valid) != 0)
+    {
+        maxRcvdMsgId = (uint32_t)storedMaxRcvdMsgId;
+        rcvFlags = WeaveSessionState::kReceiveFlags_MessageIdSynchronized | WeaveSessionState::kReceiveFlags_MessageIdFlagsMask;
+    }
+    else
+    {
+        maxRcvdMsgId = 0;
+        rcvFlags = 0;
+    }
+}
+
+MappedFileSessionKeyStore::KeyRecord *MappedFileSessionKeyStore::GetRecord(uint32_t index) const
+{
+    return (KeyRecord *)(mMapping + sizeof(FileHeader) + index * sizeof(KeyRecord));
+}
+
+/**
+ * Find the in-use record for a key.  Safe to call without holding the file lock, in which
+ * case the caller must re-verify the record after using it.
+ */
+MappedFileSessionKeyStore::KeyRecord *MappedFileSessionKeyStore::FindRecord(uint16_t keyId, uint64_t peerNodeId) const
+{
+    uint32_t index = ProbeStartIndex(keyId, peerNodeId);
+
+    for (uint32_t i = 0; i < WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS; i++)
+    {
+        KeyRecord *rec = GetRecord((index + i) % WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS);
+        uint8_t state = rec->State;
+
+        if (state == kRecordState_Empty)
+            break;
+
+        if (state == kRecordState_InUse && rec->KeyId == keyId && rec->PeerNodeId == peerNodeId)
+            return rec;
+    }
+
+    return NULL;
+}
+
+/**
+ * Delete a record.  Must be called with the file lock held.
+ *
+ * If the record ends its probe sequence, it and the deleted records before it are marked empty
+ * instead, so that lookups of missing keys do not have to step over them.
+ */
+void MappedFileSessionKeyStore::ReleaseRecord(uint32_t index)
+{
+    KeyRecord *rec = GetRecord(index);
+
+    rec->State = kRecordState_Deleted;
+    ClearSecretData((uint8_t *)&rec->EncKey, sizeof(rec->EncKey));
+
+    if (GetRecord((index + 1) % WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS)->State != kRecordState_Empty)
+        return;
+
+    for (uint32_t i = 0; i < WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS; i++)
+    {
+        rec = GetRecord(index);
+        if (rec->State != kRecordState_Deleted)
+            break;
+
+        rec->State = kRecordState_Empty;
+        index = (index + WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS - 1) % WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS;
+    }
+}
+
+void MappedFileSessionKeyStore::ReleaseRecord(KeyRecord *rec)
+{
+    ReleaseRecord((uint32_t)(((uint8_t *)rec - mMapping - sizeof(FileHeader)) / sizeof(KeyRecord)));
+}
+
+WEAVE_ERROR MappedFileSessionKeyStore::LockFile(void) const
+{
+    while (flock(mFD, LOCK_EX) != 0)
+        if (errno != EINTR)
+            return System::MapErrorPOSIX(errno);
+
+    return WEAVE_NO_ERROR;
+}
+
+void MappedFileSessionKeyStore::UnlockFile(void) const
+{
+    flock(mFD, LOCK_UN);
+}
+
+WEAVE_ERROR MappedFileSessionKeyStore::SyncRecord(const KeyRecord *rec) const
+{
+    uintptr_t pageMask = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+    uintptr_t start = (uintptr_t)rec & ~pageMask;
+    uintptr_t end = (uintptr_t)(rec + 1);
+
+    if (msync((void *)start, end - start, MS_SYNC) != 0)
+        return System::MapErrorPOSIX(errno);
+
+    return WEAVE_NO_ERROR;
+}
+
+void MappedFileSessionKeyStore::ComputeRecordMAC(const KeyRecord *rec, uint8_t *mac) const
+{
+    HMACSHA256 hmac;
+    const uint8_t *macStart = (const uint8_t *)&rec->MsgIdLimit;
+    const uint8_t *macEnd = (const uint8_t *)rec->MAC;
+
+    hmac.Begin(mStoreKey, mStoreKeyLen);
+    hmac.AddData(macStart, (uint16_t)(macEnd - macStart));
+    hmac.Finish(mac);
+}
+
+WEAVE_ERROR MappedFileSessionKeyStore::GetCurrentTime(uint64_t& curTimeSec)
+{
+    WEAVE_ERROR err;
+    uint64_t curTimeUSec;
+
+    err = System::Layer::GetClock_RealTime(curTimeUSec);
+    SuccessOrExit(err);
+
+    curTimeSec = curTimeUSec / 1000000;
+
+exit:
+    return err;
+}
+
+bool MappedFileSessionKeyStore::IsExpired(const KeyRecord *rec, uint64_t curTimeSec)
+{
+    return rec->ExpiryTime != 0 && curTimeSec >= rec->ExpiryTime;
+}
+
+} // namespace Weave
+} // namespace nl
+
+#endif // WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
@@ -0,0 +1,112 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file defines a Weave session key store backed by a
+ *      memory-mapped file, for use on POSIX platforms.
+ *
+ */
+
+#ifndef WEAVE_MAPPED_FILE_SESSION_KEY_STORE_H
+#define WEAVE_MAPPED_FILE_SESSION_KEY_STORE_H
+
+#include <Weave/Core/WeaveCore.h>
+#include <Weave/Support/crypto/HMAC.h>
+
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+namespace nl {
+namespace Weave {
+
+/**
+ * @class MappedFileSessionKeyStore
+ *
+ * @brief
+ *   A session key store that keeps session keys in a memory-mapped file.
+ *
+ *   Several processes acting as the same Weave node may open the same file, in which
+ *   case sessions established by one process can be used by the others.  Message ids
+ *   for stored sessions are allocated from a counter in the shared mapping, and a
+ *   block of WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MSG_ID_EPOCH ids is reserved
+ *   on disk ahead of use so that ids are never reused following a crash.
+ *
+ *   Each record is protected by an HMAC-SHA256 computed with a key supplied by the
+ *   application, and expires a fixed time after it is stored.  The file is created
+ *   readable only by its owner; records are not encrypted.  The file format is
+ *   native-endian and not intended to be shared between machines.
+ *
+ *   Duplicate message detection for stored sessions shares a replay window through the
+ *   mapping: the highest message id received under each key is stored in its record and
+ *   raised by each process that accepts a message.  Before checking a message a process
+ *   treats every id up to the stored maximum as received, so a message accepted by one
+ *   process is rejected if replayed to another.  Only the maximum is shared, so a
+ *   delayed, lower-numbered message may be rejected by a process that has not seen it.
+ */
+class NL_DLL_EXPORT MappedFileSessionKeyStore : public WeaveSessionKeyStoreBase
+{
+public:
+    enum
+    {
+        kMaxStoreKeyLength              = 32,       /**< Maximum length of the record integrity key. */
+    };
+
+    MappedFileSessionKeyStore(void);
+
+    WEAVE_ERROR Init(const char *path, const uint8_t *storeKey, uint16_t storeKeyLen, uint32_t keyLifetimeSec);
+    WEAVE_ERROR Shutdown(void);
+
+    virtual WEAVE_ERROR StoreSessionKey(const WeaveSessionKey& sessionKey);
+    virtual WEAVE_ERROR RetrieveSessionKey(uint16_t keyId, uint64_t peerNodeId, WeaveSessionKey& sessionKey);
+    virtual WEAVE_ERROR DeleteSessionKey(uint16_t keyId, uint64_t peerNodeId);
+    virtual WEAVE_ERROR AllocMessageId(uint16_t keyId, uint64_t peerNodeId, uint32_t& msgId);
+    virtual WEAVE_ERROR GetMaxRcvdMsgId(uint16_t keyId, uint64_t peerNodeId, uint32_t& maxRcvdMsgId,
+                                        WeaveSessionState::ReceiveFlagsType& rcvFlags);
+    virtual WEAVE_ERROR UpdateMaxRcvdMsgId(uint16_t keyId, uint64_t peerNodeId, uint32_t msgId);
+
+private:
+    struct FileHeader;
+    struct KeyRecord;
+
+    static const size_t kFileLength;
+
+    int mFD;
+    uint8_t *mMapping;
+    uint32_t mKeyLifetime;
+    uint16_t mStoreKeyLen;
+    uint8_t mStoreKey[kMaxStoreKeyLength];
+
+    KeyRecord *GetRecord(uint32_t index) const;
+    KeyRecord *FindRecord(uint16_t keyId, uint64_t peerNodeId) const;
+    void ReleaseRecord(uint32_t index);
+    void ReleaseRecord(KeyRecord *rec);
+    WEAVE_ERROR LockFile(void) const;
+    void UnlockFile(void) const;
+    WEAVE_ERROR SyncRecord(const KeyRecord *rec) const;
+    void ComputeRecordMAC(const KeyRecord *rec, uint8_t *mac) const;
+    static WEAVE_ERROR GetCurrentTime(uint64_t& curTimeSec);
+    static bool IsExpired(const KeyRecord *rec, uint64_t curTimeSec);
+    static void GetMaxRcvdMsgId(const KeyRecord *rec, uint32_t& maxRcvdMsgId, WeaveSessionState::ReceiveFlagsType& rcvFlags);
+};
+
+} // namespace Weave
+} // namespace nl
+
+#endif // WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+#endif // WEAVE_MAPPED_FILE_SESSION_KEY_STORE_H
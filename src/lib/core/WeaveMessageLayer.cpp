@@ -953,6 +953,34 @@ static uint16_t EncodeHeaderField(const WeaveMessageInfo *msgInfo)
            ((((uint16_t)msgInfo->MessageVersion) << kMsgHeaderField_MessageVersionShift) & kMsgHeaderField_MessageVersionMask);
 }
 
+// Hash the message header fields covered by the integrity check of an AES128CTRSHA1 message.
+static void AddIntegrityCheckHeader_AES128CTRSHA1(const WeaveMessageInfo *msgInfo, HMACSHA1 &hmacSHA1)
+{
+    uint8_t encodedBuf[2 * sizeof(uint64_t) + sizeof(uint16_t) + sizeof(uint32_t)];
+    uint8_t *p = encodedBuf;
+
+    // Encode the source and destination node identifiers in a little-endian format.
+    Encoding::LittleEndian::Write64(p, msgInfo->SourceNodeId);
+    Encoding::LittleEndian::Write64(p, msgInfo->DestNodeId);
+
+    // Hash the message header field and the message Id for the message version V2.
+    if (msgInfo->MessageVersion == kWeaveMessageVersion_V2)
+    {
+        // Encode message header field value.
+        uint16_t headerField = EncodeHeaderField(msgInfo);
+
+        // Mask destination and source node Id flags.
+        headerField &= kMsgHeaderField_MessageHMACMask;
+
+        // Encode the message header field and the message Id in a little-endian format.
+        Encoding::LittleEndian::Write16(p, headerField);
+        Encoding::LittleEndian::Write32(p, msgInfo->MessageId);
+    }
+
+    // Hash encoded message header fields.
+    hmacSHA1.AddData(encodedBuf, p - encodedBuf);
+}
+
 // Decode message header field value.
 static void DecodeHeaderField(const uint16_t headerField, WeaveMessageInfo *msgInfo)
 {
@@ -1305,6 +1333,45 @@ WEAVE_ERROR WeaveMessageLayer::EncodeMessage(WeaveMessageInfo *msgInfo, PacketBu
 
 WEAVE_ERROR WeaveMessageLayer::DecodeMessage(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
         WeaveMessageInfo *msgInfo, uint8_t **rPayload, uint16_t *rPayloadLen) // TODO: use references
+{
+    WEAVE_ERROR err;
+    WeaveSessionState sessionState;
+
+    // Decode the message header, get the session state and locate the payload.
+    err = PrepareDecodeMessage(msgBuf, sourceNodeId, con, msgInfo, sessionState, rPayload, rPayloadLen);
+    if (err != WEAVE_NO_ERROR)
+        return err;
+
+    if (msgInfo->EncryptionType == kWeaveEncryptionType_AES128CTRSHA1)
+    {
+        uint8_t *p = *rPayload;
+        uint16_t payloadLen = *rPayloadLen;
+
+        // Decrypt the message payload and the integrity check value that follows it, in place, in the message buffer.
+        Encrypt_AES128CTRSHA1(msgInfo, sessionState.MsgEncKey->EncKey.AES128CTRSHA1.DataKey,
+                              p, payloadLen + HMACSHA1::kDigestLength, p);
+
+        // Compute the expected integrity check value from the decrypted payload.
+        uint8_t expectedIntegrityCheck[HMACSHA1::kDigestLength];
+        ComputeIntegrityCheck_AES128CTRSHA1(msgInfo, sessionState.MsgEncKey->EncKey.AES128CTRSHA1.IntegrityKey,
+                                            p, payloadLen, expectedIntegrityCheck);
+        // Error if the expected integrity check doesn't match the integrity check in the message.
+        if (!ConstantTimeCompare(p + payloadLen, expectedIntegrityCheck, HMACSHA1::kDigestLength))
+            return WEAVE_ERROR_INTEGRITY_CHECK_FAILED;
+    }
+
+    FinishDecodeMessage(msgInfo, sessionState);
+
+    return err;
+}
+
+/**
+ *  Decode the header of a received message, get the session state for its source node and key, and
+ *  locate its payload.  For encrypted messages the payload is still encrypted on return, and is
+ *  followed in the message buffer by the (encrypted) integrity check value.
+ */
+WEAVE_ERROR WeaveMessageLayer::PrepareDecodeMessage(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
+        WeaveMessageInfo *msgInfo, WeaveSessionState &sessionState, uint8_t **rPayload, uint16_t *rPayloadLen)
 {
     WEAVE_ERROR err;
     uint8_t *msgStart = msgBuf->Start();
@@ -1319,8 +1386,6 @@ WEAVE_ERROR WeaveMessageLayer::DecodeMessage(PacketBuffer *msgBuf, uint64_t sour
         return err;
 
     // Get the session state for the given source node and encryption key.
-    WeaveSessionState sessionState;
-
     err = FabricState->GetSessionState(sourceNodeId, msgInfo->KeyId, msgInfo->EncryptionType, con, sessionState);
     if (err != WEAVE_NO_ERROR)
         return err;
@@ -1331,43 +1396,30 @@ WEAVE_ERROR WeaveMessageLayer::DecodeMessage(PacketBuffer *msgBuf, uint64_t sour
         // Return the position and length of the payload within the message.
         *rPayloadLen = msgLen - (p - msgStart);
         *rPayload = p;
-
-        // Skip over the payload.
-        p += *rPayloadLen;
         break;
 
     case kWeaveEncryptionType_AES128CTRSHA1:
-    {
         // Error if the message is short given the expected fields.
         if ((p + kMinPayloadLen + HMACSHA1::kDigestLength) > msgEnd)
             return WEAVE_ERROR_INVALID_MESSAGE_LENGTH;
 
         // Return the position and length of the payload within the message.
-        uint16_t payloadLen = msgLen - ((p - msgStart) + HMACSHA1::kDigestLength);
-        *rPayloadLen = payloadLen;
+        *rPayloadLen = msgLen - ((p - msgStart) + HMACSHA1::kDigestLength);
         *rPayload = p;
-
-        // Decrypt the message payload and the integrity check value that follows it, in place, in the message buffer.
-        Encrypt_AES128CTRSHA1(msgInfo, sessionState.MsgEncKey->EncKey.AES128CTRSHA1.DataKey,
-                              p, payloadLen + HMACSHA1::kDigestLength, p);
-
-        // Compute the expected integrity check value from the decrypted payload.
-        uint8_t expectedIntegrityCheck[HMACSHA1::kDigestLength];
-        ComputeIntegrityCheck_AES128CTRSHA1(msgInfo, sessionState.MsgEncKey->EncKey.AES128CTRSHA1.IntegrityKey,
-                                            p, payloadLen, expectedIntegrityCheck);
-        // Error if the expected integrity check doesn't match the integrity check in the message.
-        if (!ConstantTimeCompare(p + payloadLen, expectedIntegrityCheck, HMACSHA1::kDigestLength))
-            return WEAVE_ERROR_INTEGRITY_CHECK_FAILED;
-        // Skip past the payload and the integrity check value.
-        p += payloadLen + HMACSHA1::kDigestLength;
-
         break;
-    }
 
     default:
         return WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE;
     }
 
+    return WEAVE_NO_ERROR;
+}
+
+/**
+ *  Apply the session state to a message whose payload has been decrypted and authenticated.
+ */
+void WeaveMessageLayer::FinishDecodeMessage(WeaveMessageInfo *msgInfo, WeaveSessionState &sessionState)
+{
     // Set flag in the message header indicating that the message is a duplicate if:
     //  - A message with the same message identifier has already been received from that peer.
     //  - This is the first message from that peer encrypted with application keys.
@@ -1382,8 +1434,6 @@ WEAVE_ERROR WeaveMessageLayer::DecodeMessage(PacketBuffer *msgBuf, uint64_t sour
 
     // Pass the peer authentication mode back to the application via the weave message header structure.
     msgInfo->PeerAuthMode = sessionState.AuthMode;
-
-    return err;
 }
 
 WEAVE_ERROR WeaveMessageLayer::EncodeMessageWithLength(WeaveMessageInfo *msgInfo, PacketBuffer *msgBuf,
@@ -1409,6 +1459,58 @@ WEAVE_ERROR WeaveMessageLayer::DecodeMessageWithLength(PacketBuffer *msgBuf, uin
     uint8_t *dataStart = msgBuf->Start();
     uint16_t dataLen = msgBuf->DataLength();
 
+    // Error if the message buffer doesn't contain the entire message.
+    WEAVE_ERROR err = DecodeFrameLength(msgBuf, rFrameLen);
+    if (err != WEAVE_NO_ERROR)
+        return err;
+
+    uint16_t msgLen = *rFrameLen - 2;
+
+    // Adjust the message buffer to point at the message, not including the message length field that precedes it,
+    // and not including any data that may follow it.
+    msgBuf->SetStart(dataStart + 2);
+    msgBuf->SetDataLength(msgLen);
+
+    // Decode the message.
+    err = DecodeMessage(msgBuf, sourceNodeId, con, msgInfo, rPayload, rPayloadLen);
+
+    // If successful, adjust the message buffer to point at any remaining data beyond the end of the message.
+    // (This may in fact represent another message).
+    if (err == WEAVE_NO_ERROR)
+    {
+        msgBuf->SetStart(dataStart + msgLen + 2);
+        msgBuf->SetDataLength(dataLen - (msgLen + 2));
+    }
+
+    // Otherwise, reset the buffer to its original position/length.
+    else
+    {
+        msgBuf->SetStart(dataStart);
+        msgBuf->SetDataLength(dataLen);
+    }
+
+    return err;
+}
+
+/**
+ *  Read the length field of the length-prefixed message at the head of a message buffer.
+ *
+ *  @param[in]    msgBuf        The buffer holding the received data.
+ *
+ *  @param[out]   rFrameLen     The length of the message plus its length field or, if the length field
+ *                              itself is incomplete, the minimum length of a frame.
+ *
+ *  @retval  #WEAVE_NO_ERROR    If the buffer holds the entire message.
+ *  @retval  #WEAVE_ERROR_MESSAGE_INCOMPLETE
+ *                              If the buffer holds only part of the message.
+ *  @retval  #WEAVE_ERROR_MESSAGE_TOO_LONG
+ *                              If the message would never fit in the buffer.
+ *
+ */
+WEAVE_ERROR WeaveMessageLayer::DecodeFrameLength(const PacketBuffer *msgBuf, uint16_t *rFrameLen)
+{
+    uint16_t dataLen = msgBuf->DataLength();
+
     // Error if the message buffer doesn't contain the entire message length field.
     if (dataLen < 2)
     {
@@ -1416,11 +1518,8 @@ WEAVE_ERROR WeaveMessageLayer::DecodeMessageWithLength(PacketBuffer *msgBuf, uin
         return WEAVE_ERROR_MESSAGE_INCOMPLETE;
     }
 
-    // Read the message length.
-    uint16_t msgLen = LittleEndian::Get16(dataStart);
-
     // The frame length is the length of the message plus the length of the length field.
-    *rFrameLen = msgLen + 2;
+    *rFrameLen = LittleEndian::Get16(msgBuf->Start()) + 2;
 
     // Error if the message buffer doesn't contain the entire message, or is too
     // long to ever fit in the buffer.
@@ -1431,32 +1530,229 @@ WEAVE_ERROR WeaveMessageLayer::DecodeMessageWithLength(PacketBuffer *msgBuf, uin
         return WEAVE_ERROR_MESSAGE_INCOMPLETE;
     }
 
-    // Adjust the message buffer to point at the message, not including the message length field that precedes it,
-    // and not including any data that may follow it.
-    msgBuf->SetStart(dataStart + 2);
-    msgBuf->SetDataLength(msgLen);
+    return WEAVE_NO_ERROR;
+}
 
-    // Decode the message.
-    WEAVE_ERROR err = DecodeMessage(msgBuf, sourceNodeId, con, msgInfo, rPayload, rPayloadLen);
+/**
+ *  Decode, in place, a batch of consecutive length-prefixed messages at the head of a message buffer.
+ *
+ *  Encrypted messages are decrypted one after another, reusing the expanded AES key while consecutive
+ *  messages share a session key, and their integrity checks are then computed together with
+ *  HMACSHA1::AddDataMultiple().
+ *
+ *  Unlike DecodeMessageWithLength(), this function does not consume the decoded messages from the
+ *  buffer, and it does not apply duplicate message detection.  The caller must call
+ *  FinishDecodeMessage() for each message, in order, immediately before dispatching it, and
+ *  RestoreDecodedMessages() for any messages it does not dispatch before returning the data to the
+ *  end point.
+ *
+ *  Only the first message's errors are reported.  Decoding stops without error before any later
+ *  message that is incomplete or fails to decode, so that it is decoded again, with its error
+ *  reported, once the messages before it have been dispatched.  This also lets a message encrypted
+ *  with a session key established by an earlier message in the same batch be decoded once that
+ *  key is in place.
+ *
+ *  @param[in]    msgBuf        The buffer holding the received data.
+ *
+ *  @param[in]    sourceNodeId  The node identifier of the peer.
+ *
+ *  @param[in]    con           The connection the data was received on.
+ *
+ *  @param[inout] msgs          An array of entries for the decoded messages.  The MsgInfo of each
+ *                              entry must be cleared and initialized by the caller.
+ *
+ *  @param[in]    maxMsgs       The number of entries in msgs.  At most
+ *                              #WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE messages are decoded.
+ *
+ *  @param[out]   rNumMsgs      The number of messages decoded.
+ *
+ *  @param[out]   rFrameLen     On error, the frame length of the first message, as returned by
+ *                              DecodeMessageWithLength().
+ *
+ *  @retval  #WEAVE_NO_ERROR    If at least one message was decoded.
+ *  @retval  other              The error decoding the first message.
+ *
+ */
+WEAVE_ERROR WeaveMessageLayer::DecodeMessagesWithLength(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
+        DecodedMessage msgs[], uint8_t maxMsgs, uint8_t *rNumMsgs, uint16_t *rFrameLen)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint8_t *dataStart = msgBuf->Start();
+    uint16_t dataLen = msgBuf->DataLength();
+    uint16_t offset = 0;
+    uint8_t numMsgs = 0;
+    uint8_t numChecks = 0;
+    uint8_t numVerified;
+    WeaveSessionState sessionStates[WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE];
+    HMACSHA1 hmacs[WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE];
+    HMACSHA1 *hmacPtrs[WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE];
+    const uint8_t *checkData[WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE];
+    uint16_t checkDataLens[WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE];
+    uint8_t checkMsgIndex[WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE];
 
-    // If successful, adjust the message buffer to point at any remaining data beyond the end of the message.
-    // (This may in fact represent another message).
-    if (err == WEAVE_NO_ERROR)
+    *rNumMsgs = 0;
+
+    if (maxMsgs > WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE)
+        maxMsgs = WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE;
+
+    // Decode the header of each complete message and get its session state.
+    while (numMsgs < maxMsgs && offset < dataLen)
     {
-        msgBuf->SetStart(dataStart + msgLen + 2);
-        msgBuf->SetDataLength(dataLen - (msgLen + 2));
+        DecodedMessage &msg = msgs[numMsgs];
+        uint16_t frameLen;
+
+        msgBuf->SetStart(dataStart + offset);
+        msgBuf->SetDataLength(dataLen - offset);
+
+        err = DecodeFrameLength(msgBuf, &frameLen);
+        if (err == WEAVE_NO_ERROR)
+        {
+            // Point the message buffer at the message, not including its length field.
+            msgBuf->SetStart(dataStart + offset + 2);
+            msgBuf->SetDataLength(frameLen - 2);
+
+            err = PrepareDecodeMessage(msgBuf, sourceNodeId, con, &msg.MsgInfo, sessionStates[numMsgs],
+                                       &msg.Payload, &msg.PayloadLen);
+        }
+
+        if (err != WEAVE_NO_ERROR)
+        {
+            if (numMsgs == 0)
+            {
+                *rFrameLen = frameLen;
+                ExitNow();
+            }
+            err = WEAVE_NO_ERROR;
+            break;
+        }
+
+        msg.FrameLen = frameLen;
+        offset += frameLen;
+        numMsgs++;
     }
 
-    // Otherwise, reset the buffer to its original position/length.
-    else
+    // Decrypt the encrypted messages, then compute their integrity checks together.
     {
-        msgBuf->SetStart(dataStart);
-        msgBuf->SetDataLength(dataLen);
+        AES128CTRMode aes128CTR;
+        HMACSHA1 keyedHMAC;
+        const uint8_t *dataKey = NULL;
+        const uint8_t *integrityKey = NULL;
+
+        for (uint8_t i = 0; i < numMsgs; i++)
+        {
+            DecodedMessage &msg = msgs[i];
+
+            if (msg.MsgInfo.EncryptionType != kWeaveEncryptionType_AES128CTRSHA1)
+                continue;
+
+            const WeaveEncryptionKey_AES128CTRSHA1 &key = sessionStates[i].MsgEncKey->EncKey.AES128CTRSHA1;
+
+            // Expand the data key, and hash the keyed HMAC inner block, once per run of messages sharing a key.
+            if (key.DataKey != dataKey)
+            {
+                dataKey = key.DataKey;
+                aes128CTR.SetKey(dataKey);
+            }
+            if (key.IntegrityKey != integrityKey)
+            {
+                integrityKey = key.IntegrityKey;
+                keyedHMAC.Begin(integrityKey, WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize);
+            }
+
+            // Decrypt the payload and the integrity check value that follows it, in place.
+            aes128CTR.SetWeaveMessageCounter(msg.MsgInfo.SourceNodeId, msg.MsgInfo.MessageId);
+            aes128CTR.EncryptData(msg.Payload, msg.PayloadLen + HMACSHA1::kDigestLength, msg.Payload);
+            memcpy(msg.DataKey, dataKey, sizeof(msg.DataKey));
+
+            hmacs[numChecks] = keyedHMAC;
+            AddIntegrityCheckHeader_AES128CTRSHA1(&msg.MsgInfo, hmacs[numChecks]);
+
+            hmacPtrs[numChecks] = &hmacs[numChecks];
+            checkData[numChecks] = msg.Payload;
+            checkDataLens[numChecks] = msg.PayloadLen;
+            checkMsgIndex[numChecks] = i;
+            numChecks++;
+        }
+
+        aes128CTR.Reset();
+        keyedHMAC.Reset();
+    }
+
+    HMACSHA1::AddDataMultiple(hmacPtrs, checkData, checkDataLens, numChecks);
+
+    // Keep the messages up to the first one that fails its integrity check.
+    numVerified = numMsgs;
+    for (uint8_t i = 0; i < numChecks; i++)
+    {
+        uint8_t expectedIntegrityCheck[HMACSHA1::kDigestLength];
+        const DecodedMessage &msg = msgs[checkMsgIndex[i]];
+
+        hmacs[i].Finish(expectedIntegrityCheck);
+
+        if (checkMsgIndex[i] < numVerified &&
+            !ConstantTimeCompare(msg.Payload + msg.PayloadLen, expectedIntegrityCheck, HMACSHA1::kDigestLength))
+            numVerified = checkMsgIndex[i];
     }
 
+    if (numVerified == 0)
+    {
+        *rFrameLen = msgs[0].FrameLen;
+        ExitNow(err = WEAVE_ERROR_INTEGRITY_CHECK_FAILED);
+    }
+
+    // Re-encrypt the failed message and those after it, so that they are decoded again later.
+    RestoreDecodedMessages(msgs + numVerified, numMsgs - numVerified);
+
+    *rNumMsgs = numVerified;
+
+exit:
+    msgBuf->SetStart(dataStart);
+    msgBuf->SetDataLength(dataLen);
+
     return err;
 }
 
+/**
+ *  Apply duplicate message detection to a message decoded by DecodeMessagesWithLength() before it is
+ *  dispatched.  The session state is looked up again, since dispatching earlier messages of the batch
+ *  may have changed it.
+ */
+WEAVE_ERROR WeaveMessageLayer::FinishDecodeMessage(DecodedMessage &msg, WeaveConnection *con)
+{
+    WEAVE_ERROR err;
+    WeaveSessionState sessionState;
+
+    err = FabricState->GetSessionState(msg.MsgInfo.SourceNodeId, msg.MsgInfo.KeyId, msg.MsgInfo.EncryptionType, con,
+                                       sessionState);
+    if (err != WEAVE_NO_ERROR)
+        return err;
+
+    FinishDecodeMessage(&msg.MsgInfo, sessionState);
+
+    return WEAVE_NO_ERROR;
+}
+
+/**
+ *  Re-encrypt, in place, messages decoded by DecodeMessagesWithLength() that will not be dispatched,
+ *  restoring the received data so that it can be decoded again.
+ *
+ *  Each message is re-encrypted with the key it was decrypted with, not the current session key, so
+ *  the original data is restored even if dispatching an earlier message replaced or removed the key.
+ *  The caller must clear the saved keys with ClearSecretData() once it is done with the messages.
+ */
+void WeaveMessageLayer::RestoreDecodedMessages(DecodedMessage msgs[], uint8_t numMsgs)
+{
+    for (uint8_t i = 0; i < numMsgs; i++)
+    {
+        DecodedMessage &msg = msgs[i];
+
+        if (msg.MsgInfo.EncryptionType != kWeaveEncryptionType_AES128CTRSHA1)
+            continue;
+
+        Encrypt_AES128CTRSHA1(&msg.MsgInfo, msg.DataKey, msg.Payload, msg.PayloadLen + HMACSHA1::kDigestLength, msg.Payload);
+    }
+}
+
 void WeaveMessageLayer::HandleUDPMessage(UDPEndPoint *endPoint, PacketBuffer *msg, const IPPacketInfo *pktInfo)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
@@ -2131,32 +2427,12 @@ void WeaveMessageLayer::ComputeIntegrityCheck_AES128CTRSHA1(const WeaveMessageIn
                                                             const uint8_t *inData, uint16_t inLen, uint8_t *outBuf)
 {
     HMACSHA1 hmacSHA1;
-    uint8_t encodedBuf[2 * sizeof(uint64_t) + sizeof(uint16_t) + sizeof(uint32_t)];
-    uint8_t *p = encodedBuf;
 
     // Initialize HMAC Key.
     hmacSHA1.Begin(key, WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize);
 
-    // Encode the source and destination node identifiers in a little-endian format.
-    Encoding::LittleEndian::Write64(p, msgInfo->SourceNodeId);
-    Encoding::LittleEndian::Write64(p, msgInfo->DestNodeId);
-
-    // Hash the message header field and the message Id for the message version V2.
-    if (msgInfo->MessageVersion == kWeaveMessageVersion_V2)
-    {
-        // Encode message header field value.
-        uint16_t headerField = EncodeHeaderField(msgInfo);
-
-        // Mask destination and source node Id flags.
-        headerField &= kMsgHeaderField_MessageHMACMask;
-
-        // Encode the message header field and the message Id in a little-endian format.
-        Encoding::LittleEndian::Write16(p, headerField);
-        Encoding::LittleEndian::Write32(p, msgInfo->MessageId);
-    }
-
-    // Hash encoded message header fields.
-    hmacSHA1.AddData(encodedBuf, p - encodedBuf);
+    // Hash the message header fields.
+    AddIntegrityCheckHeader_AES128CTRSHA1(msgInfo, hmacSHA1);
 
     // Handle payload data.
     hmacSHA1.AddData(inData, inLen);
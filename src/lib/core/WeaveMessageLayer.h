@@ -716,14 +716,35 @@ private:
     WEAVE_ERROR DisableUnsecuredListen(void);
     bool IsUnsecuredListenEnabled(void) const;
 
+    /**
+     *  A message decoded, but not yet dispatched, by DecodeMessagesWithLength().
+     */
+    struct DecodedMessage
+    {
+        WeaveMessageInfo MsgInfo;   /**< The decoded message header. */
+        uint8_t *Payload;           /**< The decrypted payload, within the received data. */
+        uint16_t PayloadLen;        /**< The length of the payload. */
+        uint16_t FrameLen;          /**< The length of the message, including its length field. */
+        uint8_t DataKey[WeaveEncryptionKey_AES128CTRSHA1::DataKeySize];
+                                    /**< The key the message was decrypted with, used to restore it. */
+    };
+
     WEAVE_ERROR SendMessage(const IPAddress &destAddr, uint16_t destPort, InterfaceId sendIntfId, PacketBuffer *payload, uint16_t udpSendFlags);
     WEAVE_ERROR SelectDestNodeIdAndAddress(uint64_t& destNodeId, IPAddress& destAddr);
     WEAVE_ERROR DecodeMessage(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
             WeaveMessageInfo *msgInfo, uint8_t **rPayload, uint16_t *rPayloadLen);
+    WEAVE_ERROR PrepareDecodeMessage(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
+            WeaveMessageInfo *msgInfo, WeaveSessionState &sessionState, uint8_t **rPayload, uint16_t *rPayloadLen);
+    void FinishDecodeMessage(WeaveMessageInfo *msgInfo, WeaveSessionState &sessionState);
     WEAVE_ERROR EncodeMessageWithLength(WeaveMessageInfo *msgInfo, PacketBuffer *msgBuf, WeaveConnection *con,
             uint16_t maxLen);
     WEAVE_ERROR DecodeMessageWithLength(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
             WeaveMessageInfo *msgInfo, uint8_t **rPayload, uint16_t *rPayloadLen, uint16_t *rFrameLen);
+    WEAVE_ERROR DecodeMessagesWithLength(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
+            DecodedMessage msgs[], uint8_t maxMsgs, uint8_t *rNumMsgs, uint16_t *rFrameLen);
+    WEAVE_ERROR FinishDecodeMessage(DecodedMessage &msg, WeaveConnection *con);
+    void RestoreDecodedMessages(DecodedMessage msgs[], uint8_t numMsgs);
+    static WEAVE_ERROR DecodeFrameLength(const PacketBuffer *msgBuf, uint16_t *rFrameLen);
 
     static void HandleUDPMessage(UDPEndPoint *endPoint, PacketBuffer *msg, const IPPacketInfo *pktInfo);
     static void HandleUDPReceiveError(UDPEndPoint *endPoint, INET_ERROR err, const IPPacketInfo *pktInfo);
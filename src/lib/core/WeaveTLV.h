@@ -62,6 +62,8 @@ namespace TLV {
 
 using nl::Weave::System::PacketBuffer;
 
+class TLVIndex;
+
 enum {
     kTLVControlByte_NotSpecified = 0xFFFF
 };
@@ -144,6 +146,9 @@ public:
 
     WEAVE_ERROR Skip(void);
 
+    void SetIndex(const TLVIndex *index) { mIndex = index; }
+    const TLVIndex *GetIndex(void) const { return mIndex; }
+
     uint32_t ImplicitProfileId;
     void *AppData;
 
@@ -161,6 +166,7 @@ protected:
     uint32_t mMaxLen;
     TLVType mContainerType;
     uint16_t mControlByte;
+    const TLVIndex *mIndex;
 
 private:
     bool mContainerOpen;
@@ -173,6 +179,7 @@ protected:
     void ClearElementState(void);
     WEAVE_ERROR SkipData(void);
     WEAVE_ERROR SkipToEndOfContainer(void);
+    bool SkipContainerUsingIndex(void);
     WEAVE_ERROR VerifyElement(void);
     uint64_t ReadTag(TLVTagControl tagControl, const uint8_t *& p);
     WEAVE_ERROR EnsureData(WEAVE_ERROR noDataErr);
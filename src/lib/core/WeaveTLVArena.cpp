@@ -0,0 +1,316 @@
+/*
+ *
+ *    Copyright (c) 2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements WeaveTLVArena, a growable, contiguous
+ *      arena for TLV encodings, and ArenaTLVWriter.
+ *
+ */
+
+#include <string.h>
+
+#include <Weave/Core/WeaveTLVArena.h>
+#include <Weave/Support/CodeUtils.h>
+#include <SystemLayer/SystemPacketBuffer.h>
+
+namespace nl {
+namespace Weave {
+namespace TLV {
+
+using nl::Weave::System::PacketBuffer;
+
+enum
+{
+    kMinArenaGrowth = 256 //< Size of the first allocation of an arena initialized without storage
+};
+
+WeaveTLVArena::WeaveTLVArena(void) :
+    mData(NULL),
+    mDataLength(0),
+    mCapacity(0),
+    mMaxSize(0)
+{
+}
+
+WeaveTLVArena::~WeaveTLVArena(void)
+{
+    Shutdown();
+}
+
+/**
+ * @brief
+ *   Initializes the arena.
+ *
+ * @param[in]    inInitialSize  The number of bytes to allocate up front.  If 0, storage is
+ *                              allocated when the first element is written.
+ * @param[in]    inMaxSize      The size beyond which the arena will not grow.
+ *
+ * @retval #WEAVE_NO_ERROR               On success.
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT If @p inInitialSize exceeds @p inMaxSize.
+ * @retval #WEAVE_ERROR_NO_MEMORY        If the initial storage could not be allocated.
+ */
+WEAVE_ERROR WeaveTLVArena::Init(uint32_t inInitialSize, uint32_t inMaxSize)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(inInitialSize <= inMaxSize, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    Shutdown();
+
+    mMaxSize = inMaxSize;
+
+    if (inInitialSize > 0)
+    {
+        mData = static_cast<uint8_t *>(malloc(inInitialSize));
+        VerifyOrExit(mData != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        mCapacity = inInitialSize;
+    }
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   Discards the contents of the arena, keeping its storage for reuse.
+ */
+void WeaveTLVArena::Reset(void)
+{
+    mDataLength = 0;
+}
+
+/**
+ * @brief
+ *   Discards the contents of the arena and frees its storage.
+ */
+void WeaveTLVArena::Shutdown(void)
+{
+    free(mData);
+
+    mData = NULL;
+    mDataLength = 0;
+    mCapacity = 0;
+}
+
+/**
+ * @brief
+ *   Doubles the storage of the arena, up to its maximum size.
+ *
+ * @retval #WEAVE_NO_ERROR               On success.
+ * @retval #WEAVE_ERROR_BUFFER_TOO_SMALL If the arena has reached its maximum size.
+ * @retval #WEAVE_ERROR_NO_MEMORY        If the storage could not be reallocated.
+ */
+WEAVE_ERROR WeaveTLVArena::Grow(void)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint32_t newCapacity;
+    uint8_t *newData;
+
+    VerifyOrExit(mCapacity < mMaxSize, err = WEAVE_ERROR_BUFFER_TOO_SMALL);
+
+    if (mCapacity == 0)
+        newCapacity = kMinArenaGrowth;
+    else if (mCapacity > mMaxSize / 2)
+        newCapacity = mMaxSize;
+    else
+        newCapacity = mCapacity * 2;
+
+    if (newCapacity > mMaxSize)
+        newCapacity = mMaxSize;
+
+    newData = static_cast<uint8_t *>(realloc(mData, newCapacity));
+    VerifyOrExit(newData != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+    mData = newData;
+    mCapacity = newCapacity;
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   Appends the next slice of the arena's contents to a PacketBuffer.
+ *
+ * A message encoded into the arena is sent by calling this method repeatedly, each time with a
+ * new buffer, until it returns #WEAVE_END_OF_INPUT.
+ *
+ * @param[inout] ioOffset  The offset of the first byte to copy.  Advanced past the bytes copied.
+ * @param[inout] ioBuf     The buffer to append to.
+ * @param[in]    inMaxLen  The maximum number of bytes to copy, e.g. the payload size allowed by
+ *                         the path MTU.  Fewer are copied if @p ioBuf has less room available.
+ *
+ * @retval #WEAVE_NO_ERROR               If at least one byte was copied.
+ * @retval #WEAVE_END_OF_INPUT           If @p ioOffset is at the end of the arena's contents.
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT If @p ioOffset is past the end of the arena's contents.
+ * @retval #WEAVE_ERROR_BUFFER_TOO_SMALL If @p ioBuf or @p inMaxLen leave no room to copy into.
+ */
+WEAVE_ERROR WeaveTLVArena::CopyToPacketBuffer(uint32_t& ioOffset, PacketBuffer *ioBuf, uint32_t inMaxLen) const
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint32_t len;
+
+    VerifyOrExit(ioOffset <= mDataLength, err = WEAVE_ERROR_INVALID_ARGUMENT);
+    VerifyOrExit(ioOffset < mDataLength, err = WEAVE_END_OF_INPUT);
+
+    len = mDataLength - ioOffset;
+    if (len > inMaxLen)
+        len = inMaxLen;
+    if (len > ioBuf->AvailableDataLength())
+        len = ioBuf->AvailableDataLength();
+
+    VerifyOrExit(len > 0, err = WEAVE_ERROR_BUFFER_TOO_SMALL);
+
+    memcpy(ioBuf->Start() + ioBuf->DataLength(), mData + ioOffset, len);
+    ioBuf->SetDataLength(ioBuf->DataLength() + len);
+
+    ioOffset += len;
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   An implementation of a TLVWriter GetNewBuffer function for writing to a WeaveTLVArena.
+ *
+ * The new space continues the encoding directly after the data the writer has finalized, growing
+ * the arena if it is full.
+ *
+ * @param[inout] ioWriter     TLVWriter calling this function
+ * @param[inout] inBufHandle  A handle to the WeaveTLVArena object
+ * @param[out]   outBufStart  The pointer to the new buffer
+ * @param[out]   outBufLen    The available length for writing
+ *
+ * @retval #WEAVE_NO_ERROR               On success.
+ * @retval #WEAVE_ERROR_BUFFER_TOO_SMALL If the arena has reached its maximum size.
+ * @retval #WEAVE_ERROR_NO_MEMORY        If the arena could not be grown.
+ */
+WEAVE_ERROR WeaveTLVArena::GetNewBufferFunct(TLVWriter& ioWriter, uintptr_t& inBufHandle, uint8_t *& outBufStart, uint32_t& outBufLen)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    WeaveTLVArena *arena = reinterpret_cast<WeaveTLVArena *>(inBufHandle);
+
+    if (arena->mDataLength == arena->mCapacity)
+    {
+        err = arena->Grow();
+        SuccessOrExit(err);
+    }
+
+    outBufStart = arena->mData + arena->mDataLength;
+    outBufLen = arena->mCapacity - arena->mDataLength;
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   An implementation of a TLVWriter FinalizeBuffer function for writing to a WeaveTLVArena.
+ *
+ * @param[inout] ioWriter     TLVWriter calling this function
+ * @param[in]    inBufHandle  A handle to the WeaveTLVArena object
+ * @param[in]    inBufStart   The start of the space written since the last call
+ * @param[in]    inBufLen     The number of bytes written since the last call
+ *
+ * @retval #WEAVE_NO_ERROR  Unconditionally.
+ */
+WEAVE_ERROR WeaveTLVArena::FinalizeBufferFunct(TLVWriter& ioWriter, uintptr_t inBufHandle, uint8_t *inBufStart, uint32_t inBufLen)
+{
+    WeaveTLVArena *arena = reinterpret_cast<WeaveTLVArena *>(inBufHandle);
+
+    arena->mDataLength = (inBufStart - arena->mData) + inBufLen;
+
+    return WEAVE_NO_ERROR;
+}
+
+/**
+ * @brief
+ *   Initializes a TLVWriter object to append to a WeaveTLVArena.
+ *
+ * Writing begins after any data already in the arena.  As with other writers, the application
+ * must call Finalize() before using the contents of the arena.
+ *
+ * @param[in]    inArena   A pointer to an initialized WeaveTLVArena.
+ * @param[in]    inMaxLen  The maximum number of bytes that should be written.
+ */
+void ArenaTLVWriter::Init(WeaveTLVArena *inArena, uint32_t inMaxLen)
+{
+    mBufHandle = reinterpret_cast<uintptr_t>(inArena);
+    mBufStart = mWritePoint = inArena->mData + inArena->mDataLength;
+    mRemainingLen = inArena->mCapacity - inArena->mDataLength;
+    if (mRemainingLen > inMaxLen)
+        mRemainingLen = inMaxLen;
+    mLenWritten = 0;
+    mMaxLen = inMaxLen;
+    mContainerType = kTLVType_NotSpecified;
+    SetContainerOpen(false);
+    SetCloseContainerReserved(true);
+
+    ImplicitProfileId = kProfileIdNotSpecified;
+    GetNewBuffer = WeaveTLVArena::GetNewBufferFunct;
+    FinalizeBuffer = WeaveTLVArena::FinalizeBufferFunct;
+}
+
+/**
+ * @brief
+ *   Records the state of the writer, so that everything written after this point can later be
+ *   discarded with Rollback().
+ *
+ * @param[out]   outCheckpoint  The checkpoint.
+ */
+void ArenaTLVWriter::GetCheckpoint(Checkpoint& outCheckpoint) const
+{
+    const WeaveTLVArena *arena = reinterpret_cast<const WeaveTLVArena *>(mBufHandle);
+
+    outCheckpoint.mState = *this;
+    outCheckpoint.mBufStartOffset = mBufStart - arena->mData;
+    outCheckpoint.mWritePointOffset = mWritePoint - arena->mData;
+}
+
+/**
+ * @brief
+ *   Returns the writer to a checkpoint taken with GetCheckpoint(), discarding everything written
+ *   since.
+ *
+ * The checkpoint must have been taken on this writer since it was initialized, and the arena
+ * must not have been reset in between.
+ *
+ * @param[in]    inCheckpoint   The checkpoint.
+ */
+void ArenaTLVWriter::Rollback(const Checkpoint& inCheckpoint)
+{
+    WeaveTLVArena *arena;
+
+    *static_cast<TLVWriter *>(this) = inCheckpoint.mState;
+
+    arena = reinterpret_cast<WeaveTLVArena *>(mBufHandle);
+
+    // The arena may have moved since the checkpoint was taken.
+    mBufStart = arena->mData + inCheckpoint.mBufStartOffset;
+    mWritePoint = arena->mData + inCheckpoint.mWritePointOffset;
+
+    if (arena->mDataLength > inCheckpoint.mWritePointOffset)
+        arena->mDataLength = inCheckpoint.mWritePointOffset;
+}
+
+} // namespace TLV
+} // namespace Weave
+} // namespace nl
@@ -0,0 +1,116 @@
+/*
+ *
+ *    Copyright (c) 2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *  @file
+ *      This file defines a growable, contiguous arena for TLV
+ *      encodings, and a TLVWriter that writes into it.  Large messages
+ *      are encoded into the arena and only copied into PacketBuffers,
+ *      one MTU-sized slice at a time, when they are sent.
+ */
+
+#ifndef WEAVE_TLV_ARENA_H_
+#define WEAVE_TLV_ARENA_H_
+
+#include <stdlib.h>
+
+#include <Weave/Support/NLDLLUtil.h>
+#include <Weave/Core/WeaveError.h>
+#include "WeaveTLVTags.h"
+#include "WeaveTLVTypes.h"
+#include "WeaveTLV.h"
+
+namespace nl {
+namespace Weave {
+namespace TLV {
+
+/**
+ * @class WeaveTLVArena
+ *
+ * @brief
+ *    WeaveTLVArena provides contiguous, heap-allocated storage for an
+ *    nl::Weave::TLV::ArenaTLVWriter.  The storage grows geometrically, up to a
+ *    configured limit, as the writer needs it, and is kept across Reset() so
+ *    that an arena reused for successive messages stops allocating once it
+ *    has reached the size of the largest of them.
+ *
+ *    Because the storage can move when it grows, positions in the arena are
+ *    held as offsets rather than pointers.
+ */
+class NL_DLL_EXPORT WeaveTLVArena
+{
+    friend class ArenaTLVWriter;
+
+public:
+    WeaveTLVArena(void);
+    ~WeaveTLVArena(void);
+
+    WEAVE_ERROR Init(uint32_t inInitialSize, uint32_t inMaxSize);
+    void Reset(void);
+    void Shutdown(void);
+
+    inline const uint8_t *Start(void) const { return mData; }
+    inline uint32_t DataLength(void) const { return mDataLength; }
+    inline uint32_t Capacity(void) const { return mCapacity; }
+
+    WEAVE_ERROR CopyToPacketBuffer(uint32_t& ioOffset, PacketBuffer *ioBuf, uint32_t inMaxLen) const;
+
+    static WEAVE_ERROR GetNewBufferFunct(TLVWriter& ioWriter, uintptr_t& inBufHandle, uint8_t *& outBufStart, uint32_t& outBufLen);
+    static WEAVE_ERROR FinalizeBufferFunct(TLVWriter& ioWriter, uintptr_t inBufHandle, uint8_t *inBufStart, uint32_t inBufLen);
+
+private:
+    WEAVE_ERROR Grow(void);
+
+    uint8_t *mData;
+    uint32_t mDataLength;
+    uint32_t mCapacity;
+    uint32_t mMaxSize;
+};
+
+/**
+ * @class ArenaTLVWriter
+ *
+ * @brief
+ *    A TLVWriter that appends to a WeaveTLVArena.
+ *
+ *    A checkpoint taken with GetCheckpoint() records the writer's position
+ *    as an offset, so Rollback() remains valid after the arena has grown.
+ *    Restoring a plain copy of the writer is only safe if the arena has not
+ *    grown since the copy was made.
+ */
+class NL_DLL_EXPORT ArenaTLVWriter : public TLVWriter
+{
+public:
+    struct Checkpoint
+    {
+        TLVWriter mState;
+        uint32_t mBufStartOffset;
+        uint32_t mWritePointOffset;
+    };
+
+    void Init(WeaveTLVArena *inArena, uint32_t inMaxLen = 0xFFFFFFFFUL);
+
+    void GetCheckpoint(Checkpoint& outCheckpoint) const;
+    void Rollback(const Checkpoint& inCheckpoint);
+};
+
+} // namespace TLV
+} // namespace Weave
+} // namespace nl
+
+#endif /* WEAVE_TLV_ARENA_H_ */
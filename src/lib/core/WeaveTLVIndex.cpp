@@ -0,0 +1,241 @@
+/*
+ *
+ *    Copyright (c) 2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements TLVIndex, a structural index over a
+ *      contiguous buffer of Weave TLV.
+ *
+ */
+
+#include <Weave/Core/WeaveEncoding.h>
+#include <Weave/Core/WeaveTLVIndex.h>
+#include <Weave/Support/CodeUtils.h>
+
+namespace nl {
+namespace Weave {
+namespace TLV {
+
+using namespace nl::Weave::Encoding;
+
+enum
+{
+    kTypeInfo_FieldSizeMask     = 0x0F, //< Number of bytes in the length/value field
+    kTypeInfo_HasLength         = 0x10,
+    kTypeInfo_Container         = 0x20,
+    kTypeInfo_EndOfContainer    = 0x40,
+    kTypeInfo_Invalid           = 0x80,
+
+    kNoContainer                = 0xFFFFFFFFUL
+};
+
+// Everything Build() needs to know about an element type, indexed by the low 5 bits of the
+// control byte, so that element heads can be measured without branching on the type.
+static const uint8_t sTypeInfo[32] =
+{
+    1, 2, 4, 8,                                                                     // Int8 .. Int64
+    1, 2, 4, 8,                                                                     // UInt8 .. UInt64
+    0, 0,                                                                           // BooleanFalse, BooleanTrue
+    4, 8,                                                                           // Float32, Float64
+    kTypeInfo_HasLength | 1, kTypeInfo_HasLength | 2,                               // UTF8String
+    kTypeInfo_HasLength | 4, kTypeInfo_HasLength | 8,
+    kTypeInfo_HasLength | 1, kTypeInfo_HasLength | 2,                               // ByteString
+    kTypeInfo_HasLength | 4, kTypeInfo_HasLength | 8,
+    0,                                                                              // Null
+    kTypeInfo_Container, kTypeInfo_Container, kTypeInfo_Container,                  // Structure, Array, Path
+    kTypeInfo_EndOfContainer,                                                       // EndOfContainer
+    kTypeInfo_Invalid, kTypeInfo_Invalid, kTypeInfo_Invalid, kTypeInfo_Invalid,
+    kTypeInfo_Invalid, kTypeInfo_Invalid, kTypeInfo_Invalid
+};
+
+static const uint8_t sTagSizes[] = { 0, 1, 2, 4, 2, 4, 6, 8 };
+
+/**
+ * Initializes a TLVIndex object to store its entries in the supplied array.
+ *
+ * @param[in]   entries     Storage for the index entries.  An encoding needs one entry
+ *                          per element, not counting end-of-container markers.
+ * @param[in]   maxEntries  The number of entries in @p entries.
+ */
+void TLVIndex::Init(Entry *entries, uint32_t maxEntries)
+{
+    mData = NULL;
+    mDataLen = 0;
+    mEntries = entries;
+    mMaxEntries = maxEntries;
+    mEntryCount = 0;
+}
+
+/**
+ * Validates a TLV encoding and builds the index of its elements.
+ *
+ * The encoding may hold any number of top-level elements.  It is checked as a TLVReader
+ * reading every element would check it: element types, tag forms for the enclosing
+ * container, lengths of strings and container nesting.  Tags with an implicit profile are
+ * not resolved.
+ *
+ * While a container is open its entry's End field links to the entry of the enclosing
+ * container, so no storage beyond the entries is needed however deeply the encoding nests.
+ *
+ * @param[in]   data        The TLV encoding.  It must remain valid, and unchanged, for as
+ *                          long as the index is in use.
+ * @param[in]   dataLen     The length of the encoding.
+ *
+ * @retval #WEAVE_NO_ERROR                  If the encoding is valid and was indexed.
+ * @retval #WEAVE_ERROR_INVALID_TLV_ELEMENT If the encoding holds an invalid element type, or an
+ *                                          end-of-container marker outside a container.
+ * @retval #WEAVE_ERROR_INVALID_TLV_TAG     If an element's tag is not allowed in its container.
+ * @retval #WEAVE_ERROR_TLV_UNDERRUN        If the encoding ends inside an element or container.
+ * @retval #WEAVE_ERROR_BUFFER_TOO_SMALL    If the encoding has more elements than there are entries.
+ */
+WEAVE_ERROR TLVIndex::Build(const uint8_t *data, uint32_t dataLen)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint32_t pos = 0;
+    uint32_t count = 0;
+    uint32_t open = kNoContainer;
+    int containerType = kTLVElementType_NotSpecified;
+
+    mData = data;
+    mDataLen = dataLen;
+    mEntryCount = 0;
+
+    while (pos < dataLen)
+    {
+        const uint8_t controlByte = data[pos];
+        const uint8_t typeInfo = sTypeInfo[controlByte & kTLVTypeMask];
+        const uint8_t tagControl = controlByte & kTLVTagControlMask;
+        const uint32_t fieldBytes = typeInfo & kTypeInfo_FieldSizeMask;
+        uint32_t headLen;
+
+        VerifyOrExit((typeInfo & kTypeInfo_Invalid) == 0, err = WEAVE_ERROR_INVALID_TLV_ELEMENT);
+
+        if (typeInfo & kTypeInfo_EndOfContainer)
+        {
+            uint32_t outer;
+
+            VerifyOrExit(open != kNoContainer, err = WEAVE_ERROR_INVALID_TLV_ELEMENT);
+            VerifyOrExit(tagControl == kTLVTagControl_Anonymous, err = WEAVE_ERROR_INVALID_TLV_TAG);
+
+            pos++;
+
+            outer = mEntries[open].End;
+            mEntries[open].End = pos;
+            open = outer;
+            containerType = (open == kNoContainer) ? (int) kTLVElementType_NotSpecified
+                                                   : (int) (data[mEntries[open].Offset] & kTLVTypeMask);
+            continue;
+        }
+
+        switch (containerType)
+        {
+        case kTLVElementType_NotSpecified:
+            VerifyOrExit(tagControl != kTLVTagControl_ContextSpecific, err = WEAVE_ERROR_INVALID_TLV_TAG);
+            break;
+        case kTLVElementType_Array:
+            VerifyOrExit(tagControl == kTLVTagControl_Anonymous, err = WEAVE_ERROR_INVALID_TLV_TAG);
+            break;
+        default:
+            VerifyOrExit(tagControl != kTLVTagControl_Anonymous, err = WEAVE_ERROR_INVALID_TLV_TAG);
+            break;
+        }
+
+        headLen = 1 + sTagSizes[tagControl >> kTLVTagControlShift] + fieldBytes;
+        VerifyOrExit(dataLen - pos >= headLen, err = WEAVE_ERROR_TLV_UNDERRUN);
+
+        VerifyOrExit(count < mMaxEntries, err = WEAVE_ERROR_BUFFER_TOO_SMALL);
+        mEntries[count].Offset = pos;
+
+        if (typeInfo & kTypeInfo_Container)
+        {
+            mEntries[count].End = open;
+            open = count;
+            containerType = controlByte & kTLVTypeMask;
+            pos += headLen;
+        }
+        else
+        {
+            uint64_t valueLen = 0;
+
+            if (typeInfo & kTypeInfo_HasLength)
+            {
+                const uint8_t *p = data + pos + headLen - fieldBytes;
+
+                switch (fieldBytes)
+                {
+                case 1: valueLen = *p; break;
+                case 2: valueLen = LittleEndian::Get16(p); break;
+                case 4: valueLen = LittleEndian::Get32(p); break;
+                default: valueLen = LittleEndian::Get64(p); break;
+                }
+
+                VerifyOrExit(valueLen <= dataLen - pos - headLen, err = WEAVE_ERROR_TLV_UNDERRUN);
+            }
+
+            pos += headLen + (uint32_t) valueLen;
+            mEntries[count].End = pos;
+        }
+
+        count++;
+    }
+
+    VerifyOrExit(open == kNoContainer, err = WEAVE_ERROR_TLV_UNDERRUN);
+
+    mEntryCount = count;
+
+exit:
+    return err;
+}
+
+/**
+ * Returns the index entry of the element whose control byte is at the given offset, or NULL
+ * if no element starts there.
+ */
+const TLVIndex::Entry *TLVIndex::Find(uint32_t offset) const
+{
+    uint32_t lo = 0;
+    uint32_t hi = mEntryCount;
+
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (mEntries[mid].Offset < offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return (lo < mEntryCount && mEntries[lo].Offset == offset) ? &mEntries[lo] : NULL;
+}
+
+/**
+ * Returns the index entry of the element whose control byte is at @p elemStart, or NULL if
+ * @p elemStart is outside the indexed encoding or no element starts there.
+ */
+const TLVIndex::Entry *TLVIndex::Find(const uint8_t *elemStart) const
+{
+    if (mData == NULL || elemStart < mData || elemStart >= mData + mDataLen)
+        return NULL;
+
+    return Find((uint32_t) (elemStart - mData));
+}
+
+} // namespace TLV
+} // namespace Weave
+} // namespace nl
@@ -0,0 +1,84 @@
+/*
+ *
+ *    Copyright (c) 2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *  @file
+ *      This file defines TLVIndex, a structural index over a contiguous
+ *      buffer of Weave TLV that lets a TLVReader skip containers
+ *      without decoding their members.
+ */
+
+#ifndef WEAVE_TLV_INDEX_H_
+#define WEAVE_TLV_INDEX_H_
+
+#include <Weave/Support/NLDLLUtil.h>
+#include <Weave/Core/WeaveError.h>
+#include "WeaveTLV.h"
+
+namespace nl {
+namespace Weave {
+namespace TLV {
+
+/**
+ * @class TLVIndex
+ *
+ * @brief
+ *    A structural index of a contiguous TLV encoding.
+ *
+ *    Build() validates the encoding in a single pass and records, for
+ *    every element, the offset of its control byte and the offset just past
+ *    the element (for a container, just past its end-of-container marker).
+ *    Entries are stored in encoding order in caller-supplied storage.
+ *
+ *    A TLVReader given an index with TLVReader::SetIndex() moves over
+ *    indexed containers in Next(), Skip() and ExitContainer() by jumping to
+ *    their end, rather than reading each of their members.
+ */
+class NL_DLL_EXPORT TLVIndex
+{
+public:
+    struct Entry
+    {
+        uint32_t Offset;    //< Offset of the element's control byte.
+        uint32_t End;       //< Offset immediately after the element.
+    };
+
+    void Init(Entry *entries, uint32_t maxEntries);
+    WEAVE_ERROR Build(const uint8_t *data, uint32_t dataLen);
+
+    const Entry *Find(uint32_t offset) const;
+    const Entry *Find(const uint8_t *elemStart) const;
+
+    const uint8_t *GetData(void) const { return mData; }
+    uint32_t GetDataLength(void) const { return mDataLen; }
+    const Entry *GetEntries(void) const { return mEntries; }
+    uint32_t GetEntryCount(void) const { return mEntryCount; }
+
+private:
+    const uint8_t *mData;
+    uint32_t mDataLen;
+    Entry *mEntries;
+    uint32_t mMaxEntries;
+    uint32_t mEntryCount;
+};
+
+} // namespace TLV
+} // namespace Weave
+} // namespace nl
+
+#endif /* WEAVE_TLV_INDEX_H_ */
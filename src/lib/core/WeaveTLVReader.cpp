@@ -27,6 +27,7 @@
 #include <Weave/Core/WeaveCore.h>
 #include <Weave/Core/WeaveEncoding.h>
 #include <Weave/Core/WeaveTLV.h>
+#include <Weave/Core/WeaveTLVIndex.h>
 #include <Weave/Support/CodeUtils.h>
 
 namespace nl {
@@ -68,6 +69,25 @@ static const uint8_t sTagSizes[] = { 0, 1, 2, 4, 2, 4, 6, 8 };
  * @return A pointer into underlying input buffer that corresponds to the reader's current position.
  */
 
+/**
+ * @fn void TLVReader::SetIndex(const TLVIndex *index)
+ *
+ * Gives the reader a structural index of the encoding it is reading.
+ *
+ * While an index is set, Next(), Skip() and ExitContainer() move over any container the index
+ * covers by jumping to its end, rather than reading each of its members.  The index must have
+ * been built over the same, unchanged data the reader reads.  Containers outside the indexed
+ * data are read as usual.  The index is copied along with the reader, e.g. by OpenContainer().
+ *
+ * @param[in]   index   The index to use, or NULL to stop using one.
+ */
+
+/**
+ * @fn const TLVIndex *TLVReader::GetIndex() const
+ *
+ * Returns the structural index given to the reader with SetIndex(), or NULL if there is none.
+ */
+
 /**
  *
  * @var uint32_t TLVReader::ImplicitProfileId
@@ -152,6 +172,7 @@ void TLVReader::Init(const uint8_t *data, uint32_t dataLen)
     mMaxLen = dataLen;
     ClearElementState();
     mContainerType = kTLVType_NotSpecified;
+    mIndex = NULL;
     SetContainerOpen(false);
 
     ImplicitProfileId = kProfileIdNotSpecified;
@@ -178,6 +199,7 @@ void TLVReader::Init(PacketBuffer *buf, uint32_t maxLen)
     mMaxLen = maxLen;
     ClearElementState();
     mContainerType = kTLVType_NotSpecified;
+    mIndex = NULL;
     SetContainerOpen(false);
 
     ImplicitProfileId = kProfileIdNotSpecified;
@@ -210,6 +232,7 @@ void TLVReader::Init(PacketBuffer *buf, uint32_t maxLen, bool allowDiscontiguous
     mMaxLen = maxLen;
     ClearElementState();
     mContainerType = kTLVType_NotSpecified;
+    mIndex = NULL;
     SetContainerOpen(false);
 
     ImplicitProfileId = kProfileIdNotSpecified;
@@ -245,6 +268,7 @@ void TLVReader::Init(const TLVReader &aReader)
     mMaxLen           = aReader.mMaxLen;
     mControlByte      = aReader.mControlByte;
     mContainerType    = aReader.mContainerType;
+    mIndex            = aReader.mIndex;
     SetContainerOpen(aReader.IsContainerOpen());
 
     // Initialize public data members
@@ -854,6 +878,7 @@ WEAVE_ERROR TLVReader::OpenContainer(TLVReader& containerReader)
     containerReader.mMaxLen = mMaxLen;
     containerReader.ClearElementState();
     containerReader.mContainerType = (TLVType) elemType;
+    containerReader.mIndex = mIndex;
     containerReader.SetContainerOpen(false);
     containerReader.ImplicitProfileId = ImplicitProfileId;
     containerReader.AppData = AppData;
@@ -1160,6 +1185,9 @@ WEAVE_ERROR TLVReader::Next(TLVType expectedType, uint64_t expectedTag)
  * container will be skipped.  If the reader is not positioned on any element, its position remains
  * unchanged.
  *
+ * If the reader has been given a TLVIndex covering the container, the members are skipped without
+ * being read.
+ *
  * @retval #WEAVE_NO_ERROR              If the reader was successfully positioned on a new element.
  * @retval #WEAVE_END_OF_TLV            If no further elements are available.
  * @retval #WEAVE_ERROR_TLV_UNDERRUN    If the underlying TLV encoding ended prematurely.
@@ -1183,6 +1211,14 @@ WEAVE_ERROR TLVReader::Skip()
     if (TLVTypeIsContainer(elemType))
     {
         TLVType outerContainerType;
+
+        if (SkipContainerUsingIndex())
+        {
+            SetContainerOpen(false);
+            ClearElementState();
+            return WEAVE_NO_ERROR;
+        }
+
         err = EnterContainer(outerContainerType);
         if (err != WEAVE_NO_ERROR)
             return err;
@@ -1267,8 +1303,11 @@ WEAVE_ERROR TLVReader::SkipToEndOfContainer()
 
         else if (TLVTypeIsContainer(elemType))
         {
-            nestLevel++;
-            mContainerType = (TLVType)elemType;
+            if (!SkipContainerUsingIndex())
+            {
+                nestLevel++;
+                mContainerType = (TLVType)elemType;
+            }
         }
 
         err = SkipData();
@@ -1281,6 +1320,45 @@ WEAVE_ERROR TLVReader::SkipToEndOfContainer()
     }
 }
 
+/**
+ * If the reader has been given a TLVIndex covering the container element it is positioned on,
+ * moves the read point to the end of the container without reading its members.
+ *
+ * The element state is left as is, so the reader still appears to be on the container.
+ *
+ * @return @p true if the container was skipped; @p false if the reader must read through it.
+ */
+bool TLVReader::SkipContainerUsingIndex()
+{
+    const TLVIndex::Entry *entry;
+    uint8_t elemHeadBytes;
+    uint32_t elemStart;
+    uint32_t skipLen;
+
+    if (mIndex == NULL)
+        return false;
+
+    if (GetElementHeadLength(elemHeadBytes) != WEAVE_NO_ERROR)
+        return false;
+
+    // The head may have been staged across a buffer boundary, in which case the read point no
+    // longer follows it.  Finding an entry with the same control byte rules that out for any
+    // buffer the index describes.
+    entry = mIndex->Find(mReadPoint - elemHeadBytes);
+    if (entry == NULL || mIndex->GetData()[entry->Offset] != mControlByte)
+        return false;
+
+    elemStart = entry->Offset;
+    skipLen = entry->End - (elemStart + elemHeadBytes);
+    if (skipLen > (uint32_t) (mBufEnd - mReadPoint) || skipLen > mMaxLen - mLenRead)
+        return false;
+
+    mReadPoint += skipLen;
+    mLenRead += skipLen;
+
+    return true;
+}
+
 WEAVE_ERROR TLVReader::ReadElement()
 {
     WEAVE_ERROR err;
@@ -147,6 +147,7 @@ WEAVE_ERROR TLVUpdater::Init(TLVReader& aReader, uint32_t freeLen)
     mUpdaterReader.mElemTag = AnonymousTag;
     mUpdaterReader.mElemLenOrVal = 0;
     mUpdaterReader.mContainerType = aReader.mContainerType;
+    mUpdaterReader.mIndex = NULL;
     mUpdaterReader.SetContainerOpen(false);
 
     mUpdaterReader.ImplicitProfileId = aReader.ImplicitProfileId;
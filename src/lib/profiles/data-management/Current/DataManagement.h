@@ -74,7 +74,9 @@
 #include <Weave/Profiles/data-management/EventLoggingTypes.h>
 #include <Weave/Profiles/data-management/LoggingConfiguration.h>
 #include <Weave/Profiles/data-management/EventProcessor.h>
+#include <Weave/Profiles/data-management/EventStreamCompression.h>
 #include <Weave/Profiles/data-management/LogBDXUpload.h>
+#include <Weave/Profiles/data-management/MappedFileEventLog.h>
 
 #include <SystemLayer/SystemStats.h>
 
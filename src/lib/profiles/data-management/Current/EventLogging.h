@@ -209,6 +209,44 @@ event_id_t LogEvent(const EventSchema & inSchema, EventWriterFunct inEventWriter
  */
 event_id_t LogEvent(const EventSchema & inSchema, EventWriterFunct inEventWriter, void * inAppData, const EventOptions * inOptions);
 
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+/**
+ * @brief
+ *   Stage an event via a callback, with options, from an application
+ *   thread.
+ *
+ * The function behaves like LogEvent, except that the calling thread
+ * does not contend for the event log with other threads.  The event
+ * data is serialized into the staging ring owned by the calling
+ * thread; the event is written into the event log, and given its
+ * event ID, when the Weave thread merges the staged events.  An event
+ * that is not timestamped by the caller is timestamped at the point
+ * of the call.
+ *
+ * @param[in] inRing       The staging ring owned by the calling
+ *                         thread; must be less than
+ *                         #WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS.
+ *
+ * @param[in] inSchema     Schema defining importance, profile ID, and
+ *                         structure type of this event.
+ *
+ * @param[in] inEventWriter The callback to invoke to actually
+ *                         serialize the event data
+ *
+ * @param[in] inAppData    Application context for the callback.
+ *
+ * @param[in] inOptions    The options for the event metadata. May be NULL.
+ *
+ * @retval #WEAVE_NO_ERROR        The event was staged, or dropped
+ *                                because of its importance.
+ * @retval #WEAVE_ERROR_NO_MEMORY The ring is full; the event was not
+ *                                staged.
+ * @retval other                  The event could not be staged.
+ */
+WEAVE_ERROR StageEvent(size_t inRing, const EventSchema & inSchema, EventWriterFunct inEventWriter, void * inAppData,
+                       const EventOptions * inOptions);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+
 /**
  * @brief
  *   LogFreeform emits a freeform string to the default event stream.
@@ -0,0 +1,345 @@
+/*
+ *
+ *    Copyright (c) 2016-2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief
+ *   Implementation of the streaming compression of encoded events.
+ *
+ */
+
+#include <Weave/Profiles/data-management/Current/WdmManagedNamespace.h>
+#include <Weave/Profiles/data-management/DataManagement.h>
+
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+
+#include <string.h>
+
+namespace nl {
+namespace Weave {
+namespace Profiles {
+namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current) {
+
+// Version kEventStreamDictionaryVersion of the dictionary: TLV fragments
+// of the event envelope and of common event data.  Changing it requires
+// a new dictionary version.
+static const uint8_t sEventStreamDictionary[] = {
+    // Debug string log entry
+    0x26, 0x0f, 0x10, 0x00, 0x5a, 0x23, 0x24, 0x11, 0x01, 0x35, 0x32, 0x2c, 0x01, 0x00, 0x2c, 0x02,
+    // Trait instance, event type and event data
+    0x24, 0x10, 0x00, 0x24, 0x11, 0x01, 0x35, 0x32, 0x20, 0x01, 0x25, 0x11, 0x35, 0x32, 0x24, 0x01,
+    // First event of each importance: importance, event ID and UTC timestamp
+    0x15, 0x24, 0x02, 0x01, 0x24, 0x03, 0x00, 0x27, 0x0c, 0x15, 0x24, 0x02, 0x03, 0x24, 0x03, 0x00,
+    0x27, 0x0d, 0x15, 0x24, 0x02, 0x04, 0x25, 0x03, 0x26, 0x03, 0x27, 0x0e, 0x26, 0x0f,
+    // Later events: importance and deltas of the timestamps
+    0x18, 0x18, 0x15, 0x24, 0x02, 0x03, 0x21, 0x1e, 0x22, 0x1e, 0x20, 0x1f, 0x21, 0x1f, 0x25, 0x0f,
+    0x18, 0x18, 0x15, 0x24, 0x02, 0x01, 0x20, 0x1e, 0x00, 0x24, 0x0f, 0x18, 0x18, 0x15, 0x24, 0x02,
+    0x02, 0x20, 0x1e, 0x00, 0x26, 0x0f,
+};
+
+enum
+{
+    kHashBits = 10,
+
+    kLiteralRunFlag   = 0x00,
+    kMatchFlag        = 0x80,
+    kMatchLengthShift = 2,
+    kMatchLengthMask  = 0x1F,
+    kMatchOffsetMask  = 0x03,
+};
+
+static inline uint32_t Hash(const uint8_t * inData)
+{
+    const uint32_t value = (static_cast<uint32_t>(inData[0]) << 16) | (static_cast<uint32_t>(inData[1]) << 8) | inData[2];
+
+    return (value * 2654435761U) >> (32 - kHashBits);
+}
+
+static size_t EmitLiterals(const uint8_t * inData, size_t inLength, uint8_t * outBuf)
+{
+    size_t written = 0;
+
+    while (inLength > 0)
+    {
+        const size_t run = (inLength < kEventStreamMaxLiteralRun) ? inLength : kEventStreamMaxLiteralRun;
+
+        outBuf[written++] = kLiteralRunFlag | static_cast<uint8_t>(run - 1);
+        memcpy(outBuf + written, inData, run);
+        written += run;
+        inData += run;
+        inLength -= run;
+    }
+
+    return written;
+}
+
+/**
+ * @brief
+ *   Start a new stream.
+ */
+void EventStreamCompressor::Reset(void)
+{
+    memset(mHashTable, 0, sizeof(mHashTable));
+    memcpy(mHistory, sEventStreamDictionary, sizeof(sEventStreamDictionary));
+    mHistoryLength = sizeof(sEventStreamDictionary);
+
+    for (size_t i = 0; i + kEventStreamMinMatchLength <= mHistoryLength; i++)
+    {
+        Insert(i);
+    }
+}
+
+/**
+ * @brief
+ *   Compress the next chunk of the stream.
+ *
+ * @param[in]  inData       The data to compress.
+ * @param[in]  inDataLength The length of the data.
+ * @param[out] outBuf       The buffer to write the compressed data to.
+ * @param[in]  inBufSize    The size of the buffer; must be at least
+ *                          GetMaxCompressedLength(inDataLength).
+ * @param[out] outLength    The length of the compressed data.
+ *
+ * @retval #WEAVE_NO_ERROR               On success.
+ * @retval #WEAVE_ERROR_BUFFER_TOO_SMALL The buffer is too small.
+ */
+WEAVE_ERROR EventStreamCompressor::Compress(const uint8_t * inData, size_t inDataLength, uint8_t * outBuf, size_t inBufSize,
+                                           size_t & outLength)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    outLength = 0;
+
+    VerifyOrExit(inBufSize >= GetMaxCompressedLength(inDataLength), err = WEAVE_ERROR_BUFFER_TOO_SMALL);
+
+    while (inDataLength > 0)
+    {
+        const size_t chunkLength = (inDataLength < kEventStreamWindowSize) ? inDataLength : kEventStreamWindowSize;
+        size_t pos, end, literalStart;
+
+        if (mHistoryLength + chunkLength > sizeof(mHistory))
+        {
+            Slide();
+        }
+
+        memcpy(mHistory + mHistoryLength, inData, chunkLength);
+        pos = literalStart = mHistoryLength;
+        end                = mHistoryLength + chunkLength;
+
+        while (pos < end)
+        {
+            size_t matchLength = 0;
+            size_t matchOffset = 0;
+
+            if (pos + kEventStreamMinMatchLength <= end)
+            {
+                const size_t candidate = mHashTable[Hash(mHistory + pos)];
+
+                Insert(pos);
+
+                if (candidate != 0 && pos - (candidate - 1) <= kEventStreamWindowSize)
+                {
+                    const size_t maxLength = (end - pos < kEventStreamMaxMatchLength) ? end - pos : kEventStreamMaxMatchLength;
+
+                    matchOffset = pos - (candidate - 1);
+                    while (matchLength < maxLength && mHistory[pos - matchOffset + matchLength] == mHistory[pos + matchLength])
+                    {
+                        matchLength++;
+                    }
+                }
+            }
+
+            if (matchLength < kEventStreamMinMatchLength)
+            {
+                pos++;
+                continue;
+            }
+
+            outLength += EmitLiterals(mHistory + literalStart, pos - literalStart, outBuf + outLength);
+
+            if (matchLength - kEventStreamMinMatchLength < kMatchLengthMask)
+            {
+                outBuf[outLength++] = kMatchFlag | ((matchLength - kEventStreamMinMatchLength) << kMatchLengthShift) |
+                    ((matchOffset - 1) >> 8);
+                outBuf[outLength++] = (matchOffset - 1) & 0xFF;
+            }
+            else
+            {
+                outBuf[outLength++] = kMatchFlag | (kMatchLengthMask << kMatchLengthShift) | ((matchOffset - 1) >> 8);
+                outBuf[outLength++] = (matchOffset - 1) & 0xFF;
+                outBuf[outLength++] = matchLength - kEventStreamMinMatchLength - kMatchLengthMask;
+            }
+
+            for (size_t i = pos + 1; i < pos + matchLength && i + kEventStreamMinMatchLength <= end; i++)
+            {
+                Insert(i);
+            }
+
+            pos += matchLength;
+            literalStart = pos;
+        }
+
+        outLength += EmitLiterals(mHistory + literalStart, end - literalStart, outBuf + outLength);
+
+        mHistoryLength = end;
+        inData += chunkLength;
+        inDataLength -= chunkLength;
+    }
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   The largest size that a chunk of data can compress to.
+ *
+ * Literals cost one byte in kEventStreamMaxLiteralRun, and each match
+ * saves at least the byte of the literal run it interrupts.
+ */
+size_t EventStreamCompressor::GetMaxCompressedLength(size_t inDataLength)
+{
+    return inDataLength + (inDataLength + kEventStreamMaxLiteralRun - 1) / kEventStreamMaxLiteralRun;
+}
+
+/**
+ * @brief
+ *   The largest chunk of data that is sure to compress into a buffer of
+ *   the given size.
+ */
+size_t EventStreamCompressor::GetMaxDataLength(size_t inBufSize)
+{
+    return inBufSize - (inBufSize + kEventStreamMaxLiteralRun) / (kEventStreamMaxLiteralRun + 1);
+}
+
+// Keep the last window of the stream, to make room for the next chunk.
+void EventStreamCompressor::Slide(void)
+{
+    const size_t shift = mHistoryLength - kEventStreamWindowSize;
+
+    memmove(mHistory, mHistory + shift, kEventStreamWindowSize);
+    mHistoryLength = kEventStreamWindowSize;
+
+    for (size_t i = 0; i < kHashTableSize; i++)
+    {
+        mHashTable[i] = (mHashTable[i] > shift) ? mHashTable[i] - shift : 0;
+    }
+}
+
+void EventStreamCompressor::Insert(size_t inPosition)
+{
+    mHashTable[Hash(mHistory + inPosition)] = static_cast<uint16_t>(inPosition + 1);
+}
+
+/**
+ * @brief
+ *   Start a new stream.
+ */
+void EventStreamDecompressor::Reset(void)
+{
+    memcpy(mHistory, sEventStreamDictionary, sizeof(sEventStreamDictionary));
+    mHistoryLength = sizeof(sEventStreamDictionary);
+}
+
+/**
+ * @brief
+ *   Decode the next chunk of the stream, as produced by one call to
+ *   EventStreamCompressor::Compress().
+ *
+ * @param[in]  inData       The compressed data.
+ * @param[in]  inDataLength The length of the compressed data.
+ * @param[out] outBuf       The buffer to write the decoded data to.
+ * @param[in]  inBufSize    The size of the buffer.
+ * @param[out] outLength    The length of the decoded data.
+ *
+ * @retval #WEAVE_NO_ERROR               On success.
+ * @retval #WEAVE_ERROR_BUFFER_TOO_SMALL The buffer is too small.
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT The data is not a valid chunk of
+ *                                       the stream.
+ */
+WEAVE_ERROR EventStreamDecompressor::Decompress(const uint8_t * inData, size_t inDataLength, uint8_t * outBuf, size_t inBufSize,
+                                               size_t & outLength)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    size_t i        = 0;
+
+    outLength = 0;
+
+    while (i < inDataLength)
+    {
+        const uint8_t control = inData[i++];
+        size_t length;
+        size_t offset = 0;
+
+        if ((control & kMatchFlag) == 0)
+        {
+            length = control + 1;
+            VerifyOrExit(i + length <= inDataLength, err = WEAVE_ERROR_INVALID_ARGUMENT);
+        }
+        else
+        {
+            VerifyOrExit(i < inDataLength, err = WEAVE_ERROR_INVALID_ARGUMENT);
+            offset = (((control & kMatchOffsetMask) << 8) | inData[i++]) + 1;
+            VerifyOrExit(offset <= mHistoryLength, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+            length = ((control >> kMatchLengthShift) & kMatchLengthMask) + kEventStreamMinMatchLength;
+            if (((control >> kMatchLengthShift) & kMatchLengthMask) == kMatchLengthMask)
+            {
+                VerifyOrExit(i < inDataLength, err = WEAVE_ERROR_INVALID_ARGUMENT);
+                length += inData[i++];
+            }
+        }
+
+        VerifyOrExit(outLength + length <= inBufSize, err = WEAVE_ERROR_BUFFER_TOO_SMALL);
+
+        if (mHistoryLength + length > sizeof(mHistory))
+        {
+            memmove(mHistory, mHistory + mHistoryLength - kEventStreamWindowSize, kEventStreamWindowSize);
+            mHistoryLength = kEventStreamWindowSize;
+        }
+
+        if ((control & kMatchFlag) == 0)
+        {
+            memcpy(mHistory + mHistoryLength, inData + i, length);
+            i += length;
+        }
+        else
+        {
+            // The match may overlap the bytes it produces.
+            for (size_t j = 0; j < length; j++)
+            {
+                mHistory[mHistoryLength + j] = mHistory[mHistoryLength - offset + j];
+            }
+        }
+
+        memcpy(outBuf + outLength, mHistory + mHistoryLength, length);
+        mHistoryLength += length;
+        outLength += length;
+    }
+
+exit:
+    return err;
+}
+
+} // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
+} // namespace Profiles
+} // namespace Weave
+} // namespace nl
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
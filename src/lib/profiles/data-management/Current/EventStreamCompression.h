@@ -0,0 +1,126 @@
+/*
+ *
+ *    Copyright (c) 2016-2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief
+ *   Streaming compression of encoded events, for log upload.
+ *
+ */
+#ifndef _WEAVE_DATA_MANAGEMENT_EVENT_STREAM_COMPRESSION_CURRENT_H
+#define _WEAVE_DATA_MANAGEMENT_EVENT_STREAM_COMPRESSION_CURRENT_H
+
+#include <Weave/Profiles/data-management/Current/WdmManagedNamespace.h>
+#include <Weave/Core/WeaveCore.h>
+
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+
+namespace nl {
+namespace Weave {
+namespace Profiles {
+namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current) {
+
+/**
+ * @brief
+ *   Constants of the event stream encoding.
+ *
+ * The stream is a sequence of tokens, each of which starts with a
+ * control byte:
+ *
+ *   - `0LLLLLLL`: a run of `L + 1` literal bytes follows.
+ *   - `1LLLLLOO OOOOOOOO`: copy `L + 3` bytes from `O + 1` bytes back in
+ *     the decoded stream.  When `L` is 31, a further byte is added to
+ *     the length.
+ *
+ * Matches reach back at most kEventStreamWindowSize bytes.  Before the
+ * first token, the decoded stream is primed with a dictionary of the
+ * TLV that recurs in encoded events, which is shared by the sender
+ * and the receiver.
+ */
+enum
+{
+    kEventStreamWindowSize        = 1024,
+    kEventStreamDictionaryVersion = 1,
+
+    kEventStreamMinMatchLength = 3,
+    kEventStreamMaxMatchLength = kEventStreamMinMatchLength + 31 + 255,
+    kEventStreamMaxLiteralRun  = 128,
+};
+
+/**
+ * @class EventStreamCompressor
+ *
+ * @brief
+ *   Compresses a stream of encoded events, one chunk at a time.
+ *
+ * Each chunk is compressed into whole tokens, so that the receiver can
+ * decode each chunk as it arrives, but matches may refer back to
+ * earlier chunks of the stream.
+ */
+class NL_DLL_EXPORT EventStreamCompressor
+{
+public:
+    void Reset(void);
+
+    WEAVE_ERROR Compress(const uint8_t * inData, size_t inDataLength, uint8_t * outBuf, size_t inBufSize, size_t & outLength);
+
+    static size_t GetMaxCompressedLength(size_t inDataLength);
+    static size_t GetMaxDataLength(size_t inBufSize);
+
+private:
+    enum
+    {
+        kHashTableSize = 1024,
+    };
+
+    void Slide(void);
+    void Insert(size_t inPosition);
+
+    uint8_t mHistory[2 * kEventStreamWindowSize];
+    uint16_t mHashTable[kHashTableSize]; //< Position + 1 of the last occurrence of each hash, or 0
+    size_t mHistoryLength;
+};
+
+/**
+ * @class EventStreamDecompressor
+ *
+ * @brief
+ *   Decodes a stream produced by EventStreamCompressor, one chunk at a
+ *   time.
+ */
+class NL_DLL_EXPORT EventStreamDecompressor
+{
+public:
+    void Reset(void);
+
+    WEAVE_ERROR Decompress(const uint8_t * inData, size_t inDataLength, uint8_t * outBuf, size_t inBufSize, size_t & outLength);
+
+private:
+    uint8_t mHistory[2 * kEventStreamWindowSize];
+    size_t mHistoryLength;
+};
+
+} // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
+} // namespace Profiles
+} // namespace Weave
+} // namespace nl
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+
+#endif // _WEAVE_DATA_MANAGEMENT_EVENT_STREAM_COMPRESSION_CURRENT_H
@@ -39,6 +39,9 @@ WEAVE_ERROR BdxSendAcceptHandler(nl::Weave::Profiles::BulkDataTransfer::BDXTrans
     WEAVE_ERROR error = WEAVE_NO_ERROR;
     WeaveLogDetail(BDX, "SendInit Accepted: %hd maxBlockSize, transfer mode is %hd", aSendAcceptMsg->mMaxBlockSize,
                    aXfer->mTransferMode);
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    error = static_cast<LogBDXUpload *>(aXfer->mAppState)->HandleSendAccept(aSendAcceptMsg);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
     return error;
 }
 
@@ -91,8 +94,22 @@ void LogBDXUpload::BlockHandler(nl::Weave::Profiles::BulkDataTransfer::BDXTransf
     WEAVE_ERROR err = WEAVE_NO_ERROR;
     TLVWriter writer;
     bool fullBlock = true;
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    const size_t blockLength = *aLength;
+    size_t compressedLength  = 0;
 
-    writer.Init(*aDataBlock, *aLength);
+    if (mCompressing)
+    {
+        // Events are fetched into the raw block, then compressed into the data block.
+        const size_t rawLength = EventStreamCompressor::GetMaxDataLength(blockLength);
+
+        writer.Init(mRawBlock, (rawLength < sizeof(mRawBlock)) ? rawLength : sizeof(mRawBlock));
+    }
+    else
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    {
+        writer.Init(*aDataBlock, *aLength);
+    }
 
     // If successful, these values will be reset below.  If the
     // function fails, these will be the return values.
@@ -108,6 +125,27 @@ void LogBDXUpload::BlockHandler(nl::Weave::Profiles::BulkDataTransfer::BDXTransf
 
         err = mLogger->FetchEventsSince(writer, mCurrentImportance, mCurrentEventID);
 
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+        if (mCompressing &&
+            ((err == WEAVE_END_OF_TLV) || (err == WEAVE_ERROR_TLV_UNDERRUN) || (err == WEAVE_ERROR_BUFFER_TOO_SMALL) ||
+             (err == WEAVE_ERROR_NO_MEMORY)))
+        {
+            const bool fetchedEvents = (writer.GetLengthWritten() > 0);
+            WEAVE_ERROR compressErr  = CompressFetchedEvents(writer, *aDataBlock, blockLength, compressedLength);
+
+            VerifyOrExit(compressErr == WEAVE_NO_ERROR, err = compressErr);
+
+            // Once compressed, the events took less room than the
+            // raw block allowed for; fetch more into what is left.
+            if (((err == WEAVE_ERROR_BUFFER_TOO_SMALL) || (err == WEAVE_ERROR_NO_MEMORY)) && fetchedEvents)
+            {
+                err       = WEAVE_NO_ERROR;
+                fullBlock = false;
+                continue;
+            }
+        }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+
         // Reached the end of the current importance
         if ((err == WEAVE_END_OF_TLV) || (err == WEAVE_ERROR_TLV_UNDERRUN))
         {
@@ -151,11 +189,136 @@ void LogBDXUpload::BlockHandler(nl::Weave::Profiles::BulkDataTransfer::BDXTransf
 
     SuccessOrExit(err);
     // on success, the aLastBlock is already set.
-    *aLength = writer.GetLengthWritten();
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    if (mCompressing)
+    {
+        *aLength = compressedLength;
+    }
+    else
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    {
+        *aLength = writer.GetLengthWritten();
+    }
 exit:
     return;
 }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+// Compress the events fetched into the raw block onto the end of the
+// data block, and make room in the raw block for as many events as
+// are sure to fit in the rest of the data block.
+WEAVE_ERROR LogBDXUpload::CompressFetchedEvents(TLVWriter & aWriter, uint8_t * aDataBlock, size_t aBlockLength,
+                                                size_t & aCompressedLength)
+{
+    WEAVE_ERROR err;
+    size_t length;
+    size_t rawLength;
+
+    err = mCompressor.Compress(mRawBlock, aWriter.GetLengthWritten(), aDataBlock + aCompressedLength,
+                               aBlockLength - aCompressedLength, length);
+    SuccessOrExit(err);
+
+    aCompressedLength += length;
+
+    rawLength = EventStreamCompressor::GetMaxDataLength(aBlockLength - aCompressedLength);
+    aWriter.Init(mRawBlock, (rawLength < sizeof(mRawBlock)) ? rawLength : sizeof(mRawBlock));
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   Pick up the encoding of the events chosen by the receiver.
+ *
+ * @retval #WEAVE_NO_ERROR               On success.
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT The receiver chose an encoding
+ *                                       that was not offered.
+ * @retval other                         The metadata could not be parsed.
+ */
+WEAVE_ERROR LogBDXUpload::HandleSendAccept(nl::Weave::Profiles::BulkDataTransfer::SendAccept * aSendAcceptMsg)
+{
+    WEAVE_ERROR err  = WEAVE_NO_ERROR;
+    uint8_t encoding = kUploadEncoding_RawTLV;
+    TLVReader reader;
+    TLVType container;
+
+    mCompressing = false;
+
+    if (aSendAcceptMsg->mMetaData.theLength > 0)
+    {
+        reader.Init(aSendAcceptMsg->mMetaData.theData, aSendAcceptMsg->mMetaData.theLength);
+
+        err = reader.Next(kTLVType_Structure, AnonymousTag);
+        SuccessOrExit(err);
+
+        err = reader.EnterContainer(container);
+        SuccessOrExit(err);
+
+        while ((err = reader.Next()) == WEAVE_NO_ERROR)
+        {
+            if (reader.GetTag() == ContextTag(kTag_UploadEncoding))
+            {
+                err = reader.Get(encoding);
+                SuccessOrExit(err);
+            }
+        }
+
+        VerifyOrExit(err == WEAVE_END_OF_TLV, /* no-op */);
+        err = WEAVE_NO_ERROR;
+    }
+
+    VerifyOrExit(encoding == kUploadEncoding_RawTLV || encoding == kUploadEncoding_EventStreamV1,
+                 err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    if (encoding == kUploadEncoding_EventStreamV1)
+    {
+        mCompressor.Reset();
+        mCompressing = true;
+    }
+
+exit:
+    return err;
+}
+
+// Offer to compress the events, falling back to raw TLV.
+WEAVE_ERROR LogBDXUpload::WriteSendInitMetaData(uint8_t * aBuffer, uint16_t aBufferLength, uint16_t & aNumBytesWritten,
+                                                void * aAppState)
+{
+    WEAVE_ERROR err;
+    TLVWriter writer;
+    TLVType container, encodings;
+
+    writer.Init(aBuffer, aBufferLength);
+
+    err = writer.StartContainer(AnonymousTag, kTLVType_Structure, container);
+    SuccessOrExit(err);
+
+    err = writer.StartContainer(ContextTag(kTag_UploadEncodings), kTLVType_Array, encodings);
+    SuccessOrExit(err);
+
+    err = writer.Put(AnonymousTag, static_cast<uint8_t>(kUploadEncoding_EventStreamV1));
+    SuccessOrExit(err);
+
+    err = writer.Put(AnonymousTag, static_cast<uint8_t>(kUploadEncoding_RawTLV));
+    SuccessOrExit(err);
+
+    err = writer.EndContainer(encodings);
+    SuccessOrExit(err);
+
+    err = writer.EndContainer(container);
+    SuccessOrExit(err);
+
+    err = writer.Finalize();
+    SuccessOrExit(err);
+
+    aNumBytesWritten = writer.GetLengthWritten();
+
+exit:
+    return err;
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+
 void BdxXferErrorHandler(nl::Weave::Profiles::BulkDataTransfer::BDXTransfer * aXfer,
                          nl::Weave::Profiles::StatusReporting::StatusReport * aXferError)
 {
@@ -205,7 +368,10 @@ WEAVE_ERROR LogBDXUpload::Init(LoggingManagement * inLogger)
     memset(mLastScheduledEventId, 0, sizeof(mLastScheduledEventId));
     memset(mLastTransmittedEventId, 0, sizeof(mLastTransmittedEventId));
     mLogger = inLogger;
-    err     = mBdxNode.Init(mLogger->mExchangeMgr);
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    mCompressing = false;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    err = mBdxNode.Init(mLogger->mExchangeMgr);
     SuccessOrExit(err);
 
     mState = UploaderInitialized;
@@ -246,12 +412,17 @@ WEAVE_ERROR LogBDXUpload::StartUpload(nl::Weave::Binding * aBinding)
     SuccessOrExit(err);
 
     mState              = UploaderInProgress;
-    xfer->mMaxBlockSize = 1024;
+    xfer->mMaxBlockSize = kMaxBlockSize;
     xfer->mStartOffset  = 0;
     xfer->mLength       = 0;
 
     // start transfer
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    mCompressing = false;
+    err          = mBdxNode.InitBdxSend(*xfer, true, false, false, WriteSendInitMetaData, this);
+#else
     err = mBdxNode.InitBdxSend(*xfer, true, false, false, NULL);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
 
     if (err != WEAVE_NO_ERROR)
     {
@@ -20,6 +20,7 @@
 
 #include <Weave/Profiles/data-management/Current/WdmManagedNamespace.h>
 #include <Weave/Profiles/data-management/DataManagement.h>
+#include <Weave/Profiles/data-management/EventStreamCompression.h>
 
 #include <Weave/Profiles/bulk-data-transfer/Development/BDXManagedNamespace.hpp>
 #include <Weave/Profiles/bulk-data-transfer/Development/BulkDataTransfer.h>
@@ -31,6 +32,25 @@ namespace Weave {
 namespace Profiles {
 namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current) {
 
+/**
+ * Tags for the metadata of the SendInit and SendAccept messages of a
+ * log upload.
+ */
+enum
+{
+    kTag_UploadEncodings = 1, //< In SendInit, an array of the encodings the uploader supports, most preferred first
+    kTag_UploadEncoding  = 2, //< In SendAccept, the encoding chosen by the receiver.  If omitted, the events are sent as raw TLV.
+};
+
+/**
+ * Encodings of the events sent by a log upload.
+ */
+enum
+{
+    kUploadEncoding_RawTLV        = 0,
+    kUploadEncoding_EventStreamV1 = 1, //< EventStreamCompressor, with version 1 of the dictionary
+};
+
 WEAVE_ERROR BdxSendAcceptHandler(nl::Weave::Profiles::BulkDataTransfer::BDXTransfer * aXfer,
                                  nl::Weave::Profiles::BulkDataTransfer::SendAccept * aSendAcceptMsg);
 void BdxRejectHandler(nl::Weave::Profiles::BulkDataTransfer::BDXTransfer * aXfer,
@@ -62,6 +82,10 @@ public:
     void BlockHandler(nl::Weave::Profiles::BulkDataTransfer::BDXTransfer * aXfer, uint64_t * aLength, uint8_t ** aDataBlock,
                       bool * aIsLastBlock);
 
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    WEAVE_ERROR HandleSendAccept(nl::Weave::Profiles::BulkDataTransfer::SendAccept * aSendAcceptMsg);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+
     void Abort(void);
     void Done(void);
     void Shutdown(void);
@@ -71,8 +95,20 @@ public:
     UploaderState mState;
 
 private:
+    enum
+    {
+        kMaxBlockSize = 1024,
+    };
+
     void ThrottleIfNeeded(void);
 
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    static WEAVE_ERROR WriteSendInitMetaData(uint8_t * aBuffer, uint16_t aBufferLength, uint16_t & aNumBytesWritten,
+                                             void * aAppState);
+    WEAVE_ERROR CompressFetchedEvents(TLV::TLVWriter & aWriter, uint8_t * aDataBlock, size_t aBlockLength,
+                                      size_t & aCompressedLength);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+
     LoggingManagement * mLogger;
     nl::Weave::Profiles::BulkDataTransfer::BdxNode mBdxNode;
     ImportanceType mCurrentImportance;
@@ -82,6 +118,11 @@ private:
     uint32_t mUploadPosition;
     bool mThrottled;
     bool mFirstXfer;
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    bool mCompressing;
+    EventStreamCompressor mCompressor;
+    uint8_t mRawBlock[kMaxBlockSize];
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
 };
 
 } // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
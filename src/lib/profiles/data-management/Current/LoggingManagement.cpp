@@ -22,6 +22,7 @@
 
 // it is important for this first inclusion of inttypes.h to have all the right switches turned ON
 #include <inttypes.h>
+#include <string.h>
 
 #define WEAVE_CONFIG_BDX_NAMESPACE kWeaveManagedNamespace_Development
 
@@ -76,39 +77,6 @@ WEAVE_ERROR LoggingManagement::AlwaysFail(nl::Weave::TLV::WeaveCircularTLVBuffer
     return WEAVE_ERROR_NO_MEMORY;
 }
 
-WEAVE_ERROR LoggingManagement::CopyToNextBuffer(CircularEventBuffer * inEventBuffer)
-{
-    CircularTLVWriter writer;
-    CircularTLVReader reader;
-    WeaveCircularTLVBuffer checkpoint   = inEventBuffer->mNext->mBuffer;
-    WeaveCircularTLVBuffer * nextBuffer = &(inEventBuffer->mNext->mBuffer);
-    WEAVE_ERROR err;
-
-    // Set up the next buffer s.t. it fails if needs to evict an element
-    nextBuffer->mProcessEvictedElement = AlwaysFail;
-
-    writer.Init(nextBuffer);
-
-    // Set up the reader s.t. it is positioned to read the head event
-    reader.Init(&(inEventBuffer->mBuffer));
-
-    err = reader.Next();
-    SuccessOrExit(err);
-
-    err = writer.CopyElement(reader);
-    SuccessOrExit(err);
-
-    err = writer.Finalize();
-    SuccessOrExit(err);
-
-exit:
-    if (err != WEAVE_NO_ERROR)
-    {
-        inEventBuffer->mNext->mBuffer = checkpoint;
-    }
-    return err;
-}
-
 WEAVE_ERROR LoggingManagement::EnsureSpace(size_t inRequiredSpace)
 {
     WEAVE_ERROR err                   = WEAVE_NO_ERROR;
@@ -135,36 +103,23 @@ WEAVE_ERROR LoggingManagement::EnsureSpace(size_t inRequiredSpace)
             circularBuffer->mAppData               = &ctx;
             err                                    = circularBuffer->EvictHead();
 
-            // one of two things happened: either the element was evicted,
-            // or we figured out how much space we need to evict it into
-            // the next buffer
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+            if (err == WEAVE_NO_ERROR)
+            {
+                // record the eviction before the space it frees up is reused
+                CommitMappedFile();
+            }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+            // one of two things happened: either the element was evicted
+            // (dropped, or moved to the next buffer as it is), or we
+            // figured out how much space we need to move it into the
+            // next buffer
 
             if (err != WEAVE_NO_ERROR)
             {
                 VerifyOrExit(ctx.mSpaceNeededForEvent != 0, /* no-op, return err */);
-                if (ctx.mSpaceNeededForEvent <= eventBuffer->mNext->mBuffer.AvailableDataLength())
-                {
-                    // we can copy the event outright.  copy event and
-                    // subsequently evict head s.t. evicting the head
-                    // element always succeeds.
-                    // Since we're calling CopyElement and we've checked
-                    // that there is space in the next buffer, we don't expect
-                    // this to fail.
-                    err = CopyToNextBuffer(eventBuffer);
-                    SuccessOrExit(err);
-
-                    // success; evict head unconditionally
-                    circularBuffer->mProcessEvictedElement = NULL;
-                    err                                    = circularBuffer->EvictHead();
-                    // if unconditional eviction failed, this
-                    // means that we have no way of further
-                    // clearing the buffer.  fail out and let the
-                    // caller know that we could not honor the
-                    // request
-                    SuccessOrExit(err);
-                    continue;
-                }
-                // we cannot copy event outright. We remember the
+                // we cannot move the event outright. We remember the
                 // current required space in mAppData, we note the
                 // space requirements for the event in the current
                 // buffer and make that space in the next buffer.
@@ -435,6 +390,9 @@ void LoggingManagement::DestroyLoggingManagement(void)
     Platform::CriticalSectionEnter();
     sInstance.mState       = kLoggingManagementState_Shutdown;
     sInstance.mEventBuffer = NULL;
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    sInstance.mMappedFile = NULL;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
     Platform::CriticalSectionExit();
 }
 
@@ -524,6 +482,12 @@ LoggingManagement::LoggingManagement(WeaveExchangeManager * inMgr, size_t inNumB
     mBytesWritten        = 0;
     mUploadRequested     = false;
     mMaxImportanceBuffer = static_cast<ImportanceType>(inNumBuffers);
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+    mMergeRequested = false;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    mMappedFile = NULL;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
 }
 
 /**
@@ -578,6 +542,12 @@ LoggingManagement::LoggingManagement(WeaveExchangeManager * inMgr, size_t inNumB
     mBytesWritten        = 0;
     mUploadRequested     = false;
     mMaxImportanceBuffer = static_cast<ImportanceType>(inNumBuffers);
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+    mMergeRequested = false;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    mMappedFile = NULL;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
 }
 /**
  * @brief
@@ -589,6 +559,12 @@ LoggingManagement::LoggingManagement(WeaveExchangeManager * inMgr, size_t inNumB
 LoggingManagement::LoggingManagement(void) :
     mEventBuffer(NULL), mExchangeMgr(NULL), mState(kLoggingManagementState_Idle), mBDXUploader(NULL), mBytesWritten(0),
     mThrottled(0), mMaxImportanceBuffer(kImportanceType_Invalid), mUploadRequested(false)
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+    , mMergeRequested(false)
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    , mMappedFile(NULL)
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
 { }
 
 /**
@@ -742,7 +718,15 @@ CircularEventBuffer * LoggingManagement::GetImportanceBuffer(ImportanceType inIm
 WEAVE_ERROR LoggingManagement::RegisterEventCallbackForImportance(ImportanceType inImportance, FetchExternalEventsFunct inCallback,
                                                                   size_t inNumEvents, ExternalEvents ** aExternalEventsPtr)
 {
-    return GetImportanceBuffer(inImportance)->RegisterExternalEventsCallback(inCallback, NULL, inNumEvents, aExternalEventsPtr);
+    WEAVE_ERROR err = GetImportanceBuffer(inImportance)->RegisterExternalEventsCallback(inCallback, NULL, inNumEvents, aExternalEventsPtr);
+
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    Platform::CriticalSectionEnter();
+    CommitMappedFile();
+    Platform::CriticalSectionExit();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+    return err;
 }
 
 /**
@@ -794,8 +778,16 @@ WEAVE_ERROR LoggingManagement::RegisterEventCallbackForImportance(ImportanceType
                                                                   NotifyExternalEventsDeliveredFunct inNotifyCallback,
                                                                   size_t inNumEvents, ExternalEvents ** aExternalEventsPtr)
 {
-    return GetImportanceBuffer(inImportance)
+    WEAVE_ERROR err = GetImportanceBuffer(inImportance)
         ->RegisterExternalEventsCallback(inFetchCallback, inNotifyCallback, inNumEvents, aExternalEventsPtr);
+
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    Platform::CriticalSectionEnter();
+    CommitMappedFile();
+    Platform::CriticalSectionExit();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+    return err;
 }
 
 /**
@@ -1095,12 +1087,346 @@ exit:
 #endif // WEAVE_CONFIG_EVENT_LOGGING_VERBOSE_DEBUG_LOGS
         }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+        CommitMappedFile();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
         ScheduleFlushIfNeeded(inOptions == NULL ? false : inOptions->urgent);
     }
 
     return event_id;
 }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+/**
+ * @brief
+ *   Stage an event for logging without entering the critical section.
+ *
+ * The event data is serialized into the given staging ring right
+ * away, together with the event metadata; the event is written into
+ * the event buffers, and given its event ID, when the Weave thread
+ * merges the staged events.  Events from a ring are merged in the
+ * order they were staged.  An event that is not timestamped by the
+ * caller is timestamped at the point of the call.
+ *
+ * Each ring must only be written to by a single thread, which makes
+ * it suitable for application threads that log at high rates.
+ *
+ * @param[in] inRing       The staging ring owned by the calling thread.
+ *
+ * @param[in] inSchema     Schema defining importance, profile ID, and
+ *                         structure type of this event.
+ *
+ * @param[in] inEventWriter The callback to invoke to actually
+ *                         serialize the event data
+ *
+ * @param[in] inAppData    Application context for the callback.
+ *
+ * @param[in] inOptions    The options for the event metadata. May be NULL.
+ *
+ * @retval #WEAVE_NO_ERROR               The event was staged, or dropped
+ *                                       because of its importance.
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT The ring does not exist.
+ * @retval #WEAVE_ERROR_INCORRECT_STATE  The logging subsystem is shut down.
+ * @retval #WEAVE_ERROR_NO_MEMORY        The ring is full.
+ * @retval other                         Errors returned by inEventWriter.
+ */
+WEAVE_ERROR LoggingManagement::StageEvent(size_t inRing, const EventSchema & inSchema, EventWriterFunct inEventWriter,
+                                          void * inAppData, const EventOptions * inOptions)
+{
+    WEAVE_ERROR err   = WEAVE_NO_ERROR;
+    EventOptions opts = (inOptions != NULL) ? *inOptions : EventOptions();
+
+    VerifyOrExit(inRing < WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS, err = WEAVE_ERROR_INVALID_ARGUMENT);
+    VerifyOrExit(mState != kLoggingManagementState_Shutdown, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // check whether the entry is to be logged or discarded silently
+    VerifyOrExit(inSchema.mImportance <= GetCurrentImportance(inSchema.mProfileId), /* no-op */);
+
+    if (opts.timestampType == kTimestampType_Invalid)
+    {
+        opts.timestamp.systemTimestamp = static_cast<timestamp_t>(System::Timer::GetCurrentEpoch());
+        opts.timestampType             = kTimestampType_System;
+    }
+
+    err = mStagingRings[inRing].Stage(inSchema, inEventWriter, inAppData, opts);
+    SuccessOrExit(err);
+
+    if (__sync_bool_compare_and_swap(&mMergeRequested, false, true))
+    {
+        System::Error scheduleErr = WEAVE_SYSTEM_ERROR_UNEXPECTED_STATE;
+
+        if ((mExchangeMgr != NULL) && (mExchangeMgr->MessageLayer != NULL) && (mExchangeMgr->MessageLayer->SystemLayer != NULL))
+        {
+            scheduleErr = mExchangeMgr->MessageLayer->SystemLayer->ScheduleWork(MergeStagedEventsHandler, this);
+        }
+
+        if (scheduleErr != WEAVE_SYSTEM_NO_ERROR)
+        {
+            // The event stays staged until the next StageEvent schedules a merge, or MergeStagedEvents is called.
+            mMergeRequested = false;
+        }
+    }
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   Merge the events staged by application threads into the event
+ *   buffers, assigning their event IDs.
+ *
+ * The events staged in each ring up to the point of the call are
+ * logged in one pass of the critical section.  The function is
+ * scheduled on the Weave thread whenever events are staged; it may
+ * also be called directly, from a single thread at a time.
+ */
+void LoggingManagement::MergeStagedEvents(void)
+{
+    StagedEventHeader header;
+    const uint8_t * data;
+    TLVReader reader;
+
+    mMergeRequested = false;
+    __sync_synchronize();
+
+    Platform::CriticalSectionEnter();
+
+    VerifyOrExit(mState != kLoggingManagementState_Shutdown && mEventBuffer != NULL, /* no-op */);
+
+    for (size_t i = 0; i < WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS; i++)
+    {
+        EventStagingRing & ring = mStagingRings[i];
+        const uint32_t end      = ring.mHead;
+
+        while (ring.Peek(end, header, data))
+        {
+            header.mOptions.eventSource = header.mHasEventSource ? &header.mEventSource : NULL;
+
+            reader.Init(data, header.mDataLength);
+            LogEventPrivate(header.mSchema, CopyStagedEventData, &reader, &header.mOptions);
+
+            ring.Pop(header);
+        }
+    }
+
+exit:
+    Platform::CriticalSectionExit();
+}
+
+void LoggingManagement::MergeStagedEventsHandler(System::Layer * systemLayer, void * appState, INET_ERROR err)
+{
+    LoggingManagement * logger = static_cast<LoggingManagement *>(appState);
+    logger->MergeStagedEvents();
+}
+
+// internal API, used to copy the serialized data of a staged event into the event buffers
+WEAVE_ERROR LoggingManagement::CopyStagedEventData(TLVWriter & ioWriter, uint8_t inDataTag, void * appData)
+{
+    WEAVE_ERROR err    = WEAVE_NO_ERROR;
+    TLVReader * reader = static_cast<TLVReader *>(appData);
+
+    TLVType containerType;
+
+    // LogEventPrivate may retry the copy with more space.
+    TLVReader copy;
+    copy.Init(*reader);
+
+    err = copy.Next();
+    SuccessOrExit(err);
+
+    err = copy.EnterContainer(containerType);
+    SuccessOrExit(err);
+
+    err = copy.Next();
+    SuccessOrExit(err);
+
+    err = ioWriter.CopyElement(ContextTag(kTag_EventData), copy);
+
+exit:
+    return err;
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+/**
+ * @brief
+ *   Keep the event buffers in a memory-mapped file.
+ *
+ * The logging subsystem must have been created with the buffers of
+ * the file.  The events committed to the file before the process last
+ * exited are recovered, with their event IDs and timestamps, and the
+ * state of the buffers is committed to the file each time it changes
+ * from then on.
+ *
+ * Recovering events requires the event ID counters to resume where
+ * they left off: the built-in counters are set from the file, while
+ * counters provided by the application must already have the
+ * committed values.  Externally stored events are not recovered.
+ * When the events cannot be recovered, they are discarded and logging
+ * starts over with empty buffers.
+ *
+ * @param[in] inFile  The open file holding the event buffers.
+ *
+ * @retval #WEAVE_NO_ERROR               On success.
+ * @retval #WEAVE_ERROR_INCORRECT_STATE  The logging subsystem is not
+ *                                       initialized.
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT The logging subsystem does not
+ *                                       use the buffers of the file.
+ */
+WEAVE_ERROR LoggingManagement::AttachMappedFile(MappedFileEventLog & inFile)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    const MappedEventBufferState * state;
+    CircularEventBuffer * buf;
+    size_t i;
+
+    Platform::CriticalSectionEnter();
+
+    VerifyOrExit(mState != kLoggingManagementState_Shutdown && mEventBuffer != NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(inFile.GetNumBuffers() == static_cast<size_t>(mMaxImportanceBuffer) && inFile.GetBuffers()[0] == mEventBuffer,
+                 err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    state = inFile.GetCommittedState();
+    if (state != NULL)
+    {
+        err = RestoreMappedFile(state);
+        if (err != WEAVE_NO_ERROR)
+        {
+            WeaveLogError(EventLogging, "Discarding events in mapped file: %s", ErrorStr(err));
+
+            // Still don't reuse the event IDs of the discarded events.
+            for (buf = mEventBuffer, i = 0; buf != NULL; buf = buf->mNext, i++)
+            {
+                if (buf->mEventIdCounter == &(buf->mNonPersistedCounter))
+                {
+                    buf->mNonPersistedCounter.Init(state[i].mNextEventID);
+                    buf->mFirstEventID = state[i].mNextEventID;
+                    buf->mLastEventID  = state[i].mNextEventID - 1;
+                }
+            }
+
+            err = WEAVE_NO_ERROR;
+        }
+    }
+
+    mMappedFile = &inFile;
+    CommitMappedFile();
+
+exit:
+    Platform::CriticalSectionExit();
+
+    return err;
+}
+
+// internal API: recover the event buffers from the state committed to the mapped file
+WEAVE_ERROR LoggingManagement::RestoreMappedFile(const MappedEventBufferState * inState)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    CircularEventBuffer * buf;
+    size_t i;
+
+    // Check the whole log before using any of it.
+    for (buf = mEventBuffer, i = 0; buf != NULL; buf = buf->mNext, i++)
+    {
+        WeaveCircularTLVBuffer events = buf->mBuffer;
+        CircularTLVReader reader;
+
+        VerifyOrExit((inState[i].mFlags & MappedEventBufferState::kFlag_HasExternalEvents) == 0,
+                     err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+        VerifyOrExit((buf->mEventIdCounter == &(buf->mNonPersistedCounter)) ||
+                         (buf->mEventIdCounter->GetValue() == inState[i].mNextEventID),
+                     err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+
+        err = events.Restore(inState[i].mQueueHead, inState[i].mQueueLength);
+        SuccessOrExit(err);
+
+        // The committed length must cover whole events.
+        reader.Init(&events);
+        while ((err = reader.Next()) == WEAVE_NO_ERROR)
+        {
+        }
+        VerifyOrExit(err == WEAVE_END_OF_TLV && reader.GetLengthRead() == inState[i].mQueueLength,
+                     err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+        err = WEAVE_NO_ERROR;
+    }
+
+    for (buf = mEventBuffer, i = 0; buf != NULL; buf = buf->mNext, i++)
+    {
+        buf->mBuffer.Restore(inState[i].mQueueHead, inState[i].mQueueLength);
+
+        if (buf->mEventIdCounter == &(buf->mNonPersistedCounter))
+        {
+            buf->mNonPersistedCounter.Init(inState[i].mNextEventID);
+        }
+
+        buf->mFirstEventID        = inState[i].mFirstEventID;
+        buf->mLastEventID         = inState[i].mLastEventID;
+        buf->mFirstEventTimestamp = inState[i].mFirstEventTimestamp;
+        buf->mLastEventTimestamp  = inState[i].mLastEventTimestamp;
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+        buf->mFirstEventUTCTimestamp = inState[i].mFirstEventUTCTimestamp;
+        buf->mLastEventUTCTimestamp  = inState[i].mLastEventUTCTimestamp;
+        buf->mUTCInitialized         = (inState[i].mFlags & MappedEventBufferState::kFlag_UTCInitialized) != 0;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    }
+
+exit:
+    return err;
+}
+
+// internal API: commit the state of the event buffers to the mapped file, if any
+void LoggingManagement::CommitMappedFile(void)
+{
+    MappedEventBufferState state[kImportanceType_Last - kImportanceType_First + 1];
+    CircularEventBuffer * buf;
+    size_t i;
+
+    VerifyOrExit(mMappedFile != NULL, /* no-op */);
+
+    memset(state, 0, sizeof(state));
+
+    for (buf = mEventBuffer, i = 0; buf != NULL; buf = buf->mNext, i++)
+    {
+        const uint8_t * data = reinterpret_cast<const uint8_t *>(buf) + sizeof(CircularEventBuffer);
+
+        state[i].mQueueHead           = buf->mBuffer.QueueHead() - data;
+        state[i].mQueueLength         = buf->mBuffer.DataLength();
+        state[i].mFirstEventID        = buf->mFirstEventID;
+        state[i].mLastEventID         = buf->mLastEventID;
+        state[i].mNextEventID         = buf->mEventIdCounter->GetValue();
+        state[i].mFirstEventTimestamp = buf->mFirstEventTimestamp;
+        state[i].mLastEventTimestamp  = buf->mLastEventTimestamp;
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+        state[i].mFirstEventUTCTimestamp = buf->mFirstEventUTCTimestamp;
+        state[i].mLastEventUTCTimestamp  = buf->mLastEventUTCTimestamp;
+        if (buf->mUTCInitialized)
+        {
+            state[i].mFlags |= MappedEventBufferState::kFlag_UTCInitialized;
+        }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_EXTERNAL_CALLBACKS
+        for (int j = 0; j < WEAVE_CONFIG_EVENT_LOGGING_NUM_EXTERNAL_CALLBACKS; j++)
+        {
+            const ExternalEvents & ev = buf->mExternalEventsList[j];
+
+            if ((ev.mFirstEventID <= ev.mLastEventID) && (buf->mFirstEventID <= ev.mFirstEventID))
+            {
+                state[i].mFlags |= MappedEventBufferState::kFlag_HasExternalEvents;
+            }
+        }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_EXTERNAL_CALLBACKS
+    }
+
+    mMappedFile->Commit(state);
+
+exit:
+    return;
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+
 /**
  * @brief
  *   ThrottleLogger elevates the effective logging level to the Production level.
@@ -1468,9 +1794,20 @@ WEAVE_ERROR LoggingManagement::EvictEvent(WeaveCircularTLVBuffer & inBuffer, voi
 #endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
         ctx->mSpaceNeededForEvent = 0;
     }
+    else if (inReader.GetLengthRead() <= eventBuffer->mNext->mBuffer.AvailableDataLength())
+    {
+        // event is moving to the next buffer.  Event data is position
+        // independent, so move its bytes as they are rather than
+        // re-encoding it.
+        err = inBuffer.CopyHead(eventBuffer->mNext->mBuffer, inReader.GetLengthRead());
+        SuccessOrExit(err);
+
+        ctx->mSpaceNeededForEvent = 0;
+    }
     else
     {
-        // event is not getting dropped. Note how much space it requires, and return.
+        // event is not getting dropped, and does not fit in the next
+        // buffer. Note how much space it requires, and return.
         ctx->mSpaceNeededForEvent = inReader.GetLengthRead();
         err                       = WEAVE_END_OF_TLV;
     }
@@ -2041,6 +2378,167 @@ exit:
     return err;
 }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+/**
+ * @brief
+ *   EventStagingRing constructor
+ */
+EventStagingRing::EventStagingRing(void) : mHead(0), mTail(0) { }
+
+/**
+ * @brief
+ *   Stage an event at the head of the ring.  Must only be called by
+ *   the thread that owns the ring.
+ *
+ * The event is placed where it fits in one piece; if it does not fit
+ * at the end of the ring, the rest of the ring is marked unused and
+ * the event is placed at its start.
+ *
+ * @retval #WEAVE_NO_ERROR        On success.
+ * @retval #WEAVE_ERROR_NO_MEMORY The ring does not have enough space
+ *                                for the event.
+ * @retval other                  Errors returned by inEventWriter.
+ */
+WEAVE_ERROR EventStagingRing::Stage(const EventSchema & inSchema, EventWriterFunct inEventWriter, void * inAppData,
+                                    const EventOptions & inOptions)
+{
+    WEAVE_ERROR err;
+    const uint32_t head = mHead;
+    uint32_t available, offset, contiguous, length;
+    const uint32_t unused = 0;
+
+    // Make sure the consumer is done with the space it has freed up before reusing it.
+    available = sizeof(mData) - (head - mTail);
+    __sync_synchronize();
+
+    offset     = head % sizeof(mData);
+    contiguous = sizeof(mData) - offset;
+
+    err = Encode(offset, (contiguous < available) ? contiguous : available, inSchema, inEventWriter, inAppData, inOptions, length);
+
+    if ((err == WEAVE_ERROR_NO_MEMORY || err == WEAVE_ERROR_BUFFER_TOO_SMALL) && (offset != 0) && (available > contiguous))
+    {
+        err = Encode(0, available - contiguous, inSchema, inEventWriter, inAppData, inOptions, length);
+        if (err == WEAVE_NO_ERROR)
+        {
+            memcpy(&mData[offset], &unused, sizeof(unused));
+            length += contiguous;
+        }
+    }
+
+    VerifyOrExit(err != WEAVE_ERROR_BUFFER_TOO_SMALL, err = WEAVE_ERROR_NO_MEMORY);
+    SuccessOrExit(err);
+
+    // Publish the event only once it has been written in full.
+    __sync_synchronize();
+    mHead = head + length;
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR EventStagingRing::Encode(uint32_t inOffset, uint32_t inSpace, const EventSchema & inSchema,
+                                     EventWriterFunct inEventWriter, void * inAppData, const EventOptions & inOptions,
+                                     uint32_t & outLength)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    StagedEventHeader header;
+    TLVWriter writer;
+    TLVType containerType;
+
+    VerifyOrExit(inSpace > sizeof(header), err = WEAVE_ERROR_NO_MEMORY);
+
+    writer.Init(&mData[inOffset + sizeof(header)], inSpace - sizeof(header));
+
+    // The event data is context tagged, so it is staged inside an anonymous structure.
+    err = writer.StartContainer(AnonymousTag, kTLVType_Structure, containerType);
+    SuccessOrExit(err);
+
+    err = inEventWriter(writer, kTag_EventData, inAppData);
+    SuccessOrExit(err);
+
+    err = writer.EndContainer(containerType);
+    SuccessOrExit(err);
+
+    err = writer.Finalize();
+    SuccessOrExit(err);
+
+    // Keep event headers aligned on 4-byte boundaries, so that the unused end of the ring can always be marked.
+    header.mDataLength = writer.GetLengthWritten();
+    header.mLength     = (sizeof(header) + header.mDataLength + 3) & ~static_cast<uint32_t>(3);
+    VerifyOrExit(header.mLength <= inSpace, err = WEAVE_ERROR_NO_MEMORY);
+
+    header.mSchema         = inSchema;
+    header.mOptions        = inOptions;
+    header.mHasEventSource = (inOptions.eventSource != NULL);
+    if (header.mHasEventSource)
+    {
+        header.mEventSource = *inOptions.eventSource;
+    }
+
+    memcpy(&mData[inOffset], &header, sizeof(header));
+
+    outLength = header.mLength;
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   Read the event at the tail of the ring, without removing it.
+ *   Must only be called by the consumer.
+ *
+ * @param[in] inEnd        The head of the ring as of the start of the
+ *                         merge; events staged since are left for the
+ *                         next merge.
+ *
+ * @param[out] outHeader   The header of the event.
+ *
+ * @param[out] outData     The serialized event data.
+ *
+ * @retval true   An event was read.
+ * @retval false  The ring holds no event up to inEnd.
+ */
+bool EventStagingRing::Peek(uint32_t inEnd, StagedEventHeader & outHeader, const uint8_t *& outData)
+{
+    uint32_t offset;
+
+    // Make sure the events up to inEnd have been written in full before reading them.
+    __sync_synchronize();
+
+    while (mTail != inEnd)
+    {
+        offset = mTail % sizeof(mData);
+
+        memcpy(&outHeader.mLength, &mData[offset], sizeof(outHeader.mLength));
+        if (outHeader.mLength == 0)
+        {
+            mTail = mTail + (sizeof(mData) - offset);
+            continue;
+        }
+
+        memcpy(&outHeader, &mData[offset], sizeof(outHeader));
+        outData = &mData[offset + sizeof(outHeader)];
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief
+ *   Remove the event read by Peek from the ring.  Must only be called
+ *   by the consumer.
+ */
+void EventStagingRing::Pop(const StagedEventHeader & inHeader)
+{
+    // Make sure the event has been read in full before its space is handed back to the producer.
+    __sync_synchronize();
+    mTail = mTail + inHeader.mLength;
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+
 CopyAndAdjustDeltaTimeContext::CopyAndAdjustDeltaTimeContext(TLVWriter * inWriter, EventLoadOutContext * inContext) :
     mWriter(inWriter), mContext(inContext)
 { }
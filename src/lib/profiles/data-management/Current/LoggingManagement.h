@@ -150,6 +150,58 @@ struct EventEnvelopeContext
     ImportanceType mImportance;
 };
 
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+#if (WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_SIZE & (WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_SIZE - 1)) != 0
+#error "WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_SIZE must be a power of two"
+#endif
+
+/**
+ * @brief
+ *   Internal header preceding the serialized data of a staged event.
+ */
+struct StagedEventHeader
+{
+    uint32_t mLength;     //< Bytes taken by the staged event, including this header; 0 marks the unused end of the ring
+    uint32_t mDataLength; //< Length of the serialized event data
+    EventSchema mSchema;
+    EventOptions mOptions;
+    bool mHasEventSource;
+    DetailedRootSection mEventSource;
+};
+
+/**
+ * @brief
+ *   A single-producer, single-consumer ring in which one application
+ *   thread stages events, with their data already serialized, for the
+ *   Weave thread to merge into the event buffers.  The producer and
+ *   the consumer only synchronize through the head and tail offsets.
+ */
+struct EventStagingRing
+{
+    // for doxygen, see the CPP file
+    EventStagingRing(void);
+
+    // for doxygen, see the CPP file
+    WEAVE_ERROR Stage(const EventSchema & inSchema, EventWriterFunct inEventWriter, void * inAppData,
+                      const EventOptions & inOptions);
+
+    // for doxygen, see the CPP file
+    bool Peek(uint32_t inEnd, StagedEventHeader & outHeader, const uint8_t *& outData);
+
+    // for doxygen, see the CPP file
+    void Pop(const StagedEventHeader & inHeader);
+
+    volatile uint32_t mHead; //< Bytes staged since the ring was created; only written by the producer
+    volatile uint32_t mTail; //< Bytes merged since the ring was created; only written by the consumer
+
+    uint8_t mData[WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_SIZE];
+
+private:
+    WEAVE_ERROR Encode(uint32_t inOffset, uint32_t inSpace, const EventSchema & inSchema, EventWriterFunct inEventWriter,
+                       void * inAppData, const EventOptions & inOptions, uint32_t & outLength);
+};
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+
 enum LoggingManagementStates
 {
     kLoggingManagementState_Idle       = 1, //< No log offload in progress, log offload can begin without any constraints
@@ -160,6 +212,10 @@ enum LoggingManagementStates
 
 // forward class declaration
 class LogBDXUpload;
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+class MappedFileEventLog;
+struct MappedEventBufferState;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
 
 /**
  * @brief
@@ -238,13 +294,22 @@ public:
 #if WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
     bool CheckShouldRunWDM(void);
 #endif
+
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+    WEAVE_ERROR StageEvent(size_t inRing, const EventSchema & inSchema, EventWriterFunct inEventWriter, void * inAppData,
+                           const EventOptions * inOptions);
+    void MergeStagedEvents(void);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    WEAVE_ERROR AttachMappedFile(MappedFileEventLog & inFile);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
 private:
     event_id_t LogEventPrivate(const EventSchema & inSchema, EventWriterFunct inEventWriter, void * inAppData,
                                const EventOptions * inOptions);
 
     void FlushHandler(System::Layer * inSystemLayer, INET_ERROR inErr);
     void SignalUploadDone(void);
-    WEAVE_ERROR CopyToNextBuffer(CircularEventBuffer * inEventBuffer);
     WEAVE_ERROR EnsureSpace(size_t inRequiredSpace);
 
     static WEAVE_ERROR CopyEventsSince(const nl::Weave::TLV::TLVReader & aReader, size_t aDepth, void * aContext);
@@ -258,11 +323,20 @@ private:
                                  EventLoadOutContext * aContext);
 
     static void LoggingFlushHandler(System::Layer * systemLayer, void * appState, INET_ERROR err);
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+    static void MergeStagedEventsHandler(System::Layer * systemLayer, void * appState, INET_ERROR err);
+    static WEAVE_ERROR CopyStagedEventData(nl::Weave::TLV::TLVWriter & ioWriter, uint8_t inDataTag, void * appData);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
 
 #if WEAVE_CONFIG_EVENT_LOGGING_BDX_OFFLOAD
     bool CheckShouldRunBDX(void);
 #endif
 
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    WEAVE_ERROR RestoreMappedFile(const MappedEventBufferState * inState);
+    void CommitMappedFile(void);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
     ImportanceType GetMaxImportance(void);
     ImportanceType GetCurrentImportance(uint32_t profileId);
 
@@ -277,6 +351,13 @@ private:
     uint32_t mThrottled;
     ImportanceType mMaxImportanceBuffer;
     bool mUploadRequested;
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+    bool mMergeRequested;
+    EventStagingRing mStagingRings[WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS];
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    MappedFileEventLog * mMappedFile;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
 };
 
 namespace Platform {
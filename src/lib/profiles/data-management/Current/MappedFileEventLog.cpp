@@ -0,0 +1,319 @@
+/*
+ *
+ *    Copyright (c) 2016-2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief
+ *   Implementation of event buffers kept in a memory-mapped file.
+ *
+ */
+
+#include <Weave/Profiles/data-management/Current/WdmManagedNamespace.h>
+#include <Weave/Profiles/data-management/DataManagement.h>
+
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace nl {
+namespace Weave {
+namespace Profiles {
+namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current) {
+
+enum
+{
+    kFileMagic   = 0x4C564557, // "WEVL"
+    kFileVersion = 1,
+
+    kMaxBuffers = kImportanceType_Last - kImportanceType_First + 1,
+};
+
+struct MappedFileEventLog::FileHeader
+{
+    uint32_t mMagic;
+    uint16_t mVersion;
+    uint16_t mNumBuffers;
+    uint32_t mBufferHeaderSize; //< sizeof(CircularEventBuffer), which precedes the data of each buffer
+    uint32_t mStateSize;
+    uint32_t mBufferLengths[kMaxBuffers];
+};
+
+struct MappedFileEventLog::StateSlot
+{
+    uint32_t mSequence; //< Incremented by each commit; 0 if the slot was never written
+    uint32_t mChecksum;
+    MappedEventBufferState mBuffers[kMaxBuffers];
+};
+
+static size_t RoundUp(size_t inLength)
+{
+    return (inLength + 7) & ~static_cast<size_t>(7);
+}
+
+MappedFileEventLog::MappedFileEventLog(void) :
+    mFD(-1), mMapping(NULL), mMappingLength(0), mNumBuffers(0), mCommittedSlot(-1), mSequence(0)
+{
+    memset(mBuffers, 0, sizeof(mBuffers));
+}
+
+/**
+ * @brief
+ *   Open or create an event log file.
+ *
+ * The file is locked for the lifetime of the MappedFileEventLog, so
+ * that a second process cannot log to it at the same time.
+ *
+ * @param[in] inPath          The path of the event log file.
+ *
+ * @param[in] inNumBuffers    Number of event buffers.
+ *
+ * @param[in] inBufferLengths The length of each buffer, as passed to
+ *                            LoggingManagement::CreateLoggingManagement().
+ *
+ * @retval #WEAVE_ERROR_INCORRECT_STATE        The file is already open.
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT       The arguments are invalid.
+ * @retval #WEAVE_ERROR_PERSISTED_STORAGE_FAIL The file was written with
+ *                                             other buffer lengths, or
+ *                                             by an incompatible build.
+ * @retval #WEAVE_NO_ERROR                     On success.
+ * @retval other                               POSIX errors opening,
+ *                                             locking or mapping the file.
+ */
+WEAVE_ERROR MappedFileEventLog::Init(const char * inPath, size_t inNumBuffers, const size_t * inBufferLengths)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    const size_t slotsOffset   = RoundUp(sizeof(FileHeader));
+    const size_t buffersOffset = RoundUp(slotsOffset + 2 * sizeof(StateSlot));
+    size_t offset;
+    struct stat st;
+    FileHeader * header;
+    void * mapping;
+    bool isNewFile;
+
+    VerifyOrExit(mMapping == NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(inPath != NULL && inBufferLengths != NULL && inNumBuffers > 0 && inNumBuffers <= kMaxBuffers,
+                 err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    mMappingLength = buffersOffset;
+    for (size_t i = 0; i < inNumBuffers; i++)
+    {
+        VerifyOrExit(inBufferLengths[i] > sizeof(CircularEventBuffer) && inBufferLengths[i] <= UINT32_MAX,
+                     err = WEAVE_ERROR_INVALID_ARGUMENT);
+        mMappingLength += RoundUp(inBufferLengths[i]);
+    }
+
+    mFD = open(inPath, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    VerifyOrExit(mFD >= 0, err = System::MapErrorPOSIX(errno));
+
+    VerifyOrExit(flock(mFD, LOCK_EX | LOCK_NB) == 0, err = System::MapErrorPOSIX(errno));
+
+    VerifyOrExit(fstat(mFD, &st) == 0, err = System::MapErrorPOSIX(errno));
+
+    isNewFile = (st.st_size == 0);
+    if (isNewFile)
+        VerifyOrExit(ftruncate(mFD, mMappingLength) == 0, err = System::MapErrorPOSIX(errno));
+    else
+        VerifyOrExit(static_cast<size_t>(st.st_size) == mMappingLength, err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+
+    mapping = mmap(NULL, mMappingLength, PROT_READ | PROT_WRITE, MAP_SHARED, mFD, 0);
+    VerifyOrExit(mapping != MAP_FAILED, err = System::MapErrorPOSIX(errno));
+    mMapping = static_cast<uint8_t *>(mapping);
+
+    header = reinterpret_cast<FileHeader *>(mMapping);
+    if (isNewFile)
+    {
+        // The rest of the file, including both state slots, reads as zero.
+        header->mMagic            = kFileMagic;
+        header->mVersion          = kFileVersion;
+        header->mNumBuffers       = inNumBuffers;
+        header->mBufferHeaderSize = sizeof(CircularEventBuffer);
+        header->mStateSize        = sizeof(MappedEventBufferState);
+        for (size_t i = 0; i < inNumBuffers; i++)
+        {
+            header->mBufferLengths[i] = inBufferLengths[i];
+        }
+    }
+    else
+    {
+        VerifyOrExit(header->mMagic == kFileMagic && header->mVersion == kFileVersion && header->mNumBuffers == inNumBuffers &&
+                         header->mBufferHeaderSize == sizeof(CircularEventBuffer) &&
+                         header->mStateSize == sizeof(MappedEventBufferState),
+                     err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+        for (size_t i = 0; i < inNumBuffers; i++)
+        {
+            VerifyOrExit(header->mBufferLengths[i] == inBufferLengths[i], err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+        }
+    }
+
+    mNumBuffers = inNumBuffers;
+
+    offset = buffersOffset;
+    for (size_t i = 0; i < inNumBuffers; i++)
+    {
+        mBuffers[i] = mMapping + offset;
+        offset += RoundUp(inBufferLengths[i]);
+    }
+
+    // Pick up from the most recent complete commit.
+    for (size_t i = 0; i < 2; i++)
+    {
+        const StateSlot * slot = GetSlot(i);
+
+        if (slot->mSequence == 0 || slot->mChecksum != ComputeChecksum(slot))
+            continue;
+
+        if (mCommittedSlot < 0 || static_cast<int32_t>(slot->mSequence - mSequence) > 0)
+        {
+            mCommittedSlot = i;
+            mSequence      = slot->mSequence;
+        }
+    }
+
+exit:
+    if (err != WEAVE_NO_ERROR)
+    {
+        WeaveLogError(EventLogging, "Failed to open event log %s: %s", (inPath != NULL) ? inPath : "", ErrorStr(err));
+        Shutdown();
+    }
+    return err;
+}
+
+/**
+ * @brief
+ *   Close the event log file.  The logged events remain in the file.
+ *
+ * LoggingManagement must not use the buffers once the file is closed.
+ */
+WEAVE_ERROR MappedFileEventLog::Shutdown(void)
+{
+    if (mMapping != NULL)
+    {
+        munmap(mMapping, mMappingLength);
+        mMapping = NULL;
+    }
+
+    if (mFD >= 0)
+    {
+        close(mFD);
+        mFD = -1;
+    }
+
+    mNumBuffers    = 0;
+    mCommittedSlot = -1;
+    mSequence      = 0;
+    memset(mBuffers, 0, sizeof(mBuffers));
+
+    return WEAVE_NO_ERROR;
+}
+
+/**
+ * @brief
+ *   Write the event log out to storage, so that it survives a power
+ *   loss as well as a restart of the process.
+ */
+WEAVE_ERROR MappedFileEventLog::Sync(void)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(mMapping != NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(msync(mMapping, mMappingLength, MS_SYNC) == 0, err = System::MapErrorPOSIX(errno));
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   Get the state of the buffers as last committed to the file.
+ *
+ * @return The state of each buffer, or NULL if no state was ever
+ *         committed to the file.
+ */
+const MappedEventBufferState * MappedFileEventLog::GetCommittedState(void) const
+{
+    return (mCommittedSlot < 0) ? NULL : GetSlot(mCommittedSlot)->mBuffers;
+}
+
+/**
+ * @brief
+ *   Commit the state of the buffers to the file.
+ *
+ * The state is written to the slot that does not hold the last
+ * commit, and only replaces it once it is complete, so a commit
+ * interrupted by the process exiting leaves the previous one in
+ * place.
+ *
+ * @param[in] inState The state of each buffer.
+ */
+void MappedFileEventLog::Commit(const MappedEventBufferState * inState)
+{
+    const size_t index = (mCommittedSlot == 0) ? 1 : 0;
+    StateSlot * slot   = GetSlot(index);
+
+    VerifyOrExit(mMapping != NULL, /* no-op */);
+
+    slot->mSequence = mSequence + 1;
+    if (slot->mSequence == 0)
+        slot->mSequence = 1;
+    memcpy(slot->mBuffers, inState, mNumBuffers * sizeof(MappedEventBufferState));
+    slot->mChecksum = ComputeChecksum(slot);
+
+    mCommittedSlot = index;
+    mSequence      = slot->mSequence;
+
+exit:
+    return;
+}
+
+MappedFileEventLog::StateSlot * MappedFileEventLog::GetSlot(size_t inIndex) const
+{
+    return reinterpret_cast<StateSlot *>(mMapping + RoundUp(sizeof(FileHeader)) + inIndex * sizeof(StateSlot));
+}
+
+// FNV-1a over the sequence number and the state of the buffers in use.
+uint32_t MappedFileEventLog::ComputeChecksum(const StateSlot * inSlot) const
+{
+    const uint8_t * state = reinterpret_cast<const uint8_t *>(inSlot->mBuffers);
+    uint32_t hash         = 2166136261U;
+
+    for (size_t i = 0; i < sizeof(inSlot->mSequence); i++)
+    {
+        hash = (hash ^ ((inSlot->mSequence >> (8 * i)) & 0xFF)) * 16777619U;
+    }
+
+    for (size_t i = 0; i < mNumBuffers * sizeof(MappedEventBufferState); i++)
+    {
+        hash = (hash ^ state[i]) * 16777619U;
+    }
+
+    return hash;
+}
+
+} // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
+} // namespace Profiles
+} // namespace Weave
+} // namespace nl
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
@@ -0,0 +1,128 @@
+/*
+ *
+ *    Copyright (c) 2016-2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief
+ *   Event buffers kept in a memory-mapped file, for use on POSIX
+ *   platforms.
+ *
+ */
+#ifndef _WEAVE_DATA_MANAGEMENT_MAPPED_FILE_EVENT_LOG_CURRENT_H
+#define _WEAVE_DATA_MANAGEMENT_MAPPED_FILE_EVENT_LOG_CURRENT_H
+
+#include <Weave/Profiles/data-management/Current/WdmManagedNamespace.h>
+#include <Weave/Profiles/data-management/EventLoggingTypes.h>
+
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+namespace nl {
+namespace Weave {
+namespace Profiles {
+namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current) {
+
+/**
+ * @brief
+ *   The state of an event buffer, as committed to a MappedFileEventLog
+ *   by LoggingManagement.
+ */
+struct MappedEventBufferState
+{
+    enum
+    {
+        kFlag_UTCInitialized    = 0x01, //< The buffer holds UTC timestamps
+        kFlag_HasExternalEvents = 0x02, //< Externally stored events are registered for the buffer's importance
+    };
+
+    uint32_t mQueueHead;   //< Offset of the oldest event in the buffer's data
+    uint32_t mQueueLength; //< Length of the events in the buffer's data
+    event_id_t mFirstEventID;
+    event_id_t mLastEventID;
+    event_id_t mNextEventID; //< Value of the event ID counter
+    timestamp_t mFirstEventTimestamp;
+    timestamp_t mLastEventTimestamp;
+    uint32_t mFlags;
+    utc_timestamp_t mFirstEventUTCTimestamp;
+    utc_timestamp_t mLastEventUTCTimestamp;
+};
+
+/**
+ * @class MappedFileEventLog
+ *
+ * @brief
+ *   Event buffers kept in a memory-mapped file.
+ *
+ *   The buffers returned by GetBuffers() are passed to
+ *   LoggingManagement::CreateLoggingManagement() in place of RAM
+ *   buffers, and the file is then handed to
+ *   LoggingManagement::AttachMappedFile(), which recovers the events
+ *   logged before the process last exited.  Events are written to the
+ *   file once, as they are logged; there is no separate serialization
+ *   pass.
+ *
+ *   LoggingManagement commits the state of the buffers, including the
+ *   event IDs and timestamps, to one of two slots in the file header
+ *   each time it changes, so that the file holds a consistent log
+ *   however the process exits.  Surviving a power loss also requires
+ *   calling Sync().  The file format is native-endian and depends on
+ *   the build; a file written by an incompatible build is rejected.
+ */
+class NL_DLL_EXPORT MappedFileEventLog
+{
+public:
+    MappedFileEventLog(void);
+
+    WEAVE_ERROR Init(const char * inPath, size_t inNumBuffers, const size_t * inBufferLengths);
+    WEAVE_ERROR Shutdown(void);
+
+    WEAVE_ERROR Sync(void);
+
+    void ** GetBuffers(void) { return mBuffers; }
+    size_t GetNumBuffers(void) const { return mNumBuffers; }
+
+    // for doxygen, see the CPP file
+    const MappedEventBufferState * GetCommittedState(void) const;
+
+    // for doxygen, see the CPP file
+    void Commit(const MappedEventBufferState * inState);
+
+private:
+    struct FileHeader;
+    struct StateSlot;
+
+    StateSlot * GetSlot(size_t inIndex) const;
+    uint32_t ComputeChecksum(const StateSlot * inSlot) const;
+
+    int mFD;
+    uint8_t * mMapping;
+    size_t mMappingLength;
+    size_t mNumBuffers;
+    int mCommittedSlot; //< The slot holding the last commit, or -1
+    uint32_t mSequence; //< The sequence number of the last commit
+    void * mBuffers[kImportanceType_Last - kImportanceType_First + 1];
+};
+
+} // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
+} // namespace Profiles
+} // namespace Weave
+} // namespace nl
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+#endif // _WEAVE_DATA_MANAGEMENT_MAPPED_FILE_EVENT_LOG_CURRENT_H
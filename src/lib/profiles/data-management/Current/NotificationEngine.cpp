@@ -76,9 +76,10 @@ exit:
 WEAVE_ERROR NotificationEngine::BasicGraphSolver::SetDirty(TraitDataHandle aDataHandle, PropertyPathHandle aPropertyHandle)
 {
     SubscriptionEngine * subEngine = SubscriptionEngine::GetInstance();
+    uint64_t nowMsec               = 0;
 
     // Iterate over all subscriptions and their trait instance info lists and mark them dirty as appropriate
-    for (int i = 0; i < SubscriptionEngine::kMaxNumSubscriptionHandlers; ++i)
+    for (int i = 0; i < subEngine->mHandlerPoolSize; ++i)
     {
         SubscriptionHandler * subHandler = &subEngine->mHandlers[i];
 
@@ -92,6 +93,16 @@ WEAVE_ERROR NotificationEngine::BasicGraphSolver::SetDirty(TraitDataHandle aData
                 {
                     WeaveLogDetail(DataManagement, "<BSolver:SetD> Set S%u:T%u dirty", i, j);
                     traitInstance[j].SetDirty();
+
+                    if (subHandler->mNotifyMinIntervalMsec != 0)
+                    {
+                        if (nowMsec == 0)
+                        {
+                            nowMsec = System::Layer::GetClock_MonotonicMS();
+                        }
+
+                        subHandler->NoteDataChange(nowMsec);
+                    }
                 }
             }
         }
@@ -683,6 +694,19 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::RetrieveTraitInstanceDa
                    GetPropertyDictionaryKey(currentCommonHandle), GetPropertySchemaHandle(currentCommonHandle), numMergeHandles,
                    numDeleteHandles);
 
+    // For delta subscriptions, try sending just the dirty handles if the LCA would carry unchanged data.
+    if (!aRetrieveAll && !dataSource->IsRootDirty() && numDeleteHandles == 0 && aBuilder->GetSubscriptionHandler() != NULL &&
+        aBuilder->GetSubscriptionHandler()->IsDeltaNotificationEnabled())
+    {
+        bool written = false;
+
+        err = WriteDeltaDataElements(aBuilder, aTraitDataHandle, aSchemaVersion, currentCommonHandle, mergeHandleSet,
+                                     numMergeHandles, written);
+        SuccessOrExit(err);
+
+        VerifyOrExit(!written, /* no-op */);
+    }
+
     // if we overflow, let's clear them back to 0.
     if (numMergeHandles < 0)
     {
@@ -698,6 +722,139 @@ exit:
     return err;
 }
 
+/**
+ * Write one data element per dirty handle of a trait instance, as a single change, if that is smaller than the data element
+ * at their lowest common ancestor. aCommonHandle and aMergeHandleSet describe the latter, as computed by
+ * RetrieveTraitInstanceData; a negative aNumMergeHandles indicates an overflowed merge set. aWritten is set if the delta was
+ * written, in which case the caller is done; otherwise nothing is written and the caller writes the LCA data element.
+ */
+WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::WriteDeltaDataElements(NotifyRequestBuilder * aBuilder,
+                                                                                TraitDataHandle aTraitDataHandle,
+                                                                                SchemaVersion aSchemaVersion,
+                                                                                PropertyPathHandle aCommonHandle,
+                                                                                PropertyPathHandle * aMergeHandleSet,
+                                                                                int32_t aNumMergeHandles, bool & aWritten)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    PropertyPathHandle candidates[WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE];
+    PropertyPathHandle deltaHandles[WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE];
+    uint32_t numDeltaHandles   = 0;
+    uint32_t numCandidates     = 0;
+    uint32_t changeStoreCursor = 0;
+    uint32_t startLen, lcaLen, deltaLen;
+    PropertyPathHandle candidateHandle, dictionaryItemHandle;
+    bool candidateHandleIsDelete = false;
+    bool checkpointed            = false;
+    bool lcaIsExact;
+    TraitDataSource * dataSource;
+    const TraitSchemaEngine * schemaEngine;
+    TLVWriter checkpoint;
+
+    aWritten = false;
+
+    err = SubscriptionEngine::GetInstance()->mPublisherCatalog->Locate(aTraitDataHandle, &dataSource);
+    SuccessOrExit(err);
+
+    schemaEngine = dataSource->GetSchemaEngine();
+
+    // Gather the dirty handles. Dictionaries and deletions keep their replace and delete semantics and are only expressed
+    // through the LCA.
+    while ((candidateHandle = GetNextCandidateHandle(changeStoreCursor, aTraitDataHandle, candidateHandleIsDelete)) !=
+           kNullPropertyPathHandle)
+    {
+        VerifyOrExit(!candidateHandleIsDelete, /* no-op */);
+        VerifyOrExit(!schemaEngine->IsDictionary(candidateHandle) &&
+                         !schemaEngine->IsInDictionary(candidateHandle, dictionaryItemHandle),
+                     /* no-op */);
+
+        candidates[numCandidates++] = candidateHandle;
+    }
+
+    // Leave out any handle that is covered by another dirty handle.
+    for (uint32_t i = 0; i < numCandidates; i++)
+    {
+        bool covered = false;
+
+        for (uint32_t j = 0; j < numDeltaHandles && !covered; j++)
+        {
+            covered = (deltaHandles[j] == candidates[i]);
+        }
+
+        for (uint32_t j = 0; j < numCandidates && !covered; j++)
+        {
+            covered = schemaEngine->IsParent(candidates[i], candidates[j]);
+        }
+
+        if (!covered)
+        {
+            deltaHandles[numDeltaHandles++] = candidates[i];
+        }
+    }
+
+    // The LCA data element is already exact if it is the one dirty handle, or merges in exactly the dirty handles.
+    lcaIsExact = (numDeltaHandles <= 1);
+
+    if (!lcaIsExact && aNumMergeHandles == static_cast<int32_t>(numDeltaHandles))
+    {
+        lcaIsExact = true;
+
+        for (uint32_t i = 0; i < numDeltaHandles && lcaIsExact; i++)
+        {
+            lcaIsExact = false;
+
+            for (int32_t j = 0; j < aNumMergeHandles; j++)
+            {
+                if (aMergeHandleSet[j] == deltaHandles[i])
+                {
+                    lcaIsExact = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    VerifyOrExit(!lcaIsExact, /* no-op */);
+
+    // Encode both and keep the smaller. If the LCA does not fit, the delta may still.
+    aBuilder->Checkpoint(checkpoint);
+    checkpointed = true;
+    startLen = aBuilder->GetWriter()->GetLengthWritten();
+
+    err = aBuilder->WriteDataElement(aTraitDataHandle, aCommonHandle, aSchemaVersion, aMergeHandleSet,
+                                     aNumMergeHandles < 0 ? 0 : aNumMergeHandles, NULL, 0);
+    lcaLen = (err == WEAVE_NO_ERROR) ? aBuilder->GetWriter()->GetLengthWritten() - startLen : UINT32_MAX;
+
+    aBuilder->Rollback(checkpoint);
+
+    for (uint32_t i = 0; i < numDeltaHandles; i++)
+    {
+        err = aBuilder->WriteDataElement(aTraitDataHandle, deltaHandles[i], aSchemaVersion, NULL, 0, NULL, 0,
+                                         i + 1 < numDeltaHandles);
+        SuccessOrExit(err);
+    }
+
+    deltaLen = aBuilder->GetWriter()->GetLengthWritten() - startLen;
+
+    WeaveLogDetail(DataManagement, "<ISolver::Retr> Delta: %u handles, %u bytes (LCA: %u bytes)", numDeltaHandles, deltaLen,
+                   lcaLen);
+
+    aWritten = (deltaLen < lcaLen);
+
+exit:
+    // Failing to write the delta is not an error; the caller falls back to the LCA, which reports any real failure.
+    if (!aWritten)
+    {
+        if (checkpointed)
+        {
+            aBuilder->Rollback(checkpoint);
+        }
+
+        err = WEAVE_NO_ERROR;
+    }
+
+    return err;
+}
+
 void NotificationEngine::IntermediateGraphSolver::ClearTraitInstanceDirty(void * aDataSource, TraitDataHandle aDataHandle,
                                                                           void * aContext)
 {
@@ -851,100 +1008,186 @@ exit:
     return err;
 }
 
-WEAVE_ERROR
-NotificationEngine::NotifyRequestBuilder::WriteDataElement(TraitDataHandle aTraitDataHandle, PropertyPathHandle aPropertyPathHandle,
-                                                           SchemaVersion aSchemaVersion, PropertyPathHandle * aMergeDataHandleSet,
-                                                           uint32_t aNumMergeDataHandles, PropertyPathHandle * aDeleteHandleSet,
-                                                           uint32_t aNumDeleteHandles)
+WEAVE_ERROR NotificationEngine::NotifyRequestBuilder::EncodeDataElementHeader(TLVWriter & aWriter, TraitDataSource * aDataSource,
+                                                                         TraitDataHandle aTraitDataHandle,
+                                                                         PropertyPathHandle aPropertyPathHandle,
+                                                                         SchemaVersion aSchemaVersion, bool aPartialChange)
 {
     WEAVE_ERROR err;
     TLVType dummyContainerType;
-    TraitDataSource * dataSource;
-    bool retrievingData = false;
     SchemaVersionRange versionRange;
 
-    VerifyOrExit(mState == kNotifyRequestBuilder_BuildDataList, err = WEAVE_ERROR_INCORRECT_STATE);
+    versionRange.mMaxVersion = aSchemaVersion;
+    versionRange.mMinVersion = aDataSource->GetSchemaEngine()->GetLowestCompatibleVersion(versionRange.mMaxVersion);
 
-    err = mWriter->StartContainer(AnonymousTag, kTLVType_Structure, dummyContainerType);
+    err = aWriter.StartContainer(ContextTag(DataElement::kCsTag_Path), kTLVType_Path, dummyContainerType);
     SuccessOrExit(err);
 
-    err = SubscriptionEngine::GetInstance()->mPublisherCatalog->Locate(aTraitDataHandle, &dataSource);
+    err = SubscriptionEngine::GetInstance()->mPublisherCatalog->HandleToAddress(aTraitDataHandle, aWriter, versionRange);
     SuccessOrExit(err);
 
-    versionRange.mMaxVersion = aSchemaVersion;
-    versionRange.mMinVersion = dataSource->GetSchemaEngine()->GetLowestCompatibleVersion(versionRange.mMaxVersion);
-
-    err = mWriter->StartContainer(ContextTag(DataElement::kCsTag_Path), kTLVType_Path, dummyContainerType);
+    err = aDataSource->GetSchemaEngine()->MapHandleToPath(aPropertyPathHandle, aWriter);
     SuccessOrExit(err);
 
-    err = SubscriptionEngine::GetInstance()->mPublisherCatalog->HandleToAddress(aTraitDataHandle, *mWriter, versionRange);
+    err = aWriter.EndContainer(dummyContainerType);
     SuccessOrExit(err);
 
-    err = dataSource->GetSchemaEngine()->MapHandleToPath(aPropertyPathHandle, *mWriter);
+    err = aWriter.Put(ContextTag(DataElement::kCsTag_Version), aDataSource->GetVersion());
     SuccessOrExit(err);
 
-    err = mWriter->EndContainer(dummyContainerType);
+    if (aPartialChange)
+    {
+        err = aWriter.PutBoolean(ContextTag(DataElement::kCsTag_IsPartialChange), true);
+        SuccessOrExit(err);
+    }
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR NotificationEngine::NotifyRequestBuilder::EncodeDataElement(
+    TLVWriter & aWriter, TraitDataSource * aDataSource, TraitDataHandle aTraitDataHandle, PropertyPathHandle aPropertyPathHandle,
+    SchemaVersion aSchemaVersion, PropertyPathHandle * aMergeDataHandleSet, uint32_t aNumMergeDataHandles,
+    PropertyPathHandle * aDeleteHandleSet, uint32_t aNumDeleteHandles, bool aPartialChange, bool & aRetrievingData)
+{
+    WEAVE_ERROR err;
+    TLVType outerContainerType;
+    TLVType dummyContainerType;
+
+    aRetrievingData = false;
+
+    err = aWriter.StartContainer(AnonymousTag, kTLVType_Structure, outerContainerType);
     SuccessOrExit(err);
 
-    err = mWriter->Put(ContextTag(DataElement::kCsTag_Version), dataSource->GetVersion());
+    err = EncodeDataElementHeader(aWriter, aDataSource, aTraitDataHandle, aPropertyPathHandle, aSchemaVersion, aPartialChange);
     SuccessOrExit(err);
 
     if (aNumMergeDataHandles > 0 || aNumDeleteHandles > 0)
     {
-        const TraitSchemaEngine * schemaEngine = dataSource->GetSchemaEngine();
+        const TraitSchemaEngine * schemaEngine = aDataSource->GetSchemaEngine();
 
 #if TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
         if (aNumDeleteHandles > 0)
         {
             err =
-                mWriter->StartContainer(ContextTag(DataElement::kCsTag_DeletedDictionaryKeys), kTLVType_Array, dummyContainerType);
+                aWriter.StartContainer(ContextTag(DataElement::kCsTag_DeletedDictionaryKeys), kTLVType_Array, dummyContainerType);
             SuccessOrExit(err);
 
             for (size_t i = 0; i < aNumDeleteHandles; i++)
             {
-                err = mWriter->Put(AnonymousTag, GetPropertyDictionaryKey(aDeleteHandleSet[i]));
+                err = aWriter.Put(AnonymousTag, GetPropertyDictionaryKey(aDeleteHandleSet[i]));
                 SuccessOrExit(err);
             }
 
-            err = mWriter->EndContainer(dummyContainerType);
+            err = aWriter.EndContainer(dummyContainerType);
             SuccessOrExit(err);
         }
 #endif // TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
 
         if (aNumMergeDataHandles > 0)
         {
-            err = mWriter->StartContainer(ContextTag(DataElement::kCsTag_Data), kTLVType_Structure, dummyContainerType);
+            err = aWriter.StartContainer(ContextTag(DataElement::kCsTag_Data), kTLVType_Structure, dummyContainerType);
             SuccessOrExit(err);
 
-            retrievingData = true;
+            aRetrievingData = true;
 
             for (size_t i = 0; i < aNumMergeDataHandles; i++)
             {
                 WeaveLogDetail(DataManagement, "<NE::WriteDE> Merging in 0x%08x", aMergeDataHandleSet[i]);
 
-                err = dataSource->ReadData(aMergeDataHandleSet[i], schemaEngine->GetTag(aMergeDataHandleSet[i]), *mWriter);
+                err = aDataSource->ReadData(aMergeDataHandleSet[i], schemaEngine->GetTag(aMergeDataHandleSet[i]), aWriter);
                 SuccessOrExit(err);
             }
 
-            retrievingData = false;
+            aRetrievingData = false;
 
-            err = mWriter->EndContainer(dummyContainerType);
+            err = aWriter.EndContainer(dummyContainerType);
             SuccessOrExit(err);
         }
     }
     else
     {
-        retrievingData = true;
+        aRetrievingData = true;
 
-        err = dataSource->ReadData(aPropertyPathHandle, ContextTag(DataElement::kCsTag_Data), *mWriter);
+        err = aDataSource->ReadData(aPropertyPathHandle, ContextTag(DataElement::kCsTag_Data), aWriter);
         SuccessOrExit(err);
 
-        retrievingData = false;
+        aRetrievingData = false;
     }
 
-    err = mWriter->EndContainer(kTLVType_Array);
+    err = aWriter.EndContainer(outerContainerType);
+    SuccessOrExit(err);
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR
+NotificationEngine::NotifyRequestBuilder::WriteDataElement(TraitDataHandle aTraitDataHandle, PropertyPathHandle aPropertyPathHandle,
+                                                           SchemaVersion aSchemaVersion, PropertyPathHandle * aMergeDataHandleSet,
+                                                           uint32_t aNumMergeDataHandles, PropertyPathHandle * aDeleteHandleSet,
+                                                           uint32_t aNumDeleteHandles, bool aPartialChange)
+{
+    WEAVE_ERROR err;
+    TraitDataSource * dataSource;
+    bool retrievingData = false;
+
+    VerifyOrExit(mState == kNotifyRequestBuilder_BuildDataList, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    err = SubscriptionEngine::GetInstance()->mPublisherCatalog->Locate(aTraitDataHandle, &dataSource);
     SuccessOrExit(err);
 
+#if WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+    {
+        DataElementCache & cache = SubscriptionEngine::GetInstance()->GetNotificationEngine()->mDataElementCache;
+        DataElementCache::Entry * entry =
+            cache.Find(dataSource, aTraitDataHandle, aPropertyPathHandle, aSchemaVersion, aMergeDataHandleSet,
+                       aNumMergeDataHandles, aDeleteHandleSet, aNumDeleteHandles, aPartialChange);
+
+        if (entry == NULL)
+        {
+            entry = cache.Allocate(dataSource, aTraitDataHandle, aPropertyPathHandle, aSchemaVersion, aMergeDataHandleSet,
+                                   aNumMergeDataHandles, aDeleteHandleSet, aNumDeleteHandles, aPartialChange);
+
+            if (entry != NULL)
+            {
+                TLVWriter writer;
+
+                writer.Init(entry->mData, sizeof(entry->mData));
+
+                err = EncodeDataElement(writer, dataSource, aTraitDataHandle, aPropertyPathHandle, aSchemaVersion,
+                                        aMergeDataHandleSet, aNumMergeDataHandles, aDeleteHandleSet, aNumDeleteHandles,
+                                        aPartialChange, retrievingData);
+                if (err == WEAVE_NO_ERROR)
+                {
+                    err = writer.Finalize();
+                }
+
+                if (err == WEAVE_NO_ERROR)
+                {
+                    entry->mDataLen = static_cast<uint16_t>(writer.GetLengthWritten());
+                }
+                else
+                {
+                    // Too large to cache, or the data could not be read; the element is encoded directly below.
+                    cache.Release(entry);
+                    entry = NULL;
+                }
+            }
+        }
+
+        if (entry != NULL)
+        {
+            // Skip the control byte of the anonymous structure; PutPreEncodedContainer writes its own.
+            err = mWriter->PutPreEncodedContainer(AnonymousTag, kTLVType_Structure, entry->mData + 1, entry->mDataLen - 1);
+            ExitNow();
+        }
+    }
+#endif // WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+
+    err = EncodeDataElement(*mWriter, dataSource, aTraitDataHandle, aPropertyPathHandle, aSchemaVersion, aMergeDataHandleSet,
+                            aNumMergeDataHandles, aDeleteHandleSet, aNumDeleteHandles, aPartialChange, retrievingData);
+
 exit:
     if (retrievingData && err != WEAVE_NO_ERROR)
     {
@@ -955,6 +1198,65 @@ exit:
     return err;
 }
 
+#if TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
+WEAVE_ERROR NotificationEngine::NotifyRequestBuilder::WriteDictionaryDataElement(TraitDataHandle aTraitDataHandle,
+                                                                             PropertyPathHandle aDictionaryHandle,
+                                                                             SchemaVersion aSchemaVersion,
+                                                                             PropertyPathHandle & aItemToStartFrom,
+                                                                             bool aPartialChange)
+{
+    WEAVE_ERROR err;
+    TraitDataSource * dataSource;
+    const TraitSchemaEngine * schemaEngine;
+    TLVType outerContainerType;
+    TLVType dummyContainerType;
+    bool replace = IsNullPropertyPathHandle(aItemToStartFrom);
+
+    VerifyOrExit(mState == kNotifyRequestBuilder_BuildDataList, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    err = SubscriptionEngine::GetInstance()->mPublisherCatalog->Locate(aTraitDataHandle, &dataSource);
+    SuccessOrExit(err);
+
+    schemaEngine = dataSource->GetSchemaEngine();
+
+    err = mWriter->StartContainer(AnonymousTag, kTLVType_Structure, outerContainerType);
+    SuccessOrExit(err);
+
+    if (replace)
+    {
+        // Address the parent and carry the dictionary as one of its merged children, so that the subscriber replaces the
+        // dictionary rather than merging into it.
+        err = EncodeDataElementHeader(*mWriter, dataSource, aTraitDataHandle, schemaEngine->GetParent(aDictionaryHandle),
+                                      aSchemaVersion, aPartialChange);
+        SuccessOrExit(err);
+
+        err = mWriter->StartContainer(ContextTag(DataElement::kCsTag_Data), kTLVType_Structure, dummyContainerType);
+        SuccessOrExit(err);
+
+        err = dataSource->ReadDictionaryData(aDictionaryHandle, schemaEngine->GetTag(aDictionaryHandle), *mWriter,
+                                             aItemToStartFrom);
+        SuccessOrExit(err);
+
+        err = mWriter->EndContainer(dummyContainerType);
+        SuccessOrExit(err);
+    }
+    else
+    {
+        err = EncodeDataElementHeader(*mWriter, dataSource, aTraitDataHandle, aDictionaryHandle, aSchemaVersion, aPartialChange);
+        SuccessOrExit(err);
+
+        err = dataSource->ReadDictionaryData(aDictionaryHandle, ContextTag(DataElement::kCsTag_Data), *mWriter, aItemToStartFrom);
+        SuccessOrExit(err);
+    }
+
+    err = mWriter->EndContainer(outerContainerType);
+    SuccessOrExit(err);
+
+exit:
+    return err;
+}
+#endif // TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
+
 WEAVE_ERROR NotificationEngine::NotifyRequestBuilder::MoveToState(NotifyRequestBuilderState aDesiredState)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
@@ -1027,12 +1329,229 @@ WEAVE_ERROR NotificationEngine::NotifyRequestBuilder::Rollback(TLVWriter & aPoin
 // NotificationEngine
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#if WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+NotificationEngine::DataElementCache::DataElementCache()
+{
+    mNumHits = 0;
+    mEnabled = true;
+    Clear();
+}
+
+NotificationEngine::DataElementCache::Entry *
+NotificationEngine::DataElementCache::Find(TraitDataSource * aDataSource, TraitDataHandle aTraitDataHandle,
+                                           PropertyPathHandle aPropertyPathHandle, SchemaVersion aSchemaVersion,
+                                           const PropertyPathHandle * aMergeDataHandleSet, uint32_t aNumMergeDataHandles,
+                                           const PropertyPathHandle * aDeleteHandleSet, uint32_t aNumDeleteHandles,
+                                           bool aPartialChange)
+{
+    uint64_t version;
+
+    if (!mEnabled)
+    {
+        return NULL;
+    }
+
+    version = aDataSource->GetVersion();
+
+    for (size_t i = 0; i < ArraySize(mEntries); i++)
+    {
+        Entry & entry = mEntries[i];
+
+        if (entry.mDataSource == aDataSource && entry.mTraitDataHandle == aTraitDataHandle &&
+            entry.mPropertyPathHandle == aPropertyPathHandle && entry.mSchemaVersion == aSchemaVersion &&
+            entry.mVersion == version && entry.mNumMergeDataHandles == aNumMergeDataHandles &&
+            entry.mNumDeleteHandles == aNumDeleteHandles && entry.mPartialChange == aPartialChange &&
+            memcmp(entry.mMergeDataHandleSet, aMergeDataHandleSet, aNumMergeDataHandles * sizeof(PropertyPathHandle)) == 0 &&
+            memcmp(entry.mDeleteHandleSet, aDeleteHandleSet, aNumDeleteHandles * sizeof(PropertyPathHandle)) == 0)
+        {
+            mNumHits++;
+            return &entry;
+        }
+    }
+
+    return NULL;
+}
+
+NotificationEngine::DataElementCache::Entry *
+NotificationEngine::DataElementCache::Allocate(TraitDataSource * aDataSource, TraitDataHandle aTraitDataHandle,
+                                               PropertyPathHandle aPropertyPathHandle, SchemaVersion aSchemaVersion,
+                                               const PropertyPathHandle * aMergeDataHandleSet, uint32_t aNumMergeDataHandles,
+                                               const PropertyPathHandle * aDeleteHandleSet, uint32_t aNumDeleteHandles,
+                                               bool aPartialChange)
+{
+    Entry * entry = NULL;
+
+    VerifyOrExit(mEnabled, /* no-op */);
+    VerifyOrExit(aNumMergeDataHandles <= WDM_PUBLISHER_INTERMEDIATE_SOLVER_MAX_MERGE_HANDLE_SET, /* no-op */);
+    VerifyOrExit(aNumDeleteHandles <= WDM_PUBLISHER_INTERMEDIATE_SOLVER_MAX_MERGE_HANDLE_SET, /* no-op */);
+
+    entry       = &mEntries[mNextVictim];
+    mNextVictim = (mNextVictim + 1) % ArraySize(mEntries);
+
+    entry->mDataSource          = aDataSource;
+    entry->mTraitDataHandle     = aTraitDataHandle;
+    entry->mPropertyPathHandle  = aPropertyPathHandle;
+    entry->mSchemaVersion       = aSchemaVersion;
+    entry->mVersion             = aDataSource->GetVersion();
+    entry->mNumMergeDataHandles = static_cast<uint16_t>(aNumMergeDataHandles);
+    entry->mNumDeleteHandles    = static_cast<uint16_t>(aNumDeleteHandles);
+    entry->mPartialChange       = aPartialChange;
+    entry->mDataLen             = 0;
+
+    memcpy(entry->mMergeDataHandleSet, aMergeDataHandleSet, aNumMergeDataHandles * sizeof(PropertyPathHandle));
+    memcpy(entry->mDeleteHandleSet, aDeleteHandleSet, aNumDeleteHandles * sizeof(PropertyPathHandle));
+
+exit:
+    return entry;
+}
+
+void NotificationEngine::DataElementCache::Invalidate(TraitDataSource * aDataSource)
+{
+    for (size_t i = 0; i < ArraySize(mEntries); i++)
+    {
+        if (mEntries[i].mDataSource == aDataSource)
+        {
+            Release(&mEntries[i]);
+        }
+    }
+}
+
+void NotificationEngine::DataElementCache::Release(Entry * aEntry)
+{
+    aEntry->mDataSource = NULL;
+}
+
+void NotificationEngine::DataElementCache::Clear()
+{
+    for (size_t i = 0; i < ArraySize(mEntries); i++)
+    {
+        Release(&mEntries[i]);
+    }
+
+    mNextVictim = 0;
+}
+
+void NotificationEngine::DataElementCache::SetEnabled(bool aEnabled)
+{
+    mEnabled = aEnabled;
+    Clear();
+}
+#endif // WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+
+#if WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+NotificationEngine::EventListCache::EventListCache()
+{
+    Clear();
+}
+
+WEAVE_ERROR NotificationEngine::EventListCache::FetchEventsSince(TLVWriter & ioWriter, ImportanceType aImportance,
+                                                                 event_id_t & ioEventID)
+{
+    WEAVE_ERROR err;
+    LoggingManagement & logger = LoggingManagement::GetInstance();
+    event_id_t firstEventID    = logger.GetFirstEventID(aImportance);
+    event_id_t startingEventID = (ioEventID < firstEventID) ? firstEventID : ioEventID;
+    Entry * entry              = &mEntries[aImportance - kImportanceType_First];
+    TLVReader reader;
+    TLVWriter checkpoint;
+
+    // A fragment whose first event has since been evicted can no longer be served.
+    if (entry->mDataLen == 0 || entry->mStartingEventID != startingEventID || entry->mStartingEventID < firstEventID)
+    {
+        entry = Fill(logger, aImportance, startingEventID);
+    }
+
+    if (entry == NULL)
+    {
+        return logger.FetchEventsSince(ioWriter, aImportance, ioEventID);
+    }
+
+    ioEventID = entry->mStartingEventID;
+
+    reader.Init(entry->mData, entry->mDataLen);
+
+    while ((err = reader.Next()) == WEAVE_NO_ERROR)
+    {
+        checkpoint = ioWriter;
+
+        err = ioWriter.CopyElement(reader);
+        if (err != WEAVE_NO_ERROR)
+        {
+            ioWriter = checkpoint;
+            ExitNow();
+        }
+
+        ioEventID++;
+    }
+
+    VerifyOrExit(err == WEAVE_END_OF_TLV, /* no-op */);
+
+    // The whole fragment was copied; pick up whatever did not fit in it or was logged after it was read.
+    if (ioEventID <= logger.GetLastEventID(aImportance))
+    {
+        err = logger.FetchEventsSince(ioWriter, aImportance, ioEventID);
+    }
+
+exit:
+    return err;
+}
+
+NotificationEngine::EventListCache::Entry * NotificationEngine::EventListCache::Fill(LoggingManagement & aLogger,
+                                                                                     ImportanceType aImportance,
+                                                                                     event_id_t aStartingEventID)
+{
+    WEAVE_ERROR err;
+    Entry * entry          = &mEntries[aImportance - kImportanceType_First];
+    event_id_t nextEventID = aStartingEventID;
+    size_t numEvents       = 0;
+    TLVWriter writer;
+    TLVReader reader;
+
+    entry->mDataLen = 0;
+
+    writer.Init(entry->mData, sizeof(entry->mData));
+
+    err = aLogger.FetchEventsSince(writer, aImportance, nextEventID);
+    VerifyOrExit(err == WEAVE_NO_ERROR || err == WEAVE_END_OF_TLV || err == WEAVE_ERROR_TLV_UNDERRUN ||
+                     err == WEAVE_ERROR_BUFFER_TOO_SMALL || err == WEAVE_ERROR_NO_MEMORY,
+                 entry = NULL);
+    VerifyOrExit(nextEventID > aStartingEventID, entry = NULL);
+
+    // Only consecutive runs of events can be handed out in part; externally stored events are fetched directly.
+    reader.Init(entry->mData, writer.GetLengthWritten());
+    err = nl::Weave::TLV::Utilities::Count(reader, numEvents, false);
+    VerifyOrExit(err == WEAVE_NO_ERROR && numEvents == nextEventID - aStartingEventID, entry = NULL);
+
+    entry->mStartingEventID = aStartingEventID;
+    entry->mDataLen         = static_cast<uint16_t>(writer.GetLengthWritten());
+
+exit:
+    return entry;
+}
+
+void NotificationEngine::EventListCache::Clear()
+{
+    for (size_t i = 0; i < ArraySize(mEntries); i++)
+    {
+        mEntries[i].mDataLen = 0;
+    }
+}
+#endif // WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+
 WEAVE_ERROR NotificationEngine::Init()
 {
     mCurSubscriptionHandlerIdx = 0;
     mCurTraitInstanceIdx       = 0;
     mNumNotifiesInFlight       = 0;
 
+#if WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+    mDataElementCache.Clear();
+#endif
+
+#if WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+    mEventListCache.Clear();
+#endif
+
     return WEAVE_NO_ERROR;
 }
 
@@ -1052,6 +1571,10 @@ WEAVE_ERROR NotificationEngine::DeleteKey(TraitDataSource * aDataSource, Propert
 
     isLocked = true;
 
+#if WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+    mDataElementCache.Invalidate(aDataSource);
+#endif
+
     err = mGraphSolver.DeleteKey(dataHandle, aPropertyHandle);
     SuccessOrExit(err);
 
@@ -1080,6 +1603,10 @@ WEAVE_ERROR NotificationEngine::SetDirty(TraitDataSource * aDataSource, Property
 
     isLocked = true;
 
+#if WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+    mDataElementCache.Invalidate(aDataSource);
+#endif
+
     err = mGraphSolver.SetDirty(dataHandle, aPropertyHandle);
     SuccessOrExit(err);
 
@@ -1117,6 +1644,103 @@ exit:
     return err;
 }
 
+/**
+ * Write out as much of a priming snapshot of a trait instance as fits in the request, starting at the snapshot cursor of the
+ * subscription handler. The snapshot is started over if the data source changed since the previous part was written. aPacketFull
+ * is set if the snapshot did not complete; the parts written so far are kept in the request and the dirty flag of the trait
+ * instance is only cleared once the snapshot is complete.
+ */
+WEAVE_ERROR NotificationEngine::RetrieveTraitInstanceSnapshot(SubscriptionHandler * aSubHandler,
+                                                              SubscriptionHandler::TraitInstanceInfo * aTraitInfo,
+                                                              NotifyRequestBuilder * aBuilder, bool * aPacketFull)
+{
+    WEAVE_ERROR err                              = WEAVE_NO_ERROR;
+    SubscriptionHandler::SnapshotCursor & cursor = aSubHandler->mSnapshotCursor;
+    TraitDataSource * dataSource;
+    const TraitSchemaEngine * schemaEngine;
+    TLVWriter checkpoint;
+
+    *aPacketFull = false;
+
+    err = SubscriptionEngine::GetInstance()->mPublisherCatalog->Locate(aTraitInfo->mTraitDataHandle, &dataSource);
+    SuccessOrExit(err);
+
+    schemaEngine = dataSource->GetSchemaEngine();
+
+    if (!cursor.IsActive(aTraitInfo->mTraitDataHandle) || cursor.mVersion != dataSource->GetVersion())
+    {
+        WeaveLogDetail(DataManagement, "<NE:Run> T%u snapshot %s", aSubHandler->mCurProcessingTraitInstanceIdx,
+                       cursor.IsActive(aTraitInfo->mTraitDataHandle) ? "restarted" : "started");
+
+        cursor.mTraitDataHandle      = aTraitInfo->mTraitDataHandle;
+        cursor.mPropertyHandle       = schemaEngine->GetFirstChild(kRootPropertyPathHandle);
+        cursor.mDictionaryItemHandle = kNullPropertyPathHandle;
+        cursor.mVersion              = dataSource->GetVersion();
+    }
+
+    while (!IsNullPropertyPathHandle(cursor.mPropertyHandle))
+    {
+        PropertyPathHandle nextHandle = schemaEngine->GetNextChild(kRootPropertyPathHandle, cursor.mPropertyHandle);
+        bool isLast                   = IsNullPropertyPathHandle(nextHandle);
+
+        aBuilder->Checkpoint(checkpoint);
+
+#if TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
+        if (schemaEngine->IsDictionary(cursor.mPropertyHandle))
+        {
+            PropertyPathHandle itemHandle = cursor.mDictionaryItemHandle;
+
+            err = aBuilder->WriteDictionaryDataElement(aTraitInfo->mTraitDataHandle, cursor.mPropertyHandle,
+                                                       aTraitInfo->mRequestedVersion, itemHandle, true);
+
+            if ((err == WEAVE_NO_ERROR) && isLast && IsNullPropertyPathHandle(itemHandle))
+            {
+                // This element completes the snapshot and must not be marked partial. Without the flag it is only smaller, so
+                // it still carries all of the remaining items.
+                aBuilder->Rollback(checkpoint);
+                itemHandle = cursor.mDictionaryItemHandle;
+
+                err = aBuilder->WriteDictionaryDataElement(aTraitInfo->mTraitDataHandle, cursor.mPropertyHandle,
+                                                           aTraitInfo->mRequestedVersion, itemHandle, false);
+            }
+            SuccessOrExit(err);
+
+            if (!IsNullPropertyPathHandle(itemHandle))
+            {
+                cursor.mDictionaryItemHandle = itemHandle;
+                *aPacketFull                 = true;
+                ExitNow();
+            }
+        }
+        else
+#endif // TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
+        {
+            PropertyPathHandle mergeHandle = cursor.mPropertyHandle;
+
+            err = aBuilder->WriteDataElement(aTraitInfo->mTraitDataHandle, kRootPropertyPathHandle, aTraitInfo->mRequestedVersion,
+                                             &mergeHandle, 1, NULL, 0, !isLast);
+            SuccessOrExit(err);
+        }
+
+        cursor.mPropertyHandle       = nextHandle;
+        cursor.mDictionaryItemHandle = kNullPropertyPathHandle;
+    }
+
+    // The snapshot is complete.
+    cursor.Reset();
+    aTraitInfo->ClearDirty();
+
+exit:
+    if ((err == WEAVE_ERROR_BUFFER_TOO_SMALL) || (err == WEAVE_ERROR_NO_MEMORY))
+    {
+        aBuilder->Rollback(checkpoint);
+        *aPacketFull = true;
+        err          = WEAVE_NO_ERROR;
+    }
+
+    return err;
+}
+
 WEAVE_ERROR NotificationEngine::SendNotify(PacketBuffer * aBuffer, SubscriptionHandler * aSubHandler)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
@@ -1124,21 +1748,23 @@ WEAVE_ERROR NotificationEngine::SendNotify(PacketBuffer * aBuffer, SubscriptionH
     err = aSubHandler->SendNotificationRequest(aBuffer);
     SuccessOrExit(err);
 
-    // We can only have 1 notify in flight for any given subscription - increment and break out.
+    // The subscription's own pipeline depth is enforced by SubscriptionHandler::IsNotifiable().
     mNumNotifiesInFlight++;
 
 exit:
     return err;
 }
 
-void NotificationEngine::OnNotifyConfirm(SubscriptionHandler * aSubHandler, bool aNotifyDelivered)
+void NotificationEngine::OnNotifyConfirm(SubscriptionHandler * aSubHandler, uint8_t aNumNotifies,
+                                         const event_id_t * aDeliveredEvents)
 {
-    VerifyOrDie(mNumNotifiesInFlight > 0);
+    VerifyOrDie(mNumNotifiesInFlight >= aNumNotifies);
 
-    WeaveLogDetail(DataManagement, "<NE> OnNotifyConfirm: NumNotifies-- = %d", mNumNotifiesInFlight - 1);
-    mNumNotifiesInFlight--;
+    WeaveLogDetail(DataManagement, "<NE> OnNotifyConfirm: NumNotifies -= %u = %d", aNumNotifies,
+                   mNumNotifiesInFlight - aNumNotifies);
+    mNumNotifiesInFlight -= aNumNotifies;
 
-    if (aNotifyDelivered && aSubHandler->mSubscribeToAllEvents)
+    if ((aDeliveredEvents != NULL) && aSubHandler->mSubscribeToAllEvents)
     {
         LoggingManagement & logger = LoggingManagement::GetInstance();
 
@@ -1146,7 +1772,7 @@ void NotificationEngine::OnNotifyConfirm(SubscriptionHandler * aSubHandler, bool
         {
             size_t i                  = static_cast<size_t>(iterator - kImportanceType_First);
             ImportanceType importance = (ImportanceType) iterator;
-            logger.NotifyEventsDelivered(importance, aSubHandler->mSelfVendedEvents[i] - 1, aSubHandler->GetPeerNodeId());
+            logger.NotifyEventsDelivered(importance, aDeliveredEvents[i] - 1, aSubHandler->GetPeerNodeId());
         }
     }
 
@@ -1266,8 +1892,13 @@ WEAVE_ERROR NotificationEngine::BuildSingleNotifyRequestEventList(SubscriptionHa
         while (aSubHandler->mCurrentImportance != kImportanceType_Invalid)
         {
             size_t i = static_cast<size_t>(aSubHandler->mCurrentImportance - kImportanceType_First);
-            err      = logger.FetchEventsSince(*aNotifyRequest.GetWriter(), aSubHandler->mCurrentImportance,
+#if WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+            err = mEventListCache.FetchEventsSince(*aNotifyRequest.GetWriter(), aSubHandler->mCurrentImportance,
+                                                   aSubHandler->mSelfVendedEvents[i]);
+#else
+            err = logger.FetchEventsSince(*aNotifyRequest.GetWriter(), aSubHandler->mCurrentImportance,
                                           aSubHandler->mSelfVendedEvents[i]);
+#endif
 
             if ((err == WEAVE_END_OF_TLV) || (err == WEAVE_ERROR_TLV_UNDERRUN) || (err == WEAVE_NO_ERROR))
             {
@@ -1403,7 +2034,15 @@ WEAVE_ERROR NotificationEngine::BuildSingleNotifyRequestDataList(SubscriptionHan
 
     while (aSubHandler->mCurProcessingTraitInstanceIdx < aSubHandler->GetNumTraitInstances())
     {
-        if (traitInfo->IsDirty())
+        if (traitInfo->IsDirty() && aSubHandler->IsTraitNotifyInFlight(traitInfo))
+        {
+            // A pipelined notify carrying this trait instance is still unconfirmed. Hold its new changes back until that notify
+            // is retired, so that the subscriber cannot apply two versions of the trait out of order.
+            aIsSubscriptionClean = false;
+
+            WeaveLogDetail(DataManagement, "<NE:Run> T%u is dirty but in flight", aSubHandler->mCurProcessingTraitInstanceIdx);
+        }
+        else if (traitInfo->IsDirty())
         {
             aIsSubscriptionClean = false;
             TLVWriter writerCpy;
@@ -1417,12 +2056,35 @@ WEAVE_ERROR NotificationEngine::BuildSingleNotifyRequestDataList(SubscriptionHan
             // Make a back-up of the writer so that we can rewind back if the next retrieval fails due to the packet getting full.
             aNotifyRequest.Checkpoint(writerCpy);
 
-            // Retrieve data for this trait instance and clear its dirty flag.
-            err = RetrieveTraitInstanceData(aSubHandler, traitInfo, &aNotifyRequest, &packetIsFull);
+            // Retrieve data for this trait instance and clear its dirty flag. A priming snapshot that did not fit in the previous
+            // notify resumes where that notify stopped.
+            if (aSubHandler->mSnapshotCursor.IsActive(traitInfo->mTraitDataHandle))
+            {
+                err = RetrieveTraitInstanceSnapshot(aSubHandler, traitInfo, &aNotifyRequest, &packetIsFull);
+            }
+            else
+            {
+                err = RetrieveTraitInstanceData(aSubHandler, traitInfo, &aNotifyRequest, &packetIsFull);
+
+                // A primed trait instance that does not fit in a notify of its own is streamed across several notifies.
+                if ((err == WEAVE_NO_ERROR) && packetIsFull && !aNeWriteInProgress && aSubHandler->IsSubscribing())
+                {
+                    aNotifyRequest.Rollback(writerCpy);
+                    err = RetrieveTraitInstanceSnapshot(aSubHandler, traitInfo, &aNotifyRequest, &packetIsFull);
+                }
+            }
             VerifyOrExit(err == WEAVE_NO_ERROR,
                          WeaveLogError(DataManagement, "<NE:Run> Error retrieving data from trait, aborting"));
 
-            if (packetIsFull)
+            if (packetIsFull && (aNotifyRequest.GetWriter()->GetLengthWritten() != writerCpy.GetLengthWritten()))
+            {
+                // Part of a snapshot was written; the rest goes out in the next notify.
+                WeaveLogDetail(DataManagement, "<NE:Run> Packet got full, snapshot continues in the next notify");
+                aNeWriteInProgress    = true;
+                traitInfo->mNotifySeq = aSubHandler->mNextNotifySeq;
+                break;
+            }
+            else if (packetIsFull)
             {
                 WeaveLogDetail(DataManagement, "<NE:Run> Packet got full!");
                 // Restore the writer
@@ -1432,6 +2094,7 @@ WEAVE_ERROR NotificationEngine::BuildSingleNotifyRequestDataList(SubscriptionHan
                 {
                     WeaveLogDetail(DataManagement, "<NE:Run> trait property is too big so that it fails to fit in the packet");
                     traitInfo->ClearDirty();
+                    aSubHandler->mSnapshotCursor.Reset();
                 }
                 else
                 {
@@ -1441,6 +2104,7 @@ WEAVE_ERROR NotificationEngine::BuildSingleNotifyRequestDataList(SubscriptionHan
             else
             {
                 aNeWriteInProgress = true;
+                traitInfo->mNotifySeq = aSubHandler->mNextNotifySeq;
             }
         }
 
@@ -1704,10 +2368,14 @@ void NotificationEngine::Run()
     WEAVE_ERROR err                  = WEAVE_NO_ERROR;
     uint32_t numSubscriptionsHandled = 0;
     SubscriptionEngine * subEngine   = SubscriptionEngine::GetInstance();
-    SubscriptionHandler * subHandler = subEngine->mHandlers + mCurSubscriptionHandlerIdx;
+    SubscriptionHandler * subHandler = NULL;
     bool subscriptionHandled, isSubscriptionClean;
-    bool isClean  = true;
-    bool isLocked = false;
+    bool isClean         = true;
+    bool isLocked        = false;
+    bool runAgain        = false;
+    uint64_t nowMsec     = System::Layer::GetClock_MonotonicMS();
+    uint32_t holdMsec    = 0;
+    uint32_t minHoldMsec = UINT32_MAX;
 
     // Lock before attempting to modify any of the shared data structures.
     err = subEngine->Lock();
@@ -1715,10 +2383,23 @@ void NotificationEngine::Run()
 
     isLocked = true;
 
+#if WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+    // Events read out of the log are shared between the subscriptions handled in this run only.
+    mEventListCache.Clear();
+#endif
+
+    // The handler pool may have been resized since the last run.
+    if (mCurSubscriptionHandlerIdx >= subEngine->mHandlerPoolSize)
+    {
+        mCurSubscriptionHandlerIdx = 0;
+    }
+
+    subHandler = subEngine->mHandlers + mCurSubscriptionHandlerIdx;
+
     WeaveLogDetail(DataManagement, "<NE:Run> NotifiesInFlight = %u", mNumNotifiesInFlight);
 
     while ((mNumNotifiesInFlight < WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT) &&
-           (numSubscriptionsHandled < SubscriptionEngine::kMaxNumSubscriptionHandlers))
+           (numSubscriptionsHandled < subEngine->mHandlerPoolSize))
     {
         subscriptionHandled = true;
 
@@ -1729,7 +2410,16 @@ void NotificationEngine::Run()
                            mCurSubscriptionHandlerIdx, subHandler->GetStateStr(), subHandler->GetNumTraitInstances());
         }
 
-        if (subHandler->IsNotifiable())
+        if (subHandler->IsNotifiable() && subHandler->IsNotifyHeld(nowMsec, holdMsec))
+        {
+            WeaveLogDetail(DataManagement, "<NE:Run> Subscription %u held for %u ms", mCurSubscriptionHandlerIdx, holdMsec);
+
+            if (holdMsec < minHoldMsec)
+            {
+                minHoldMsec = holdMsec;
+            }
+        }
+        else if (subHandler->IsNotifiable())
         {
             // This is needed because some error could trigger abort on subscription, which leads to destroy of the handler
             subHandler->_AddRef();
@@ -1754,7 +2444,7 @@ void NotificationEngine::Run()
             numSubscriptionsHandled = 0;
         }
 
-        mCurSubscriptionHandlerIdx = (mCurSubscriptionHandlerIdx + 1) % SubscriptionEngine::kMaxNumSubscriptionHandlers;
+        mCurSubscriptionHandlerIdx = (mCurSubscriptionHandlerIdx + 1) % subEngine->mHandlerPoolSize;
         subHandler                 = subEngine->mHandlers + mCurSubscriptionHandlerIdx;
     }
 
@@ -1763,7 +2453,7 @@ void NotificationEngine::Run()
 
     // We only wipe our granular dirty stores if all the subscriptions are clean. To do so, we iterate over
     // all of them and check each of their dirty flags.
-    for (int i = 0; i < SubscriptionEngine::kMaxNumSubscriptionHandlers; i++)
+    for (int i = 0; i < subEngine->mHandlerPoolSize; i++)
     {
         if (subHandler->IsActive())
         {
@@ -1790,11 +2480,43 @@ void NotificationEngine::Run()
         mGraphSolver.ClearDirty();
     }
 
+    // Come back once the earliest held subscription is due.
+    if (minHoldMsec != UINT32_MAX)
+    {
+        err = subEngine->GetExchangeManager()->MessageLayer->SystemLayer->StartTimer(minHoldMsec, OnCoalescingTimer, this);
+        if (err != WEAVE_NO_ERROR)
+        {
+            // Nothing would bring the held subscriptions back, so release their changes and notify them right away.
+            WeaveLogError(DataManagement, "<NE:Run> Error arming coalescing timer, err = %d; releasing held notifies", err);
+
+            subHandler = subEngine->mHandlers;
+            for (int i = 0; i < subEngine->mHandlerPoolSize; i++)
+            {
+                subHandler->mHasHeldChanges = false;
+                subHandler++;
+            }
+
+            runAgain = true;
+        }
+    }
+
 exit:
     if (isLocked)
     {
         subEngine->Unlock();
     }
 
+    if (runAgain)
+    {
+        Run();
+    }
+
     return;
 }
+
+void NotificationEngine::OnCoalescingTimer(System::Layer * aSystemLayer, void * aAppState, System::Error aError)
+{
+    NotificationEngine * const pEngine = reinterpret_cast<NotificationEngine *>(aAppState);
+
+    pEngine->Run();
+}
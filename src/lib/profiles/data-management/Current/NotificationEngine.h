@@ -213,7 +213,7 @@ public:
         /**
          * Given a trait path, write out the data element associated with that path. The caller can also optionally pass in a handle
          * set allows for leveraging the merge operation with a narrower set of immediate child nodes of the parent property path
-         * handle.
+         * handle. A change spanning several data elements is expressed by marking all but the last of them as partial.
          *
          * @retval #WEAVE_NO_ERROR On success.
          * @retval other           Unable to retrieve and write the data element.
@@ -221,7 +221,22 @@ public:
         WEAVE_ERROR WriteDataElement(TraitDataHandle aTraitDataHandle, PropertyPathHandle aPropertyPathHandle,
                                      SchemaVersion aSchemaVersion, PropertyPathHandle * aMergeDataHandleSet,
                                      uint32_t aNumMergeDataHandles, PropertyPathHandle * aDeleteHandleSet,
-                                     uint32_t aNumDeleteHandles);
+                                     uint32_t aNumDeleteHandles, bool aPartialChange = false);
+
+#if TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
+        /**
+         * Write out a data element carrying the items of a dictionary, starting at aItemToStartFrom, that fit in the request.
+         * Starting at kNullPropertyPathHandle, the element replaces the dictionary as a whole; otherwise, the element merges
+         * the items into the dictionary. On return, aItemToStartFrom is the first item left out, or kNullPropertyPathHandle if
+         * the dictionary was written out completely.
+         *
+         * @retval #WEAVE_NO_ERROR On success.
+         * @retval other           Unable to retrieve and write the data element.
+         */
+        WEAVE_ERROR WriteDictionaryDataElement(TraitDataHandle aTraitDataHandle, PropertyPathHandle aDictionaryHandle,
+                                               SchemaVersion aSchemaVersion, PropertyPathHandle & aItemToStartFrom,
+                                               bool aPartialChange);
+#endif // TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
 
         /**
          * Checkpoint the request state into a TLVWriter
@@ -243,6 +258,8 @@ public:
 
         TLV::TLVWriter * GetWriter(void) { return mWriter; }
 
+        SubscriptionHandler * GetSubscriptionHandler(void) { return mSub; }
+
         /**
          * The main state transition function. The function takes the desired state (i.e., the phase of the notify request builder
          * that we would like to reach), and transitions the request into that state. If the desired state is the same as the
@@ -262,6 +279,15 @@ public:
         WEAVE_ERROR MoveToState(NotifyRequestBuilderState aDesiredState);
 
     private:
+        static WEAVE_ERROR EncodeDataElementHeader(TLV::TLVWriter & aWriter, TraitDataSource * aDataSource,
+                                                   TraitDataHandle aTraitDataHandle, PropertyPathHandle aPropertyPathHandle,
+                                                   SchemaVersion aSchemaVersion, bool aPartialChange);
+        static WEAVE_ERROR EncodeDataElement(TLV::TLVWriter & aWriter, TraitDataSource * aDataSource,
+                                             TraitDataHandle aTraitDataHandle, PropertyPathHandle aPropertyPathHandle,
+                                             SchemaVersion aSchemaVersion, PropertyPathHandle * aMergeDataHandleSet,
+                                             uint32_t aNumMergeDataHandles, PropertyPathHandle * aDeleteHandleSet,
+                                             uint32_t aNumDeleteHandles, bool aPartialChange, bool & aRetrievingData);
+
         TLV::TLVWriter * mWriter;
         NotifyRequestBuilderState mState;
         PacketBuffer * mBuf;
@@ -323,6 +349,9 @@ public:
      *         instance as dirty. In addition, if it runs out of space in the merge handle set, it will degrade to including all
      *         child trees of the LCA'ed node.
      *
+     *         For subscriptions in delta mode, when the LCA data element would carry unchanged data, the solver instead emits one
+     *         data element per dirty handle as a single partial change, provided that encoding is the smaller of the two.
+     *
      */
     class IntermediateGraphSolver
     {
@@ -360,6 +389,9 @@ public:
         static void ClearTraitInstanceDirty(void * aDataSource, TraitDataHandle aDataHandle, void * aContext);
         PropertyPathHandle GetNextCandidateHandle(uint32_t & aChangeStoreCursor, TraitDataHandle aTargetDataHandle,
                                                   bool & aCandidateHandleIsDelete);
+        WEAVE_ERROR WriteDeltaDataElements(NotifyRequestBuilder * aBuilder, TraitDataHandle aTraitDataHandle,
+                                           SchemaVersion aSchemaVersion, PropertyPathHandle aCommonHandle,
+                                           PropertyPathHandle * aMergeHandleSet, int32_t aNumMergeHandles, bool & aWritten);
 
         Store mDirtyStore;
 
@@ -368,6 +400,106 @@ public:
 #endif
     };
 
+#if WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+    /*
+     *  @class DataElementCache
+     *
+     *  @brief A small cache of encoded data elements, keyed by the trait instance, its data version and the set of property
+     *         handles that were written. Subscribers to the same trait instance typically receive the same data element for a
+     *         given change; the cache allows it to be encoded once and copied into each of their notifies.
+     *
+     *         Entries for a trait instance are invalidated when it is marked dirty. Entries are replaced in round-robin order.
+     *         While the cache is disabled, Find and Allocate return NULL and every data element is encoded directly.
+     */
+    class DataElementCache
+    {
+    public:
+        struct Entry
+        {
+            TraitDataSource * mDataSource;
+            TraitDataHandle mTraitDataHandle;
+            PropertyPathHandle mPropertyPathHandle;
+            SchemaVersion mSchemaVersion;
+            uint64_t mVersion;
+            uint16_t mNumMergeDataHandles;
+            uint16_t mNumDeleteHandles;
+            PropertyPathHandle mMergeDataHandleSet[WDM_PUBLISHER_INTERMEDIATE_SOLVER_MAX_MERGE_HANDLE_SET];
+            PropertyPathHandle mDeleteHandleSet[WDM_PUBLISHER_INTERMEDIATE_SOLVER_MAX_MERGE_HANDLE_SET];
+            bool mPartialChange;
+            uint16_t mDataLen;
+            uint8_t mData[WDM_PUBLISHER_DATA_ELEMENT_CACHE_ENTRY_SIZE];
+        };
+
+        DataElementCache(void);
+
+        Entry * Find(TraitDataSource * aDataSource, TraitDataHandle aTraitDataHandle, PropertyPathHandle aPropertyPathHandle,
+                     SchemaVersion aSchemaVersion, const PropertyPathHandle * aMergeDataHandleSet, uint32_t aNumMergeDataHandles,
+                     const PropertyPathHandle * aDeleteHandleSet, uint32_t aNumDeleteHandles, bool aPartialChange);
+        Entry * Allocate(TraitDataSource * aDataSource, TraitDataHandle aTraitDataHandle, PropertyPathHandle aPropertyPathHandle,
+                         SchemaVersion aSchemaVersion, const PropertyPathHandle * aMergeDataHandleSet,
+                         uint32_t aNumMergeDataHandles, const PropertyPathHandle * aDeleteHandleSet, uint32_t aNumDeleteHandles,
+                         bool aPartialChange);
+        void Invalidate(TraitDataSource * aDataSource);
+        void Release(Entry * aEntry);
+        void Clear(void);
+        void SetEnabled(bool aEnabled);
+        uint32_t GetNumHits(void) const { return mNumHits; }
+
+    private:
+        friend class TestTdm;
+
+        Entry mEntries[WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE];
+        uint32_t mNextVictim;
+        uint32_t mNumHits;
+        bool mEnabled;
+    };
+#endif // WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+
+#if WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+    /*
+     *  @class EventListCache
+     *
+     *  @brief Holds, for each importance level, the events last read out of the log, encoded as they are written into an
+     *         EventList, along with the ID of the first of them. Subscriptions that are caught up to the same event are
+     *         served from the cache rather than each walking the log buffers anew.
+     *
+     *         The cache is cleared at the start of every run of the notification engine. Within a run, events are only
+     *         ever appended to the log, so a fragment stays valid for as long as its first event has not been evicted.
+     */
+    class EventListCache
+    {
+    public:
+        EventListCache(void);
+
+        /**
+         * Fetch events of the given importance since the given event ID into the writer, as
+         * LoggingManagement::FetchEventsSince does, reusing the fragment read for a previous caller if it starts at the same
+         * event.
+         *
+         * @param[in] ioWriter      The writer to use for event storage.
+         * @param[in] aImportance   The importance of the events to be fetched.
+         * @param[inout] ioEventID  On input, the ID of the first event to fetch. On completion, the ID of the event following
+         *                          the last event fetched.
+         *
+         * @retval See LoggingManagement::FetchEventsSince.
+         */
+        WEAVE_ERROR FetchEventsSince(nl::Weave::TLV::TLVWriter & ioWriter, ImportanceType aImportance, event_id_t & ioEventID);
+        void Clear(void);
+
+    private:
+        struct Entry
+        {
+            event_id_t mStartingEventID;
+            uint16_t mDataLen;
+            uint8_t mData[WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE];
+        };
+
+        Entry * Fill(LoggingManagement & aLogger, ImportanceType aImportance, event_id_t aStartingEventID);
+
+        Entry mEntries[kImportanceType_Last - kImportanceType_First + 1];
+    };
+#endif // WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+
 private:
     friend class SubscriptionHandler;
     friend class UpdateClient;
@@ -375,13 +507,15 @@ private:
     friend class TestWdm;
 
     /**
-     * Should be invoked when the device receives a NotifyConfirm, or when the Notify request times out.
-     * This allows the engine to do some clean-up.
+     * Should be invoked when notifies of a subscription are retired, either because the device received their NotifyConfirms,
+     * or because they were abandoned when the subscription was torn down. This allows the engine to do some clean-up.
      *
-     * @retval #WEAVE_NO_ERROR On success.
-     * @retval other           Was unable to retrieve data and write it into the writer.
+     * @param[in] aSubHandler       The subscription whose notifies were retired.
+     * @param[in] aNumNotifies      The number of notifies retired.
+     * @param[in] aDeliveredEvents  The self-vended event IDs as of the last retired notify, if the notifies were delivered;
+     *                              NULL otherwise.
      */
-    void OnNotifyConfirm(SubscriptionHandler * aSubHandler, bool aNotifyDelivered);
+    void OnNotifyConfirm(SubscriptionHandler * aSubHandler, uint8_t aNumNotifies, const event_id_t * aDeliveredEvents);
 
     WEAVE_ERROR BuildSingleNotifyRequestDataList(SubscriptionHandler * aSubHandler, NotifyRequestBuilder & aNotifyRequest,
                                                  bool & isSubscriptionClean, bool & aNeWriteInProgress);
@@ -392,10 +526,15 @@ private:
 
     WEAVE_ERROR RetrieveTraitInstanceData(SubscriptionHandler * aSubHandler, SubscriptionHandler::TraitInstanceInfo * aTraitInfo,
                                           NotifyRequestBuilder * aBuilder, bool * aPacketFull);
+    WEAVE_ERROR RetrieveTraitInstanceSnapshot(SubscriptionHandler * aSubHandler,
+                                              SubscriptionHandler::TraitInstanceInfo * aTraitInfo, NotifyRequestBuilder * aBuilder,
+                                              bool * aPacketFull);
     WEAVE_ERROR SendNotify(PacketBuffer * aBuf, SubscriptionHandler * aSubHandler);
 
     WEAVE_ERROR SendNotifyRequest();
 
+    static void OnCoalescingTimer(System::Layer * aSystemLayer, void * aAppState, System::Error aError);
+
 #if WDM_ENABLE_SUBSCRIPTIONLESS_NOTIFICATION
     WEAVE_ERROR BuildSubscriptionlessNotification(PacketBuffer *msgBuf, uint32_t maxPayloadSize, TraitPath *aPathList,
                                                   uint16_t aPathListSize);
@@ -405,6 +544,12 @@ private:
     uint32_t mNumNotifiesInFlight;
     nl::Weave::TLV::TLVType mOuterContainerType;
     WEAVE_CONFIG_WDM_PUBLISHER_GRAPH_SOLVER mGraphSolver;
+#if WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+    DataElementCache mDataElementCache;
+#endif
+#if WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+    EventListCache mEventListCache;
+#endif
 };
 
 }; // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
@@ -96,7 +96,11 @@ void SubscriptionClient::Reset(void)
     mUpdateRequestContext.mItemInProgress = 0;
     mUpdateRequestContext.mNextDictionaryElementPathHandle = kNullPropertyPathHandle;
     mPendingSetState = kPendingSetEmpty;
+#if WDM_UPDATE_PENDING_SET_INDEX_SIZE > 0
+    mPendingUpdateSet.Init(mPendingStore, ArraySize(mPendingStore), mPendingIndex, ArraySize(mPendingIndex));
+#else
     mPendingUpdateSet.Init(mPendingStore, ArraySize(mPendingStore));
+#endif
     mInProgressUpdateList.Init(mInProgressStore, ArraySize(mInProgressStore));
 #endif // WEAVE_CONFIG_ENABLE_WDM_UPDATE
 
@@ -2378,6 +2382,7 @@ void SubscriptionClient::OnUpdateConfirm(WEAVE_ERROR aReason, nl::Weave::Profile
     uint64_t versionCreated = 0;
     bool IsVersionListPresent = false;
     bool IsStatusListPresent = false;
+    bool isPackedWithPrevious = false;
     nl::Weave::TLV::TLVReader reader;
     uint32_t profileID;
     uint16_t statusCode;
@@ -2477,7 +2482,10 @@ void SubscriptionClient::OnUpdateConfirm(WEAVE_ERROR aReason, nl::Weave::Profile
     {
         VerifyOrDie(mInProgressUpdateList.IsItemValid(j));
 
-        if (IsVersionListPresent)
+        // Paths packed in the DataElement of the previous path share its version and status.
+        isPackedWithPrevious = mInProgressUpdateList.AreFlagsSet(j, kFlag_PackedWithPrevious);
+
+        if (IsVersionListPresent && !isPackedWithPrevious)
         {
             err = versionList.Next();
             SuccessOrExit(err);
@@ -2486,7 +2494,7 @@ void SubscriptionClient::OnUpdateConfirm(WEAVE_ERROR aReason, nl::Weave::Profile
             SuccessOrExit(err);
         }
 
-        if ((! wholeRequestSucceeded) && IsStatusListPresent)
+        if ((! wholeRequestSucceeded) && IsStatusListPresent && !isPackedWithPrevious)
         {
             err = statusList.Next();
 
@@ -565,12 +565,19 @@ private:
                                   DataElement; the application is notified about it
                                   only if the update fails.
                                   */
+        kFlag_PackedWithPrevious = 0x10, /**< The path was encoded in the same DataElement as
+                                           the previous one, and shares its status and version
+                                           in the UpdateResponse.
+                                           */
 
     };
 
     PendingSetState mPendingSetState;
     TraitPathStore mPendingUpdateSet;
     TraitPathStore::Record mPendingStore[WDM_UPDATE_MAX_ITEMS_IN_TRAIT_DIRTY_PATH_STORE];
+#if WDM_UPDATE_PENDING_SET_INDEX_SIZE > 0
+    TraitPathStore::IndexEntry mPendingIndex[WDM_UPDATE_PENDING_SET_INDEX_SIZE];
+#endif
 
     TraitPathStore mInProgressUpdateList;
     TraitPathStore::Record mInProgressStore[WDM_UPDATE_MAX_ITEMS_IN_TRAIT_DIRTY_PATH_STORE];
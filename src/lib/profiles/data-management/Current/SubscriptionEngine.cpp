@@ -37,6 +37,9 @@
 #include <Weave/Support/WeaveFaultInjection.h>
 #include <SystemLayer/SystemStats.h>
 
+#include <new>
+#include <stdlib.h>
+
 #if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
 
 namespace nl {
@@ -44,7 +47,23 @@ namespace Weave {
 namespace Profiles {
 namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current) {
 
-SubscriptionEngine::SubscriptionEngine() { }
+SubscriptionEngine::SubscriptionEngine()
+{
+#if WDM_ENABLE_SUBSCRIPTION_PUBLISHER && WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+    mHandlers             = NULL;
+    mHandlerPoolSize      = 0;
+    mTraitInfoPool        = NULL;
+    mTraitInfoPoolSize    = 0;
+    mMaxTraitInfoPoolSize = 0;
+#endif // WDM_ENABLE_SUBSCRIPTION_PUBLISHER && WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+}
+
+SubscriptionEngine::~SubscriptionEngine()
+{
+#if WDM_ENABLE_SUBSCRIPTION_PUBLISHER && WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+    FreePublisherPools();
+#endif // WDM_ENABLE_SUBSCRIPTION_PUBLISHER && WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+}
 
 void SubscriptionEngine::SetEventCallback(void * const aAppState, const EventCallback aEventCallback)
 {
@@ -90,18 +109,47 @@ WEAVE_ERROR SubscriptionEngine::Init(nl::Weave::WeaveExchangeManager * const apE
     err = mNotificationEngine.Init();
     SuccessOrExit(err);
 
-    for (size_t i = 0; i < kMaxNumSubscriptionHandlers; ++i)
+#if WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+    if (mHandlers == NULL)
+    {
+        mHandlers = static_cast<SubscriptionHandler *>(malloc(kMaxNumSubscriptionHandlers * sizeof(SubscriptionHandler)));
+        VerifyOrExit(mHandlers != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        for (size_t i = 0; i < kMaxNumSubscriptionHandlers; ++i)
+        {
+            new (&mHandlers[i]) SubscriptionHandler();
+        }
+
+        mHandlerPoolSize = kMaxNumSubscriptionHandlers;
+    }
+
+    if (mTraitInfoPool == NULL)
+    {
+        mTraitInfoPool = static_cast<SubscriptionHandler::TraitInstanceInfo *>(
+            malloc(kMaxNumPathGroups * sizeof(SubscriptionHandler::TraitInstanceInfo)));
+        VerifyOrExit(mTraitInfoPool != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        mTraitInfoPoolSize    = kMaxNumPathGroups;
+        mMaxTraitInfoPoolSize = kMaxNumPathGroups;
+    }
+#else
+    mHandlerPoolSize      = kMaxNumSubscriptionHandlers;
+    mTraitInfoPoolSize    = kMaxNumPathGroups;
+    mMaxTraitInfoPoolSize = kMaxNumPathGroups;
+#endif // WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+
+    for (size_t i = 0; i < mHandlerPoolSize; ++i)
     {
         mHandlers[i].InitAsFree();
     }
 
+    ResetTraitInfoPool();
+
     // erase everything
     DisablePublisher();
 
 #endif // WDM_ENABLE_SUBSCRIPTION_PUBLISHER
 
-    mNumTraitInfosInPool = 0;
-
 exit:
     WeaveLogFunctError(err);
 
@@ -126,7 +174,7 @@ void SubscriptionEngine::LogSubscriptionFreed(void) const
 #endif // #if WDM_ENABLE_SUBSCRIPTION_CLIENT
 
 #if WDM_ENABLE_SUBSCRIPTION_PUBLISHER
-    for (int i = 0; i < kMaxNumSubscriptionHandlers; ++i)
+    for (int i = 0; i < mHandlerPoolSize; ++i)
     {
         if (SubscriptionHandler::kState_Free != mHandlers[i].mCurrentState)
         {
@@ -188,7 +236,7 @@ void SubscriptionEngine::OnCancelRequest(nl::Weave::ExchangeContext * aEC, const
 #endif // #if WDM_ENABLE_SUBSCRIPTION_CLIENT
 
 #if WDM_ENABLE_SUBSCRIPTION_PUBLISHER
-    for (size_t i = 0; i < kMaxNumSubscriptionHandlers; ++i)
+    for (size_t i = 0; i < pEngine->mHandlerPoolSize; ++i)
     {
         if ((pEngine->mHandlers[i].mCurrentState >= SubscriptionHandler::kState_SubscriptionInfoValid_Begin) &&
             (pEngine->mHandlers[i].mCurrentState <= SubscriptionHandler::kState_SubscriptionInfoValid_End))
@@ -871,7 +919,7 @@ SubscriptionHandler * SubscriptionEngine::FindHandler(const uint64_t aPeerNodeId
 {
     SubscriptionHandler * result = NULL;
 
-    for (size_t i = 0; i < kMaxNumSubscriptionHandlers; ++i)
+    for (size_t i = 0; i < mHandlerPoolSize; ++i)
     {
         if ((mHandlers[i].mCurrentState >= SubscriptionHandler::kState_SubscriptionInfoValid_Begin) &&
             (mHandlers[i].mCurrentState <= SubscriptionHandler::kState_SubscriptionInfoValid_End))
@@ -891,7 +939,7 @@ WEAVE_ERROR SubscriptionEngine::GetMinEventLogPosition(size_t & outLogPosition)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
 
-    for (size_t subIdx = 0; subIdx < kMaxNumSubscriptionHandlers; ++subIdx)
+    for (size_t subIdx = 0; subIdx < mHandlerPoolSize; ++subIdx)
     {
         const SubscriptionHandler * subHandler = &(mHandlers[subIdx]);
         if (subHandler->mCurrentState == SubscriptionHandler::kState_Free)
@@ -912,7 +960,6 @@ void SubscriptionEngine::ReclaimTraitInfo(SubscriptionHandler * const aHandlerTo
 {
     SubscriptionHandler::TraitInstanceInfo * const traitInfoList = aHandlerToBeReclaimed->mTraitInstanceList;
     const uint16_t numTraitInstances                             = aHandlerToBeReclaimed->mNumTraitInstances;
-    size_t numTraitInstancesToBeAffected;
 
     aHandlerToBeReclaimed->mTraitInstanceList = NULL;
     aHandlerToBeReclaimed->mNumTraitInstances = 0;
@@ -927,40 +974,583 @@ void SubscriptionEngine::ReclaimTraitInfo(SubscriptionHandler * const aHandlerTo
     WeaveLogIfFalse(traitInfoList >= mTraitInfoPool);
     WeaveLogIfFalse(numTraitInstances <= mNumTraitInfosInPool);
 
-    // mPathGroupPool + kMaxNumPathGroups is a pointer which points to the last+1byte of this array
-    // traitInfoList is a pointer to the first trait instance to be released
-    // the result of subtraction is the number of trait instances from traitInfoList to the end of this array
-    numTraitInstancesToBeAffected = (mTraitInfoPool + mNumTraitInfosInPool) - traitInfoList;
+    // Return the trait instances to the free list; the other subscriptions' trait instances are left in place.
+    FreeTraitInfos(static_cast<uint16_t>(traitInfoList - mTraitInfoPool), numTraitInstances);
 
-    // Shrink the traitInfosInPool by the number of trait instances in this subscription.
     mNumTraitInfosInPool -= numTraitInstances;
     SYSTEM_STATS_DECREMENT_BY_N(nl::Weave::System::Stats::kWDM_NumTraits, numTraitInstances);
 
-    if (numTraitInstances == numTraitInstancesToBeAffected)
+exit:
+    WeaveLogDetail(DataManagement, "Number of allocated trait instances: %u", mNumTraitInfosInPool);
+}
+
+/**
+ * Allocate a trait instance at the end of a subscription's trait instance list.
+ *
+ * If the trait instance following the list is in use, the list is moved to a free run large enough to hold it.  If
+ * there is no such run, the pool is compacted, so that the list can grow while any trait instance is free.
+ *
+ * @retval A pointer to the initialized trait instance, or NULL if the pool is exhausted.
+ */
+SubscriptionHandler::TraitInstanceInfo * SubscriptionEngine::NewTraitInfo(SubscriptionHandler * const aHandler)
+{
+    SubscriptionHandler::TraitInstanceInfo * traitInfo = NULL;
+    const uint16_t count                                = aHandler->mNumTraitInstances;
+
+    if (count == 0)
     {
-        WeaveLogDetail(DataManagement, "Releasing the last block of trait instances");
-        ExitNow();
+        // Start the list in the largest free run, leaving room for it to grow.
+        uint16_t start = FindFreeTraitInfoExtent(1);
+        VerifyOrExit(start != kNullTraitInfoIndex, /* no-op */);
+
+        TakeTraitInfos(start, 1);
+
+        aHandler->mTraitInstanceList = &mTraitInfoPool[start];
     }
+    else
+    {
+        uint16_t end = static_cast<uint16_t>((aHandler->mTraitInstanceList - mTraitInfoPool) + count);
 
-    WeaveLogDetail(DataManagement, "Moving %u trait instances forward",
-                   static_cast<unsigned int>(numTraitInstancesToBeAffected - numTraitInstances));
+        if (IsFreeTraitInfoExtent(end))
+        {
+            TakeTraitInfos(end, 1);
+        }
+        else
+        {
+            uint16_t start = FindFreeTraitInfoExtent(count + 1);
 
-    memmove(traitInfoList, traitInfoList + numTraitInstances,
-            sizeof(SubscriptionHandler::TraitInstanceInfo) * (numTraitInstancesToBeAffected - numTraitInstances));
+            if (start != kNullTraitInfoIndex)
+            {
+                WeaveLogDetail(DataManagement, "Moving %u trait instances to %u", count, start);
 
-    for (size_t i = 0; i < kMaxNumSubscriptionHandlers; ++i)
+                TakeTraitInfos(start, count + 1);
+
+                // Growing the pool relocates mTraitInstanceList, so it is only read after the free run is found.
+                memcpy(&mTraitInfoPool[start], aHandler->mTraitInstanceList,
+                       count * sizeof(SubscriptionHandler::TraitInstanceInfo));
+                FreeTraitInfos(static_cast<uint16_t>(aHandler->mTraitInstanceList - mTraitInfoPool), count);
+
+                aHandler->mTraitInstanceList = &mTraitInfoPool[start];
+            }
+            else
+            {
+                // The free trait instances are too fragmented to move the list to, so pack the pool with this list
+                // last, leaving all of them directly after it.
+                CompactTraitInfoPool(aHandler);
+
+                end = static_cast<uint16_t>((aHandler->mTraitInstanceList - mTraitInfoPool) + count);
+                VerifyOrExit(IsFreeTraitInfoExtent(end), /* no-op */);
+
+                TakeTraitInfos(end, 1);
+            }
+        }
+    }
+
+    traitInfo = aHandler->mTraitInstanceList + count;
+    traitInfo->Init();
+
+    ++(aHandler->mNumTraitInstances);
+    ++mNumTraitInfosInPool;
+
+exit:
+    return traitInfo;
+}
+
+void SubscriptionEngine::ResetTraitInfoPool(void)
+{
+    mNumTraitInfosInPool = 0;
+    mTraitInfoFreeList   = kNullTraitInfoIndex;
+
+    if (mTraitInfoPoolSize > 0)
     {
-        SubscriptionHandler * const pHandler = mHandlers + i;
+        FreeTraitInfos(0, mTraitInfoPoolSize);
+    }
+}
+
+SubscriptionEngine::FreeTraitInfoExtent * SubscriptionEngine::GetFreeTraitInfoExtent(uint16_t aIndex)
+{
+    return reinterpret_cast<FreeTraitInfoExtent *>(&mTraitInfoPool[aIndex]);
+}
+
+/**
+ * Check whether a free run of trait instances starts at aIndex, growing the pool if aIndex is its end.
+ */
+bool SubscriptionEngine::IsFreeTraitInfoExtent(uint16_t aIndex)
+{
+    uint16_t extent;
 
-        if ((aHandlerToBeReclaimed != pHandler) && (pHandler->mTraitInstanceList > traitInfoList))
+#if WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+    if (aIndex == mTraitInfoPoolSize)
+    {
+        GrowTraitInfoPool(1);
+    }
+#endif // WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+
+    for (extent = mTraitInfoFreeList; extent != kNullTraitInfoIndex && extent < aIndex; extent = GetFreeTraitInfoExtent(extent)->mNext)
+        ;
+
+    return extent == aIndex;
+}
+
+static void ReverseTraitInfos(SubscriptionHandler::TraitInstanceInfo * aFirst, SubscriptionHandler::TraitInstanceInfo * aLast)
+{
+    while (aFirst < --aLast)
+    {
+        const SubscriptionHandler::TraitInstanceInfo temp = *aFirst;
+
+        *aFirst++ = *aLast;
+        *aLast    = temp;
+    }
+}
+
+/**
+ * Move every subscription's trait instances to the start of the pool, with those of aLast after all the others, and
+ * leave the free trait instances in a single run at the end of the pool.
+ */
+void SubscriptionEngine::CompactTraitInfoPool(SubscriptionHandler * const aLast)
+{
+    SubscriptionHandler::TraitInstanceInfo * end = mTraitInfoPool;
+
+    // Slide the lists down in the order in which they lie in the pool.
+    while (true)
+    {
+        SubscriptionHandler * next = NULL;
+
+        for (size_t i = 0; i < mHandlerPoolSize; ++i)
+        {
+            if (mHandlers[i].mNumTraitInstances > 0 && mHandlers[i].mTraitInstanceList >= end &&
+                (next == NULL || mHandlers[i].mTraitInstanceList < next->mTraitInstanceList))
+            {
+                next = &mHandlers[i];
+            }
+        }
+
+        if (next == NULL)
+        {
+            break;
+        }
+
+        memmove(end, next->mTraitInstanceList, next->mNumTraitInstances * sizeof(SubscriptionHandler::TraitInstanceInfo));
+        next->mTraitInstanceList = end;
+        end += next->mNumTraitInstances;
+    }
+
+    // Rotate the list of aLast past the lists that follow it.
+    if (aLast->mNumTraitInstances > 0 && aLast->mTraitInstanceList + aLast->mNumTraitInstances < end)
+    {
+        SubscriptionHandler::TraitInstanceInfo * const first = aLast->mTraitInstanceList;
+        SubscriptionHandler::TraitInstanceInfo * const middle = first + aLast->mNumTraitInstances;
+
+        ReverseTraitInfos(first, middle);
+        ReverseTraitInfos(middle, end);
+        ReverseTraitInfos(first, end);
+
+        for (size_t i = 0; i < mHandlerPoolSize; ++i)
+        {
+            if (mHandlers[i].mNumTraitInstances > 0 && mHandlers[i].mTraitInstanceList >= middle)
+            {
+                mHandlers[i].mTraitInstanceList -= aLast->mNumTraitInstances;
+            }
+        }
+
+        aLast->mTraitInstanceList = end - aLast->mNumTraitInstances;
+    }
+
+    WeaveLogDetail(DataManagement, "Trait instance pool compacted to %u", static_cast<unsigned int>(end - mTraitInfoPool));
+
+    mTraitInfoFreeList = kNullTraitInfoIndex;
+
+    if (end < mTraitInfoPool + mTraitInfoPoolSize)
+    {
+        FreeTraitInfos(static_cast<uint16_t>(end - mTraitInfoPool), static_cast<uint16_t>(mTraitInfoPool + mTraitInfoPoolSize - end));
+    }
+}
+
+/**
+ * Find the largest free run of trait instances, growing the pool if it is shorter than aMinLength.
+ *
+ * @retval The index of the first trait instance of the run, or kNullTraitInfoIndex if there is no free run of at least
+ *         aMinLength trait instances.
+ */
+uint16_t SubscriptionEngine::FindFreeTraitInfoExtent(uint16_t aMinLength)
+{
+    uint16_t largest       = kNullTraitInfoIndex;
+    uint16_t largestLength = 0;
+
+    for (uint16_t extent = mTraitInfoFreeList; extent != kNullTraitInfoIndex; extent = GetFreeTraitInfoExtent(extent)->mNext)
+    {
+        if (GetFreeTraitInfoExtent(extent)->mLength > largestLength)
         {
-            pHandler->mTraitInstanceList -= numTraitInstances;
+            largest       = extent;
+            largestLength = GetFreeTraitInfoExtent(extent)->mLength;
         }
     }
 
+#if WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+    if (largestLength < aMinLength && GrowTraitInfoPool(aMinLength))
+    {
+        return FindFreeTraitInfoExtent(aMinLength);
+    }
+#endif // WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+
+    return (largestLength >= aMinLength) ? largest : static_cast<uint16_t>(kNullTraitInfoIndex);
+}
+
+/**
+ * Remove the first aCount trait instances of the free run starting at aStart from the free list.
+ */
+void SubscriptionEngine::TakeTraitInfos(uint16_t aStart, uint16_t aCount)
+{
+    uint16_t * link = &mTraitInfoFreeList;
+    FreeTraitInfoExtent * extent;
+    uint16_t next, length;
+
+    while (*link != aStart)
+    {
+        VerifyOrExit(*link != kNullTraitInfoIndex, WeaveLogError(DataManagement, "Trait instance %u is not free", aStart));
+
+        link = &GetFreeTraitInfoExtent(*link)->mNext;
+    }
+
+    extent = GetFreeTraitInfoExtent(aStart);
+    next   = extent->mNext;
+    length = extent->mLength;
+
+    WeaveLogIfFalse(aCount <= length);
+
+    if (aCount < length)
+    {
+        extent          = GetFreeTraitInfoExtent(aStart + aCount);
+        extent->mNext   = next;
+        extent->mLength = length - aCount;
+        next            = aStart + aCount;
+    }
+
+    *link = next;
+
 exit:
-    WeaveLogDetail(DataManagement, "Number of allocated trait instances: %u", mNumTraitInfosInPool);
+    return;
+}
+
+/**
+ * Return aCount trait instances starting at aStart to the free list, merging them with adjacent free runs.
+ */
+void SubscriptionEngine::FreeTraitInfos(uint16_t aStart, uint16_t aCount)
+{
+    uint16_t prev   = kNullTraitInfoIndex;
+    uint16_t next   = mTraitInfoFreeList;
+    uint16_t length = aCount;
+
+    while (next != kNullTraitInfoIndex && next < aStart)
+    {
+        prev = next;
+        next = GetFreeTraitInfoExtent(next)->mNext;
+    }
+
+    if (next != kNullTraitInfoIndex && aStart + length == next)
+    {
+        length += GetFreeTraitInfoExtent(next)->mLength;
+        next = GetFreeTraitInfoExtent(next)->mNext;
+    }
+
+    if (prev != kNullTraitInfoIndex && prev + GetFreeTraitInfoExtent(prev)->mLength == aStart)
+    {
+        GetFreeTraitInfoExtent(prev)->mLength += length;
+        GetFreeTraitInfoExtent(prev)->mNext = next;
+    }
+    else
+    {
+        GetFreeTraitInfoExtent(aStart)->mLength = length;
+        GetFreeTraitInfoExtent(aStart)->mNext   = next;
+
+        if (prev == kNullTraitInfoIndex)
+        {
+            mTraitInfoFreeList = aStart;
+        }
+        else
+        {
+            GetFreeTraitInfoExtent(prev)->mNext = aStart;
+        }
+    }
+}
+
+#if WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+/**
+ * Grow the trait instance pool so that it ends in a free run of at least aMinLength trait instances.
+ *
+ * @retval true if the pool was grown, false if it is at its limit or could not be reallocated.
+ */
+bool SubscriptionEngine::GrowTraitInfoPool(uint16_t aMinLength)
+{
+    SubscriptionHandler::TraitInstanceInfo * pool;
+    uint16_t tailLength = 0;
+    uint32_t minSize, newSize;
+
+    for (uint16_t extent = mTraitInfoFreeList; extent != kNullTraitInfoIndex; extent = GetFreeTraitInfoExtent(extent)->mNext)
+    {
+        if (extent + GetFreeTraitInfoExtent(extent)->mLength == mTraitInfoPoolSize)
+        {
+            tailLength = GetFreeTraitInfoExtent(extent)->mLength;
+        }
+    }
+
+    minSize = static_cast<uint32_t>(mTraitInfoPoolSize) + aMinLength - tailLength;
+    newSize = static_cast<uint32_t>(mTraitInfoPoolSize) * 2;
+
+    if (newSize < minSize)
+    {
+        newSize = minSize;
+    }
+
+    if (newSize > mMaxTraitInfoPoolSize)
+    {
+        newSize = mMaxTraitInfoPoolSize;
+    }
+
+    if (newSize < minSize)
+    {
+        return false;
+    }
+
+    pool = static_cast<SubscriptionHandler::TraitInstanceInfo *>(malloc(newSize * sizeof(SubscriptionHandler::TraitInstanceInfo)));
+    if (pool == NULL)
+    {
+        return false;
+    }
+
+    memcpy(pool, mTraitInfoPool, mTraitInfoPoolSize * sizeof(SubscriptionHandler::TraitInstanceInfo));
+
+    for (size_t i = 0; i < mHandlerPoolSize; ++i)
+    {
+        if (mHandlers[i].mTraitInstanceList != NULL)
+        {
+            mHandlers[i].mTraitInstanceList = pool + (mHandlers[i].mTraitInstanceList - mTraitInfoPool);
+        }
+    }
+
+    WeaveLogDetail(DataManagement, "Trait instance pool grown from %u to %u", mTraitInfoPoolSize, static_cast<unsigned int>(newSize));
+
+    free(mTraitInfoPool);
+    mTraitInfoPool = pool;
+
+    FreeTraitInfos(mTraitInfoPoolSize, static_cast<uint16_t>(newSize - mTraitInfoPoolSize));
+    mTraitInfoPoolSize = static_cast<uint16_t>(newSize);
+
+    return true;
+}
+
+WEAVE_ERROR SubscriptionEngine::ConfigurePublisherPools(uint16_t aNumHandlers, uint16_t aMaxNumTraitInfos)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(aNumHandlers > 0 && aMaxNumTraitInfos > 0 && aMaxNumTraitInfos < kNullTraitInfoIndex,
+                 err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    for (size_t i = 0; i < mHandlerPoolSize; ++i)
+    {
+        VerifyOrExit(SubscriptionHandler::kState_Free == mHandlers[i].mCurrentState, err = WEAVE_ERROR_INCORRECT_STATE);
+    }
+
+    if (aNumHandlers != mHandlerPoolSize)
+    {
+        SubscriptionHandler * handlers = static_cast<SubscriptionHandler *>(malloc(aNumHandlers * sizeof(SubscriptionHandler)));
+        VerifyOrExit(handlers != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        for (size_t i = 0; i < aNumHandlers; ++i)
+        {
+            new (&handlers[i]) SubscriptionHandler();
+            handlers[i].InitAsFree();
+        }
+
+        DestroyHandlers();
+        mHandlers        = handlers;
+        mHandlerPoolSize = aNumHandlers;
+    }
+
+    // No trait instances are in use, so the pool can simply be truncated.
+    if (mTraitInfoPoolSize > aMaxNumTraitInfos)
+    {
+        mTraitInfoPoolSize = aMaxNumTraitInfos;
+    }
+
+    mMaxTraitInfoPoolSize = aMaxNumTraitInfos;
+
+    ResetTraitInfoPool();
+
+exit:
+    return err;
+}
+
+void SubscriptionEngine::DestroyHandlers(void)
+{
+    for (size_t i = 0; i < mHandlerPoolSize; ++i)
+    {
+        mHandlers[i].~SubscriptionHandler();
+    }
+
+    free(mHandlers);
+    mHandlers        = NULL;
+    mHandlerPoolSize = 0;
+}
+
+void SubscriptionEngine::FreePublisherPools(void)
+{
+    DestroyHandlers();
+
+    free(mTraitInfoPool);
+    mTraitInfoPool        = NULL;
+    mTraitInfoPoolSize    = 0;
+    mMaxTraitInfoPoolSize = 0;
+    mNumTraitInfosInPool  = 0;
+    mTraitInfoFreeList    = kNullTraitInfoIndex;
+}
+#endif // WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+
+void SubscriptionEngine::GetPublisherPoolStats(PublisherPoolStats & aStats) const
+{
+    memset(&aStats, 0, sizeof(aStats));
+
+    aStats.mNumHandlers        = mHandlerPoolSize;
+    aStats.mNumTraitInfos      = mTraitInfoPoolSize;
+    aStats.mMaxNumTraitInfos   = mMaxTraitInfoPoolSize;
+    aStats.mNumTraitInfosInUse = mNumTraitInfosInPool;
+
+    for (size_t i = 0; i < mHandlerPoolSize; ++i)
+    {
+        if (SubscriptionHandler::kState_Free != mHandlers[i].mCurrentState)
+        {
+            ++aStats.mNumHandlersInUse;
+        }
+    }
+
+    for (uint16_t extent = mTraitInfoFreeList; extent != kNullTraitInfoIndex;)
+    {
+        const FreeTraitInfoExtent * freeExtent = reinterpret_cast<const FreeTraitInfoExtent *>(&mTraitInfoPool[extent]);
+
+        ++aStats.mNumTraitInfoFreeExtents;
+
+        if (freeExtent->mLength > aStats.mLargestTraitInfoFreeExtent)
+        {
+            aStats.mLargestTraitInfoFreeExtent = freeExtent->mLength;
+        }
+
+        extent = freeExtent->mNext;
+    }
+}
+
+#if WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+WEAVE_ERROR SubscriptionEngine::CheckpointSubscriptions(nl::Weave::TLV::TLVWriter & aWriter, const uint64_t aTag,
+                                                        uint16_t & aNumCheckpointed)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    bool isLocked   = false;
+    nl::Weave::TLV::TLVType containerType;
+
+    aNumCheckpointed = 0;
+
+    VerifyOrExit(mIsPublisherEnabled, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    err = Lock();
+    SuccessOrExit(err);
+
+    isLocked = true;
+
+    err = aWriter.StartContainer(aTag, nl::Weave::TLV::kTLVType_Array, containerType);
+    SuccessOrExit(err);
+
+    for (size_t i = 0; i < mHandlerPoolSize; ++i)
+    {
+        if (mHandlers[i].IsCheckpointable())
+        {
+            err = mHandlers[i].Checkpoint(aWriter, nl::Weave::TLV::AnonymousTag);
+            SuccessOrExit(err);
+
+            ++aNumCheckpointed;
+        }
+    }
+
+    err = aWriter.EndContainer(containerType);
+    SuccessOrExit(err);
+
+exit:
+    WeaveLogFunctError(err);
+
+    if (isLocked)
+    {
+        Unlock();
+    }
+
+    return err;
+}
+
+WEAVE_ERROR SubscriptionEngine::RestoreSubscriptions(nl::Weave::TLV::TLVReader & aReader, void * const aAppState,
+                                                     const SubscriptionHandler::EventCallback aEventCallback,
+                                                     uint16_t & aNumRestored)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    bool isLocked   = false;
+    nl::Weave::TLV::TLVType containerType;
+
+    aNumRestored = 0;
+
+    VerifyOrExit(mIsPublisherEnabled, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(NULL != aEventCallback, err = WEAVE_ERROR_INVALID_ARGUMENT);
+    VerifyOrExit(nl::Weave::TLV::kTLVType_Array == aReader.GetType(), err = WEAVE_ERROR_WRONG_TLV_TYPE);
+
+    err = Lock();
+    SuccessOrExit(err);
+
+    isLocked = true;
+
+    err = aReader.EnterContainer(containerType);
+    SuccessOrExit(err);
+
+    while (WEAVE_NO_ERROR == (err = aReader.Next()))
+    {
+        nl::Weave::TLV::TLVReader subscriptionReader;
+        SubscriptionHandler * handler = NULL;
+        Binding * binding             = NULL;
+
+        // Each subscription is read with a copy of the reader, so that one that cannot be resumed is simply skipped
+        subscriptionReader.Init(aReader);
+
+        binding = mExchangeMgr->NewBinding();
+        if (NULL == binding)
+        {
+            WeaveLogError(DataManagement, "%s: Out of Binding", __func__);
+            continue;
+        }
+
+        if (WEAVE_NO_ERROR == NewSubscriptionHandler(&handler))
+        {
+            handler->mAppState      = aAppState;
+            handler->mEventCallback = aEventCallback;
+
+            if (WEAVE_NO_ERROR == handler->InitWithCheckpoint(binding, subscriptionReader))
+            {
+                ++aNumRestored;
+            }
+        }
+
+        binding->Release();
+    }
+
+    if (WEAVE_END_OF_TLV == err)
+    {
+        err = aReader.ExitContainer(containerType);
+    }
+
+exit:
+    WeaveLogFunctError(err);
+
+    if (isLocked)
+    {
+        Unlock();
+    }
+
+    return err;
 }
+#endif // WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
 
 WEAVE_ERROR SubscriptionEngine::EnablePublisher(IWeavePublisherLock * aLock,
                                                 TraitCatalogBase<TraitDataSource> * const aPublisherCatalog)
@@ -1005,7 +1595,7 @@ void SubscriptionEngine::DisablePublisher()
     mIsPublisherEnabled = false;
     mPublisherCatalog   = NULL;
 
-    for (size_t i = 0; i < kMaxNumSubscriptionHandlers; ++i)
+    for (size_t i = 0; i < mHandlerPoolSize; ++i)
     {
         switch (mHandlers[i].mCurrentState)
         {
@@ -1030,7 +1620,7 @@ WEAVE_ERROR SubscriptionEngine::NewSubscriptionHandler(SubscriptionHandler ** su
 
     WEAVE_FAULT_INJECT(FaultInjection::kFault_WDM_SubscriptionHandlerNew, ExitNow());
 
-    for (size_t i = 0; i < kMaxNumSubscriptionHandlers; ++i)
+    for (size_t i = 0; i < mHandlerPoolSize; ++i)
     {
         if (SubscriptionHandler::kState_Free == mHandlers[i].mCurrentState)
         {
@@ -1124,7 +1714,7 @@ void SubscriptionEngine::OnSubscribeRequest(nl::Weave::ExchangeContext * aEC, co
         if (outParam.mIncomingSubscribeRequest.mAutoClosePriorSubscription)
         {
             // if not rejected, default behavior is to abort any prior communication with this node id
-            for (size_t i = 0; i < kMaxNumSubscriptionHandlers; ++i)
+            for (size_t i = 0; i < pEngine->mHandlerPoolSize; ++i)
             {
                 if ((pEngine->mHandlers[i].mCurrentState >= SubscriptionHandler::kState_SubscriptionInfoValid_Begin) &&
                     (pEngine->mHandlers[i].mCurrentState <= SubscriptionHandler::kState_SubscriptionInfoValid_End))
@@ -291,9 +291,93 @@ public:
 
     uint16_t GetCommandObjId(const Command * const apHandle) const;
 
+    /**
+     * Occupancy of the publisher's subscription handler and trait instance pools.
+     */
+    struct PublisherPoolStats
+    {
+        uint16_t mNumHandlers;                //< Number of subscription handlers in the pool
+        uint16_t mNumHandlersInUse;           //< Number of subscription handlers that are not free
+        uint16_t mNumTraitInfos;              //< Current size of the trait instance pool
+        uint16_t mMaxNumTraitInfos;           //< Size up to which the trait instance pool may grow
+        uint16_t mNumTraitInfosInUse;         //< Number of trait instances allocated to subscriptions
+        uint16_t mNumTraitInfoFreeExtents;    //< Number of runs of free trait instances
+        uint16_t mLargestTraitInfoFreeExtent; //< Length of the longest run of free trait instances
+    };
+
+    /**
+     * @brief Retrieve the occupancy of the publisher's subscription handler and trait instance pools.
+     *
+     * @param[out] aStats           The pool statistics.
+     */
+    void GetPublisherPoolStats(PublisherPoolStats & aStats) const;
+
+#if WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+    /**
+     * @brief Resize the publisher's subscription handler pool and set the limit of its trait instance pool.
+     *
+     * May only be called while no subscription handlers are in use, e.g. before EnablePublisher.
+     *
+     * @param[in]  aNumHandlers         The number of subscription handlers.
+     * @param[in]  aMaxNumTraitInfos    The number of trait instances, summed over all subscriptions, up to which
+     *                                  the trait instance pool may grow.
+     *
+     * @retval #WEAVE_NO_ERROR                  On success.
+     * @retval #WEAVE_ERROR_INVALID_ARGUMENT    If either size is zero, or larger than supported.
+     * @retval #WEAVE_ERROR_INCORRECT_STATE     If a subscription handler is in use.
+     * @retval #WEAVE_ERROR_NO_MEMORY           If the pools could not be allocated.
+     */
+    WEAVE_ERROR ConfigurePublisherPools(uint16_t aNumHandlers, uint16_t aMaxNumTraitInfos);
+#endif // WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+
+#if WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+    /**
+     * @brief Write a checkpoint of the subscriptions to this publisher, from which they can be resumed after a restart.
+     *
+     * Only subscriptions that are established with no notify in flight, and whose subscribers are reached over UDP either
+     * without a session key or with one saved in the session key store of the fabric state, are written; the subscribers of
+     * any others have to subscribe again after a restart. The checkpoint also holds the current version of each trait
+     * instance these subscriptions cover, and is written as a single TLV array.
+     *
+     * @param[in]  aWriter              The writer to write the checkpoint to.
+     * @param[in]  aTag                 The tag of the checkpoint array.
+     * @param[out] aNumCheckpointed     The number of subscriptions written.
+     *
+     * @retval #WEAVE_NO_ERROR                  On success.
+     * @retval #WEAVE_ERROR_INCORRECT_STATE     If the publisher is not enabled.
+     * @retval other                            If the checkpoint could not be written.
+     */
+    WEAVE_ERROR CheckpointSubscriptions(nl::Weave::TLV::TLVWriter & aWriter, const uint64_t aTag, uint16_t & aNumCheckpointed);
+
+    /**
+     * @brief Resume the subscriptions written by CheckpointSubscriptions().
+     *
+     * Resumed subscriptions are established straight away and reported to aEventCallback with
+     * SubscriptionHandler::kEvent_OnSubscriptionEstablished. The data sources of the resumed trait instances are set back to
+     * their checkpointed versions, so the published data has to be restored to its checkpointed state before this is called;
+     * changes made afterwards with TraitDataSource::SetDirty() are notified as usual. Trait instances that had changes the
+     * subscriber had not seen at the checkpoint are notified in full the next time the notification engine runs. A
+     * subscription is skipped if it cannot be resumed, e.g. because one of its trait instances is no longer published, its
+     * session key is no longer stored, or the handler pool is exhausted.
+     *
+     * @param[in]  aReader              A reader positioned on the checkpoint array.
+     * @param[in]  aAppState            A pointer to application layer supplied state object for the resumed handlers.
+     * @param[in]  aEventCallback       The event callback for the resumed handlers.
+     * @param[out] aNumRestored         The number of subscriptions resumed.
+     *
+     * @retval #WEAVE_NO_ERROR                  On success.
+     * @retval #WEAVE_ERROR_INCORRECT_STATE     If the publisher is not enabled.
+     * @retval #WEAVE_ERROR_INVALID_ARGUMENT    If aEventCallback is NULL.
+     * @retval other                            If the checkpoint could not be read.
+     */
+    WEAVE_ERROR RestoreSubscriptions(nl::Weave::TLV::TLVReader & aReader, void * const aAppState,
+                                     const SubscriptionHandler::EventCallback aEventCallback, uint16_t & aNumRestored);
+#endif // WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+
 #endif // WDM_ENABLE_SUBSCRIPTION_PUBLISHER
 
     SubscriptionEngine(void);
+    ~SubscriptionEngine(void);
 
     WEAVE_ERROR Init(nl::Weave::WeaveExchangeManager * const apExchangeMgr, void * const aAppState = NULL,
                      const EventCallback aEventCallback = NULL);
@@ -395,21 +479,59 @@ private:
 
     // ******************* begin protected by lock **************************
     bool mIsPublisherEnabled;
+#if WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+    SubscriptionHandler * mHandlers;
+#else
     SubscriptionHandler mHandlers[kMaxNumSubscriptionHandlers];
+#endif
+    uint16_t mHandlerPoolSize;
     TraitCatalogBase<TraitDataSource> * mPublisherCatalog;
     NotificationEngine mNotificationEngine;
 
     // used for fairness
     uint16_t mNextHandlerToNotify;
 
+    // Each subscription holds a contiguous run of trait instances. The free runs are kept on a list, in
+    // ascending order, threaded through their first trait instance.
     uint16_t mNumTraitInfosInPool;
+#if WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+    SubscriptionHandler::TraitInstanceInfo * mTraitInfoPool;
+#else
     SubscriptionHandler::TraitInstanceInfo mTraitInfoPool[kMaxNumPathGroups];
+#endif
+    uint16_t mTraitInfoPoolSize;
+    uint16_t mMaxTraitInfoPoolSize;
+    uint16_t mTraitInfoFreeList;
 
     uint16_t mNumOfPropertyPathHandlesAllocated;
     // PropertyPathHandle mPropertyPathHandlePool[kMaxNumPropertyPathHandles];
     // ******************* end protected by lock   **************************
 
+    enum
+    {
+        kNullTraitInfoIndex = 0xFFFF,
+    };
+
+    struct FreeTraitInfoExtent
+    {
+        uint16_t mNext;
+        uint16_t mLength;
+    };
+
+    SubscriptionHandler::TraitInstanceInfo * NewTraitInfo(SubscriptionHandler * const aHandler);
     void ReclaimTraitInfo(SubscriptionHandler * const aHandlerToBeReclaimed);
+    void ResetTraitInfoPool(void);
+    FreeTraitInfoExtent * GetFreeTraitInfoExtent(uint16_t aIndex);
+    bool IsFreeTraitInfoExtent(uint16_t aIndex);
+    uint16_t FindFreeTraitInfoExtent(uint16_t aMinLength);
+    void TakeTraitInfos(uint16_t aStart, uint16_t aCount);
+    void FreeTraitInfos(uint16_t aStart, uint16_t aCount);
+    void CompactTraitInfoPool(SubscriptionHandler * const aLast);
+#if WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+    bool GrowTraitInfoPool(uint16_t aMinLength);
+    void DestroyHandlers(void);
+    void FreePublisherPools(void);
+#endif
 
     static void OnSubscribeRequest(nl::Weave::ExchangeContext * aEC, const nl::Inet::IPPacketInfo * aPktInfo,
                                    const nl::Weave::WeaveMessageInfo * aMsgInfo, uint32_t aProfileId, uint8_t aMsgType,
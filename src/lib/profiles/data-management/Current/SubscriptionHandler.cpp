@@ -70,11 +70,17 @@ void SubscriptionHandler::InitAsFree()
     mTraitInstanceList             = NULL;
     mNumTraitInstances             = 0;
     mMaxNotificationSize           = 0;
+    mDeltaNotifications            = WDM_PUBLISHER_DEFAULT_DELTA_NOTIFICATIONS;
+    mNotifyPipelineDepth           = WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION;
     mSubscribeToAllEvents          = false;
     mCurProcessingTraitInstanceIdx = 0;
     mCurrentImportance             = kImportanceType_Invalid;
     mBytesOffloaded                = 0;
 
+    mSnapshotCursor.Reset();
+    ResetNotifyCoalescing();
+    ResetInFlightNotifies();
+
     memset(mSelfVendedEvents, 0, sizeof(mSelfVendedEvents));
     memset(mLastScheduledEventId, 0, sizeof(mLastScheduledEventId));
 }
@@ -333,15 +339,11 @@ WEAVE_ERROR SubscriptionHandler::ParsePathVersionEventLists(SubscribeRequest::Pa
             // allocate a new trait instance
             WEAVE_FAULT_INJECT(FaultInjection::kFault_WDM_TraitInstanceNew, SuccessOrExit(err = WEAVE_ERROR_NO_MEMORY));
 
-            if (SubscriptionEngine::GetInstance()->mNumTraitInfosInPool < SubscriptionEngine::kMaxNumPathGroups)
+            traitInstance = SubscriptionEngine::GetInstance()->NewTraitInfo(this);
+
+            if (NULL != traitInstance)
             {
-                traitInstance =
-                    SubscriptionEngine::GetInstance()->mTraitInfoPool + SubscriptionEngine::GetInstance()->mNumTraitInfosInPool;
-                ++mNumTraitInstances;
-                ++(SubscriptionEngine::GetInstance()->mNumTraitInfosInPool);
                 SYSTEM_STATS_INCREMENT(nl::Weave::System::Stats::kWDM_NumTraits);
-
-                traitInstance->Init();
             }
             else
             {
@@ -356,13 +358,6 @@ WEAVE_ERROR SubscriptionHandler::ParsePathVersionEventLists(SubscribeRequest::Pa
         traitInstance->mTraitDataHandle  = traitDataHandle;
         traitInstance->mRequestedVersion = computedForwardRequestedVersion;
 
-        if (NULL == mTraitInstanceList)
-        {
-            // this the first trait instance for this subscription
-            // mNumTraitInstanceList has already be incremented
-            mTraitInstanceList = traitInstance;
-        }
-
         if (!IsVersionListPresent)
         {
             // no existing version
@@ -645,7 +640,7 @@ void SubscriptionHandler::InitWithIncomingRequest(Binding * const aBinding, cons
     _AddRef();
     MoveToState(kState_Subscribing_Evaluating);
 
-    InitExchangeContext();
+    InitExchangeContext(mEC);
 
     // First stage: Initial parsing
     // Convert all path lists to TargetHandles and PathHandles
@@ -738,30 +733,37 @@ exit:
 
 WEAVE_ERROR SubscriptionHandler::SendNotificationRequest(PacketBuffer * aMsgBuf)
 {
-    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    WEAVE_ERROR err                       = WEAVE_NO_ERROR;
+    nl::Weave::ExchangeContext * ec       = mEC;
+    nl::Weave::ExchangeContext * notifyEC = NULL;
 
     WeaveLogDetail(DataManagement, "Handler[%u] [%5.5s] %s Ref(%d)", SubscriptionEngine::GetInstance()->GetHandlerId(this),
                    GetStateStr(), __func__, mRefCount);
 
-    WeaveLogIfFalse((kState_Subscribing == mCurrentState) || (kState_SubscriptionEstablished_Idle == mCurrentState));
+    WeaveLogIfFalse(IsNotifiable());
 
     // Make sure we're not freed by accident.
     _AddRef();
 
-    // Create new exchange context when we're idle (otherwise we must be using the existing EC)
-    if (kState_SubscriptionEstablished_Idle == mCurrentState)
+    VerifyOrExit(mNumInFlightNotifies < WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // Once established, every notify gets an exchange context of its own so that several can be in flight
+    if (kState_Subscribing != mCurrentState)
     {
-        err = ReplaceExchangeContext();
+        err = NewExchangeContext(notifyEC);
         SuccessOrExit(err);
+
+        ec = notifyEC;
     }
 
-    // Note we're sending back a message using an EC initiated by the client
-    err     = mEC->SendMessage(nl::Weave::Profiles::kWeaveProfile_WDM, kMsgType_NotificationRequest, aMsgBuf,
-                           nl::Weave::ExchangeContext::kSendFlag_ExpectResponse);
+    // Note we're sending back a message using an EC initiated by the client while priming
+    err     = ec->SendMessage(nl::Weave::Profiles::kWeaveProfile_WDM, kMsgType_NotificationRequest, aMsgBuf,
+                          nl::Weave::ExchangeContext::kSendFlag_ExpectResponse);
     aMsgBuf = NULL;
     SuccessOrExit(err);
 
-    mCurrentState = (mCurrentState == kState_Subscribing) ? kState_Subscribing_Notifying : kState_SubscriptionEstablished_Notifying;
+    PushInFlightNotify(notifyEC);
+    notifyEC = NULL;
 
 exit:
     WeaveLogFunctError(err);
@@ -772,6 +774,11 @@ exit:
         aMsgBuf = NULL;
     }
 
+    if (NULL != notifyEC)
+    {
+        FlushExchangeContext(notifyEC, true);
+    }
+
     if (WEAVE_NO_ERROR != err)
     {
         HandleSubscriptionTerminated(err, NULL);
@@ -892,21 +899,38 @@ uint64_t SubscriptionHandler::GetPeerNodeId(void) const
     return mPeerNodeId;
 }
 
-void SubscriptionHandler::InitExchangeContext()
+void SubscriptionHandler::InitExchangeContext(nl::Weave::ExchangeContext * const aEC)
 {
-    mEC->AppState          = this;
-    mEC->OnResponseTimeout = OnResponseTimeout;
-    mEC->OnSendError       = OnSendError;
-    mEC->OnAckRcvd         = OnAckReceived;
-    mEC->OnMessageReceived = OnMessageReceivedFromLocallyHeldExchange;
+    aEC->AppState          = this;
+    aEC->OnResponseTimeout = OnResponseTimeout;
+    aEC->OnSendError       = OnSendError;
+    aEC->OnAckRcvd         = OnAckReceived;
+    aEC->OnMessageReceived = OnMessageReceivedFromLocallyHeldExchange;
 }
 
-WEAVE_ERROR SubscriptionHandler::ReplaceExchangeContext()
+WEAVE_ERROR SubscriptionHandler::NewExchangeContext(nl::Weave::ExchangeContext *& aEC)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
     InEventParam inParam;
     OutEventParam outParam;
 
+    err = mBinding->NewExchangeContext(aEC);
+    SuccessOrExit(err);
+
+    InitExchangeContext(aEC);
+
+    inParam.mExchangeStart.mEC      = aEC;
+    inParam.mExchangeStart.mHandler = this;
+    mEventCallback(mAppState, kEvent_OnExchangeStart, inParam, outParam);
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR SubscriptionHandler::ReplaceExchangeContext()
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
     WeaveLogDetail(DataManagement, "Handler[%u] [%5.5s] %s Ref(%d)", SubscriptionEngine::GetInstance()->GetHandlerId(this),
                    GetStateStr(), __func__, mRefCount);
 
@@ -915,15 +939,9 @@ WEAVE_ERROR SubscriptionHandler::ReplaceExchangeContext()
 
     FlushExistingExchangeContext();
 
-    err = mBinding->NewExchangeContext(mEC);
+    err = NewExchangeContext(mEC);
     SuccessOrExit(err);
 
-    InitExchangeContext();
-
-    inParam.mExchangeStart.mEC      = mEC;
-    inParam.mExchangeStart.mHandler = this;
-    mEventCallback(mAppState, kEvent_OnExchangeStart, inParam, outParam);
-
 exit:
     WeaveLogFunctError(err);
 
@@ -934,31 +952,160 @@ exit:
 
 void SubscriptionHandler::FlushExistingExchangeContext(const bool aAbortNow)
 {
-    if (NULL != mEC)
+    FlushExchangeContext(mEC, aAbortNow);
+}
+
+void SubscriptionHandler::FlushExchangeContext(nl::Weave::ExchangeContext *& aEC, const bool aAbortNow)
+{
+    if (NULL != aEC)
     {
-        mEC->AppState          = NULL;
-        mEC->OnMessageReceived = NULL;
-        mEC->OnResponseTimeout = NULL;
-        mEC->OnSendError       = NULL;
-        mEC->OnAckRcvd         = NULL;
+        aEC->AppState          = NULL;
+        aEC->OnMessageReceived = NULL;
+        aEC->OnResponseTimeout = NULL;
+        aEC->OnSendError       = NULL;
+        aEC->OnAckRcvd         = NULL;
         if (aAbortNow)
         {
-            mEC->Abort();
+            aEC->Abort();
         }
         else
         {
-            mEC->Close();
+            aEC->Close();
         }
-        mEC = NULL;
+        aEC = NULL;
     }
 }
 
+void SubscriptionHandler::ResetInFlightNotifies(void)
+{
+    memset(mInFlightNotifies, 0, sizeof(mInFlightNotifies));
+    mFirstInFlightNotify = 0;
+    mNumInFlightNotifies = 0;
+    mNextNotifySeq       = 1;
+}
+
+void SubscriptionHandler::PushInFlightNotify(nl::Weave::ExchangeContext * const aEC)
+{
+    InFlightNotify & notify =
+        mInFlightNotifies[(mFirstInFlightNotify + mNumInFlightNotifies) % WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION];
+
+    notify.mEC        = aEC;
+    notify.mSeq       = mNextNotifySeq;
+    notify.mConfirmed = false;
+    memcpy(notify.mSelfVendedEvents, mSelfVendedEvents, sizeof(mSelfVendedEvents));
+
+    mNumInFlightNotifies++;
+
+    // Sequence number 0 marks trait instances that have not been notified
+    mNextNotifySeq = (mNextNotifySeq == UINT8_MAX) ? 1 : mNextNotifySeq + 1;
+
+    mCurrentState = (mCurrentState == kState_Subscribing) ? kState_Subscribing_Notifying : kState_SubscriptionEstablished_Notifying;
+}
+
+SubscriptionHandler::InFlightNotify * SubscriptionHandler::FindInFlightNotify(const nl::Weave::ExchangeContext * const aEC)
+{
+    InFlightNotify * notify = NULL;
+
+    for (uint8_t i = 0; i < mNumInFlightNotifies; i++)
+    {
+        InFlightNotify * const candidate =
+            &mInFlightNotifies[(mFirstInFlightNotify + i) % WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION];
+
+        if ((NULL != candidate->mEC) && (aEC == candidate->mEC))
+        {
+            notify = candidate;
+            break;
+        }
+    }
+
+    return notify;
+}
+
+bool SubscriptionHandler::IsTraitNotifyInFlight(const TraitInstanceInfo * const aTraitInfo) const
+{
+    bool inFlight = false;
+
+    for (uint8_t i = 0; (aTraitInfo->mNotifySeq != 0) && (i < mNumInFlightNotifies); i++)
+    {
+        if (mInFlightNotifies[(mFirstInFlightNotify + i) % WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION].mSeq ==
+            aTraitInfo->mNotifySeq)
+        {
+            inFlight = true;
+            break;
+        }
+    }
+
+    return inFlight;
+}
+
+/**
+ * Retire confirmed notifies from the front of the in-flight ring, stopping at the oldest unconfirmed one, so that a
+ * confirmation that overtakes an earlier notify is only acted upon once everything sent before it is confirmed too.
+ *
+ * @param[out] aDeliveredEvents  Receives the self-vended event IDs as of the last retired notify.
+ *
+ * @return The number of notifies retired.
+ */
+uint8_t SubscriptionHandler::RetireInFlightNotifies(event_id_t * aDeliveredEvents)
+{
+    uint8_t numRetired = 0;
+
+    while (mNumInFlightNotifies > 0 && mInFlightNotifies[mFirstInFlightNotify].mConfirmed)
+    {
+        InFlightNotify & notify = mInFlightNotifies[mFirstInFlightNotify];
+
+        memcpy(aDeliveredEvents, notify.mSelfVendedEvents, sizeof(notify.mSelfVendedEvents));
+
+        // Release the trait instances that this notify was the last to carry.
+        for (uint16_t i = 0; i < mNumTraitInstances; i++)
+        {
+            if (mTraitInstanceList[i].mNotifySeq == notify.mSeq)
+            {
+                mTraitInstanceList[i].mNotifySeq = 0;
+            }
+        }
+
+        memset(&notify, 0, sizeof(notify));
+
+        mFirstInFlightNotify = (mFirstInFlightNotify + 1) % WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION;
+        mNumInFlightNotifies--;
+        numRetired++;
+    }
+
+    return numRetired;
+}
+
+/**
+ * Abandon all in-flight notifies, aborting the exchange contexts they own.
+ *
+ * @return The number of notifies abandoned.
+ */
+uint8_t SubscriptionHandler::FlushInFlightNotifies(void)
+{
+    const uint8_t numFlushed = mNumInFlightNotifies;
+
+    for (uint8_t i = 0; i < WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION; i++)
+    {
+        FlushExchangeContext(mInFlightNotifies[i].mEC, true);
+    }
+
+    for (uint16_t i = 0; i < mNumTraitInstances; i++)
+    {
+        mTraitInstanceList[i].mNotifySeq = 0;
+    }
+
+    ResetInFlightNotifies();
+
+    return numFlushed;
+}
+
 #if WDM_ENABLE_SUBSCRIPTION_CANCEL
 WEAVE_ERROR SubscriptionHandler::Cancel()
 {
-    WEAVE_ERROR err       = WEAVE_NO_ERROR;
-    PacketBuffer * msgBuf = NULL;
-    bool cancel           = false;
+    WEAVE_ERROR err              = WEAVE_NO_ERROR;
+    PacketBuffer * msgBuf        = NULL;
+    bool cancel                  = false;
+    uint8_t numAbandonedNotifies = 0;
 
     WeaveLogDetail(DataManagement, "Handler[%u] [%5.5s] %s Ref(%d)", SubscriptionEngine::GetInstance()->GetHandlerId(this),
                    GetStateStr(), __func__, mRefCount);
@@ -969,8 +1116,9 @@ WEAVE_ERROR SubscriptionHandler::Cancel()
     switch (mCurrentState)
     {
     case kState_SubscriptionEstablished_Notifying:
-        // abort whatever we're doing (notification request)
-        FlushExistingExchangeContext(true);
+        // abort whatever we're doing (notification requests)
+        numAbandonedNotifies = FlushInFlightNotifies();
+        MoveToState(kState_SubscriptionEstablished_Idle);
         cancel = true;
 
         break;
@@ -1024,6 +1172,11 @@ exit:
         msgBuf = NULL;
     }
 
+    if (numAbandonedNotifies > 0)
+    {
+        SubscriptionEngine::GetInstance()->GetNotificationEngine()->OnNotifyConfirm(this, numAbandonedNotifies, NULL);
+    }
+
     _Release();
 
     return err;
@@ -1166,25 +1319,19 @@ void SubscriptionHandler::AbortSubscription()
     else
     {
         // This is an intermediate state for external calls during the abort process
-        uint64_t peerNodeId            = mPeerNodeId;
-        uint64_t subscriptionId        = mSubscriptionId;
-        bool notifyEngineCleanupNeeded = false;
+        uint64_t peerNodeId     = mPeerNodeId;
+        uint64_t subscriptionId = mSubscriptionId;
 
         // If we were previously in a notifying state, we must tell NE so that it can do some clean-up.
         // However, we should wait till the subscription state has moved to aborting before attempting
         // to do so.
-        if (IsNotifying())
-        {
-            notifyEngineCleanupNeeded = true;
-        }
+        const uint8_t numAbandonedNotifies = FlushInFlightNotifies();
 
         MoveToState(kState_Aborting);
 
-        if (notifyEngineCleanupNeeded)
+        if (numAbandonedNotifies > 0)
         {
-            const bool notifySuccessfullyDelivered = true;
-
-            SubscriptionEngine::GetInstance()->GetNotificationEngine()->OnNotifyConfirm(this, !notifySuccessfullyDelivered);
+            SubscriptionEngine::GetInstance()->GetNotificationEngine()->OnNotifyConfirm(this, numAbandonedNotifies, NULL);
         }
 
         mBinding->SetProtocolLayerCallback(NULL, NULL);
@@ -1200,9 +1347,13 @@ void SubscriptionHandler::AbortSubscription()
         mAppState                      = NULL;
         mEventCallback                 = NULL;
         mMaxNotificationSize           = 0;
+        mDeltaNotifications            = WDM_PUBLISHER_DEFAULT_DELTA_NOTIFICATIONS;
+        mNotifyPipelineDepth           = WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION;
         mSubscribeToAllEvents          = false;
         mCurProcessingTraitInstanceIdx = 0;
         mCurrentImportance             = kImportanceType_Invalid;
+        mSnapshotCursor.Reset();
+        ResetNotifyCoalescing();
         (void) RefreshTimer();
 
         // release all trait instances back to the shared pool
@@ -1595,6 +1746,9 @@ void SubscriptionHandler::OnMessageReceivedFromLocallyHeldExchange(nl::Weave::Ex
     bool RetainExchangeContext                 = false;
     bool isStatusReportValid                   = false;
     bool isNotificationRejectedForInvalidValue = false;
+    InFlightNotify * notify                    = NULL;
+    uint8_t numRetired;
+    event_id_t deliveredEvents[kImportanceType_Last - kImportanceType_First + 1];
     nl::Weave::Profiles::StatusReporting::StatusReport status;
 
     WeaveLogDetail(DataManagement, "Handler[%u] [%5.5s] %s Ref(%d)", SubscriptionEngine::GetInstance()->GetHandlerId(pHandler),
@@ -1603,7 +1757,11 @@ void SubscriptionHandler::OnMessageReceivedFromLocallyHeldExchange(nl::Weave::Ex
     // Make sure we're not freed by accident.
     pHandler->_AddRef();
 
-    VerifyOrExit(aEC == pHandler->mEC, err = WEAVE_ERROR_INCORRECT_STATE);
+    if (aEC != pHandler->mEC)
+    {
+        notify = pHandler->FindInFlightNotify(aEC);
+        VerifyOrExit(NULL != notify, err = WEAVE_ERROR_INCORRECT_STATE);
+    }
 
     if ((nl::Weave::Profiles::kWeaveProfile_Common == aProfileId) &&
         (nl::Weave::Profiles::Common::kMsgType_StatusReport == aMsgType))
@@ -1646,16 +1804,18 @@ void SubscriptionHandler::OnMessageReceivedFromLocallyHeldExchange(nl::Weave::Ex
         // only retain the EC if we're good to continue processing
         RetainExchangeContext = true;
 
-        // Only prompt the NotificationEngine if we received a status report indicating success. Otherwise, the subscription will
-        // get torn down and as part of that clean-up, a similar invocation of OnNotifyConfirm will happen.
-        SubscriptionEngine::GetInstance()->GetNotificationEngine()->OnNotifyConfirm(pHandler, status.success());
+        // priming notifies are sent one at a time over the EC of the subscribe request
+        pHandler->mInFlightNotifies[pHandler->mFirstInFlightNotify].mConfirmed = true;
+        numRetired = pHandler->RetireInFlightNotifies(deliveredEvents);
 
         // kick back from kState_Subscribing_Notifying to kState_Subscribing and evaluate again
         pHandler->MoveToState(kState_Subscribing);
 
-        // kick notification engine again
-        // Note that the call to NotificationEngine::Run could actually cause this particular handler to be aborted
-        SubscriptionEngine::GetInstance()->GetNotificationEngine()->Run();
+        // Only prompt the NotificationEngine if we received a status report indicating success. Otherwise, the subscription will
+        // get torn down and as part of that clean-up, a similar invocation of OnNotifyConfirm will happen.
+        // Note that the call to NotificationEngine::Run from here could actually cause this particular handler to be aborted
+        SubscriptionEngine::GetInstance()->GetNotificationEngine()->OnNotifyConfirm(pHandler, numRetired,
+                                                                                   status.success() ? deliveredEvents : NULL);
         break;
 
     case kState_SubscriptionEstablished_Notifying:
@@ -1677,20 +1837,23 @@ void SubscriptionHandler::OnMessageReceivedFromLocallyHeldExchange(nl::Weave::Ex
             ExitNow(err = WEAVE_ERROR_STATUS_REPORT_RECEIVED);
         }
 
+        VerifyOrExit(NULL != notify, err = WEAVE_ERROR_INCORRECT_STATE);
+
         // don't call flush for us in the end
         RetainExchangeContext = true;
 
-        // Only prompt the NotificationEngine if we received a status report indicating success. Otherwise, the subscription will
-        // get torn down and as part of that clean-up, a similar invocation of OnNotifyConfirm will happen.
-        SubscriptionEngine::GetInstance()->GetNotificationEngine()->OnNotifyConfirm(pHandler, status.success());
-
-        // flush right here, for NotificationEngine::Run() only flushes when a new notification is needed
-        // make it clear that we do not need this EC anymore
-        pHandler->FlushExistingExchangeContext();
+        // make it clear that we do not need this EC anymore, even if earlier notifies are still awaiting their confirmation
+        FlushExchangeContext(notify->mEC, false);
         aEC = NULL;
 
-        // kick back from kState_SubscriptionEstablished_Notifying to kState_SubscriptionEstablished_Idle and evaluate again
-        pHandler->MoveToState(kState_SubscriptionEstablished_Idle);
+        notify->mConfirmed = true;
+        numRetired         = pHandler->RetireInFlightNotifies(deliveredEvents);
+
+        // kick back from kState_SubscriptionEstablished_Notifying to kState_SubscriptionEstablished_Idle once nothing is in flight
+        if (pHandler->mNumInFlightNotifies == 0)
+        {
+            pHandler->MoveToState(kState_SubscriptionEstablished_Idle);
+        }
 
         err = pHandler->RefreshTimer();
         SuccessOrExit(err);
@@ -1699,11 +1862,16 @@ void SubscriptionHandler::OnMessageReceivedFromLocallyHeldExchange(nl::Weave::Ex
         (void) SubscriptionEngine::GetInstance()->UpdateClientLiveness(pHandler->mPeerNodeId, pHandler->mSubscriptionId);
 #endif // WDM_ENABLE_SUBSCRIPTION_CLIENT
 
-        // kick notification engine again
-        // Note: we could have a new pHandler->mEC here, for sending out the next notification request.
-        // when that happens, we're again in kState_SubscriptionEstablished_Notifying
-        // Note that the call to NotificationEngine::Run could actually cause this particular handler to be aborted
-        SubscriptionEngine::GetInstance()->GetNotificationEngine()->Run();
+        // Only prompt the NotificationEngine if we received a status report indicating success. Otherwise, the subscription will
+        // get torn down and as part of that clean-up, a similar invocation of OnNotifyConfirm will happen.
+        // Note: we could have a new notify in flight after this, in which case we're again in
+        // kState_SubscriptionEstablished_Notifying
+        // Note that the call to NotificationEngine::Run from here could actually cause this particular handler to be aborted
+        if (numRetired > 0)
+        {
+            SubscriptionEngine::GetInstance()->GetNotificationEngine()->OnNotifyConfirm(pHandler, numRetired,
+                                                                                       status.success() ? deliveredEvents : NULL);
+        }
         break;
 
 #if WDM_ENABLE_SUBSCRIPTION_CANCEL
@@ -1750,6 +1918,648 @@ void SubscriptionHandler::SetMaxNotificationSize(const uint32_t aMaxSize)
         mMaxNotificationSize = aMaxSize;
 }
 
+WEAVE_ERROR SubscriptionHandler::SetNotifyPipelineDepth(const uint8_t aDepth)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(aDepth > 0 && aDepth <= WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    mNotifyPipelineDepth = aDepth;
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR SubscriptionHandler::SetNotifyCoalescing(const uint32_t aMinIntervalMsec, const uint32_t aMaxLatencyMsec)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(aMinIntervalMsec == 0 || aMaxLatencyMsec >= aMinIntervalMsec, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    mNotifyMinIntervalMsec = aMinIntervalMsec;
+    mNotifyMaxLatencyMsec  = aMaxLatencyMsec;
+
+exit:
+    return err;
+}
+
+void SubscriptionHandler::ResetNotifyCoalescing(void)
+{
+    mNotifyMinIntervalMsec = WDM_PUBLISHER_DEFAULT_NOTIFY_MIN_INTERVAL_MSEC;
+    mNotifyMaxLatencyMsec  = WDM_PUBLISHER_DEFAULT_NOTIFY_MAX_LATENCY_MSEC;
+    mFirstHeldChangeMsec   = 0;
+    mLastHeldChangeMsec    = 0;
+    mHasHeldChanges        = false;
+}
+
+void SubscriptionHandler::NoteDataChange(const uint64_t aNowMsec)
+{
+    if (!mHasHeldChanges)
+    {
+        mFirstHeldChangeMsec = aNowMsec;
+        mHasHeldChanges      = true;
+    }
+
+    mLastHeldChangeMsec = aNowMsec;
+}
+
+/**
+ * Decide whether a notify to this subscription should be held back to coalesce further data changes. If so, aHoldMsec is
+ * set to the time after which the subscription should be evaluated again. Otherwise the held changes are released and
+ * the caller is expected to notify.
+ */
+bool SubscriptionHandler::IsNotifyHeld(const uint64_t aNowMsec, uint32_t & aHoldMsec)
+{
+    uint64_t releaseMsec;
+
+    // Coalescing only applies to established subscriptions, including those with notifies in flight; the initial notifies
+    // always go out immediately.
+    if (mNotifyMinIntervalMsec == 0 || !mHasHeldChanges ||
+        (mCurrentState != kState_SubscriptionEstablished_Idle && mCurrentState != kState_SubscriptionEstablished_Notifying))
+    {
+        mHasHeldChanges = false;
+        return false;
+    }
+
+    releaseMsec = mLastHeldChangeMsec + mNotifyMinIntervalMsec;
+    if (releaseMsec > mFirstHeldChangeMsec + mNotifyMaxLatencyMsec)
+    {
+        releaseMsec = mFirstHeldChangeMsec + mNotifyMaxLatencyMsec;
+    }
+
+    if (aNowMsec >= releaseMsec)
+    {
+        mHasHeldChanges = false;
+        return false;
+    }
+
+    aHoldMsec = static_cast<uint32_t>(releaseMsec - aNowMsec);
+    return true;
+}
+
+#if WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+
+namespace {
+
+// Tags of the structure that SubscriptionHandler::Checkpoint writes for a subscription
+enum
+{
+    kCsTag_Checkpoint_SubscriptionId       = 1,
+    kCsTag_Checkpoint_PeerNodeId           = 2,
+    kCsTag_Checkpoint_PeerAddress          = 3,
+    kCsTag_Checkpoint_PeerPort             = 4,
+    kCsTag_Checkpoint_ReliableMessaging    = 5,
+    kCsTag_Checkpoint_KeyId                = 6,
+    kCsTag_Checkpoint_EncryptionType       = 7,
+    kCsTag_Checkpoint_ResponseTimeout      = 8,
+    kCsTag_Checkpoint_LivenessTimeout      = 9,
+    kCsTag_Checkpoint_MaxNotificationSize  = 10,
+    kCsTag_Checkpoint_DeltaNotifications   = 11,
+    kCsTag_Checkpoint_NotifyPipelineDepth  = 12,
+    kCsTag_Checkpoint_NotifyMinInterval    = 13,
+    kCsTag_Checkpoint_NotifyMaxLatency     = 14,
+    kCsTag_Checkpoint_TraitInstances       = 15,
+    kCsTag_Checkpoint_SubscribeToAllEvents = 16,
+    kCsTag_Checkpoint_SelfVendedEvents     = 17,
+};
+
+// Tags of the structure written for each trait instance of a subscription
+enum
+{
+    kCsTag_CheckpointTrait_Path             = 1,
+    kCsTag_CheckpointTrait_RequestedVersion = 2,
+    kCsTag_CheckpointTrait_Version          = 3,
+    kCsTag_CheckpointTrait_Dirty            = 4,
+};
+
+// A session key outlives a restart only if it has been saved in the session key store of the fabric state
+bool IsStoredSessionKey(WeaveFabricState * aFabricState, uint32_t aKeyId, uint64_t aPeerNodeId)
+{
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE
+    WeaveSessionKey * sessionKey;
+
+    return aFabricState->SessionKeyStore != NULL &&
+        aFabricState->GetSessionKey(static_cast<uint16_t>(aKeyId), aPeerNodeId, sessionKey) == WEAVE_NO_ERROR &&
+        sessionKey->IsStored();
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+/**
+ * A subscription can only be checkpointed while it is established and has no notify in flight, and only if the subscriber
+ * could be reached the same way after a restart, i.e. over UDP, at an address that does not depend on an interface, and
+ * either without a session key or with one saved in the session key store.
+ */
+bool SubscriptionHandler::IsCheckpointable(void) const
+{
+    nl::Inet::IPAddress peerAddress;
+    uint16_t peerPort;
+    InterfaceId interfaceId;
+
+    if (mCurrentState != kState_SubscriptionEstablished_Idle || mNumInFlightNotifies != 0 || mIsInitiator)
+    {
+        return false;
+    }
+
+    if (!mBinding->IsUDPTransport())
+    {
+        return false;
+    }
+
+    if (WeaveKeyId::IsSessionKey(mBinding->GetKeyId()) &&
+        !IsStoredSessionKey(mBinding->GetExchangeManager()->FabricState, mBinding->GetKeyId(), mBinding->GetPeerNodeId()))
+    {
+        return false;
+    }
+
+    mBinding->GetPeerIPAddress(peerAddress, peerPort, interfaceId);
+
+    return !peerAddress.IsIPv6LinkLocal();
+}
+
+WEAVE_ERROR SubscriptionHandler::Checkpoint(nl::Weave::TLV::TLVWriter & aWriter, const uint64_t aTag)
+{
+    WEAVE_ERROR err                             = WEAVE_NO_ERROR;
+    TraitCatalogBase<TraitDataSource> * catalog = SubscriptionEngine::GetInstance()->mPublisherCatalog;
+    nl::Weave::TLV::TLVType containerType, listContainerType, itemContainerType, pathContainerType;
+    nl::Inet::IPAddress peerAddress;
+    uint16_t peerPort;
+    InterfaceId interfaceId;
+    uint8_t addressBuf[16];
+    uint8_t * p = addressBuf;
+
+    VerifyOrExit(IsCheckpointable(), err = WEAVE_ERROR_INCORRECT_STATE);
+
+    mBinding->GetPeerIPAddress(peerAddress, peerPort, interfaceId);
+    peerAddress.WriteAddress(p);
+
+    err = aWriter.StartContainer(aTag, nl::Weave::TLV::kTLVType_Structure, containerType);
+    SuccessOrExit(err);
+
+    err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_SubscriptionId), mSubscriptionId);
+    SuccessOrExit(err);
+
+    err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_PeerNodeId), mBinding->GetPeerNodeId());
+    SuccessOrExit(err);
+
+    err = aWriter.PutBytes(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_PeerAddress), addressBuf, sizeof(addressBuf));
+    SuccessOrExit(err);
+
+    err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_PeerPort), peerPort);
+    SuccessOrExit(err);
+
+    err = aWriter.PutBoolean(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_ReliableMessaging), mBinding->IsWRMTransport());
+    SuccessOrExit(err);
+
+    err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_KeyId), mBinding->GetKeyId());
+    SuccessOrExit(err);
+
+    err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_EncryptionType), mBinding->GetEncryptionType());
+    SuccessOrExit(err);
+
+    err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_ResponseTimeout), mBinding->GetDefaultResponseTimeout());
+    SuccessOrExit(err);
+
+    err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_LivenessTimeout), mLivenessTimeoutMsec);
+    SuccessOrExit(err);
+
+    err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_MaxNotificationSize), mMaxNotificationSize);
+    SuccessOrExit(err);
+
+    err = aWriter.PutBoolean(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_DeltaNotifications), mDeltaNotifications);
+    SuccessOrExit(err);
+
+    err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_NotifyPipelineDepth), mNotifyPipelineDepth);
+    SuccessOrExit(err);
+
+    err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_NotifyMinInterval), mNotifyMinIntervalMsec);
+    SuccessOrExit(err);
+
+    err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_NotifyMaxLatency), mNotifyMaxLatencyMsec);
+    SuccessOrExit(err);
+
+    err = aWriter.StartContainer(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_TraitInstances), nl::Weave::TLV::kTLVType_Array,
+                                 listContainerType);
+    SuccessOrExit(err);
+
+    for (size_t i = 0; i < mNumTraitInstances; ++i)
+    {
+        TraitInstanceInfo * traitInstance = &mTraitInstanceList[i];
+        TraitDataSource * dataSource;
+        SchemaVersionRange versionRange;
+
+        err = catalog->Locate(traitInstance->mTraitDataHandle, &dataSource);
+        SuccessOrExit(err);
+
+        err = aWriter.StartContainer(nl::Weave::TLV::AnonymousTag, nl::Weave::TLV::kTLVType_Structure, itemContainerType);
+        SuccessOrExit(err);
+
+        err = aWriter.StartContainer(nl::Weave::TLV::ContextTag(kCsTag_CheckpointTrait_Path), nl::Weave::TLV::kTLVType_Path,
+                                     pathContainerType);
+        SuccessOrExit(err);
+
+        err = catalog->HandleToAddress(traitInstance->mTraitDataHandle, aWriter, versionRange);
+        SuccessOrExit(err);
+
+        err = aWriter.EndContainer(pathContainerType);
+        SuccessOrExit(err);
+
+        err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_CheckpointTrait_RequestedVersion), traitInstance->mRequestedVersion);
+        SuccessOrExit(err);
+
+        // The version of the data source is saved so that it can be restored after a restart, when data sources start
+        // over at a random version.
+        err = aWriter.Put(nl::Weave::TLV::ContextTag(kCsTag_CheckpointTrait_Version), dataSource->GetVersion());
+        SuccessOrExit(err);
+
+        // A trait instance that is still dirty has changes the subscriber has not seen, and is notified in full once the
+        // subscription is restored.
+        if (traitInstance->IsDirty())
+        {
+            err = aWriter.PutBoolean(nl::Weave::TLV::ContextTag(kCsTag_CheckpointTrait_Dirty), true);
+            SuccessOrExit(err);
+        }
+
+        err = aWriter.EndContainer(itemContainerType);
+        SuccessOrExit(err);
+    }
+
+    err = aWriter.EndContainer(listContainerType);
+    SuccessOrExit(err);
+
+    err = aWriter.PutBoolean(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_SubscribeToAllEvents), mSubscribeToAllEvents);
+    SuccessOrExit(err);
+
+    err = aWriter.StartContainer(nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_SelfVendedEvents), nl::Weave::TLV::kTLVType_Array,
+                                 listContainerType);
+    SuccessOrExit(err);
+
+    for (size_t i = 0; i < sizeof(mSelfVendedEvents) / sizeof(mSelfVendedEvents[0]); ++i)
+    {
+        err = aWriter.Put(nl::Weave::TLV::AnonymousTag, mSelfVendedEvents[i]);
+        SuccessOrExit(err);
+    }
+
+    err = aWriter.EndContainer(listContainerType);
+    SuccessOrExit(err);
+
+    err = aWriter.EndContainer(containerType);
+    SuccessOrExit(err);
+
+exit:
+    WeaveLogFunctError(err);
+
+    return err;
+}
+
+/**
+ * Resume a subscription from the structure written by Checkpoint, on which aReader is positioned, configuring aBinding to
+ * reach the subscriber. The subscription is resumed in the established state. The data source of each trait instance is set
+ * back to its checkpointed version, and the trait instances that were dirty when checkpointed are marked dirty again.
+ */
+WEAVE_ERROR SubscriptionHandler::InitWithCheckpoint(Binding * const aBinding, nl::Weave::TLV::TLVReader & aReader)
+{
+    WEAVE_ERROR err                             = WEAVE_NO_ERROR;
+    TraitCatalogBase<TraitDataSource> * catalog = SubscriptionEngine::GetInstance()->mPublisherCatalog;
+    nl::Weave::TLV::TLVType containerType, listContainerType, itemContainerType;
+    nl::Inet::IPAddress peerAddress;
+    uint64_t peerNodeId;
+    uint16_t peerPort;
+    bool isReliable;
+    uint32_t keyId;
+    uint8_t encryptionType;
+    uint32_t responseTimeoutMsec;
+    uint16_t maxNotificationSize;
+    uint8_t pipelineDepth;
+    uint32_t minIntervalMsec, maxLatencyMsec;
+    uint8_t addressBuf[16];
+    uint8_t * p = addressBuf;
+
+    WeaveLogDetail(DataManagement, "Handler[%u] [%5.5s] %s Ref(%d)", SubscriptionEngine::GetInstance()->GetHandlerId(this),
+                   GetStateStr(), __func__, mRefCount);
+
+    WeaveLogIfFalse(0 == mRefCount);
+
+    _AddRef();
+
+    aBinding->AddRef();
+    mBinding = aBinding;
+
+    // Add the reference held by the protocol state machine, as in InitWithIncomingRequest
+    _AddRef();
+    MoveToState(kState_Subscribing_Evaluating);
+
+    VerifyOrExit(nl::Weave::TLV::kTLVType_Structure == aReader.GetType(), err = WEAVE_ERROR_WRONG_TLV_TYPE);
+
+    err = aReader.EnterContainer(containerType);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_SubscriptionId));
+    SuccessOrExit(err);
+
+    err = aReader.Get(mSubscriptionId);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_PeerNodeId));
+    SuccessOrExit(err);
+
+    err = aReader.Get(peerNodeId);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_ByteString, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_PeerAddress));
+    SuccessOrExit(err);
+
+    VerifyOrExit(aReader.GetLength() == sizeof(addressBuf), err = WEAVE_ERROR_INVALID_TLV_ELEMENT);
+
+    err = aReader.GetBytes(addressBuf, sizeof(addressBuf));
+    SuccessOrExit(err);
+
+    nl::Inet::IPAddress::ReadAddress(p, peerAddress);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_PeerPort));
+    SuccessOrExit(err);
+
+    err = aReader.Get(peerPort);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_Boolean, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_ReliableMessaging));
+    SuccessOrExit(err);
+
+    err = aReader.Get(isReliable);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_KeyId));
+    SuccessOrExit(err);
+
+    err = aReader.Get(keyId);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_EncryptionType));
+    SuccessOrExit(err);
+
+    err = aReader.Get(encryptionType);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_ResponseTimeout));
+    SuccessOrExit(err);
+
+    err = aReader.Get(responseTimeoutMsec);
+    SuccessOrExit(err);
+
+    {
+        Binding::Configuration config = mBinding->BeginConfiguration();
+
+        config.Target_NodeId(peerNodeId).TargetAddress_IP(peerAddress, peerPort).Exchange_ResponseTimeoutMsec(responseTimeoutMsec);
+
+        if (isReliable)
+        {
+            config.Transport_UDP_WRM();
+        }
+        else
+        {
+            config.Transport_UDP();
+        }
+
+        if (keyId == WeaveKeyId::kNone)
+        {
+            config.Security_None();
+        }
+        else
+        {
+            // A session that is no longer in the session key store cannot be resumed; the subscriber has to subscribe again
+            VerifyOrExit(!WeaveKeyId::IsSessionKey(keyId) ||
+                             IsStoredSessionKey(mBinding->GetExchangeManager()->FabricState, keyId, peerNodeId),
+                         err = WEAVE_ERROR_KEY_NOT_FOUND);
+
+            config.Security_Key(keyId).Security_EncryptionType(encryptionType);
+        }
+
+        err = config.PrepareBinding();
+        SuccessOrExit(err);
+    }
+
+    mPeerNodeId     = peerNodeId;
+    mBytesOffloaded = 0;
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_LivenessTimeout));
+    SuccessOrExit(err);
+
+    err = aReader.Get(mLivenessTimeoutMsec);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger,
+                       nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_MaxNotificationSize));
+    SuccessOrExit(err);
+
+    err = aReader.Get(maxNotificationSize);
+    SuccessOrExit(err);
+
+    SetMaxNotificationSize(maxNotificationSize);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_Boolean, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_DeltaNotifications));
+    SuccessOrExit(err);
+
+    err = aReader.Get(mDeltaNotifications);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger,
+                       nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_NotifyPipelineDepth));
+    SuccessOrExit(err);
+
+    err = aReader.Get(pipelineDepth);
+    SuccessOrExit(err);
+
+    // The depth may have been saved by a build that allowed deeper pipelines
+    if (pipelineDepth > WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION)
+    {
+        pipelineDepth = WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION;
+    }
+
+    err = SetNotifyPipelineDepth(pipelineDepth);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_NotifyMinInterval));
+    SuccessOrExit(err);
+
+    err = aReader.Get(minIntervalMsec);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_NotifyMaxLatency));
+    SuccessOrExit(err);
+
+    err = aReader.Get(maxLatencyMsec);
+    SuccessOrExit(err);
+
+    err = SetNotifyCoalescing(minIntervalMsec, maxLatencyMsec);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_Array, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_TraitInstances));
+    SuccessOrExit(err);
+
+    err = aReader.EnterContainer(listContainerType);
+    SuccessOrExit(err);
+
+    while (WEAVE_NO_ERROR == (err = aReader.Next()))
+    {
+        TraitDataHandle traitDataHandle;
+        TraitDataSource * dataSource;
+        TraitInstanceInfo * traitInstance;
+        SchemaVersionRange versionRange;
+        uint16_t requestedVersion;
+        uint64_t version;
+        bool isDirty;
+
+        VerifyOrExit(nl::Weave::TLV::kTLVType_Structure == aReader.GetType(), err = WEAVE_ERROR_WRONG_TLV_TYPE);
+
+        err = aReader.EnterContainer(itemContainerType);
+        SuccessOrExit(err);
+
+        err = aReader.Next(nl::Weave::TLV::kTLVType_Path, nl::Weave::TLV::ContextTag(kCsTag_CheckpointTrait_Path));
+        SuccessOrExit(err);
+
+        {
+            nl::Weave::TLV::TLVReader pathReader;
+
+            pathReader.Init(aReader);
+
+            // A trait instance that is no longer published cannot be resumed; the subscriber has to subscribe again
+            err = catalog->AddressToHandle(pathReader, traitDataHandle, versionRange);
+            SuccessOrExit(err);
+        }
+
+        err = catalog->Locate(traitDataHandle, &dataSource);
+        SuccessOrExit(err);
+
+        err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger,
+                           nl::Weave::TLV::ContextTag(kCsTag_CheckpointTrait_RequestedVersion));
+        SuccessOrExit(err);
+
+        err = aReader.Get(requestedVersion);
+        SuccessOrExit(err);
+
+        traitInstance = SubscriptionEngine::GetInstance()->NewTraitInfo(this);
+        VerifyOrExit(NULL != traitInstance, err = WEAVE_ERROR_NO_MEMORY);
+
+        SYSTEM_STATS_INCREMENT(nl::Weave::System::Stats::kWDM_NumTraits);
+
+        traitInstance->mTraitDataHandle  = traitDataHandle;
+        traitInstance->mRequestedVersion = requestedVersion;
+
+        err = aReader.Next(nl::Weave::TLV::kTLVType_UnsignedInteger, nl::Weave::TLV::ContextTag(kCsTag_CheckpointTrait_Version));
+        SuccessOrExit(err);
+
+        err = aReader.Get(version);
+        SuccessOrExit(err);
+
+        // Versions restored by several subscriptions to the same trait instance are the same, as they are checkpointed together
+        dataSource->SetVersion(version);
+
+        err = aReader.Next();
+        if (WEAVE_NO_ERROR == err)
+        {
+            VerifyOrExit(aReader.GetTag() == nl::Weave::TLV::ContextTag(kCsTag_CheckpointTrait_Dirty),
+                         err = WEAVE_ERROR_INVALID_TLV_TAG);
+
+            err = aReader.Get(isDirty);
+            SuccessOrExit(err);
+
+            if (isDirty)
+            {
+                WeaveLogDetail(DataManagement, "Handler[%u] Syncing is necessary for trait[%u]",
+                               SubscriptionEngine::GetInstance()->GetHandlerId(this), traitDataHandle);
+
+                traitInstance->SetDirty();
+            }
+        }
+        else
+        {
+            VerifyOrExit(WEAVE_END_OF_TLV == err, /* no-op */);
+        }
+
+        // The changes to a trait instance made before the restart are not in the dirty stores of the graph solver, so a
+        // trait instance the subscriber is behind on has to be notified in full.
+        if (traitInstance->IsDirty())
+        {
+#if (WEAVE_CONFIG_WDM_PUBLISHER_GRAPH_SOLVER == IntermediateGraphSolver)
+            dataSource->SetRootDirty();
+#endif
+        }
+
+        err = aReader.ExitContainer(itemContainerType);
+        SuccessOrExit(err);
+    }
+
+    VerifyOrExit(WEAVE_END_OF_TLV == err, /* no-op */);
+
+    err = aReader.ExitContainer(listContainerType);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_Boolean, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_SubscribeToAllEvents));
+    SuccessOrExit(err);
+
+    err = aReader.Get(mSubscribeToAllEvents);
+    SuccessOrExit(err);
+
+    err = aReader.Next(nl::Weave::TLV::kTLVType_Array, nl::Weave::TLV::ContextTag(kCsTag_Checkpoint_SelfVendedEvents));
+    SuccessOrExit(err);
+
+    err = aReader.EnterContainer(listContainerType);
+    SuccessOrExit(err);
+
+    for (size_t i = 0; i < sizeof(mSelfVendedEvents) / sizeof(mSelfVendedEvents[0]); ++i)
+    {
+        err = aReader.Next();
+        if (WEAVE_END_OF_TLV == err)
+        {
+            err = WEAVE_NO_ERROR;
+            break;
+        }
+        SuccessOrExit(err);
+
+        err = aReader.Get(mSelfVendedEvents[i]);
+        SuccessOrExit(err);
+    }
+
+    err = aReader.ExitContainer(listContainerType);
+    SuccessOrExit(err);
+
+    err = aReader.ExitContainer(containerType);
+    SuccessOrExit(err);
+
+    MoveToState(kState_SubscriptionEstablished_Idle);
+
+    err = RefreshTimer();
+    SuccessOrExit(err);
+
+    {
+        InEventParam inParam;
+        OutEventParam outParam;
+        inParam.mSubscriptionEstablished.mSubscriptionId = mSubscriptionId;
+        inParam.mSubscriptionEstablished.mHandler        = this;
+
+        // Note we could be aborted in this callback
+        mEventCallback(mAppState, kEvent_OnSubscriptionEstablished, inParam, outParam);
+    }
+
+exit:
+    WeaveLogFunctError(err);
+
+    if (WEAVE_NO_ERROR != err)
+    {
+        // The subscriber is not told; it will find out when its subscription times out
+        AbortSubscription();
+    }
+
+    _Release();
+
+    return err;
+}
+
+#endif // WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+
 }; // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
 }; // namespace Profiles
 }; // namespace Weave
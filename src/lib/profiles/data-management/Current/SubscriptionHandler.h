@@ -55,7 +55,11 @@ public:
 
     struct TraitInstanceInfo
     {
-        void Init(void) { this->ClearDirty(); }
+        void Init(void)
+        {
+            this->ClearDirty();
+            mNotifySeq = 0;
+        }
         bool IsDirty(void) { return mDirty; }
         void SetDirty(void) { mDirty = true; }
         void ClearDirty(void) { mDirty = false; }
@@ -63,6 +67,10 @@ public:
         TraitDataHandle mTraitDataHandle;
         uint16_t mRequestedVersion;
         bool mDirty;
+
+        // Sequence number of the last notify that carried this trait instance, or 0 if none. The trait instance is in flight
+        // for as long as that notify awaits confirmation.
+        uint8_t mNotifySeq;
     };
 
     enum EventID
@@ -183,6 +191,37 @@ public:
 
     void SetMaxNotificationSize(const uint32_t aMaxPayload);
 
+    /**
+     * @brief Configure notification coalescing for this subscription.
+     *
+     * Once the subscription is established, data changes are held until no further change has been seen for
+     * aMinIntervalMsec, or until the oldest held change is aMaxLatencyMsec old, whichever comes first. A minimum
+     * interval of zero disables coalescing.
+     *
+     * @retval #WEAVE_ERROR_INVALID_ARGUMENT if coalescing is enabled and aMaxLatencyMsec is less than aMinIntervalMsec.
+     */
+    WEAVE_ERROR SetNotifyCoalescing(const uint32_t aMinIntervalMsec, const uint32_t aMaxLatencyMsec);
+
+    /**
+     * @brief Enable or disable delta notifications for this subscription.
+     *
+     * When enabled, changes to several properties of a trait instance are notified as one data element per changed property,
+     * rather than as a single data element rooted at their common ancestor, if that is the smaller of the two encodings.
+     */
+    void SetDeltaNotifications(const bool aEnable) { mDeltaNotifications = aEnable; }
+    bool IsDeltaNotificationEnabled(void) const { return mDeltaNotifications; }
+
+    /**
+     * @brief Set the number of notifies this subscription may have in flight once it is established.
+     *
+     * A depth of 1 waits for each notify to be confirmed before sending the next. Larger depths pipeline notifies to the
+     * subscriber, and their confirmations are retired in the order the notifies were sent.
+     *
+     * @retval #WEAVE_ERROR_INVALID_ARGUMENT if aDepth is zero or exceeds WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION.
+     */
+    WEAVE_ERROR SetNotifyPipelineDepth(const uint8_t aDepth);
+    uint8_t GetNotifyPipelineDepth(void) const { return mNotifyPipelineDepth; }
+
 private:
     friend class SubscriptionEngine;
     friend class NotificationEngine;
@@ -219,7 +258,8 @@ private:
 
     bool IsNotifiable(void)
     {
-        return (mCurrentState == kState_Subscribing || mCurrentState == kState_SubscriptionEstablished_Idle);
+        return (mCurrentState == kState_Subscribing || mCurrentState == kState_SubscriptionEstablished_Idle ||
+                (mCurrentState == kState_SubscriptionEstablished_Notifying && mNumInFlightNotifies < mNotifyPipelineDepth));
     }
     bool IsSubscribing(void)
     {
@@ -247,6 +287,64 @@ private:
     uint16_t mNumTraitInstances;
     uint16_t mMaxNotificationSize;
     uint32_t mCurProcessingTraitInstanceIdx;
+    bool mDeltaNotifications;
+
+    uint32_t mNotifyMinIntervalMsec;
+    uint32_t mNotifyMaxLatencyMsec;
+    uint64_t mFirstHeldChangeMsec;
+    uint64_t mLastHeldChangeMsec;
+    bool mHasHeldChanges;
+
+    // Notifies awaiting confirmation, oldest first, in a ring of WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION slots.
+    // Established notifies each own their exchange context; a priming notify uses mEC and leaves mEC in its slot NULL.
+    struct InFlightNotify
+    {
+        nl::Weave::ExchangeContext * mEC;
+        event_id_t mSelfVendedEvents[kImportanceType_Last - kImportanceType_First + 1];
+        uint8_t mSeq;
+        bool mConfirmed;
+    };
+
+    InFlightNotify mInFlightNotifies[WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION];
+    uint8_t mFirstInFlightNotify;
+    uint8_t mNumInFlightNotifies;
+    uint8_t mNotifyPipelineDepth;
+    uint8_t mNextNotifySeq;
+
+    void ResetInFlightNotifies(void);
+    void PushInFlightNotify(nl::Weave::ExchangeContext * const aEC);
+    InFlightNotify * FindInFlightNotify(const nl::Weave::ExchangeContext * const aEC);
+    uint8_t RetireInFlightNotifies(event_id_t * aDeliveredEvents);
+    uint8_t FlushInFlightNotifies(void);
+    bool IsTraitNotifyInFlight(const TraitInstanceInfo * const aTraitInfo) const;
+
+    void NoteDataChange(const uint64_t aNowMsec);
+    bool IsNotifyHeld(const uint64_t aNowMsec, uint32_t & aHoldMsec);
+    void ResetNotifyCoalescing(void);
+
+    // Resume point of a priming snapshot of a trait instance too large for a single notify. The snapshot is sent as one
+    // data element per top-level property, and a dictionary property as one data element per run of items that fits.
+    struct SnapshotCursor
+    {
+        void Reset(void)
+        {
+            mTraitDataHandle      = 0;
+            mPropertyHandle       = kNullPropertyPathHandle;
+            mDictionaryItemHandle = kNullPropertyPathHandle;
+            mVersion              = 0;
+        }
+        bool IsActive(const TraitDataHandle aTraitDataHandle) const
+        {
+            return (mPropertyHandle != kNullPropertyPathHandle && mTraitDataHandle == aTraitDataHandle);
+        }
+
+        TraitDataHandle mTraitDataHandle;
+        PropertyPathHandle mPropertyHandle;       // Top-level property to resume at.
+        PropertyPathHandle mDictionaryItemHandle; // Item (i.e. key) to resume at within a dictionary property, or null.
+        uint64_t mVersion;                        // Version of the data source when the snapshot was started.
+    };
+
+    SnapshotCursor mSnapshotCursor;
 
     TraitInstanceInfo * GetTraitInstanceInfoList(void) { return mTraitInstanceList; }
     uint32_t GetNumTraitInstances(void) { return mNumTraitInstances; }
@@ -278,8 +376,10 @@ private:
     const char * GetStateStr() const;
 
     WEAVE_ERROR ReplaceExchangeContext(void);
-    void InitExchangeContext(void);
+    WEAVE_ERROR NewExchangeContext(nl::Weave::ExchangeContext *& aEC);
+    void InitExchangeContext(nl::Weave::ExchangeContext * const aEC);
     void FlushExistingExchangeContext(const bool aAbortNow = false);
+    static void FlushExchangeContext(nl::Weave::ExchangeContext *& aEC, const bool aAbortNow);
 
     void InitWithIncomingRequest(Binding * const aBinding, const uint64_t aRandomNumber, nl::Weave::ExchangeContext * aEC,
                                  const nl::Inet::IPPacketInfo * aPktInfo, const nl::Weave::WeaveMessageInfo * aMsgInfo,
@@ -304,6 +404,12 @@ private:
 
     void InitAsFree(void);
 
+#if WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+    bool IsCheckpointable(void) const;
+    WEAVE_ERROR Checkpoint(nl::Weave::TLV::TLVWriter & aWriter, const uint64_t aTag);
+    WEAVE_ERROR InitWithCheckpoint(Binding * const aBinding, nl::Weave::TLV::TLVReader & aReader);
+#endif // WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+
     WEAVE_ERROR ParsePathVersionEventLists(SubscribeRequest::Parser & aRequest, uint32_t & aRejectReasonProfileId,
                                            uint16_t & aRejectReasonStatusCode);
 
@@ -36,6 +36,8 @@
 #include <Weave/Profiles/data-management/MessageDef.h>
 #include <Weave/Support/CodeUtils.h>
 
+#include <stdlib.h>
+
 namespace nl {
 namespace Weave {
 namespace Profiles {
@@ -194,6 +196,96 @@ private:
 typedef SingleResourceTraitCatalog<TraitDataSink> SingleResourceSinkTraitCatalog;
 typedef SingleResourceTraitCatalog<TraitDataSource> SingleResourceSourceTraitCatalog;
 
+/*
+ *  @class MultiResourceTraitCatalog
+ *
+ *  @brief A Weave provided implementation of the TraitCatalogBase interface for a collection of trait data instances
+ *         belonging to any number of resources. Instances are indexed by (resource, profile, instance) and by instance
+ *         pointer in hash tables, and storage is allocated from the heap and grows as instances are added.
+ *
+ *         A path that omits the resource refers to the publishing node, i.e. ResourceIdentifier::SELF_NODE_ID.
+ */
+template <typename T>
+class MultiResourceTraitCatalog : public TraitCatalogBase<T>
+{
+public:
+    MultiResourceTraitCatalog(void);
+    ~MultiResourceTraitCatalog(void);
+
+    /*
+     * Add a new trait data instance into the catalog and return a handle to it.
+     */
+    WEAVE_ERROR Add(const ResourceIdentifier & aResourceId, uint64_t aInstanceId, T * aItem, TraitDataHandle & aHandle);
+
+    /**
+     * Removes a trait instance from the catalog. The handle may be reused by a subsequent Add().
+     */
+    WEAVE_ERROR Remove(TraitDataHandle aHandle);
+
+    /**
+     * Removes all trait instances and releases the catalog's storage.
+     */
+    void Clear(void);
+
+    WEAVE_ERROR Locate(const ResourceIdentifier & aResourceId, uint64_t aProfileId, uint64_t aInstanceId,
+                       TraitDataHandle & aHandle) const;
+
+    /**
+     * Return the number of trait instances in the catalog.
+     */
+    uint32_t Count() const;
+
+public: // TraitCatalogBase
+    WEAVE_ERROR AddressToHandle(TLV::TLVReader & aReader, TraitDataHandle & aHandle,
+                                SchemaVersionRange & aSchemaVersionRange) const;
+    WEAVE_ERROR HandleToAddress(TraitDataHandle aHandle, TLV::TLVWriter & aWriter, SchemaVersionRange & aSchemaVersionRange) const;
+    WEAVE_ERROR Locate(TraitDataHandle aHandle, T ** aTraitInstance) const;
+    WEAVE_ERROR Locate(T * aTraitInstance, TraitDataHandle & aHandle) const;
+    WEAVE_ERROR DispatchEvent(uint16_t aEvent, void * aContext) const;
+    void Iterate(IteratorCallback aCallback, void * aContext);
+
+#if    WEAVE_CONFIG_ENABLE_WDM_UPDATE
+    WEAVE_ERROR GetInstanceId(TraitDataHandle aHandle, uint64_t &aInstanceId) const;
+    WEAVE_ERROR GetResourceId(TraitDataHandle aHandle, ResourceIdentifier &aResourceId) const;
+#endif // WEAVE_CONFIG_ENABLE_WDM_UPDATE
+
+private:
+    enum
+    {
+        kNullIndex          = 0xFFFF,
+        kMaxCatalogItems    = 0xFFFF,
+        kMinCapacity        = 16,
+    };
+
+    struct CatalogItem
+    {
+        ResourceIdentifier mResourceId;
+        uint64_t mInstanceId;
+        T * mItem;                          // NULL if the slot is free
+        uint32_t mProfileId;
+        TraitDataHandle mNextByAddress;     // Next item in the same address bucket, or next free slot
+        TraitDataHandle mNextByItem;        // Next item in the same instance pointer bucket
+    };
+
+    // Both indexes have mCapacity buckets, which is always a power of two.
+    CatalogItem * mCatalogStore;
+    TraitDataHandle * mAddressBuckets;
+    TraitDataHandle * mItemBuckets;
+    uint32_t mCapacity;
+    uint32_t mNumSlotsUsed;
+    uint32_t mNumCurCatalogItems;
+    TraitDataHandle mFreeList;
+
+    static uint32_t HashAddress(const ResourceIdentifier & aResourceId, uint64_t aProfileId, uint64_t aInstanceId);
+    static uint32_t HashItem(const T * aItem);
+    bool IsValidHandle(TraitDataHandle aHandle) const;
+    WEAVE_ERROR Grow(void);
+    void LinkItem(TraitDataHandle aHandle);
+};
+
+typedef MultiResourceTraitCatalog<TraitDataSink> MultiResourceSinkTraitCatalog;
+typedef MultiResourceTraitCatalog<TraitDataSource> MultiResourceSourceTraitCatalog;
+
 template <typename T>
 SingleResourceTraitCatalog<T>::SingleResourceTraitCatalog(ResourceIdentifier aResourceIdentifier, CatalogItem * aCatalogStore,
                                                           uint32_t aNumMaxCatalogItems) :
@@ -459,6 +551,432 @@ WEAVE_ERROR SingleResourceTraitCatalog<T>::GetResourceId(TraitDataHandle aHandle
 
 #endif // WEAVE_CONFIG_ENABLE_WDM_UPDATE
 
+template <typename T>
+MultiResourceTraitCatalog<T>::MultiResourceTraitCatalog(void)
+{
+    mCatalogStore       = NULL;
+    mAddressBuckets     = NULL;
+    mItemBuckets        = NULL;
+    mCapacity           = 0;
+    mNumSlotsUsed       = 0;
+    mNumCurCatalogItems = 0;
+    mFreeList           = kNullIndex;
+}
+
+template <typename T>
+MultiResourceTraitCatalog<T>::~MultiResourceTraitCatalog(void)
+{
+    Clear();
+}
+
+template <typename T>
+void MultiResourceTraitCatalog<T>::Clear(void)
+{
+    free(mCatalogStore);
+    free(mAddressBuckets);
+    free(mItemBuckets);
+
+    mCatalogStore       = NULL;
+    mAddressBuckets     = NULL;
+    mItemBuckets        = NULL;
+    mCapacity           = 0;
+    mNumSlotsUsed       = 0;
+    mNumCurCatalogItems = 0;
+    mFreeList           = kNullIndex;
+}
+
+template <typename T>
+uint32_t MultiResourceTraitCatalog<T>::HashAddress(const ResourceIdentifier & aResourceId, uint64_t aProfileId,
+                                                   uint64_t aInstanceId)
+{
+    const uint64_t kMultiplier = 0x9E3779B97F4A7C15ULL;
+    uint64_t hash;
+
+    hash = (aResourceId.GetResourceId() ^ aResourceId.GetResourceType()) * kMultiplier;
+    hash = (hash ^ aProfileId) * kMultiplier;
+    hash = (hash ^ aInstanceId) * kMultiplier;
+
+    return (uint32_t) (hash >> 32);
+}
+
+template <typename T>
+uint32_t MultiResourceTraitCatalog<T>::HashItem(const T * aItem)
+{
+    return (uint32_t) (((uint64_t) (uintptr_t) aItem * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+template <typename T>
+bool MultiResourceTraitCatalog<T>::IsValidHandle(TraitDataHandle aHandle) const
+{
+    return aHandle < mNumSlotsUsed && mCatalogStore[aHandle].mItem != NULL;
+}
+
+template <typename T>
+void MultiResourceTraitCatalog<T>::LinkItem(TraitDataHandle aHandle)
+{
+    CatalogItem & item = mCatalogStore[aHandle];
+    uint32_t addressBucket = HashAddress(item.mResourceId, item.mProfileId, item.mInstanceId) & (mCapacity - 1);
+    uint32_t itemBucket    = HashItem(item.mItem) & (mCapacity - 1);
+
+    item.mNextByAddress            = mAddressBuckets[addressBucket];
+    mAddressBuckets[addressBucket] = aHandle;
+    item.mNextByItem               = mItemBuckets[itemBucket];
+    mItemBuckets[itemBucket]       = aHandle;
+}
+
+template <typename T>
+WEAVE_ERROR MultiResourceTraitCatalog<T>::Grow(void)
+{
+    WEAVE_ERROR err               = WEAVE_NO_ERROR;
+    uint32_t newCapacity          = (mCapacity == 0) ? kMinCapacity : mCapacity * 2;
+    CatalogItem * newStore        = NULL;
+    TraitDataHandle * newAddressBuckets = NULL;
+    TraitDataHandle * newItemBuckets    = NULL;
+
+    VerifyOrExit(mCapacity < kMaxCatalogItems, err = WEAVE_ERROR_NO_MEMORY);
+
+    newStore = (CatalogItem *) realloc(mCatalogStore, newCapacity * sizeof(CatalogItem));
+    VerifyOrExit(newStore != NULL, err = WEAVE_ERROR_NO_MEMORY);
+    mCatalogStore = newStore;
+
+    newAddressBuckets = (TraitDataHandle *) malloc(newCapacity * sizeof(TraitDataHandle));
+    newItemBuckets    = (TraitDataHandle *) malloc(newCapacity * sizeof(TraitDataHandle));
+    VerifyOrExit(newAddressBuckets != NULL && newItemBuckets != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+    free(mAddressBuckets);
+    free(mItemBuckets);
+    mAddressBuckets = newAddressBuckets;
+    mItemBuckets    = newItemBuckets;
+    mCapacity       = newCapacity;
+    newAddressBuckets = NULL;
+    newItemBuckets    = NULL;
+
+    // Rehash the live items into the larger indexes.
+    memset(mAddressBuckets, 0xFF, mCapacity * sizeof(TraitDataHandle));
+    memset(mItemBuckets, 0xFF, mCapacity * sizeof(TraitDataHandle));
+
+    for (uint32_t i = 0; i < mNumSlotsUsed; i++)
+    {
+        if (mCatalogStore[i].mItem != NULL)
+        {
+            LinkItem(i);
+        }
+    }
+
+exit:
+    free(newAddressBuckets);
+    free(newItemBuckets);
+    return err;
+}
+
+template <typename T>
+WEAVE_ERROR MultiResourceTraitCatalog<T>::Add(const ResourceIdentifier & aResourceId, uint64_t aInstanceId, T * aItem,
+                                              TraitDataHandle & aHandle)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint32_t profileId;
+    TraitDataHandle handle;
+
+    VerifyOrExit(aItem != NULL, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    profileId = aItem->GetSchemaEngine()->GetProfileId();
+
+    VerifyOrExit(Locate(aResourceId, profileId, aInstanceId, handle) != WEAVE_NO_ERROR, err = WEAVE_ERROR_DUPLICATE_KEY_ID);
+
+    if (mFreeList != kNullIndex)
+    {
+        handle    = mFreeList;
+        mFreeList = mCatalogStore[handle].mNextByAddress;
+    }
+    else
+    {
+        VerifyOrExit(mNumSlotsUsed < kMaxCatalogItems, err = WEAVE_ERROR_NO_MEMORY);
+
+        if (mNumSlotsUsed == mCapacity)
+        {
+            err = Grow();
+            SuccessOrExit(err);
+        }
+
+        handle = mNumSlotsUsed++;
+    }
+
+    mCatalogStore[handle].mResourceId = aResourceId;
+    mCatalogStore[handle].mInstanceId = aInstanceId;
+    mCatalogStore[handle].mItem       = aItem;
+    mCatalogStore[handle].mProfileId  = profileId;
+    LinkItem(handle);
+
+    mNumCurCatalogItems++;
+    aHandle = handle;
+
+exit:
+    return err;
+}
+
+template <typename T>
+WEAVE_ERROR MultiResourceTraitCatalog<T>::Remove(TraitDataHandle aHandle)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    CatalogItem * item;
+    TraitDataHandle * link;
+
+    VerifyOrExit(IsValidHandle(aHandle), err = WEAVE_ERROR_INVALID_ARGUMENT);
+    item = &mCatalogStore[aHandle];
+
+    link = &mAddressBuckets[HashAddress(item->mResourceId, item->mProfileId, item->mInstanceId) & (mCapacity - 1)];
+    while (*link != aHandle)
+        link = &mCatalogStore[*link].mNextByAddress;
+    *link = item->mNextByAddress;
+
+    link = &mItemBuckets[HashItem(item->mItem) & (mCapacity - 1)];
+    while (*link != aHandle)
+        link = &mCatalogStore[*link].mNextByItem;
+    *link = item->mNextByItem;
+
+    item->mItem          = NULL;
+    item->mNextByAddress = mFreeList;
+    mFreeList           = aHandle;
+    mNumCurCatalogItems--;
+
+exit:
+    return err;
+}
+
+template <typename T>
+WEAVE_ERROR MultiResourceTraitCatalog<T>::AddressToHandle(TLV::TLVReader & aReader, TraitDataHandle & aHandle,
+                                                          SchemaVersionRange & aSchemaVersionRange) const
+{
+    WEAVE_ERROR err     = WEAVE_NO_ERROR;
+    uint32_t profileId  = 0;
+    uint64_t instanceId = 0;
+    ResourceIdentifier resourceId(ResourceIdentifier::SELF_NODE_ID);
+    Path::Parser path;
+    nl::Weave::TLV::TLVReader reader;
+
+    err = path.Init(aReader);
+    SuccessOrExit(err);
+
+    err = path.GetProfileID(&profileId, &aSchemaVersionRange);
+    SuccessOrExit(err);
+
+    err = path.GetInstanceID(&instanceId);
+    if ((WEAVE_NO_ERROR != err) && (WEAVE_END_OF_TLV != err))
+    {
+        ExitNow();
+    }
+
+    err = path.GetResourceID(&reader);
+    if (err == WEAVE_NO_ERROR)
+    {
+        err = resourceId.FromTLV(reader);
+        SuccessOrExit(err);
+    }
+    else if (err == WEAVE_END_OF_TLV)
+    {
+        // no-op, element not found
+    }
+    else
+    {
+        ExitNow();
+    }
+
+    path.GetTags(&aReader);
+
+    VerifyOrExit(profileId != 0, err = WEAVE_ERROR_TLV_TAG_NOT_FOUND);
+
+    err = Locate(resourceId, profileId, instanceId, aHandle);
+    SuccessOrExit(err);
+
+exit:
+    return err;
+}
+
+template <typename T>
+WEAVE_ERROR MultiResourceTraitCatalog<T>::Locate(const ResourceIdentifier & aResourceId, uint64_t aProfileId, uint64_t aInstanceId,
+                                                 TraitDataHandle & aHandle) const
+{
+    if (mCapacity != 0)
+    {
+        TraitDataHandle i = mAddressBuckets[HashAddress(aResourceId, aProfileId, aInstanceId) & (mCapacity - 1)];
+
+        while (i != kNullIndex)
+        {
+            const CatalogItem & item = mCatalogStore[i];
+
+            if (item.mProfileId == aProfileId && item.mInstanceId == aInstanceId && item.mResourceId == aResourceId)
+            {
+                aHandle = i;
+                return WEAVE_NO_ERROR;
+            }
+
+            i = item.mNextByAddress;
+        }
+    }
+
+    return WEAVE_ERROR_INVALID_PROFILE_ID;
+}
+
+template <typename T>
+WEAVE_ERROR MultiResourceTraitCatalog<T>::HandleToAddress(TraitDataHandle aHandle, TLV::TLVWriter & aWriter,
+                                                          SchemaVersionRange & aSchemaVersionRange) const
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    CatalogItem * item;
+    TLV::TLVType type;
+
+    VerifyOrExit(IsValidHandle(aHandle), err = WEAVE_ERROR_INVALID_ARGUMENT);
+    item = &mCatalogStore[aHandle];
+
+    VerifyOrExit(aSchemaVersionRange.IsValid(), err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    err = aWriter.StartContainer(TLV::ContextTag(Path::kCsTag_InstanceLocator), TLV::kTLVType_Structure, type);
+    SuccessOrExit(err);
+
+    if (aSchemaVersionRange.mMinVersion != 1 || aSchemaVersionRange.mMaxVersion != 1)
+    {
+        TLV::TLVType type2;
+
+        err = aWriter.StartContainer(TLV::ContextTag(Path::kCsTag_TraitProfileID), TLV::kTLVType_Array, type2);
+        SuccessOrExit(err);
+
+        err = aWriter.Put(TLV::AnonymousTag, item->mProfileId);
+        SuccessOrExit(err);
+
+        // Only encode the max version if it isn't 1.
+        if (aSchemaVersionRange.mMaxVersion != 1)
+        {
+            err = aWriter.Put(TLV::AnonymousTag, aSchemaVersionRange.mMaxVersion);
+            SuccessOrExit(err);
+        }
+
+        // Only encode the min version if it isn't 1.
+        if (aSchemaVersionRange.mMinVersion != 1)
+        {
+            err = aWriter.Put(TLV::AnonymousTag, aSchemaVersionRange.mMinVersion);
+            SuccessOrExit(err);
+        }
+
+        err = aWriter.EndContainer(type2);
+        SuccessOrExit(err);
+    }
+    else
+    {
+        err = aWriter.Put(TLV::ContextTag(Path::kCsTag_TraitProfileID), item->mProfileId);
+        SuccessOrExit(err);
+    }
+
+    if (item->mInstanceId)
+    {
+        err = aWriter.Put(TLV::ContextTag(Path::kCsTag_TraitInstanceID), item->mInstanceId);
+        SuccessOrExit(err);
+    }
+
+    err = item->mResourceId.ToTLV(aWriter);
+    SuccessOrExit(err);
+
+    err = aWriter.EndContainer(type);
+    SuccessOrExit(err);
+
+exit:
+    return err;
+}
+
+template <typename T>
+WEAVE_ERROR MultiResourceTraitCatalog<T>::Locate(TraitDataHandle aHandle, T ** aTraitInstance) const
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(IsValidHandle(aHandle), err = WEAVE_ERROR_INVALID_ARGUMENT);
+    *aTraitInstance = mCatalogStore[aHandle].mItem;
+
+exit:
+    return err;
+}
+
+template <typename T>
+WEAVE_ERROR MultiResourceTraitCatalog<T>::Locate(T * aTraitInstance, TraitDataHandle & aHandle) const
+{
+    if (mCapacity != 0 && aTraitInstance != NULL)
+    {
+        TraitDataHandle i = mItemBuckets[HashItem(aTraitInstance) & (mCapacity - 1)];
+
+        while (i != kNullIndex)
+        {
+            if (mCatalogStore[i].mItem == aTraitInstance)
+            {
+                aHandle = i;
+                return WEAVE_NO_ERROR;
+            }
+
+            i = mCatalogStore[i].mNextByItem;
+        }
+    }
+
+    return WEAVE_ERROR_KEY_NOT_FOUND;
+}
+
+template <typename T>
+void MultiResourceTraitCatalog<T>::Iterate(IteratorCallback aCallback, void * aContext)
+{
+    for (uint32_t i = 0; i < mNumSlotsUsed; i++)
+    {
+        if (mCatalogStore[i].mItem != NULL)
+        {
+            aCallback(mCatalogStore[i].mItem, i, aContext);
+        }
+    }
+}
+
+template <typename T>
+WEAVE_ERROR MultiResourceTraitCatalog<T>::DispatchEvent(uint16_t aEvent, void * aContext) const
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    for (uint32_t i = 0; i < mNumSlotsUsed; i++)
+    {
+        if (mCatalogStore[i].mItem != NULL)
+        {
+            mCatalogStore[i].mItem->OnEvent(aEvent, aContext);
+        }
+    }
+
+    return err;
+}
+
+template <typename T>
+uint32_t MultiResourceTraitCatalog<T>::Count() const
+{
+    return mNumCurCatalogItems;
+}
+
+#if WEAVE_CONFIG_ENABLE_WDM_UPDATE
+template <typename T>
+WEAVE_ERROR MultiResourceTraitCatalog<T>::GetInstanceId(TraitDataHandle aHandle, uint64_t &aInstanceId) const
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(IsValidHandle(aHandle), err = WEAVE_ERROR_INVALID_ARGUMENT);
+    aInstanceId = mCatalogStore[aHandle].mInstanceId;
+
+exit:
+    return err;
+}
+
+template <typename T>
+WEAVE_ERROR MultiResourceTraitCatalog<T>::GetResourceId(TraitDataHandle aHandle, ResourceIdentifier &aResourceId) const
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(IsValidHandle(aHandle), err = WEAVE_ERROR_INVALID_ARGUMENT);
+    aResourceId = mCatalogStore[aHandle].mResourceId;
+
+exit:
+    return err;
+}
+
+#endif // WEAVE_CONFIG_ENABLE_WDM_UPDATE
+
 }; // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
 }; // namespace Profiles
 }; // namespace Weave
@@ -292,7 +292,6 @@ exit:
     return err;
 }
 
-#if WEAVE_CONFIG_ENABLE_WDM_UPDATE
 WEAVE_ERROR TraitSchemaEngine::RetrieveUpdatableDictionaryData(PropertyPathHandle aHandle,
                                                                uint64_t aTagToWrite,
                                                                TLVWriter & aWriter,
@@ -371,6 +370,7 @@ exit:
     return err;
 }
 
+#if WEAVE_CONFIG_ENABLE_WDM_UPDATE
 WEAVE_ERROR TraitSchemaEngine::GetRelativePathTags(const PropertyPathHandle aCandidateHandle,
                                                    uint64_t *aTags,
                                                    const uint32_t aTagsSize,
@@ -1248,6 +1248,18 @@ void TraitDataSource::DeleteKey(PropertyPathHandle aPropertyHandle)
         SubscriptionEngine::GetInstance()->GetNotificationEngine()->DeleteKey(this, aPropertyHandle);
     }
 }
+
+WEAVE_ERROR TraitDataSource::ReadDictionaryData(PropertyPathHandle aHandle, uint64_t aTagToWrite, TLVWriter & aWriter,
+                                                PropertyPathHandle & aPropertyPathHandleOfDictItemToStartFrom)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    Lock();
+    err = mSchemaEngine->RetrieveUpdatableDictionaryData(aHandle, aTagToWrite, aWriter, this,
+                                                         aPropertyPathHandleOfDictItemToStartFrom);
+    Unlock();
+
+    return err;
+}
 #endif // TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
 
 WEAVE_ERROR TraitDataSource::Lock()
@@ -838,6 +838,14 @@ public:
 
 #if TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
     void DeleteKey(PropertyPathHandle aPropertyHandle);
+
+    /**
+     * Write the items of the dictionary at aHandle, in ascending order of their property path handles, starting at
+     * aPropertyPathHandleOfDictItemToStartFrom. If the writer fills up after at least one item was written, the item that did
+     * not fit is returned in aPropertyPathHandleOfDictItemToStartFrom; otherwise it is set to kNullPropertyPathHandle.
+     */
+    WEAVE_ERROR ReadDictionaryData(PropertyPathHandle aHandle, uint64_t aTagToWrite, TLV::TLVWriter & aWriter,
+                                   PropertyPathHandle & aPropertyPathHandleOfDictItemToStartFrom);
 #endif
 
     // This API has been deprecated.
@@ -902,6 +910,8 @@ protected: // IGetDataDelegate
     const TraitSchemaEngine * mSchemaEngine;
 
 private:
+    friend class SubscriptionHandler;
+
     // Current version of the data in this source.
     uint64_t mVersion;
     // Tracks whether SetDirty was called within a Lock/Unlock 'session'
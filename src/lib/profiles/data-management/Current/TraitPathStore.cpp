@@ -45,7 +45,8 @@ using namespace ::nl::Weave::Profiles::DataManagement_Current;
  * Empty constructor
  */
 TraitPathStore::TraitPathStore()
-    : mStore(NULL), mStoreSize(0), mNumItems(0)
+    : mStore(NULL), mStoreSize(0), mNumItems(0), mIndex(NULL), mIndexSize(0), mNumIndexEntries(0),
+      mNumItemsWithoutAncestry(0), mIndexOverflowed(false)
 {
 }
 
@@ -57,9 +58,31 @@ TraitPathStore::TraitPathStore()
  * @param[in]   aArrayLength    Length of the storage array in number of items.
  */
 void TraitPathStore::Init(TraitPathStore::Record *aRecordArray, size_t aArrayLength)
+{
+    Init(aRecordArray, aArrayLength, NULL, 0);
+}
+
+/**
+ * Inits the TraitPathStore with an index of the valid items.
+ * The index makes IsPresent, Includes, Intersects, IsTraitPresent and AddItemDedup
+ * take time proportional to the depth of the schema rather than to the number of
+ * items in the store. Each valid item takes up to one IndexEntry per level of its
+ * path, plus one per trait instance; if the index fills up, the store falls back
+ * to scanning its items until it is cleared.
+ *
+ * @param[in]   aRecordArray    Pointer to an array of Records that will be used
+ *                              to store paths and flags.
+ * @param[in]   aArrayLength    Length of the storage array in number of items.
+ * @param[in]   aIndexArray     Pointer to an array of IndexEntries, or NULL.
+ * @param[in]   aIndexSize      Length of the index array in number of entries.
+ */
+void TraitPathStore::Init(TraitPathStore::Record *aRecordArray, size_t aArrayLength,
+                          TraitPathStore::IndexEntry *aIndexArray, size_t aIndexSize)
 {
     mStore = aRecordArray;
     mStoreSize = aArrayLength;
+    mIndex = (aIndexSize > 0) ? aIndexArray : NULL;
+    mIndexSize = aIndexSize;
 
     Clear();
 }
@@ -96,20 +119,7 @@ void TraitPathStore::Init(TraitPathStore::Record *aRecordArray, size_t aArrayLen
  */
 WEAVE_ERROR TraitPathStore::AddItem(const TraitPath &aItem, Flags aFlags)
 {
-    WEAVE_ERROR err = WEAVE_NO_ERROR;
-    size_t i = 0;
-
-    VerifyOrExit((aFlags & static_cast<Flags>(kFlag_ReservedFlags)) == 0x0,
-                 err = WEAVE_ERROR_INVALID_ARGUMENT);
-
-    i = FindFirstAvailableItem();
-    VerifyOrExit(i < mStoreSize, err = WEAVE_ERROR_NO_MEMORY);
-
-    SetItem(i, aItem, aFlags);
-    mNumItems++;
-
-exit:
-    return err;
+    return AddItem_private(aItem, aFlags, NULL);
 }
 
 /**
@@ -128,6 +138,7 @@ WEAVE_ERROR TraitPathStore::AddItem(const TraitPath &aItem)
 WEAVE_ERROR TraitPathStore::AddItemDedup(const TraitPath &aItem, const TraitSchemaEngine * const aSchemaEngine)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
+    bool mayHaveDescendants = true;
 
     if (Includes(aItem, aSchemaEngine))
     {
@@ -135,8 +146,15 @@ WEAVE_ERROR TraitPathStore::AddItemDedup(const TraitPath &aItem, const TraitSche
         ExitNow();
     }
 
+    if (AreDescendantsIndexed())
+    {
+        const IndexEntry *entry = FindIndexEntry(aItem);
+
+        mayHaveDescendants = (entry != NULL && entry->mNumDescendants > 0);
+    }
+
     // Remove any paths of which aItem is an ancestor
-    for (size_t i = GetFirstValidItem(aItem.mTraitDataHandle);
+    for (size_t i = mayHaveDescendants ? GetFirstValidItem(aItem.mTraitDataHandle) : GetPathStoreSize();
             i < GetPathStoreSize();
             i = GetNextValidItem(i, aItem.mTraitDataHandle))
     {
@@ -150,7 +168,7 @@ WEAVE_ERROR TraitPathStore::AddItemDedup(const TraitPath &aItem, const TraitSche
         }
     }
 
-    err = AddItem(aItem, kFlag_None);
+    err = AddItem_private(aItem, kFlag_None, aSchemaEngine);
 
 exit:
     return err;
@@ -188,7 +206,7 @@ WEAVE_ERROR TraitPathStore::InsertItemAt(size_t aIndex, const TraitPath &aItem,
         SetFlags(aIndex, kFlag_InUse, false);
     }
 
-    SetItem(aIndex, aItem, aFlags);
+    SetItem(aIndex, aItem, aFlags, NULL);
     mNumItems++;
 
 exit:
@@ -217,6 +235,13 @@ void TraitPathStore::RemoveTrait(TraitDataHandle aDataHandle)
  */
 bool TraitPathStore::IsTraitPresent(TraitDataHandle aDataHandle) const
 {
+    if (IsIndexed())
+    {
+        const IndexEntry *entry = FindIndexEntry(TraitPath(aDataHandle, kNullPropertyPathHandle));
+
+        return (entry != NULL && entry->mNumDescendants > 0);
+    }
+
     size_t i = GetFirstValidItem(aDataHandle);
 
     return i < mStoreSize;
@@ -237,6 +262,21 @@ void TraitPathStore::SetFailedTrait(TraitDataHandle aDataHandle)
     }
 }
 
+/**
+ * Mark a TraitPath as failed.
+ *
+ * @param aIndex    The index of the item to mark.
+ */
+void TraitPathStore::SetFailed(size_t aIndex)
+{
+    if (IsItemValid(aIndex))
+    {
+        UnindexItem(aIndex);
+    }
+
+    SetFlags(aIndex, kFlag_Failed, true);
+}
+
 void TraitPathStore::RemoveItemAt(size_t aIndex)
 {
     VerifyOrDie(mNumItems > 0);
@@ -244,6 +284,11 @@ void TraitPathStore::RemoveItemAt(size_t aIndex)
 
     if (IsItemInUse(aIndex))
     {
+        if (IsItemValid(aIndex))
+        {
+            UnindexItem(aIndex);
+        }
+
         ClearItem(aIndex);
         mNumItems--;
     }
@@ -288,6 +333,13 @@ void TraitPathStore::Compact()
  */
 bool TraitPathStore::IsPresent(const TraitPath &aItem) const
 {
+    if (IsIndexed())
+    {
+        const IndexEntry *entry = FindIndexEntry(aItem);
+
+        return (entry != NULL && entry->mNumItems > 0);
+    }
+
     for (size_t i = GetFirstValidItem(); i < mStoreSize; i = GetNextValidItem(i))
     {
         if (mStore[i].mTraitPath == aItem)
@@ -317,6 +369,13 @@ bool TraitPathStore::Intersects(const TraitPath &aTraitPath, const TraitSchemaEn
     TraitDataHandle dataHandle = aTraitPath.mTraitDataHandle;
     PropertyPathHandle pathHandle = aTraitPath.mPropertyPathHandle;
 
+    if (AreDescendantsIndexed())
+    {
+        const IndexEntry *entry = FindIndexEntry(aTraitPath);
+
+        return ((entry != NULL && entry->mNumDescendants > 0) || Includes(aTraitPath, aSchemaEngine));
+    }
+
     for (size_t i = GetFirstValidItem(dataHandle); i < mStoreSize; i = GetNextValidItem(i, dataHandle))
     {
         if (pathHandle == mStore[i].mTraitPath.mPropertyPathHandle ||
@@ -349,6 +408,23 @@ bool TraitPathStore::Includes(const TraitPath &aItem, const TraitSchemaEngine *
     TraitDataHandle dataHandle = aItem.mTraitDataHandle;
     PropertyPathHandle pathHandle = aItem.mPropertyPathHandle;
 
+    if (IsIndexed())
+    {
+        // Look the path and each of its ancestors up.
+        for ( ; pathHandle != kNullPropertyPathHandle; pathHandle = aSchemaEngine->GetParent(pathHandle))
+        {
+            const IndexEntry *entry = FindIndexEntry(TraitPath(dataHandle, pathHandle));
+
+            if (entry != NULL && entry->mNumItems > 0)
+            {
+                found = true;
+                break;
+            }
+        }
+
+        return found;
+    }
+
     for (size_t i = GetFirstValidItem(dataHandle); i < mStoreSize; i = GetNextValidItem(i, dataHandle))
     {
         if (pathHandle == mStore[i].mTraitPath.mPropertyPathHandle ||
@@ -369,6 +445,8 @@ void TraitPathStore::Clear()
 {
     mNumItems = 0;
 
+    ClearIndex();
+
     for (size_t i = 0; i < mStoreSize; i++)
     {
         ClearItem(i);
@@ -462,8 +540,49 @@ bool TraitPathStore::AreFlagsSet(size_t aIndex, Flags aFlags) const
     return AreFlagsSet_private(aIndex, aFlags);
 }
 
+/**
+ * Sets or clears application flags of an item.
+ *
+ * @param[in]   aIndex   An index into the store.
+ * @param[in]   aFlags   The flags to set or clear.
+ * @param[in]   aValue   True to set the flags, false to clear them.
+ *
+ * @retval WEAVE_ERROR_INVALID_ARGUMENT if aFlags includes any reserved flag.
+ * @retval WEAVE_NO_ERROR               in case of success.
+ */
+WEAVE_ERROR TraitPathStore::SetItemFlags(size_t aIndex, Flags aFlags, bool aValue)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit((aFlags & static_cast<Flags>(kFlag_ReservedFlags)) == 0x0,
+                 err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    SetFlags(aIndex, aFlags, aValue);
+
+exit:
+    return err;
+}
+
 // Private members
 
+WEAVE_ERROR TraitPathStore::AddItem_private(const TraitPath &aItem, Flags aFlags, const TraitSchemaEngine * const aSchemaEngine)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    size_t i = 0;
+
+    VerifyOrExit((aFlags & static_cast<Flags>(kFlag_ReservedFlags)) == 0x0,
+                 err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    i = FindFirstAvailableItem();
+    VerifyOrExit(i < mStoreSize, err = WEAVE_ERROR_NO_MEMORY);
+
+    SetItem(i, aItem, aFlags, aSchemaEngine);
+    mNumItems++;
+
+exit:
+    return err;
+}
+
 size_t TraitPathStore::FindFirstAvailableItem() const
 {
     size_t i = 0;
@@ -476,11 +595,17 @@ size_t TraitPathStore::FindFirstAvailableItem() const
     return i;
 }
 
-void TraitPathStore::SetItem(size_t aIndex, const TraitPath &aItem, Flags aFlags)
+void TraitPathStore::SetItem(size_t aIndex, const TraitPath &aItem, Flags aFlags,
+                             const TraitSchemaEngine * const aSchemaEngine)
 {
     mStore[aIndex].mTraitPath = aItem;
     mStore[aIndex].mFlags = aFlags;
     SetFlags(aIndex, kFlag_InUse, true);
+
+    if (IsItemValid(aIndex))
+    {
+        IndexItem(aIndex, aSchemaEngine);
+    }
 }
 
 void TraitPathStore::ClearItem(size_t aIndex)
@@ -498,3 +623,212 @@ void TraitPathStore::SetFlags(size_t aIndex, Flags aFlags, bool aValue)
         mStore[aIndex].mFlags |= aFlags;
     }
 }
+
+void TraitPathStore::ClearIndex()
+{
+    mNumIndexEntries = 0;
+    mNumItemsWithoutAncestry = 0;
+    mIndexOverflowed = false;
+
+    for (size_t i = 0; mIndex != NULL && i < mIndexSize; i++)
+    {
+        mIndex[i].mSchemaEngine = NULL;
+        mIndex[i].mNumItems = 0;
+        mIndex[i].mNumDescendants = 0;
+    }
+}
+
+/**
+ * Accounts for a valid item in the index: the item itself, the trait instance it
+ * belongs to and, if aSchemaEngine is not NULL, each of its ancestors.
+ */
+void TraitPathStore::IndexItem(size_t aIndex, const TraitSchemaEngine * const aSchemaEngine)
+{
+    const TraitPath &traitPath = mStore[aIndex].mTraitPath;
+
+    VerifyOrExit(IsIndexed(), );
+
+    UpdateIndexEntry(TraitPath(traitPath.mTraitDataHandle, kNullPropertyPathHandle), 0, 1, NULL);
+    UpdateIndexEntry(traitPath, 1, 0, aSchemaEngine);
+
+    if (aSchemaEngine != NULL)
+    {
+        for (PropertyPathHandle ancestor = aSchemaEngine->GetParent(traitPath.mPropertyPathHandle);
+             ancestor != kNullPropertyPathHandle;
+             ancestor = aSchemaEngine->GetParent(ancestor))
+        {
+            UpdateIndexEntry(TraitPath(traitPath.mTraitDataHandle, ancestor), 0, 1, NULL);
+        }
+
+        SetFlags(aIndex, kFlag_AncestryIndexed, true);
+    }
+    else
+    {
+        mNumItemsWithoutAncestry++;
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Reverts IndexItem for an item that is about to stop being valid.
+ */
+void TraitPathStore::UnindexItem(size_t aIndex)
+{
+    const TraitPath traitPath = mStore[aIndex].mTraitPath;
+    const TraitSchemaEngine *schemaEngine = NULL;
+    const IndexEntry *entry;
+
+    VerifyOrExit(IsIndexed(), );
+
+    if (AreFlagsSet_private(aIndex, kFlag_AncestryIndexed))
+    {
+        entry = FindIndexEntry(traitPath);
+        VerifyOrDie(entry != NULL);
+
+        schemaEngine = entry->mSchemaEngine;
+
+        for (PropertyPathHandle ancestor = schemaEngine->GetParent(traitPath.mPropertyPathHandle);
+             ancestor != kNullPropertyPathHandle;
+             ancestor = schemaEngine->GetParent(ancestor))
+        {
+            UpdateIndexEntry(TraitPath(traitPath.mTraitDataHandle, ancestor), 0, -1, NULL);
+        }
+
+        SetFlags(aIndex, kFlag_AncestryIndexed, false);
+    }
+    else
+    {
+        mNumItemsWithoutAncestry--;
+    }
+
+    UpdateIndexEntry(traitPath, -1, 0, NULL);
+    UpdateIndexEntry(TraitPath(traitPath.mTraitDataHandle, kNullPropertyPathHandle), 0, -1, NULL);
+
+exit:
+    return;
+}
+
+size_t TraitPathStore::HashIndexEntry(const TraitPath &aTraitPath) const
+{
+    uint32_t hash = (static_cast<uint32_t>(aTraitPath.mPropertyPathHandle) * 2654435761U) ^
+                    (static_cast<uint32_t>(aTraitPath.mTraitDataHandle) * 40503U);
+
+    return hash % mIndexSize;
+}
+
+/**
+ * @return The index entry keyed by aTraitPath, or NULL if there is none.
+ *         The index is an open addressing hash table with linear probing;
+ *         entries with no items and no descendants are removed right away,
+ *         so an unused entry ends a probe sequence.
+ */
+TraitPathStore::IndexEntry *TraitPathStore::FindIndexEntry(const TraitPath &aTraitPath) const
+{
+    size_t i = HashIndexEntry(aTraitPath);
+
+    for (size_t n = 0; n < mIndexSize; n++)
+    {
+        IndexEntry *entry = &mIndex[i];
+
+        if (entry->mNumItems == 0 && entry->mNumDescendants == 0)
+        {
+            break;
+        }
+
+        if (entry->mTraitPath == aTraitPath)
+        {
+            return entry;
+        }
+
+        i = (i + 1) % mIndexSize;
+    }
+
+    return NULL;
+}
+
+void TraitPathStore::UpdateIndexEntry(const TraitPath &aTraitPath, int aNumItems, int aNumDescendants,
+                                      const TraitSchemaEngine * const aSchemaEngine)
+{
+    IndexEntry *entry = FindIndexEntry(aTraitPath);
+
+    if (entry == NULL)
+    {
+        size_t i = HashIndexEntry(aTraitPath);
+
+        VerifyOrDie(aNumItems >= 0 && aNumDescendants >= 0);
+
+        // Keep one entry unused, so that every probe sequence ends.
+        if (mNumIndexEntries + 1 >= mIndexSize)
+        {
+            WeaveLogDetail(DataManagement, "TraitPathStore index full; falling back to scanning");
+            mIndexOverflowed = true;
+            ExitNow();
+        }
+
+        while (mIndex[i].mNumItems != 0 || mIndex[i].mNumDescendants != 0)
+        {
+            i = (i + 1) % mIndexSize;
+        }
+
+        entry = &mIndex[i];
+        entry->mTraitPath = aTraitPath;
+        entry->mSchemaEngine = NULL;
+        mNumIndexEntries++;
+    }
+
+    entry->mNumItems = static_cast<uint16_t>(entry->mNumItems + aNumItems);
+    entry->mNumDescendants = static_cast<uint16_t>(entry->mNumDescendants + aNumDescendants);
+
+    if (aSchemaEngine != NULL)
+    {
+        entry->mSchemaEngine = aSchemaEngine;
+    }
+
+    if (entry->mNumItems == 0 && entry->mNumDescendants == 0)
+    {
+        RemoveIndexEntry(static_cast<size_t>(entry - mIndex));
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Removes an index entry, moving back any later entry of the same probe sequence
+ * so that lookups do not need tombstones.
+ */
+void TraitPathStore::RemoveIndexEntry(size_t aIndex)
+{
+    size_t hole = aIndex;
+    size_t i = aIndex;
+
+    for (;;)
+    {
+        size_t home;
+
+        i = (i + 1) % mIndexSize;
+
+        if (mIndex[i].mNumItems == 0 && mIndex[i].mNumDescendants == 0)
+        {
+            break;
+        }
+
+        home = HashIndexEntry(mIndex[i].mTraitPath);
+
+        // Leave the entry where it is if its home slot lies cyclically in (hole, i].
+        if ((hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i))
+        {
+            continue;
+        }
+
+        mIndex[hole] = mIndex[i];
+        hole = i;
+    }
+
+    mIndex[hole].mSchemaEngine = NULL;
+    mIndex[hole].mNumItems = 0;
+    mIndex[hole].mNumDescendants = 0;
+    mNumIndexEntries--;
+}
@@ -44,8 +44,10 @@ struct TraitPathStore
             kFlag_InUse      = 0x1,
             kFlag_Failed     = 0x2, /**< The item is in use, but is not valid anymore.
                                       */
+            kFlag_AncestryIndexed = 0x80, /**< The ancestors of the item are accounted for in the index.
+                                            */
 
-            kFlag_ReservedFlags = kFlag_InUse | kFlag_Failed,
+            kFlag_ReservedFlags = kFlag_InUse | kFlag_Failed | kFlag_AncestryIndexed,
         };
         typedef uint8_t Flags;
 
@@ -54,14 +56,26 @@ struct TraitPathStore
             TraitPath mTraitPath;
         };
 
+        /**
+         * An entry of the optional index of the valid items, keyed by TraitPath.
+         * The entry keyed by a TraitPath with a null property path handle counts the items of that trait instance.
+         */
+        struct IndexEntry {
+            TraitPath mTraitPath;
+            const TraitSchemaEngine *mSchemaEngine; /**< The schema the ancestors of the items were found with, or NULL. */
+            uint16_t mNumItems;                     /**< Number of valid items equal to mTraitPath. */
+            uint16_t mNumDescendants;               /**< Number of valid items mTraitPath is an ancestor of. */
+        };
+
         TraitPathStore();
 
         void Init(Record *aRecordArray, size_t aNumItems);
+        void Init(Record *aRecordArray, size_t aNumItems, IndexEntry *aIndexArray, size_t aIndexSize);
 
         bool IsEmpty() { return mNumItems == 0; }
         bool IsFull() { return mNumItems >= mStoreSize; }
         size_t GetNumItems() { return mNumItems; }
-        size_t GetPathStoreSize() { return mStoreSize; }
+        size_t GetPathStoreSize() const { return mStoreSize; }
 
         WEAVE_ERROR AddItem(const TraitPath &aItem);
         WEAVE_ERROR AddItem(const TraitPath &aItem, Flags aFlags);
@@ -69,10 +83,10 @@ struct TraitPathStore
         WEAVE_ERROR InsertItemAt(size_t aIndex, const TraitPath &aItem, Flags aFlags);
         WEAVE_ERROR InsertItemAfter(size_t aIndex, const TraitPath &aItem, Flags aFlags) { return InsertItemAt(aIndex+1, aItem, aFlags); }
 
-        void SetFailed(size_t aIndex) { SetFlags(aIndex, kFlag_Failed, true); }
+        void SetFailed(size_t aIndex);
         void SetFailedTrait(TraitDataHandle aDataHandle);
 
-        void GetItemAt(size_t aIndex, TraitPath &aTraitPath) { aTraitPath = mStore[aIndex].mTraitPath; }
+        void GetItemAt(size_t aIndex, TraitPath &aTraitPath) const { aTraitPath = mStore[aIndex].mTraitPath; }
 
         size_t GetFirstValidItem() const;
         size_t GetNextValidItem(size_t i) const;
@@ -95,18 +109,37 @@ struct TraitPathStore
         bool IsItemFailed(size_t aIndex) const { return AreFlagsSet_private(aIndex, kFlag_Failed); }
 
         bool AreFlagsSet(size_t aIndex, Flags aFlags) const;
+        WEAVE_ERROR SetItemFlags(size_t aIndex, Flags aFlags, bool aValue);
 
         Record *mStore;
 
    private:
+        WEAVE_ERROR AddItem_private(const TraitPath &aItem, Flags aFlags, const TraitSchemaEngine * const aSchemaEngine);
         size_t FindFirstAvailableItem() const;
-        void SetItem(size_t aIndex, const TraitPath &aItem, Flags aFlags);
+        void SetItem(size_t aIndex, const TraitPath &aItem, Flags aFlags, const TraitSchemaEngine * const aSchemaEngine);
         void ClearItem(size_t aIndex);
         void SetFlags(size_t aIndex, Flags aFlags, bool aValue);
         bool AreFlagsSet_private(size_t aIndex, Flags aFlags) const { return ((mStore[aIndex].mFlags & aFlags) == aFlags); }
 
+        bool IsIndexed() const { return (mIndex != NULL && !mIndexOverflowed); }
+        bool AreDescendantsIndexed() const { return (IsIndexed() && mNumItemsWithoutAncestry == 0); }
+        void ClearIndex();
+        void IndexItem(size_t aIndex, const TraitSchemaEngine * const aSchemaEngine);
+        void UnindexItem(size_t aIndex);
+        size_t HashIndexEntry(const TraitPath &aTraitPath) const;
+        IndexEntry *FindIndexEntry(const TraitPath &aTraitPath) const;
+        void UpdateIndexEntry(const TraitPath &aTraitPath, int aNumItems, int aNumDescendants,
+                              const TraitSchemaEngine * const aSchemaEngine);
+        void RemoveIndexEntry(size_t aIndex);
+
         size_t mStoreSize;
         size_t mNumItems;
+
+        IndexEntry *mIndex;
+        size_t mIndexSize;
+        size_t mNumIndexEntries;
+        size_t mNumItemsWithoutAncestry;
+        bool mIndexOverflowed;
 };
 
 }; // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
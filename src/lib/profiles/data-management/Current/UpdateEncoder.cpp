@@ -229,6 +229,7 @@ WEAVE_ERROR UpdateEncoder::EncodeDataElements()
             WeaveLogDetail(DataManagement, "Resume encoding a dictionary");
         }
 
+        // EncodeDataElement moves i to the last item it packed in the DataElement.
         err = EncodeDataElement();
         SuccessOrExit(err);
 
@@ -263,8 +264,12 @@ exit:
  * Encodes a DataElement.
  * If the DataElement is a dictionary, it resumes encoding from mContext->mNextDictionaryElementPathHandle.
  * If the dictionary overflows the buffer, mContext->mNextDictionaryElementPathHandle is udpated accordingly.
+ * Consecutive leaves of the same parent are packed in a single DataElement
+ * that merges them at the path of the parent; mContext->mItemInProgress is moved
+ * to the last item packed, and each following item is flagged with
+ * SubscriptionClient::kFlag_PackedWithPrevious.
  * This method does all the lookups required and passes everything to
- * EncodeElementPath and EncodeElementData.
+ * EncodeElementPath and EncodeElementData or EncodePackedElementData.
  *
  * If the DataElement cannot be encoded successfully, the TLV writer is rolled back.
  *
@@ -279,6 +284,8 @@ WEAVE_ERROR UpdateEncoder::EncodeDataElement()
     TLV::TLVWriter checkpoint;
     DataElementDataContext dataContext;
     DataElementPathContext pathContext;
+    size_t numItemsToPack = 0;
+    size_t lastItemEncoded = mContext->mItemInProgress;
 
     Checkpoint(checkpoint);
 
@@ -318,7 +325,15 @@ WEAVE_ERROR UpdateEncoder::EncodeDataElement()
 
         dataContext.mForceMerge = mContext->mInProgressUpdateList->AreFlagsSet(mContext->mItemInProgress, SubscriptionClient::kFlag_ForceMerge);
 
-        if (dataContext.mSchemaEngine->IsDictionary(dataContext.mTraitPath.mPropertyPathHandle) &&
+        numItemsToPack = CountItemsToPack(dataContext);
+
+        if (numItemsToPack > 1)
+        {
+            // The leaves are merged into their parent, so the path has to point to the parent.
+            VerifyOrExit(pathContext.mNumTags > 0, err = WEAVE_ERROR_WDM_SCHEMA_MISMATCH);
+            pathContext.mNumTags--;
+        }
+        else if (dataContext.mSchemaEngine->IsDictionary(dataContext.mTraitPath.mPropertyPathHandle) &&
                 false == dataContext.mForceMerge)
         {
             // If the property being updated is a dictionary, we need to use the "replace"
@@ -335,7 +350,16 @@ WEAVE_ERROR UpdateEncoder::EncodeDataElement()
         err = EncodeElementPath(pathContext, mWriter);
         SuccessOrExit(err);
 
-        err = EncodeElementData(dataContext, mWriter);
+        if (numItemsToPack > 1)
+        {
+            err = EncodePackedElementData(dataContext, numItemsToPack, lastItemEncoded);
+        }
+        else
+        {
+            mContext->mInProgressUpdateList->SetItemFlags(mContext->mItemInProgress, SubscriptionClient::kFlag_PackedWithPrevious, false);
+
+            err = EncodeElementData(dataContext, mWriter);
+        }
         SuccessOrExit(err);
 
         mContext->mNextDictionaryElementPathHandle = dataContext.mNextDictionaryElementPathHandle;
@@ -343,6 +367,7 @@ WEAVE_ERROR UpdateEncoder::EncodeDataElement()
         err = mWriter.EndContainer(mDataElementOuterContainerType);
         SuccessOrExit(err);
 
+        mContext->mItemInProgress = lastItemEncoded;
         mContext->mNumDataElementsAddedToPayload++;
     }
 
@@ -478,6 +503,128 @@ exit:
     return err;
 }
 
+/**
+ * Counts the items that can be packed in the DataElement of the current item:
+ * the current item and the valid items following it, as long as they are leaves
+ * of the same parent which are not part of a dictionary being encoded.
+ *
+ * @param[in] aElementContext   The context of the current item.
+ *
+ * @return The number of items to pack; 1 if the current item has to be encoded on its own.
+ */
+size_t UpdateEncoder::CountItemsToPack(const DataElementDataContext &aElementContext) const
+{
+    const TraitPathStore &traitPathList = *(mContext->mInProgressUpdateList);
+    const TraitSchemaEngine *schemaEngine = aElementContext.mSchemaEngine;
+    PropertyPathHandle parentHandle;
+    TraitPath traitPath;
+    size_t numItems = 1;
+
+    VerifyOrExit(aElementContext.mNextDictionaryElementPathHandle == kNullPropertyPathHandle, );
+    VerifyOrExit(IsPackable(mContext->mItemInProgress, aElementContext.mTraitPath, schemaEngine), );
+
+    parentHandle = schemaEngine->GetParent(aElementContext.mTraitPath.mPropertyPathHandle);
+    VerifyOrExit(parentHandle != kNullPropertyPathHandle && !schemaEngine->IsDictionary(parentHandle), );
+
+    for (size_t i = traitPathList.GetNextValidItem(mContext->mItemInProgress);
+         i < traitPathList.GetPathStoreSize();
+         i = traitPathList.GetNextValidItem(i))
+    {
+        traitPathList.GetItemAt(i, traitPath);
+
+        if (traitPath.mTraitDataHandle != aElementContext.mTraitPath.mTraitDataHandle ||
+            !IsPackable(i, traitPath, schemaEngine) ||
+            schemaEngine->GetParent(traitPath.mPropertyPathHandle) != parentHandle)
+        {
+            break;
+        }
+
+        numItems++;
+    }
+
+exit:
+    return numItems;
+}
+
+bool UpdateEncoder::IsPackable(size_t aItem, const TraitPath &aTraitPath, const TraitSchemaEngine *aSchemaEngine) const
+{
+    const TraitPathStore &traitPathList = *(mContext->mInProgressUpdateList);
+
+    return (!traitPathList.AreFlagsSet(aItem, SubscriptionClient::kFlag_ForceMerge) &&
+            !traitPathList.AreFlagsSet(aItem, SubscriptionClient::kFlag_Private) &&
+            aSchemaEngine->IsLeaf(aTraitPath.mPropertyPathHandle));
+}
+
+/**
+ * Encodes the data of a DataElement that packs several leaves of the same parent,
+ * starting from the current item. The data is a structure holding one element per leaf.
+ * Leaves are added until the buffer is full; at least one has to fit.
+ *
+ * @param[in] aElementContext   The context of the current item.
+ * @param[in] aNumItemsToPack   The number of items to pack, as returned by CountItemsToPack.
+ * @param[out] aLastItemEncoded The index of the last item packed.
+ *
+ * @retval #WEAVE_NO_ERROR On success.
+ * @retval #WEAVE_ERROR_BUFFER_TOO_SMALL In case not even the first leaf fits in the buffer.
+ */
+WEAVE_ERROR UpdateEncoder::EncodePackedElementData(DataElementDataContext &aElementContext, size_t aNumItemsToPack,
+                                                   size_t &aLastItemEncoded)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TraitPathStore &traitPathList = *(mContext->mInProgressUpdateList);
+    nl::Weave::TLV::TLVType dataContainerType;
+    TLV::TLVWriter checkpoint;
+    TraitPath traitPath;
+    PropertyPathHandle nextDictionaryElementPathHandle = kNullPropertyPathHandle;
+    size_t numItemsPacked = 0;
+
+    if (aElementContext.mUpdateRequiredVersion != 0x0)
+    {
+        err = mWriter.Put(nl::Weave::TLV::ContextTag(DataElement::kCsTag_Version), aElementContext.mUpdateRequiredVersion);
+        SuccessOrExit(err);
+    }
+
+    err = mWriter.StartContainer(nl::Weave::TLV::ContextTag(DataElement::kCsTag_Data),
+                                 nl::Weave::TLV::kTLVType_Structure, dataContainerType);
+    SuccessOrExit(err);
+
+    for (size_t i = mContext->mItemInProgress;
+         numItemsPacked < aNumItemsToPack && i < traitPathList.GetPathStoreSize();
+         i = traitPathList.GetNextValidItem(i))
+    {
+        traitPathList.GetItemAt(i, traitPath);
+
+        Checkpoint(checkpoint);
+
+        err = aElementContext.mDataSink->ReadData(traitPath.mTraitDataHandle,
+                                                  traitPath.mPropertyPathHandle,
+                                                  aElementContext.mSchemaEngine->GetTag(traitPath.mPropertyPathHandle),
+                                                  mWriter,
+                                                  nextDictionaryElementPathHandle);
+        if (err == WEAVE_ERROR_BUFFER_TOO_SMALL && numItemsPacked > 0)
+        {
+            Rollback(checkpoint);
+            err = WEAVE_NO_ERROR;
+            break;
+        }
+        SuccessOrExit(err);
+
+        traitPathList.SetItemFlags(i, SubscriptionClient::kFlag_PackedWithPrevious, (numItemsPacked > 0));
+
+        aLastItemEncoded = i;
+        numItemsPacked++;
+    }
+
+    WeaveLogDetail(DataManagement, "<EncodePackedElementData> packed %u leaves of 0x%08x",
+            numItemsPacked, aElementContext.mSchemaEngine->GetParent(aElementContext.mTraitPath.mPropertyPathHandle));
+
+    err = mWriter.EndContainer(dataContainerType);
+    SuccessOrExit(err);
+
+exit:
+    return err;
+}
+
 /**
  * End the construction of the update request.
  *
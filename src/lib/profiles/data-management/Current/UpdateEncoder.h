@@ -154,6 +154,10 @@ private:
     WEAVE_ERROR EncodeDataElement();
     static WEAVE_ERROR EncodeElementPath(const DataElementPathContext &aElementContext, TLV::TLVWriter &aWriter);
     static WEAVE_ERROR EncodeElementData(DataElementDataContext &aElementContext, TLV::TLVWriter &aWriter);
+    size_t CountItemsToPack(const DataElementDataContext &aElementContext) const;
+    bool IsPackable(size_t aItem, const TraitPath &aTraitPath, const TraitSchemaEngine *aSchemaEngine) const;
+    WEAVE_ERROR EncodePackedElementData(DataElementDataContext &aElementContext, size_t aNumItemsToPack,
+                                        size_t &aLastItemEncoded);
     WEAVE_ERROR EndUpdateRequest(void);
 
     void Checkpoint(TLV::TLVWriter &aWriter) { aWriter = mWriter; }
@@ -76,7 +76,22 @@ using namespace nl::Weave::ASN1;
 //
 #if WEAVE_CONFIG_SUPPORT_PASE_CONFIG1
 
-static BIGNUM *PASEConfig1_JPAKE_P()
+// Decode a Config1 domain parameter on first use and share it between all J-PAKE contexts.
+static const BIGNUM *GetPASEConfig1Param(BIGNUM *& cachedVal, const uint8_t *val, size_t valLen)
+{
+    if (cachedVal == NULL)
+    {
+        BIGNUM *newVal = BN_bin2bn(val, valLen, NULL);
+
+        // Another thread may have decoded the parameter in the meantime.
+        if (newVal != NULL && !__sync_bool_compare_and_swap(&cachedVal, (BIGNUM *)NULL, newVal))
+            BN_free(newVal);
+    }
+
+    return cachedVal;
+}
+
+static const BIGNUM *PASEConfig1_JPAKE_P()
 {
     static const uint8_t P[] =
     {
@@ -89,22 +104,24 @@ static BIGNUM *PASEConfig1_JPAKE_P()
         0x8B, 0x30, 0xB8, 0x39, 0xAF, 0x17, 0x24, 0x40, 0xF3, 0x25, 0x63, 0x05, 0x6C, 0xB6, 0x7A, 0x86,
         0x11, 0x58, 0xDD, 0xD9, 0x0E, 0x6A, 0x89, 0x4C, 0x72, 0xA5, 0xBB, 0xEF, 0x9E, 0x28, 0x6C, 0x6B,
     };
+    static BIGNUM *sP = NULL;
 
-    return BN_bin2bn(P, sizeof(P), NULL);
+    return GetPASEConfig1Param(sP, P, sizeof(P));
 }
 
-static BIGNUM *PASEConfig1_JPAKE_Q()
+static const BIGNUM *PASEConfig1_JPAKE_Q()
 {
     static const uint8_t Q[] =
     {
         0xE9, 0x50, 0x51, 0x1E, 0xAB, 0x42, 0x4B, 0x9A, 0x19, 0xA2, 0xAE, 0xB4, 0xE1, 0x59, 0xB7, 0x84,
         0x4C, 0x58, 0x9C, 0x4F
     };
+    static BIGNUM *sQ = NULL;
 
-    return BN_bin2bn(Q, sizeof(Q), NULL);
+    return GetPASEConfig1Param(sQ, Q, sizeof(Q));
 }
 
-static BIGNUM *PASEConfig1_JPAKE_G()
+static const BIGNUM *PASEConfig1_JPAKE_G()
 {
     static const uint8_t G[] =
     {
@@ -117,8 +134,9 @@ static BIGNUM *PASEConfig1_JPAKE_G()
         0x9F, 0x0B, 0x35, 0x18, 0x69, 0xAC, 0x24, 0xDA, 0x3D, 0x7B, 0xA8, 0x70, 0x11, 0xA7, 0x01, 0xCE,
         0x8E, 0xE7, 0xBF, 0xE4, 0x94, 0x86, 0xED, 0x45, 0x27, 0xB7, 0x18, 0x6C, 0xA4, 0x61, 0x0A, 0x75,
     };
+    static BIGNUM *sG = NULL;
 
-    return BN_bin2bn(G, sizeof(G), NULL);
+    return GetPASEConfig1Param(sG, G, sizeof(G));
 }
 
 // Utility function for initializing a JPAKE_CTX for PASE Config1
@@ -126,9 +144,9 @@ static WEAVE_ERROR NewPASEConfig1JPAKECTX(const uint8_t *pw, uint16_t pwLen, con
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
     BIGNUM *secret = NULL;
-    BIGNUM *P = NULL;
-    BIGNUM *G = NULL;
-    BIGNUM *Q = NULL;
+    const BIGNUM *P;
+    const BIGNUM *G;
+    const BIGNUM *Q;
 
     secret = BN_bin2bn(pw, pwLen, NULL);
     VerifyOrExit(secret != NULL, err = WEAVE_ERROR_NO_MEMORY);
@@ -147,9 +165,6 @@ static WEAVE_ERROR NewPASEConfig1JPAKECTX(const uint8_t *pw, uint16_t pwLen, con
 
 exit:
     BN_free(secret);
-    BN_free(P);
-    BN_free(G);
-    BN_free(Q);
     return err;
 }
 
@@ -40,6 +40,58 @@ namespace Security {
 
 using namespace nl::Weave::Crypto;
 
+// Encrypt a run of independent blocks using an expanded encryption key.  AESENC has a latency of
+// several cycles but can be issued every cycle, so the blocks are pushed through each round in
+// groups of eight (then four) to keep the AES unit's pipeline full.
+static void EncryptBlocksInterleaved(const __m128i *key, int roundCount, const uint8_t *inBlocks, uint8_t *outBlocks, size_t numBlocks)
+{
+    __m128i b[8];
+
+    for (; numBlocks >= 8; numBlocks -= 8, inBlocks += 8 * 16, outBlocks += 8 * 16)
+    {
+        for (int i = 0; i < 8; i++)
+            b[i] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(inBlocks + i * 16)), key[0]);
+        for (int round = 1; round < roundCount; round++)
+        {
+            b[0] = _mm_aesenc_si128(b[0], key[round]);
+            b[1] = _mm_aesenc_si128(b[1], key[round]);
+            b[2] = _mm_aesenc_si128(b[2], key[round]);
+            b[3] = _mm_aesenc_si128(b[3], key[round]);
+            b[4] = _mm_aesenc_si128(b[4], key[round]);
+            b[5] = _mm_aesenc_si128(b[5], key[round]);
+            b[6] = _mm_aesenc_si128(b[6], key[round]);
+            b[7] = _mm_aesenc_si128(b[7], key[round]);
+        }
+        for (int i = 0; i < 8; i++)
+            _mm_storeu_si128((__m128i *)(outBlocks + i * 16), _mm_aesenclast_si128(b[i], key[roundCount]));
+    }
+
+    for (; numBlocks >= 4; numBlocks -= 4, inBlocks += 4 * 16, outBlocks += 4 * 16)
+    {
+        for (int i = 0; i < 4; i++)
+            b[i] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(inBlocks + i * 16)), key[0]);
+        for (int round = 1; round < roundCount; round++)
+        {
+            b[0] = _mm_aesenc_si128(b[0], key[round]);
+            b[1] = _mm_aesenc_si128(b[1], key[round]);
+            b[2] = _mm_aesenc_si128(b[2], key[round]);
+            b[3] = _mm_aesenc_si128(b[3], key[round]);
+        }
+        for (int i = 0; i < 4; i++)
+            _mm_storeu_si128((__m128i *)(outBlocks + i * 16), _mm_aesenclast_si128(b[i], key[roundCount]));
+    }
+
+    for (; numBlocks > 0; numBlocks--, inBlocks += 16, outBlocks += 16)
+    {
+        b[0] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)inBlocks), key[0]);
+        for (int round = 1; round < roundCount; round++)
+            b[0] = _mm_aesenc_si128(b[0], key[round]);
+        _mm_storeu_si128((__m128i *)outBlocks, _mm_aesenclast_si128(b[0], key[roundCount]));
+    }
+
+    ClearSecretData((uint8_t *)b, sizeof(b));
+}
+
 AES128BlockCipher::AES128BlockCipher()
 {
     memset(&mKey, 0, sizeof(mKey));
@@ -108,6 +160,11 @@ void AES128BlockCipherEnc::EncryptBlock(const uint8_t *inBlock, uint8_t *outBloc
     ClearSecretData((uint8_t *)&block, sizeof(block));
 }
 
+void AES128BlockCipherEnc::EncryptBlocks(const uint8_t *inBlocks, uint8_t *outBlocks, size_t numBlocks)
+{
+    EncryptBlocksInterleaved(mKey, kRoundCount, inBlocks, outBlocks, numBlocks);
+}
+
 void AES128BlockCipherDec::SetKey(const uint8_t *key)
 {
     __m128i tmp;
@@ -234,6 +291,11 @@ void AES256BlockCipherEnc::EncryptBlock(const uint8_t *inBlock, uint8_t *outBloc
     ClearSecretData((uint8_t *)&block, sizeof(block));
 }
 
+void AES256BlockCipherEnc::EncryptBlocks(const uint8_t *inBlocks, uint8_t *outBlocks, size_t numBlocks)
+{
+    EncryptBlocksInterleaved(mKey, kRoundCount, inBlocks, outBlocks, numBlocks);
+}
+
 void AES256BlockCipherDec::SetKey(const uint8_t *key)
 {
     __m128i tmp;
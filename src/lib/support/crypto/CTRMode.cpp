@@ -59,6 +59,9 @@ template <class BlockCipher>
 void CTRMode<BlockCipher>::SetCounter(const uint8_t *counter)
 {
     memcpy(Counter, counter, kCounterLength);
+
+    // Start a new key stream, allowing the expanded key to be reused for another message.
+    mMsgIndex = 0;
 }
 
 template <class BlockCipher>
@@ -86,6 +89,9 @@ void CTRMode<BlockCipher>::SetWeaveMessageCounter(uint64_t sendingNodeId, uint32
     Counter[13] = 0;
     Counter[14] = 0;
     Counter[15] = 0;
+
+    // Start a new key stream, allowing the expanded key to be reused for another message.
+    mMsgIndex = 0;
 }
 
 template <class BlockCipher>
@@ -95,29 +101,30 @@ void CTRMode<BlockCipher>::EncryptData(const uint8_t *inData, uint16_t dataLen,
     uint32_t encryptedCounterIndex = mMsgIndex % kCounterLength;
 
     // For each byte of input data...
-    for (uint16_t dataIndex = 0; dataIndex < dataLen && mMsgIndex < UINT32_MAX; dataIndex++, mMsgIndex++)
+    for (uint16_t dataIndex = 0; dataIndex < dataLen && mMsgIndex < UINT32_MAX; )
     {
+        // If we are on a block boundary and one or more whole blocks of input remain, encrypt a run
+        // of up to kBulkBlockCount counter blocks at once and XOR the resulting keystream into the data.
+        if (encryptedCounterIndex == 0 && (uint32_t) (dataLen - dataIndex) >= kCounterLength &&
+            UINT32_MAX - mMsgIndex > kBulkLength)
+        {
+            uint32_t numBlocks = (dataLen - dataIndex) / kCounterLength;
+            if (numBlocks > kBulkBlockCount)
+                numBlocks = kBulkBlockCount;
+
+            EncryptBulk(inData + dataIndex, outData + dataIndex, numBlocks);
+            dataIndex += numBlocks * kCounterLength;
+            mMsgIndex += numBlocks * kCounterLength;
+            continue;
+        }
+
         // If we need more encrypted counter bytes...
         if (encryptedCounterIndex == 0)
         {
             // Encrypt the next counter value.
             mBlockCipher.EncryptBlock(Counter, mEncryptedCounter);
 
-            // Bump the counter. Since the message size is at most UINT32_MAX (and the counter counts blocks)
-            // we will never need to update more than the four least-significant bytes.
-            Counter[kCounterLength-1]++;
-            if (Counter[kCounterLength-1] == 0)
-            {
-                Counter[kCounterLength-2]++;
-                if (Counter[kCounterLength-2] == 0)
-                {
-                    Counter[kCounterLength-3]++;
-                    if (Counter[kCounterLength-3] == 0)
-                    {
-                        Counter[kCounterLength-4]++;
-                    }
-                }
-            }
+            IncrementCounter();
         }
 
         // XOR the data with the corresponding byte of the encrypted counter.
@@ -127,7 +134,60 @@ void CTRMode<BlockCipher>::EncryptData(const uint8_t *inData, uint16_t dataLen,
         encryptedCounterIndex++;
         if (encryptedCounterIndex == kCounterLength)
             encryptedCounterIndex = 0;
+
+        dataIndex++;
+        mMsgIndex++;
+    }
+}
+
+template <class BlockCipher>
+void CTRMode<BlockCipher>::IncrementCounter()
+{
+    // Bump the counter. Since the message size is at most UINT32_MAX (and the counter counts blocks)
+    // we will never need to update more than the four least-significant bytes.
+    Counter[kCounterLength-1]++;
+    if (Counter[kCounterLength-1] == 0)
+    {
+        Counter[kCounterLength-2]++;
+        if (Counter[kCounterLength-2] == 0)
+        {
+            Counter[kCounterLength-3]++;
+            if (Counter[kCounterLength-3] == 0)
+            {
+                Counter[kCounterLength-4]++;
+            }
+        }
+    }
+}
+
+template <class BlockCipher>
+void CTRMode<BlockCipher>::EncryptBulk(const uint8_t *inData, uint8_t *outData, uint32_t numBlocks)
+{
+    uint8_t keyStream[kBulkLength];
+    uint64_t dataWord, keyWord;
+
+    // Lay out the next numBlocks counter values and encrypt them in a single call, allowing
+    // the block cipher to pipeline the blocks.
+    for (uint32_t i = 0; i < numBlocks; i++)
+    {
+        memcpy(keyStream + i * kCounterLength, Counter, kCounterLength);
+        IncrementCounter();
+    }
+
+    mBlockCipher.EncryptBlocks(keyStream, keyStream, numBlocks);
+
+    // XOR the keystream into the data a word at a time.  The input and output buffers may alias
+    // and carry no alignment guarantees, hence the use of memcpy.
+    for (uint32_t i = 0; i < numBlocks * kCounterLength; i += sizeof(uint64_t))
+    {
+        memcpy(&dataWord, inData + i, sizeof(dataWord));
+        memcpy(&keyWord, keyStream + i, sizeof(keyWord));
+        dataWord ^= keyWord;
+        memcpy(outData + i, &dataWord, sizeof(dataWord));
     }
+
+    ClearSecretData(keyStream, sizeof(keyStream));
+    ClearSecretData((uint8_t *) &keyWord, sizeof(keyWord));
 }
 
 template <class BlockCipher>
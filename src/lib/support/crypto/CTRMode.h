@@ -42,7 +42,9 @@ public:
     enum
     {
         kKeyLength      = BlockCipher::kKeyLength,
-        kCounterLength  = BlockCipher::kBlockLength
+        kCounterLength  = BlockCipher::kBlockLength,
+        kBulkBlockCount = WEAVE_CONFIG_AES_CTR_BULK_BLOCK_COUNT,
+        kBulkLength     = kBulkBlockCount * kCounterLength
     };
 
     CTRMode(void);
@@ -60,6 +62,9 @@ public:
     void Reset(void);
 
 private:
+    void IncrementCounter(void);
+    void EncryptBulk(const uint8_t *inData, uint8_t *outData, uint32_t numBlocks);
+
     BlockCipher mBlockCipher;
     uint32_t mMsgIndex;
     uint8_t mEncryptedCounter[kCounterLength];
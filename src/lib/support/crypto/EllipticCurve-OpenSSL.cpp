@@ -836,53 +836,135 @@ static int GetOrderWordCount(const EC_GROUP *ecGroup)
     }
 }
 
-static WEAVE_ERROR EncodeECPointValue(const EC_GROUP *ecGroup, const EC_POINT *ecPoint, const uint8_t wordCount, uint8_t *& p)
+enum
 {
-    WEAVE_ERROR err;
-    BIGNUM *ecPointX = NULL;
-    BIGNUM *ecPointY = NULL;
+    kMaxECPointOctLength = 1 + 2 * ((WEAVE_CONFIG_MAX_EC_BITS + 7) / 8)
+};
 
-    ecPointX = BN_new();
-    VerifyOrExit(ecPointX != NULL, err = WEAVE_ERROR_NO_MEMORY);
-    ecPointY = BN_new();
-    VerifyOrExit(ecPointY != NULL, err = WEAVE_ERROR_NO_MEMORY);
+// Cache of EC groups shared by all EC-JPAKE contexts, indexed by GetECJPAKEGroupCacheIndex().
+// Each group is created, and the multiples of its generator precomputed, on first use.
+// Cached groups are never freed.
+static EC_GROUP *sECJPAKEGroupCache[4];
 
-    if (!EC_POINT_get_affine_coordinates_GFp(ecGroup, ecPoint, ecPointX, ecPointY, NULL))
-        ExitNow(err = WEAVE_ERROR_INVALID_ARGUMENT);
+static int GetECJPAKEGroupCacheIndex(OID curveOID)
+{
+    switch (curveOID)
+    {
+    case kOID_EllipticCurve_secp160r1:
+        return 0;
+    case kOID_EllipticCurve_prime192v1:
+        return 1;
+    case kOID_EllipticCurve_secp224r1:
+        return 2;
+    case kOID_EllipticCurve_prime256v1:
+        return 3;
+    default:
+        return -1;
+    }
+}
 
-    err = EncodeBIGNUMValueLE(*ecPointX, wordCount * sizeof(uint32_t), p);
-    SuccessOrExit(err);
-    err = EncodeBIGNUMValueLE(*ecPointY, wordCount * sizeof(uint32_t), p);
+static bool IsCachedECJPAKEGroup(const EC_GROUP *ecGroup)
+{
+    for (size_t i = 0; i < sizeof(sECJPAKEGroupCache) / sizeof(sECJPAKEGroupCache[0]); i++)
+        if (sECJPAKEGroupCache[i] == ecGroup)
+            return true;
+    return false;
+}
+
+static WEAVE_ERROR GetECJPAKEGroup(OID curveOID, EC_GROUP *& ecGroup)
+{
+    WEAVE_ERROR err;
+    int index = GetECJPAKEGroupCacheIndex(curveOID);
+    EC_GROUP *newGroup = NULL;
+
+    if (index >= 0 && sECJPAKEGroupCache[index] != NULL)
+    {
+        ecGroup = sECJPAKEGroupCache[index];
+        ExitNow(err = WEAVE_NO_ERROR);
+    }
+
+    err = GetECGroupForCurve(curveOID, newGroup);
     SuccessOrExit(err);
 
+    // Curves outside the cache are owned by the caller.
+    if (index < 0)
+    {
+        ecGroup = newGroup;
+        ExitNow();
+    }
+
+#if (OPENSSL_VERSION_NUMBER < 0x30000000L)
+    // Precomputation only speeds up multiplication of the generator; failure is not fatal. OpenSSL 3.0 deprecates it, as
+    // its built-in curves come with the generator tables.
+    EC_GROUP_precompute_mult(newGroup, NULL);
+#endif
+
+    // Another thread may have populated the entry in the meantime, in which case use its group.
+    if (!__sync_bool_compare_and_swap(&sECJPAKEGroupCache[index], (EC_GROUP *)NULL, newGroup))
+        EC_GROUP_free(newGroup);
+
+    ecGroup = sECJPAKEGroupCache[index];
+
+exit:
+    return err;
+}
+
+// Convert a big-endian value to a little-endian value of the given length, padded with zeros.
+static void ReverseValue(const uint8_t *in, size_t inLen, size_t outLen, uint8_t *& p)
+{
+    for (size_t i = 0; i < inLen; i++)
+        p[i] = in[inLen - 1 - i];
+    memset(p + inLen, 0, outLen - inLen);
+    p += outLen;
+}
+
+static WEAVE_ERROR EncodeECPointValue(const EC_GROUP *ecGroup, const EC_POINT *ecPoint, const uint8_t wordCount, uint8_t *& p)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint8_t octBuf[kMaxECPointOctLength];
+    const size_t valueLen = wordCount * sizeof(uint32_t);
+    size_t octLen, fieldLen;
+
+    // Use the uncompressed X9.62 form rather than the affine coordinates to avoid allocating
+    // BIGNUMs for every point encoded or hashed.
+    octLen = EC_POINT_point2oct(ecGroup, ecPoint, POINT_CONVERSION_UNCOMPRESSED, octBuf, sizeof(octBuf), NULL);
+    VerifyOrExit(octLen > 1 && octBuf[0] == POINT_CONVERSION_UNCOMPRESSED, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    fieldLen = (octLen - 1) / 2;
+    VerifyOrExit(fieldLen <= valueLen, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    ReverseValue(octBuf + 1, fieldLen, valueLen, p);
+    ReverseValue(octBuf + 1 + fieldLen, fieldLen, valueLen, p);
+
 exit:
-    BN_free(ecPointY);
-    BN_free(ecPointX);
     return err;
 }
 
 static WEAVE_ERROR DecodeECPointValue(const EC_GROUP *ecGroup, EC_POINT *ecPoint, const uint8_t wordCount, const uint8_t *& p)
 {
-    WEAVE_ERROR err;
-    BIGNUM *ecPointX = NULL;
-    BIGNUM *ecPointY = NULL;
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint8_t octBuf[kMaxECPointOctLength];
+    const size_t valueLen = wordCount * sizeof(uint32_t);
+    const size_t fieldLen = (EC_GROUP_get_degree(ecGroup) + 7) / 8;
+    uint8_t *octP;
 
-    ecPointX = BN_new();
-    VerifyOrExit(ecPointX != NULL, err = WEAVE_ERROR_NO_MEMORY);
-    ecPointY = BN_new();
-    VerifyOrExit(ecPointY != NULL, err = WEAVE_ERROR_NO_MEMORY);
+    VerifyOrExit(fieldLen <= valueLen && 1 + 2 * fieldLen <= sizeof(octBuf), err = WEAVE_ERROR_INVALID_ARGUMENT);
 
-    err = DecodeBIGNUMValueLE(*ecPointX, wordCount * sizeof(uint32_t), p);
-    SuccessOrExit(err);
-    err = DecodeBIGNUMValueLE(*ecPointY, wordCount * sizeof(uint32_t), p);
-    SuccessOrExit(err);
+    // The padding beyond the field length must be zero.
+    for (size_t i = fieldLen; i < valueLen; i++)
+        VerifyOrExit(p[i] == 0 && p[valueLen + i] == 0, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    octBuf[0] = POINT_CONVERSION_UNCOMPRESSED;
+    octP = octBuf + 1;
+    ReverseValue(p, fieldLen, fieldLen, octP);
+    ReverseValue(p + valueLen, fieldLen, fieldLen, octP);
 
-    if (!EC_POINT_set_affine_coordinates_GFp(ecGroup, ecPoint, ecPointX, ecPointY, NULL))
+    if (!EC_POINT_oct2point(ecGroup, ecPoint, octBuf, 1 + 2 * fieldLen, NULL))
         ExitNow(err = WEAVE_ERROR_INVALID_ARGUMENT);
 
+    p += 2 * valueLen;
+
 exit:
-    BN_free(ecPointY);
-    BN_free(ecPointX);
     return err;
 }
 
@@ -943,25 +1025,19 @@ static int ECJPAKE_HashECPoint(ECJPAKE_CTX *ctx, SHA256_CTX *sha, const EC_POINT
 {
     WEAVE_ERROR err;
     uint8_t fieldWordCount;
-    uint8_t *ecPointEncoded = NULL;
-    uint8_t *p = NULL;
+    uint8_t ecPointEncoded[2 * sizeof(uint32_t) * ((WEAVE_CONFIG_MAX_EC_BITS + 31) / 32)];
+    uint8_t *p = ecPointEncoded;
     int ret = 1;
 
     fieldWordCount = GetCurveWordCount(ECJPAKE_get_ecGroup(ctx));
-    VerifyOrExit(fieldWordCount != 0, ret = 0);
-
-    ecPointEncoded = (uint8_t *)OPENSSL_malloc(2 * sizeof(uint32_t) * fieldWordCount);
-    VerifyOrExit(ecPointEncoded != NULL, ret = 0);
+    VerifyOrExit(fieldWordCount != 0 && 2 * sizeof(uint32_t) * fieldWordCount <= sizeof(ecPointEncoded), ret = 0);
 
-    // Assign another pointer because the value is updated by EncodeECPointValue function
-    p = ecPointEncoded;
     err = EncodeECPointValue(ECJPAKE_get_ecGroup(ctx), ecPoint, fieldWordCount, p);
     VerifyOrExit(err == WEAVE_NO_ERROR, ret = 0);
 
     SHA256_Update(sha, ecPointEncoded, 2 * sizeof(uint32_t) * fieldWordCount);
 
 exit:
-    if (ecPointEncoded != NULL) OPENSSL_free(ecPointEncoded);
     return ret;
 }
 
@@ -983,7 +1059,8 @@ void EllipticCurveJPAKE::Reset()
     {
         EC_GROUP *ecGroup = (EC_GROUP *)ECJPAKE_get_ecGroup(ECJPAKECtx);
 
-        if (ecGroup != NULL)
+        // Cached groups are shared with other contexts.
+        if (ecGroup != NULL && !IsCachedECJPAKEGroup(ecGroup))
         {
             EC_GROUP_free(ecGroup);
         }
@@ -1004,7 +1081,7 @@ WEAVE_ERROR EllipticCurveJPAKE::Init(const OID curveOID, const uint8_t *pw, cons
 
     // TODO: should we limit MAX length and check these inputs: pwLen, localNameLen, peerNameLen ?
 
-    err = GetECGroupForCurve(curveOID, ecGroup);
+    err = GetECJPAKEGroup(curveOID, ecGroup);
     SuccessOrExit(err);
 
     secret = BN_new();
@@ -1019,6 +1096,8 @@ WEAVE_ERROR EllipticCurveJPAKE::Init(const OID curveOID, const uint8_t *pw, cons
     ECJPAKE_Set_HashECPoint(ECJPAKE_HashECPoint);
 
 exit:
+    if (ECJPAKECtx == NULL && ecGroup != NULL && !IsCachedECJPAKEGroup(ecGroup))
+        EC_GROUP_free(ecGroup);
     BN_clear_free(secret);
     return err;
 }
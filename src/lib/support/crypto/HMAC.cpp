@@ -100,6 +100,28 @@ void HMAC<H>::AddData(const BIGNUM& num)
 }
 #endif
 
+template <class H>
+void HMAC<H>::AddDataMultiple(HMAC * const hmacs[], const uint8_t * const msgData[], const uint16_t dataLens[], uint16_t count)
+{
+    enum
+    {
+        kBatchSize              = 8
+    };
+
+    H *innerHashes[kBatchSize];
+
+    // Add the chunks to the inner hashes, a batch at a time.
+    for (uint16_t base = 0; base < count; base += kBatchSize)
+    {
+        uint16_t batchCount = (count - base < kBatchSize) ? count - base : (uint16_t) kBatchSize;
+
+        for (uint16_t i = 0; i < batchCount; i++)
+            innerHashes[i] = &hmacs[base + i]->mHash;
+
+        H::AddDataMultiple(innerHashes, msgData + base, dataLens + base, batchCount);
+    }
+}
+
 template <class H>
 void HMAC<H>::Finish(uint8_t *hashBuf)
 {
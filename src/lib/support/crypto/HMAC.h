@@ -54,6 +54,10 @@ public:
     void Finish(uint8_t *hashBuf);
     void Reset(void);
 
+    // Add one chunk of message data to each of several independent HMAC computations,
+    // letting the underlying hash process the messages in parallel where it can.
+    static void AddDataMultiple(HMAC * const hmacs[], const uint8_t * const msgData[], const uint16_t dataLens[], uint16_t count);
+
 private:
     enum
     {
@@ -0,0 +1,850 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements SHA1 and SHA256 hash functions for the Weave layer
+ *      natively, without relying on an external crypto library.
+ *
+ *      On x86 targets the block functions are selected at first use based on
+ *      the features reported by CPUID: SHA-NI when present, otherwise portable
+ *      C.  AddDataMultiple() hashes up to eight messages in parallel AVX2 lanes
+ *      on CPUs that have AVX2 but lack SHA-NI (where single-buffer SHA-NI is
+ *      faster than any lane-parallel scheme).
+ *
+ *      This implementation is used when #WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+ *      is enabled (1).
+ *
+ */
+
+#include <string.h>
+
+#include "WeaveCrypto.h"
+#include "HashAlgos.h"
+
+#if WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define WEAVE_HASH_NATIVE_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define WEAVE_HASH_NATIVE_X86 0
+#endif
+
+namespace nl {
+namespace Weave {
+namespace Platform {
+namespace Security {
+
+enum
+{
+    kHashBlockLength    = 64,
+    kMaxLanes           = 8
+};
+
+// Processes numBlocks consecutive 64-byte blocks into a single hash state.
+typedef void (*HashBlocksFunct)(uint32_t *state, const uint8_t *blocks, size_t numBlocks);
+
+// Processes one 64-byte block into each of numLanes independent hash states.
+typedef void (*HashLanesFunct)(uint32_t * const states[], const uint8_t * const blocks[], size_t numLanes);
+
+static inline uint32_t RotL(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32_t RotR(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t GetBE32(const uint8_t *p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static inline void PutBE32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t) (v >> 24);
+    p[1] = (uint8_t) (v >> 16);
+    p[2] = (uint8_t) (v >> 8);
+    p[3] = (uint8_t) v;
+}
+
+static const uint32_t sSHA1InitState[5] =
+{
+    0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+};
+
+static const uint32_t sSHA256InitState[8] =
+{
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+static const uint32_t sSHA256K[64] =
+{
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static void SHA1Blocks_Generic(uint32_t *state, const uint8_t *blocks, size_t numBlocks)
+{
+    uint32_t w[16];
+
+    for (; numBlocks > 0; numBlocks--, blocks += kHashBlockLength)
+    {
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+        for (int t = 0; t < 80; t++)
+        {
+            uint32_t f, k, temp;
+
+            if (t < 16)
+                w[t] = GetBE32(blocks + 4 * t);
+            else
+                w[t & 15] = RotL(w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15], 1);
+
+            if (t < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (t < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (t < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            temp = RotL(a, 5) + f + e + k + w[t & 15];
+            e = d;
+            d = c;
+            c = RotL(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+    ClearSecretData((uint8_t *) w, sizeof(w));
+}
+
+static void SHA256Blocks_Generic(uint32_t *state, const uint8_t *blocks, size_t numBlocks)
+{
+    uint32_t w[16];
+
+    for (; numBlocks > 0; numBlocks--, blocks += kHashBlockLength)
+    {
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int t = 0; t < 64; t++)
+        {
+            uint32_t t1, t2;
+
+            if (t < 16)
+                w[t] = GetBE32(blocks + 4 * t);
+            else
+            {
+                uint32_t w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+                w[t & 15] += (RotR(w2, 17) ^ RotR(w2, 19) ^ (w2 >> 10)) + w[(t - 7) & 15] +
+                             (RotR(w15, 7) ^ RotR(w15, 18) ^ (w15 >> 3));
+            }
+
+            t1 = h + (RotR(e, 6) ^ RotR(e, 11) ^ RotR(e, 25)) + ((e & f) ^ (~e & g)) + sSHA256K[t] + w[t & 15];
+            t2 = (RotR(a, 2) ^ RotR(a, 13) ^ RotR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    ClearSecretData((uint8_t *) w, sizeof(w));
+}
+
+#if WEAVE_HASH_NATIVE_X86
+
+__attribute__((target("sha,sse4.1")))
+static void SHA1Blocks_SHANI(uint32_t *state, const uint8_t *blocks, size_t numBlocks)
+{
+    const __m128i byteSwapMask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090A0B0C0D0E0FULL);
+    __m128i abcd, abcdSave, e0, e0Save, e1;
+    __m128i msg[4];
+
+    abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state), 0x1B);
+    e0 = _mm_set_epi32((int) state[4], 0, 0, 0);
+
+    for (; numBlocks > 0; numBlocks--, blocks += kHashBlockLength)
+    {
+        abcdSave = abcd;
+        e0Save = e0;
+
+        // Each iteration performs four rounds.  The message schedule is kept in
+        // four registers that are recycled as the rounds progress.
+#define SHA1_SHANI_ROUNDS(G, E_CUR, E_NEXT)                                                     \
+        do {                                                                                    \
+            if ((G) < 4)                                                                        \
+                msg[(G)] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (blocks + 16 * (G))), byteSwapMask); \
+            if ((G) == 0)                                                                       \
+                E_CUR = _mm_add_epi32(E_CUR, msg[0]);                                           \
+            else                                                                                \
+                E_CUR = _mm_sha1nexte_epu32(E_CUR, msg[(G) & 3]);                               \
+            E_NEXT = abcd;                                                                      \
+            if ((G) >= 3 && (G) <= 18)                                                          \
+                msg[((G) + 1) & 3] = _mm_sha1msg2_epu32(msg[((G) + 1) & 3], msg[(G) & 3]);      \
+            abcd = _mm_sha1rnds4_epu32(abcd, E_CUR, (G) / 5);                                   \
+            if ((G) >= 1 && (G) <= 16)                                                          \
+                msg[((G) + 3) & 3] = _mm_sha1msg1_epu32(msg[((G) + 3) & 3], msg[(G) & 3]);      \
+            if ((G) >= 2 && (G) <= 17)                                                          \
+                msg[((G) + 2) & 3] = _mm_xor_si128(msg[((G) + 2) & 3], msg[(G) & 3]);           \
+        } while (0)
+
+        SHA1_SHANI_ROUNDS(0, e0, e1);
+        SHA1_SHANI_ROUNDS(1, e1, e0);
+        SHA1_SHANI_ROUNDS(2, e0, e1);
+        SHA1_SHANI_ROUNDS(3, e1, e0);
+        SHA1_SHANI_ROUNDS(4, e0, e1);
+        SHA1_SHANI_ROUNDS(5, e1, e0);
+        SHA1_SHANI_ROUNDS(6, e0, e1);
+        SHA1_SHANI_ROUNDS(7, e1, e0);
+        SHA1_SHANI_ROUNDS(8, e0, e1);
+        SHA1_SHANI_ROUNDS(9, e1, e0);
+        SHA1_SHANI_ROUNDS(10, e0, e1);
+        SHA1_SHANI_ROUNDS(11, e1, e0);
+        SHA1_SHANI_ROUNDS(12, e0, e1);
+        SHA1_SHANI_ROUNDS(13, e1, e0);
+        SHA1_SHANI_ROUNDS(14, e0, e1);
+        SHA1_SHANI_ROUNDS(15, e1, e0);
+        SHA1_SHANI_ROUNDS(16, e0, e1);
+        SHA1_SHANI_ROUNDS(17, e1, e0);
+        SHA1_SHANI_ROUNDS(18, e0, e1);
+        SHA1_SHANI_ROUNDS(19, e1, e0);
+
+#undef SHA1_SHANI_ROUNDS
+
+        e0 = _mm_sha1nexte_epu32(e0, e0Save);
+        abcd = _mm_add_epi32(abcd, abcdSave);
+    }
+
+    _mm_storeu_si128((__m128i *) state, _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = (uint32_t) _mm_extract_epi32(e0, 3);
+
+    ClearSecretData((uint8_t *) msg, sizeof(msg));
+}
+
+__attribute__((target("sha,sse4.1")))
+static void SHA256Blocks_SHANI(uint32_t *state, const uint8_t *blocks, size_t numBlocks)
+{
+    const __m128i byteSwapMask = _mm_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+    __m128i state0, state1, abefSave, cdghSave, tmp, m;
+    __m128i msg[4];
+
+    // Rearrange the state into the ABEF / CDGH form used by SHA256RNDS2.
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[0]), 0xB1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[4]), 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; numBlocks > 0; numBlocks--, blocks += kHashBlockLength)
+    {
+        abefSave = state0;
+        cdghSave = state1;
+
+        for (int g = 0; g < 16; g++)
+        {
+            if (g < 4)
+                msg[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (blocks + 16 * g)), byteSwapMask);
+
+            m = _mm_add_epi32(msg[g & 3], _mm_loadu_si128((const __m128i *) &sSHA256K[4 * g]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+
+            if (g >= 3 && g <= 14)
+            {
+                tmp = _mm_alignr_epi8(msg[g & 3], msg[(g + 3) & 3], 4);
+                msg[(g + 1) & 3] = _mm_add_epi32(msg[(g + 1) & 3], tmp);
+                msg[(g + 1) & 3] = _mm_sha256msg2_epu32(msg[(g + 1) & 3], msg[g & 3]);
+            }
+
+            m = _mm_shuffle_epi32(m, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, m);
+
+            if (g >= 1 && g <= 12)
+                msg[(g + 3) & 3] = _mm_sha256msg1_epu32(msg[(g + 3) & 3], msg[g & 3]);
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    _mm_storeu_si128((__m128i *) &state[0], _mm_blend_epi16(tmp, state1, 0xF0));
+    _mm_storeu_si128((__m128i *) &state[4], _mm_alignr_epi8(state1, tmp, 8));
+
+    ClearSecretData((uint8_t *) msg, sizeof(msg));
+}
+
+#define AVX2_ROTL(X, N) _mm256_or_si256(_mm256_slli_epi32((X), (N)), _mm256_srli_epi32((X), 32 - (N)))
+#define AVX2_ROTR(X, N) _mm256_or_si256(_mm256_srli_epi32((X), (N)), _mm256_slli_epi32((X), 32 - (N)))
+
+// Load word T of each lane's block, byte-swapped, into one vector.
+#define AVX2_LOAD_WORD(P, T)                                                                    \
+    _mm256_setr_epi32((int) GetBE32((P)[0] + 4 * (T)), (int) GetBE32((P)[1] + 4 * (T)),         \
+                      (int) GetBE32((P)[2] + 4 * (T)), (int) GetBE32((P)[3] + 4 * (T)),         \
+                      (int) GetBE32((P)[4] + 4 * (T)), (int) GetBE32((P)[5] + 4 * (T)),         \
+                      (int) GetBE32((P)[6] + 4 * (T)), (int) GetBE32((P)[7] + 4 * (T)))
+
+__attribute__((target("avx2")))
+static void LoadLaneStates(__m256i *s, int numWords, uint32_t * const states[], size_t numLanes)
+{
+    uint32_t words[kMaxLanes];
+
+    for (int k = 0; k < numWords; k++)
+    {
+        for (size_t j = 0; j < kMaxLanes; j++)
+            words[j] = states[(j < numLanes) ? j : 0][k];
+        s[k] = _mm256_loadu_si256((const __m256i *) words);
+    }
+}
+
+__attribute__((target("avx2")))
+static void StoreLaneStates(const __m256i *s, int numWords, uint32_t * const states[], size_t numLanes)
+{
+    uint32_t words[kMaxLanes];
+
+    for (int k = 0; k < numWords; k++)
+    {
+        _mm256_storeu_si256((__m256i *) words, s[k]);
+        for (size_t j = 0; j < numLanes; j++)
+            states[j][k] = words[j];
+    }
+}
+
+__attribute__((target("avx2")))
+static void SHA1Lanes_AVX2(uint32_t * const states[], const uint8_t * const blocks[], size_t numLanes)
+{
+    const uint8_t *p[kMaxLanes];
+    __m256i s[5], w[16];
+    __m256i a, b, c, d, e, f, k, temp;
+
+    // Unused lanes recompute lane 0; their results are discarded.
+    for (size_t j = 0; j < kMaxLanes; j++)
+        p[j] = blocks[(j < numLanes) ? j : 0];
+
+    LoadLaneStates(s, 5, states, numLanes);
+    a = s[0]; b = s[1]; c = s[2]; d = s[3]; e = s[4];
+
+    for (int t = 0; t < 80; t++)
+    {
+        if (t < 16)
+            w[t] = AVX2_LOAD_WORD(p, t);
+        else
+        {
+            temp = _mm256_xor_si256(_mm256_xor_si256(w[(t - 3) & 15], w[(t - 8) & 15]),
+                                    _mm256_xor_si256(w[(t - 14) & 15], w[t & 15]));
+            w[t & 15] = AVX2_ROTL(temp, 1);
+        }
+
+        if (t < 20)
+        {
+            f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_andnot_si256(b, d));
+            k = _mm256_set1_epi32(0x5A827999);
+        }
+        else if (t < 40)
+        {
+            f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+            k = _mm256_set1_epi32(0x6ED9EBA1);
+        }
+        else if (t < 60)
+        {
+            f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)));
+            k = _mm256_set1_epi32((int) 0x8F1BBCDC);
+        }
+        else
+        {
+            f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+            k = _mm256_set1_epi32((int) 0xCA62C1D6);
+        }
+
+        temp = _mm256_add_epi32(_mm256_add_epi32(AVX2_ROTL(a, 5), f), _mm256_add_epi32(_mm256_add_epi32(e, k), w[t & 15]));
+        e = d;
+        d = c;
+        c = AVX2_ROTL(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    s[0] = _mm256_add_epi32(s[0], a);
+    s[1] = _mm256_add_epi32(s[1], b);
+    s[2] = _mm256_add_epi32(s[2], c);
+    s[3] = _mm256_add_epi32(s[3], d);
+    s[4] = _mm256_add_epi32(s[4], e);
+    StoreLaneStates(s, 5, states, numLanes);
+
+    ClearSecretData((uint8_t *) w, sizeof(w));
+}
+
+__attribute__((target("avx2")))
+static void SHA256Lanes_AVX2(uint32_t * const states[], const uint8_t * const blocks[], size_t numLanes)
+{
+    const uint8_t *p[kMaxLanes];
+    __m256i s[8], w[16];
+    __m256i a, b, c, d, e, f, g, h, t1, t2, x;
+
+    for (size_t j = 0; j < kMaxLanes; j++)
+        p[j] = blocks[(j < numLanes) ? j : 0];
+
+    LoadLaneStates(s, 8, states, numLanes);
+    a = s[0]; b = s[1]; c = s[2]; d = s[3]; e = s[4]; f = s[5]; g = s[6]; h = s[7];
+
+    for (int t = 0; t < 64; t++)
+    {
+        if (t < 16)
+            w[t] = AVX2_LOAD_WORD(p, t);
+        else
+        {
+            __m256i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(w15, 7), AVX2_ROTR(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(w2, 17), AVX2_ROTR(w2, 19)), _mm256_srli_epi32(w2, 10));
+            w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+        }
+
+        x = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(e, 6), AVX2_ROTR(e, 11)), AVX2_ROTR(e, 25));
+        t1 = _mm256_add_epi32(h, x);
+        x = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        t1 = _mm256_add_epi32(t1, x);
+        t1 = _mm256_add_epi32(t1, _mm256_add_epi32(_mm256_set1_epi32((int) sSHA256K[t]), w[t & 15]));
+
+        x = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(a, 2), AVX2_ROTR(a, 13)), AVX2_ROTR(a, 22));
+        t2 = _mm256_add_epi32(x, _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b))));
+
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+
+    s[0] = _mm256_add_epi32(s[0], a);
+    s[1] = _mm256_add_epi32(s[1], b);
+    s[2] = _mm256_add_epi32(s[2], c);
+    s[3] = _mm256_add_epi32(s[3], d);
+    s[4] = _mm256_add_epi32(s[4], e);
+    s[5] = _mm256_add_epi32(s[5], f);
+    s[6] = _mm256_add_epi32(s[6], g);
+    s[7] = _mm256_add_epi32(s[7], h);
+    StoreLaneStates(s, 8, states, numLanes);
+
+    ClearSecretData((uint8_t *) w, sizeof(w));
+}
+
+#undef AVX2_LOAD_WORD
+#undef AVX2_ROTR
+#undef AVX2_ROTL
+
+#endif // WEAVE_HASH_NATIVE_X86
+
+struct HashFuncts
+{
+    HashBlocksFunct SHA1Blocks;
+    HashBlocksFunct SHA256Blocks;
+    HashLanesFunct SHA1Lanes;
+    HashLanesFunct SHA256Lanes;
+};
+
+static const HashFuncts sGenericHashFuncts = { SHA1Blocks_Generic, SHA256Blocks_Generic, NULL, NULL };
+#if WEAVE_HASH_NATIVE_X86
+static const HashFuncts sAVX2HashFuncts = { SHA1Blocks_Generic, SHA256Blocks_Generic, SHA1Lanes_AVX2, SHA256Lanes_AVX2 };
+static const HashFuncts sSHANIHashFuncts = { SHA1Blocks_SHANI, SHA256Blocks_SHANI, NULL, NULL };
+#endif
+
+// Published once with a compare-and-swap so that threads racing on first use all see a complete table.
+static const HashFuncts *sHashFuncts;
+
+#if WEAVE_HASH_NATIVE_X86
+
+static bool CPUSupportsSHANI(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    bool hasSSE41 = false, hasSHA = false;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        hasSSE41 = (ecx & (1 << 19)) != 0 && (ecx & (1 << 9)) != 0;   // SSE4.1 and SSSE3
+
+    if (__get_cpuid_max(0, NULL) >= 7)
+    {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        hasSHA = (ebx & (1 << 29)) != 0;
+    }
+
+    return hasSHA && hasSSE41;
+}
+
+static bool CPUSupportsAVX2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // WEAVE_HASH_NATIVE_X86
+
+static const HashFuncts *LookupHashFuncts(NativeHashBackend backend)
+{
+    switch (backend)
+    {
+    case kNativeHashBackend_Generic:
+        return &sGenericHashFuncts;
+#if WEAVE_HASH_NATIVE_X86
+    case kNativeHashBackend_AVX2:
+        return CPUSupportsAVX2() ? &sAVX2HashFuncts : NULL;
+    case kNativeHashBackend_SHANI:
+        return CPUSupportsSHANI() ? &sSHANIHashFuncts : NULL;
+    case kNativeHashBackend_Auto:
+        if (CPUSupportsSHANI())
+            return &sSHANIHashFuncts;
+        if (CPUSupportsAVX2())
+            return &sAVX2HashFuncts;
+        return &sGenericHashFuncts;
+#else
+    case kNativeHashBackend_Auto:
+        return &sGenericHashFuncts;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+static const HashFuncts& GetHashFuncts(void)
+{
+    const HashFuncts *functs = sHashFuncts;
+
+    if (functs == NULL)
+    {
+        // Only the first caller's selection is published; any racing caller picks up the winner.
+        __sync_bool_compare_and_swap(&sHashFuncts, (const HashFuncts *) NULL, LookupHashFuncts(kNativeHashBackend_Auto));
+        functs = sHashFuncts;
+    }
+
+    return *functs;
+}
+
+/**
+ * Force the native hash implementation to use a particular backend.
+ *
+ * This is intended for tests that need to cover each backend on a single machine. It must not
+ * be called while hashes are in progress on other threads.
+ *
+ * @param[in] backend   The backend to use, or #kNativeHashBackend_Auto to select the fastest
+ *                      backend supported by the CPU.
+ *
+ * @return true if the backend is supported by this build and CPU, false otherwise.
+ */
+bool SelectNativeHashBackend(NativeHashBackend backend)
+{
+    const HashFuncts *functs = LookupHashFuncts(backend);
+
+    if (functs == NULL)
+        return false;
+
+    __sync_synchronize();
+    sHashFuncts = functs;
+
+    return true;
+}
+
+template <class CTX>
+static void HashBegin(CTX& ctx, const uint32_t *initState, size_t stateSize)
+{
+    memcpy(ctx.State, initState, stateSize);
+    ctx.Length = 0;
+}
+
+template <class CTX>
+static void HashAddData(CTX& ctx, const uint8_t *data, size_t dataLen, HashBlocksFunct blocksFunct)
+{
+    size_t bufferLen = (size_t) (ctx.Length % kHashBlockLength);
+
+    ctx.Length += dataLen;
+
+    // Complete any partially filled block first.
+    if (bufferLen > 0)
+    {
+        size_t copyLen = kHashBlockLength - bufferLen;
+        if (copyLen > dataLen)
+            copyLen = dataLen;
+
+        memcpy(ctx.Buffer + bufferLen, data, copyLen);
+        data += copyLen;
+        dataLen -= copyLen;
+
+        if (bufferLen + copyLen < kHashBlockLength)
+            return;
+
+        blocksFunct(ctx.State, ctx.Buffer, 1);
+    }
+
+    // Hash whole blocks directly from the input.
+    if (dataLen >= kHashBlockLength)
+    {
+        blocksFunct(ctx.State, data, dataLen / kHashBlockLength);
+        data += dataLen - (dataLen % kHashBlockLength);
+        dataLen %= kHashBlockLength;
+    }
+
+    // Save any remainder for the next call.
+    if (dataLen > 0)
+        memcpy(ctx.Buffer, data, dataLen);
+}
+
+template <class CTX>
+static void HashFinish(CTX& ctx, uint8_t *hashBuf, size_t hashLen, HashBlocksFunct blocksFunct)
+{
+    size_t bufferLen = (size_t) (ctx.Length % kHashBlockLength);
+    uint64_t bitLength = ctx.Length * 8;
+
+    // Append the 0x80 terminator, zero pad and append the 64-bit message length in bits.
+    ctx.Buffer[bufferLen++] = 0x80;
+    if (bufferLen > kHashBlockLength - 8)
+    {
+        memset(ctx.Buffer + bufferLen, 0, kHashBlockLength - bufferLen);
+        blocksFunct(ctx.State, ctx.Buffer, 1);
+        bufferLen = 0;
+    }
+    memset(ctx.Buffer + bufferLen, 0, kHashBlockLength - 8 - bufferLen);
+    PutBE32(ctx.Buffer + kHashBlockLength - 8, (uint32_t) (bitLength >> 32));
+    PutBE32(ctx.Buffer + kHashBlockLength - 4, (uint32_t) bitLength);
+    blocksFunct(ctx.State, ctx.Buffer, 1);
+
+    for (size_t i = 0; i < hashLen / 4; i++)
+        PutBE32(hashBuf + 4 * i, ctx.State[i]);
+}
+
+template <class CTX>
+static void HashAddDataMultiple(CTX * const ctxs[], const uint8_t * const data[], const uint16_t dataLens[], uint16_t count,
+                                HashBlocksFunct blocksFunct, HashLanesFunct lanesFunct)
+{
+    if (lanesFunct == NULL)
+    {
+        for (uint16_t i = 0; i < count; i++)
+            HashAddData(*ctxs[i], data[i], dataLens[i], blocksFunct);
+        return;
+    }
+
+    for (uint16_t base = 0; base < count; base += kMaxLanes)
+    {
+        size_t numLanes = count - base;
+        const uint8_t *ptrs[kMaxLanes];
+        size_t remaining[kMaxLanes];
+
+        if (numLanes > kMaxLanes)
+            numLanes = kMaxLanes;
+
+        // Top up any partially filled blocks so that each lane's input starts on a block boundary.
+        for (size_t j = 0; j < numLanes; j++)
+        {
+            CTX& ctx = *ctxs[base + j];
+            size_t bufferLen = (size_t) (ctx.Length % kHashBlockLength);
+
+            ptrs[j] = data[base + j];
+            remaining[j] = dataLens[base + j];
+
+            if (bufferLen > 0)
+            {
+                size_t copyLen = kHashBlockLength - bufferLen;
+                if (copyLen > remaining[j])
+                    copyLen = remaining[j];
+
+                HashAddData(ctx, ptrs[j], copyLen, blocksFunct);
+                ptrs[j] += copyLen;
+                remaining[j] -= copyLen;
+            }
+        }
+
+        // Hash one block from every lane that still has a whole block, for as long as two or more do.
+        while (true)
+        {
+            uint32_t *laneStates[kMaxLanes];
+            const uint8_t *laneBlocks[kMaxLanes];
+            size_t laneIndex[kMaxLanes];
+            size_t numActive = 0;
+
+            for (size_t j = 0; j < numLanes; j++)
+            {
+                if (remaining[j] >= kHashBlockLength)
+                {
+                    laneStates[numActive] = ctxs[base + j]->State;
+                    laneBlocks[numActive] = ptrs[j];
+                    laneIndex[numActive] = j;
+                    numActive++;
+                }
+            }
+
+            if (numActive < 2)
+                break;
+
+            lanesFunct(laneStates, laneBlocks, numActive);
+
+            for (size_t i = 0; i < numActive; i++)
+            {
+                size_t j = laneIndex[i];
+                ctxs[base + j]->Length += kHashBlockLength;
+                ptrs[j] += kHashBlockLength;
+                remaining[j] -= kHashBlockLength;
+            }
+        }
+
+        // Finish whatever is left one message at a time.
+        for (size_t j = 0; j < numLanes; j++)
+        {
+            if (remaining[j] > 0)
+                HashAddData(*ctxs[base + j], ptrs[j], remaining[j], blocksFunct);
+        }
+    }
+}
+
+SHA1::SHA1()
+{
+}
+
+SHA1::~SHA1()
+{
+}
+
+void SHA1::Begin()
+{
+    HashBegin(mSHACtx, sSHA1InitState, sizeof(sSHA1InitState));
+}
+
+void SHA1::AddData(const uint8_t *data, uint16_t dataLen)
+{
+    HashAddData(mSHACtx, data, dataLen, GetHashFuncts().SHA1Blocks);
+}
+
+void SHA1::Finish(uint8_t *hashBuf)
+{
+    HashFinish(mSHACtx, hashBuf, kHashLength, GetHashFuncts().SHA1Blocks);
+}
+
+void SHA1::Reset()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+void SHA1::AddDataMultiple(SHA1 * const hashes[], const uint8_t * const data[], const uint16_t dataLens[], uint16_t count)
+{
+    SHA_CTX_NATIVE *ctxs[kMaxLanes];
+    const HashFuncts& functs = GetHashFuncts();
+
+    for (uint16_t base = 0; base < count; base += kMaxLanes)
+    {
+        uint16_t n = (count - base < kMaxLanes) ? count - base : (uint16_t) kMaxLanes;
+
+        for (uint16_t i = 0; i < n; i++)
+            ctxs[i] = &hashes[base + i]->mSHACtx;
+
+        HashAddDataMultiple(ctxs, data + base, dataLens + base, n, functs.SHA1Blocks, functs.SHA1Lanes);
+    }
+}
+
+SHA256::SHA256()
+{
+}
+
+SHA256::~SHA256()
+{
+}
+
+void SHA256::Begin()
+{
+    HashBegin(mSHACtx, sSHA256InitState, sizeof(sSHA256InitState));
+}
+
+void SHA256::AddData(const uint8_t *data, uint16_t dataLen)
+{
+    HashAddData(mSHACtx, data, dataLen, GetHashFuncts().SHA256Blocks);
+}
+
+void SHA256::Finish(uint8_t *hashBuf)
+{
+    HashFinish(mSHACtx, hashBuf, kHashLength, GetHashFuncts().SHA256Blocks);
+}
+
+void SHA256::Reset()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+void SHA256::AddDataMultiple(SHA256 * const hashes[], const uint8_t * const data[], const uint16_t dataLens[], uint16_t count)
+{
+    SHA256_CTX_NATIVE *ctxs[kMaxLanes];
+    const HashFuncts& functs = GetHashFuncts();
+
+    for (uint16_t base = 0; base < count; base += kMaxLanes)
+    {
+        uint16_t n = (count - base < kMaxLanes) ? count - base : (uint16_t) kMaxLanes;
+
+        for (uint16_t i = 0; i < n; i++)
+            ctxs[i] = &hashes[base + i]->mSHACtx;
+
+        HashAddDataMultiple(ctxs, data + base, dataLens + base, n, functs.SHA256Blocks, functs.SHA256Lanes);
+    }
+}
+
+} /* namespace Security */
+} /* namespace Platform */
+} /* namespace Weave */
+} /* namespace nl */
+
+#endif // WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
@@ -33,6 +33,11 @@
  *    @note WeaveProjectHashAlgos.h should include declarations of SHA_CTX_PLATFORM
  *          and SHA256_CTX_PLATFORM context structures.
  *
+ *      AddDataMultiple() adds one chunk of data to each of several independent,
+ *      already begun hash computations (e.g. the inner hashes of a batch of HMACs
+ *      being verified). Implementations that can hash in parallel lanes do so;
+ *      the others process the hashes one after the other.
+ *
  */
 
 #ifndef HashAlgos_H_
@@ -73,6 +78,34 @@ namespace Weave {
 namespace Platform {
 namespace Security {
 
+#if WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+
+struct SHA_CTX_NATIVE
+{
+    uint32_t State[5];
+    uint64_t Length;
+    uint8_t Buffer[64];
+};
+
+struct SHA256_CTX_NATIVE
+{
+    uint32_t State[8];
+    uint64_t Length;
+    uint8_t Buffer[64];
+};
+
+enum NativeHashBackend
+{
+    kNativeHashBackend_Auto     = 0,    /**< The fastest backend supported by the CPU. */
+    kNativeHashBackend_Generic  = 1,    /**< Portable C implementation. */
+    kNativeHashBackend_AVX2     = 2,    /**< Portable single-buffer code with AVX2 multi-buffer lanes. */
+    kNativeHashBackend_SHANI    = 3     /**< x86 SHA extensions. */
+};
+
+extern bool SelectNativeHashBackend(NativeHashBackend backend);
+
+#endif // WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+
 class NL_DLL_EXPORT SHA1
 {
 public:
@@ -93,6 +126,8 @@ public:
     void Finish(uint8_t *hashBuf);
     void Reset(void);
 
+    static void AddDataMultiple(SHA1 * const hashes[], const uint8_t * const data[], const uint16_t dataLens[], uint16_t count);
+
 private:
 #if WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL
     SHA_CTX mSHACtx;
@@ -100,6 +135,8 @@ private:
     MINCRYPT_SHA_CTX mSHACtx;
 #elif WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM
     SHA_CTX_PLATFORM mSHACtx;
+#elif WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+    SHA_CTX_NATIVE mSHACtx;
 #endif
 };
 
@@ -123,6 +160,8 @@ public:
     void Finish(uint8_t *hashBuf);
     void Reset(void);
 
+    static void AddDataMultiple(SHA256 * const hashes[], const uint8_t * const data[], const uint16_t dataLens[], uint16_t count);
+
 private:
 #if WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL
     SHA256_CTX mSHACtx;
@@ -130,9 +169,29 @@ private:
     MINCRYPT_SHA256_CTX mSHACtx;
 #elif WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM
     SHA256_CTX_PLATFORM mSHACtx;
+#elif WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+    SHA256_CTX_NATIVE mSHACtx;
 #endif
 };
 
+#if !WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+
+// Implementations without a multi-buffer primitive process the messages one after the other.
+
+inline void SHA1::AddDataMultiple(SHA1 * const hashes[], const uint8_t * const data[], const uint16_t dataLens[], uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+        hashes[i]->AddData(data[i], dataLens[i]);
+}
+
+inline void SHA256::AddDataMultiple(SHA256 * const hashes[], const uint8_t * const data[], const uint16_t dataLens[], uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+        hashes[i]->AddData(data[i], dataLens[i]);
+}
+
+#endif // !WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+
 } // namespace Security
 } // namespace Platform
 } // namespace Weave
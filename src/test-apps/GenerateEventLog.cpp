@@ -123,6 +123,7 @@ struct LogContext
     bool mVerbose;
     bool mBDX;
     bool mWDMOutput;
+    bool mCompress;
 };
 
 LogContext gLogContext;
@@ -135,7 +136,8 @@ LogContext::LogContext() :
     mRaw(false),
     mVerbose(false),
     mBDX(false),
-    mWDMOutput(false)
+    mWDMOutput(false),
+    mCompress(false)
 {
 }
 
@@ -217,6 +219,52 @@ void SimpleDumpWriter(const char *aFormat, ...)
     va_end(args);
 }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+// Compress the log as LogBDXUpload would, one block at a time, and
+// report the ratio and the speed of compression and decompression.
+static void ReportCompression(const uint8_t *inData, size_t inLength, FILE *out)
+{
+    const size_t kBlockSize = 1024;
+    const uint64_t kDuration = 200000;
+    static EventStreamCompressor sCompressor;
+    static EventStreamDecompressor sDecompressor;
+    static uint8_t sCompressed[LOG_BUFFER_SIZE * 9];
+    static uint8_t sDecompressed[LOG_BUFFER_SIZE * 8];
+    size_t compressedLength = 0, decompressedLength = 0, length;
+    uint64_t startTime, elapsedTime, rounds;
+    double compressRate, decompressRate;
+
+    startTime = nl::Weave::System::Layer::GetClock_MonotonicHiRes();
+    for (rounds = 0, elapsedTime = 0; elapsedTime < kDuration; rounds++)
+    {
+        sCompressor.Reset();
+        compressedLength = 0;
+        for (size_t offset = 0; offset < inLength; offset += kBlockSize)
+        {
+            sCompressor.Compress(inData + offset, (inLength - offset < kBlockSize) ? inLength - offset : kBlockSize,
+                                 sCompressed + compressedLength, sizeof(sCompressed) - compressedLength, length);
+            compressedLength += length;
+        }
+        elapsedTime = nl::Weave::System::Layer::GetClock_MonotonicHiRes() - startTime;
+    }
+    compressRate = (double) rounds * inLength / (double) elapsedTime;
+
+    startTime = nl::Weave::System::Layer::GetClock_MonotonicHiRes();
+    for (rounds = 0, elapsedTime = 0; elapsedTime < kDuration; rounds++)
+    {
+        sDecompressor.Reset();
+        sDecompressor.Decompress(sCompressed, compressedLength, sDecompressed, sizeof(sDecompressed), decompressedLength);
+        elapsedTime = nl::Weave::System::Layer::GetClock_MonotonicHiRes() - startTime;
+    }
+    decompressRate = (double) rounds * inLength / (double) elapsedTime;
+
+    fprintf(out, "Compressed %u bytes to %u bytes (%.2fx), compress %.1f MB/s, decompress %.1f MB/s%s\n",
+            static_cast<unsigned>(inLength), static_cast<unsigned>(compressedLength),
+            (double) inLength / (double) (compressedLength ? compressedLength : 1), compressRate, decompressRate,
+            (decompressedLength == inLength && memcmp(sDecompressed, inData, inLength) == 0) ? "" : ", MISMATCH");
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+
 void DumpEventLog(LogContext *inContext)
 {
     uint8_t backingStore[LOG_BUFFER_SIZE*8];
@@ -285,6 +333,13 @@ void DumpEventLog(LogContext *inContext)
         SuccessOrExit(err);
     }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    if (inContext->mCompress)
+    {
+        ReportCompression(backingStore, writer.GetLengthWritten(), out);
+    }
+    else
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
     if (inContext->mRaw)
     {
         fwrite(backingStore, 1, writer.GetLengthWritten(), out);
@@ -370,6 +425,7 @@ const size_t gNumTests = sizeof(gTests)/sizeof(void(*)(void *));
 
 static OptionDef gToolOptionDefs[] =
 {
+    { "compress",   kNoArgument,        'c' },
     { "loglevel",   kArgumentRequired,  'l' },
     { "output",     kArgumentRequired,  'o' },
     { "raw",        kNoArgument,        'r' },
@@ -380,6 +436,8 @@ static OptionDef gToolOptionDefs[] =
 };
 
 static const char *gToolOptionHelp =
+    "  -c, --compress\n"
+    "       Report how well the log compresses for upload over BDX\n"
     "  -l, --loglevel <logLevel>\n"
     "       Configured default log level, 1 - PRODUCTION, 2 - INFO, 3 - DEBUG\n"
     "  -o, --output <filename>\n"
@@ -423,6 +481,10 @@ bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *n
 
     switch (id)
     {
+    case 'c':
+        gLogContext.mCompress = true;
+        break;
+
     case 'l':
         if (!ParseInt(arg, level) || level == 0 || level > 3)
         {
@@ -43,6 +43,11 @@ int main(int argc, char *argv[])
         {
             WeaveCryptoAESTests();
         }
+        else if (!strcmp(argv[1], "--bench"))
+        {
+            WeaveCryptoAESBenchmarks();
+            WeaveCryptoSHABenchmarks();
+        }
         else
         {
             printf("%s: unknown parameter %s.\n", argv[0], argv[1]);
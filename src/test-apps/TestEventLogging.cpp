@@ -31,6 +31,8 @@
 #endif
 
 #include <new>
+#include <pthread.h>
+#include <sched.h>
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
@@ -114,15 +116,29 @@ namespace Weave {
 namespace Profiles {
 namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current) {
 namespace Platform {
-    // for unit tests, the dummy critical section is sufficient.
+    // The logging benchmark logs from several threads, so the critical section is a real (recursive) lock.
+    static pthread_once_t sCriticalSectionOnce = PTHREAD_ONCE_INIT;
+    static pthread_mutex_t sCriticalSection;
+
+    static void InitCriticalSection(void)
+    {
+        pthread_mutexattr_t attr;
+
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&sCriticalSection, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+
     void CriticalSectionEnter()
     {
-        return;
+        pthread_once(&sCriticalSectionOnce, InitCriticalSection);
+        pthread_mutex_lock(&sCriticalSection);
     }
 
     void CriticalSectionExit()
     {
-        return;
+        pthread_mutex_unlock(&sCriticalSection);
     }
 } // Platform
 } // WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
@@ -275,6 +291,7 @@ static OptionSet *gToolOptionSets[] =
     &gNetworkOptions,
     &gWeaveNodeOptions,
     &gFaultInjectionOptions,
+    &gBenchmarkOptions,
     &gHelpOptions,
     NULL
 };
@@ -3532,6 +3549,683 @@ static void CheckLastObservedEventId(nlTestSuite *inSuite, void *inContext)
     DestroyEventLogging(context);
 }
 
+#if WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+// Fetch through the cache and straight from the log, and check that both produce the same events.
+static void CheckCachedFetch(nlTestSuite *inSuite, NotificationEngine::EventListCache &inCache, event_id_t inEventId,
+                             size_t inWriterLen)
+{
+    LoggingManagement &logger = LoggingManagement::GetInstance();
+    uint8_t directStore[2048];
+    uint8_t cachedStore[2048];
+    TLVWriter directWriter, cachedWriter;
+    TLVReader directReader, cachedReader;
+    size_t directCount, cachedCount;
+    event_id_t directId = inEventId, cachedId = inEventId;
+    WEAVE_ERROR directErr, cachedErr;
+
+    directWriter.Init(directStore, inWriterLen);
+    cachedWriter.Init(cachedStore, inWriterLen);
+
+    directErr = logger.FetchEventsSince(directWriter, Production, directId);
+    cachedErr = inCache.FetchEventsSince(cachedWriter, Production, cachedId);
+
+    NL_TEST_ASSERT(inSuite, cachedErr == directErr);
+    NL_TEST_ASSERT(inSuite, cachedId == directId);
+
+    directReader.Init(directStore, directWriter.GetLengthWritten());
+    cachedReader.Init(cachedStore, cachedWriter.GetLengthWritten());
+    NL_TEST_ASSERT(inSuite, nl::Weave::TLV::Utilities::Count(directReader, directCount, false) == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, nl::Weave::TLV::Utilities::Count(cachedReader, cachedCount, false) == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, cachedCount == directCount);
+
+    // Events beyond the fragment start over with an absolute timestamp and event ID; up to there, the encoding is the same.
+    if (inWriterLen <= WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE)
+    {
+        NL_TEST_ASSERT(inSuite, cachedWriter.GetLengthWritten() == directWriter.GetLengthWritten());
+        NL_TEST_ASSERT(inSuite, memcmp(cachedStore, directStore, directWriter.GetLengthWritten()) == 0);
+    }
+}
+
+static void CheckEventListCache(nlTestSuite *inSuite, void *inContext)
+{
+    TestLoggingContext *context = static_cast<TestLoggingContext *>(inContext);
+    NotificationEngine::EventListCache cache;
+    event_id_t firstId;
+    timestamp_t now = 0;
+    size_t counter;
+
+    InitializeEventLogging(context);
+
+    firstId = FastLogFreeform(Production, now, "Freeform entry %d", 0);
+    for (counter = 1; counter < 30; counter++)
+    {
+        now += 10;
+        FastLogFreeform(Production, now, "Freeform entry %d", counter);
+    }
+
+    // Subscribers caught up to the same event, with room for more events than the fragment holds, or fewer.
+    for (size_t writerLen = 2048; writerLen >= 64; writerLen /= 2)
+    {
+        CheckCachedFetch(inSuite, cache, firstId, writerLen);
+    }
+
+    // A subscriber further along, and one whose events have been evicted.
+    CheckCachedFetch(inSuite, cache, firstId + 10, 2048);
+    CheckCachedFetch(inSuite, cache, 0, 2048);
+
+    // Events logged after the fragment was read.
+    CheckCachedFetch(inSuite, cache, firstId, 2048);
+    for (; counter < 35; counter++)
+    {
+        now += 10;
+        FastLogFreeform(Production, now, "Freeform entry %d", counter);
+    }
+    CheckCachedFetch(inSuite, cache, firstId, 2048);
+
+    DestroyEventLogging(context);
+}
+
+// Measure the rate at which many subscribers that are caught up to the same event fetch the events logged since, with the
+// log read once and shared through the cache, and with the log read separately for each subscriber.
+static void BenchmarkEventListFanOut(TestLoggingContext *context)
+{
+    const size_t kNumSubscribers = 64;
+    const size_t kNumNewEvents   = 4;
+    LoggingManagement &logger    = LoggingManagement::GetInstance();
+    NotificationEngine::EventListCache cache;
+    uint8_t backingStore[1024];
+    TLVWriter writer;
+
+    for (int shared = 1; shared >= 0; shared--)
+    {
+        uint64_t totalFetches = 0;
+        event_id_t eventId;
+        timestamp_t now = 0;
+
+        InitializeEventLogging(context);
+
+        // Fill the log so that each fetch has to skip over older events, as it would on a device.
+        for (size_t i = 0; i < 40; i++)
+        {
+            now += 10;
+            FastLogFreeform(Production, now, "Freeform entry %d", i);
+        }
+
+        BenchmarkTimer timer;
+
+        while (timer.Continue())
+        {
+            eventId = logger.GetLastEventID(Production) + 1;
+
+            for (size_t i = 0; i < kNumNewEvents; i++)
+            {
+                now += 10;
+                FastLogFreeform(Production, now, "Freeform entry %d", i);
+            }
+
+            // One run of the notification engine.
+            cache.Clear();
+
+            for (size_t i = 0; i < kNumSubscribers; i++)
+            {
+                event_id_t vendedId = eventId;
+
+                writer.Init(backingStore, sizeof(backingStore));
+
+                if (shared)
+                {
+                    cache.FetchEventsSince(writer, Production, vendedId);
+                }
+                else
+                {
+                    logger.FetchEventsSince(writer, Production, vendedId);
+                }
+            }
+
+            totalFetches += kNumSubscribers;
+        }
+
+        printf("Event list fan-out %u subscribers %-16s %12.0f fetches/s\n", static_cast<unsigned>(kNumSubscribers),
+               shared ? "shared" : "per-subscriber", (double) totalFetches * 1000000.0 / (double) timer.ElapsedUSec());
+
+        DestroyEventLogging(context);
+    }
+}
+#endif // WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+static WEAVE_ERROR WriteCounterEventData(TLVWriter &ioWriter, uint8_t inDataTag, void *appData)
+{
+    WEAVE_ERROR err;
+    TLVType outer;
+
+    err = ioWriter.StartContainer(ContextTag(inDataTag), kTLVType_Structure, outer);
+    SuccessOrExit(err);
+
+    err = ioWriter.Put(ContextTag(1), *static_cast<uint32_t *>(appData));
+    SuccessOrExit(err);
+
+    err = ioWriter.EndContainer(outer);
+
+exit:
+    return err;
+}
+
+// Read the counters written by WriteCounterEventData out of the events logged since inEventId.
+static size_t ReadCounterEvents(event_id_t inEventId, uint32_t *outCounters, size_t inMaxCounters)
+{
+    WEAVE_ERROR err;
+    TLVWriter writer;
+    TLVReader reader;
+    TLVType eventType, dataType;
+    size_t numCounters = 0;
+
+    writer.Init(gLargeMemoryBackingStore, sizeof(gLargeMemoryBackingStore));
+    LoggingManagement::GetInstance().FetchEventsSince(writer, Production, inEventId);
+
+    reader.Init(gLargeMemoryBackingStore, writer.GetLengthWritten());
+
+    while (reader.Next() == WEAVE_NO_ERROR && numCounters < inMaxCounters)
+    {
+        err = reader.EnterContainer(eventType);
+        SuccessOrExit(err);
+
+        while (reader.Next() == WEAVE_NO_ERROR)
+        {
+            if (reader.GetTag() == ContextTag(kTag_EventData))
+            {
+                err = reader.EnterContainer(dataType);
+                SuccessOrExit(err);
+
+                err = reader.Next();
+                SuccessOrExit(err);
+
+                err = reader.Get(outCounters[numCounters++]);
+                SuccessOrExit(err);
+
+                err = reader.ExitContainer(dataType);
+                SuccessOrExit(err);
+            }
+        }
+
+        err = reader.ExitContainer(eventType);
+        SuccessOrExit(err);
+    }
+
+exit:
+    return numCounters;
+}
+
+static void CheckStagedEvents(nlTestSuite *inSuite, void *inContext)
+{
+    TestLoggingContext *context = static_cast<TestLoggingContext *>(inContext);
+    LoggingManagement &logger = LoggingManagement::GetInstance();
+    EventSchema schema = { OpenCloseProfileID, 1, Production, 1, 1 };
+    EventOptions options(static_cast<timestamp_t>(100));
+    event_id_t firstId;
+    uint32_t counters[64];
+    uint32_t counter;
+    size_t numStaged;
+    WEAVE_ERROR err;
+
+    InitializeEventLogging(context);
+
+    // Log an event directly, so that the IDs of the staged events follow on from it.
+    FastLogFreeform(Production, 10, "Direct entry");
+
+    firstId = logger.GetLastEventID(Production) + 1;
+
+    // Events are only logged, and given IDs, when they are merged; each ring is merged in order.
+    for (counter = 0; counter < 3; counter++)
+    {
+        err = StageEvent(1, schema, WriteCounterEventData, &counter, &options);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    }
+    counter = 10;
+    err = StageEvent(0, schema, WriteCounterEventData, &counter, NULL);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    NL_TEST_ASSERT(inSuite, logger.GetLastEventID(Production) + 1 == firstId);
+
+    logger.MergeStagedEvents();
+
+    NL_TEST_ASSERT(inSuite, logger.GetLastEventID(Production) == firstId + 3);
+    NL_TEST_ASSERT(inSuite, ReadCounterEvents(firstId, counters, 64) == 4);
+    NL_TEST_ASSERT(inSuite, counters[0] == 10 && counters[1] == 0 && counters[2] == 1 && counters[3] == 2);
+
+    NL_TEST_ASSERT(inSuite, StageEvent(WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS, schema, WriteCounterEventData, &counter, NULL) ==
+                   WEAVE_ERROR_INVALID_ARGUMENT);
+
+    // Fill a ring, then wrap around it.
+    for (int pass = 0; pass < 3; pass++)
+    {
+        firstId   = logger.GetLastEventID(Production) + 1;
+        numStaged = 0;
+
+        for (counter = 0; (err = StageEvent(2, schema, WriteCounterEventData, &counter, NULL)) == WEAVE_NO_ERROR; counter++)
+        {
+            numStaged++;
+        }
+
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_NO_MEMORY);
+        NL_TEST_ASSERT(inSuite, numStaged > 1 && numStaged < 64);
+
+        logger.MergeStagedEvents();
+
+        NL_TEST_ASSERT(inSuite, logger.GetLastEventID(Production) + 1 == firstId + numStaged);
+        NL_TEST_ASSERT(inSuite, ReadCounterEvents(firstId, counters, 64) == numStaged);
+        for (counter = 0; counter < numStaged; counter++)
+        {
+            NL_TEST_ASSERT(inSuite, counters[counter] == counter);
+        }
+
+        // Leave the ring part full, so that the next pass starts in the middle of it.
+        counter = 0;
+        err = StageEvent(2, schema, WriteCounterEventData, &counter, NULL);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        logger.MergeStagedEvents();
+    }
+
+    DestroyEventLogging(context);
+}
+
+struct StagedLoggingThreadContext
+{
+    size_t mRing;
+    bool mStaged;
+    uint32_t mNumEvents;
+};
+
+static void *StagedLoggingThread(void *inContext)
+{
+    StagedLoggingThreadContext *context = static_cast<StagedLoggingThreadContext *>(inContext);
+    EventSchema schema = { OpenCloseProfileID, 1, Production, 1, 1 };
+
+    for (uint32_t counter = 0; counter < context->mNumEvents; counter++)
+    {
+        if (!context->mStaged)
+        {
+            LogEvent(schema, WriteCounterEventData, &counter);
+        }
+        else
+        {
+            while (StageEvent(context->mRing, schema, WriteCounterEventData, &counter, NULL) == WEAVE_ERROR_NO_MEMORY)
+            {
+                sched_yield();
+            }
+        }
+    }
+
+    return NULL;
+}
+
+// Measure the rate at which several threads get events into the log, logging them directly and staging them for a
+// merging thread.
+static void BenchmarkStagedLogging(TestLoggingContext *context)
+{
+    const uint32_t kNumEventsPerThread = 100000;
+    LoggingManagement &logger = LoggingManagement::GetInstance();
+
+    for (int staged = 1; staged >= 0; staged--)
+    {
+        pthread_t threads[WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS];
+        StagedLoggingThreadContext threadContexts[WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS];
+        uint64_t startTime, elapsedTime;
+        event_id_t firstId, expectedId;
+
+        InitializeEventLogging(context);
+        FastLogFreeform(Production, 10, "Direct entry");
+
+        firstId    = logger.GetLastEventID(Production);
+        expectedId = firstId + kNumEventsPerThread * WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS;
+
+        startTime = System::Layer::GetClock_MonotonicHiRes();
+
+        for (size_t i = 0; i < WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS; i++)
+        {
+            threadContexts[i].mRing      = i;
+            threadContexts[i].mStaged    = staged;
+            threadContexts[i].mNumEvents = kNumEventsPerThread;
+            pthread_create(&threads[i], NULL, StagedLoggingThread, &threadContexts[i]);
+        }
+
+        // Stand in for the Weave thread, letting the logging threads run between merges.
+        while (staged && logger.GetLastEventID(Production) != expectedId)
+        {
+            logger.MergeStagedEvents();
+            sched_yield();
+        }
+
+        for (size_t i = 0; i < WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS; i++)
+        {
+            pthread_join(threads[i], NULL);
+        }
+
+        elapsedTime = System::Layer::GetClock_MonotonicHiRes() - startTime;
+
+        printf("Event logging %u threads %-8s %12.0f events/s\n", static_cast<unsigned>(WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS),
+               staged ? "staged" : "direct", (double) (logger.GetLastEventID(Production) - firstId) * 1000000.0 / (double) elapsedTime);
+
+        DestroyEventLogging(context);
+    }
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+static size_t sMappedFileBufferSizes[] = { sizeof(gDebugEventBuffer), sizeof(gInfoEventBuffer), sizeof(gProdEventBuffer), sizeof(gCritEventBuffer) };
+
+static WEAVE_ERROR InitializeMappedFileEventLogging(TestLoggingContext *context, MappedFileEventLog &ioFile, const char *inPath)
+{
+    WEAVE_ERROR err;
+
+    err = ioFile.Init(inPath, sizeof(sMappedFileBufferSizes)/sizeof(sMappedFileBufferSizes[0]), sMappedFileBufferSizes);
+    SuccessOrExit(err);
+
+    LoggingManagement::CreateLoggingManagement(context->mExchangeMgr, ioFile.GetNumBuffers(), sMappedFileBufferSizes, ioFile.GetBuffers(), NULL, NULL, NULL);
+    LoggingConfiguration::GetInstance().mGlobalImportance = nl::Weave::Profiles::DataManagement::Debug;
+
+    err = LoggingManagement::GetInstance().AttachMappedFile(ioFile);
+
+exit:
+    return err;
+}
+
+static void DestroyMappedFileEventLogging(MappedFileEventLog &ioFile)
+{
+    LoggingManagement::GetInstance().DestroyLoggingManagement();
+    ioFile.Shutdown();
+}
+
+static void CheckMappedFileEventLog(nlTestSuite *inSuite, void *inContext)
+{
+    TestLoggingContext *context = static_cast<TestLoggingContext *>(inContext);
+    LoggingManagement &logger = LoggingManagement::GetInstance();
+    EventSchema schema = { OpenCloseProfileID, 1, Production, 1, 1 };
+    char path[] = "/tmp/weave-event-log-XXXXXX";
+    int fd;
+    MappedFileEventLog file;
+    event_id_t firstId, lastId;
+    uint32_t counters[64];
+    uint32_t counter;
+    size_t otherSizes[] = { sizeof(gDebugEventBuffer), sizeof(gInfoEventBuffer), sizeof(gProdEventBuffer), sizeof(gCritEventBuffer) / 2 };
+    WEAVE_ERROR err;
+
+    fd = mkstemp(path);
+    NL_TEST_ASSERT(inSuite, fd >= 0);
+    close(fd);
+
+    err = InitializeMappedFileEventLogging(context, file, path);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    FastLogFreeform(Production, 10, "Direct entry");
+    firstId = logger.GetLastEventID(Production) + 1;
+    for (counter = 0; counter < 3; counter++)
+    {
+        LogEvent(schema, WriteCounterEventData, &counter);
+    }
+    lastId = logger.GetLastEventID(Production);
+    NL_TEST_ASSERT(inSuite, lastId == firstId + 2);
+
+    // The events, and their IDs, survive a restart.
+    DestroyMappedFileEventLogging(file);
+
+    err = InitializeMappedFileEventLogging(context, file, path);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    NL_TEST_ASSERT(inSuite, logger.GetLastEventID(Production) == lastId);
+    NL_TEST_ASSERT(inSuite, ReadCounterEvents(firstId, counters, 64) == 3);
+    NL_TEST_ASSERT(inSuite, counters[0] == 0 && counters[1] == 1 && counters[2] == 2);
+
+    counter = 3;
+    NL_TEST_ASSERT(inSuite, LogEvent(schema, WriteCounterEventData, &counter) == lastId + 1);
+    lastId++;
+    NL_TEST_ASSERT(inSuite, ReadCounterEvents(firstId, counters, 64) == 4);
+    NL_TEST_ASSERT(inSuite, counters[3] == 3);
+
+    DestroyMappedFileEventLogging(file);
+
+    // A file laid out for other buffers is rejected.
+    err = file.Init(path, sizeof(otherSizes)/sizeof(otherSizes[0]), otherSizes);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+
+    // Corrupt events are discarded, without reusing their IDs; events are logged into the first buffer.
+    err = file.Init(path, sizeof(sMappedFileBufferSizes)/sizeof(sMappedFileBufferSizes[0]), sMappedFileBufferSizes);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    memset(static_cast<uint8_t *>(file.GetBuffers()[0]) + sizeof(CircularEventBuffer), 0xFF, sizeof(gDebugEventBuffer) - sizeof(CircularEventBuffer));
+    file.Shutdown();
+
+    err = InitializeMappedFileEventLogging(context, file, path);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    NL_TEST_ASSERT(inSuite, logger.GetLastEventID(Production) == lastId);
+    NL_TEST_ASSERT(inSuite, ReadCounterEvents(firstId, counters, 64) == 0);
+    counter = 4;
+    NL_TEST_ASSERT(inSuite, LogEvent(schema, WriteCounterEventData, &counter) == lastId + 1);
+
+    DestroyMappedFileEventLogging(file);
+    unlink(path);
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+// Fetch the events of every importance, in the order LogBDXUpload uploads them.
+static size_t FetchAllEvents(uint8_t *outBuf, size_t inBufSize)
+{
+    TLVWriter writer;
+
+    writer.Init(outBuf, inBufSize);
+    for (int importance = kImportanceType_First; importance <= kImportanceType_Last; importance++)
+    {
+        event_id_t eventId = 0;
+
+        LoggingManagement::GetInstance().FetchEventsSince(writer, static_cast<ImportanceType>(importance), eventId);
+    }
+
+    return writer.GetLengthWritten();
+}
+
+static size_t CountTopLevelElements(const uint8_t *inData, size_t inLength)
+{
+    TLVReader reader;
+    size_t count = 0;
+
+    reader.Init(inData, inLength);
+    while (reader.Next() == WEAVE_NO_ERROR)
+    {
+        count++;
+    }
+
+    return count;
+}
+
+// Compress inData in chunks of inChunkSize, decompress it and check that it survives the round trip.
+static size_t CheckCompressionRoundTrip(nlTestSuite *inSuite, const uint8_t *inData, size_t inLength, size_t inChunkSize)
+{
+    static EventStreamCompressor sCompressor;
+    static EventStreamDecompressor sDecompressor;
+    uint8_t compressed[1100];
+    uint8_t decompressed[1024];
+    size_t totalCompressed = 0;
+    size_t compressedLength, decompressedLength;
+    WEAVE_ERROR err;
+
+    sCompressor.Reset();
+    sDecompressor.Reset();
+
+    for (size_t offset = 0; offset < inLength; offset += inChunkSize)
+    {
+        const size_t chunkLength = (inLength - offset < inChunkSize) ? inLength - offset : inChunkSize;
+
+        err = sCompressor.Compress(inData + offset, chunkLength, compressed, sizeof(compressed), compressedLength);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        NL_TEST_ASSERT(inSuite, compressedLength <= EventStreamCompressor::GetMaxCompressedLength(chunkLength));
+
+        err = sDecompressor.Decompress(compressed, compressedLength, decompressed, sizeof(decompressed), decompressedLength);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        NL_TEST_ASSERT(inSuite, decompressedLength == chunkLength && memcmp(decompressed, inData + offset, chunkLength) == 0);
+
+        totalCompressed += compressedLength;
+    }
+
+    return totalCompressed;
+}
+
+static void CheckEventStreamCompression(nlTestSuite *inSuite, void *inContext)
+{
+    TestLoggingContext *context = static_cast<TestLoggingContext *>(inContext);
+    static uint8_t sData[8192];
+    EventStreamDecompressor decompressor;
+    const uint8_t badOffset[] = { 0x80 | 0x03, 0xFF };
+    uint8_t decompressed[64];
+    size_t length, logLength;
+
+    // Encoded events compress well, whatever the chunk size.
+    InitializeEventLogging(context);
+    for (int i = 0; i < 200; i++)
+    {
+        FastLogFreeform(static_cast<ImportanceType>(kImportanceType_First + (i % 4)), 1000 + 10 * i, "Freeform entry %d", i);
+    }
+    logLength = FetchAllEvents(sData, sizeof(sData));
+    DestroyEventLogging(context);
+
+    NL_TEST_ASSERT(inSuite, logLength > 4096);
+    NL_TEST_ASSERT(inSuite, CheckCompressionRoundTrip(inSuite, sData, logLength, 1024) * 3 < logLength);
+    NL_TEST_ASSERT(inSuite, CheckCompressionRoundTrip(inSuite, sData, logLength, 97) * 2 < logLength);
+
+    // Random data stays within the bound, and runs use long matches.
+    for (size_t i = 0; i < sizeof(sData); i++)
+    {
+        sData[i] = static_cast<uint8_t>(rand());
+    }
+    CheckCompressionRoundTrip(inSuite, sData, sizeof(sData), 1024);
+    memset(sData, 0x42, sizeof(sData));
+    NL_TEST_ASSERT(inSuite, CheckCompressionRoundTrip(inSuite, sData, sizeof(sData), 1024) < 128);
+
+    NL_TEST_ASSERT(inSuite, EventStreamCompressor::GetMaxDataLength(1024) == 1016);
+    NL_TEST_ASSERT(inSuite, EventStreamCompressor::GetMaxCompressedLength(1016) == 1024);
+
+    // Matches cannot reach back before the start of the stream.
+    decompressor.Reset();
+    NL_TEST_ASSERT(inSuite, decompressor.Decompress(badOffset, sizeof(badOffset), decompressed, sizeof(decompressed), length) ==
+                   WEAVE_ERROR_INVALID_ARGUMENT);
+}
+
+static void CheckCompressedLogUpload(nlTestSuite *inSuite, void *inContext)
+{
+    TestLoggingContext *context = static_cast<TestLoggingContext *>(inContext);
+    static uint8_t sExpected[8192];
+    static uint8_t sUploaded[8192];
+    EventStreamDecompressor decompressor;
+    nl::Weave::Profiles::BulkDataTransfer::BDXTransfer xfer;
+    nl::Weave::Profiles::BulkDataTransfer::SendAccept accept;
+    ReferencedTLVData metaData;
+    uint8_t metaDataBuf[16];
+    uint8_t block[1024];
+    uint8_t *blockPtr = block;
+    uint64_t blockLength;
+    size_t expectedLength, uploadedLength = 0, compressedLength = 0, length;
+    size_t numBlocks = 0;
+    bool isLastBlock = false;
+    TLVWriter writer;
+    TLVType container;
+    WEAVE_ERROR err;
+
+    InitializeEventLogging(context);
+    for (int i = 0; i < 200; i++)
+    {
+        FastLogFreeform(static_cast<ImportanceType>(kImportanceType_First + (i % 4)), 1000 + 10 * i, "Freeform entry %d", i);
+    }
+
+    expectedLength = FetchAllEvents(sExpected, sizeof(sExpected));
+
+    // The receiver picks the compressed encoding in its SendAccept.
+    writer.Init(metaDataBuf, sizeof(metaDataBuf));
+    writer.StartContainer(AnonymousTag, kTLVType_Structure, container);
+    writer.Put(ContextTag(kTag_UploadEncoding), static_cast<uint8_t>(kUploadEncoding_EventStreamV1));
+    writer.EndContainer(container);
+    writer.Finalize();
+    metaData.init(writer.GetLengthWritten(), sizeof(metaDataBuf), metaDataBuf);
+    accept.init(1, nl::Weave::Profiles::BulkDataTransfer::kMode_SenderDrive, sizeof(block), &metaData);
+
+    xfer.mAppState     = &gLogBDXUpload;
+    xfer.mTransferMode = nl::Weave::Profiles::BulkDataTransfer::kMode_SenderDrive;
+    err = BdxSendAcceptHandler(&xfer, &accept);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    decompressor.Reset();
+    while (!isLastBlock && numBlocks < 64)
+    {
+        blockLength = sizeof(block);
+        gLogBDXUpload.BlockHandler(&xfer, &blockLength, &blockPtr, &isLastBlock);
+        NL_TEST_ASSERT(inSuite, blockLength > 0 && blockLength <= sizeof(block));
+
+        err = decompressor.Decompress(block, blockLength, sUploaded + uploadedLength, sizeof(sUploaded) - uploadedLength, length);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+        uploadedLength += length;
+        compressedLength += blockLength;
+        numBlocks++;
+    }
+
+    NL_TEST_ASSERT(inSuite, isLastBlock);
+    // Each block restarts the delta encoding of the events, so compare the events rather than the bytes.
+    NL_TEST_ASSERT(inSuite, uploadedLength >= expectedLength);
+    NL_TEST_ASSERT(inSuite, CountTopLevelElements(sExpected, expectedLength) > 0);
+    NL_TEST_ASSERT(inSuite, CountTopLevelElements(sUploaded, uploadedLength) == CountTopLevelElements(sExpected, expectedLength));
+
+    // Blocks are filled with compressed events, not just with what would fit uncompressed.
+    NL_TEST_ASSERT(inSuite, compressedLength * 3 < expectedLength);
+    NL_TEST_ASSERT(inSuite, numBlocks <= compressedLength / sizeof(block) + 1);
+
+    gLogBDXUpload.Abort();
+    DestroyEventLogging(context);
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+
+
+// Measure the rate at which events are logged once the debug buffer is full, so that every event evicts older ones:
+// debug events alone only drop them, while a mix of importances also moves them up through the buffers.
+static void BenchmarkSaturatedLogging(TestLoggingContext *context)
+{
+    const ImportanceType kMixes[][4] = {
+        { nl::Weave::Profiles::DataManagement::Debug, nl::Weave::Profiles::DataManagement::Debug, nl::Weave::Profiles::DataManagement::Debug,
+          nl::Weave::Profiles::DataManagement::Debug },
+        { nl::Weave::Profiles::DataManagement::Debug, Info, Production, ProductionCritical },
+    };
+
+    for (size_t mix = 0; mix < sizeof(kMixes) / sizeof(kMixes[0]); mix++)
+    {
+        uint64_t totalEvents = 0;
+        timestamp_t now = 0;
+
+        InitializeEventLogging(context);
+
+        // Saturate the buffers before starting the clock.
+        for (size_t i = 0; i < 200; i++)
+        {
+            now += 10;
+            FastLogFreeform(kMixes[mix][i % 4], now, "Freeform entry %d", i);
+        }
+
+        BenchmarkTimer timer;
+
+        while (timer.Continue())
+        {
+            for (size_t i = 0; i < 64; i++)
+            {
+                now += 10;
+                FastLogFreeform(kMixes[mix][i % 4], now, "Freeform entry %d", i);
+            }
+
+            totalEvents += 64;
+        }
+
+        printf("Saturated event logging %-16s %12.0f events/s\n", mix == 0 ? "debug" : "mixed importance",
+               (double) totalEvents * 1000000.0 / (double) timer.ElapsedUSec());
+
+        DestroyEventLogging(context);
+    }
+}
 
 //Test Suite
 
@@ -3582,6 +4276,19 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("Check Gap detection", CheckGapDetection),
     NL_TEST_DEF("Check Drop Overlapping Event Id Ranges", CheckDropOverlap),
     NL_TEST_DEF("Check Last Observed Event Id", CheckLastObservedEventId),
+#if WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+    NL_TEST_DEF("Check Event List Cache", CheckEventListCache),
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+    NL_TEST_DEF("Check Staged Events", CheckStagedEvents),
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_ENABLE_MAPPED_FILE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    NL_TEST_DEF("Check Mapped File Event Log", CheckMappedFileEventLog),
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_BDX_COMPRESSION
+    NL_TEST_DEF("Check Event Stream Compression", CheckEventStreamCompression),
+    NL_TEST_DEF("Check Compressed Log Upload", CheckCompressedLogUpload),
+#endif
     NL_TEST_SENTINEL()
 };
 
@@ -3596,6 +4303,26 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
+    if (gBenchmarkOptions.RunBenchmarks)
+    {
+        if (TestSetup(&gTestLoggingContext) != SUCCESS)
+        {
+            return EXIT_FAILURE;
+        }
+
+        nl::Weave::Logging::SetLogFilter(nl::Weave::Logging::kLogCategory_Error);
+
+        BenchmarkSaturatedLogging(&gTestLoggingContext);
+#if WDM_PUBLISHER_EVENT_LIST_CACHE_SIZE > 0
+        BenchmarkEventListFanOut(&gTestLoggingContext);
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_NUM_STAGING_RINGS > 0
+        BenchmarkStagedLogging(&gTestLoggingContext);
+#endif
+
+        return (TestTeardown(&gTestLoggingContext) == SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     nlTestSuite theSuite = {
         "weave-event-log",
         &sTests[0],
@@ -47,6 +47,8 @@ using namespace nl::Weave::Profiles::Security;
 
 #define DEBUG_PRINT_ENABLE 0
 
+#define TOOL_NAME "TestMsgEnc"
+
 namespace nl {
 namespace Weave {
 
@@ -55,11 +57,42 @@ class NL_DLL_EXPORT WeaveMessageLayerTestObject
 public:
     WeaveMessageLayer *msgLayer;
 
+    typedef WeaveMessageLayer::DecodedMessage DecodedMessage;
+
     WEAVE_ERROR DecodeMessage(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
             WeaveMessageInfo *msgInfo, uint8_t **rPayload, uint16_t *rPayloadLen)
     {
         return msgLayer->DecodeMessage(msgBuf, sourceNodeId, con, msgInfo, rPayload, rPayloadLen);
     }
+
+    WEAVE_ERROR EncodeMessageWithLength(WeaveMessageInfo *msgInfo, PacketBuffer *msgBuf, WeaveConnection *con,
+            uint16_t maxLen)
+    {
+        return msgLayer->EncodeMessageWithLength(msgInfo, msgBuf, con, maxLen);
+    }
+
+    WEAVE_ERROR DecodeMessageWithLength(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
+            WeaveMessageInfo *msgInfo, uint8_t **rPayload, uint16_t *rPayloadLen, uint16_t *rFrameLen)
+    {
+        return msgLayer->DecodeMessageWithLength(msgBuf, sourceNodeId, con, msgInfo, rPayload, rPayloadLen, rFrameLen);
+    }
+
+    WEAVE_ERROR DecodeMessagesWithLength(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
+            DecodedMessage msgs[], uint8_t maxMsgs, uint8_t *rNumMsgs, uint16_t *rFrameLen)
+    {
+        return msgLayer->DecodeMessagesWithLength(msgBuf, sourceNodeId, con, msgs, maxMsgs, rNumMsgs, rFrameLen);
+    }
+
+    WEAVE_ERROR FinishDecodeMessage(DecodedMessage &msg, WeaveConnection *con)
+    {
+        return msgLayer->FinishDecodeMessage(msg, con);
+    }
+
+    static void HandleIncomingTcpConnection(TCPEndPoint *listeningEP, TCPEndPoint *conEP, const IPAddress &peerAddr,
+            uint16_t peerPort)
+    {
+        WeaveMessageLayer::HandleIncomingTcpConnection(listeningEP, conEP, peerAddr, peerPort);
+    }
 };
 
 } // namespace nl
@@ -340,10 +373,566 @@ void WeaveMessageEncryption_Test1(nlTestSuite *inSuite, void *inContext)
 }
 
 
+// Number of messages in the length-prefixed stream used by the batch decode test and benchmark.
+#define BATCH_TEST_MSG_COUNT 12
+
+struct BatchTestState
+{
+    WeaveFabricState FabricState;
+    WeaveMessageLayer MessageLayer;
+    WeaveMessageLayerTestObject TestObject;
+    uint64_t SrcNodeId;
+    uint8_t Stream[2048];
+    uint16_t StreamLen;
+    uint16_t FrameLens[BATCH_TEST_MSG_COUNT];
+};
+
+static const uint64_t sBatchTestDestNodeId = 0x18B4300012345678;
+
+// Initialize the fabric and a session key used for both sending and receiving.
+static WEAVE_ERROR InitBatchTestState(BatchTestState &state)
+{
+    WEAVE_ERROR err;
+    WeaveSessionKey *sessionKey;
+    WeaveEncryptionKey msgEncSessionKey;
+    IPAddress localIPv6Addr;
+
+    ParseIPAddress("fd00:0:1:1:18B4:3000::2", localIPv6Addr);
+
+    err = state.FabricState.Init();
+    SuccessOrExit(err);
+
+    state.SrcNodeId = localIPv6Addr.InterfaceId();
+    state.FabricState.LocalNodeId = state.SrcNodeId;
+    state.FabricState.FabricId = localIPv6Addr.GlobalId();
+    state.FabricState.DefaultSubnet = localIPv6Addr.Subnet();
+
+    memcpy(msgEncSessionKey.AES128CTRSHA1.DataKey, sMsgEncKey_DataKey, sizeof(sMsgEncKey_DataKey));
+    memcpy(msgEncSessionKey.AES128CTRSHA1.IntegrityKey, sMsgEncKey_IntegrityKey, sizeof(sMsgEncKey_IntegrityKey));
+
+    // Use the same session key for sending to the destination node and for receiving from the local node.
+    err = state.FabricState.AllocSessionKey(sBatchTestDestNodeId, sTestDefaultSessionKeyId, NULL, sessionKey);
+    SuccessOrExit(err);
+    state.FabricState.SetSessionKey(sessionKey, kWeaveEncryptionType_AES128CTRSHA1, kWeaveAuthMode_CASE_Device, &msgEncSessionKey);
+
+    err = state.FabricState.AllocSessionKey(state.SrcNodeId, sTestDefaultSessionKeyId, NULL, sessionKey);
+    SuccessOrExit(err);
+    state.FabricState.SetSessionKey(sessionKey, kWeaveEncryptionType_AES128CTRSHA1, kWeaveAuthMode_CASE_Device, &msgEncSessionKey);
+
+    state.MessageLayer.FabricState = &state.FabricState;
+    state.TestObject.msgLayer = &state.MessageLayer;
+
+exit:
+    return err;
+}
+
+// Encode a stream of length-prefixed messages. Message 5 is unencrypted and the rest are encrypted
+// with the session key.
+static WEAVE_ERROR EncodeBatchTestStream(BatchTestState &state, uint16_t payloadLen)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    state.StreamLen = 0;
+
+    for (uint16_t i = 0; i < BATCH_TEST_MSG_COUNT; i++)
+    {
+        WeaveMessageInfo msgInfo;
+        PacketBuffer *msgBuf = PacketBuffer::New();
+
+        VerifyOrExit(msgBuf != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        for (uint16_t j = 0; j < payloadLen; j++)
+            msgBuf->Start()[j] = (uint8_t) (i + j);
+        msgBuf->SetDataLength(payloadLen);
+
+        msgInfo.Clear();
+        msgInfo.SourceNodeId = state.SrcNodeId;
+        msgInfo.DestNodeId = sBatchTestDestNodeId;
+        msgInfo.MessageId = 100 + i;
+        msgInfo.Flags = kWeaveMessageFlag_DestNodeId | kWeaveMessageFlag_SourceNodeId | kWeaveMessageFlag_ReuseMessageId;
+        msgInfo.MessageVersion = kWeaveMessageVersion_V2;
+        if (i == 5)
+        {
+            msgInfo.KeyId = WeaveKeyId::kNone;
+            msgInfo.EncryptionType = kWeaveEncryptionType_None;
+        }
+        else
+        {
+            msgInfo.KeyId = sTestDefaultSessionKeyId;
+            msgInfo.EncryptionType = kWeaveEncryptionType_AES128CTRSHA1;
+        }
+
+        err = state.TestObject.EncodeMessageWithLength(&msgInfo, msgBuf, NULL, UINT16_MAX);
+        if (err == WEAVE_NO_ERROR && state.StreamLen + msgBuf->DataLength() > sizeof(state.Stream))
+            err = WEAVE_ERROR_BUFFER_TOO_SMALL;
+        if (err == WEAVE_NO_ERROR)
+        {
+            memcpy(state.Stream + state.StreamLen, msgBuf->Start(), msgBuf->DataLength());
+            state.FrameLens[i] = msgBuf->DataLength();
+            state.StreamLen += msgBuf->DataLength();
+        }
+
+        PacketBuffer::Free(msgBuf);
+        SuccessOrExit(err);
+    }
+
+exit:
+    return err;
+}
+
+static bool CheckBatchPayload(const WeaveMessageLayerTestObject::DecodedMessage &msg, uint16_t msgIndex, uint16_t payloadLen)
+{
+    if (msg.PayloadLen != payloadLen || msg.MsgInfo.MessageId != (uint32_t) (100 + msgIndex))
+        return false;
+
+    for (uint16_t j = 0; j < payloadLen; j++)
+        if (msg.Payload[j] != (uint8_t) (msgIndex + j))
+            return false;
+
+    return true;
+}
+
+void WeaveMessageEncryption_Batch(nlTestSuite *inSuite, void *inContext)
+{
+    static BatchTestState state;
+    WeaveMessageLayerTestObject::DecodedMessage msgs[WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE];
+    const uint16_t payloadLen = 77;
+    PacketBuffer *msgBuf;
+    uint8_t numMsgs;
+    uint16_t frameLen;
+    uint16_t msgIndex;
+    WEAVE_ERROR err;
+
+    err = InitBatchTestState(state);
+    if (err == WEAVE_NO_ERROR)
+        err = EncodeBatchTestStream(state, payloadLen);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    msgBuf = PacketBuffer::New(0);
+    NL_TEST_ASSERT(inSuite, msgBuf != NULL && msgBuf->AvailableDataLength() >= state.StreamLen);
+    if (err != WEAVE_NO_ERROR || msgBuf == NULL)
+        return;
+
+    memcpy(msgBuf->Start(), state.Stream, state.StreamLen);
+    msgBuf->SetDataLength(state.StreamLen);
+
+    // Decode the whole stream in batches, consuming each message as it is dispatched.
+    for (msgIndex = 0; msgIndex < BATCH_TEST_MSG_COUNT; )
+    {
+        uint8_t *batchStart = msgBuf->Start();
+
+        for (uint8_t i = 0; i < WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE; i++)
+            msgs[i].MsgInfo.Clear();
+
+        err = state.TestObject.DecodeMessagesWithLength(msgBuf, state.SrcNodeId, NULL, msgs, WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE,
+                                                        &numMsgs, &frameLen);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        if (err != WEAVE_NO_ERROR)
+            break;
+
+        // The batch holds as many messages as fit, and leaves the buffer unchanged.
+        NL_TEST_ASSERT(inSuite, numMsgs == WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE || msgIndex + numMsgs == BATCH_TEST_MSG_COUNT);
+        NL_TEST_ASSERT(inSuite, msgBuf->Start() == batchStart);
+
+        for (uint8_t i = 0; i < numMsgs; i++, msgIndex++)
+        {
+            NL_TEST_ASSERT(inSuite, msgs[i].FrameLen == state.FrameLens[msgIndex]);
+            NL_TEST_ASSERT(inSuite, CheckBatchPayload(msgs[i], msgIndex, payloadLen));
+
+            err = state.TestObject.FinishDecodeMessage(msgs[i], NULL);
+            NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+            NL_TEST_ASSERT(inSuite, (msgs[i].MsgInfo.Flags & kWeaveMessageFlag_DuplicateMessage) == 0);
+
+            msgBuf->SetStart(msgBuf->Start() + msgs[i].FrameLen);
+        }
+    }
+
+    NL_TEST_ASSERT(inSuite, msgIndex == BATCH_TEST_MSG_COUNT && msgBuf->DataLength() == 0);
+
+    // Corrupt the integrity check of message 2.  A batch starting at message 0 stops before it and
+    // leaves it, and the messages after it, as received.
+    msgBuf->SetStart(msgBuf->Start() - state.StreamLen);
+    memcpy(msgBuf->Start(), state.Stream, state.StreamLen);
+    msgBuf->SetDataLength(state.StreamLen);
+    msgBuf->Start()[state.FrameLens[0] + state.FrameLens[1] + state.FrameLens[2] - 1] ^= 0x01;
+
+    uint8_t tampered[sizeof(state.Stream)];
+    memcpy(tampered, msgBuf->Start(), state.StreamLen);
+
+    err = state.TestObject.DecodeMessagesWithLength(msgBuf, state.SrcNodeId, NULL, msgs, WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE,
+                                                    &numMsgs, &frameLen);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, numMsgs == 2 || WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE < 3);
+
+    if (err == WEAVE_NO_ERROR && numMsgs == 2)
+    {
+        uint16_t restOffset = state.FrameLens[0] + state.FrameLens[1];
+
+        // Messages after the failed one are re-encrypted
+        NL_TEST_ASSERT(inSuite, memcmp(msgBuf->Start() + restOffset, tampered + restOffset, state.StreamLen - restOffset) == 0);
+
+        // Once the first two messages are consumed, the corrupted message is reported.
+        msgBuf->SetStart(msgBuf->Start() + restOffset);
+        msgBuf->SetDataLength(state.StreamLen - restOffset);
+
+        err = state.TestObject.DecodeMessagesWithLength(msgBuf, state.SrcNodeId, NULL, msgs, WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE,
+                                                        &numMsgs, &frameLen);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INTEGRITY_CHECK_FAILED);
+        NL_TEST_ASSERT(inSuite, numMsgs == 0 && frameLen == state.FrameLens[2]);
+    }
+
+    PacketBuffer::Free(msgBuf);
+
+    // A batch that ends in a partial message decodes the complete messages before it.
+
+    msgBuf = PacketBuffer::New(0);
+    NL_TEST_ASSERT(inSuite, msgBuf != NULL);
+    if (msgBuf == NULL)
+        return;
+
+    memcpy(msgBuf->Start(), state.Stream, state.FrameLens[0] + 10);
+    msgBuf->SetDataLength(state.FrameLens[0] + 10);
+
+    err = state.TestObject.DecodeMessagesWithLength(msgBuf, state.SrcNodeId, NULL, msgs, WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE,
+                                                    &numMsgs, &frameLen);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && numMsgs == 1);
+
+    msgBuf->SetStart(msgBuf->Start() + state.FrameLens[0]);
+    msgBuf->SetDataLength(10);
+
+    err = state.TestObject.DecodeMessagesWithLength(msgBuf, state.SrcNodeId, NULL, msgs, WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE,
+                                                    &numMsgs, &frameLen);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_MESSAGE_INCOMPLETE && frameLen == state.FrameLens[1]);
+
+    PacketBuffer::Free(msgBuf);
+}
+
+#if WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+struct ConnectionBatchTestState
+{
+    BatchTestState Batch;
+    WeaveConnection *ServerCon;
+    bool ClientConnected;
+    bool ServerConClosed;
+    uint16_t NumReceived;
+    uint16_t NumCorrupt;
+    uint16_t PayloadLen;
+    uint8_t DataKey[WeaveEncryptionKey_AES128CTRSHA1::DataKeySize];
+};
+
+static ConnectionBatchTestState sConBatchState;
+
+static const uint16_t kBatchTestFirstPort = 41095;
+
+static WeaveSessionKey *FindBatchTestSessionKey(void)
+{
+    WeaveSessionKey *sessionKey = NULL;
+
+    sConBatchState.Batch.FabricState.FindSessionKey(sTestDefaultSessionKeyId, sConBatchState.Batch.SrcNodeId, false, sessionKey);
+
+    return sessionKey;
+}
+
+static void HandleBatchTestMessageReceived(WeaveConnection *con, WeaveMessageInfo *msgInfo, PacketBuffer *payload)
+{
+    uint16_t msgIndex = sConBatchState.NumReceived++;
+    bool valid = (msgInfo->MessageId == (uint32_t) (100 + msgIndex) && payload->DataLength() == sConBatchState.PayloadLen);
+
+    for (uint16_t j = 0; valid && j < sConBatchState.PayloadLen; j++)
+        valid = (payload->Start()[j] == (uint8_t) (msgIndex + j));
+
+    if (!valid)
+        sConBatchState.NumCorrupt++;
+
+    PacketBuffer::Free(payload);
+
+    // Replace the session key while the rest of the batch is still waiting to be dispatched, and stop
+    // receiving, so that the undispatched messages are put back for later.
+    if (msgIndex == 0)
+    {
+        WeaveSessionKey *sessionKey = FindBatchTestSessionKey();
+
+        if (sessionKey != NULL)
+            sessionKey->MsgEncKey.EncKey.AES128CTRSHA1.DataKey[0] ^= 0xFF;
+
+        con->DisableReceive();
+    }
+}
+
+static void HandleBatchTestConnectionClosed(WeaveConnection *con, WEAVE_ERROR conErr)
+{
+    sConBatchState.ServerConClosed = true;
+}
+
+static void HandleBatchTestConnectionReceived(WeaveMessageLayer *msgLayer, WeaveConnection *con)
+{
+    sConBatchState.ServerCon = con;
+    con->OnMessageReceived = HandleBatchTestMessageReceived;
+    con->OnConnectionClosed = HandleBatchTestConnectionClosed;
+}
+
+static void HandleBatchTestClientConnectComplete(TCPEndPoint *endPoint, INET_ERROR err)
+{
+    sConBatchState.ClientConnected = (err == INET_NO_ERROR);
+}
+
+static bool IsBatchTestConnected(void)
+{
+    return sConBatchState.ClientConnected && sConBatchState.ServerCon != NULL;
+}
+
+static bool IsBatchTestFirstReceived(void)
+{
+    return sConBatchState.NumReceived > 0 || sConBatchState.ServerConClosed;
+}
+
+static bool IsBatchTestAllReceived(void)
+{
+    return sConBatchState.NumReceived == BATCH_TEST_MSG_COUNT || sConBatchState.ServerConClosed;
+}
+
+// Service network events until the given condition holds, or a few seconds have passed.
+static void ServiceBatchTestEvents(bool (*isDone)(void))
+{
+    uint64_t deadline = System::Layer::GetClock_MonotonicMS() + 5000;
+
+    while (!isDone() && System::Layer::GetClock_MonotonicMS() < deadline)
+    {
+        struct timeval sleepTime = { 0, 10000 };
+        ServiceEvents(sleepTime);
+    }
+}
+
+// Send part of the encoded batch test stream over a TCP end point.
+static INET_ERROR SendBatchTestStream(TCPEndPoint *endPoint, uint16_t offset, uint16_t len)
+{
+    PacketBuffer *buf = PacketBuffer::New(0);
+
+    if (buf == NULL)
+        return INET_ERROR_NO_MEMORY;
+
+    memcpy(buf->Start(), sConBatchState.Batch.Stream + offset, len);
+    buf->SetDataLength(len);
+
+    return endPoint->Send(buf);
+}
+
+// Receive a stream of messages over a WeaveConnection, where the first message replaces the session
+// key before the rest of its batch is dispatched.  The undispatched messages must be restored with the
+// key they were decrypted with, so that they decode correctly once the original key is back.
+void WeaveConnection_Batch(nlTestSuite *inSuite, void *inContext)
+{
+    ConnectionBatchTestState &state = sConBatchState;
+    WeaveMessageLayer::InitContext initContext;
+    TCPEndPoint *listenEP = NULL;
+    TCPEndPoint *clientEP = NULL;
+    IPAddress loopbackAddr;
+    uint16_t listenPort;
+    uint16_t lastFrameOffset;
+    WeaveSessionKey *sessionKey;
+    WEAVE_ERROR err;
+
+    state.PayloadLen = 61;
+
+    err = InitBatchTestState(state.Batch);
+    if (err == WEAVE_NO_ERROR)
+        err = EncodeBatchTestStream(state.Batch, state.PayloadLen);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    SuccessOrExit(err);
+
+    // The test stream is addressed to the batch test destination node.
+    state.Batch.FabricState.LocalNodeId = sBatchTestDestNodeId;
+
+    sessionKey = FindBatchTestSessionKey();
+    NL_TEST_ASSERT(inSuite, sessionKey != NULL);
+    VerifyOrExit(sessionKey != NULL, err = WEAVE_ERROR_KEY_NOT_FOUND);
+    memcpy(state.DataKey, sessionKey->MsgEncKey.EncKey.AES128CTRSHA1.DataKey, sizeof(state.DataKey));
+
+    InitSystemLayer();
+    InitNetwork();
+
+    initContext.systemLayer = &SystemLayer;
+    initContext.inet = &Inet;
+    initContext.fabricState = &state.Batch.FabricState;
+    initContext.listenTCP = false;
+    initContext.listenUDP = false;
+
+    err = state.Batch.MessageLayer.Init(&initContext);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    SuccessOrExit(err);
+
+    state.Batch.MessageLayer.OnConnectionReceived = HandleBatchTestConnectionReceived;
+
+    // Accept connections on a loopback port on behalf of the message layer.  The end point can't report
+    // an ephemeral port before it is connected, so try a few fixed ports instead.
+    ParseIPAddress("::1", loopbackAddr);
+
+    err = Inet.NewTCPEndPoint(&listenEP);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    SuccessOrExit(err);
+
+    for (listenPort = kBatchTestFirstPort; listenPort < kBatchTestFirstPort + 16; listenPort++)
+    {
+        err = listenEP->Bind(kIPAddressType_IPv6, loopbackAddr, listenPort, true);
+        if (err == WEAVE_NO_ERROR)
+            break;
+    }
+    if (err == WEAVE_NO_ERROR)
+        err = listenEP->Listen(1);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    SuccessOrExit(err);
+
+    listenEP->AppState = &state.Batch.MessageLayer;
+    listenEP->OnConnectionReceived = WeaveMessageLayerTestObject::HandleIncomingTcpConnection;
+
+    err = Inet.NewTCPEndPoint(&clientEP);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    SuccessOrExit(err);
+
+    clientEP->OnConnectComplete = HandleBatchTestClientConnectComplete;
+
+    err = clientEP->Connect(loopbackAddr, listenPort);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    SuccessOrExit(err);
+
+    ServiceBatchTestEvents(IsBatchTestConnected);
+    NL_TEST_ASSERT(inSuite, IsBatchTestConnected());
+    VerifyOrExit(IsBatchTestConnected(), err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // Send all but the last message in one write, so that they are received, and decoded, together.
+    lastFrameOffset = state.Batch.StreamLen - state.Batch.FrameLens[BATCH_TEST_MSG_COUNT - 1];
+
+    err = SendBatchTestStream(clientEP, 0, lastFrameOffset);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    SuccessOrExit(err);
+
+    ServiceBatchTestEvents(IsBatchTestFirstReceived);
+    NL_TEST_ASSERT(inSuite, state.NumReceived == 1);
+
+    // Put the original key back, then send the last message to have the put back data processed again.
+    memcpy(sessionKey->MsgEncKey.EncKey.AES128CTRSHA1.DataKey, state.DataKey, sizeof(state.DataKey));
+    state.ServerCon->EnableReceive();
+
+    err = SendBatchTestStream(clientEP, lastFrameOffset, state.Batch.StreamLen - lastFrameOffset);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    SuccessOrExit(err);
+
+    ServiceBatchTestEvents(IsBatchTestAllReceived);
+    NL_TEST_ASSERT(inSuite, state.NumReceived == BATCH_TEST_MSG_COUNT);
+    NL_TEST_ASSERT(inSuite, state.NumCorrupt == 0);
+    NL_TEST_ASSERT(inSuite, !state.ServerConClosed);
+
+exit:
+    if (state.ServerCon != NULL && !state.ServerConClosed)
+        state.ServerCon->Abort();
+    if (clientEP != NULL)
+        clientEP->Free();
+    if (listenEP != NULL)
+        listenEP->Free();
+    state.Batch.MessageLayer.Shutdown();
+    ShutdownNetwork();
+    ShutdownSystemLayer();
+}
+
+#endif // WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+// Measure the receive-side decode rate of a stream of encrypted, length-prefixed messages, decoding
+// them one at a time and in batches.
+static void BenchmarkMessageDecode(BatchTestState &state, uint16_t payloadLen)
+{
+    WeaveMessageLayerTestObject::DecodedMessage msgs[WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE];
+    PacketBuffer *msgBuf;
+    uint64_t totalMsgs;
+
+    if (EncodeBatchTestStream(state, payloadLen) != WEAVE_NO_ERROR)
+        return;
+
+    msgBuf = PacketBuffer::New(0);
+    if (msgBuf == NULL)
+        return;
+
+    for (int useBatch = 0; useBatch <= 1; useBatch++)
+    {
+        BenchmarkTimer timer;
+
+        totalMsgs = 0;
+
+        while (timer.Continue())
+        {
+            uint8_t *streamStart = msgBuf->Start();
+
+            memcpy(streamStart, state.Stream, state.StreamLen);
+            msgBuf->SetDataLength(state.StreamLen);
+
+            while (msgBuf->DataLength() > 0)
+            {
+                uint8_t numMsgs = 0;
+                uint16_t frameLen;
+
+                if (useBatch)
+                {
+                    for (uint8_t i = 0; i < WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE; i++)
+                        msgs[i].MsgInfo.Clear();
+
+                    if (state.TestObject.DecodeMessagesWithLength(msgBuf, state.SrcNodeId, NULL, msgs,
+                                                                  WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE, &numMsgs, &frameLen) != WEAVE_NO_ERROR)
+                        break;
+
+                    for (uint8_t i = 0; i < numMsgs; i++)
+                    {
+                        state.TestObject.FinishDecodeMessage(msgs[i], NULL);
+                        msgBuf->SetStart(msgBuf->Start() + msgs[i].FrameLen);
+                    }
+                }
+                else
+                {
+                    WeaveMessageInfo msgInfo;
+                    uint8_t *payload;
+                    uint16_t decodedPayloadLen;
+
+                    msgInfo.Clear();
+                    if (state.TestObject.DecodeMessageWithLength(msgBuf, state.SrcNodeId, NULL, &msgInfo, &payload,
+                                                                 &decodedPayloadLen, &frameLen) != WEAVE_NO_ERROR)
+                        break;
+                    numMsgs = 1;
+                }
+
+                totalMsgs += numMsgs;
+            }
+
+            msgBuf->SetStart(streamStart);
+        }
+
+        printf("%-10s %5u byte payloads: %10.0f msgs/s\n", useBatch ? "batched" : "sequential", (unsigned) payloadLen,
+               (double) totalMsgs * 1000000.0 / (double) timer.ElapsedUSec());
+    }
+
+    PacketBuffer::Free(msgBuf);
+}
+
+static HelpOptions gHelpOptions(
+    TOOL_NAME,
+    "Usage: " TOOL_NAME " [<options...>]\n",
+    WEAVE_VERSION_STRING "\n" WEAVE_TOOL_COPYRIGHT,
+    "Unit tests for Weave message encryption.\n"
+);
+
+static OptionSet *gToolOptionSets[] =
+{
+    &gBenchmarkOptions,
+    &gHelpOptions,
+    NULL
+};
+
 int main(int argc, char *argv[])
 {
     static const nlTest tests[] = {
         NL_TEST_DEF("WeaveMessageEncryption",           WeaveMessageEncryption_Test1),
+        NL_TEST_DEF("WeaveMessageEncryption Batch",     WeaveMessageEncryption_Batch),
+#if WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+        NL_TEST_DEF("WeaveConnection Batch",            WeaveConnection_Batch),
+#endif
         NL_TEST_SENTINEL()
     };
 
@@ -356,6 +945,25 @@ int main(int argc, char *argv[])
     tcpip_init(NULL, NULL);
 #endif // WEAVE_SYSTEM_CONFIG_USE_LWIP
 
+    if (!ParseArgs(TOOL_NAME, argc, argv, gToolOptionSets))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    if (gBenchmarkOptions.RunBenchmarks)
+    {
+        static BatchTestState state;
+
+        if (InitBatchTestState(state) != WEAVE_NO_ERROR)
+            return EXIT_FAILURE;
+
+        printf("Message decode rate (%u messages per batch)\n", (unsigned) WEAVE_CONFIG_MSG_DECODE_BATCH_SIZE);
+        BenchmarkMessageDecode(state, 16);
+        BenchmarkMessageDecode(state, 32);
+        BenchmarkMessageDecode(state, 64);
+        return EXIT_SUCCESS;
+    }
+
     nl_test_set_output_style(OUTPUT_CSV);
 
     nlTestRunner(&testSuite, &sContext);
@@ -0,0 +1,39 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file runs the Weave SHA tests against the native SHA1 and SHA256
+ *      implementation, which is built into this test independently of the
+ *      hash implementation the Weave library is configured with. The SHA
+ *      tests select each backend the CPU supports in turn.
+ *
+ */
+
+#include <WeaveCryptoTests.h>
+
+// The program is built with WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE, so the SHA1 and SHA256 classes come from here rather
+// than from the Weave library, which only supplies the crypto support functions. The OpenSSL source contributes the BIGNUM
+// hashing the SHA tests use.
+#include "../lib/support/crypto/HashAlgos-Native.cpp"
+#include "../lib/support/crypto/HashAlgos-OpenSSL.cpp"
+
+int main(void)
+{
+    return WeaveCryptoSHATests();
+}
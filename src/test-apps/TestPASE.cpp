@@ -40,6 +40,8 @@ using namespace nl::Weave::Profiles::Security;
 using namespace nl::Weave::Profiles::Security::PASE;
 using System::PacketBuffer;
 
+#define TOOL_NAME "TestPASE"
+
 void PASEEngineTests_BasicTests()
 {
     //Fails
@@ -161,6 +163,43 @@ void PASEEngine_ExternalFuzzingEngine(const char *fuzzLocation, const uint8_t *f
 
 }
 
+// Measure the rate of complete PASE handshakes, including key confirmation, for a given config.
+void PASEEngine_BenchmarkHandshake(const char *name, uint32_t config)
+{
+    BenchmarkTimer timer;
+    uint64_t handshakeCount = 0;
+
+    while (timer.Continue())
+    {
+        PASEEngineTest(name)
+                .InitiatorPassword("TestPassword")
+                .ResponderPassword("TestPassword")
+                .ProposedConfig(config)
+                .ResponderAllowedConfigs(config)
+                .ConfirmKey(true)
+                .LogMessageData(false)
+                .Run();
+
+        handshakeCount++;
+    }
+
+    printf("%-10s %10.1f handshakes/s\n", name, (double) handshakeCount * 1000000.0 / (double) timer.ElapsedUSec());
+}
+
+static HelpOptions gHelpOptions(
+    TOOL_NAME,
+    "Usage: " TOOL_NAME " [<options...>]\n",
+    WEAVE_VERSION_STRING "\n" WEAVE_TOOL_COPYRIGHT,
+    "Unit tests for the Weave PASE engine.\n"
+);
+
+static OptionSet *gToolOptionSets[] =
+{
+    &gBenchmarkOptions,
+    &gHelpOptions,
+    NULL
+};
+
 int main(int argc, char *argv[])
 {
     WEAVE_ERROR err;
@@ -171,6 +210,23 @@ int main(int argc, char *argv[])
     err = nl::Weave::Platform::Security::InitSecureRandomDataSource(NULL, 64, NULL, 0);
     FAIL_ERROR(err, "InitSecureRandomDataSource() failed");
 
+    if (!ParseArgs(TOOL_NAME, argc, argv, gToolOptionSets))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    if (gBenchmarkOptions.RunBenchmarks)
+    {
+        printf("PASE handshake rate\n");
+#if WEAVE_CONFIG_SUPPORT_PASE_CONFIG1
+        PASEEngine_BenchmarkHandshake("Config 1", kPASEConfig_Config1);
+#endif
+#if WEAVE_CONFIG_SUPPORT_PASE_CONFIG4
+        PASEEngine_BenchmarkHandshake("Config 4", kPASEConfig_Config4);
+#endif
+        return EXIT_SUCCESS;
+    }
+
     printf("Starting tests\n");
     PASEEngine_ConfigTest1();
     PASEEngine_ConfigTest4();
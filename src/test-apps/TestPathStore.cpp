@@ -48,6 +48,7 @@ using namespace nl::Weave::TLV;
 using namespace nl::Weave::Profiles::DataManagement;
 using namespace Schema::Nest::Test::Trait;
 
+#define TOOL_NAME "TestPathStore"
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
@@ -102,6 +103,14 @@ class TraitPathStoreTest {
         void TestFlags(nlTestSuite *inSuite, void *inContext);
         void TestInsertItem(nlTestSuite *inSuite, void *inContext);
         void TestSetFailedTrait(nlTestSuite *inSuite, void *inContext);
+        void TestIndex(nlTestSuite *inSuite, void *inContext);
+        void TestIndexOverflow(nlTestSuite *inSuite, void *inContext);
+        void BenchmarkAddItemDedup(void);
+
+    private:
+        void AddProbes(TraitPath *aProbes, size_t &aNumProbes);
+        void CompareStores(nlTestSuite *inSuite, TraitPathStore &aStore, TraitPathStore &aIndexedStore,
+                           const TraitPath *aProbes, size_t aNumProbes);
 };
 
 TraitPathStoreTest::TraitPathStoreTest() :
@@ -644,6 +653,225 @@ void TraitPathStoreTest::TestSetFailedTrait(nlTestSuite *inSuite, void *inContex
     mStore.Clear();
 }
 
+/**
+ * Fills aProbes with paths at all levels of TestHTrait, for both trait data handles.
+ */
+void TraitPathStoreTest::AddProbes(TraitPath *aProbes, size_t &aNumProbes)
+{
+    const TraitDataHandle handles[] = { mTDH1, mTDH2 };
+
+    aNumProbes = 0;
+
+    for (size_t h = 0; h < ArraySize(handles); h++)
+    {
+        aProbes[aNumProbes++] = TraitPath(handles[h], kRootPropertyPathHandle);
+
+        for (PropertyPathHandle p = TestHTrait::kPropertyHandle_A; p <= TestHTrait::kPropertyHandle_L_Value_Dc; p++)
+        {
+            aProbes[aNumProbes++] = TraitPath(handles[h], CreatePropertyPathHandle(p));
+        }
+
+        for (PropertyDictionaryKey key = 0; key < 3; key++)
+        {
+            aProbes[aNumProbes++] = TraitPath(handles[h], CreatePropertyPathHandle(TestHTrait::kPropertyHandle_K_Sa, key));
+            aProbes[aNumProbes++] = TraitPath(handles[h], CreatePropertyPathHandle(TestHTrait::kPropertyHandle_L_Value, key));
+            aProbes[aNumProbes++] = TraitPath(handles[h], CreatePropertyPathHandle(TestHTrait::kPropertyHandle_L_Value_Da, key));
+            aProbes[aNumProbes++] = TraitPath(handles[h], CreatePropertyPathHandle(TestHTrait::kPropertyHandle_L_Value_Db, key));
+        }
+    }
+}
+
+void TraitPathStoreTest::CompareStores(nlTestSuite *inSuite, TraitPathStore &aStore, TraitPathStore &aIndexedStore,
+                                       const TraitPath *aProbes, size_t aNumProbes)
+{
+    NL_TEST_ASSERT(inSuite, aStore.GetNumItems() == aIndexedStore.GetNumItems());
+    NL_TEST_ASSERT(inSuite, aStore.IsTraitPresent(mTDH1) == aIndexedStore.IsTraitPresent(mTDH1));
+    NL_TEST_ASSERT(inSuite, aStore.IsTraitPresent(mTDH2) == aIndexedStore.IsTraitPresent(mTDH2));
+
+    for (size_t i = 0; i < aNumProbes; i++)
+    {
+        NL_TEST_ASSERT(inSuite, aStore.IsPresent(aProbes[i]) == aIndexedStore.IsPresent(aProbes[i]));
+        NL_TEST_ASSERT(inSuite, aStore.Includes(aProbes[i], mSchemaEngine) ==
+                                aIndexedStore.Includes(aProbes[i], mSchemaEngine));
+        NL_TEST_ASSERT(inSuite, aStore.Intersects(aProbes[i], mSchemaEngine) ==
+                                aIndexedStore.Intersects(aProbes[i], mSchemaEngine));
+    }
+}
+
+/**
+ * Applies the same random sequence of operations to a store and to an indexed
+ * store, and checks that the two always answer queries the same way.
+ */
+void TraitPathStoreTest::TestIndex(nlTestSuite *inSuite, void *inContext)
+{
+    TraitPathStore store, indexedStore;
+    TraitPathStore::Record storage[20], indexedStorage[20];
+    TraitPathStore::IndexEntry index[128];
+    TraitPath probes[128];
+    size_t numProbes;
+    WEAVE_ERROR err, indexedErr;
+
+    AddProbes(probes, numProbes);
+
+    store.Init(storage, ArraySize(storage));
+    indexedStore.Init(indexedStorage, ArraySize(indexedStorage), index, ArraySize(index));
+
+    srand(1);
+
+    for (int n = 0; n < 2000; n++)
+    {
+        const TraitPath &tp = probes[rand() % numProbes];
+        size_t item = rand() % ArraySize(storage);
+
+        switch (rand() % 8)
+        {
+        case 0:
+            // Same as AddItemDedup, but without indexing ancestors.
+            if (!store.IsFull())
+            {
+                err = store.AddItem(tp);
+                indexedErr = indexedStore.AddItem(tp);
+                NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && indexedErr == WEAVE_NO_ERROR);
+            }
+            break;
+        case 1:
+            if (store.IsItemInUse(item))
+            {
+                store.RemoveItemAt(item);
+                indexedStore.RemoveItemAt(item);
+            }
+            break;
+        case 2:
+            if (store.IsItemInUse(item))
+            {
+                store.SetFailed(item);
+                indexedStore.SetFailed(item);
+            }
+            break;
+        case 3:
+            store.SetFailedTrait(tp.mTraitDataHandle);
+            indexedStore.SetFailedTrait(tp.mTraitDataHandle);
+            store.Compact();
+            indexedStore.Compact();
+            break;
+        case 4:
+            if (store.GetNumItems() > ArraySize(storage) / 2)
+            {
+                store.Clear();
+                indexedStore.Clear();
+            }
+            break;
+        default:
+            err = store.AddItemDedup(tp, mSchemaEngine);
+            indexedErr = indexedStore.AddItemDedup(tp, mSchemaEngine);
+            NL_TEST_ASSERT(inSuite, err == indexedErr);
+            break;
+        }
+
+        CompareStores(inSuite, store, indexedStore, probes, numProbes);
+    }
+}
+
+/**
+ * An index too small for the items falls back to scanning until the store is cleared.
+ */
+void TraitPathStoreTest::TestIndexOverflow(nlTestSuite *inSuite, void *inContext)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TraitPathStore store, indexedStore;
+    TraitPathStore::Record storage[10], indexedStorage[10];
+    TraitPathStore::IndexEntry index[8];
+    TraitPath probes[128];
+    size_t numProbes;
+
+    AddProbes(probes, numProbes);
+
+    store.Init(storage, ArraySize(storage));
+    indexedStore.Init(indexedStorage, ArraySize(indexedStorage), index, ArraySize(index));
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (PropertyDictionaryKey key = 0; key < 5; key++)
+        {
+            mPath.mTraitDataHandle = mTDH1;
+            mPath.mPropertyPathHandle = CreatePropertyPathHandle(TestHTrait::kPropertyHandle_L_Value_Da, key);
+
+            err = store.AddItemDedup(mPath, mSchemaEngine);
+            NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+            err = indexedStore.AddItemDedup(mPath, mSchemaEngine);
+            NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+            CompareStores(inSuite, store, indexedStore, probes, numProbes);
+        }
+
+        store.RemoveItemAt(0);
+        indexedStore.RemoveItemAt(0);
+
+        CompareStores(inSuite, store, indexedStore, probes, numProbes);
+
+        store.Clear();
+        indexedStore.Clear();
+    }
+}
+
+/**
+ * Measures adding the 500 leaves of a dictionary with AddItemDedup, then checking each of them
+ * with Intersects, with and without an index.
+ */
+void TraitPathStoreTest::BenchmarkAddItemDedup(void)
+{
+    enum { kNumProperties = 500 };
+    static TraitPathStore::Record storage[kNumProperties];
+    static TraitPathStore::IndexEntry index[4 * kNumProperties];
+    TraitPathStore store;
+
+    for (int indexed = 0; indexed < 2; indexed++)
+    {
+        BenchmarkTimer timer;
+        uint64_t totalRuns = 0;
+
+        while (timer.Continue())
+        {
+            if (indexed)
+            {
+                store.Init(storage, ArraySize(storage), index, ArraySize(index));
+            }
+            else
+            {
+                store.Init(storage, ArraySize(storage));
+            }
+
+            for (PropertyDictionaryKey key = 0; key < kNumProperties; key++)
+            {
+                mPath.mTraitDataHandle = mTDH1;
+                mPath.mPropertyPathHandle = CreatePropertyPathHandle(TestHTrait::kPropertyHandle_L_Value_Da, key);
+
+                if (store.AddItemDedup(mPath, mSchemaEngine) != WEAVE_NO_ERROR)
+                {
+                    printf("AddItemDedup failed\n");
+                    return;
+                }
+            }
+
+            for (PropertyDictionaryKey key = 0; key < kNumProperties; key++)
+            {
+                mPath.mPropertyPathHandle = CreatePropertyPathHandle(TestHTrait::kPropertyHandle_L_Value_Da, key);
+
+                if (!store.Intersects(mPath, mSchemaEngine))
+                {
+                    printf("Intersects failed\n");
+                    return;
+                }
+            }
+
+            totalRuns++;
+        }
+
+        printf("AddItemDedup and Intersects of %d properties %-8s %10.1f usec\n", kNumProperties,
+               indexed ? "indexed" : "linear", (double) timer.ElapsedUSec() / (double) totalRuns);
+    }
+}
+
 } // WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
 }
 }
@@ -720,6 +948,16 @@ void TraitPathStoreTest_SetFailedTrait(nlTestSuite *inSuite, void *inContext)
     gPathStoreTest.TestSetFailedTrait(inSuite, inContext);
 }
 
+void TraitPathStoreTest_Index(nlTestSuite *inSuite, void *inContext)
+{
+    gPathStoreTest.TestIndex(inSuite, inContext);
+}
+
+void TraitPathStoreTest_IndexOverflow(nlTestSuite *inSuite, void *inContext)
+{
+    gPathStoreTest.TestIndexOverflow(inSuite, inContext);
+}
+
 // Test Suite
 
 /**
@@ -738,6 +976,8 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("Flags",  TraitPathStoreTest_Flags),
     NL_TEST_DEF("InsertItem",  TraitPathStoreTest_InsertItem),
     NL_TEST_DEF("SetFailedTrait",  TraitPathStoreTest_SetFailedTrait),
+    NL_TEST_DEF("Index",  TraitPathStoreTest_Index),
+    NL_TEST_DEF("Index overflow",  TraitPathStoreTest_IndexOverflow),
 
     NL_TEST_SENTINEL()
 };
@@ -773,6 +1013,20 @@ static int TestTeardown(void *inContext)
     return 0;
 }
 
+static HelpOptions gHelpOptions(
+    TOOL_NAME,
+    "Usage: " TOOL_NAME " [<options...>]\n",
+    WEAVE_VERSION_STRING "\n" WEAVE_TOOL_COPYRIGHT,
+    "Unit tests for the WDM TraitPathStore.\n"
+);
+
+static OptionSet *gToolOptionSets[] =
+{
+    &gBenchmarkOptions,
+    &gHelpOptions,
+    NULL
+};
+
 /**
  *  Main
  */
@@ -785,6 +1039,17 @@ int main(int argc, char *argv[])
         TestTeardown
     };
 
+    if (!ParseArgs(TOOL_NAME, argc, argv, gToolOptionSets))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    if (gBenchmarkOptions.RunBenchmarks)
+    {
+        gPathStoreTest.BenchmarkAddItemDedup();
+        return EXIT_SUCCESS;
+    }
+
     // Generate machine-readable, comma-separated value (CSV) output.
     nl_test_set_output_style(OUTPUT_CSV);
 
@@ -64,6 +64,8 @@ using namespace nl;
 using namespace nl::Weave::TLV;
 using namespace nl::Weave::Profiles::DataManagement;
 
+#define TOOL_NAME "TestTDM"
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // System/Platform definitions
@@ -160,7 +162,18 @@ static void TestTdmDictionary_DeleteEntryTwice(nlTestSuite *inSuite, void *inCon
 static void TestRandomizedDataVersions(nlTestSuite *inSuite, void *inContext);
 
 static void TestTdmStatic_MultiInstance(nlTestSuite *inSuite, void *inContext);
+
+static void TestTdmStatic_DataElementCache(nlTestSuite *inSuite, void *inContext);
+static void TestTdmStatic_NotifyCoalescing(nlTestSuite *inSuite, void *inContext);
+static void TestTdmStatic_DeltaNotifications(nlTestSuite *inSuite, void *inContext);
+static void TestTdmStatic_NotifyPipeline(nlTestSuite *inSuite, void *inContext);
+static void TestTdmStatic_SnapshotStreaming(nlTestSuite *inSuite, void *inContext);
+static void TestTdmStatic_SubscriptionCheckpoint(nlTestSuite *inSuite, void *inContext);
+
+static void CheckPublisherPools(nlTestSuite *inSuite, void *inContext);
+static void CheckPublisherPoolCompaction(nlTestSuite *inSuite, void *inContext);
 static void CheckAllocateRightSizedBufferForNotifications(nlTestSuite *inSuite, void *inContext);
+static void CheckMultiResourceTraitCatalog(nlTestSuite *inSuite, void *inContext);
 
 // Test Suite
 
@@ -223,10 +236,23 @@ static const nlTest sTests[] = {
 
     NL_TEST_DEF("Test Tdm (Multi Instance): Multi Instance", TestTdmStatic_MultiInstance),
 
+    NL_TEST_DEF("Test Tdm (Static schema): Data element cache shared across notifies", TestTdmStatic_DataElementCache),
+    NL_TEST_DEF("Test Tdm (Static schema): Coalescing of high-rate updates", TestTdmStatic_NotifyCoalescing),
+    NL_TEST_DEF("Test Tdm (Static schema): Delta notifications", TestTdmStatic_DeltaNotifications),
+    NL_TEST_DEF("Test Tdm (Static schema): Notify pipeline", TestTdmStatic_NotifyPipeline),
+    NL_TEST_DEF("Test Tdm (Static schema): Snapshot streaming of a large dictionary", TestTdmStatic_SnapshotStreaming),
+    NL_TEST_DEF("Test Tdm (Static schema): Subscription checkpoint and restore", TestTdmStatic_SubscriptionCheckpoint),
+
     // Tests the allocation of buffer for building and sending Notifies and
     // Updates.
     NL_TEST_DEF("Test Allocate Right Sized Buffer", CheckAllocateRightSizedBufferForNotifications),
 
+    // Tests indexing and growth of the multi-resource catalog.
+    NL_TEST_DEF("Test MultiResourceTraitCatalog", CheckMultiResourceTraitCatalog),
+
+    NL_TEST_DEF("Test publisher handler and trait instance pools", CheckPublisherPools),
+    NL_TEST_DEF("Test publisher trait instance pool compaction", CheckPublisherPoolCompaction),
+
 
     NL_TEST_SENTINEL()
 };
@@ -412,6 +438,10 @@ public:
     void SetValue(PropertyPathHandle aPropertyPathHandle, uint32_t aValue);
     void Reset();
 
+    // Making these public to allow tests to change the version as if the data had changed or the publisher had restarted.
+    using TraitDataSource::SetVersion;
+    using TraitDataSource::IncrementVersion;
+
 private:
     WEAVE_ERROR GetLeafData(PropertyPathHandle aLeafHandle, uint64_t aTagToWrite, TLVWriter &aWriter);
     WEAVE_ERROR GetNextDictionaryItemKey(PropertyPathHandle aDictionaryHandle, uintptr_t &aContext, PropertyDictionaryKey &aKey);
@@ -579,6 +609,8 @@ public:
     bool ValidateChangeSets(std::map <PropertyPathHandle, uint32_t> aTargetModifiedSet, std::set <PropertyPathHandle> aTargetDeletedSet, std::set <PropertyPathHandle> aTargetReplacedSet);
 
 private:
+    friend class TestTdm;
+
     WEAVE_ERROR OnEvent(uint16_t aType, void *aInParam);
     WEAVE_ERROR SetLeafData(PropertyPathHandle aLeafHandle, nl::Weave::TLV::TLVReader &aReader);
     WEAVE_ERROR GetLeafData(PropertyPathHandle aLeafHandle, uint64_t aTagToWrite, TLVWriter &aWriter);
@@ -689,7 +721,11 @@ public:
     int Setup();
     int Teardown();
     int Reset();
-    int BuildAndProcessNotify();
+    int BuildNotify(PacketBuffer *&aBuf, bool &aNeWriteInProgress);
+    int BuildAndProcessNotify(uint32_t *aNotifyLen = NULL);
+    int RunHighRateUpdates(uint32_t aNumUpdates, uint32_t &aNumNotifies);
+    uint8_t ConfirmNotifies(void);
+    int PrimeLargeDictionary(uint32_t aNumEntries, uint32_t &aNumNotifies, uint32_t &aNumBytes);
 
     void TestTdmStatic_SingleLeafHandle(nlTestSuite *inSuite);
     void TestTdmStatic_SingleLevelMerge(nlTestSuite *inSuite);
@@ -737,8 +773,21 @@ public:
 
     void TestTdmStatic_MultiInstance(nlTestSuite *inSuite);
 
+    void TestTdmStatic_DataElementCache(nlTestSuite *inSuite);
+    void TestTdmStatic_NotifyCoalescing(nlTestSuite *inSuite);
+    void TestTdmStatic_DeltaNotifications(nlTestSuite *inSuite);
+    void TestTdmStatic_NotifyPipeline(nlTestSuite *inSuite);
+    void TestTdmStatic_SnapshotStreaming(nlTestSuite *inSuite);
+    void TestTdmStatic_SubscriptionCheckpoint(nlTestSuite *inSuite);
+
     void CheckAllocateRightSizedBufferForNotifications(nlTestSuite *inSuite);
 
+    void CheckPublisherPools(nlTestSuite *inSuite);
+    void CheckPublisherPoolCompaction(nlTestSuite *inSuite);
+
+    void BenchmarkNotifyFanOut(void);
+    void BenchmarkSnapshotPriming(void);
+
 private:
     SubscriptionHandler *mSubHandler;
     SubscriptionClient *mSubClient;
@@ -825,36 +874,27 @@ int TestTdm::Setup()
 
     mSinkCatalog.Add(3, &mTestBSink, testBSinkHandle);
 
-    traitInstance = mSubscriptionEngine.mTraitInfoPool;
-    mSubHandler->mTraitInstanceList = traitInstance;
-    mSubHandler->mNumTraitInstances++;
-    ++(SubscriptionEngine::GetInstance()->mNumTraitInfosInPool);
+    traitInstance = mSubscriptionEngine.NewTraitInfo(mSubHandler);
+    VerifyOrExit(traitInstance != NULL, err = WEAVE_ERROR_NO_MEMORY);
 
-    traitInstance->Init();
     traitInstance->mTraitDataHandle = testTdmSourceHandle;
     traitInstance->mRequestedVersion = 1;
 
-    traitInstance = mSubscriptionEngine.mTraitInfoPool + 1;
-    mSubHandler->mNumTraitInstances++;
-    ++(SubscriptionEngine::GetInstance()->mNumTraitInfosInPool);
+    traitInstance = mSubscriptionEngine.NewTraitInfo(mSubHandler);
+    VerifyOrExit(traitInstance != NULL, err = WEAVE_ERROR_NO_MEMORY);
 
-    traitInstance->Init();
     traitInstance->mTraitDataHandle = testTdmSourceHandle1;
     traitInstance->mRequestedVersion = 1;
 
-    traitInstance = mSubscriptionEngine.mTraitInfoPool + 2;
-    mSubHandler->mNumTraitInstances++;
-    ++(SubscriptionEngine::GetInstance()->mNumTraitInfosInPool);
+    traitInstance = mSubscriptionEngine.NewTraitInfo(mSubHandler);
+    VerifyOrExit(traitInstance != NULL, err = WEAVE_ERROR_NO_MEMORY);
 
-    traitInstance->Init();
     traitInstance->mTraitDataHandle = testMismatchedCSourceHandle;
     traitInstance->mRequestedVersion = 1;
 
-    traitInstance = mSubscriptionEngine.mTraitInfoPool + 3;
-    mSubHandler->mNumTraitInstances++;
-    ++(SubscriptionEngine::GetInstance()->mNumTraitInfosInPool);
+    traitInstance = mSubscriptionEngine.NewTraitInfo(mSubHandler);
+    VerifyOrExit(traitInstance != NULL, err = WEAVE_ERROR_NO_MEMORY);
 
-    traitInstance->Init();
     traitInstance->mTraitDataHandle = testBSourceHandle;
     traitInstance->mRequestedVersion = 1;
 
@@ -901,35 +941,57 @@ int TestTdm::Reset()
     return err;
 }
 
-int TestTdm::BuildAndProcessNotify()
+int TestTdm::BuildNotify(PacketBuffer *&aBuf, bool &aNeWriteInProgress)
 {
     bool isSubscriptionClean;
     NotificationEngine::NotifyRequestBuilder notifyRequest;
-    NotificationRequest::Parser notify;
-    PacketBuffer *buf = NULL;
     TLVWriter writer;
-    TLVReader reader;
-    TLVType dummyType1, dummyType2;
     WEAVE_ERROR err = WEAVE_NO_ERROR;
-    bool neWriteInProgress = false;
     uint32_t maxNotificationSize = 0;
     uint32_t maxPayloadSize = 0;
 
+    aBuf = NULL;
+    aNeWriteInProgress = false;
+
     maxNotificationSize = mSubHandler->GetMaxNotificationSize();
 
-    err = mSubHandler->mBinding->AllocateRightSizedBuffer(buf, maxNotificationSize, WDM_MIN_NOTIFICATION_SIZE, maxPayloadSize);
+    err = mSubHandler->mBinding->AllocateRightSizedBuffer(aBuf, maxNotificationSize, WDM_MIN_NOTIFICATION_SIZE, maxPayloadSize);
     SuccessOrExit(err);
 
-    err = notifyRequest.Init(buf, &writer, mSubHandler, maxPayloadSize);
+    err = notifyRequest.Init(aBuf, &writer, mSubHandler, maxPayloadSize);
     SuccessOrExit(err);
 
-    err = mNotificationEngine->BuildSingleNotifyRequestDataList(mSubHandler, notifyRequest, isSubscriptionClean, neWriteInProgress);
+    err = mNotificationEngine->BuildSingleNotifyRequestDataList(mSubHandler, notifyRequest, isSubscriptionClean, aNeWriteInProgress);
     SuccessOrExit(err);
 
-    if (neWriteInProgress)
+    if (aNeWriteInProgress)
     {
         err = notifyRequest.MoveToState(NotificationEngine::kNotifyRequestBuilder_Idle);
         SuccessOrExit(err);
+    }
+
+exit:
+    return err;
+}
+
+int TestTdm::BuildAndProcessNotify(uint32_t *aNotifyLen)
+{
+    NotificationRequest::Parser notify;
+    PacketBuffer *buf = NULL;
+    TLVReader reader;
+    TLVType dummyType1, dummyType2;
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    bool neWriteInProgress = false;
+
+    err = BuildNotify(buf, neWriteInProgress);
+    SuccessOrExit(err);
+
+    if (neWriteInProgress)
+    {
+        if (aNotifyLen != NULL)
+        {
+            *aNotifyLen = buf->DataLength();
+        }
 
         reader.Init(buf);
 
@@ -2028,223 +2090,1245 @@ exit:
     return err;
 }
 
-void TestTdm::CheckAllocateRightSizedBufferForNotifications(nlTestSuite *inSuite)
+void TestTdm::TestTdmStatic_DataElementCache(nlTestSuite *inSuite)
 {
+#if WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
     WEAVE_ERROR err = WEAVE_NO_ERROR;
-    uint32_t maxNotificationSize = 0;
-    uint32_t fakeMax = UINT16_MAX;
-    maxNotificationSize = mSubHandler->GetMaxNotificationSize();
+    NotificationEngine::DataElementCache &cache = mNotificationEngine->mDataElementCache;
+    PacketBuffer *buf = NULL;
+    bool neWriteInProgress = false;
+    uint8_t uncached[WDM_MAX_NOTIFICATION_SIZE];
+    uint16_t uncachedLen = 0;
+    uint32_t numHits = 0;
+    bool testPass = false;
 
-    err = AllocateBuffer(WDM_MAX_NOTIFICATION_SIZE, WDM_MIN_NOTIFICATION_SIZE);
+    Reset();
 
-    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_A, 2);
+    mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_B, 3);
 
-    err = AllocateBuffer(fakeMax, fakeMax);
+    // With the cache disabled, the data element is retrieved from the data source and encoded straight into the notify.
+    cache.SetEnabled(false);
 
-    NL_TEST_ASSERT(inSuite, err != WEAVE_NO_ERROR);
-}
+    err = BuildNotify(buf, neWriteInProgress);
+    SuccessOrExit(err);
+    VerifyOrExit(neWriteInProgress, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(cache.mEntries[0].mDataSource == NULL, err = WEAVE_ERROR_INCORRECT_STATE);
 
-} // WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
-}
-}
-}
+    uncachedLen = buf->DataLength();
+    memcpy(uncached, buf->Start(), uncachedLen);
+    PacketBuffer::Free(buf);
+    buf = NULL;
 
-TestTdm *gTestTdm;
+    cache.SetEnabled(true);
+    numHits = cache.GetNumHits();
 
-/**
- *  Set up the test suite.
- */
-static int TestSetup(void *inContext)
-{
-    static TestTdm testTdm;
-    gTestTdm = &testTdm;
+    // The first notify for the change encodes the data element into the cache and copies it from there.
+    mSubHandler->mTraitInstanceList[0].SetDirty();
 
-    return testTdm.Setup();
-}
+    err = BuildNotify(buf, neWriteInProgress);
+    SuccessOrExit(err);
+    VerifyOrExit(neWriteInProgress, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(cache.mEntries[0].mDataSource == &mTestTdmSource, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(cache.GetNumHits() == numHits, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(buf->DataLength() == uncachedLen && memcmp(buf->Start(), uncached, uncachedLen) == 0,
+                 err = WEAVE_ERROR_INCORRECT_STATE);
 
-/**
- *  Tear down the test suite.
- */
-static int TestTeardown(void *inContext)
-{
-    return gTestTdm->Teardown();
-}
+    PacketBuffer::Free(buf);
+    buf = NULL;
 
-static void TestTdmStatic_SingleLeafHandle(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmStatic_SingleLeafHandle(inSuite);
-}
+    // Subsequent notifies for the same change are served from the cache.
+    mSubHandler->mTraitInstanceList[0].SetDirty();
 
-static void TestTdmStatic_SingleLevelMerge(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmStatic_SingleLevelMerge(inSuite);
-}
+    err = BuildNotify(buf, neWriteInProgress);
+    SuccessOrExit(err);
+    VerifyOrExit(neWriteInProgress, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(cache.GetNumHits() == numHits + 1, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(buf->DataLength() == uncachedLen && memcmp(buf->Start(), uncached, uncachedLen) == 0,
+                 err = WEAVE_ERROR_INCORRECT_STATE);
 
-static void TestTdmStatic_SingleLevelMergeDeep(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmStatic_SingleLevelMergeDeep(inSuite);
-}
+    // Marking the trait instance dirty invalidates its entries, and the new value is notified.
+    mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_A, 4);
 
-static void TestTdmStatic_DirtyStruct(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmStatic_DirtyStruct(inSuite);
-}
+    for (size_t i = 0; i < WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE; i++)
+    {
+        VerifyOrExit(cache.mEntries[i].mDataSource != &mTestTdmSource, err = WEAVE_ERROR_INCORRECT_STATE);
+    }
 
-static void TestTdmStatic_DirtyLeafUnevenDepth(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmStatic_DirtyLeafUnevenDepth(inSuite);
-}
+    mSubHandler->mTraitInstanceList[0].SetDirty();
 
-static void TestTdmStatic_MergeHandleSetOverflow(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmStatic_MergeHandleSetOverflow(inSuite);
-}
+    err = BuildAndProcessNotify();
+    SuccessOrExit(err);
 
-static void TestTdmStatic_MarkLeafHandleDirtyTwice(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmStatic_MarkLeafHandleDirtyTwice(inSuite);
-}
+    testPass = mTestTdmSink.ValidateChangeSets( { { TestHTrait::kPropertyHandle_A, 4 }, { TestHTrait::kPropertyHandle_B, 3 } },
+                                                { },
+                                                { } );
 
-static void TestTdmStatic_TestNullableStruct(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmStatic_TestNullableStruct(inSuite);
-}
+exit:
+    if (buf) {
+        PacketBuffer::Free(buf);
+    }
 
-static void TestTdmStatic_TestNullableLeaf(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmStatic_TestNullableLeaf(inSuite);
-}
+    cache.SetEnabled(true);
 
-static void TestTdmStatic_TestNonNullableLeaf(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmStatic_TestNonNullableLeaf(inSuite);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && testPass);
+#endif // WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
 }
 
-static void TestTdmStatic_TestEphemeralStruct(nlTestSuite *inSuite, void *inContext)
+// Check that each subscription's trait instances are contiguous and hold the handles they were given.
+static bool CheckPoolTraitInfos(SubscriptionHandler::TraitInstanceInfo *aTraitInfos, uint16_t aNumTraitInfos, uint16_t aHandlerIdx)
 {
-    gTestTdm->TestTdmStatic_TestEphemeralStruct(inSuite);
-}
+    for (uint16_t i = 0; i < aNumTraitInfos; i++)
+    {
+        if (aTraitInfos[i].mTraitDataHandle != aHandlerIdx * 16 + i)
+            return false;
+    }
 
-static void TestTdmStatic_TestIsParent(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmStatic_TestIsParent(inSuite);
+    return true;
 }
 
-static void TestTdmStatic_TestEphemeralLeaf(nlTestSuite *inSuite, void *inContext)
+void TestTdm::CheckPublisherPools(nlTestSuite *inSuite)
 {
-    gTestTdm->TestTdmStatic_TestEphemeralLeaf(inSuite);
-}
+#if WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+    enum { kNumHandlers = 64 };
+    SubscriptionEngine *engine = new SubscriptionEngine();
+    SubscriptionEngine::PublisherPoolStats stats;
+    SubscriptionHandler::TraitInstanceInfo *traitInfo;
+    uint16_t numTraitInfos = 0;
+    WEAVE_ERROR err;
 
-static void TestTdmMismatched_PathInDataElement(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmMismatched_PathInDataElement(inSuite);
-}
+    err = engine->ConfigurePublisherPools(kNumHandlers, 4096);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
 
-static void TestTdmMismatched_TopLevelPOD(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmMismatched_TopLevelPOD(inSuite);
-}
+    // Interleave the allocations so that subscriptions outgrow their free runs and are moved.
+    for (uint16_t round = 0; round < 8; round++)
+    {
+        for (uint16_t h = 0; h < kNumHandlers; h++)
+        {
+            if (round <= h % 8)
+            {
+                traitInfo = engine->NewTraitInfo(&engine->mHandlers[h]);
+                NL_TEST_ASSERT(inSuite, traitInfo != NULL);
+                VerifyOrExit(traitInfo != NULL, );
+
+                traitInfo->mTraitDataHandle = h * 16 + round;
+                numTraitInfos++;
+            }
+        }
+    }
 
-static void TestTdmMismatched_NestedStruct(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmMismatched_NestedStruct(inSuite);
-}
+    for (uint16_t h = 0; h < kNumHandlers; h++)
+    {
+        NL_TEST_ASSERT(inSuite, engine->mHandlers[h].mNumTraitInstances == h % 8 + 1);
+        NL_TEST_ASSERT(inSuite, CheckPoolTraitInfos(engine->mHandlers[h].mTraitInstanceList, engine->mHandlers[h].mNumTraitInstances, h));
+    }
 
-static void TestTdmMismatched_TopLevelStruct(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmMismatched_TopLevelStruct(inSuite);
-}
+    engine->GetPublisherPoolStats(stats);
+    NL_TEST_ASSERT(inSuite, stats.mNumHandlers == kNumHandlers && stats.mNumHandlersInUse == 0);
+    NL_TEST_ASSERT(inSuite, stats.mNumTraitInfosInUse == numTraitInfos);
+    NL_TEST_ASSERT(inSuite, stats.mNumTraitInfos >= numTraitInfos && stats.mMaxNumTraitInfos == 4096);
 
-static void TestTdmMismatched_SetLeafDataMismatch(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmMismatched_SetLeafDataMismatch(inSuite);
-}
-static void TestTdmDictionary_DictionaryEntryAddition(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DictionaryEntryAddition(inSuite);
-}
+    // Release every other subscription; the others' trait instances stay where they are.
+    for (uint16_t h = 0; h < kNumHandlers; h += 2)
+    {
+        numTraitInfos -= engine->mHandlers[h].mNumTraitInstances;
+        engine->ReclaimTraitInfo(&engine->mHandlers[h]);
+    }
 
-static void TestTdmDictionary_DictionaryEntriesAddition(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DictionaryEntriesAddition(inSuite);
-}
+    for (uint16_t h = 1; h < kNumHandlers; h += 2)
+    {
+        NL_TEST_ASSERT(inSuite, CheckPoolTraitInfos(engine->mHandlers[h].mTraitInstanceList, engine->mHandlers[h].mNumTraitInstances, h));
+    }
 
-static void TestTdmDictionary_ReplaceDictionary(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_ReplaceDictionary(inSuite);
-}
+    engine->GetPublisherPoolStats(stats);
+    NL_TEST_ASSERT(inSuite, stats.mNumTraitInfosInUse == numTraitInfos && stats.mNumTraitInfoFreeExtents > 1);
 
-static void TestTdmDictionary_DeleteSingle(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DeleteSingle(inSuite);
-}
+    for (uint16_t h = 1; h < kNumHandlers; h += 2)
+    {
+        engine->ReclaimTraitInfo(&engine->mHandlers[h]);
+    }
 
-static void TestTdmDictionary_DeleteMultiple(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DeleteMultiple(inSuite);
-}
+    // With everything released, the free runs merge back into one.
+    engine->GetPublisherPoolStats(stats);
+    NL_TEST_ASSERT(inSuite, stats.mNumTraitInfosInUse == 0);
+    NL_TEST_ASSERT(inSuite, stats.mNumTraitInfoFreeExtents == 1 && stats.mLargestTraitInfoFreeExtent == stats.mNumTraitInfos);
 
-static void TestTdmDictionary_DeleteHandleSetOverflow(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DeleteHandleSetOverflow(inSuite);
-}
+    // The trait instance pool does not grow past its limit.
+    err = engine->ConfigurePublisherPools(4, 8);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
 
-static void TestTdmDictionary_AddDeleteDifferent(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_AddDeleteDifferent(inSuite);
-}
+    for (uint16_t i = 0; i < 8; i++)
+    {
+        traitInfo = engine->NewTraitInfo(&engine->mHandlers[i < 5 ? 0 : 1]);
+        NL_TEST_ASSERT(inSuite, traitInfo != NULL);
+    }
 
-static void TestTdmDictionary_DeleteAndMarkDirty(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DeleteAndMarkDirty(inSuite);
-}
+    NL_TEST_ASSERT(inSuite, engine->NewTraitInfo(&engine->mHandlers[2]) == NULL);
 
-static void TestTdmDictionary_MarkDirtyAndDelete(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_MarkDirtyAndDelete(inSuite);
-}
+    engine->mHandlers[0].MoveToState(SubscriptionHandler::kState_SubscriptionEstablished_Idle);
+    NL_TEST_ASSERT(inSuite, engine->ConfigurePublisherPools(8, 8) == WEAVE_ERROR_INCORRECT_STATE);
+    engine->mHandlers[0].MoveToState(SubscriptionHandler::kState_Free);
 
-static void TestTdmDictionary_DeleteAndMarkFarDirty(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DeleteAndMarkFarDirty(inSuite);
-}
+exit:
+    delete engine;
+#endif // WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+}
+
+// Check that a subscription can grow while any trait instance is free, however fragmented the pool, as when the pool was
+// compacted each time a subscription ended.
+void TestTdm::CheckPublisherPoolCompaction(nlTestSuite *inSuite)
+{
+    SubscriptionEngine *engine = new SubscriptionEngine();
+    SubscriptionEngine::PublisherPoolStats stats;
+    SubscriptionHandler::TraitInstanceInfo *traitInfo;
+    uint16_t poolSize, numTraitInfos;
+
+#if WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
+    poolSize = 8;
+    NL_TEST_ASSERT(inSuite, engine->ConfigurePublisherPools(2, poolSize) == WEAVE_NO_ERROR);
+#else
+    // Size the pools as SubscriptionEngine::Init() does.
+    poolSize = SubscriptionEngine::kMaxNumPathGroups;
+    engine->mHandlerPoolSize      = SubscriptionEngine::kMaxNumSubscriptionHandlers;
+    engine->mTraitInfoPoolSize    = poolSize;
+    engine->mMaxTraitInfoPoolSize = poolSize;
+    for (size_t i = 0; i < engine->mHandlerPoolSize; i++)
+    {
+        engine->mHandlers[i].InitAsFree();
+    }
+    engine->ResetTraitInfoPool();
+#endif // WDM_PUBLISHER_ENABLE_DYNAMIC_POOLS
 
-static void TestTdmDictionary_AddAndDeleteSimilar(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_AddAndDeleteSimilar(inSuite);
-}
+    VerifyOrExit(engine->mHandlerPoolSize >= 2 && poolSize >= 4, );
 
-static void TestTdmDictionary_ModifyAndDeleteSimilar(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_ModifyAndDeleteSimilar(inSuite);
-}
+    // Two subscriptions take most of the pool, then the first ends, leaving its trait instances free ahead of the second's.
+    numTraitInfos = (poolSize - 2) / 2;
 
-static void TestTdmDictionary_DeleteAndModifySimilar(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DeleteAndModifySimilar(inSuite);
-}
+    for (uint16_t h = 0; h < 2; h++)
+    {
+        for (uint16_t i = 0; i < numTraitInfos; i++)
+        {
+            traitInfo = engine->NewTraitInfo(&engine->mHandlers[h]);
+            NL_TEST_ASSERT(inSuite, traitInfo != NULL);
+            VerifyOrExit(traitInfo != NULL, );
 
-static void TestTdmDictionary_DeleteAndModifyLeafSimilar(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DeleteAndModifyLeafSimilar(inSuite);
-}
+            traitInfo->mTraitDataHandle = h * 16 + i;
+        }
+    }
 
-static void TestTdmDictionary_DeleteStoreOverflowAndItemAddition(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DeleteStoreOverflowAndItemAddition(inSuite);
-}
+    engine->ReclaimTraitInfo(&engine->mHandlers[0]);
 
-static void TestTdmDictionary_DirtyStoreOverflowAndItemDeletion(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DirtyStoreOverflowAndItemDeletion(inSuite);
-}
+    engine->GetPublisherPoolStats(stats);
+    NL_TEST_ASSERT(inSuite, stats.mNumTraitInfoFreeExtents == 2);
 
-static void TestTdmDictionary_DeleteEntryTwice(nlTestSuite *inSuite, void *inContext)
-{
-    gTestTdm->TestTdmDictionary_DeleteEntryTwice(inSuite);
+    // A new subscription outgrows either free run, but may take every free trait instance.
+    for (uint16_t i = 0; i < poolSize - numTraitInfos; i++)
+    {
+        traitInfo = engine->NewTraitInfo(&engine->mHandlers[0]);
+        NL_TEST_ASSERT(inSuite, traitInfo != NULL);
+        VerifyOrExit(traitInfo != NULL, );
+
+        traitInfo->mTraitDataHandle = i;
+    }
+
+    NL_TEST_ASSERT(inSuite, engine->NewTraitInfo(&engine->mHandlers[0]) == NULL);
+
+    NL_TEST_ASSERT(inSuite, engine->mHandlers[0].mNumTraitInstances == poolSize - numTraitInfos);
+    NL_TEST_ASSERT(inSuite, CheckPoolTraitInfos(engine->mHandlers[0].mTraitInstanceList, engine->mHandlers[0].mNumTraitInstances, 0));
+    NL_TEST_ASSERT(inSuite, engine->mHandlers[1].mNumTraitInstances == numTraitInfos);
+    NL_TEST_ASSERT(inSuite, CheckPoolTraitInfos(engine->mHandlers[1].mTraitInstanceList, engine->mHandlers[1].mNumTraitInstances, 1));
+
+    engine->GetPublisherPoolStats(stats);
+    NL_TEST_ASSERT(inSuite, stats.mNumTraitInfosInUse == poolSize && stats.mNumTraitInfoFreeExtents == 0);
+
+exit:
+    delete engine;
 }
 
-static void  TestRandomizedDataVersions(nlTestSuite *inSuite, void *inContext)
+// Measure the rate at which notifies for a single dirty trait instance are built for many subscribers, with the data
+// element shared through the cache and with the cache disabled, so that it is retrieved and encoded for each subscriber.
+void TestTdm::BenchmarkNotifyFanOut(void)
+{
+#if WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+    for (int shared = 1; shared >= 0; shared--)
+    {
+        uint64_t totalNotifies = 0;
+
+        Reset();
+        mNotificationEngine->mDataElementCache.SetEnabled(shared != 0);
+
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_A, 2);
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_B, 3);
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_K_Sa, 4);
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_K_Sb, 5);
+
+        BenchmarkTimer timer;
+
+        while (timer.Continue())
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                PacketBuffer *buf = NULL;
+                bool neWriteInProgress;
+
+                mSubHandler->mTraitInstanceList[0].SetDirty();
+
+                BuildNotify(buf, neWriteInProgress);
+
+                if (buf != NULL)
+                {
+                    PacketBuffer::Free(buf);
+                }
+            }
+
+            totalNotifies += 256;
+        }
+
+        printf("Notify fan-out  %-16s %12.0f notifies/s\n", shared ? "shared" : "per-subscriber",
+               (double) totalNotifies * 1000000.0 / (double) timer.ElapsedUSec());
+    }
+
+    mNotificationEngine->mDataElementCache.SetEnabled(true);
+    Reset();
+#else
+    printf("Notify fan-out benchmark requires WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0\n");
+#endif // WDM_PUBLISHER_DATA_ELEMENT_CACHE_SIZE > 0
+}
+
+void TestTdm::BenchmarkSnapshotPriming(void)
+{
+    const uint32_t kNumEntries = 1000;
+    BenchmarkTimer timer;
+    uint64_t totalPrimes = 0;
+    uint32_t numNotifies = 0, numBytes = 0;
+
+    while (timer.Continue())
+    {
+        if (PrimeLargeDictionary(kNumEntries, numNotifies, numBytes) != WEAVE_NO_ERROR)
+        {
+            printf("Snapshot priming failed\n");
+            break;
+        }
+
+        totalPrimes++;
+    }
+
+    if (totalPrimes > 0)
+    {
+        printf("Snapshot priming %u-entry dictionary %10.1f usec, %u notifies, %u bytes\n", kNumEntries,
+               (double) timer.ElapsedUSec() / (double) totalPrimes, numNotifies, numBytes);
+    }
+
+    mSubHandler->MoveToState(SubscriptionHandler::kState_SubscriptionEstablished_Idle);
+    Reset();
+}
+
+// Fill the dictionary of the first trait instance with the given number of entries and prime the subscription with it,
+// counting the notifies and bytes it takes.
+int TestTdm::PrimeLargeDictionary(uint32_t aNumEntries, uint32_t &aNumNotifies, uint32_t &aNumBytes)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    SubscriptionHandler::TraitInstanceInfo *traitInfo = mSubHandler->mTraitInstanceList;
+    uint32_t notifyLen;
+
+    Reset();
+
+    for (size_t i = 0; i < mSubHandler->GetNumTraitInstances(); i++)
+    {
+        traitInfo[i].ClearDirty();
+    }
+
+    for (uint32_t i = 0; i < aNumEntries; i++)
+    {
+        mTestTdmSource.mDictlValues[i] = { i, i + 1, i + 2 };
+    }
+
+    // Priming sends the trait instance as a whole, whatever its size.
+    mSubHandler->MoveToState(SubscriptionHandler::kState_Subscribing);
+    traitInfo[0].SetDirty();
+
+    aNumNotifies = 0;
+    aNumBytes    = 0;
+
+    while (traitInfo[0].IsDirty())
+    {
+        notifyLen = 0;
+
+        err = BuildAndProcessNotify(&notifyLen);
+        SuccessOrExit(err);
+
+        VerifyOrExit(notifyLen > 0, err = WEAVE_ERROR_INCORRECT_STATE);
+
+        aNumNotifies++;
+        aNumBytes += notifyLen;
+    }
+
+exit:
+    return err;
+}
+
+#if WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+static uint64_t sMockClockUsec;
+
+static uint64_t GetMockClock_Monotonic(void)
+{
+    return sMockClockUsec;
+}
+
+// Advance the mock clock and fire the system layer timers that have become due.
+static void AdvanceMockClock(uint32_t aMsec)
+{
+    struct timeval sleepTime = { 0, 0 };
+
+    sMockClockUsec += aMsec * 1000;
+
+    ServiceEvents(sleepTime);
+}
+
+// Return the time until the earliest system layer timer is due, as the event loop would sleep for.
+static uint32_t GetTimerWaitMsec(void)
+{
+    fd_set readFDs, writeFDs, exceptFDs;
+    struct timeval sleepTime = { 3600, 0 };
+    int numFDs = 0;
+
+    FD_ZERO(&readFDs);
+    FD_ZERO(&writeFDs);
+    FD_ZERO(&exceptFDs);
+
+    SystemLayer.PrepareSelect(numFDs, &readFDs, &writeFDs, &exceptFDs, sleepTime);
+
+    return sleepTime.tv_sec * 1000 + sleepTime.tv_usec / 1000;
+}
+
+static void CoalescingHandlerEventCallback(void * const aAppState, SubscriptionHandler::EventID aEvent,
+                                           const SubscriptionHandler::InEventParam & aInParam,
+                                           SubscriptionHandler::OutEventParam & aOutParam)
+{
+    SubscriptionHandler::DefaultEventHandler(aEvent, aInParam, aOutParam);
+}
+#endif // WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+// Stand in for the subscriber confirming the notifies the notification engine has sent, and return their number.
+uint8_t TestTdm::ConfirmNotifies(void)
+{
+    const uint8_t numNotifies = mSubHandler->FlushInFlightNotifies();
+
+    mSubHandler->MoveToState(SubscriptionHandler::kState_SubscriptionEstablished_Idle);
+    mNotificationEngine->mNumNotifiesInFlight -= numNotifies;
+
+    return numNotifies;
+}
+
+// Update a property once a millisecond of mock time, running the notification engine after every update, and count the
+// notifies it sends.
+int TestTdm::RunHighRateUpdates(uint32_t aNumUpdates, uint32_t &aNumNotifies)
+{
+    aNumNotifies = 0;
+
+#if WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    for (uint32_t i = 1; i <= aNumUpdates; i++)
+    {
+        AdvanceMockClock(1);
+        aNumNotifies += ConfirmNotifies();
+
+        // Each update is a separate transaction, and so a new data version.
+        mTestTdmSource.Lock();
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_A, i);
+        mTestTdmSource.Unlock();
+
+        mNotificationEngine->Run();
+        aNumNotifies += ConfirmNotifies();
+    }
+#endif // WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+    return WEAVE_NO_ERROR;
+}
+
+void TestTdm::TestTdmStatic_NotifyCoalescing(nlTestSuite *inSuite)
+{
+#if WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    const uint32_t kNumUpdates = 100;
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint64_t (*const realClock)(void) = MockPlatform::gMockPlatformClocks.GetClock_Monotonic;
+    WeaveMessageLayer::InitContext initContext;
+    Binding *fixtureBinding = mSubHandler->mBinding;
+    Binding *binding = NULL;
+    SubscriptionHandler::EventCallback fixtureEventCallback = mSubHandler->mEventCallback;
+    const int8_t fixtureRefCount = mSubHandler->mRefCount;
+    IPAddress loopbackAddr;
+    uint32_t uncoalescedNotifies = 0, coalescedNotifies = 0;
+    bool testPass = false;
+
+    Reset();
+
+    sMockClockUsec = realClock();
+    MockPlatform::gMockPlatformClocks.GetClock_Monotonic = GetMockClock_Monotonic;
+
+    // The notification engine sends its notifies, and arms its coalescing timer, through a message layer on the loopback
+    // interface. The notifies go to the discard port and are confirmed by the test.
+    InitSystemLayer();
+    InitNetwork();
+
+    err = FabricState.Init();
+    SuccessOrExit(err);
+
+    initContext.systemLayer = &SystemLayer;
+    initContext.inet = &::Inet;
+    initContext.fabricState = &FabricState;
+    initContext.listenTCP = false;
+    initContext.listenUDP = false;
+
+    err = MessageLayer.Init(&initContext);
+    SuccessOrExit(err);
+
+    err = mExchangeMgr.Init(&MessageLayer);
+    SuccessOrExit(err);
+
+    mSubscriptionEngine.mExchangeMgr = &mExchangeMgr;
+
+    IPAddress::FromString("::1", loopbackAddr);
+
+    binding = mExchangeMgr.NewBinding();
+    VerifyOrExit(binding != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+    err = binding->BeginConfiguration()
+              .Target_NodeId(0x18B4300000000002ULL)
+              .TargetAddress_IP(loopbackAddr, 9)
+              .Transport_UDP()
+              .Security_None()
+              .PrepareBinding();
+    SuccessOrExit(err);
+
+    // Hold the reference an established subscription would, so that the engine releasing its own does not abort it.
+    mSubHandler->mBinding = binding;
+    mSubHandler->mEventCallback = CoalescingHandlerEventCallback;
+    mSubHandler->_AddRef();
+
+    err = mSubHandler->SetNotifyCoalescing(100, 50);
+    VerifyOrExit(err == WEAVE_ERROR_INVALID_ARGUMENT, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // Without coalescing, every update is notified.
+    err = mSubHandler->SetNotifyCoalescing(0, 0);
+    SuccessOrExit(err);
+
+    err = RunHighRateUpdates(kNumUpdates, uncoalescedNotifies);
+    SuccessOrExit(err);
+
+    VerifyOrExit(uncoalescedNotifies == kNumUpdates, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(GetTimerWaitMsec() >= 3600 * 1000, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // With coalescing, the updates are held until the oldest is 50 ms old. The timer armed for the 50th update releases the
+    // first 50 together; the second 50 are still held when the updates stop.
+    err = mSubHandler->SetNotifyCoalescing(20, 50);
+    SuccessOrExit(err);
+
+    err = RunHighRateUpdates(kNumUpdates, coalescedNotifies);
+    SuccessOrExit(err);
+
+    VerifyOrExit(coalescedNotifies == 1, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mSubHandler->mTraitInstanceList[0].IsDirty(), err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // The engine has re-armed its timer for the latency bound of the second 50, and releases them when it fires.
+    VerifyOrExit(GetTimerWaitMsec() == 1, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    AdvanceMockClock(1);
+
+    coalescedNotifies += ConfirmNotifies();
+
+    VerifyOrExit(coalescedNotifies == 2, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(!mSubHandler->mTraitInstanceList[0].IsDirty(), err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(GetTimerWaitMsec() >= 3600 * 1000, err = WEAVE_ERROR_INCORRECT_STATE);
+
+#if WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION > 1
+    // With notifies pipelined, updates made while a notify is in flight are held too. The first update is released after
+    // the minimum interval, and its notify is left unconfirmed, so that the subscription is notifying with room for more.
+    // The further updates go to a second trait instance, as a trait with a notify in flight is not notified again.
+    err = mSubHandler->SetNotifyPipelineDepth(WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION);
+    SuccessOrExit(err);
+
+    mTestTdmSource.Lock();
+    mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_A, kNumUpdates + 1);
+    mTestTdmSource.Unlock();
+
+    mNotificationEngine->Run();
+    AdvanceMockClock(20);
+
+    VerifyOrExit(mSubHandler->mNumInFlightNotifies == 1, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mSubHandler->IsNotifiable(), err = WEAVE_ERROR_INCORRECT_STATE);
+
+    for (uint32_t i = 2; i <= 10; i++)
+    {
+        AdvanceMockClock(1);
+
+        mTestTdmSource1.Lock();
+        mTestTdmSource1.SetValue(TestHTrait::kPropertyHandle_A, i);
+        mTestTdmSource1.Unlock();
+
+        mNotificationEngine->Run();
+    }
+
+    VerifyOrExit(mSubHandler->mNumInFlightNotifies == 1, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(GetTimerWaitMsec() == 20, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    AdvanceMockClock(20);
+
+    VerifyOrExit(ConfirmNotifies() == 2, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(!mSubHandler->mTraitInstanceList[1].IsDirty(), err = WEAVE_ERROR_INCORRECT_STATE);
+#endif // WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION > 1
+
+    testPass = true;
+
+exit:
+    mSubHandler->ResetNotifyCoalescing();
+    ConfirmNotifies();
+
+    SystemLayer.CancelTimer(NotificationEngine::OnCoalescingTimer, mNotificationEngine);
+
+    if (binding != NULL)
+    {
+        mSubHandler->mBinding = fixtureBinding;
+        binding->Release();
+    }
+
+    mSubHandler->mEventCallback = fixtureEventCallback;
+    mSubHandler->mRefCount = fixtureRefCount;
+
+    mSubscriptionEngine.mExchangeMgr = &ExchangeMgr;
+    mExchangeMgr.Shutdown();
+    MessageLayer.Shutdown();
+    FabricState.Shutdown();
+    ShutdownNetwork();
+    ShutdownSystemLayer();
+
+    MockPlatform::gMockPlatformClocks.GetClock_Monotonic = realClock;
+
+    Reset();
+
+    if (err != WEAVE_NO_ERROR)
+    {
+        WeaveLogError(DataManagement, "Notify coalescing failed: %s", ErrorStr(err));
+    }
+
+    NL_TEST_ASSERT(inSuite, testPass);
+#endif // WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+}
+
+void TestTdm::TestTdmStatic_DeltaNotifications(nlTestSuite *inSuite)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint32_t lcaLen = 0, deltaLen = 0, exactLen = 0, exactDeltaLen = 0;
+    bool testPass = false;
+
+    // Six changed leaves overflow the merge handle set, so the LCA data element carries the whole trait, including a
+    // dictionary that has not changed.
+    // **NOTE** If you increase the merge handle limit, then this test will have to be altered too!
+    for (int pass = 0; pass < 2; pass++)
+    {
+        Reset();
+        mSubHandler->SetDeltaNotifications(pass == 1);
+
+        for (uint16_t key = 1; key <= 16; key++)
+        {
+            mTestTdmSource.mDictlValues[key] = { 1, 1, 1 };
+        }
+
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_A, 2);
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_B, 3);
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_C, 4);
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_D, 5);
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_E, 6);
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_F, 7);
+
+        err = BuildAndProcessNotify(pass == 1 ? &deltaLen : &lcaLen);
+        SuccessOrExit(err);
+    }
+
+    // Only the changed leaves were sent, and the sink applied them as one change.
+    testPass = mTestTdmSink.ValidateChangeSets( { { TestHTrait::kPropertyHandle_A, 2 }, { TestHTrait::kPropertyHandle_B, 3 },
+                                                  { TestHTrait::kPropertyHandle_C, 4 }, { TestHTrait::kPropertyHandle_D, 5 },
+                                                  { TestHTrait::kPropertyHandle_E, 6 }, { TestHTrait::kPropertyHandle_F, 7 } },
+                                                { },
+                                                { } );
+    VerifyOrExit(testPass, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mTestTdmSink.GetVersion() == mTestTdmSource.GetVersion(), err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // When the LCA merges in exactly the changed leaves, delta mode sends the same notify.
+    for (int pass = 0; pass < 2; pass++)
+    {
+        Reset();
+        mSubHandler->SetDeltaNotifications(pass == 1);
+
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_A, 2);
+        mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_B, 3);
+
+        err = BuildAndProcessNotify(pass == 1 ? &exactDeltaLen : &exactLen);
+        SuccessOrExit(err);
+    }
+
+    VerifyOrExit(deltaLen < lcaLen, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(exactDeltaLen == exactLen, err = WEAVE_ERROR_INCORRECT_STATE);
+
+exit:
+    mSubHandler->SetDeltaNotifications(false);
+
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && testPass);
+}
+
+void TestTdm::TestTdmStatic_NotifyPipeline(nlTestSuite *inSuite)
+{
+#if WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION > 1
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    PacketBuffer *buf = NULL;
+    bool neWriteInProgress = false;
+    SubscriptionHandler::TraitInstanceInfo *traitInfo = mSubHandler->mTraitInstanceList;
+    event_id_t savedSelfVendedEvents[kImportanceType_Last - kImportanceType_First + 1];
+    event_id_t deliveredEvents[kImportanceType_Last - kImportanceType_First + 1];
+    uint8_t firstSeq, secondSeq;
+    bool testPass = false;
+
+    Reset();
+    memcpy(savedSelfVendedEvents, mSubHandler->mSelfVendedEvents, sizeof(savedSelfVendedEvents));
+
+    // Start with no trait instance dirty or marked by an earlier notify.
+    mSubHandler->FlushInFlightNotifies();
+
+    for (size_t i = 0; i < mSubHandler->GetNumTraitInstances(); i++)
+    {
+        traitInfo[i].ClearDirty();
+    }
+
+    VerifyOrExit(mSubHandler->SetNotifyPipelineDepth(0) == WEAVE_ERROR_INVALID_ARGUMENT, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mSubHandler->SetNotifyPipelineDepth(WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION + 1) ==
+                 WEAVE_ERROR_INVALID_ARGUMENT, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // First notify carries trait instance 0.
+    mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_A, 2);
+
+    err = BuildNotify(buf, neWriteInProgress);
+    SuccessOrExit(err);
+    VerifyOrExit(neWriteInProgress, err = WEAVE_ERROR_INCORRECT_STATE);
+    PacketBuffer::Free(buf);
+    buf = NULL;
+
+    firstSeq = mSubHandler->mNextNotifySeq;
+    mSubHandler->mSelfVendedEvents[0] = 10;
+    mSubHandler->PushInFlightNotify(NULL);
+
+    // The subscription may pipeline another notify, but trait instance 0 is held back while its notify is unconfirmed.
+    VerifyOrExit(mSubHandler->IsNotifiable(), err = WEAVE_ERROR_INCORRECT_STATE);
+
+    mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_A, 3);
+    mTestTdmSource1.SetValue(TestHTrait::kPropertyHandle_A, 4);
+
+    err = BuildNotify(buf, neWriteInProgress);
+    SuccessOrExit(err);
+    VerifyOrExit(neWriteInProgress, err = WEAVE_ERROR_INCORRECT_STATE);
+    PacketBuffer::Free(buf);
+    buf = NULL;
+
+    secondSeq = mSubHandler->mNextNotifySeq;
+    VerifyOrExit(traitInfo[0].IsDirty() && traitInfo[0].mNotifySeq == firstSeq, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(!traitInfo[1].IsDirty() && traitInfo[1].mNotifySeq == secondSeq, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    mSubHandler->mSelfVendedEvents[0] = 20;
+    mSubHandler->PushInFlightNotify(NULL);
+
+    // A confirm that overtakes the first notify is not retired until the first notify is confirmed too.
+    mSubHandler->mInFlightNotifies[(mSubHandler->mFirstInFlightNotify + 1) % WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION]
+        .mConfirmed = true;
+    VerifyOrExit(mSubHandler->RetireInFlightNotifies(deliveredEvents) == 0, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mSubHandler->IsTraitNotifyInFlight(&traitInfo[1]), err = WEAVE_ERROR_INCORRECT_STATE);
+
+    mSubHandler->mInFlightNotifies[mSubHandler->mFirstInFlightNotify].mConfirmed = true;
+    VerifyOrExit(mSubHandler->RetireInFlightNotifies(deliveredEvents) == 2, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mSubHandler->mNumInFlightNotifies == 0 && deliveredEvents[0] == 20, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(!mSubHandler->IsTraitNotifyInFlight(&traitInfo[0]) && !mSubHandler->IsTraitNotifyInFlight(&traitInfo[1]),
+                 err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // The held change goes out next.
+    err = BuildNotify(buf, neWriteInProgress);
+    SuccessOrExit(err);
+    VerifyOrExit(neWriteInProgress && !traitInfo[0].IsDirty(), err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // A depth of 1 restores stop-and-wait.
+    err = mSubHandler->SetNotifyPipelineDepth(1);
+    SuccessOrExit(err);
+
+    mSubHandler->PushInFlightNotify(NULL);
+    VerifyOrExit(!mSubHandler->IsNotifiable(), err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mSubHandler->FlushInFlightNotifies() == 1, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    testPass = true;
+
+exit:
+    if (buf != NULL)
+    {
+        PacketBuffer::Free(buf);
+    }
+
+    mSubHandler->FlushInFlightNotifies();
+    mSubHandler->SetNotifyPipelineDepth(WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION);
+    memcpy(mSubHandler->mSelfVendedEvents, savedSelfVendedEvents, sizeof(savedSelfVendedEvents));
+
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && testPass);
+#endif // WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT_PER_SUBSCRIPTION > 1
+}
+
+void TestTdm::TestTdmStatic_SnapshotStreaming(nlTestSuite *inSuite)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    const uint32_t kNumEntries = 1000;
+    uint32_t numNotifies = 0, numBytes = 0, notifyLen = 0;
+    uint32_t i;
+
+    // Prime a trait instance whose dictionary takes many notifies; every entry must arrive exactly as in the source.
+    err = PrimeLargeDictionary(kNumEntries, numNotifies, numBytes);
+    SuccessOrExit(err);
+
+    VerifyOrExit(numNotifies > 1 && numBytes <= numNotifies * WDM_MAX_NOTIFICATION_SIZE, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mTestTdmSink.mReplacedDictionaries.count(TestHTrait::kPropertyHandle_L) == 1, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mTestTdmSink.mModifiedHandles[TestHTrait::kPropertyHandle_A] == 1, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mTestTdmSink.mModifiedHandles[TestHTrait::kPropertyHandle_K_Sb] == 1, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    for (i = 0; i < kNumEntries; i++)
+    {
+        VerifyOrExit(mTestTdmSink.mModifiedHandles[CreatePropertyPathHandle(TestHTrait::kPropertyHandle_L_Value_Da, i)] == i,
+                     err = WEAVE_ERROR_INCORRECT_STATE);
+        VerifyOrExit(mTestTdmSink.mModifiedHandles[CreatePropertyPathHandle(TestHTrait::kPropertyHandle_L_Value_Db, i)] == i + 1,
+                     err = WEAVE_ERROR_INCORRECT_STATE);
+        VerifyOrExit(mTestTdmSink.mModifiedHandles[CreatePropertyPathHandle(TestHTrait::kPropertyHandle_L_Value_Dc, i)] == i + 2,
+                     err = WEAVE_ERROR_INCORRECT_STATE);
+    }
+
+    VerifyOrExit(mTestTdmSink.GetVersion() == mTestTdmSource.GetVersion(), err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(!mSubHandler->mSnapshotCursor.IsActive(mSubHandler->mTraitInstanceList[0].mTraitDataHandle),
+                 err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // A change to the source between two parts of the snapshot starts the snapshot over, so the subscriber ends up with the
+    // new data rather than a mix of both versions.
+    mTestTdmSink.Reset();
+    mSubHandler->mTraitInstanceList[0].SetDirty();
+
+    err = BuildAndProcessNotify(&notifyLen);
+    SuccessOrExit(err);
+
+    VerifyOrExit(mSubHandler->mSnapshotCursor.IsActive(mSubHandler->mTraitInstanceList[0].mTraitDataHandle),
+                 err = WEAVE_ERROR_INCORRECT_STATE);
+
+    mTestTdmSource.Lock();
+    mTestTdmSource.mDictlValues[0] = { 7, 7, 7 };
+    mTestTdmSource.SetDirty(TestHTrait::kPropertyHandle_L);
+    mTestTdmSource.Unlock();
+
+    for (i = 0; i < 2 * numNotifies && mSubHandler->mTraitInstanceList[0].IsDirty(); i++)
+    {
+        err = BuildAndProcessNotify();
+        SuccessOrExit(err);
+    }
+
+    VerifyOrExit(!mSubHandler->mTraitInstanceList[0].IsDirty(), err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mTestTdmSink.mModifiedHandles[CreatePropertyPathHandle(TestHTrait::kPropertyHandle_L_Value_Da, 0)] == 7,
+                 err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mTestTdmSink.GetVersion() == mTestTdmSource.GetVersion(), err = WEAVE_ERROR_INCORRECT_STATE);
+
+exit:
+    mSubHandler->MoveToState(SubscriptionHandler::kState_SubscriptionEstablished_Idle);
+    mTestTdmSource.Reset();
+
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+}
+
+#if WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+static void RestoredHandlerEventCallback(void * const aAppState, SubscriptionHandler::EventID aEvent,
+                                         const SubscriptionHandler::InEventParam & aInParam,
+                                         SubscriptionHandler::OutEventParam & aOutParam)
+{
+    if (aEvent == SubscriptionHandler::kEvent_OnSubscriptionEstablished)
+    {
+        *static_cast<SubscriptionHandler **>(aAppState) = aInParam.mSubscriptionEstablished.mHandler;
+    }
+}
+#endif // WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+
+void TestTdm::TestTdmStatic_SubscriptionCheckpoint(nlTestSuite *inSuite)
+{
+#if WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint8_t buf[1024];
+    TLVWriter writer;
+    TLVReader reader;
+    Binding *fixtureBinding = mSubHandler->mBinding;
+    Binding *binding = NULL;
+    SubscriptionHandler *restored = NULL;
+    SubscriptionHandler::TraitInstanceInfo *traitInfo = mSubHandler->mTraitInstanceList;
+    IPAddress peerAddr, restoredAddr;
+    uint16_t restoredPort;
+    InterfaceId restoredInterface;
+    uint16_t numCheckpointed = 0, numRestored = 0;
+    uint64_t version, version1;
+    bool testPass = false;
+
+    Reset();
+
+    // The fixture runs without an exchange manager. Restored subscriptions need bindings that can be prepared, so the engine
+    // is given one over an idle message layer for the duration of this test.
+    MessageLayer.SystemLayer = &SystemLayer;
+    err = mExchangeMgr.Init(&MessageLayer);
+    SuccessOrExit(err);
+
+    mSubscriptionEngine.mExchangeMgr = &mExchangeMgr;
+
+    IPAddress::FromString("fd00:0:1:1::2", peerAddr);
+
+    binding = mExchangeMgr.NewBinding();
+    VerifyOrExit(binding != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+    err = binding->BeginConfiguration()
+              .Target_NodeId(0x18B4300000000002ULL)
+              .TargetAddress_IP(peerAddr, 11095)
+              .Transport_UDP_WRM()
+              .Security_None()
+              .Exchange_ResponseTimeoutMsec(7000)
+              .PrepareBinding();
+    SuccessOrExit(err);
+
+    mSubHandler->mBinding = binding;
+    mSubHandler->mSubscriptionId = 0x1234;
+    mSubHandler->mLivenessTimeoutMsec = SubscriptionHandler::kNoTimeout;
+    mSubHandler->mSubscribeToAllEvents = true;
+    mSubHandler->mSelfVendedEvents[0] = 42;
+    mSubHandler->SetDeltaNotifications(true);
+    mSubHandler->FlushInFlightNotifies();
+
+    for (size_t i = 0; i < mSubHandler->GetNumTraitInstances(); i++)
+    {
+        traitInfo[i].ClearDirty();
+    }
+
+    // The subscriber has not seen the latest changes to the third trait instance.
+    traitInfo[2].SetDirty();
+
+    // A subscription that is busy notifying is not checkpointed.
+    mSubHandler->MoveToState(SubscriptionHandler::kState_SubscriptionEstablished_Notifying);
+
+    writer.Init(buf, sizeof(buf));
+    err = mSubscriptionEngine.CheckpointSubscriptions(writer, AnonymousTag, numCheckpointed);
+    SuccessOrExit(err);
+    VerifyOrExit(numCheckpointed == 0, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    mSubHandler->MoveToState(SubscriptionHandler::kState_SubscriptionEstablished_Idle);
+
+    writer.Init(buf, sizeof(buf));
+    err = mSubscriptionEngine.CheckpointSubscriptions(writer, AnonymousTag, numCheckpointed);
+    SuccessOrExit(err);
+    VerifyOrExit(numCheckpointed == 1, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    err = writer.Finalize();
+    SuccessOrExit(err);
+
+    // Data sources start over at a random version after a restart.
+    version = mTestTdmSource.GetVersion();
+    version1 = mTestTdmSource1.GetVersion();
+    mTestTdmSource.SetVersion(0);
+    mTestTdmSource1.SetVersion(0);
+    VerifyOrExit(mTestTdmSource.GetVersion() != version && mTestTdmSource1.GetVersion() != version1,
+                 err = WEAVE_ERROR_INCORRECT_STATE);
+
+    reader.Init(buf, writer.GetLengthWritten());
+    err = reader.Next();
+    SuccessOrExit(err);
+
+    err = mSubscriptionEngine.RestoreSubscriptions(reader, &restored, RestoredHandlerEventCallback, numRestored);
+    SuccessOrExit(err);
+    VerifyOrExit(numRestored == 1 && restored != NULL && restored != mSubHandler, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    VerifyOrExit(restored->IsEstablishedIdle(), err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(restored->mSubscriptionId == 0x1234, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(restored->GetPeerNodeId() == 0x18B4300000000002ULL, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(mSubscriptionEngine.FindHandler(0x18B4300000000002ULL, 0x1234) != NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(restored->IsDeltaNotificationEnabled(), err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(restored->mSubscribeToAllEvents && restored->mSelfVendedEvents[0] == 42, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    restored->mBinding->GetPeerIPAddress(restoredAddr, restoredPort, restoredInterface);
+    VerifyOrExit(restoredAddr == peerAddr && restoredPort == 11095, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(restored->mBinding->IsWRMTransport() && restored->mBinding->GetDefaultResponseTimeout() == 7000,
+                 err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // The data sources are back at their checkpointed versions, and only the trait instances the subscriber is behind on
+    // are notified.
+    VerifyOrExit(mTestTdmSource.GetVersion() == version && mTestTdmSource1.GetVersion() == version1,
+                 err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(restored->GetNumTraitInstances() == mSubHandler->GetNumTraitInstances(), err = WEAVE_ERROR_INCORRECT_STATE);
+
+    for (size_t i = 0; i < restored->GetNumTraitInstances(); i++)
+    {
+        SubscriptionHandler::TraitInstanceInfo *restoredInfo = &restored->mTraitInstanceList[i];
+
+        VerifyOrExit(restoredInfo->mTraitDataHandle == traitInfo[i].mTraitDataHandle, err = WEAVE_ERROR_INCORRECT_STATE);
+        VerifyOrExit(restoredInfo->mRequestedVersion == traitInfo[i].mRequestedVersion, err = WEAVE_ERROR_INCORRECT_STATE);
+        VerifyOrExit(restoredInfo->IsDirty() == (i == 2), err = WEAVE_ERROR_INCORRECT_STATE);
+    }
+
+    // Changes made after the restore are notified as usual.
+    mTestTdmSource1.Lock();
+    mTestTdmSource1.SetValue(TestHTrait::kPropertyHandle_B, 2);
+    mTestTdmSource1.Unlock();
+
+    VerifyOrExit(mTestTdmSource1.GetVersion() == version1 + 1 && restored->mTraitInstanceList[1].IsDirty(),
+                 err = WEAVE_ERROR_INCORRECT_STATE);
+
+    testPass = true;
+
+exit:
+    if (restored != NULL && restored != mSubHandler)
+    {
+        restored->AbortSubscription();
+    }
+
+    if (binding != NULL)
+    {
+        mSubHandler->mBinding = fixtureBinding;
+        binding->Release();
+    }
+
+    mSubHandler->mSubscriptionId = 0;
+    mSubHandler->mSubscribeToAllEvents = false;
+    mSubHandler->mSelfVendedEvents[0] = 0;
+    mSubHandler->SetDeltaNotifications(WDM_PUBLISHER_DEFAULT_DELTA_NOTIFICATIONS);
+
+    mSubscriptionEngine.mExchangeMgr = &ExchangeMgr;
+    mExchangeMgr.Shutdown();
+    MessageLayer.SystemLayer = NULL;
+
+    Reset();
+
+    if (err != WEAVE_NO_ERROR)
+    {
+        WeaveLogError(DataManagement, "Subscription checkpoint failed: %s", ErrorStr(err));
+    }
+
+    NL_TEST_ASSERT(inSuite, testPass);
+#endif // WDM_PUBLISHER_ENABLE_SUBSCRIPTION_CHECKPOINT
+}
+
+void TestTdm::CheckAllocateRightSizedBufferForNotifications(nlTestSuite *inSuite)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint32_t maxNotificationSize = 0;
+    uint32_t fakeMax = UINT16_MAX;
+    maxNotificationSize = mSubHandler->GetMaxNotificationSize();
+
+    err = AllocateBuffer(WDM_MAX_NOTIFICATION_SIZE, WDM_MIN_NOTIFICATION_SIZE);
+
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    err = AllocateBuffer(fakeMax, fakeMax);
+
+    NL_TEST_ASSERT(inSuite, err != WEAVE_NO_ERROR);
+}
+
+} // WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
+}
+}
+}
+
+TestTdm *gTestTdm;
+
+/**
+ *  Set up the test suite.
+ */
+static int TestSetup(void *inContext)
+{
+    static TestTdm testTdm;
+    gTestTdm = &testTdm;
+
+    return testTdm.Setup();
+}
+
+/**
+ *  Tear down the test suite.
+ */
+static int TestTeardown(void *inContext)
+{
+    return gTestTdm->Teardown();
+}
+
+static void TestTdmStatic_SingleLeafHandle(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_SingleLeafHandle(inSuite);
+}
+
+static void TestTdmStatic_SingleLevelMerge(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_SingleLevelMerge(inSuite);
+}
+
+static void TestTdmStatic_SingleLevelMergeDeep(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_SingleLevelMergeDeep(inSuite);
+}
+
+static void TestTdmStatic_DirtyStruct(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_DirtyStruct(inSuite);
+}
+
+static void TestTdmStatic_DirtyLeafUnevenDepth(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_DirtyLeafUnevenDepth(inSuite);
+}
+
+static void TestTdmStatic_MergeHandleSetOverflow(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_MergeHandleSetOverflow(inSuite);
+}
+
+static void TestTdmStatic_MarkLeafHandleDirtyTwice(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_MarkLeafHandleDirtyTwice(inSuite);
+}
+
+static void TestTdmStatic_TestNullableStruct(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_TestNullableStruct(inSuite);
+}
+
+static void TestTdmStatic_TestNullableLeaf(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_TestNullableLeaf(inSuite);
+}
+
+static void TestTdmStatic_TestNonNullableLeaf(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_TestNonNullableLeaf(inSuite);
+}
+
+static void TestTdmStatic_TestEphemeralStruct(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_TestEphemeralStruct(inSuite);
+}
+
+static void TestTdmStatic_TestIsParent(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_TestIsParent(inSuite);
+}
+
+static void TestTdmStatic_TestEphemeralLeaf(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_TestEphemeralLeaf(inSuite);
+}
+
+static void TestTdmMismatched_PathInDataElement(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmMismatched_PathInDataElement(inSuite);
+}
+
+static void TestTdmMismatched_TopLevelPOD(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmMismatched_TopLevelPOD(inSuite);
+}
+
+static void TestTdmMismatched_NestedStruct(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmMismatched_NestedStruct(inSuite);
+}
+
+static void TestTdmMismatched_TopLevelStruct(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmMismatched_TopLevelStruct(inSuite);
+}
+
+static void TestTdmMismatched_SetLeafDataMismatch(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmMismatched_SetLeafDataMismatch(inSuite);
+}
+static void TestTdmDictionary_DictionaryEntryAddition(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DictionaryEntryAddition(inSuite);
+}
+
+static void TestTdmDictionary_DictionaryEntriesAddition(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DictionaryEntriesAddition(inSuite);
+}
+
+static void TestTdmDictionary_ReplaceDictionary(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_ReplaceDictionary(inSuite);
+}
+
+static void TestTdmDictionary_DeleteSingle(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DeleteSingle(inSuite);
+}
+
+static void TestTdmDictionary_DeleteMultiple(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DeleteMultiple(inSuite);
+}
+
+static void TestTdmDictionary_DeleteHandleSetOverflow(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DeleteHandleSetOverflow(inSuite);
+}
+
+static void TestTdmDictionary_AddDeleteDifferent(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_AddDeleteDifferent(inSuite);
+}
+
+static void TestTdmDictionary_DeleteAndMarkDirty(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DeleteAndMarkDirty(inSuite);
+}
+
+static void TestTdmDictionary_MarkDirtyAndDelete(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_MarkDirtyAndDelete(inSuite);
+}
+
+static void TestTdmDictionary_DeleteAndMarkFarDirty(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DeleteAndMarkFarDirty(inSuite);
+}
+
+static void TestTdmDictionary_AddAndDeleteSimilar(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_AddAndDeleteSimilar(inSuite);
+}
+
+static void TestTdmDictionary_ModifyAndDeleteSimilar(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_ModifyAndDeleteSimilar(inSuite);
+}
+
+static void TestTdmDictionary_DeleteAndModifySimilar(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DeleteAndModifySimilar(inSuite);
+}
+
+static void TestTdmDictionary_DeleteAndModifyLeafSimilar(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DeleteAndModifyLeafSimilar(inSuite);
+}
+
+static void TestTdmDictionary_DeleteStoreOverflowAndItemAddition(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DeleteStoreOverflowAndItemAddition(inSuite);
+}
+
+static void TestTdmDictionary_DirtyStoreOverflowAndItemDeletion(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DirtyStoreOverflowAndItemDeletion(inSuite);
+}
+
+static void TestTdmDictionary_DeleteEntryTwice(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmDictionary_DeleteEntryTwice(inSuite);
+}
+
+static void  TestRandomizedDataVersions(nlTestSuite *inSuite, void *inContext)
 {
     gTestTdm->TestRandomizedDataVersions(inSuite);
 }
@@ -2254,11 +3338,320 @@ static void TestTdmStatic_MultiInstance(nlTestSuite *inSuite, void *inContext)
     gTestTdm->TestTdmStatic_MultiInstance(inSuite);
 }
 
+static void TestTdmStatic_DataElementCache(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_DataElementCache(inSuite);
+}
+
+static void TestTdmStatic_NotifyCoalescing(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_NotifyCoalescing(inSuite);
+}
+
+static void TestTdmStatic_DeltaNotifications(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_DeltaNotifications(inSuite);
+}
+
+static void TestTdmStatic_NotifyPipeline(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_NotifyPipeline(inSuite);
+}
+
+static void TestTdmStatic_SnapshotStreaming(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_SnapshotStreaming(inSuite);
+}
+
+static void TestTdmStatic_SubscriptionCheckpoint(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_SubscriptionCheckpoint(inSuite);
+}
+
 static void CheckAllocateRightSizedBufferForNotifications(nlTestSuite *inSuite, void *inContext)
 {
     gTestTdm->CheckAllocateRightSizedBufferForNotifications(inSuite);
 }
 
+static void CheckPublisherPools(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->CheckPublisherPools(inSuite);
+}
+
+static void CheckPublisherPoolCompaction(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->CheckPublisherPoolCompaction(inSuite);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Testing MultiResourceTraitCatalog
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Number of resources and trait instances per resource used by the catalog test and benchmark.
+#define CATALOG_TEST_NUM_RESOURCES 1024
+#define CATALOG_TEST_INSTANCES_PER_RESOURCE 16
+#define CATALOG_TEST_NUM_ITEMS (CATALOG_TEST_NUM_RESOURCES * CATALOG_TEST_INSTANCES_PER_RESOURCE)
+
+static TestEmptyDataSource *NewCatalogTestSources(void)
+{
+    TestEmptyDataSource *sources = (TestEmptyDataSource *) malloc(CATALOG_TEST_NUM_ITEMS * sizeof(TestEmptyDataSource));
+
+    for (int i = 0; sources != NULL && i < CATALOG_TEST_NUM_ITEMS; i++)
+        new (&sources[i]) TestEmptyDataSource(&TestHTrait::TraitSchema);
+
+    return sources;
+}
+
+static void DeleteCatalogTestSources(TestEmptyDataSource *sources)
+{
+    for (int i = 0; sources != NULL && i < CATALOG_TEST_NUM_ITEMS; i++)
+        sources[i].~TestEmptyDataSource();
+
+    free(sources);
+}
+
+static ResourceIdentifier CatalogTestResourceId(int index)
+{
+    if (index == 0)
+        return ResourceIdentifier(ResourceIdentifier::SELF_NODE_ID);
+
+    return ResourceIdentifier(Schema::Weave::Common::RESOURCE_TYPE_DEVICE, 0x18B4300000000000ULL + index);
+}
+
+static void CountCatalogItem(void *aTraitInstance, TraitDataHandle aHandle, void *aContext)
+{
+    (*(uint32_t *) aContext)++;
+}
+
+// Encode the path of a catalog item and map it back to a handle.
+static WEAVE_ERROR CatalogRoundTrip(TraitCatalogBase<TraitDataSource> &catalog, TraitDataHandle handle, TraitDataHandle &outHandle)
+{
+    WEAVE_ERROR err;
+    uint8_t buf[128];
+    TLVWriter writer;
+    TLVReader reader;
+    TLVType containerType;
+    SchemaVersionRange versionRange;
+
+    writer.Init(buf, sizeof(buf));
+
+    err = writer.StartContainer(AnonymousTag, kTLVType_Path, containerType);
+    SuccessOrExit(err);
+    err = catalog.HandleToAddress(handle, writer, versionRange);
+    SuccessOrExit(err);
+    err = writer.EndContainer(containerType);
+    SuccessOrExit(err);
+    err = writer.Finalize();
+    SuccessOrExit(err);
+
+    reader.Init(buf, writer.GetLengthWritten());
+    err = reader.Next();
+    SuccessOrExit(err);
+
+    err = catalog.AddressToHandle(reader, outHandle, versionRange);
+
+exit:
+    return err;
+}
+
+static void CheckMultiResourceTraitCatalog(nlTestSuite *inSuite, void *inContext)
+{
+    WEAVE_ERROR err;
+    MultiResourceSourceTraitCatalog catalog;
+    TestEmptyDataSource *sources = NewCatalogTestSources();
+    TraitDataHandle *handles = (TraitDataHandle *) malloc(CATALOG_TEST_NUM_ITEMS * sizeof(TraitDataHandle));
+    TraitDataHandle handle;
+    TraitDataSource *source;
+    uint32_t count;
+
+    NL_TEST_ASSERT(inSuite, sources != NULL && handles != NULL);
+    VerifyOrExit(sources != NULL && handles != NULL, );
+
+    // Lookups in an empty catalog fail.
+    NL_TEST_ASSERT(inSuite, catalog.Locate(CatalogTestResourceId(0), TestHTrait::kWeaveProfileId, 0, handle) != WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, catalog.Locate(&sources[0], handle) == WEAVE_ERROR_KEY_NOT_FOUND);
+
+    for (int i = 0; i < CATALOG_TEST_NUM_ITEMS; i++)
+    {
+        err = catalog.Add(CatalogTestResourceId(i / CATALOG_TEST_INSTANCES_PER_RESOURCE), i % CATALOG_TEST_INSTANCES_PER_RESOURCE,
+                          &sources[i], handles[i]);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    }
+
+    NL_TEST_ASSERT(inSuite, catalog.Count() == CATALOG_TEST_NUM_ITEMS);
+
+    // The same address can't be added twice.
+    err = catalog.Add(CatalogTestResourceId(1), 0, &sources[0], handle);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_DUPLICATE_KEY_ID);
+
+    for (int i = 0; i < CATALOG_TEST_NUM_ITEMS; i++)
+    {
+        err = catalog.Locate(CatalogTestResourceId(i / CATALOG_TEST_INSTANCES_PER_RESOURCE), TestHTrait::kWeaveProfileId,
+                             i % CATALOG_TEST_INSTANCES_PER_RESOURCE, handle);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && handle == handles[i]);
+
+        err = catalog.Locate(&sources[i], handle);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && handle == handles[i]);
+
+        err = catalog.Locate(handles[i], &source);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && source == &sources[i]);
+    }
+
+    // Paths without a resource map to the publisher itself.
+    for (int i = 0; i < CATALOG_TEST_NUM_ITEMS; i += 97)
+    {
+        err = CatalogRoundTrip(catalog, handles[i], handle);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && handle == handles[i]);
+    }
+
+    NL_TEST_ASSERT(inSuite, catalog.Locate(CatalogTestResourceId(CATALOG_TEST_NUM_RESOURCES), TestHTrait::kWeaveProfileId, 0,
+                                           handle) == WEAVE_ERROR_INVALID_PROFILE_ID);
+    NL_TEST_ASSERT(inSuite, catalog.Locate(CatalogTestResourceId(1), TestHTrait::kWeaveProfileId + 1, 0,
+                                           handle) == WEAVE_ERROR_INVALID_PROFILE_ID);
+
+    // Remove every third item; the rest must remain reachable.
+    for (int i = 0; i < CATALOG_TEST_NUM_ITEMS; i += 3)
+    {
+        err = catalog.Remove(handles[i]);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    }
+
+    NL_TEST_ASSERT(inSuite, catalog.Remove(handles[0]) == WEAVE_ERROR_INVALID_ARGUMENT);
+    NL_TEST_ASSERT(inSuite, catalog.Locate(handles[0], &source) == WEAVE_ERROR_INVALID_ARGUMENT);
+
+    for (int i = 0; i < CATALOG_TEST_NUM_ITEMS; i++)
+    {
+        err = catalog.Locate(&sources[i], handle);
+        NL_TEST_ASSERT(inSuite, (i % 3 == 0) ? (err == WEAVE_ERROR_KEY_NOT_FOUND) : (err == WEAVE_NO_ERROR && handle == handles[i]));
+    }
+
+    count = 0;
+    catalog.Iterate(CountCatalogItem, &count);
+    NL_TEST_ASSERT(inSuite, count == catalog.Count());
+
+    // Re-adding an item reuses a free slot.
+    err = catalog.Add(CatalogTestResourceId(0), 0, &sources[0], handle);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && handle < CATALOG_TEST_NUM_ITEMS);
+    NL_TEST_ASSERT(inSuite, catalog.Locate(&sources[0], handles[0]) == WEAVE_NO_ERROR && handles[0] == handle);
+
+    catalog.Clear();
+    NL_TEST_ASSERT(inSuite, catalog.Count() == 0);
+    NL_TEST_ASSERT(inSuite, catalog.Locate(&sources[1], handle) == WEAVE_ERROR_KEY_NOT_FOUND);
+
+exit:
+    free(handles);
+    DeleteCatalogTestSources(sources);
+}
+
+// Measure the lookup rate of the single- and multi-resource catalogs, by address (AddressToHandle) and by instance
+// pointer. The single-resource catalog holds all the items under one resource.
+static void BenchmarkTraitCatalog(TraitCatalogBase<TraitDataSource> &catalog, const char *name, TestEmptyDataSource *sources,
+                                  const uint8_t *paths, size_t pathLen)
+{
+    for (int byAddress = 1; byAddress >= 0; byAddress--)
+    {
+        BenchmarkTimer timer;
+        uint64_t totalLookups = 0;
+        uint32_t i = 0;
+
+        while (timer.Continue())
+        {
+            for (int j = 0; j < 256; j++)
+            {
+                TraitDataHandle handle;
+
+                // Step through the items in an order unrelated to their handles.
+                i = (i + 7919) % CATALOG_TEST_NUM_ITEMS;
+
+                if (byAddress)
+                {
+                    TLVReader reader;
+                    SchemaVersionRange versionRange;
+
+                    reader.Init(paths + i * pathLen, pathLen);
+                    reader.Next();
+                    catalog.AddressToHandle(reader, handle, versionRange);
+                }
+                else
+                {
+                    catalog.Locate(&sources[i], handle);
+                }
+            }
+
+            totalLookups += 256;
+        }
+
+        printf("%-15s %-16s %12.0f lookups/s\n", name, byAddress ? "AddressToHandle" : "Locate(T *)",
+               (double) totalLookups * 1000000.0 / (double) timer.ElapsedUSec());
+    }
+}
+
+static int RunTraitCatalogBenchmarks(void)
+{
+    enum { kPathLen = 32 };
+    TestEmptyDataSource *sources = NewCatalogTestSources();
+    SingleResourceSourceTraitCatalog::CatalogItem *singleStore =
+        (SingleResourceSourceTraitCatalog::CatalogItem *) malloc(CATALOG_TEST_NUM_ITEMS * sizeof(SingleResourceSourceTraitCatalog::CatalogItem));
+    SingleResourceSourceTraitCatalog singleCatalog(ResourceIdentifier(ResourceIdentifier::SELF_NODE_ID), singleStore, CATALOG_TEST_NUM_ITEMS);
+    MultiResourceSourceTraitCatalog multiCatalog;
+    uint8_t *singlePaths = (uint8_t *) calloc(CATALOG_TEST_NUM_ITEMS, kPathLen);
+    uint8_t *multiPaths = (uint8_t *) calloc(CATALOG_TEST_NUM_ITEMS, kPathLen);
+
+    if (sources == NULL || singleStore == NULL || singlePaths == NULL || multiPaths == NULL)
+        return EXIT_FAILURE;
+
+    for (int i = 0; i < CATALOG_TEST_NUM_ITEMS; i++)
+    {
+        TraitDataHandle handle;
+        SchemaVersionRange versionRange;
+        TLVWriter writer;
+        TLVType containerType;
+
+        singleCatalog.Add(i, &sources[i], handle);
+        writer.Init(singlePaths + i * kPathLen, kPathLen);
+        writer.StartContainer(AnonymousTag, kTLVType_Path, containerType);
+        singleCatalog.HandleToAddress(handle, writer, versionRange);
+        writer.EndContainer(containerType);
+        writer.Finalize();
+
+        multiCatalog.Add(CatalogTestResourceId(i / CATALOG_TEST_INSTANCES_PER_RESOURCE), i % CATALOG_TEST_INSTANCES_PER_RESOURCE,
+                         &sources[i], handle);
+        writer.Init(multiPaths + i * kPathLen, kPathLen);
+        writer.StartContainer(AnonymousTag, kTLVType_Path, containerType);
+        multiCatalog.HandleToAddress(handle, writer, versionRange);
+        writer.EndContainer(containerType);
+        writer.Finalize();
+    }
+
+    printf("Trait catalog lookup rate (%u trait instances)\n", (unsigned) CATALOG_TEST_NUM_ITEMS);
+    BenchmarkTraitCatalog(singleCatalog, "SingleResource", sources, singlePaths, kPathLen);
+    BenchmarkTraitCatalog(multiCatalog, "MultiResource", sources, multiPaths, kPathLen);
+
+    multiCatalog.Clear();
+    free(multiPaths);
+    free(singlePaths);
+    free(singleStore);
+    DeleteCatalogTestSources(sources);
+
+    return EXIT_SUCCESS;
+}
+
+static HelpOptions gHelpOptions(
+    TOOL_NAME,
+    "Usage: " TOOL_NAME " [<options...>]\n",
+    WEAVE_VERSION_STRING "\n" WEAVE_TOOL_COPYRIGHT,
+    "Unit tests for Weave TDM.\n"
+);
+
+static OptionSet *gToolOptionSets[] =
+{
+    &gBenchmarkOptions,
+    &gHelpOptions,
+    NULL
+};
+
 /**
  *  Main
  */
@@ -2271,6 +3664,30 @@ int main(int argc, char *argv[])
     MockPlatform::gMockPlatformClocks.GetClock_RealTime = Private::GetClock_RealTime;
     MockPlatform::gMockPlatformClocks.SetClock_RealTime = Private::SetClock_RealTime;
 
+    if (!ParseArgs(TOOL_NAME, argc, argv, gToolOptionSets))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    if (gBenchmarkOptions.RunBenchmarks)
+    {
+        int ret = RunTraitCatalogBenchmarks();
+
+        if (ret == EXIT_SUCCESS)
+        {
+            ret = TestSetup(NULL);
+        }
+
+        if (ret == EXIT_SUCCESS)
+        {
+            gTestTdm->BenchmarkNotifyFanOut();
+            gTestTdm->BenchmarkSnapshotPriming();
+            ret = TestTeardown(NULL);
+        }
+
+        return ret;
+    }
+
     nlTestSuite theSuite = {
         "weave-tdm",
         &sTests[0],
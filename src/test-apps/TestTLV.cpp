@@ -29,7 +29,9 @@
 
 #include <Weave/Core/WeaveCore.h>
 #include <Weave/Core/WeaveTLV.h>
+#include <Weave/Core/WeaveTLVArena.h>
 #include <Weave/Core/WeaveTLVDebug.hpp>
+#include <Weave/Core/WeaveTLVIndex.h>
 #include <Weave/Core/WeaveTLVUtilities.hpp>
 #include <Weave/Core/WeaveTLVData.hpp>
 #include <Weave/Core/WeaveCircularTLVBuffer.h>
@@ -2013,6 +2015,90 @@ void CheckCircularTLVBufferEvictStraddlingEvent(nlTestSuite *inSuite, void *inCo
     TestEnd<TLVReader>(inSuite, reader);
 }
 
+void CheckCircularTLVBufferCopyHead(nlTestSuite *inSuite, void *inContext)
+{
+    // Copy head elements of one circular buffer to another, wrapping
+    // around the end of either buffer.
+
+    TestTLVContext *context = static_cast<TestTLVContext *>(inContext);
+    WEAVE_ERROR err;
+    uint8_t backingStore[30];
+    uint8_t backingStore1[16];
+    CircularTLVWriter writer;
+    CircularTLVReader reader;
+    WeaveCircularTLVBuffer buffer(backingStore, sizeof(backingStore));
+    WeaveCircularTLVBuffer buffer1(backingStore1, sizeof(backingStore1));
+
+    context->mEvictionCount = 0;
+    context->mEvictedBytes = 0;
+
+    buffer.mProcessEvictedElement = CountEvictedMembers;
+    buffer.mAppData = inContext;
+
+    // As in the simple test, leave 2 instances of Encoding3 in the
+    // buffer, the second one straddling its end.
+    writer.Init(&buffer);
+    writer.ImplicitProfileId = TestProfile_2;
+
+    writer.PutBoolean(ProfileTag(TestProfile_1, 2), true);
+
+    WriteEncoding3(inSuite, writer);
+
+    WriteEncoding3(inSuite, writer);
+
+    WriteEncoding3(inSuite, writer);
+
+    NL_TEST_ASSERT(inSuite, buffer.DataLength() == 22);
+
+    // Move the head of the destination to its middle.
+    writer.Init(&buffer1);
+    writer.ImplicitProfileId = TestProfile_2;
+
+    err = writer.PutBoolean(ProfileTag(TestProfile_1, 2), true);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    err = writer.Finalize();
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    err = buffer1.EvictHead();
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    err = buffer.CopyHead(buffer1, buffer.DataLength() + 1);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_ARGUMENT);
+
+    err = buffer.CopyHead(buffer1, buffer.DataLength());
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_NO_MEMORY);
+    NL_TEST_ASSERT(inSuite, buffer1.DataLength() == 0);
+
+    // Copy the first instance, which wraps around the end of the
+    // destination, then the second one, which wraps around the end of
+    // the source.
+    err = buffer.CopyHead(buffer1, 11);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, buffer.DataLength() == 22);
+    NL_TEST_ASSERT(inSuite, buffer1.DataLength() == 11);
+
+    buffer.mProcessEvictedElement = NULL;
+    err = buffer.EvictHead();
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    err = buffer1.EvictHead();
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    err = buffer.CopyHead(buffer1, 11);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, buffer1.DataLength() == 11);
+
+    reader.Init(&buffer1);
+    reader.ImplicitProfileId = TestProfile_2;
+
+    TestNext<TLVReader>(inSuite, reader);
+
+    ReadEncoding3(inSuite, reader);
+
+    TestEnd<TLVReader>(inSuite, reader);
+}
+
 void CheckCircularTLVBufferEdge(nlTestSuite *inSuite, void *inContext)
 {
     TestTLVContext *context = static_cast<TestTLVContext *>(inContext);
@@ -3005,6 +3091,249 @@ void CheckWeaveTLVReader(nlTestSuite *inSuite, void *inContext)
     TestWeaveTLVReader_SkipOverContainer(inSuite);
 }
 
+static void CountElement(nlTestSuite *inSuite, TLVReader& reader, void *context)
+{
+    (*(uint32_t *) context)++;
+}
+
+void TestWeaveTLVIndex_SkipOverContainer_ProcessElement(nlTestSuite *inSuite, TLVReader& reader, void *context)
+{
+    WEAVE_ERROR err, nextRes1, nextRes2;
+
+    // If the current element is a container...
+    if (TLVTypeIsContainer(reader.GetType()))
+    {
+        // Make two copies of the reader, only one of which uses the index.
+        TLVReader readerClone1 = reader;
+        TLVReader readerClone2 = reader;
+
+        readerClone1.SetIndex(NULL);
+        NL_TEST_ASSERT(inSuite, readerClone2.GetIndex() == context);
+
+        err = readerClone1.Skip();
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        err = readerClone2.Skip();
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        NL_TEST_ASSERT(inSuite, readerClone1.GetReadPoint() == readerClone2.GetReadPoint());
+        NL_TEST_ASSERT(inSuite, readerClone1.GetLengthRead() == readerClone2.GetLengthRead());
+
+        nextRes1 = readerClone1.Next();
+        nextRes2 = readerClone2.Next();
+        NL_TEST_ASSERT(inSuite, nextRes1 == nextRes2);
+        NL_TEST_ASSERT(inSuite, readerClone1.GetType() == readerClone2.GetType());
+        NL_TEST_ASSERT(inSuite, readerClone1.GetTag() == readerClone2.GetTag());
+    }
+}
+
+/**
+ *  Test Weave TLV Index
+ */
+static void CheckWeaveTLVIndex(nlTestSuite *inSuite, void *inContext)
+{
+    WEAVE_ERROR err;
+    TLVIndex index;
+    TLVIndex::Entry entries[32];
+    TLVReader reader;
+    uint32_t elemCount = 0;
+
+    // Index Encoding1 and check it against what the reader finds.
+    index.Init(entries, sizeof(entries) / sizeof(entries[0]));
+    err = index.Build(Encoding1, sizeof(Encoding1));
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    reader.Init(Encoding1, sizeof(Encoding1));
+    reader.ImplicitProfileId = TestProfile_2;
+    ForEachElement(inSuite, reader, &elemCount, CountElement);
+
+    NL_TEST_ASSERT(inSuite, index.GetEntryCount() == elemCount);
+    NL_TEST_ASSERT(inSuite, entries[0].Offset == 0 && entries[0].End == sizeof(Encoding1));
+    NL_TEST_ASSERT(inSuite, index.Find(Encoding1) == &entries[0]);
+    NL_TEST_ASSERT(inSuite, index.Find((uint32_t) 1) == NULL);
+    NL_TEST_ASSERT(inSuite, index.Find(Encoding1 + sizeof(Encoding1)) == NULL);
+
+    // Read Encoding1 through an indexed reader.
+    reader.Init(Encoding1, sizeof(Encoding1));
+    reader.ImplicitProfileId = TestProfile_2;
+    reader.SetIndex(&index);
+    ReadEncoding1(inSuite, reader);
+
+    // Skip every container with and without the index.
+    reader.Init(Encoding1, sizeof(Encoding1));
+    reader.ImplicitProfileId = TestProfile_2;
+    reader.SetIndex(&index);
+    ForEachElement(inSuite, reader, &index, TestWeaveTLVIndex_SkipOverContainer_ProcessElement);
+
+    // Exit the outer structure right after entering it; the nested containers are jumped over.
+    {
+        TLVType outerContainerType;
+
+        reader.Init(Encoding1, sizeof(Encoding1));
+        reader.SetIndex(&index);
+        reader.ImplicitProfileId = TestProfile_2;
+        TestNext<TLVReader>(inSuite, reader);
+        TestAndEnterContainer<TLVReader>(inSuite, reader, kTLVType_Structure, ProfileTag(TestProfile_1, 1), outerContainerType);
+        err = reader.ExitContainer(outerContainerType);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        NL_TEST_ASSERT(inSuite, reader.GetReadPoint() == Encoding1 + sizeof(Encoding1));
+    }
+
+    // An index over other data is ignored.
+    {
+        uint8_t copy[sizeof(Encoding1)];
+
+        memcpy(copy, Encoding1, sizeof(copy));
+        reader.Init(copy, sizeof(copy));
+        reader.ImplicitProfileId = TestProfile_2;
+        reader.SetIndex(&index);
+        ReadEncoding1(inSuite, reader);
+    }
+
+    // Malformed and oversized encodings.
+    {
+        static const uint8_t sStrayEnd[]        = { 0x04, 0x01, 0x18 };
+        static const uint8_t sTaggedInArray[]   = { 0x16, 0x24, 0x01, 0x02, 0x18 };
+        static const uint8_t sAnonInStruct[]    = { 0x15, 0x04, 0x02, 0x18 };
+        static const uint8_t sContextTopLevel[] = { 0x24, 0x01, 0x02 };
+        static const uint8_t sBadType[]         = { 0x15, 0x39, 0x01, 0x18 };
+        static const uint8_t sLongString[]      = { 0x0C, 0x05, 'a', 'b', 'c' };
+        static const uint8_t sOpenContainer[]   = { 0x16, 0x04, 0x01 };
+
+        err = index.Build(sStrayEnd, sizeof(sStrayEnd));
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_TLV_ELEMENT);
+        err = index.Build(sTaggedInArray, sizeof(sTaggedInArray));
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_TLV_TAG);
+        err = index.Build(sAnonInStruct, sizeof(sAnonInStruct));
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_TLV_TAG);
+        err = index.Build(sContextTopLevel, sizeof(sContextTopLevel));
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_TLV_TAG);
+        err = index.Build(sBadType, sizeof(sBadType));
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_TLV_ELEMENT);
+        err = index.Build(sLongString, sizeof(sLongString));
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_TLV_UNDERRUN);
+        err = index.Build(sOpenContainer, sizeof(sOpenContainer));
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_TLV_UNDERRUN);
+        err = index.Build(Encoding1, sizeof(Encoding1) - 1);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_TLV_UNDERRUN);
+        NL_TEST_ASSERT(inSuite, index.GetEntryCount() == 0);
+
+        index.Init(entries, elemCount - 1);
+        err = index.Build(Encoding1, sizeof(Encoding1));
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_BUFFER_TOO_SMALL);
+    }
+}
+
+/**
+ *  Test Weave TLV Arena
+ */
+static void CheckWeaveTLVArena(nlTestSuite *inSuite, void *inContext)
+{
+    WEAVE_ERROR err;
+    WeaveTLVArena arena;
+    ArenaTLVWriter writer;
+    ArenaTLVWriter::Checkpoint checkpoint;
+    TLVReader reader;
+    TLVType outerContainerType;
+    uint32_t capacity;
+
+    err = arena.Init(32, 16);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_ARGUMENT);
+
+    // Write Encoding1 into an arena that starts too small to hold it.
+    err = arena.Init(16, 4096);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    writer.Init(&arena);
+    writer.ImplicitProfileId = TestProfile_2;
+    WriteEncoding1(inSuite, writer);
+
+    NL_TEST_ASSERT(inSuite, arena.Capacity() > 16);
+    NL_TEST_ASSERT(inSuite, arena.DataLength() == sizeof(Encoding1));
+    NL_TEST_ASSERT(inSuite, writer.GetLengthWritten() == sizeof(Encoding1));
+    NL_TEST_ASSERT(inSuite, memcmp(arena.Start(), Encoding1, sizeof(Encoding1)) == 0);
+
+    reader.Init(arena.Start(), arena.DataLength());
+    reader.ImplicitProfileId = TestProfile_2;
+    ReadEncoding1(inSuite, reader);
+
+    // Slice the encoding into small PacketBuffers.
+    {
+        uint32_t offset = 0;
+        PacketBuffer *buf;
+
+        while (true)
+        {
+            uint32_t sliceStart = offset;
+
+            buf = PacketBuffer::New(0);
+            err = arena.CopyToPacketBuffer(offset, buf, 10);
+            if (err == WEAVE_END_OF_INPUT)
+            {
+                PacketBuffer::Free(buf);
+                break;
+            }
+            NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+            NL_TEST_ASSERT(inSuite, buf->DataLength() == offset - sliceStart);
+            NL_TEST_ASSERT(inSuite, buf->DataLength() == 10 || offset == sizeof(Encoding1));
+            NL_TEST_ASSERT(inSuite, memcmp(buf->Start(), Encoding1 + sliceStart, buf->DataLength()) == 0);
+            PacketBuffer::Free(buf);
+        }
+        NL_TEST_ASSERT(inSuite, offset == sizeof(Encoding1));
+
+        offset = sizeof(Encoding1) + 1;
+        buf = PacketBuffer::New(0);
+        err = arena.CopyToPacketBuffer(offset, buf, 10);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_ARGUMENT);
+        PacketBuffer::Free(buf);
+    }
+
+    // Roll back over writes that grew the arena.  The reused arena keeps its storage.
+    arena.Reset();
+    capacity = arena.Capacity();
+
+    writer.Init(&arena);
+    err = writer.StartContainer(AnonymousTag, kTLVType_Array, outerContainerType);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    err = writer.Put(AnonymousTag, (uint8_t) 1);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    writer.GetCheckpoint(checkpoint);
+
+    for (int i = 0; i < 4; i++)
+    {
+        err = writer.PutString(AnonymousTag, sLargeString);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    }
+    NL_TEST_ASSERT(inSuite, arena.Capacity() > capacity);
+
+    writer.Rollback(checkpoint);
+
+    err = writer.Put(AnonymousTag, (uint8_t) 2);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    err = writer.EndContainer(outerContainerType);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    err = writer.Finalize();
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    {
+        static const uint8_t sExpected[] = { 0x16, 0x04, 0x01, 0x04, 0x02, 0x18 };
+
+        NL_TEST_ASSERT(inSuite, arena.DataLength() == sizeof(sExpected));
+        NL_TEST_ASSERT(inSuite, writer.GetLengthWritten() == sizeof(sExpected));
+        NL_TEST_ASSERT(inSuite, memcmp(arena.Start(), sExpected, sizeof(sExpected)) == 0);
+    }
+
+    // The arena does not grow past its maximum size.
+    err = arena.Init(0, 64);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    writer.Init(&arena);
+    err = writer.PutString(AnonymousTag, sLargeString);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_BUFFER_TOO_SMALL);
+    NL_TEST_ASSERT(inSuite, arena.Capacity() == 64);
+
+    arena.Shutdown();
+}
+
 /**
  *  Test Weave TLV Items
  */
@@ -3523,6 +3852,8 @@ static void TLVReaderFuzzTest(nlTestSuite *inSuite, void *inContext)
 {
     time_t now, endTime;
     uint8_t fuzzedData[sizeof(Encoding1)];
+    TLVIndex index;
+    static TLVIndex::Entry sIndexEntries[sizeof(Encoding1)];
 
     static uint8_t sFixedFuzzVals[] =
     {
@@ -3591,6 +3922,18 @@ static void TLVReaderFuzzTest(nlTestSuite *inSuite, void *inContext)
                 ExitNow();
             }
 
+            // Where the mutated encoding is still well-formed, reading it through an index must
+            // give the same result.
+            index.Init(sIndexEntries, sizeof(sIndexEntries) / sizeof(sIndexEntries[0]));
+            if (index.Build(fuzzedData, sizeof(fuzzedData)) == WEAVE_NO_ERROR)
+            {
+                reader.Init(fuzzedData, sizeof(fuzzedData));
+                reader.ImplicitProfileId = TestProfile_2;
+                reader.SetIndex(&index);
+
+                NL_TEST_ASSERT(inSuite, ReadFuzzedEncoding1(inSuite, reader) == readRes);
+            }
+
             time(&now);
             if (now >= endTime)
                 ExitNow();
@@ -3606,6 +3949,352 @@ exit:
     return;
 }
 
+// Number of records in the encoding used by the index benchmark.
+#define INDEX_BENCHMARK_RECORD_COUNT 20000
+
+typedef WEAVE_ERROR (*IndexBenchmarkFunct)(const uint8_t *data, uint32_t dataLen, TLVIndex& index, bool useIndex);
+
+// Write a record shaped like typical trait data: a few scalars, a string, and nested containers.
+static WEAVE_ERROR WriteBenchmarkRecord(TLVWriter& writer, uint32_t i)
+{
+    WEAVE_ERROR err;
+    TLVType recordType, innerType, leafType;
+
+    err = writer.StartContainer(AnonymousTag, kTLVType_Structure, recordType);
+    SuccessOrExit(err);
+
+    err = writer.Put(ContextTag(1), i);
+    SuccessOrExit(err);
+    err = writer.PutString(ContextTag(2), "temperature-sensor");
+    SuccessOrExit(err);
+
+    err = writer.StartContainer(ContextTag(3), kTLVType_Array, innerType);
+    SuccessOrExit(err);
+    for (uint32_t j = 0; j < 8; j++)
+    {
+        err = writer.Put(AnonymousTag, i * j);
+        SuccessOrExit(err);
+    }
+    err = writer.EndContainer(innerType);
+    SuccessOrExit(err);
+
+    err = writer.StartContainer(ContextTag(4), kTLVType_Structure, innerType);
+    SuccessOrExit(err);
+    err = writer.Put(ContextTag(1), (int16_t) -(int32_t) (i & 0x7FFF));
+    SuccessOrExit(err);
+    err = writer.PutBoolean(ContextTag(2), (i & 1) != 0);
+    SuccessOrExit(err);
+    err = writer.Put(ContextTag(3), (float) i / 10);
+    SuccessOrExit(err);
+    for (uint32_t j = 0; j < 2; j++)
+    {
+        err = writer.StartContainer(ContextTag(4 + j), kTLVType_Structure, leafType);
+        SuccessOrExit(err);
+        err = writer.Put(ContextTag(1), (uint64_t) i << 32);
+        SuccessOrExit(err);
+        err = writer.PutBytes(ContextTag(2), (const uint8_t *) sLargeString, 16);
+        SuccessOrExit(err);
+        err = writer.EndContainer(leafType);
+        SuccessOrExit(err);
+    }
+    err = writer.EndContainer(innerType);
+    SuccessOrExit(err);
+
+    err = writer.EndContainer(recordType);
+
+exit:
+    return err;
+}
+
+// Write an array of benchmark records.
+static WEAVE_ERROR WriteIndexBenchmarkEncoding(uint8_t *buf, uint32_t bufSize, uint32_t& encodingLen)
+{
+    WEAVE_ERROR err;
+    TLVWriter writer;
+    TLVType arrayType;
+
+    writer.Init(buf, bufSize);
+
+    err = writer.StartContainer(AnonymousTag, kTLVType_Array, arrayType);
+    SuccessOrExit(err);
+
+    for (uint32_t i = 0; i < INDEX_BENCHMARK_RECORD_COUNT; i++)
+    {
+        err = WriteBenchmarkRecord(writer, i);
+        SuccessOrExit(err);
+    }
+
+    err = writer.EndContainer(arrayType);
+    SuccessOrExit(err);
+
+    err = writer.Finalize();
+    SuccessOrExit(err);
+
+    encodingLen = writer.GetLengthWritten();
+
+exit:
+    return err;
+}
+
+static WEAVE_ERROR BenchmarkBuildIndex(const uint8_t *data, uint32_t dataLen, TLVIndex& index, bool useIndex)
+{
+    return index.Build(data, dataLen);
+}
+
+// Step over every record with Next().
+static WEAVE_ERROR BenchmarkSkipRecords(const uint8_t *data, uint32_t dataLen, TLVIndex& index, bool useIndex)
+{
+    WEAVE_ERROR err;
+    TLVReader reader;
+    TLVType outerContainerType;
+
+    reader.Init(data, dataLen);
+    reader.SetIndex(useIndex ? &index : NULL);
+
+    err = reader.Next();
+    SuccessOrExit(err);
+    err = reader.EnterContainer(outerContainerType);
+    SuccessOrExit(err);
+
+    while ((err = reader.Next()) == WEAVE_NO_ERROR)
+        ;
+    VerifyOrExit(err == WEAVE_END_OF_TLV, );
+
+    err = reader.ExitContainer(outerContainerType);
+
+exit:
+    return err;
+}
+
+// Read the first field of every record, then exit it.
+static WEAVE_ERROR BenchmarkPickField(const uint8_t *data, uint32_t dataLen, TLVIndex& index, bool useIndex)
+{
+    WEAVE_ERROR err;
+    TLVReader reader;
+    TLVType arrayType, recordType;
+    uint32_t val;
+
+    reader.Init(data, dataLen);
+    reader.SetIndex(useIndex ? &index : NULL);
+
+    err = reader.Next();
+    SuccessOrExit(err);
+    err = reader.EnterContainer(arrayType);
+    SuccessOrExit(err);
+
+    while ((err = reader.Next()) == WEAVE_NO_ERROR)
+    {
+        err = reader.EnterContainer(recordType);
+        SuccessOrExit(err);
+        err = reader.Next(kTLVType_UnsignedInteger, ContextTag(1));
+        SuccessOrExit(err);
+        err = reader.Get(val);
+        SuccessOrExit(err);
+        err = reader.ExitContainer(recordType);
+        SuccessOrExit(err);
+    }
+    VerifyOrExit(err == WEAVE_END_OF_TLV, );
+
+    err = reader.ExitContainer(arrayType);
+
+exit:
+    return err;
+}
+
+static void RunIndexBenchmark(const char *name, IndexBenchmarkFunct funct, const uint8_t *data, uint32_t dataLen,
+                              TLVIndex& index, bool useIndex)
+{
+    BenchmarkTimer timer;
+    uint64_t totalLen = 0;
+
+    do
+    {
+        if (funct(data, dataLen, index, useIndex) != WEAVE_NO_ERROR)
+        {
+            printf("%-32s failed\n", name);
+            return;
+        }
+        totalLen += dataLen;
+    } while (timer.Continue());
+
+    printf("%-32s %10.1f MB/s\n", name, (double) totalLen / (double) timer.ElapsedUSec());
+}
+
+// Compare stepping over containers with and without a TLVIndex, and the cost of building one.
+static void BenchmarkTLVIndex(void)
+{
+    const uint32_t bufSize = INDEX_BENCHMARK_RECORD_COUNT * 160;
+    const uint32_t maxEntries = INDEX_BENCHMARK_RECORD_COUNT * 24 + 1;
+    uint8_t *buf = (uint8_t *) malloc(bufSize);
+    TLVIndex::Entry *entries = (TLVIndex::Entry *) malloc(maxEntries * sizeof(TLVIndex::Entry));
+    TLVIndex index;
+    uint32_t encodingLen;
+
+    VerifyOrExit(buf != NULL && entries != NULL, );
+    VerifyOrExit(WriteIndexBenchmarkEncoding(buf, bufSize, encodingLen) == WEAVE_NO_ERROR, );
+
+    index.Init(entries, maxEntries);
+    VerifyOrExit(index.Build(buf, encodingLen) == WEAVE_NO_ERROR, );
+
+    printf("TLVIndex benchmark: %u records, %u bytes, %u elements\n", (unsigned) INDEX_BENCHMARK_RECORD_COUNT,
+           (unsigned) encodingLen, (unsigned) index.GetEntryCount());
+
+    RunIndexBenchmark("build index", BenchmarkBuildIndex, buf, encodingLen, index, true);
+    RunIndexBenchmark("skip records", BenchmarkSkipRecords, buf, encodingLen, index, false);
+    RunIndexBenchmark("skip records, indexed", BenchmarkSkipRecords, buf, encodingLen, index, true);
+    RunIndexBenchmark("pick field", BenchmarkPickField, buf, encodingLen, index, false);
+    RunIndexBenchmark("pick field, indexed", BenchmarkPickField, buf, encodingLen, index, true);
+
+exit:
+    free(entries);
+    free(buf);
+}
+
+// Number of records in the message used by the writer benchmark.
+#define WRITER_BENCHMARK_RECORD_COUNT 64
+
+// Payload size of each PacketBuffer an arena is sliced into when it is sent.
+#define WRITER_BENCHMARK_SLICE_LEN 1232
+
+typedef WEAVE_ERROR (*WriterBenchmarkFunct)(WeaveTLVArena& arena, uint32_t& messageLen);
+
+// Write the message into a chain of PacketBuffers, allocated as the writer needs them.
+static WEAVE_ERROR BenchmarkPacketBufferWriter(WeaveTLVArena& arena, uint32_t& messageLen)
+{
+    WEAVE_ERROR err;
+    PacketBuffer *buf = PacketBuffer::New(0);
+    TLVWriter writer;
+    TLVType arrayType;
+
+    VerifyOrExit(buf != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+    writer.Init(buf, 0xFFFFFFFFUL, true);
+
+    err = writer.StartContainer(AnonymousTag, kTLVType_Array, arrayType);
+    SuccessOrExit(err);
+
+    for (uint32_t i = 0; i < WRITER_BENCHMARK_RECORD_COUNT; i++)
+    {
+        err = WriteBenchmarkRecord(writer, i);
+        SuccessOrExit(err);
+    }
+
+    err = writer.EndContainer(arrayType);
+    SuccessOrExit(err);
+
+    err = writer.Finalize();
+    SuccessOrExit(err);
+
+    messageLen = writer.GetLengthWritten();
+
+exit:
+    if (buf != NULL)
+        PacketBuffer::Free(buf);
+    return err;
+}
+
+// Write the message into a reused arena, optionally taking a checkpoint before each record, then
+// slice it into PacketBuffers as it would be sent.
+static WEAVE_ERROR BenchmarkArenaWriter(WeaveTLVArena& arena, uint32_t& messageLen, bool checkpointRecords)
+{
+    WEAVE_ERROR err;
+    ArenaTLVWriter writer;
+    ArenaTLVWriter::Checkpoint checkpoint;
+    TLVType arrayType;
+    uint32_t offset = 0;
+
+    arena.Reset();
+    writer.Init(&arena);
+
+    err = writer.StartContainer(AnonymousTag, kTLVType_Array, arrayType);
+    SuccessOrExit(err);
+
+    for (uint32_t i = 0; i < WRITER_BENCHMARK_RECORD_COUNT; i++)
+    {
+        if (checkpointRecords)
+            writer.GetCheckpoint(checkpoint);
+
+        err = WriteBenchmarkRecord(writer, i);
+        SuccessOrExit(err);
+    }
+
+    err = writer.EndContainer(arrayType);
+    SuccessOrExit(err);
+
+    err = writer.Finalize();
+    SuccessOrExit(err);
+
+    messageLen = writer.GetLengthWritten();
+
+    while (true)
+    {
+        PacketBuffer *buf = PacketBuffer::New(0);
+
+        VerifyOrExit(buf != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        err = arena.CopyToPacketBuffer(offset, buf, WRITER_BENCHMARK_SLICE_LEN);
+        PacketBuffer::Free(buf);
+        if (err == WEAVE_END_OF_INPUT)
+            break;
+        SuccessOrExit(err);
+    }
+
+    err = WEAVE_NO_ERROR;
+
+exit:
+    return err;
+}
+
+static WEAVE_ERROR BenchmarkArenaWriter(WeaveTLVArena& arena, uint32_t& messageLen)
+{
+    return BenchmarkArenaWriter(arena, messageLen, false);
+}
+
+static WEAVE_ERROR BenchmarkArenaWriterCheckpoints(WeaveTLVArena& arena, uint32_t& messageLen)
+{
+    return BenchmarkArenaWriter(arena, messageLen, true);
+}
+
+static void RunWriterBenchmark(const char *name, WriterBenchmarkFunct funct, WeaveTLVArena& arena)
+{
+    BenchmarkTimer timer;
+    uint64_t totalLen = 0;
+    uint32_t messageLen;
+
+    do
+    {
+        if (funct(arena, messageLen) != WEAVE_NO_ERROR)
+        {
+            printf("%-32s failed\n", name);
+            return;
+        }
+        totalLen += messageLen;
+    } while (timer.Continue());
+
+    printf("%-32s %10.1f MB/s\n", name, (double) totalLen / (double) timer.ElapsedUSec());
+}
+
+// Compare encoding a multi-buffer message into a chain of PacketBuffers with encoding it into an
+// arena and slicing it into PacketBuffers afterwards.
+static void BenchmarkTLVArena(void)
+{
+    WeaveTLVArena arena;
+    uint32_t messageLen;
+
+    VerifyOrExit(arena.Init(0, 0xFFFFFFFFUL) == WEAVE_NO_ERROR, );
+    VerifyOrExit(BenchmarkArenaWriter(arena, messageLen) == WEAVE_NO_ERROR, );
+
+    printf("TLV writer benchmark: %u records, %u bytes, %u byte slices\n", (unsigned) WRITER_BENCHMARK_RECORD_COUNT,
+           (unsigned) messageLen, (unsigned) WRITER_BENCHMARK_SLICE_LEN);
+
+    RunWriterBenchmark("packet buffer chain", BenchmarkPacketBufferWriter, arena);
+    RunWriterBenchmark("arena, sliced", BenchmarkArenaWriter, arena);
+    RunWriterBenchmark("arena, sliced, checkpoints", BenchmarkArenaWriterCheckpoints, arena);
+
+exit:
+    arena.Shutdown();
+}
+
 // Test Suite
 
 /**
@@ -3621,12 +4310,15 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("Weave TLV Basics",                    CheckWeaveTLVBasics),
     NL_TEST_DEF("Weave TLV Writer",                    CheckWeaveTLVWriter),
     NL_TEST_DEF("Weave TLV Reader",                    CheckWeaveTLVReader),
+    NL_TEST_DEF("Weave TLV Index",                     CheckWeaveTLVIndex),
+    NL_TEST_DEF("Weave TLV Arena",                     CheckWeaveTLVArena),
     NL_TEST_DEF("Weave TLV Utilities",                 CheckWeaveTLVUtilities),
     NL_TEST_DEF("Weave TLV Updater",                   CheckWeaveUpdater),
     NL_TEST_DEF("Weave TLV Empty Find",                CheckWeaveTLVEmptyFind),
     NL_TEST_DEF("Weave Circular TLV buffer, simple",   CheckCircularTLVBufferSimple),
     NL_TEST_DEF("Weave Circular TLV buffer, straddle", CheckCircularTLVBufferEvictStraddlingEvent),
     NL_TEST_DEF("Weave Circular TLV buffer, edge",     CheckCircularTLVBufferEdge),
+    NL_TEST_DEF("Weave Circular TLV buffer, copy head", CheckCircularTLVBufferCopyHead),
     NL_TEST_DEF("Weave TLV Printf",                    CheckWeaveTLVPutStringF),
     NL_TEST_DEF("Weave TLV Printf, Circular TLV buf",  CheckWeaveTLVPutStringFCircular),
     NL_TEST_DEF("Weave TLV Skip non-contiguous",       CheckWeaveTLVSkipCircular),
@@ -3685,6 +4377,7 @@ static HelpOptions gHelpOptions(
 static OptionSet *gToolOptionSets[] =
 {
     &gToolOptions,
+    &gBenchmarkOptions,
     &gHelpOptions,
     NULL
 };
@@ -3737,6 +4430,13 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
+    if (gBenchmarkOptions.RunBenchmarks)
+    {
+        BenchmarkTLVIndex();
+        BenchmarkTLVArena();
+        return EXIT_SUCCESS;
+    }
+
     context.mSuite = &theSuite;
 
     // Generate machine-readable, comma-separated value (CSV) output.
@@ -117,6 +117,7 @@ class WdmUpdateEncoderTest {
         void TestTwoProperties(nlTestSuite *inSuite, void *inContext);
         void TestDictionaryElements(nlTestSuite *inSuite, void *inContext);
         void TestStructure(nlTestSuite *inSuite, void *inContext);
+        void TestPackedLeaves(nlTestSuite *inSuite, void *inContext);
         void TestOverflowDictionary(nlTestSuite *inSuite, void *inContext);
         void TestOverflowRoot(nlTestSuite *inSuite, void *inContext);
         void TestDataElementTooBig(nlTestSuite *inSuite, void *inContext);
@@ -274,6 +275,12 @@ void WdmUpdateEncoderTest::VerifyDataList(nlTestSuite *inSuite, PacketBuffer *aB
             i < firstItemNotEncoded;
             i = mPathList.GetNextValidItem(i))
     {
+        if (mPathList.AreFlagsSet(i, SubscriptionClient::kFlag_PackedWithPrevious))
+        {
+            // Encoded in the same DataElement as the previous item.
+            continue;
+        }
+
         count++;
 
         mPathList.GetItemAt(i, tp);
@@ -313,6 +320,13 @@ void WdmUpdateEncoderTest::VerifyDataList(nlTestSuite *inSuite, PacketBuffer *aB
             // that is, the path points to its parent.
             tp.mPropertyPathHandle = dataSink->GetSchemaEngine()->GetParent(tp.mPropertyPathHandle);
         }
+        else if (dataSink->GetSchemaEngine()->IsLeaf(tp.mPropertyPathHandle) &&
+                pathHandle == dataSink->GetSchemaEngine()->GetParent(tp.mPropertyPathHandle))
+        {
+            // Leaves packed together are merged into their parent; when the payload
+            // is full, the DataElement can end up holding just one of them.
+            tp.mPropertyPathHandle = pathHandle;
+        }
 
         NL_TEST_ASSERT(inSuite, pathHandle == tp.mPropertyPathHandle);
     }
@@ -469,6 +483,82 @@ void WdmUpdateEncoderTest::TestStructure(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, 1 == mPathList.GetNumItems());
 }
 
+void WdmUpdateEncoderTest::TestPackedLeaves(nlTestSuite *inSuite, void *inContext)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    const PropertyPathHandle leaves[] = {
+        CreatePropertyPathHandle(TestATrait::kPropertyHandle_TaA),
+        CreatePropertyPathHandle(TestATrait::kPropertyHandle_TaB),
+        CreatePropertyPathHandle(TestATrait::kPropertyHandle_TaC),
+        CreatePropertyPathHandle(TestATrait::kPropertyHandle_TaD_SaA),
+        CreatePropertyPathHandle(TestATrait::kPropertyHandle_TaD_SaB),
+    };
+
+    PRINT_TEST_NAME();
+
+    PacketBuffer::Free(mBuf);
+    mBuf = PacketBuffer::New(0);
+
+    SetupTest();
+
+    uint16_t available = mBuf->AvailableDataLength();
+
+    for (size_t i = 0; i < ArraySize(leaves); i++)
+    {
+        mTP = { mTraitHandleSet[kTestATraitSink0Index], leaves[i] };
+
+        err = mPathList.AddItem(mTP);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    }
+
+    BasicTestBody(inSuite);
+
+    // The leaves of the root go in one DataElement, the leaves of ta_d in another one.
+    NL_TEST_ASSERT(inSuite, 2 == mContext.mNumDataElementsAddedToPayload);
+    NL_TEST_ASSERT(inSuite, false == mPathList.AreFlagsSet(0, SubscriptionClient::kFlag_PackedWithPrevious));
+    NL_TEST_ASSERT(inSuite, mPathList.AreFlagsSet(1, SubscriptionClient::kFlag_PackedWithPrevious));
+    NL_TEST_ASSERT(inSuite, mPathList.AreFlagsSet(2, SubscriptionClient::kFlag_PackedWithPrevious));
+    NL_TEST_ASSERT(inSuite, false == mPathList.AreFlagsSet(3, SubscriptionClient::kFlag_PackedWithPrevious));
+    NL_TEST_ASSERT(inSuite, mPathList.AreFlagsSet(4, SubscriptionClient::kFlag_PackedWithPrevious));
+
+    uint16_t encodedLen = mBuf->TotalLength();
+
+    // Shrink the payload one byte at a time: the leaves that do not fit
+    // are left for the next payload.
+
+    for (uint16_t reserved = (available - encodedLen + 1); reserved < available; reserved++)
+    {
+        SetupTest();
+
+        for (size_t i = 0; i < ArraySize(leaves); i++)
+        {
+            mTP = { mTraitHandleSet[kTestATraitSink0Index], leaves[i] };
+
+            err = mPathList.AddItem(mTP);
+            NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        }
+
+        PacketBuffer::Free(mBuf);
+        mBuf = PacketBuffer::New(reserved);
+        NL_TEST_ASSERT(inSuite, NULL != mBuf);
+
+        InitEncoderContext(inSuite);
+
+        err = mEncoder.EncodeRequest(mContext);
+
+        if (err == WEAVE_ERROR_BUFFER_TOO_SMALL)
+        {
+            break;
+        }
+
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        NL_TEST_ASSERT(inSuite, mContext.mItemInProgress > 0);
+        NL_TEST_ASSERT(inSuite, mContext.mItemInProgress < mPathList.GetPathStoreSize());
+
+        VerifyDataList(inSuite, mBuf);
+    }
+}
+
 void WdmUpdateEncoderTest::TestOverflowDictionary(nlTestSuite *inSuite, void *inContext)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
@@ -1075,6 +1165,11 @@ void WdmUpdateEncoderTest_Structure(nlTestSuite *inSuite, void *inContext)
     gWdmUpdateEncoderTest.TestStructure(inSuite, inContext);
 }
 
+void WdmUpdateEncoderTest_PackedLeaves(nlTestSuite *inSuite, void *inContext)
+{
+    gWdmUpdateEncoderTest.TestPackedLeaves(inSuite, inContext);
+}
+
 void WdmUpdateEncoderTest_OverflowDictionary(nlTestSuite *inSuite, void *inContext)
 {
     gWdmUpdateEncoderTest.TestOverflowDictionary(inSuite, inContext);
@@ -1118,6 +1213,7 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("Encode two properties",  WdmUpdateEncoderTest_TwoProperties),
     NL_TEST_DEF("Encode dictionary elements",  WdmUpdateEncoderTest_DictionaryElements),
     NL_TEST_DEF("Encode structure",  WdmUpdateEncoderTest_Structure),
+    NL_TEST_DEF("Encode leaves packed in their parent",  WdmUpdateEncoderTest_PackedLeaves),
     NL_TEST_DEF("Encode overflowing dictionary",  WdmUpdateEncoderTest_OverflowDictionary),
     NL_TEST_DEF("Encode overflowing root DE",  WdmUpdateEncoderTest_OverflowRoot),
     NL_TEST_DEF("Fail to encode because DataElement is too big",  WdmUpdateEncoderTest_DataElementTooBig),
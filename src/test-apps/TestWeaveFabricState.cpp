@@ -23,11 +23,14 @@
  */
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <nltest.h>
 
 #include <Weave/Core/WeaveCore.h>
+#include <Weave/Core/WeaveMappedFileSessionKeyStore.h>
 
 #include "ToolCommon.h"
 
@@ -101,6 +104,179 @@ static void CheckSelectNodeAddressWithSubnet(nlTestSuite *inSuite, void *inConte
     }
 }
 
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
+static const uint64_t kTestPeerNodeId = 0x18B4300000000042ULL;
+static const uint8_t kTestStoreKey[] = { 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F };
+
+// Two processes sharing a session key store, each with its own fabric state. These are too large to keep on the stack.
+static MappedFileSessionKeyStore sStoreA, sStoreB;
+static WeaveFabricState sFabricStateA, sFabricStateB;
+
+static void MakeTestSessionKey(WeaveEncryptionKey& encKey)
+{
+    memset(encKey.AES128CTRSHA1.DataKey, 0xD5, sizeof(encKey.AES128CTRSHA1.DataKey));
+    memset(encKey.AES128CTRSHA1.IntegrityKey, 0x1C, sizeof(encKey.AES128CTRSHA1.IntegrityKey));
+}
+
+/**
+ * Test sharing and restoring session keys through a MappedFileSessionKeyStore.
+ */
+static void CheckMappedFileSessionKeyStore(nlTestSuite *inSuite, void *inContext)
+{
+    WEAVE_ERROR err;
+    char path[] = "/tmp/weave-session-keys-XXXXXX";
+    int fd;
+    WeaveSessionKey *sessionKey;
+    WeaveSessionState sessionStateA, sessionStateB;
+    WeaveEncryptionKey encKey;
+    uint16_t keyId = WeaveKeyId::MakeSessionKeyId(0x1234);
+    uint32_t msgIdA, msgIdB;
+
+    fd = mkstemp(path);
+    NL_TEST_ASSERT(inSuite, fd >= 0);
+    close(fd);
+    unlink(path);
+
+    MakeTestSessionKey(encKey);
+
+    // Two fabric states sharing one store file stand in for two processes.
+    err = sStoreA.Init(path, kTestStoreKey, sizeof(kTestStoreKey), 3600);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    err = sStoreB.Init(path, kTestStoreKey, sizeof(kTestStoreKey), 3600);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    sFabricStateA.Init();
+    sFabricStateA.LocalNodeId = kTestNodeId;
+    sFabricStateA.SetSessionKeyStore(&sStoreA);
+    sFabricStateB.Init();
+    sFabricStateB.LocalNodeId = kTestNodeId;
+    sFabricStateB.SetSessionKeyStore(&sStoreB);
+
+    // Establish a session in A.
+    err = sFabricStateA.AllocSessionKey(kTestPeerNodeId, keyId, NULL, sessionKey);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    sessionKey->SetRemoveOnIdle(true);
+    sFabricStateA.SetSessionKey(sessionKey, kWeaveEncryptionType_AES128CTRSHA1, kWeaveAuthMode_CASE_AnyCert, &encKey);
+    NL_TEST_ASSERT(inSuite, sessionKey->IsStored());
+
+    // B finds the session in the store.
+    err = sFabricStateB.GetSessionKey(keyId, kTestPeerNodeId, sessionKey);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, sessionKey->IsStored() && sessionKey->IsRemoveOnIdle() && !sessionKey->IsLocallyInitiated());
+    NL_TEST_ASSERT(inSuite, sessionKey->AuthMode == kWeaveAuthMode_CASE_AnyCert);
+    NL_TEST_ASSERT(inSuite, sessionKey->MsgEncKey.EncType == kWeaveEncryptionType_AES128CTRSHA1);
+    NL_TEST_ASSERT(inSuite, memcmp(&sessionKey->MsgEncKey.EncKey, &encKey, sizeof(encKey)) == 0);
+
+    // A key id already in use by another process cannot be allocated again.
+    err = sFabricStateB.RemoveSessionKey(keyId, kTestPeerNodeId);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    sFabricStateA.SetSessionKeyStore(NULL);
+    sFabricStateA.SetSessionKeyStore(&sStoreA);
+    err = sFabricStateA.AllocSessionKey(kTestPeerNodeId, keyId, NULL, sessionKey);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    sFabricStateA.SetSessionKey(sessionKey, kWeaveEncryptionType_AES128CTRSHA1, kWeaveAuthMode_CASE_AnyCert, &encKey);
+    err = sFabricStateB.AllocSessionKey(kTestPeerNodeId, keyId, NULL, sessionKey);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_DUPLICATE_KEY_ID);
+
+    // Message ids sent by either process are never reused.
+    err = sFabricStateA.GetSessionState(kTestPeerNodeId, keyId, kWeaveEncryptionType_AES128CTRSHA1, NULL, sessionStateA);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    err = sFabricStateB.GetSessionState(kTestPeerNodeId, keyId, kWeaveEncryptionType_AES128CTRSHA1, NULL, sessionStateB);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    msgIdA = sessionStateA.NewMessageId();
+    for (int i = 0; i < 3000; i++)
+    {
+        msgIdB = sessionStateB.NewMessageId();
+        NL_TEST_ASSERT(inSuite, msgIdB > msgIdA);
+        msgIdA = sessionStateA.NewMessageId();
+        NL_TEST_ASSERT(inSuite, msgIdA > msgIdB);
+    }
+
+    // A message received by one process is a duplicate in the other.
+    NL_TEST_ASSERT(inSuite, !sessionStateA.IsDuplicateMessage(5));
+    NL_TEST_ASSERT(inSuite, sessionStateB.IsDuplicateMessage(5));
+    NL_TEST_ASSERT(inSuite, !sessionStateB.IsDuplicateMessage(6));
+    NL_TEST_ASSERT(inSuite, sessionStateA.IsDuplicateMessage(6));
+    NL_TEST_ASSERT(inSuite, sessionStateA.IsDuplicateMessage(4));
+
+    // Following a restart, message ids resume after the last reserved block.
+    sStoreA.Shutdown();
+    sFabricStateA.Shutdown();
+    err = sStoreA.Init(path, kTestStoreKey, sizeof(kTestStoreKey), 3600);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    sFabricStateA.Init();
+    sFabricStateA.LocalNodeId = kTestNodeId;
+    sFabricStateA.SetSessionKeyStore(&sStoreA);
+
+    err = sFabricStateA.GetSessionState(kTestPeerNodeId, keyId, kWeaveEncryptionType_AES128CTRSHA1, NULL, sessionStateA);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    msgIdB = sessionStateA.NewMessageId();
+    NL_TEST_ASSERT(inSuite, msgIdB > msgIdA);
+
+    // ... and messages received before the restart are still duplicates.
+    NL_TEST_ASSERT(inSuite, sessionStateA.IsDuplicateMessage(6));
+    NL_TEST_ASSERT(inSuite, !sessionStateA.IsDuplicateMessage(7));
+
+    // Removing the session in one process ends it in the other.
+    err = sFabricStateA.RemoveSessionKey(keyId, kTestPeerNodeId);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    sessionStateB.NewMessageId();
+    err = sFabricStateB.GetSessionState(kTestPeerNodeId, keyId, kWeaveEncryptionType_AES128CTRSHA1, NULL, sessionStateB);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_KEY_NOT_FOUND);
+
+    // Stored keys that fail the integrity check are not loaded.
+    err = sFabricStateA.AllocSessionKey(kTestPeerNodeId, keyId, NULL, sessionKey);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    sFabricStateA.SetSessionKey(sessionKey, kWeaveEncryptionType_AES128CTRSHA1, kWeaveAuthMode_CASE_AnyCert, &encKey);
+    {
+        FILE *file = fopen(path, "r+b");
+        static uint8_t buf[65536];
+        size_t len;
+
+        NL_TEST_ASSERT(inSuite, file != NULL);
+        if (file == NULL)
+            return;
+
+        len = fread(buf, 1, sizeof(buf), file);
+        for (size_t i = 0; i + sizeof(encKey.AES128CTRSHA1.DataKey) <= len; i++)
+            if (memcmp(buf + i, encKey.AES128CTRSHA1.DataKey, sizeof(encKey.AES128CTRSHA1.DataKey)) == 0)
+            {
+                fseek(file, i, SEEK_SET);
+                fputc(0xD6, file);
+                break;
+            }
+        fclose(file);
+    }
+    err = sFabricStateB.GetSessionKey(keyId, kTestPeerNodeId, sessionKey);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_KEY_NOT_FOUND);
+
+    // Deleted records are reused, so keys can be stored and removed indefinitely.
+    for (uint16_t i = 0; i < 2 * WEAVE_CONFIG_MAPPED_FILE_SESSION_KEY_STORE_MAX_KEYS; i++)
+    {
+        uint16_t tempKeyId = WeaveKeyId::MakeSessionKeyId(0x2000 + i);
+
+        err = sFabricStateA.AllocSessionKey(kTestPeerNodeId, tempKeyId, NULL, sessionKey);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        if (err != WEAVE_NO_ERROR)
+            break;
+        sFabricStateA.SetSessionKey(sessionKey, kWeaveEncryptionType_AES128CTRSHA1, kWeaveAuthMode_CASE_AnyCert, &encKey);
+        NL_TEST_ASSERT(inSuite, sessionKey->IsStored());
+
+        err = sFabricStateA.RemoveSessionKey(tempKeyId, kTestPeerNodeId);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    }
+
+    sFabricStateA.Shutdown();
+    sFabricStateB.Shutdown();
+    sStoreA.Shutdown();
+    sStoreB.Shutdown();
+    unlink(path);
+}
+
+#endif // WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
 /**
  *  Set up the test suite.
  */
@@ -131,6 +307,9 @@ static const nlTest sTests[] =
     // more thorough collection of tests should be written.
     NL_TEST_DEF("WeaveFabricState::SelectNodeAddress", CheckSelectNodeAddress),
     NL_TEST_DEF("WeaveFabricState::SelectNodeAddress", CheckSelectNodeAddressWithSubnet),
+#if WEAVE_CONFIG_ENABLE_SESSION_KEY_STORE && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    NL_TEST_DEF("WeaveFabricState::SessionKeyStore", CheckMappedFileSessionKeyStore),
+#endif
     NL_TEST_SENTINEL()
 };
 
@@ -34,6 +34,8 @@ import re
 import hashlib
 import argparse
 import itertools
+import json
+import struct
 
 
 # ================================================================================
@@ -209,6 +211,11 @@ def parseOpenSSLHexField(text, startMarker):
     else:
         return None
 
+def normalizeTLVDump(text):
+    '''Strip the length line and the element addresses printed when a TLV file is read all at once'''
+    lines = [ line for line in text.splitlines() if not line.startswith('TLV length is ') ]
+    return [ re.sub(r'''^(\d+ \t*)0x[0-9A-Fa-f]+, ''', r'\1', line).rstrip() for line in lines ]
+
 def prefixLines(text, prefix):
     return re.sub(r'''^''', prefix, text, flags=re.MULTILINE)
 
@@ -338,6 +345,21 @@ class WeaveToolTestCase(unittest.TestCase):
         
         return (res, stdout, stderr)
 
+    def generateEventLog(self, fileName, testNum, wdm=False):
+        '''Capture one of the sample event logs of the GenerateEventLog test app'''
+        logFile = OutFileArg(fileName)
+        (res, stdout, stderr) = self.runCommand(args.generateEventLogTool,
+            args=[ '--test', testNum, '--raw', '--output', logFile ] + ([ '--wdm' ] if wdm else []))
+        self.assertEqual(res, 0, 'GenerateEventLog returned %d' % res)
+        return logFile
+
+    def generateEventCapture(self):
+        '''Generate a capture of events of several trait profiles, mixing plain events and WDM notifications'''
+        contents = ''
+        for testNum, wdm in itertools.product([ 1, 2, 3 ], [ False, True ]):
+            contents += self.generateEventLog('part.bin', testNum, wdm).contents
+        return contents
+
     def parseWeaveCert(self, cert):
         
         (res, stdout, stderr) = self.runCommand(args.weaveTool, 
@@ -421,7 +443,7 @@ class WeaveToolTestCase(unittest.TestCase):
         
         return parseOpenSSLHexField(privKeyText, 'pub:')
 
-    def verifyProvisioningDataFile(self, fileName, deviceCount, curve, hash, certFormat, keyFormat):
+    def verifyProvisioningDataFile(self, fileName, deviceCount, curve, hash, certFormat, keyFormat, macs=None):
 
         # Read the provisioning data file...
         with open(fileName, 'r') as provData:
@@ -462,8 +484,11 @@ class WeaveToolTestCase(unittest.TestCase):
                 pairingCode = values[pairingCodeCol]
                 certType = values[certTypeCol]
                 
-                # Verify the MAC
-                expectedMAC = "%16X" % (0x18B4300000000001 + count)
+                # Verify the MAC, which follows the given list or else counts up from the first device id
+                if macs != None:
+                    expectedMAC = macs[count]
+                else:
+                    expectedMAC = "%16X" % (0x18B4300000000001 + count)
                 self.assertEqual(mac, expectedMAC, 'Invalid MAC value')
                 
                 # Verify the certificate's construction
@@ -870,6 +895,46 @@ class TEST06_GenProvisioningData(WeaveToolTestCase):
             # Verify the contents of the generated provisioning data file
             self.verifyProvisioningDataFile(provDataFile.name, deviceCount, curve, hash, certFormat, keyFormat)
 
+    def test_Bulk(self):
+        '''Test generation of device provisioning data for a list of devices on multiple threads'''
+
+        # Enough devices to span several of the batches handed to the worker threads, listed out of order so that the
+        # output is seen to follow the list rather than the device ids.
+        deviceCount = 70
+        curve = 'prime256v1'
+        hash = 'sha256'
+        macs = [ '%016X' % (0x18B4300000000001 + (i * 37) % deviceCount) for i in range(deviceCount) ]
+
+        self.clearTestContext()
+        self.clearTmpFiles()
+
+        # Invoke weave gen-provisioning-data command
+        caCertFile = InFileArg('ca-cert.pem', rootCACert_prime256v1_sha256)
+        caKeyFile = InFileArg('ca-key.pem', rootCAKey_prime256v1)
+        devListFile = InFileArg('dev-list.csv', 'MAC\n' + ''.join([ mac + '\n' for mac in macs ]))
+        provDataFile = OutFileArg('prov-data.csv')
+        (res, stdout, stderr) = self.runCommand(args.weaveTool,
+            args=[
+                'gen-provisioning-data',
+                '--dev-list', devListFile,
+                '--jobs', 4,
+                '--ca-cert', caCertFile,
+                '--ca-key', caKeyFile,
+                '--curve', curve,
+                '--' + hash,
+                '--valid-from', '2018/01/01',
+                '--lifetime', '365',
+                '--out', provDataFile
+            ])
+
+        # Check for errors or unexpected output.
+        self.assertEqual(res, 0, 'Command returned %d' % res)
+        self.assertEqual(stdout, '', 'Text in stdout')
+        self.assertEqual(stderr, '', 'Text in stderr')
+
+        # Verify the contents of the generated provisioning data file, with the devices in the order of the list
+        self.verifyProvisioningDataFile(provDataFile.name, deviceCount, curve, hash, 'weave', 'weave', macs)
+
 class TEST07_ConvertProvisioningData(WeaveToolTestCase):
     '''Test the weave convert-provisioning-data command'''
 
@@ -993,6 +1058,189 @@ class TEST07_ConvertProvisioningData(WeaveToolTestCase):
                 # Verify the contents of the generated provisioning data file
                 self.verifyProvisioningDataFile(toProvDataFile.name, deviceCount, curve, hash, certFormat, toKeyFormat)
 
+class TEST08_PrintTLV(WeaveToolTestCase):
+    '''Test the weave print-tlv command'''
+
+    def printTLV(self, *cmdArgs):
+        (res, stdout, stderr) = self.runCommand(args.weaveTool, args=[ 'print-tlv' ] + list(cmdArgs))
+        self.assertEqual(res, 0, 'Command returned %d' % res)
+        self.assertEqual(stderr, '', 'Text in stderr')
+        return stdout
+
+    def test_Stream(self):
+        '''Test that streaming a TLV file in small chunks prints the same elements as reading it all at once'''
+
+        # A WDM notification of a few kilobytes, spanning many chunks.
+        logFile = self.generateEventLog('notification.bin', 1, wdm=True)
+
+        dump = normalizeTLVDump(self.printTLV(logFile))
+        self.assertTrue(len(dump) > 100, 'Too few elements printed')
+
+        streamed = normalizeTLVDump(self.printTLV('--stream', '--chunk-size', 64, logFile))
+        self.assertEqual(streamed, dump, 'Streamed output does not match')
+
+    def test_Base64(self):
+        '''Test printing a base-64 TLV file, all at once and streamed'''
+
+        logFile = self.generateEventLog('notification.bin', 1, wdm=True)
+        dump = normalizeTLVDump(self.printTLV(logFile))
+
+        base64File = InFileArg('notification.b64', base64.b64encode(logFile.contents))
+        self.assertEqual(normalizeTLVDump(self.printTLV('--base64', base64File)), dump, 'Base-64 output does not match')
+        self.assertEqual(normalizeTLVDump(self.printTLV('--base64', '--stream', '--chunk-size', 64, base64File)), dump,
+                         'Streamed base-64 output does not match')
+
+    def test_PathAndJSON(self):
+        '''Test selecting elements by path and printing them as JSON'''
+
+        logFile = self.generateEventLog('notification.bin', 1, wdm=True)
+
+        # The trait profile ids of the events in the notification's event list.
+        dump = normalizeTLVDump(self.printTLV(logFile))
+        profileIds = [ int(m.group(1)) for m in
+            (re.match(r'''^3 \t\t\ttag\[Context Specific\]: 0xf, type: [^,]+, value: (\d+)$''', line) for line in dump) if m ]
+        self.assertTrue(len(profileIds) > 10, 'Too few events in the notification')
+
+        selected = self.printTLV('--path', '*/23/*/15', '--chunk-size', 64, logFile).splitlines()
+        self.assertEqual(len(selected), len(profileIds), 'Wrong number of elements selected by path')
+
+        selected = self.printTLV('--path', '*/23/*/15', '--json', '--chunk-size', 64, logFile).splitlines()
+        self.assertEqual([ json.loads(line) for line in selected ], profileIds, 'Wrong elements selected by path')
+
+        notification = self.printTLV('--json', '--chunk-size', 64, logFile).splitlines()
+        self.assertEqual(len(notification), 1, 'Wrong number of top-level elements')
+        events = json.loads(notification[0])['23']
+        self.assertEqual([ event['15'] for event in events ], profileIds, 'Wrong events printed as JSON')
+
+class TEST09_QueryEvents(WeaveToolTestCase):
+    '''Test the weave query-events command'''
+
+    def queryEvents(self, logFile, *cmdArgs):
+        (res, stdout, stderr) = self.runCommand(args.weaveTool, args=[ 'query-events' ] + list(cmdArgs) + [ logFile ])
+        self.assertEqual(res, 0, 'Command returned %d' % res)
+        self.assertEqual(stderr, '', 'Text in stderr')
+        return stdout.splitlines()
+
+    def test(self):
+        '''Test that queries, with and without an index, return the events of a full scan that match them'''
+
+        logFile = InFileArg('events.bin', self.generateEventCapture())
+
+        # Every event of the log, in log order.
+        lines = self.queryEvents(logFile)
+
+        # Name the log by its path from here on, so that it is not rewritten, and the index stays current.
+        logFile = logFile.name
+        events = []
+        for line in lines:
+            fields = line.split()
+            event = dict((name, int(value, 0)) for name, value in zip(fields[1::2], fields[2::2]))
+            event['importance'] = fields[0]
+            events.append(event)
+
+        # The same events, as scanned by print-tlv.
+        (res, stdout, stderr) = self.runCommand(args.weaveTool, args=[ 'print-tlv', '--json', logFile ])
+        self.assertEqual(res, 0, 'Command returned %d' % res)
+        scanned = []
+        for element in (json.loads(line) for line in stdout.splitlines()):
+            scanned += element['23'] if '23' in element else [ element ]
+        profileIds = [ e['15'][0] if isinstance(e['15'], list) else e['15'] for e in scanned ]
+        self.assertEqual([ e['profile'] for e in events ], profileIds, 'Events do not match the log')
+        self.assertEqual(len(set(profileIds)), 3, 'Expected events of three trait profiles')
+
+        utcTimes = sorted(e['utc'] for e in events if 'utc' in e)
+        utcLow, utcHigh = utcTimes[len(utcTimes) / 4], utcTimes[len(utcTimes) * 3 / 4]
+
+        queries = [
+            ([ '--profile', '0x22' ], lambda e: e['profile'] == 0x22),
+            ([ '--profile', '0x22', '--profile', '0xE02' ], lambda e: e['profile'] in (0x22, 0xE02)),
+            ([ '--profile', '0x235A0010', '--type', '1' ], lambda e: e['profile'] == 0x235A0010 and e['type'] == 1),
+            ([ '--profile', '0x22', '--event-id', '2-4' ], lambda e: e['profile'] == 0x22 and 2 <= e['id'] <= 4),
+            ([ '--event-id', '3-6' ], lambda e: 3 <= e['id'] <= 6),
+            ([ '--importance', 'production' ], lambda e: e['importance'] in ('production-critical', 'production')),
+            ([ '--importance', 'production-critical' ], lambda e: e['importance'] == 'production-critical'),
+            ([ '--time', '0-0' ], lambda e: e['time'] == 0),
+            ([ '--utc-time', '%d-%d' % (utcLow, utcHigh) ], lambda e: 'utc' in e and utcLow <= e['utc'] <= utcHigh),
+        ]
+
+        indexFile = OutFileArg('events.idx')
+
+        for queryArgs, matches in queries:
+            expected = [ line for line, event in zip(lines, events) if matches(event) ]
+            self.assertEqual(self.queryEvents(logFile, *queryArgs), expected, 'Query %s does not match' % queryArgs)
+            self.assertEqual(self.queryEvents(logFile, '--index', indexFile, *queryArgs), expected,
+                             'Indexed query %s does not match' % queryArgs)
+            self.assertEqual(self.queryEvents(logFile, '--count', *queryArgs), [ str(len(expected)) ],
+                             'Count of query %s does not match' % queryArgs)
+
+        # The index is reused, unless it refers to events outside the log.
+        (res, stdout, stderr) = self.runCommand(args.weaveTool, args=[ 'query-events', '--verbose', '--index', indexFile, logFile ])
+        self.assertEqual(res, 0, 'Command returned %d' % res)
+        self.assertTrue(stderr.startswith('Loaded index'), 'Index not reused')
+
+        with open(indexFile.name, 'r+b') as f:
+            index = bytearray(f.read())
+            struct.pack_into('<Q', index, 40, os.path.getsize(logFile) + 1)
+            f.seek(0)
+            f.write(index)
+
+        (res, stdout, stderr) = self.runCommand(args.weaveTool, args=[ 'query-events', '--verbose', '--index', indexFile, logFile ])
+        self.assertEqual(res, 0, 'Command returned %d' % res)
+        self.assertTrue(stderr.startswith('Indexed'), 'Damaged index not rebuilt')
+        self.assertEqual(stdout.splitlines(), lines, 'Query with a rebuilt index does not match')
+
+class TEST10_ExportEvents(WeaveToolTestCase):
+    '''Test the weave export-events command'''
+
+    def exportEvents(self, logFile, outFileName, *cmdArgs):
+        outFile = OutFileArg(outFileName)
+        (res, stdout, stderr) = self.runCommand(args.weaveTool, args=[ 'export-events' ] + list(cmdArgs) + [ logFile, outFile ])
+        self.assertEqual(res, 0, 'Command returned %d' % res)
+        self.assertEqual(stdout, '', 'Text in stdout')
+        self.assertEqual(stderr, '', 'Text in stderr')
+        return outFile.contents
+
+    def test(self):
+        '''Test that the export is independent of the number of jobs, and holds the resolved ids and timestamps of the events'''
+
+        # Repeat the capture, so that the log spans many chunks.
+        logFile = InFileArg('events.bin', self.generateEventCapture() * 20)
+
+        export = self.exportEvents(logFile, 'events-1.out', '--jobs', '1', '--chunk-size', '4096')
+        self.assertEqual(self.exportEvents(logFile, 'events-4.out', '--jobs', '4', '--chunk-size', '4096'), export,
+                         'Export on 4 jobs differs from export on 1 job')
+
+        # The events of the log, as listed by query-events.
+        (res, stdout, stderr) = self.runCommand(args.weaveTool, args=[ 'query-events', logFile ])
+        self.assertEqual(res, 0, 'Command returned %d' % res)
+        expected = []
+        for line in stdout.splitlines():
+            fields = line.split()
+            event = dict((name, int(value, 0)) for name, value in zip(fields[1::2], fields[2::2]))
+            expected.append((event['profile'], event['type'], event['id'], event['time'], event.get('utc')))
+
+        # The events of the export, one block of columns per event type in each chunk.
+        (res, stdout, stderr) = self.runCommand(args.weaveTool, args=[ 'print-tlv', '--json', InFileArg('events.out', export) ])
+        self.assertEqual(res, 0, 'Command returned %d' % res)
+        exported = []
+        for block in (json.loads(line) for line in stdout.splitlines()):
+            columns = dict((column['1'], column) for column in block['4'])
+
+            def getValues(name):
+                column = columns[name]
+                values = struct.unpack('<%dQ' % block['3'], base64.b64decode(column['4']))
+                if '3' in column:
+                    present = bytearray(base64.b64decode(column['3']))
+                    values = [ value if present[i / 8] & (1 << (i % 8)) else None for i, value in enumerate(values) ]
+                return values
+
+            # query-events lists a missing system timestamp as 0.
+            for eventId, systemTime, utcTime in zip(getValues('EventId'), getValues('SystemTimestamp'), getValues('UTCTimestamp')):
+                exported.append((block['1'], block['2'], eventId, systemTime or 0, utcTime))
+
+        self.assertEqual(len(exported), len(expected), 'Wrong number of exported events')
+        self.assertEqual(sorted(exported), sorted(expected), 'Exported events do not match the log')
+
 if __name__ == '__main__':
     
     argParser = argparse.ArgumentParser(description='Script for testing the weave tool')
@@ -1000,6 +1248,7 @@ if __name__ == '__main__':
     argParser.add_argument('--weave-root', required=False, dest='weaveRoot', help='Path to the root of the weave source tree')
     argParser.add_argument('--weave-tool', required=False, dest='weaveTool', help='Path to the weave tool executable to be tested')
     argParser.add_argument('--openssl', required=False, dest='opensslTool', help='Path to the openssl executable.')
+    argParser.add_argument('--generate-event-log', required=False, dest='generateEventLogTool', help='Path to the GenerateEventLog test app')
     
     args = argParser.parse_args()
     
@@ -1031,6 +1280,14 @@ if __name__ == '__main__':
         sys.stderr.write('Expected location: %s\n' % args.weaveTool)
         sys.exit(-1)
     
+    # Locate the GenerateEventLog test app in the same way.
+    if not args.generateEventLogTool:
+        args.generateEventLogTool = os.path.join(buildDir, 'src/test-apps/GenerateEventLog')
+    if not os.path.isfile(args.generateEventLogTool) or not os.access(args.generateEventLogTool, os.X_OK):
+        sys.stderr.write('ERROR: GenerateEventLog not found\n')
+        sys.stderr.write('Expected location: %s\n' % args.generateEventLogTool)
+        sys.exit(-1)
+
     # If not specified on the command line, locate the openssl tool in the user's PATH.
     if not args.opensslTool:
         args.opensslTool = next(
@@ -197,6 +197,44 @@ inline uint64_t NowMs()
     return Now()/1000;
 }
 
+// Minimum run time of each benchmark, in microseconds.
+#define BENCHMARK_MIN_DURATION_USEC 500000
+
+/**
+ * Times a benchmark that repeats its operation until it has run for at least
+ * BENCHMARK_MIN_DURATION_USEC:
+ *
+ *     BenchmarkTimer timer;
+ *
+ *     while (timer.Continue())
+ *         count += RunOperation();
+ *
+ *     rate = count * 1000000.0 / timer.ElapsedUSec();
+ */
+class BenchmarkTimer
+{
+public:
+    BenchmarkTimer(void) { Start(); }
+
+    void Start(void)
+    {
+        mStartTime = nl::Weave::System::Layer::GetClock_MonotonicHiRes();
+        mElapsedUSec = 0;
+    }
+
+    bool Continue(void)
+    {
+        mElapsedUSec = nl::Weave::System::Layer::GetClock_MonotonicHiRes() - mStartTime;
+        return mElapsedUSec < BENCHMARK_MIN_DURATION_USEC;
+    }
+
+    uint64_t ElapsedUSec(void) const { return mElapsedUSec; }
+
+private:
+    uint64_t mStartTime;
+    uint64_t mElapsedUSec;
+};
+
 #define FAIL_ERROR(ERR, MSG) \
 	do { \
 		if ((ERR) != WEAVE_NO_ERROR) \
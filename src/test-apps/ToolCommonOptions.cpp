@@ -51,6 +51,7 @@ GroupKeyEncOptions gGroupKeyEncOptions;
 GeneralSecurityOptions gGeneralSecurityOptions;
 ServiceDirClientOptions gServiceDirClientOptions;
 FaultInjectionOptions gFaultInjectionOptions;
+BenchmarkOptions gBenchmarkOptions;
 
 NetworkOptions::NetworkOptions()
 {
@@ -866,3 +867,38 @@ bool FaultInjectionOptions::HandleOption(const char *progName, OptionSet *optSet
 
     return true;
 }
+
+BenchmarkOptions::BenchmarkOptions()
+{
+    static OptionDef optionDefs[] =
+    {
+        { "bench", kNoArgument, kToolCommonOpt_Bench },
+        { NULL }
+    };
+    OptionDefs = optionDefs;
+
+    HelpGroupName = "BENCHMARK OPTIONS";
+
+    OptionHelp =
+        "  --bench\n"
+        "       Run the benchmarks instead of the tests.\n"
+        "\n";
+
+    // Defaults
+    RunBenchmarks = false;
+}
+
+bool BenchmarkOptions::HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg)
+{
+    switch (id)
+    {
+    case kToolCommonOpt_Bench:
+        RunBenchmarks = true;
+        break;
+    default:
+        PrintArgError("%s: INTERNAL ERROR: Unhandled option: %s\n", progName, name);
+        return false;
+    }
+
+    return true;
+}
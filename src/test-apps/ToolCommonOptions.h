@@ -82,6 +82,7 @@ enum
     kToolCommonOpt_SecurityTAKE,
     kToolCommonOpt_GeneralSecurityIdleSessionTimeout,
     kToolCommonOpt_GeneralSecuritySessionEstablishmentTimeout,
+    kToolCommonOpt_Bench,
 };
 
 
@@ -263,6 +264,22 @@ public:
 extern FaultInjectionOptions gFaultInjectionOptions;
 
 
+/**
+ * Handler for the option that runs a unit test's benchmarks in place of its tests.
+ */
+class BenchmarkOptions : public OptionSetBase
+{
+public:
+    bool RunBenchmarks;
+
+    BenchmarkOptions();
+
+    virtual bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg);
+};
+
+extern BenchmarkOptions gBenchmarkOptions;
+
+
 
 
 
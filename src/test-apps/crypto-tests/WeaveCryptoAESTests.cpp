@@ -287,6 +287,52 @@ static void Check_AES256CTRMode_Test3(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, res == true);
 }
 
+static void Check_AES128CTRMode_Bulk(nlTestSuite *inSuite, void *inContext)
+{
+    // Verify that the multi-block keystream path produces the same output as the
+    // block-at-a-time path, for every starting offset within a counter block.
+    static uint8_t key[]                = { 0x76, 0x91, 0xBE, 0x03, 0x5E, 0x50, 0x20, 0xA8, 0xAC, 0x6E, 0x61, 0x85, 0x29, 0xF9, 0xA0, 0xDC };
+    static uint8_t ctr[]                = { 0x00, 0xE0, 0x01, 0x7B, 0x27, 0x77, 0x7F, 0x3F, 0x4A, 0x17, 0x86, 0xF0, 0xFF, 0xFF, 0xFF, 0xF0 };
+    uint8_t plainText[1031];
+    uint8_t expectedCipherText[sizeof(plainText)];
+    uint8_t cipherText[sizeof(plainText)];
+
+    for (size_t i = 0; i < sizeof(plainText); i++)
+        plainText[i] = (uint8_t) (i * 7 + 3);
+
+    // Encrypting one byte at a time never takes the bulk path.
+    {
+        AES128CTRMode aes128CTR;
+
+        aes128CTR.SetKey(key);
+        aes128CTR.SetCounter(ctr);
+        for (size_t i = 0; i < sizeof(plainText); i++)
+            aes128CTR.EncryptData(plainText + i, 1, expectedCipherText + i);
+    }
+
+    for (size_t prefixLen = 0; prefixLen <= AES128CTRMode::kCounterLength; prefixLen++)
+    {
+        AES128CTRMode aes128CTR;
+
+        aes128CTR.SetKey(key);
+        aes128CTR.SetCounter(ctr);
+        aes128CTR.EncryptData(plainText, prefixLen, cipherText);
+        aes128CTR.EncryptData(plainText + prefixLen, sizeof(plainText) - prefixLen, cipherText + prefixLen);
+
+        // Invalid ciphertext generated by the AES128CTRMode::EncryptData() bulk path
+        NL_TEST_ASSERT(inSuite, memcmp(cipherText, expectedCipherText, sizeof(plainText)) == 0);
+
+        // In-place decryption
+        aes128CTR.Reset();
+        aes128CTR.SetKey(key);
+        aes128CTR.SetCounter(ctr);
+        aes128CTR.EncryptData(cipherText, sizeof(cipherText), cipherText);
+
+        // Invalid plaintext generated by the AES128CTRMode::EncryptData() bulk path
+        NL_TEST_ASSERT(inSuite, memcmp(cipherText, plainText, sizeof(plainText)) == 0);
+    }
+}
+
 bool AES128BlockCipher_DoTest(const uint8_t *key, const uint8_t *plainText, const uint8_t *expectedCipherText)
 {
     uint8_t cipherText[AES128BlockCipherEnc::kBlockLength];
@@ -407,6 +453,7 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("AES128CTRMode Test2",        Check_AES128CTRMode_Test2),
     NL_TEST_DEF("AES128CTRMode Test3",        Check_AES128CTRMode_Test3),
     NL_TEST_DEF("AES128CTRMode Test4",        Check_AES128CTRMode_Test4),
+    NL_TEST_DEF("AES128CTRMode Bulk",         Check_AES128CTRMode_Bulk),
     NL_TEST_DEF("AES256CTRMode Test1",        Check_AES256CTRMode_Test1),
     NL_TEST_DEF("AES256CTRMode Test2",        Check_AES256CTRMode_Test2),
     NL_TEST_DEF("AES256CTRMode Test3",        Check_AES256CTRMode_Test3),
@@ -0,0 +1,227 @@
+/*
+ *
+ *    Copyright (c) 2018 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements throughput benchmarks for the Weave Crypto
+ *      library.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Weave/Support/crypto/AESBlockCipher.h>
+#include <Weave/Support/crypto/CTRMode.h>
+#include <Weave/Support/crypto/HashAlgos.h>
+#include <Weave/Support/crypto/HMAC.h>
+
+#include "WeaveCryptoTests.h"
+#include "../ToolCommon.h"
+
+using namespace nl::Weave::Crypto;
+using namespace nl::Weave::Platform::Security;
+
+// EncryptData() and AddData() accept at most UINT16_MAX bytes per call.
+#define BENCHMARK_MAX_CHUNK_LENGTH 32768
+
+static void PrintThroughput(const char *name, size_t dataLen, uint64_t totalBytes, uint64_t elapsedUSec)
+{
+    double mbPerSec = (elapsedUSec > 0) ? ((double) totalBytes / (double) elapsedUSec) : 0.0;
+
+    printf("%-24s %7u bytes: %10.1f MB/s (%llu bytes in %llu us)\n", name, (unsigned) dataLen, mbPerSec,
+           (unsigned long long) totalBytes, (unsigned long long) elapsedUSec);
+}
+
+template <class CTRModeType>
+static void BenchmarkCTRMode(const char *name, size_t dataLen)
+{
+    static const uint8_t key[32] = { 0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+                                     0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4 };
+    uint8_t *data = (uint8_t *) malloc(dataLen);
+    uint64_t totalBytes = 0;
+    uint32_t msgId = 0;
+
+    if (data == NULL)
+        return;
+
+    memset(data, 0xA5, dataLen);
+
+    BenchmarkTimer timer;
+
+    while (timer.Continue())
+    {
+        // Mirror the message layer: a fresh CTR mode object and counter per message.
+        for (int i = 0; i < 64; i++)
+        {
+            CTRModeType ctrMode;
+
+            ctrMode.SetKey(key);
+            ctrMode.SetWeaveMessageCounter(0x18B43000001E8687ULL, msgId++);
+
+            for (size_t offset = 0; offset < dataLen; offset += BENCHMARK_MAX_CHUNK_LENGTH)
+            {
+                size_t chunkLen = dataLen - offset;
+                if (chunkLen > BENCHMARK_MAX_CHUNK_LENGTH)
+                    chunkLen = BENCHMARK_MAX_CHUNK_LENGTH;
+                ctrMode.EncryptData(data + offset, (uint16_t) chunkLen, data + offset);
+            }
+
+            totalBytes += dataLen;
+        }
+    }
+
+    PrintThroughput(name, dataLen, totalBytes, timer.ElapsedUSec());
+
+    free(data);
+}
+
+int WeaveCryptoAESBenchmarks(void)
+{
+    static const size_t dataLens[] = { 64, 1024, 65536 };
+
+    printf("AES-CTR throughput (%u blocks per bulk iteration)\n", (unsigned) WEAVE_CONFIG_AES_CTR_BULK_BLOCK_COUNT);
+
+    for (size_t i = 0; i < sizeof(dataLens) / sizeof(dataLens[0]); i++)
+        BenchmarkCTRMode<AES128CTRMode>("AES128CTRMode", dataLens[i]);
+
+    for (size_t i = 0; i < sizeof(dataLens) / sizeof(dataLens[0]); i++)
+        BenchmarkCTRMode<AES256CTRMode>("AES256CTRMode", dataLens[i]);
+
+    return 0;
+}
+
+template <class HashType>
+static void BenchmarkHash(const char *name, size_t dataLen)
+{
+    uint8_t *data = (uint8_t *) malloc(dataLen);
+    uint8_t hashBuf[HashType::kHashLength];
+    uint64_t totalBytes = 0;
+
+    if (data == NULL)
+        return;
+
+    memset(data, 0x5A, dataLen);
+
+    BenchmarkTimer timer;
+
+    while (timer.Continue())
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            HashType hash;
+
+            hash.Begin();
+            for (size_t offset = 0; offset < dataLen; offset += BENCHMARK_MAX_CHUNK_LENGTH)
+            {
+                size_t chunkLen = dataLen - offset;
+                if (chunkLen > BENCHMARK_MAX_CHUNK_LENGTH)
+                    chunkLen = BENCHMARK_MAX_CHUNK_LENGTH;
+                hash.AddData(data + offset, (uint16_t) chunkLen);
+            }
+            hash.Finish(hashBuf);
+
+            totalBytes += dataLen;
+        }
+    }
+
+    PrintThroughput(name, dataLen, totalBytes, timer.ElapsedUSec());
+
+    free(data);
+}
+
+// Compare verifying a batch of message MACs one at a time against AddDataMultiple().
+static void BenchmarkHMACSHA1Batch(size_t msgLen, bool useMultiple)
+{
+    enum
+    {
+        kBatchSize = 8
+    };
+
+    static const uint8_t key[20] = { 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+                                     0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b };
+    uint8_t *data = (uint8_t *) malloc(msgLen * kBatchSize);
+    uint8_t digest[HMACSHA1::kDigestLength];
+    HMACSHA1 hmacs[kBatchSize];
+    HMACSHA1 *hmacPtrs[kBatchSize];
+    const uint8_t *msgs[kBatchSize];
+    uint16_t msgLens[kBatchSize];
+    uint64_t totalMsgs = 0;
+
+    if (data == NULL)
+        return;
+
+    memset(data, 0x3C, msgLen * kBatchSize);
+
+    for (int i = 0; i < kBatchSize; i++)
+    {
+        hmacPtrs[i] = &hmacs[i];
+        msgs[i] = data + i * msgLen;
+        msgLens[i] = (uint16_t) msgLen;
+    }
+
+    BenchmarkTimer timer;
+
+    while (timer.Continue())
+    {
+        for (int iter = 0; iter < 64; iter++)
+        {
+            for (int i = 0; i < kBatchSize; i++)
+                hmacs[i].Begin(key, sizeof(key));
+
+            if (useMultiple)
+                HMACSHA1::AddDataMultiple(hmacPtrs, msgs, msgLens, kBatchSize);
+            else
+                for (int i = 0; i < kBatchSize; i++)
+                    hmacs[i].AddData(msgs[i], msgLens[i]);
+
+            for (int i = 0; i < kBatchSize; i++)
+                hmacs[i].Finish(digest);
+
+            totalMsgs += kBatchSize;
+        }
+    }
+
+    printf("HMACSHA1 %-15s %7u bytes: %10.0f msgs/s\n", useMultiple ? "AddDataMultiple" : "sequential", (unsigned) msgLen,
+           (double) totalMsgs * 1000000.0 / (double) timer.ElapsedUSec());
+
+    free(data);
+}
+
+int WeaveCryptoSHABenchmarks(void)
+{
+    static const size_t dataLens[] = { 64, 1024, 65536 };
+    static const size_t msgLens[] = { 128, 1024 };
+
+    printf("SHA throughput\n");
+
+    for (size_t i = 0; i < sizeof(dataLens) / sizeof(dataLens[0]); i++)
+        BenchmarkHash<nl::Weave::Platform::Security::SHA1>("SHA1", dataLens[i]);
+
+    for (size_t i = 0; i < sizeof(dataLens) / sizeof(dataLens[0]); i++)
+        BenchmarkHash<nl::Weave::Platform::Security::SHA256>("SHA256", dataLens[i]);
+
+    for (size_t i = 0; i < sizeof(msgLens) / sizeof(msgLens[0]); i++)
+    {
+        BenchmarkHMACSHA1Batch(msgLens[i], false);
+        BenchmarkHMACSHA1Batch(msgLens[i], true);
+    }
+
+    return 0;
+}
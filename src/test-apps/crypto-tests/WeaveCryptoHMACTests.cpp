@@ -73,9 +73,54 @@ static void Check_HMACSHA1_Test2(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, memcmp(digest, ExpectedDigest, HMACSHA1::kDigestLength) == 0);
 }
 
+static void Check_HMACSHA1_Multiple(nlTestSuite *inSuite, void *inContext)
+{
+    enum
+    {
+        kMsgCount = 11
+    };
+
+    static uint8_t Key[] = { 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b };
+    uint8_t msgBuf[1024];
+    HMACSHA1 hmacs[kMsgCount];
+    HMACSHA1 *hmacPtrs[kMsgCount];
+    const uint8_t *msgs[kMsgCount];
+    uint16_t msgLens[kMsgCount];
+    uint8_t digest[HMACSHA1::kDigestLength];
+    uint8_t expectedDigest[HMACSHA1::kDigestLength];
+
+    for (size_t i = 0; i < sizeof(msgBuf); i++)
+        msgBuf[i] = (uint8_t) (i * 13 + 5);
+
+    for (int i = 0; i < kMsgCount; i++)
+    {
+        hmacPtrs[i] = &hmacs[i];
+        msgs[i] = msgBuf + i;
+        msgLens[i] = (uint16_t) ((i * 97) % 700);
+        hmacs[i].Begin(Key, sizeof(Key));
+    }
+
+    HMACSHA1::AddDataMultiple(hmacPtrs, msgs, msgLens, kMsgCount);
+
+    for (int i = 0; i < kMsgCount; i++)
+    {
+        HMACSHA1 hmac;
+
+        hmacs[i].Finish(digest);
+
+        hmac.Begin(Key, sizeof(Key));
+        hmac.AddData(msgs[i], msgLens[i]);
+        hmac.Finish(expectedDigest);
+
+        // Digest from HMACSHA1::AddDataMultiple() differs from the sequential computation
+        NL_TEST_ASSERT(inSuite, memcmp(digest, expectedDigest, HMACSHA1::kDigestLength) == 0);
+    }
+}
+
 static const nlTest sTests[] = {
     NL_TEST_DEF("HMACSHA1 Test1",          Check_HMACSHA1_Test1),
     NL_TEST_DEF("HMACSHA1 Test2",          Check_HMACSHA1_Test2),
+    NL_TEST_DEF("HMACSHA1 Multiple",       Check_HMACSHA1_Multiple),
     NL_TEST_SENTINEL()
 };
 
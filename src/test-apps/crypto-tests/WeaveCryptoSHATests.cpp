@@ -31,6 +31,10 @@
 
 #include "WeaveCryptoTests.h"
 
+#if WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE && WEAVE_WITH_OPENSSL
+#include <openssl/sha.h>
+#endif
+
 using namespace nl::Weave::Crypto;
 using namespace nl::Weave::Platform::Security;
 
@@ -303,12 +307,163 @@ static void Check_SHA1_Test3(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, memcmp(hashBuf, LongMsg6056Result, SHA1::kHashLength) == 0);
 }
 
+static void Check_SHA256_Multiple(nlTestSuite *inSuite, void *inContext)
+{
+    enum
+    {
+        kMsgCount = 13
+    };
+
+    uint8_t msgBuf[2048];
+    nl::Weave::Platform::Security::SHA256 hashes[kMsgCount];
+    nl::Weave::Platform::Security::SHA256 *hashPtrs[kMsgCount];
+    const uint8_t *msgs[kMsgCount];
+    uint16_t msgLens[kMsgCount];
+    uint8_t hashBuf[SHA256::kHashLength];
+    uint8_t expectedHashBuf[SHA256::kHashLength];
+
+    for (size_t i = 0; i < sizeof(msgBuf); i++)
+        msgBuf[i] = (uint8_t) (i * 31 + 7);
+
+    // Start each hash with a different prefix so that the lanes begin at different block offsets.
+    for (int i = 0; i < kMsgCount; i++)
+    {
+        hashPtrs[i] = &hashes[i];
+        msgs[i] = msgBuf + 3 * i;
+        msgLens[i] = (uint16_t) ((i * 211) % 1500);
+        hashes[i].Begin();
+        hashes[i].AddData(msgBuf, 3 * i);
+    }
+
+    SHA256::AddDataMultiple(hashPtrs, msgs, msgLens, kMsgCount);
+
+    for (int i = 0; i < kMsgCount; i++)
+    {
+        nl::Weave::Platform::Security::SHA256 sha256;
+
+        hashes[i].Finish(hashBuf);
+
+        sha256.Begin();
+        sha256.AddData(msgBuf, 3 * i + msgLens[i]);
+        sha256.Finish(expectedHashBuf);
+
+        // Hash from SHA256::AddDataMultiple() differs from the sequential computation
+        NL_TEST_ASSERT(inSuite, memcmp(hashBuf, expectedHashBuf, SHA256::kHashLength) == 0);
+    }
+}
+
+#if WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+
+#if WEAVE_WITH_OPENSSL
+static void CheckNativeBackendAgainstOpenSSL(nlTestSuite *inSuite)
+{
+    enum
+    {
+        kMsgCount = 9
+    };
+
+    uint8_t msgBuf[1024];
+    uint8_t hashBuf[SHA256::kHashLength];
+    uint8_t expectedHashBuf[SHA256::kHashLength];
+    nl::Weave::Platform::Security::SHA1 sha1Hashes[kMsgCount];
+    nl::Weave::Platform::Security::SHA1 *sha1Ptrs[kMsgCount];
+    nl::Weave::Platform::Security::SHA256 sha256Hashes[kMsgCount];
+    nl::Weave::Platform::Security::SHA256 *sha256Ptrs[kMsgCount];
+    const uint8_t *msgs[kMsgCount];
+    uint16_t msgLens[kMsgCount];
+
+    for (size_t i = 0; i < sizeof(msgBuf); i++)
+        msgBuf[i] = (uint8_t) (i * 13 + 5);
+
+    // Cover every padding case around the block boundaries.
+    for (uint16_t len = 0; len <= 300; len++)
+    {
+        nl::Weave::Platform::Security::SHA1 sha1;
+        nl::Weave::Platform::Security::SHA256 sha256;
+
+        sha1.Begin();
+        sha1.AddData(msgBuf, len);
+        sha1.Finish(hashBuf);
+        ::SHA1(msgBuf, len, expectedHashBuf);
+        // Native SHA1 hash differs from OpenSSL
+        NL_TEST_ASSERT(inSuite, memcmp(hashBuf, expectedHashBuf, SHA1::kHashLength) == 0);
+
+        sha256.Begin();
+        sha256.AddData(msgBuf, len);
+        sha256.Finish(hashBuf);
+        ::SHA256(msgBuf, len, expectedHashBuf);
+        // Native SHA256 hash differs from OpenSSL
+        NL_TEST_ASSERT(inSuite, memcmp(hashBuf, expectedHashBuf, SHA256::kHashLength) == 0);
+    }
+
+    for (int i = 0; i < kMsgCount; i++)
+    {
+        msgs[i] = msgBuf + i;
+        msgLens[i] = (uint16_t) ((i * 127) % (sizeof(msgBuf) - kMsgCount));
+        sha1Ptrs[i] = &sha1Hashes[i];
+        sha256Ptrs[i] = &sha256Hashes[i];
+        sha1Hashes[i].Begin();
+        sha256Hashes[i].Begin();
+    }
+
+    SHA1::AddDataMultiple(sha1Ptrs, msgs, msgLens, kMsgCount);
+    SHA256::AddDataMultiple(sha256Ptrs, msgs, msgLens, kMsgCount);
+
+    for (int i = 0; i < kMsgCount; i++)
+    {
+        sha1Hashes[i].Finish(hashBuf);
+        ::SHA1(msgs[i], msgLens[i], expectedHashBuf);
+        // Native SHA1::AddDataMultiple() hash differs from OpenSSL
+        NL_TEST_ASSERT(inSuite, memcmp(hashBuf, expectedHashBuf, SHA1::kHashLength) == 0);
+
+        sha256Hashes[i].Finish(hashBuf);
+        ::SHA256(msgs[i], msgLens[i], expectedHashBuf);
+        // Native SHA256::AddDataMultiple() hash differs from OpenSSL
+        NL_TEST_ASSERT(inSuite, memcmp(hashBuf, expectedHashBuf, SHA256::kHashLength) == 0);
+    }
+}
+#endif // WEAVE_WITH_OPENSSL
+
+static void Check_Native_Backends(nlTestSuite *inSuite, void *inContext)
+{
+    static const NativeHashBackend backends[] =
+    {
+        kNativeHashBackend_Generic,
+        kNativeHashBackend_AVX2,
+        kNativeHashBackend_SHANI
+    };
+
+    // Run the known answer tests on every backend this machine supports, not just the one selected by default.
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++)
+    {
+        if (!SelectNativeHashBackend(backends[i]))
+            continue;
+
+        Check_SHA1_Test3(inSuite, inContext);
+        Check_SHA256_Multiple(inSuite, inContext);
+#if WEAVE_WITH_OPENSSL
+        CheckNativeBackendAgainstOpenSSL(inSuite);
+#endif
+    }
+
+    // The generic backend is available everywhere.
+    NL_TEST_ASSERT(inSuite, SelectNativeHashBackend(kNativeHashBackend_Generic));
+
+    NL_TEST_ASSERT(inSuite, SelectNativeHashBackend(kNativeHashBackend_Auto));
+}
+
+#endif // WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+
 static const nlTest sTests[] = {
     NL_TEST_DEF("SHA1 Test1",          Check_SHA1_Test1),
 #if WEAVE_WITH_OPENSSL
     NL_TEST_DEF("SHA1 Test2",          Check_SHA1_Test2),
 #endif
     NL_TEST_DEF("SHA1 Test3",          Check_SHA1_Test3),
+    NL_TEST_DEF("SHA256 Multiple",     Check_SHA256_Multiple),
+#if WEAVE_CONFIG_HASH_IMPLEMENTATION_NATIVE
+    NL_TEST_DEF("Native Backends",     Check_Native_Backends),
+#endif
     NL_TEST_SENTINEL()
 };
 
@@ -52,4 +52,14 @@ int WeaveCryptoHKDFTests(void);
  */
 int WeaveCryptoAESTests(void);
 
+/*
+ * Throughput benchmark for AES CTR mode.
+ */
+int WeaveCryptoAESBenchmarks(void);
+
+/*
+ * Throughput benchmark for SHA1, SHA256 and batched HMACSHA1.
+ */
+int WeaveCryptoSHABenchmarks(void);
+
 #endif /* WEAVE_CRYPTO_TESTS_H_ */
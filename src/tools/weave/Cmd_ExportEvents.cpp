@@ -0,0 +1,1518 @@
+/*
+ *
+ *    Copyright (c) 2013-2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements the command handler for the 'weave' tool
+ *      that exports captured Weave event logs in columnar form.
+ *
+ */
+
+#define __STDC_FORMAT_MACROS
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <Weave/Core/WeaveEncoding.h>
+#include <Weave/Profiles/data-management/DataManagement.h>
+
+#include "weave-tool.h"
+
+using namespace nl::Weave::TLV;
+using namespace nl::Weave::Profiles::DataManagement;
+using namespace nl::Weave::Encoding;
+
+#define CMD_NAME "weave export-events"
+
+enum
+{
+    kMaxJobs            = 256,
+    kMaxChunksPerJob    = 2,        // Number of chunks each worker may run ahead of the output
+    kMaxPathDepth       = 8,        // Structures nested deeper than this are exported as TLV
+    kOutputBufferSize   = 65536,
+};
+
+/**
+ * Tags of the elements of an exported block.
+ *
+ * Each block is an anonymous structure holding the events of one event type, from one
+ * chunk of the log, with one column for each header field and each leaf of the event
+ * data.
+ */
+enum
+{
+    kTag_Block_ProfileId            = 1,    // Trait profile id of the events
+    kTag_Block_EventType            = 2,    // Event type
+    kTag_Block_RowCount             = 3,    // Number of events in the block
+    kTag_Block_Columns              = 4,    // Array of column structures
+
+    kTag_Column_Name                = 1,    // e.g. "EventId", "SystemTimestamp" or "Data.2.1"
+    kTag_Column_Type                = 2,    // One of kColumnType_*
+    kTag_Column_Present             = 3,    // Bitmap of the rows with a value, LSB first.  Omitted if every row has one.
+    kTag_Column_Values              = 4,    // Little-endian values, 8 bytes each (1 for booleans, 4 byte codes for dictionary types)
+    kTag_Column_Dictionary          = 5,    // For dictionary types, the distinct values in code order
+};
+
+enum ColumnType
+{
+    kColumnType_Int                 = 1,
+    kColumnType_UInt                = 2,
+    kColumnType_Float               = 3,
+    kColumnType_Bool                = 4,
+    kColumnType_String              = 5,    // Dictionary of UTF-8 strings
+    kColumnType_Bytes               = 6,    // Dictionary of byte strings
+    kColumnType_TLV                 = 7,    // Dictionary of the TLV encodings of arrays, paths and deeply nested structures
+};
+
+// Columns that every block starts with, holding the header fields that are implicit in the log encoding.
+enum
+{
+    kColumn_EventId                 = 0,
+    kColumn_Importance              = 1,
+    kColumn_SystemTimestamp         = 2,
+    kColumn_UTCTimestamp            = 3,
+
+    kFixedColumnCount
+};
+
+struct ExportBuffer
+{
+    uint8_t *Data;
+    size_t Length;
+    size_t Capacity;
+};
+
+struct DictionaryEntry
+{
+    uint32_t Offset;
+    uint32_t Length;
+    uint32_t Hash;
+};
+
+struct ExportColumn
+{
+    uint64_t Path[kMaxPathDepth];       // Tags leading to the value, starting with its tag in the event
+    uint8_t PathDepth;
+    uint8_t Type;
+    bool HasNulls;
+    uint32_t RowCount;
+    ExportBuffer Values;
+    ExportBuffer Present;
+    ExportBuffer DictEntries;           // DictionaryEntry for each code
+    ExportBuffer DictData;
+    uint32_t *DictSlots;                // Open-addressed table of code + 1, or 0 if empty
+    uint32_t DictSlotCount;
+};
+
+struct ExportBlock
+{
+    uint32_t ProfileId;
+    uint32_t Type;
+    uint32_t RowCount;
+    ExportColumn *Columns;
+    uint32_t ColumnCount;
+    uint32_t MaxColumns;
+    uint32_t NextColumnHint;            // Events of one type tend to carry the same fields in the same order
+};
+
+/**
+ * A leaf of an event, held until the block the event belongs to is known.
+ */
+struct ExportValue
+{
+    uint64_t Path[kMaxPathDepth];
+    uint8_t PathDepth;
+    uint8_t Type;
+    uint64_t Bits;                      // Numeric value, or offset of the TLV in the scratch buffer
+    const uint8_t *Data;
+    uint32_t Length;
+};
+
+struct UnresolvedEvent
+{
+    uint32_t Block;
+    uint32_t Row;
+    uint8_t Flags;                      // kEventField_* flags of the values relative to the end of the previous chunk
+};
+
+struct ExportChunk
+{
+    uint64_t Start;
+    uint64_t End;
+    ExportBlock *Blocks;
+    uint32_t BlockCount;
+    uint32_t MaxBlocks;
+    uint32_t *BlockSlots;               // Open-addressed table of block index + 1, or 0 if empty
+    uint32_t BlockSlotCount;
+    ExportBuffer Unresolved;            // UnresolvedEvent for each event with a relative id or timestamp
+    ExportBuffer Values;                // ExportValue stack of the events being decoded
+    ExportBuffer Scratch;               // TLV of the values being decoded
+    EventDecodeContext EndContext;
+    uint64_t EventCount;
+    WEAVE_ERROR Error;
+    uint64_t ErrorOffset;
+};
+
+/**
+ * State shared between the thread writing the export, the thread splitting the log into chunks and the worker
+ * threads decoding them.
+ *
+ * Chunks are handed out to the workers in order, as soon as the splitter has found their end.  Workers may run at
+ * most a fixed number of chunks ahead of the output, which bounds the memory held by decoded but unwritten chunks.
+ */
+struct ExportJob
+{
+    pthread_mutex_t Lock;
+    pthread_cond_t ChunkDecoded;        // Signalled when a worker finishes a chunk, or the splitter finishes
+    pthread_cond_t WorkAvailable;       // Signalled when the splitter finds a chunk, or the writer finishes one
+    const uint8_t *Log;
+    uint64_t LogSize;
+    uint32_t ChunkCount;                // Number of chunks found by the splitter
+    uint32_t MaxChunks;
+    uint32_t MaxPendingChunks;
+    uint32_t NextChunk;                 // Next chunk to be handed to a worker
+    uint32_t NextChunkToWrite;
+    ExportChunk *Chunks;
+    bool *ChunkReady;
+    bool SplitDone;
+    bool Failed;
+};
+
+class TLVFileWriter : public TLVWriter
+{
+public:
+    void Init(FILE *file, uint8_t *buf, uint32_t bufSize);
+
+private:
+    static WEAVE_ERROR GetNewFileBuffer(TLVWriter& writer, uintptr_t& bufHandle, uint8_t *& bufStart, uint32_t& bufLen);
+    static WEAVE_ERROR FinalizeFileBuffer(TLVWriter& writer, uintptr_t bufHandle, uint8_t *bufStart, uint32_t bufLen);
+};
+
+static bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg);
+static bool HandleNonOptionArgs(const char *progName, int argc, char *argv[]);
+static void *SplitterMain(void *arg);
+static bool IsChunkBoundary(const TLVReader& reader);
+static bool AddChunk(ExportJob& job, uint64_t end);
+static void *ExportWorkerMain(void *arg);
+static void DecodeChunk(const uint8_t *log, ExportChunk& chunk);
+static WEAVE_ERROR DecodeEvent(TLVReader& reader, EventDecodeContext& context, ExportChunk& chunk);
+static WEAVE_ERROR HandleEventElement(TLVReader& reader, void *appState);
+static WEAVE_ERROR DecodeEventList(TLVReader& reader, ExportChunk& chunk);
+static WEAVE_ERROR AddValues(TLVReader& reader, uint64_t *path, uint8_t pathDepth, ExportChunk& chunk);
+static WEAVE_ERROR AddEventRow(ExportChunk& chunk, const EventHeader& header, size_t valuesStart, uint8_t unresolved);
+static void ResolveChunk(ExportChunk& chunk, EventDecodeContext& context);
+static WEAVE_ERROR WriteChunk(FILE *outFile, const ExportChunk& chunk, uint64_t& bytesWritten);
+static WEAVE_ERROR WriteBlock(TLVWriter& writer, const ExportBlock& block);
+static void GetColumnName(const ExportColumn& column, char *buf, size_t bufSize);
+static void FreeChunk(ExportChunk& chunk);
+
+static OptionDef gCmdOptionDefs[] =
+{
+    { "jobs",       kArgumentRequired, 'j' },
+    { "chunk-size", kArgumentRequired, 'c' },
+    { "rate",       kNoArgument,       'r' },
+    { NULL }
+};
+
+static const char *const gCmdOptionHelp =
+    "   -j, --jobs <num>\n"
+    "\n"
+    "       Decode the log on the given number of threads.  Defaults to the number of\n"
+    "       processors.\n"
+    "\n"
+    "   -c, --chunk-size <bytes>\n"
+    "\n"
+    "       Decode the log in chunks of about the given size.  Defaults to 4194304.\n"
+    "\n"
+    "   -r, --rate\n"
+    "\n"
+    "       Report the export rate on stderr.\n"
+    "\n"
+    ;
+
+static OptionSet gCmdOptions =
+{
+    HandleOption,
+    gCmdOptionDefs,
+    "COMMAND OPTIONS",
+    gCmdOptionHelp
+};
+
+static HelpOptions gHelpOptions(
+    CMD_NAME,
+    "Usage: " CMD_NAME " [ <options...> ] <event-log-file> <out-file>\n",
+    WEAVE_VERSION_STRING "\n" COPYRIGHT_STRING,
+    "Export the events in a captured Weave event log in columnar form.\n"
+    "\n"
+    "The output is a sequence of TLV structures, one for each event type in each chunk of\n"
+    "the log.  Each holds the trait profile id (tag 1), event type (tag 2) and number of\n"
+    "events (tag 3), and an array of columns (tag 4).  Each column holds its name (tag 1),\n"
+    "type (tag 2), a bitmap of the events that have a value (tag 3, omitted if all do),\n"
+    "the packed values (tag 4) and, for strings and nested TLV, a dictionary of the\n"
+    "distinct values (tag 5) into which the values are 4 byte codes.  Event ids and\n"
+    "timestamps are absolute.\n"
+    "\n"
+    "ARGUMENTS\n"
+    "\n"
+    "  <event-log-file>\n"
+    "\n"
+    "       A file containing a sequence of events, as fetched from the event\n"
+    "       log, or of WDM notifications carrying event lists.\n"
+    "\n"
+    "  <out-file>\n"
+    "\n"
+    "       The file to which the columns should be written.\n"
+    "\n"
+);
+
+static OptionSet *gCmdOptionSets[] =
+{
+    &gCmdOptions,
+    &gHelpOptions,
+    NULL
+};
+
+static const char *gLogFileName = NULL;
+static const char *gOutFileName = NULL;
+static int32_t gJobCount = 0;
+static uint32_t gChunkSize = 4 * 1024 * 1024;
+static bool gReportRate = false;
+
+bool Cmd_ExportEvents(int argc, char *argv[])
+{
+    bool res = true;
+    int fd = -1;
+    struct stat st;
+    uint8_t *log = NULL;
+    FILE *outFile = NULL;
+    ExportJob job;
+    EventDecodeContext context;
+    pthread_t splitter, workers[kMaxJobs];
+    bool splitterStarted = false;
+    int32_t workerCount = 0;
+    uint64_t eventCount = 0, blockCount = 0, bytesWritten = 0;
+    struct timespec startTime, endTime;
+
+    memset(&job, 0, sizeof(job));
+    memset(&context, 0, sizeof(context));
+    pthread_mutex_init(&job.Lock, NULL);
+    pthread_cond_init(&job.ChunkDecoded, NULL);
+    pthread_cond_init(&job.WorkAvailable, NULL);
+
+    if (argc == 1)
+    {
+        gHelpOptions.PrintBriefUsage(stderr);
+        ExitNow(res = true);
+    }
+
+    if (!ParseArgs(CMD_NAME, argc, argv, gCmdOptionSets, HandleNonOptionArgs))
+    {
+        ExitNow(res = false);
+    }
+
+    if (gJobCount == 0)
+    {
+        long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+        gJobCount = (cpuCount < 1) ? 1 : (cpuCount > kMaxJobs) ? kMaxJobs : (int32_t)cpuCount;
+    }
+
+    fd = open(gLogFileName, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || fstat(fd, &st) < 0)
+    {
+        fprintf(stderr, "weave: Error reading %s: %s\n", gLogFileName, strerror(errno));
+        ExitNow(res = false);
+    }
+
+    if (st.st_size > 0)
+    {
+        log = static_cast<uint8_t *>(mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0));
+        if (log == MAP_FAILED)
+        {
+            log = NULL;
+            fprintf(stderr, "weave: Error reading %s: %s\n", gLogFileName, strerror(errno));
+            ExitNow(res = false);
+        }
+    }
+
+    outFile = fopen(gOutFileName, "w+b");
+    if (outFile == NULL)
+    {
+        fprintf(stderr, "weave: Unable to create %s: %s\n", gOutFileName, strerror(errno));
+        ExitNow(res = false);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    // Every chunk but the last is at least the chunk size.
+    job.Log = log;
+    job.LogSize = st.st_size;
+    job.MaxChunks = (uint32_t)(job.LogSize / gChunkSize) + 1;
+    job.MaxPendingChunks = gJobCount * kMaxChunksPerJob;
+    job.Chunks = (ExportChunk *)calloc(job.MaxChunks + 1, sizeof(ExportChunk));
+    job.ChunkReady = (bool *)calloc(job.MaxChunks + 1, sizeof(bool));
+    if (job.Chunks == NULL || job.ChunkReady == NULL)
+    {
+        fprintf(stderr, "Memory allocation error\n");
+        ExitNow(res = false);
+    }
+
+    {
+        int err = pthread_create(&splitter, NULL, SplitterMain, &job);
+        if (err != 0)
+        {
+            fprintf(stderr, "weave: Unable to create splitter thread: %s\n", strerror(err));
+            ExitNow(res = false);
+        }
+        splitterStarted = true;
+    }
+
+    for (; workerCount < gJobCount && workerCount < (int32_t)job.MaxChunks; workerCount++)
+    {
+        int err = pthread_create(&workers[workerCount], NULL, ExportWorkerMain, &job);
+        if (err != 0)
+        {
+            fprintf(stderr, "weave: Unable to create worker thread: %s\n", strerror(err));
+            pthread_mutex_lock(&job.Lock);
+            job.Failed = true;
+            pthread_cond_broadcast(&job.WorkAvailable);
+            pthread_mutex_unlock(&job.Lock);
+            ExitNow(res = false);
+        }
+    }
+
+    // Resolve and write each chunk, in order, as soon as it has been decoded.
+    for (uint32_t i = 0; ; i++)
+    {
+        ExportChunk& chunk = job.Chunks[i];
+        WEAVE_ERROR err;
+        bool ready, failed;
+
+        pthread_mutex_lock(&job.Lock);
+        while (!job.ChunkReady[i] && !job.Failed && !(job.SplitDone && i >= job.ChunkCount))
+            pthread_cond_wait(&job.ChunkDecoded, &job.Lock);
+        ready = job.ChunkReady[i];
+        failed = job.Failed;
+        pthread_mutex_unlock(&job.Lock);
+
+        if (failed)
+            ExitNow(res = false);
+
+        if (!ready)
+            break;
+
+        err = chunk.Error;
+        if (err != WEAVE_NO_ERROR)
+        {
+            fprintf(stderr, "weave: Error reading event at offset %" PRIu64 " of %s: %s\n", chunk.ErrorOffset, gLogFileName,
+                    nl::ErrorStr(err));
+        }
+        else
+        {
+            ResolveChunk(chunk, context);
+
+            err = WriteChunk(outFile, chunk, bytesWritten);
+            if (err != WEAVE_NO_ERROR)
+                fprintf(stderr, "weave: Error writing %s: %s\n", gOutFileName, nl::ErrorStr(err));
+        }
+
+        eventCount += chunk.EventCount;
+        blockCount += chunk.BlockCount;
+        FreeChunk(chunk);
+
+        pthread_mutex_lock(&job.Lock);
+        if (err != WEAVE_NO_ERROR)
+            job.Failed = true;
+        job.NextChunkToWrite = i + 1;
+        pthread_cond_broadcast(&job.WorkAvailable);
+        pthread_mutex_unlock(&job.Lock);
+
+        if (err != WEAVE_NO_ERROR)
+            ExitNow(res = false);
+    }
+
+    if (fflush(outFile) != 0 || ferror(outFile))
+    {
+        fprintf(stderr, "weave: Error writing %s: %s\n", gOutFileName, strerror(errno));
+        ExitNow(res = false);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+
+    if (gReportRate)
+    {
+        double elapsed = (endTime.tv_sec - startTime.tv_sec) + (endTime.tv_nsec - startTime.tv_nsec) / 1e9;
+        fprintf(stderr, "Exported %" PRIu64 " events (%" PRIu64 " bytes) into %" PRIu64 " blocks (%" PRIu64 " bytes) in %.3f s "
+                "(%.1f events/s, %.1f MB/s, %d jobs)\n", eventCount, (uint64_t)st.st_size, blockCount, bytesWritten, elapsed,
+                (elapsed > 0) ? eventCount / elapsed : 0.0, (elapsed > 0) ? st.st_size / elapsed / 1e6 : 0.0, (int)gJobCount);
+    }
+
+exit:
+    if (!res)
+    {
+        pthread_mutex_lock(&job.Lock);
+        job.Failed = true;
+        pthread_cond_broadcast(&job.WorkAvailable);
+        pthread_mutex_unlock(&job.Lock);
+    }
+    if (splitterStarted)
+        pthread_join(splitter, NULL);
+    for (int32_t i = 0; i < workerCount; i++)
+        pthread_join(workers[i], NULL);
+    if (job.Chunks != NULL)
+    {
+        for (uint32_t i = 0; i < job.ChunkCount; i++)
+            FreeChunk(job.Chunks[i]);
+        free(job.Chunks);
+    }
+    if (job.ChunkReady != NULL)
+        free(job.ChunkReady);
+    pthread_cond_destroy(&job.WorkAvailable);
+    pthread_cond_destroy(&job.ChunkDecoded);
+    pthread_mutex_destroy(&job.Lock);
+    if (outFile != NULL)
+        fclose(outFile);
+    if (!res && gOutFileName != NULL)
+        unlink(gOutFileName);
+    if (log != NULL)
+        munmap(log, st.st_size);
+    if (fd >= 0)
+        close(fd);
+    return res;
+}
+
+bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg)
+{
+    switch (id)
+    {
+    case 'j':
+        if (!ParseInt(arg, gJobCount) || gJobCount <= 0 || gJobCount > kMaxJobs)
+        {
+            PrintArgError("%s: Invalid value specified for number of jobs: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    case 'c':
+        if (!ParseInt(arg, gChunkSize) || gChunkSize < 4096)
+        {
+            PrintArgError("%s: Invalid value specified for chunk size: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    case 'r':
+        gReportRate = true;
+        break;
+    default:
+        PrintArgError("%s: INTERNAL ERROR: Unhandled option: %s\n", progName, name);
+        return false;
+    }
+
+    return true;
+}
+
+bool HandleNonOptionArgs(const char *progName, int argc, char *argv[])
+{
+    if (argc == 0)
+    {
+        PrintArgError("%s: Please specify the name of the event log file.\n", progName);
+        return false;
+    }
+
+    if (argc == 1)
+    {
+        PrintArgError("%s: Please specify the name of the output file.\n", progName);
+        return false;
+    }
+
+    if (argc > 2)
+    {
+        PrintArgError("%s: Unexpected argument: %s\n", progName, argv[2]);
+        return false;
+    }
+
+    gLogFileName = argv[0];
+    gOutFileName = argv[1];
+
+    return true;
+}
+
+static bool GrowBuffer(ExportBuffer& buf, size_t needed)
+{
+    if (buf.Length + needed > buf.Capacity)
+    {
+        size_t newCapacity = (buf.Capacity != 0) ? buf.Capacity * 2 : 256;
+        uint8_t *newData;
+
+        while (newCapacity < buf.Length + needed)
+            newCapacity *= 2;
+
+        newData = (uint8_t *)realloc(buf.Data, newCapacity);
+        if (newData == NULL)
+            return false;
+
+        buf.Data = newData;
+        buf.Capacity = newCapacity;
+    }
+
+    return true;
+}
+
+static void FreeBuffer(ExportBuffer& buf)
+{
+    free(buf.Data);
+    memset(&buf, 0, sizeof(buf));
+}
+
+static uint32_t HashBytes(const uint8_t *data, uint32_t len)
+{
+    uint32_t hash = 2166136261u;
+
+    for (uint32_t i = 0; i < len; i++)
+        hash = (hash ^ data[i]) * 16777619u;
+
+    return hash;
+}
+
+/**
+ * Split the log into chunks at the top-level elements nearest the chunk size.
+ *
+ * Chunks only start at WDM notifications, which are decoded afresh, or at events that
+ * give their importance and type, so that each chunk can be assigned to blocks on its own.
+ * Every event written by LoggingManagement qualifies.
+ */
+void *SplitterMain(void *arg)
+{
+    ExportJob *job = (ExportJob *)arg;
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TLVReader reader;
+    const uint8_t *log = job->Log;
+    uint64_t offset = 0, nextSplit = gChunkSize;
+
+    // Read each top-level element with a fresh reader, so that logs larger than a reader can count are handled.
+    while (offset < job->LogSize)
+    {
+        uint64_t remaining = job->LogSize - offset;
+
+        reader.Init(log + offset, (remaining < UINT32_MAX) ? (uint32_t)remaining : UINT32_MAX);
+
+        err = reader.Next();
+        SuccessOrExit(err);
+
+        if (offset >= nextSplit && IsChunkBoundary(reader))
+        {
+            VerifyOrExit(AddChunk(*job, offset), );
+            nextSplit = offset + gChunkSize;
+        }
+
+        err = reader.Skip();
+        SuccessOrExit(err);
+
+        offset = reader.GetReadPoint() - log;
+    }
+
+    if (offset > 0)
+        AddChunk(*job, offset);
+
+exit:
+    pthread_mutex_lock(&job->Lock);
+    if (err != WEAVE_NO_ERROR && !job->Failed)
+    {
+        fprintf(stderr, "weave: Error reading event at offset %" PRIu64 " of %s: %s\n", offset, gLogFileName, nl::ErrorStr(err));
+        job->Failed = true;
+    }
+    job->SplitDone = true;
+    pthread_cond_broadcast(&job->WorkAvailable);
+    pthread_cond_broadcast(&job->ChunkDecoded);
+    pthread_mutex_unlock(&job->Lock);
+
+    return NULL;
+}
+
+/**
+ * Hand the chunk ending at the given offset to the workers.
+ *
+ * @return false if the export has failed and splitting should stop.
+ */
+bool AddChunk(ExportJob& job, uint64_t end)
+{
+    bool res;
+
+    pthread_mutex_lock(&job.Lock);
+
+    res = !job.Failed;
+    if (res)
+    {
+        job.Chunks[job.ChunkCount].End = end;
+        job.Chunks[job.ChunkCount + 1].Start = end;
+        job.ChunkCount++;
+        pthread_cond_broadcast(&job.WorkAvailable);
+    }
+
+    pthread_mutex_unlock(&job.Lock);
+
+    return res;
+}
+
+bool IsChunkBoundary(const TLVReader& elemReader)
+{
+    TLVReader reader;
+    TLVType outerContainerType;
+    bool hasImportance = false, hasType = false;
+
+    if (elemReader.GetType() != kTLVType_Structure)
+        return false;
+
+    reader.Init(elemReader);
+
+    if (reader.EnterContainer(outerContainerType) != WEAVE_NO_ERROR)
+        return false;
+
+    while (reader.Next() == WEAVE_NO_ERROR)
+    {
+        const uint64_t tag = reader.GetTag();
+
+        if (tag == ContextTag(NotificationRequest::kCsTag_EventList))
+            return true;
+
+        hasImportance = hasImportance || tag == ContextTag(Event::kCsTag_Importance);
+        hasType = hasType || tag == ContextTag(Event::kCsTag_Type);
+
+        if (hasImportance && hasType)
+            return true;
+    }
+
+    return false;
+}
+
+void *ExportWorkerMain(void *arg)
+{
+    ExportJob *job = (ExportJob *)arg;
+
+    pthread_mutex_lock(&job->Lock);
+
+    while (true)
+    {
+        uint32_t chunkNum;
+
+        while (!job->Failed && !(job->SplitDone && job->NextChunk >= job->ChunkCount) &&
+               (job->NextChunk >= job->ChunkCount || job->NextChunk >= job->NextChunkToWrite + job->MaxPendingChunks))
+            pthread_cond_wait(&job->WorkAvailable, &job->Lock);
+
+        if (job->Failed || job->NextChunk >= job->ChunkCount)
+            break;
+
+        chunkNum = job->NextChunk++;
+        pthread_mutex_unlock(&job->Lock);
+
+        DecodeChunk(job->Log, job->Chunks[chunkNum]);
+
+        pthread_mutex_lock(&job->Lock);
+        job->ChunkReady[chunkNum] = true;
+        pthread_cond_broadcast(&job->ChunkDecoded);
+    }
+
+    pthread_mutex_unlock(&job->Lock);
+
+    return NULL;
+}
+
+void DecodeChunk(const uint8_t *log, ExportChunk& chunk)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    EventDecodeContext context;
+    TLVReader reader;
+    uint64_t offset = chunk.Start;
+
+    // The first chunk starts from the initial context; the others start relative to the end of the chunk before them.
+    memset(&context, 0, sizeof(context));
+    if (chunk.Start != 0)
+        context.Unresolved = kEventField_Id | kEventField_SystemTimestamp | kEventField_UTCTimestamp;
+
+    while (offset < chunk.End)
+    {
+        uint64_t remaining = chunk.End - offset;
+
+        reader.Init(log + offset, (remaining < UINT32_MAX) ? (uint32_t)remaining : UINT32_MAX);
+
+        err = reader.Next();
+        SuccessOrExit(err);
+
+        err = DecodeEvent(reader, context, chunk);
+        SuccessOrExit(err);
+
+        offset = reader.GetReadPoint() - log;
+    }
+
+    chunk.EndContext = context;
+
+exit:
+    FreeBuffer(chunk.Values);
+    FreeBuffer(chunk.Scratch);
+    if (err != WEAVE_NO_ERROR)
+    {
+        chunk.Error = err;
+        chunk.ErrorOffset = offset;
+    }
+}
+
+WEAVE_ERROR DecodeEvent(TLVReader& reader, EventDecodeContext& context, ExportChunk& chunk)
+{
+    WEAVE_ERROR err;
+    const size_t valuesStart = chunk.Values.Length, scratchStart = chunk.Scratch.Length;
+    EventHeader header;
+    uint8_t unresolved;
+
+    err = DecodeEventHeader(reader, context, header, HandleEventElement, &chunk);
+    SuccessOrExit(err);
+
+    VerifyOrExit(!header.IsEventList, );
+
+    unresolved = context.Unresolved & (kEventField_Id | header.Fields);
+
+    err = AddEventRow(chunk, header, valuesStart, unresolved);
+    SuccessOrExit(err);
+
+exit:
+    chunk.Values.Length = valuesStart;
+    chunk.Scratch.Length = scratchStart;
+    return err;
+}
+
+/**
+ * Add an element of an event, other than its header, to the values of the event.
+ */
+WEAVE_ERROR HandleEventElement(TLVReader& reader, void *appState)
+{
+    ExportChunk& chunk = *static_cast<ExportChunk *>(appState);
+    uint64_t path[kMaxPathDepth];
+
+    if (reader.GetTag() == ContextTag(NotificationRequest::kCsTag_EventList))
+        return DecodeEventList(reader, chunk);
+
+    path[0] = reader.GetTag();
+    return AddValues(reader, path, 1, chunk);
+}
+
+WEAVE_ERROR DecodeEventList(TLVReader& reader, ExportChunk& chunk)
+{
+    WEAVE_ERROR err;
+    EventDecodeContext context;
+    TLVType outerContainerType;
+
+    // As in EventProcessor::ParseEventList(), each list of events is decoded afresh.
+    memset(&context, 0, sizeof(context));
+
+    err = reader.EnterContainer(outerContainerType);
+    SuccessOrExit(err);
+
+    while ((err = reader.Next()) == WEAVE_NO_ERROR)
+    {
+        err = DecodeEvent(reader, context, chunk);
+        SuccessOrExit(err);
+    }
+    VerifyOrExit(err == WEAVE_END_OF_TLV, );
+
+    err = reader.ExitContainer(outerContainerType);
+
+exit:
+    return err;
+}
+
+/**
+ * Add the leaves of an element of an event to the values of the event, flattening
+ * structures into one value for each of their members.
+ */
+WEAVE_ERROR AddValues(TLVReader& reader, uint64_t *path, uint8_t pathDepth, ExportChunk& chunk)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    ExportValue *value;
+    const TLVType type = reader.GetType();
+
+    if (type == kTLVType_Structure && pathDepth < kMaxPathDepth)
+    {
+        TLVType outerContainerType;
+
+        err = reader.EnterContainer(outerContainerType);
+        SuccessOrExit(err);
+
+        while ((err = reader.Next()) == WEAVE_NO_ERROR)
+        {
+            path[pathDepth] = reader.GetTag();
+            err = AddValues(reader, path, pathDepth + 1, chunk);
+            SuccessOrExit(err);
+        }
+        VerifyOrExit(err == WEAVE_END_OF_TLV, );
+
+        ExitNow(err = reader.ExitContainer(outerContainerType));
+    }
+
+    // Nulls are exported as missing values.
+    VerifyOrExit(type != kTLVType_Null, );
+
+    VerifyOrExit(GrowBuffer(chunk.Values, sizeof(ExportValue)), err = WEAVE_ERROR_NO_MEMORY);
+    value = (ExportValue *)(chunk.Values.Data + chunk.Values.Length);
+    memcpy(value->Path, path, pathDepth * sizeof(uint64_t));
+    value->PathDepth = pathDepth;
+    value->Data = NULL;
+    value->Length = 0;
+    value->Bits = 0;
+
+    switch (type)
+    {
+    case kTLVType_SignedInteger:
+    {
+        int64_t v;
+        err = reader.Get(v);
+        value->Type = kColumnType_Int;
+        value->Bits = (uint64_t)v;
+        break;
+    }
+    case kTLVType_UnsignedInteger:
+        err = reader.Get(value->Bits);
+        value->Type = kColumnType_UInt;
+        break;
+    case kTLVType_FloatingPointNumber:
+    {
+        double v;
+        err = reader.Get(v);
+        value->Type = kColumnType_Float;
+        memcpy(&value->Bits, &v, sizeof(v));
+        break;
+    }
+    case kTLVType_Boolean:
+    {
+        bool v;
+        err = reader.Get(v);
+        value->Type = kColumnType_Bool;
+        value->Bits = v;
+        break;
+    }
+    case kTLVType_UTF8String:
+    case kTLVType_ByteString:
+        value->Type = (type == kTLVType_UTF8String) ? kColumnType_String : kColumnType_Bytes;
+        value->Length = reader.GetLength();
+        err = reader.GetDataPtr(value->Data);
+        break;
+    default:
+    {
+        // Arrays, paths and deeply nested structures are kept as TLV.
+        TLVWriter writer;
+        TLVReader copy;
+
+        value->Type = kColumnType_TLV;
+        value->Bits = chunk.Scratch.Length;
+
+        while (true)
+        {
+            const size_t avail = chunk.Scratch.Capacity - chunk.Scratch.Length;
+
+            copy.Init(reader);
+            writer.Init(chunk.Scratch.Data + chunk.Scratch.Length, (avail < UINT32_MAX) ? (uint32_t)avail : UINT32_MAX);
+            err = writer.CopyElement(AnonymousTag, copy);
+            if (err == WEAVE_NO_ERROR)
+                err = writer.Finalize();
+            if (err != WEAVE_ERROR_BUFFER_TOO_SMALL)
+                break;
+            VerifyOrExit(GrowBuffer(chunk.Scratch, chunk.Scratch.Capacity - chunk.Scratch.Length + 256),
+                         err = WEAVE_ERROR_NO_MEMORY);
+        }
+        SuccessOrExit(err);
+
+        value->Length = writer.GetLengthWritten();
+        chunk.Scratch.Length += value->Length;
+        break;
+    }
+    }
+    SuccessOrExit(err);
+
+    chunk.Values.Length += sizeof(ExportValue);
+
+exit:
+    return err;
+}
+
+static uint8_t GetValueWidth(uint8_t type)
+{
+    switch (type)
+    {
+    case kColumnType_Bool:
+        return 1;
+    case kColumnType_String:
+    case kColumnType_Bytes:
+    case kColumnType_TLV:
+        return 4;
+    default:
+        return 8;
+    }
+}
+
+static bool IsDictionaryType(uint8_t type)
+{
+    return type == kColumnType_String || type == kColumnType_Bytes || type == kColumnType_TLV;
+}
+
+static WEAVE_ERROR AppendColumnValue(ExportColumn& column, bool present, uint64_t bits, const uint8_t *data, uint32_t len)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    const uint8_t width = GetValueWidth(column.Type);
+    const uint32_t row = column.RowCount;
+
+    VerifyOrExit(GrowBuffer(column.Values, width), err = WEAVE_ERROR_NO_MEMORY);
+    VerifyOrExit(GrowBuffer(column.Present, 1), err = WEAVE_ERROR_NO_MEMORY);
+
+    if (row % 8 == 0)
+        column.Present.Data[column.Present.Length++] = 0;
+
+    if (present)
+        column.Present.Data[row / 8] |= (uint8_t)(1 << (row % 8));
+    else
+        column.HasNulls = true;
+
+    if (present && IsDictionaryType(column.Type))
+    {
+        const uint32_t hash = HashBytes(data, len);
+        DictionaryEntry *entries;
+        uint32_t slot, code;
+
+        // Keep the table at most half full.
+        if ((column.DictEntries.Length / sizeof(DictionaryEntry) + 1) * 2 > column.DictSlotCount)
+        {
+            const uint32_t newSlotCount = (column.DictSlotCount != 0) ? column.DictSlotCount * 2 : 64;
+            uint32_t *newSlots = (uint32_t *)calloc(newSlotCount, sizeof(uint32_t));
+
+            VerifyOrExit(newSlots != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+            entries = (DictionaryEntry *)column.DictEntries.Data;
+            for (uint32_t i = 0; i < column.DictEntries.Length / sizeof(DictionaryEntry); i++)
+            {
+                for (slot = entries[i].Hash & (newSlotCount - 1); newSlots[slot] != 0; slot = (slot + 1) & (newSlotCount - 1))
+                    ;
+                newSlots[slot] = i + 1;
+            }
+
+            free(column.DictSlots);
+            column.DictSlots = newSlots;
+            column.DictSlotCount = newSlotCount;
+        }
+
+        entries = (DictionaryEntry *)column.DictEntries.Data;
+        for (slot = hash & (column.DictSlotCount - 1); column.DictSlots[slot] != 0; slot = (slot + 1) & (column.DictSlotCount - 1))
+        {
+            const DictionaryEntry& entry = entries[column.DictSlots[slot] - 1];
+
+            if (entry.Hash == hash && entry.Length == len && memcmp(column.DictData.Data + entry.Offset, data, len) == 0)
+                break;
+        }
+
+        if (column.DictSlots[slot] == 0)
+        {
+            DictionaryEntry *entry;
+
+            VerifyOrExit(column.DictData.Length + len <= UINT32_MAX, err = WEAVE_ERROR_NO_MEMORY);
+            VerifyOrExit(GrowBuffer(column.DictEntries, sizeof(DictionaryEntry)), err = WEAVE_ERROR_NO_MEMORY);
+            VerifyOrExit(GrowBuffer(column.DictData, len), err = WEAVE_ERROR_NO_MEMORY);
+
+            entry = (DictionaryEntry *)(column.DictEntries.Data + column.DictEntries.Length);
+            entry->Offset = (uint32_t)column.DictData.Length;
+            entry->Length = len;
+            entry->Hash = hash;
+            memcpy(column.DictData.Data + column.DictData.Length, data, len);
+            column.DictData.Length += len;
+            column.DictEntries.Length += sizeof(DictionaryEntry);
+
+            column.DictSlots[slot] = (uint32_t)(column.DictEntries.Length / sizeof(DictionaryEntry));
+        }
+
+        code = column.DictSlots[slot] - 1;
+        bits = code;
+    }
+    else if (!present)
+    {
+        bits = 0;
+    }
+
+    switch (width)
+    {
+    case 1:
+        column.Values.Data[column.Values.Length] = (uint8_t)bits;
+        break;
+    case 4:
+        LittleEndian::Put32(column.Values.Data + column.Values.Length, (uint32_t)bits);
+        break;
+    default:
+        LittleEndian::Put64(column.Values.Data + column.Values.Length, bits);
+        break;
+    }
+    column.Values.Length += width;
+    column.RowCount++;
+
+exit:
+    return err;
+}
+
+static WEAVE_ERROR AddColumn(ExportBlock& block, const uint64_t *path, uint8_t pathDepth, uint8_t type, uint32_t& columnIndex)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    ExportColumn *column;
+
+    if (block.ColumnCount == block.MaxColumns)
+    {
+        uint32_t newMaxColumns = (block.MaxColumns != 0) ? block.MaxColumns * 2 : 16;
+        ExportColumn *newColumns = (ExportColumn *)realloc(block.Columns, newMaxColumns * sizeof(ExportColumn));
+
+        VerifyOrExit(newColumns != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        block.Columns = newColumns;
+        block.MaxColumns = newMaxColumns;
+    }
+
+    columnIndex = block.ColumnCount++;
+    column = &block.Columns[columnIndex];
+    memset(column, 0, sizeof(ExportColumn));
+    memcpy(column->Path, path, pathDepth * sizeof(uint64_t));
+    column->PathDepth = pathDepth;
+    column->Type = type;
+
+    // Earlier events in the block had no value for the column.
+    while (column->RowCount < block.RowCount)
+    {
+        err = AppendColumnValue(*column, false, 0, NULL, 0);
+        SuccessOrExit(err);
+    }
+
+exit:
+    return err;
+}
+
+static bool ColumnMatches(const ExportColumn& column, const ExportValue& value)
+{
+    return column.Type == value.Type && column.PathDepth == value.PathDepth &&
+        memcmp(column.Path, value.Path, value.PathDepth * sizeof(uint64_t)) == 0;
+}
+
+static WEAVE_ERROR FindBlock(ExportChunk& chunk, uint32_t profileId, uint32_t type, uint32_t& blockIndex)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    const uint32_t hash = HashBytes((const uint8_t *)&profileId, sizeof(profileId)) ^ (type * 2654435761u);
+    uint32_t slot;
+
+    if ((chunk.BlockCount + 1) * 2 > chunk.BlockSlotCount)
+    {
+        const uint32_t newSlotCount = (chunk.BlockSlotCount != 0) ? chunk.BlockSlotCount * 2 : 64;
+        uint32_t *newSlots = (uint32_t *)calloc(newSlotCount, sizeof(uint32_t));
+
+        VerifyOrExit(newSlots != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        for (uint32_t i = 0; i < chunk.BlockCount; i++)
+        {
+            const uint32_t h = HashBytes((const uint8_t *)&chunk.Blocks[i].ProfileId, sizeof(uint32_t)) ^
+                (chunk.Blocks[i].Type * 2654435761u);
+
+            for (slot = h & (newSlotCount - 1); newSlots[slot] != 0; slot = (slot + 1) & (newSlotCount - 1))
+                ;
+            newSlots[slot] = i + 1;
+        }
+
+        free(chunk.BlockSlots);
+        chunk.BlockSlots = newSlots;
+        chunk.BlockSlotCount = newSlotCount;
+    }
+
+    for (slot = hash & (chunk.BlockSlotCount - 1); chunk.BlockSlots[slot] != 0; slot = (slot + 1) & (chunk.BlockSlotCount - 1))
+    {
+        const ExportBlock& block = chunk.Blocks[chunk.BlockSlots[slot] - 1];
+
+        if (block.ProfileId == profileId && block.Type == type)
+            ExitNow(blockIndex = chunk.BlockSlots[slot] - 1);
+    }
+
+    if (chunk.BlockCount == chunk.MaxBlocks)
+    {
+        uint32_t newMaxBlocks = (chunk.MaxBlocks != 0) ? chunk.MaxBlocks * 2 : 16;
+        ExportBlock *newBlocks = (ExportBlock *)realloc(chunk.Blocks, newMaxBlocks * sizeof(ExportBlock));
+
+        VerifyOrExit(newBlocks != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        chunk.Blocks = newBlocks;
+        chunk.MaxBlocks = newMaxBlocks;
+    }
+
+    blockIndex = chunk.BlockCount++;
+    chunk.BlockSlots[slot] = blockIndex + 1;
+
+    {
+        ExportBlock& block = chunk.Blocks[blockIndex];
+        static const uint32_t sFixedColumnTags[kFixedColumnCount] =
+            { Event::kCsTag_Id, Event::kCsTag_Importance, Event::kCsTag_SystemTimestamp, Event::kCsTag_UTCTimestamp };
+
+        memset(&block, 0, sizeof(block));
+        block.ProfileId = profileId;
+        block.Type = type;
+
+        for (uint32_t i = 0; i < kFixedColumnCount; i++)
+        {
+            const uint64_t path = ContextTag(sFixedColumnTags[i]);
+            uint32_t columnIndex;
+
+            err = AddColumn(block, &path, 1, kColumnType_UInt, columnIndex);
+            SuccessOrExit(err);
+        }
+
+        block.NextColumnHint = kFixedColumnCount;
+    }
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR AddEventRow(ExportChunk& chunk, const EventHeader& header, size_t valuesStart, uint8_t unresolved)
+{
+    WEAVE_ERROR err;
+    uint32_t blockIndex;
+    const ExportValue *values = (const ExportValue *)(chunk.Values.Data + valuesStart);
+    const uint32_t valueCount = (uint32_t)((chunk.Values.Length - valuesStart) / sizeof(ExportValue));
+
+    err = FindBlock(chunk, header.ProfileId, header.Type, blockIndex);
+    SuccessOrExit(err);
+
+    {
+        ExportBlock& block = chunk.Blocks[blockIndex];
+        const uint32_t row = block.RowCount;
+
+        VerifyOrExit(row != UINT32_MAX, err = WEAVE_ERROR_NO_MEMORY);
+
+        err = AppendColumnValue(block.Columns[kColumn_EventId], true, header.Id, NULL, 0);
+        SuccessOrExit(err);
+        err = AppendColumnValue(block.Columns[kColumn_Importance], true, header.Importance, NULL, 0);
+        SuccessOrExit(err);
+        err = AppendColumnValue(block.Columns[kColumn_SystemTimestamp], (header.Fields & kEventField_SystemTimestamp) != 0,
+                                header.SystemTimestamp, NULL, 0);
+        SuccessOrExit(err);
+        err = AppendColumnValue(block.Columns[kColumn_UTCTimestamp], (header.Fields & kEventField_UTCTimestamp) != 0,
+                                header.UTCTimestamp, NULL, 0);
+        SuccessOrExit(err);
+
+        for (uint32_t i = 0; i < valueCount; i++)
+        {
+            const ExportValue& value = values[i];
+            uint32_t columnIndex = block.NextColumnHint;
+
+            if (columnIndex >= block.ColumnCount || !ColumnMatches(block.Columns[columnIndex], value))
+            {
+                for (columnIndex = kFixedColumnCount; columnIndex < block.ColumnCount; columnIndex++)
+                    if (ColumnMatches(block.Columns[columnIndex], value))
+                        break;
+
+                if (columnIndex == block.ColumnCount)
+                {
+                    err = AddColumn(block, value.Path, value.PathDepth, value.Type, columnIndex);
+                    SuccessOrExit(err);
+                }
+            }
+
+            block.NextColumnHint = columnIndex + 1;
+
+            // Only the first of repeated fields is kept.
+            if (block.Columns[columnIndex].RowCount > row)
+                continue;
+
+            err = AppendColumnValue(block.Columns[columnIndex], true, value.Bits,
+                                    (value.Type == kColumnType_TLV) ? chunk.Scratch.Data + value.Bits : value.Data, value.Length);
+            SuccessOrExit(err);
+        }
+
+        block.NextColumnHint = kFixedColumnCount;
+
+        // Pad the columns for which the event had no value.
+        for (uint32_t i = kFixedColumnCount; i < block.ColumnCount; i++)
+        {
+            if (block.Columns[i].RowCount == row)
+            {
+                err = AppendColumnValue(block.Columns[i], false, 0, NULL, 0);
+                SuccessOrExit(err);
+            }
+        }
+
+        block.RowCount++;
+        chunk.EventCount++;
+
+        if (unresolved != 0)
+        {
+            UnresolvedEvent *event;
+
+            VerifyOrExit(GrowBuffer(chunk.Unresolved, sizeof(UnresolvedEvent)), err = WEAVE_ERROR_NO_MEMORY);
+            event = (UnresolvedEvent *)(chunk.Unresolved.Data + chunk.Unresolved.Length);
+            event->Block = blockIndex;
+            event->Row = row;
+            event->Flags = unresolved;
+            chunk.Unresolved.Length += sizeof(UnresolvedEvent);
+        }
+    }
+
+exit:
+    return err;
+}
+
+/**
+ * Make the ids and timestamps of a chunk absolute, given the context at the end of the
+ * chunk before it, and advance the context to the end of the chunk.
+ */
+void ResolveChunk(ExportChunk& chunk, EventDecodeContext& context)
+{
+    const UnresolvedEvent *events = (const UnresolvedEvent *)chunk.Unresolved.Data;
+    const uint32_t eventCount = (uint32_t)(chunk.Unresolved.Length / sizeof(UnresolvedEvent));
+    static const struct
+    {
+        uint8_t Flag;
+        uint8_t Column;
+    } sResolvedColumns[] =
+    {
+        { kEventField_Id,              kColumn_EventId         },
+        { kEventField_SystemTimestamp, kColumn_SystemTimestamp },
+        { kEventField_UTCTimestamp,    kColumn_UTCTimestamp    },
+    };
+    const uint64_t bases[] = { context.Id, context.SystemTimestamp, context.UTCTimestamp };
+
+    for (uint32_t i = 0; i < eventCount; i++)
+    {
+        ExportBlock& block = chunk.Blocks[events[i].Block];
+
+        for (size_t j = 0; j < sizeof(sResolvedColumns) / sizeof(sResolvedColumns[0]); j++)
+        {
+            if (events[i].Flags & sResolvedColumns[j].Flag)
+            {
+                uint8_t *p = block.Columns[sResolvedColumns[j].Column].Values.Data + events[i].Row * sizeof(uint64_t);
+                LittleEndian::Put64(p, LittleEndian::Get64(p) + bases[j]);
+            }
+        }
+    }
+
+    context.Id = (chunk.EndContext.Unresolved & kEventField_Id) ? context.Id + chunk.EndContext.Id : chunk.EndContext.Id;
+    context.SystemTimestamp = (chunk.EndContext.Unresolved & kEventField_SystemTimestamp) ?
+        context.SystemTimestamp + chunk.EndContext.SystemTimestamp : chunk.EndContext.SystemTimestamp;
+    context.UTCTimestamp = (chunk.EndContext.Unresolved & kEventField_UTCTimestamp) ?
+        context.UTCTimestamp + chunk.EndContext.UTCTimestamp : chunk.EndContext.UTCTimestamp;
+}
+
+WEAVE_ERROR WriteChunk(FILE *outFile, const ExportChunk& chunk, uint64_t& bytesWritten)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TLVFileWriter writer;
+    static uint8_t sOutputBuffer[kOutputBufferSize];
+
+    for (uint32_t i = 0; i < chunk.BlockCount; i++)
+    {
+        writer.Init(outFile, sOutputBuffer, sizeof(sOutputBuffer));
+
+        err = WriteBlock(writer, chunk.Blocks[i]);
+        SuccessOrExit(err);
+
+        err = writer.Finalize();
+        SuccessOrExit(err);
+
+        bytesWritten += writer.GetLengthWritten();
+    }
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR WriteBlock(TLVWriter& writer, const ExportBlock& block)
+{
+    WEAVE_ERROR err;
+    TLVType blockContainerType, columnsContainerType, columnContainerType, dictContainerType;
+    char name[256];
+
+    err = writer.StartContainer(AnonymousTag, kTLVType_Structure, blockContainerType);
+    SuccessOrExit(err);
+
+    err = writer.Put(ContextTag(kTag_Block_ProfileId), block.ProfileId);
+    SuccessOrExit(err);
+    err = writer.Put(ContextTag(kTag_Block_EventType), block.Type);
+    SuccessOrExit(err);
+    err = writer.Put(ContextTag(kTag_Block_RowCount), block.RowCount);
+    SuccessOrExit(err);
+
+    err = writer.StartContainer(ContextTag(kTag_Block_Columns), kTLVType_Array, columnsContainerType);
+    SuccessOrExit(err);
+
+    for (uint32_t i = 0; i < block.ColumnCount; i++)
+    {
+        const ExportColumn& column = block.Columns[i];
+
+        err = writer.StartContainer(AnonymousTag, kTLVType_Structure, columnContainerType);
+        SuccessOrExit(err);
+
+        GetColumnName(column, name, sizeof(name));
+        err = writer.PutString(ContextTag(kTag_Column_Name), name);
+        SuccessOrExit(err);
+        err = writer.Put(ContextTag(kTag_Column_Type), column.Type);
+        SuccessOrExit(err);
+
+        if (column.HasNulls)
+        {
+            err = writer.PutBytes(ContextTag(kTag_Column_Present), column.Present.Data, (uint32_t)column.Present.Length);
+            SuccessOrExit(err);
+        }
+
+        VerifyOrExit(column.Values.Length <= UINT32_MAX, err = WEAVE_ERROR_MESSAGE_TOO_LONG);
+        err = writer.PutBytes(ContextTag(kTag_Column_Values), column.Values.Data, (uint32_t)column.Values.Length);
+        SuccessOrExit(err);
+
+        if (IsDictionaryType(column.Type))
+        {
+            const DictionaryEntry *entries = (const DictionaryEntry *)column.DictEntries.Data;
+            const uint32_t entryCount = (uint32_t)(column.DictEntries.Length / sizeof(DictionaryEntry));
+
+            err = writer.StartContainer(ContextTag(kTag_Column_Dictionary), kTLVType_Array, dictContainerType);
+            SuccessOrExit(err);
+
+            for (uint32_t j = 0; j < entryCount; j++)
+            {
+                const uint8_t *data = column.DictData.Data + entries[j].Offset;
+
+                if (column.Type == kColumnType_String)
+                    err = writer.PutString(AnonymousTag, (const char *)data, entries[j].Length);
+                else
+                    err = writer.PutBytes(AnonymousTag, data, entries[j].Length);
+                SuccessOrExit(err);
+            }
+
+            err = writer.EndContainer(dictContainerType);
+            SuccessOrExit(err);
+        }
+
+        err = writer.EndContainer(columnContainerType);
+        SuccessOrExit(err);
+    }
+
+    err = writer.EndContainer(columnsContainerType);
+    SuccessOrExit(err);
+
+    err = writer.EndContainer(blockContainerType);
+
+exit:
+    return err;
+}
+
+void GetColumnName(const ExportColumn& column, char *buf, size_t bufSize)
+{
+    size_t len = 0;
+
+    for (uint8_t i = 0; i < column.PathDepth && len < bufSize; i++)
+    {
+        const uint64_t tag = column.Path[i];
+        const char *fieldName = NULL;
+
+        if (i == 0 && IsContextTag(tag))
+        {
+            switch (TagNumFromTag(tag))
+            {
+            case Event::kCsTag_Source:              fieldName = "Source"; break;
+            case Event::kCsTag_Importance:          fieldName = "Importance"; break;
+            case Event::kCsTag_Id:                  fieldName = "EventId"; break;
+            case Event::kCsTag_RelatedImportance:   fieldName = "RelatedImportance"; break;
+            case Event::kCsTag_RelatedId:           fieldName = "RelatedEventId"; break;
+            case Event::kCsTag_UTCTimestamp:        fieldName = "UTCTimestamp"; break;
+            case Event::kCsTag_SystemTimestamp:     fieldName = "SystemTimestamp"; break;
+            case Event::kCsTag_ResourceId:          fieldName = "ResourceId"; break;
+            case Event::kCsTag_TraitInstanceId:     fieldName = "TraitInstanceId"; break;
+            case Event::kCsTag_Data:                fieldName = "Data"; break;
+            }
+        }
+
+        if (fieldName != NULL)
+            len += snprintf(buf + len, bufSize - len, "%s", fieldName);
+        else if (IsContextTag(tag))
+            len += snprintf(buf + len, bufSize - len, "%s%" PRIu32, (i > 0) ? "." : "", TagNumFromTag(tag));
+        else if (IsProfileTag(tag))
+            len += snprintf(buf + len, bufSize - len, "%s0x%08" PRIX32 ":%" PRIu32, (i > 0) ? "." : "", ProfileIdFromTag(tag),
+                            TagNumFromTag(tag));
+        else
+            len += snprintf(buf + len, bufSize - len, "%s*", (i > 0) ? "." : "");
+    }
+}
+
+void FreeChunk(ExportChunk& chunk)
+{
+    for (uint32_t i = 0; i < chunk.BlockCount; i++)
+    {
+        ExportBlock& block = chunk.Blocks[i];
+
+        for (uint32_t j = 0; j < block.ColumnCount; j++)
+        {
+            ExportColumn& column = block.Columns[j];
+
+            FreeBuffer(column.Values);
+            FreeBuffer(column.Present);
+            FreeBuffer(column.DictEntries);
+            FreeBuffer(column.DictData);
+            free(column.DictSlots);
+        }
+
+        free(block.Columns);
+    }
+
+    free(chunk.Blocks);
+    free(chunk.BlockSlots);
+    FreeBuffer(chunk.Unresolved);
+    FreeBuffer(chunk.Values);
+    FreeBuffer(chunk.Scratch);
+
+    chunk.Blocks = NULL;
+    chunk.BlockSlots = NULL;
+    chunk.BlockCount = chunk.MaxBlocks = chunk.BlockSlotCount = 0;
+}
+
+void TLVFileWriter::Init(FILE *file, uint8_t *buf, uint32_t bufSize)
+{
+    TLVWriter::Init(buf, bufSize);
+    mMaxLen = UINT32_MAX;
+    AppData = file;
+    GetNewBuffer = GetNewFileBuffer;
+    FinalizeBuffer = FinalizeFileBuffer;
+}
+
+WEAVE_ERROR TLVFileWriter::GetNewFileBuffer(TLVWriter& writer, uintptr_t& bufHandle, uint8_t *& bufStart, uint32_t& bufLen)
+{
+    // The previous buffer has been written out, so it can be reused.
+    bufLen = kOutputBufferSize;
+    return WEAVE_NO_ERROR;
+}
+
+WEAVE_ERROR TLVFileWriter::FinalizeFileBuffer(TLVWriter& writer, uintptr_t bufHandle, uint8_t *bufStart, uint32_t bufLen)
+{
+    FILE *file = (FILE *)writer.AppData;
+
+    if (bufLen > 0 && fwrite(bufStart, 1, bufLen, file) != bufLen)
+        return nl::Weave::System::MapErrorPOSIX(errno);
+
+    return WEAVE_NO_ERROR;
+}
@@ -32,9 +32,11 @@
 #include <getopt.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "weave-tool.h"
@@ -45,12 +47,17 @@ using namespace nl::Weave::ASN1;
 
 #define CMD_NAME "weave gen-provisioning-data"
 
+struct ProvisioningJob;
+
 static bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg);
-static bool OutputProvisioningData(FILE *outFile, uint64_t devId, X509 *caCert, EVP_PKEY *caKey, const char *curveName,
-                                   const struct tm& validFrom, uint32_t validDays,
-                                   const char *sigType, const EVP_MD *sigHashAlgo,
-                                   CertFormat certFormat, KeyFormat keyFormat,
-                                   uint32_t pairingCodeLen);
+static bool ReadDeviceIdList(const char *fileName, uint64_t *& devIds, uint32_t& devCount);
+static bool OutputProvisioningData(FILE *outFile, const uint64_t *devIds, uint32_t devCount, X509 *caCert, EVP_PKEY *caKey);
+static void *ProvisioningWorkerMain(void *arg);
+static bool GenerateProvisioningData(uint64_t devId, X509 *caCert, EVP_PKEY *caKey, const char *curveName,
+                                     const struct tm& validFrom, uint32_t validDays,
+                                     const char *sigType, const EVP_MD *sigHashAlgo,
+                                     CertFormat certFormat, KeyFormat keyFormat,
+                                     uint32_t pairingCodeLen, char *& row);
 static char *GeneratePairingCode(uint32_t pairingCodeLen);
 static char *GeneratePermissions(uint64_t devId);
 
@@ -63,10 +70,18 @@ enum
     kToolOpt_PKCS8Key   = 1004,
 };
 
+enum
+{
+    kMaxJobs            = 256,
+    kDevicesPerBatch    = 64,       // Number of devices handed to a worker thread at a time
+    kMaxBatchesPerJob   = 4,        // Number of batches each worker may run ahead of the output
+};
+
 static OptionDef gCmdOptionDefs[] =
 {
     { "dev-id",            kArgumentRequired, 'i'                   },
     { "count",             kArgumentRequired, 'c'                   },
+    { "dev-list",          kArgumentRequired, 'L'                   },
     { "ca-cert",           kArgumentRequired, 'C'                   },
     { "ca-key",            kArgumentRequired, 'K'                   },
     { "out",               kArgumentRequired, 'o'                   },
@@ -74,6 +89,8 @@ static OptionDef gCmdOptionDefs[] =
     { "valid-from",        kArgumentRequired, 'V'                   },
     { "lifetime",          kArgumentRequired, 'l'                   },
     { "pairing-code-len",  kArgumentRequired, 'P'                   },
+    { "jobs",              kArgumentRequired, 'j'                   },
+    { "rate",              kNoArgument,       'r'                   },
     { "sha1",              kNoArgument,       '1'                   },
     { "sha256",            kNoArgument,       '2'                   },
     { "weave",             kNoArgument,       'w'                   },
@@ -95,6 +112,13 @@ static const char *const gCmdOptionHelp =
     "\n"
     "       The number of devices which the provisioning data should be generated.\n"
     "\n"
+    "   -L, --dev-list <file>\n"
+    "\n"
+    "       File listing the device ids (in hex) for which provisioning data should be\n"
+    "       generated, one per line.  Only the first comma-separated column of each line\n"
+    "       is read, so a CSV file with a header line may be given.  May be used instead\n"
+    "       of the --dev-id and --count options.\n"
+    "\n"
     "   -C, --ca-cert <file>\n"
     "\n"
     "       File containing CA certificate to be used to sign device certificates.\n"
@@ -128,6 +152,15 @@ static const char *const gCmdOptionHelp =
     "       The number of characters in the generated device pairing codes.\n"
     "       Default is 6.\n"
     "\n"
+    "   -j, --jobs <num>\n"
+    "\n"
+    "       The number of threads on which to generate keys and sign certificates.\n"
+    "       Provisioning data is written in device order regardless.  Default is 1.\n"
+    "\n"
+    "   -r, --rate\n"
+    "\n"
+    "       Report the number of devices generated per second on stderr.\n"
+    "\n"
     "   -1, --sha1\n"
     "\n"
     "       Sign the certificate using a SHA-1 hash.\n"
@@ -193,6 +226,9 @@ static OptionSet *gCmdOptionSets[] =
 
 static uint64_t gDevId = 0;
 static int32_t gDevCount = 0;
+static const char *gDevListFileName = NULL;
+static int32_t gJobCount = 1;
+static bool gReportRate = false;
 static const char *gCurveName = NULL;
 static const char *gCACertFileName = NULL;
 static const char *gCAKeyFileName = NULL;
@@ -211,6 +247,8 @@ bool Cmd_GenProvisioningData(int argc, char *argv[])
     X509 *caCert = NULL;
     EVP_PKEY *caKey = NULL;
     FILE *outFile = NULL;
+    uint64_t *devIds = NULL;
+    uint32_t devCount = 0;
     const char * certColumnName;
     const char * privateKeyColumnName;
     bool outFileCreated = false;
@@ -234,16 +272,28 @@ bool Cmd_GenProvisioningData(int argc, char *argv[])
         ExitNow(res = false);
     }
 
-    if (gDevId == 0)
+    if (gDevListFileName != NULL)
     {
-        fprintf(stderr, "Please specify the starting device id using the --dev-id option.\n");
-        ExitNow(res = false);
+        if (gDevId != 0 || gDevCount != 0)
+        {
+            fprintf(stderr, "The --dev-list option cannot be combined with the --dev-id or --count options.\n");
+            ExitNow(res = false);
+        }
     }
 
-    if (gDevCount == 0)
+    else
     {
-        fprintf(stderr, "Please specify the number of devices device id using the --count option.\n");
-        ExitNow(res = false);
+        if (gDevId == 0)
+        {
+            fprintf(stderr, "Please specify the starting device id using the --dev-id option.\n");
+            ExitNow(res = false);
+        }
+
+        if (gDevCount == 0)
+        {
+            fprintf(stderr, "Please specify the number of devices device id using the --count option.\n");
+            ExitNow(res = false);
+        }
     }
 
     if (gCACertFileName == NULL)
@@ -276,6 +326,15 @@ bool Cmd_GenProvisioningData(int argc, char *argv[])
         ExitNow(res = false);
     }
 
+    if (gDevListFileName != NULL)
+    {
+        if (!ReadDeviceIdList(gDevListFileName, devIds, devCount))
+            ExitNow(res = false);
+    }
+
+    else
+        devCount = (uint32_t)gDevCount;
+
     if (!InitOpenSSL())
         ExitNow(res = false);
 
@@ -334,17 +393,12 @@ bool Cmd_GenProvisioningData(int argc, char *argv[])
         ExitNow(res = false);
     }
 
-    for (int32_t i = 0; i < gDevCount; i++)
-        if (!OutputProvisioningData(outFile, gDevId + i,
-                caCert, caKey,
-                gCurveName,
-                gValidFrom, gValidDays,
-                gSigType, gSigHashAlgo,
-                gCertFormat, gKeyFormat,
-                gPairingCodeLen))
-            ExitNow(res = false);
+    if (!OutputProvisioningData(outFile, devIds, devCount, caCert, caKey))
+        ExitNow(res = false);
 
 exit:
+    if (devIds != NULL)
+        free(devIds);
     if (caCert != NULL)
         X509_free(caCert);
     if (caKey != NULL)
@@ -374,6 +428,19 @@ bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *n
             return false;
         }
         break;
+    case 'L':
+        gDevListFileName = arg;
+        break;
+    case 'j':
+        if (!ParseInt(arg, gJobCount) || gJobCount <= 0 || gJobCount > kMaxJobs)
+        {
+            PrintArgError("%s: Invalid value specified for job count: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    case 'r':
+        gReportRate = true;
+        break;
     case 'C':
         gCACertFileName = arg;
         break;
@@ -446,11 +513,285 @@ bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *n
     return true;
 }
 
-bool OutputProvisioningData(FILE *outFile, uint64_t devId, X509 *caCert, EVP_PKEY *caKey, const char *curveName,
-                            const struct tm& validFrom, uint32_t validDays,
-                            const char *sigType, const EVP_MD *sigHashAlgo,
-                            CertFormat certFormat, KeyFormat keyFormat,
-                            uint32_t pairingCodeLen)
+bool ReadDeviceIdList(const char *fileName, uint64_t *& devIds, uint32_t& devCount)
+{
+    bool res = true;
+    uint8_t *fileData = NULL;
+    uint32_t fileLen;
+    uint32_t maxDevCount = 0;
+    uint32_t lineNum = 0;
+    const char *p, *end;
+
+    devIds = NULL;
+    devCount = 0;
+
+    if (!ReadFileIntoMem(fileName, fileData, fileLen))
+        ExitNow(res = false);
+
+    // Every device id occupies at least one line, so the number of lines bounds the number of ids.
+    for (uint32_t i = 0; i < fileLen; i++)
+        if (fileData[i] == '\n')
+            maxDevCount++;
+    maxDevCount++;
+
+    devIds = (uint64_t *)malloc(maxDevCount * sizeof(uint64_t));
+    if (devIds == NULL)
+    {
+        fprintf(stderr, "Memory allocation error\n");
+        ExitNow(res = false);
+    }
+
+    p = (const char *)fileData;
+    end = p + fileLen;
+    while (p < end)
+    {
+        const char *lineEnd = (const char *)memchr(p, '\n', end - p);
+        const char *fieldEnd;
+        char field[32];
+        size_t fieldLen;
+
+        if (lineEnd == NULL)
+            lineEnd = end;
+        lineNum++;
+
+        // Take the first comma-separated column, less any surrounding whitespace.
+        fieldEnd = (const char *)memchr(p, ',', lineEnd - p);
+        if (fieldEnd == NULL)
+            fieldEnd = lineEnd;
+        while (p < fieldEnd && isspace(*p))
+            p++;
+        while (fieldEnd > p && isspace(fieldEnd[-1]))
+            fieldEnd--;
+        fieldLen = fieldEnd - p;
+
+        if (fieldLen > 0)
+        {
+            if (fieldLen < sizeof(field))
+            {
+                memcpy(field, p, fieldLen);
+                field[fieldLen] = 0;
+            }
+
+            if (fieldLen < sizeof(field) && ParseEUI64(field, devIds[devCount]))
+                devCount++;
+
+            // Skip a header line.
+            else if (devCount != 0 || lineNum != 1)
+            {
+                fprintf(stderr, "weave: Invalid device id on line %" PRIu32 " of %s\n", lineNum, fileName);
+                ExitNow(res = false);
+            }
+        }
+
+        p = lineEnd + 1;
+    }
+
+    if (devCount == 0)
+    {
+        fprintf(stderr, "weave: No device ids found in %s\n", fileName);
+        ExitNow(res = false);
+    }
+
+exit:
+    if (fileData != NULL)
+        free(fileData);
+    if (!res && devIds != NULL)
+    {
+        free(devIds);
+        devIds = NULL;
+    }
+    return res;
+}
+
+/**
+ * State shared between the thread writing the provisioning data and the worker threads generating it.
+ *
+ * Devices are handed out to the workers in batches.  Workers may run at most a fixed number of batches ahead of the
+ * output, which bounds the memory held by generated but unwritten rows.
+ */
+struct ProvisioningJob
+{
+    pthread_mutex_t Lock;
+    pthread_cond_t BatchGenerated;      // Signalled when a worker finishes a batch
+    pthread_cond_t BatchWritten;        // Signalled when the writer finishes a batch
+    const uint64_t *DevIds;             // Device ids, or NULL for the range starting at gDevId
+    uint32_t DevCount;
+    uint32_t BatchCount;
+    uint32_t MaxPendingBatches;
+    uint32_t NextBatch;                 // Next batch to be handed to a worker
+    uint32_t NextBatchToWrite;
+    char **Rows;                        // Generated rows, indexed by device
+    bool *BatchReady;
+    bool Failed;
+    X509 *CACert;
+    EVP_PKEY *CAKey;
+};
+
+bool OutputProvisioningData(FILE *outFile, const uint64_t *devIds, uint32_t devCount, X509 *caCert, EVP_PKEY *caKey)
+{
+    bool res = true;
+    ProvisioningJob job;
+    pthread_t workers[kMaxJobs];
+    int32_t workerCount = 0;
+    struct timespec startTime, endTime;
+
+    memset(&job, 0, sizeof(job));
+    pthread_mutex_init(&job.Lock, NULL);
+    pthread_cond_init(&job.BatchGenerated, NULL);
+    pthread_cond_init(&job.BatchWritten, NULL);
+    job.DevIds = devIds;
+    job.DevCount = devCount;
+    job.BatchCount = (devCount + kDevicesPerBatch - 1) / kDevicesPerBatch;
+    job.MaxPendingBatches = gJobCount * kMaxBatchesPerJob;
+    job.CACert = caCert;
+    job.CAKey = caKey;
+
+    job.Rows = (char **)calloc(devCount, sizeof(char *));
+    job.BatchReady = (bool *)calloc(job.BatchCount, sizeof(bool));
+    if (job.Rows == NULL || job.BatchReady == NULL)
+    {
+        fprintf(stderr, "Memory allocation error\n");
+        ExitNow(res = false);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    for (; workerCount < gJobCount; workerCount++)
+    {
+        int err = pthread_create(&workers[workerCount], NULL, ProvisioningWorkerMain, &job);
+        if (err != 0)
+        {
+            fprintf(stderr, "weave: Unable to create worker thread: %s\n", strerror(err));
+            pthread_mutex_lock(&job.Lock);
+            job.Failed = true;
+            pthread_cond_broadcast(&job.BatchWritten);
+            pthread_mutex_unlock(&job.Lock);
+            ExitNow(res = false);
+        }
+    }
+
+    // Write each batch, in order, as soon as it has been generated.
+    for (uint32_t batch = 0; batch < job.BatchCount; batch++)
+    {
+        uint32_t firstDev = batch * kDevicesPerBatch;
+        uint32_t lastDev = (firstDev + kDevicesPerBatch < devCount) ? firstDev + kDevicesPerBatch : devCount;
+        bool failed;
+
+        pthread_mutex_lock(&job.Lock);
+        while (!job.BatchReady[batch] && !job.Failed)
+            pthread_cond_wait(&job.BatchGenerated, &job.Lock);
+        failed = job.Failed;
+        pthread_mutex_unlock(&job.Lock);
+
+        if (failed)
+            ExitNow(res = false);
+
+        for (uint32_t i = firstDev; i < lastDev; i++)
+        {
+            if (fputs(job.Rows[i], outFile) < 0 || ferror(outFile))
+            {
+                fprintf(stderr, "Error writing to output file: %s\n", strerror(errno));
+                pthread_mutex_lock(&job.Lock);
+                job.Failed = true;
+                pthread_cond_broadcast(&job.BatchWritten);
+                pthread_mutex_unlock(&job.Lock);
+                ExitNow(res = false);
+            }
+            free(job.Rows[i]);
+            job.Rows[i] = NULL;
+        }
+
+        pthread_mutex_lock(&job.Lock);
+        job.NextBatchToWrite = batch + 1;
+        pthread_cond_broadcast(&job.BatchWritten);
+        pthread_mutex_unlock(&job.Lock);
+    }
+
+    if (fflush(outFile) != 0)
+    {
+        fprintf(stderr, "Error writing to output file: %s\n", strerror(errno));
+        ExitNow(res = false);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+
+    if (gReportRate)
+    {
+        double elapsed = (endTime.tv_sec - startTime.tv_sec) + (endTime.tv_nsec - startTime.tv_nsec) / 1e9;
+        fprintf(stderr, "Generated %" PRIu32 " devices in %.3f s (%.1f devices/s, %d jobs)\n", devCount, elapsed,
+                (elapsed > 0) ? devCount / elapsed : 0.0, (int)gJobCount);
+    }
+
+exit:
+    for (int32_t i = 0; i < workerCount; i++)
+        pthread_join(workers[i], NULL);
+    if (job.Rows != NULL)
+    {
+        for (uint32_t i = 0; i < devCount; i++)
+            free(job.Rows[i]);
+        free(job.Rows);
+    }
+    if (job.BatchReady != NULL)
+        free(job.BatchReady);
+    pthread_cond_destroy(&job.BatchWritten);
+    pthread_cond_destroy(&job.BatchGenerated);
+    pthread_mutex_destroy(&job.Lock);
+    return res;
+}
+
+void *ProvisioningWorkerMain(void *arg)
+{
+    ProvisioningJob *job = (ProvisioningJob *)arg;
+
+    pthread_mutex_lock(&job->Lock);
+
+    while (true)
+    {
+        uint32_t batch, firstDev, lastDev;
+        bool batchRes = true;
+
+        while (!job->Failed && job->NextBatch < job->BatchCount &&
+               job->NextBatch >= job->NextBatchToWrite + job->MaxPendingBatches)
+            pthread_cond_wait(&job->BatchWritten, &job->Lock);
+
+        if (job->Failed || job->NextBatch >= job->BatchCount)
+            break;
+
+        batch = job->NextBatch++;
+        pthread_mutex_unlock(&job->Lock);
+
+        firstDev = batch * kDevicesPerBatch;
+        lastDev = (firstDev + kDevicesPerBatch < job->DevCount) ? firstDev + kDevicesPerBatch : job->DevCount;
+        for (uint32_t i = firstDev; i < lastDev && batchRes; i++)
+        {
+            uint64_t devId = (job->DevIds != NULL) ? job->DevIds[i] : gDevId + i;
+
+            batchRes = GenerateProvisioningData(devId,
+                    job->CACert, job->CAKey,
+                    gCurveName,
+                    gValidFrom, gValidDays,
+                    gSigType, gSigHashAlgo,
+                    gCertFormat, gKeyFormat,
+                    gPairingCodeLen, job->Rows[i]);
+        }
+
+        pthread_mutex_lock(&job->Lock);
+        if (!batchRes)
+            job->Failed = true;
+        job->BatchReady[batch] = true;
+        pthread_cond_broadcast(&job->BatchGenerated);
+    }
+
+    pthread_mutex_unlock(&job->Lock);
+
+    return NULL;
+}
+
+bool GenerateProvisioningData(uint64_t devId, X509 *caCert, EVP_PKEY *caKey, const char *curveName,
+                              const struct tm& validFrom, uint32_t validDays,
+                              const char *sigType, const EVP_MD *sigHashAlgo,
+                              CertFormat certFormat, KeyFormat keyFormat,
+                              uint32_t pairingCodeLen, char *& row)
 {
     bool res = true;
     X509 *devCert = NULL;
@@ -463,6 +804,9 @@ bool OutputProvisioningData(FILE *outFile, uint64_t devId, X509 *caCert, EVP_PKE
     char *encodedKeyB64 = NULL;
     char *pairingCode = NULL;
     char *perms = NULL;
+    int rowLen;
+
+    row = NULL;
 
     if (!MakeDeviceCert(devId, caCert, caKey, curveName, validFrom, validDays, sigHashAlgo, devCert, devKey))
         ExitNow(res = false);
@@ -504,13 +848,16 @@ bool OutputProvisioningData(FILE *outFile, uint64_t devId, X509 *caCert, EVP_PKE
     if (pairingCode == NULL)
         ExitNow(res = false);
 
-    if (fprintf(outFile, "%016" PRIX64 ",%s,%s,%s,%s,%s\n", devId, encodedCertB64, encodedKeyB64, perms, pairingCode, sigType) < 0 ||
-        ferror(outFile))
+    rowLen = snprintf(NULL, 0, "%016" PRIX64 ",%s,%s,%s,%s,%s\n", devId, encodedCertB64, encodedKeyB64, perms, pairingCode, sigType);
+    row = (char *)malloc(rowLen + 1);
+    if (row == NULL)
     {
-        fprintf(stderr, "Error writing to output file: %s\n", strerror(errno));
+        fprintf(stderr, "Memory allocation error\n");
         ExitNow(res = false);
     }
 
+    snprintf(row, rowLen + 1, "%016" PRIX64 ",%s,%s,%s,%s,%s\n", devId, encodedCertB64, encodedKeyB64, perms, pairingCode, sigType);
+
 exit:
     if (encodedCertB64 != NULL)
         free(encodedCertB64);
@@ -21,9 +21,19 @@
  *      This file implements the weave command of print-tlv.
  *
  */
+
+#define __STDC_FORMAT_MACROS
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -41,13 +51,84 @@ using namespace nl::Weave::TLV;
 
 #define CMD_NAME "weave print-tlv"
 
+enum
+{
+    kDefaultChunkSize   = 65536,
+    kMinChunkSize       = 64,
+    kMaxChunkSize       = 16 * 1024 * 1024,
+    kMaxPathFilters     = 16,
+    kMaxPathDepth       = 16,
+    kStringPieceSize    = 768,      // Multiple of 3, so that byte strings can be base-64 encoded a piece at a time
+};
+
+struct PathFilter
+{
+    uint64_t Tags[kMaxPathDepth];
+    bool AnyTag[kMaxPathDepth];
+    uint8_t Depth;
+};
+
+enum PathMatch
+{
+    kPathMatch_None,
+    kPathMatch_Prefix,          // The element is an ancestor of the elements selected by a filter
+    kPathMatch_Full,
+};
+
+/**
+ * Source of TLV data read from a file a fixed-size chunk at a time, for
+ * printing TLV too large to hold in memory.  Input in base-64 is decoded
+ * as it is read.
+ */
+struct TLVFileStream
+{
+    FILE *File;
+    uint8_t *Chunk;
+    uint32_t ChunkSize;
+    const uint8_t *DataEnd;             // End of the data read into Chunk
+    char *Base64Buf;
+    uint32_t Base64Carry;               // Base-64 characters left over from the previous read
+
+    bool Init(const char *fileName, uint32_t chunkSize, bool base64);
+    void Shutdown(void);
+    WEAVE_ERROR ReadChunk(uint32_t& dataLen);
+
+    static WEAVE_ERROR GetNextBuffer(TLVReader& reader, uintptr_t& bufHandle, const uint8_t *& bufStart, uint32_t& bufLen);
+};
+
+/**
+ * TLVReader over a TLVFileStream.
+ *
+ * A fresh reader is started for each top-level element, so that inputs
+ * larger than the 4GB a reader can count are handled.  String values can
+ * be read a piece at a time, so that long strings need not fit in memory.
+ */
+class TLVStreamReader : public TLVReader
+{
+public:
+    void Init(TLVFileStream& stream, const uint8_t *readPoint);
+    WEAVE_ERROR ReadStringPiece(uint8_t *buf, uint32_t bufSize, uint32_t& pieceLen);
+    bool HasMoreStringData(void) const { return mElemLenOrVal != 0; }
+};
+
 static bool HandleNonOptionArgs(const char *progName, int argc, char *argv[]);
 static bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg);
+static bool ParsePathFilter(const char *str, PathFilter& filter);
 static void _DumpWriter(const char *aFormat, ...);
+static bool PrintTLVStream(void);
+static PathMatch MatchPath(const uint64_t *tags, uint8_t depth);
+static WEAVE_ERROR HandleElement(TLVStreamReader& reader, uint64_t *tags, size_t depth);
+static WEAVE_ERROR PrintElementText(TLVStreamReader& reader, size_t depth);
+static WEAVE_ERROR PrintElementJSON(TLVStreamReader& reader);
+static WEAVE_ERROR PrintStringJSON(TLVStreamReader& reader, bool isByteString);
 
 static OptionDef gCmdOptionDefs[] =
 {
-    { "base64", kNoArgument, 'b' },
+    { "base64",     kNoArgument,       'b' },
+    { "stream",     kNoArgument,       's' },
+    { "chunk-size", kArgumentRequired, 'c' },
+    { "path",       kArgumentRequired, 'p' },
+    { "json",       kNoArgument,       'j' },
     { NULL }
 };
 
@@ -56,6 +137,36 @@ static const char *const gCmdOptionHelp =
     "\n"
     "       The file containing the TLV should be parsed as base64.\n"
     "\n"
+    "   -s, --stream\n"
+    "\n"
+    "       Read the file a chunk at a time, rather than all at once, so that files of\n"
+    "       any size can be printed in constant memory.  The file may contain a sequence\n"
+    "       of TLV elements, such as an event log capture.  Implied by the --path and\n"
+    "       --json options.\n"
+    "\n"
+    "   -c, --chunk-size <bytes>\n"
+    "\n"
+    "       The size of the chunks in which the file is read when streaming.  Defaults\n"
+    "       to 65536.\n"
+    "\n"
+    "   -p, --path <selector>\n"
+    "\n"
+    "       Print only the elements at the given path.  A path is a list of tags\n"
+    "       separated by '/', starting from the top-level elements.  Each tag is one of:\n"
+    "\n"
+    "           <num>              A context tag.\n"
+    "           <profile>:<num>    A profile-specific tag.  The profile id is given in\n"
+    "                              full, e.g. 0x0000000A for the Data Management profile.\n"
+    "           *                  Any tag, including an anonymous one.\n"
+    "\n"
+    "       Numbers may be decimal or hex (with a 0x prefix).  The option may be given\n"
+    "       more than once, in which case elements matching any path are printed.\n"
+    "\n"
+    "   -j, --json\n"
+    "\n"
+    "       Print each element as JSON, one element per line.  Structures become\n"
+    "       objects keyed by tag, and byte strings become base-64 strings.\n"
+    "\n"
     ;
 
 static OptionSet gCmdOptions =
@@ -90,6 +201,11 @@ static OptionSet *gCmdOptionSets[] =
 
 static const char *gFileName = NULL;
 static bool gUseBase64Decoding = false;
+static bool gStream = false;
+static bool gJSON = false;
+static int32_t gChunkSize = kDefaultChunkSize;
+static PathFilter gPathFilters[kMaxPathFilters];
+static uint8_t gPathFilterCount = 0;
 
 bool Cmd_PrintTLV(int argc, char *argv[])
 {
@@ -112,6 +228,11 @@ bool Cmd_PrintTLV(int argc, char *argv[])
         ExitNow(res = false);
     }
 
+    if (gStream)
+    {
+        ExitNow(res = PrintTLVStream());
+    }
+
     fd = open(gFileName, O_RDONLY | O_CLOEXEC);
     if (fd < 0)
     {
@@ -199,6 +320,38 @@ bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *n
         gUseBase64Decoding = true;
         break;
 
+    case 's':
+        gStream = true;
+        break;
+
+    case 'c':
+        if (!ParseInt(arg, gChunkSize) || gChunkSize < kMinChunkSize || gChunkSize > kMaxChunkSize)
+        {
+            PrintArgError("%s: Invalid value specified for chunk size: %s\n", progName, arg);
+            return false;
+        }
+        break;
+
+    case 'p':
+        if (gPathFilterCount == kMaxPathFilters)
+        {
+            PrintArgError("%s: Too many paths specified\n", progName);
+            return false;
+        }
+        if (!ParsePathFilter(arg, gPathFilters[gPathFilterCount]))
+        {
+            PrintArgError("%s: Invalid path: %s\n", progName, arg);
+            return false;
+        }
+        gPathFilterCount++;
+        gStream = true;
+        break;
+
+    case 'j':
+        gJSON = true;
+        gStream = true;
+        break;
+
     default:
         PrintArgError("%s: INTERNAL ERROR: Unhandled option: %s\n", progName, name);
         return false;
@@ -206,3 +359,598 @@ bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *n
 
     return true;
 }
+
+bool ParsePathFilter(const char *str, PathFilter& filter)
+{
+    const char *p = str;
+
+    filter.Depth = 0;
+
+    if (*p == '/')
+        p++;
+
+    while (*p != 0)
+    {
+        char *end;
+
+        if (filter.Depth == kMaxPathDepth)
+            return false;
+
+        if (p[0] == '*' && (p[1] == '/' || p[1] == 0))
+        {
+            filter.AnyTag[filter.Depth] = true;
+            filter.Tags[filter.Depth] = AnonymousTag;
+            end = (char *)p + 1;
+        }
+
+        else
+        {
+            unsigned long num;
+
+            if (!isdigit(*p))
+                return false;
+            errno = 0;
+            num = strtoul(p, &end, 0);
+            if (errno != 0)
+                return false;
+
+            if (*end == ':')
+            {
+                unsigned long tagNum;
+
+                p = end + 1;
+                if (!isdigit(*p) || num > UINT32_MAX)
+                    return false;
+                tagNum = strtoul(p, &end, 0);
+                if (errno != 0 || tagNum > UINT32_MAX)
+                    return false;
+                filter.Tags[filter.Depth] = ProfileTag((uint32_t)num, (uint32_t)tagNum);
+            }
+
+            else
+            {
+                if (num >= kContextTagMaxNum)
+                    return false;
+                filter.Tags[filter.Depth] = ContextTag((uint8_t)num);
+            }
+
+            filter.AnyTag[filter.Depth] = false;
+        }
+
+        if (*end == '/')
+            end++;
+        else if (*end != 0)
+            return false;
+
+        filter.Depth++;
+        p = end;
+    }
+
+    return filter.Depth > 0;
+}
+
+bool TLVFileStream::Init(const char *fileName, uint32_t chunkSize, bool base64)
+{
+    bool res = true;
+
+    memset(this, 0, sizeof(*this));
+    ChunkSize = chunkSize;
+
+    File = fopen(fileName, "rb");
+    if (File == NULL)
+    {
+        fprintf(stderr, "weave: Error reading %s: %s\n", fileName, strerror(errno));
+        ExitNow(res = false);
+    }
+
+    Chunk = (uint8_t *)malloc(chunkSize);
+    if (Chunk == NULL)
+    {
+        fprintf(stderr, "Memory allocation error\n");
+        ExitNow(res = false);
+    }
+    DataEnd = Chunk;
+
+    if (base64)
+    {
+        // Each 4 base-64 characters decode to 3 bytes; 3 more are carried over between reads.
+        Base64Buf = (char *)malloc((chunkSize / 3) * 4 + 3);
+        if (Base64Buf == NULL)
+        {
+            fprintf(stderr, "Memory allocation error\n");
+            ExitNow(res = false);
+        }
+    }
+
+exit:
+    if (!res)
+        Shutdown();
+    return res;
+}
+
+void TLVFileStream::Shutdown(void)
+{
+    if (File != NULL)
+        fclose(File);
+    if (Chunk != NULL)
+        free(Chunk);
+    if (Base64Buf != NULL)
+        free(Base64Buf);
+    File = NULL;
+    Chunk = NULL;
+    Base64Buf = NULL;
+}
+
+WEAVE_ERROR TLVFileStream::ReadChunk(uint32_t& dataLen)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    if (Base64Buf == NULL)
+    {
+        dataLen = fread(Chunk, 1, ChunkSize, File);
+        VerifyOrExit(!ferror(File), err = nl::Weave::System::MapErrorPOSIX(errno));
+    }
+
+    else
+    {
+        uint32_t maxChars = (ChunkSize / 3) * 4;
+        uint32_t charCount = Base64Carry;
+        uint32_t decodeCount;
+
+        // Read base-64 characters, ignoring line breaks and other white space, until a full chunk's worth
+        // is available or the end of the file is reached.
+        while (charCount < maxChars)
+        {
+            int ch = getc(File);
+            if (ch == EOF)
+                break;
+            if (!isspace(ch))
+                Base64Buf[charCount++] = (char)ch;
+        }
+        VerifyOrExit(!ferror(File), err = nl::Weave::System::MapErrorPOSIX(errno));
+
+        // Decode whole groups of 4 characters, except at the end of the file, where padding may be omitted.
+        decodeCount = feof(File) ? charCount : charCount - (charCount % 4);
+
+        dataLen = nl::Base64Decode32(Base64Buf, decodeCount, Chunk);
+        VerifyOrExit(dataLen != UINT32_MAX, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+        Base64Carry = charCount - decodeCount;
+        memmove(Base64Buf, Base64Buf + decodeCount, Base64Carry);
+    }
+
+exit:
+    DataEnd = Chunk + ((err == WEAVE_NO_ERROR) ? dataLen : 0);
+    return err;
+}
+
+WEAVE_ERROR TLVFileStream::GetNextBuffer(TLVReader& reader, uintptr_t& bufHandle, const uint8_t *& bufStart, uint32_t& bufLen)
+{
+    TLVFileStream *stream = static_cast<TLVFileStream *>(reader.AppData);
+
+    // A reader started part way through the current chunk first consumes the rest of it.
+    if (bufStart >= stream->Chunk && bufStart < stream->DataEnd)
+    {
+        bufLen = stream->DataEnd - bufStart;
+        return WEAVE_NO_ERROR;
+    }
+
+    bufStart = stream->Chunk;
+    return stream->ReadChunk(bufLen);
+}
+
+void TLVStreamReader::Init(TLVFileStream& stream, const uint8_t *readPoint)
+{
+    TLVReader::Init(readPoint, 0);
+    mMaxLen = UINT32_MAX;
+    AppData = &stream;
+    GetNextBuffer = TLVFileStream::GetNextBuffer;
+}
+
+WEAVE_ERROR TLVStreamReader::ReadStringPiece(uint8_t *buf, uint32_t bufSize, uint32_t& pieceLen)
+{
+    WEAVE_ERROR err;
+
+    VerifyOrExit(TLVTypeIsString(ElementType()), err = WEAVE_ERROR_WRONG_TLV_TYPE);
+
+    pieceLen = (mElemLenOrVal < bufSize) ? (uint32_t)mElemLenOrVal : bufSize;
+
+    err = ReadData(buf, pieceLen);
+    SuccessOrExit(err);
+
+    mElemLenOrVal -= pieceLen;
+
+exit:
+    return err;
+}
+
+bool PrintTLVStream(void)
+{
+    bool res = true;
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TLVFileStream stream;
+    TLVStreamReader reader;
+    const uint8_t *readPoint;
+    uint64_t tags[kMaxPathDepth];
+
+    if (!stream.Init(gFileName, (uint32_t)gChunkSize, gUseBase64Decoding))
+        ExitNow(res = false);
+
+    readPoint = stream.Chunk;
+
+    while (true)
+    {
+        reader.Init(stream, readPoint);
+
+        err = reader.Next();
+        if (err == WEAVE_END_OF_TLV)
+        {
+            err = WEAVE_NO_ERROR;
+            break;
+        }
+        SuccessOrExit(err);
+
+        err = HandleElement(reader, tags, 0);
+        SuccessOrExit(err);
+
+        err = reader.Skip();
+        SuccessOrExit(err);
+
+        readPoint = reader.GetReadPoint();
+    }
+
+    if (fflush(stdout) != 0)
+    {
+        fprintf(stderr, "weave: Error writing output: %s\n", strerror(errno));
+        ExitNow(res = false);
+    }
+
+exit:
+    if (err != WEAVE_NO_ERROR)
+    {
+        fflush(stdout);
+        fprintf(stderr, "weave: Error reading %s: %s\n", gFileName, nl::ErrorStr(err));
+        res = false;
+    }
+    stream.Shutdown();
+    return res;
+}
+
+PathMatch MatchPath(const uint64_t *tags, uint8_t depth)
+{
+    PathMatch match = (gPathFilterCount == 0) ? kPathMatch_Full : kPathMatch_None;
+
+    for (uint8_t i = 0; i < gPathFilterCount && match != kPathMatch_Full; i++)
+    {
+        const PathFilter& filter = gPathFilters[i];
+        bool matches = (depth <= filter.Depth);
+
+        for (uint8_t j = 0; j < depth && matches; j++)
+            matches = filter.AnyTag[j] || filter.Tags[j] == tags[j];
+
+        if (matches)
+            match = (depth == filter.Depth) ? kPathMatch_Full : kPathMatch_Prefix;
+    }
+
+    return match;
+}
+
+/**
+ * Print the element on which the reader is positioned if it is selected
+ * by the path filters, or look for selected elements within it.
+ */
+WEAVE_ERROR HandleElement(TLVStreamReader& reader, uint64_t *tags, size_t depth)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    PathMatch match = kPathMatch_Full;
+
+    if (gPathFilterCount != 0)
+    {
+        tags[depth] = reader.GetTag();
+        match = MatchPath(tags, depth + 1);
+    }
+
+    if (match == kPathMatch_Full)
+    {
+        if (gJSON)
+        {
+            err = PrintElementJSON(reader);
+            SuccessOrExit(err);
+            putchar('\n');
+        }
+        else
+        {
+            err = PrintElementText(reader, depth);
+        }
+    }
+
+    else if (match == kPathMatch_Prefix && TLVTypeIsContainer(reader.GetType()))
+    {
+        TLVType outerContainerType;
+
+        err = reader.EnterContainer(outerContainerType);
+        SuccessOrExit(err);
+
+        while ((err = reader.Next()) == WEAVE_NO_ERROR)
+        {
+            err = HandleElement(reader, tags, depth + 1);
+            SuccessOrExit(err);
+        }
+        if (err != WEAVE_END_OF_TLV)
+            ExitNow();
+
+        err = reader.ExitContainer(outerContainerType);
+    }
+
+exit:
+    return err;
+}
+
+/**
+ * Print an element, and any elements within it, in the form used by
+ * nl::Weave::TLV::Debug::Dump().
+ */
+WEAVE_ERROR PrintElementText(TLVStreamReader& reader, size_t depth)
+{
+    static const char tabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    const TLVType type = reader.GetType();
+    const uint64_t tag = reader.GetTag();
+    const TLVTagControl tagControl = static_cast<TLVTagControl>(reader.GetControlByte() & kTLVTagControlMask);
+    uint8_t piece[kStringPieceSize];
+    uint32_t pieceLen;
+
+    printf("%zd %.*s", depth, (int)((depth < sizeof(tabs) - 1) ? depth : sizeof(tabs) - 1), tabs);
+
+    if (IsProfileTag(tag))
+        printf("tag[%s]: 0x%x::0x%x::0x%x, ", Debug::DecodeTagControl(tagControl), VendorIdFromTag(tag), ProfileNumFromTag(tag),
+               TagNumFromTag(tag));
+    else
+        printf("tag[%s]: 0x%x, ", Debug::DecodeTagControl(tagControl), TagNumFromTag(tag));
+
+    printf("type: %s (0x%02x), ", Debug::DecodeType(type), type);
+
+    switch (type)
+    {
+    case kTLVType_Structure:
+    case kTLVType_Array:
+    case kTLVType_Path:
+    {
+        TLVType outerContainerType;
+
+        printf("container:\n");
+
+        err = reader.EnterContainer(outerContainerType);
+        SuccessOrExit(err);
+
+        while ((err = reader.Next()) == WEAVE_NO_ERROR)
+        {
+            err = PrintElementText(reader, depth + 1);
+            SuccessOrExit(err);
+        }
+        if (err != WEAVE_END_OF_TLV)
+            ExitNow();
+
+        err = reader.ExitContainer(outerContainerType);
+        ExitNow();
+    }
+
+    case kTLVType_SignedInteger:
+    {
+        int64_t val;
+        err = reader.Get(val);
+        SuccessOrExit(err);
+        printf("value: %" PRIi64, val);
+        break;
+    }
+
+    case kTLVType_UnsignedInteger:
+    {
+        uint64_t val;
+        err = reader.Get(val);
+        SuccessOrExit(err);
+        printf("value: %" PRIu64, val);
+        break;
+    }
+
+    case kTLVType_Boolean:
+    {
+        bool val;
+        err = reader.Get(val);
+        SuccessOrExit(err);
+        printf("value: %s", val ? "true" : "false");
+        break;
+    }
+
+    case kTLVType_FloatingPointNumber:
+    {
+        double val;
+        err = reader.Get(val);
+        SuccessOrExit(err);
+        printf("value: %lf", val);
+        break;
+    }
+
+    case kTLVType_UTF8String:
+        printf("length: %" PRIu32 ", value: \"", reader.GetLength());
+        while (reader.HasMoreStringData())
+        {
+            err = reader.ReadStringPiece(piece, sizeof(piece), pieceLen);
+            SuccessOrExit(err);
+            fwrite(piece, 1, pieceLen, stdout);
+        }
+        putchar('"');
+        break;
+
+    case kTLVType_ByteString:
+        printf("length: %" PRIu32 ", value: ", reader.GetLength());
+        while (reader.HasMoreStringData())
+        {
+            err = reader.ReadStringPiece(piece, sizeof(piece), pieceLen);
+            SuccessOrExit(err);
+            for (uint32_t i = 0; i < pieceLen; i++)
+                printf("%02X", piece[i]);
+        }
+        break;
+
+    case kTLVType_Null:
+        printf("value: NULL");
+        break;
+
+    default:
+        printf("value: Not Specified");
+        break;
+    }
+
+    putchar('\n');
+
+exit:
+    return err;
+}
+
+/**
+ * Print an element, and any elements within it, as a JSON value.
+ */
+WEAVE_ERROR PrintElementJSON(TLVStreamReader& reader)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    const TLVType type = reader.GetType();
+
+    switch (type)
+    {
+    case kTLVType_Structure:
+    case kTLVType_Array:
+    case kTLVType_Path:
+    {
+        TLVType outerContainerType;
+        bool isArray = (type == kTLVType_Array);
+        bool first = true;
+
+        putchar(isArray ? '[' : '{');
+
+        err = reader.EnterContainer(outerContainerType);
+        SuccessOrExit(err);
+
+        while ((err = reader.Next()) == WEAVE_NO_ERROR)
+        {
+            if (!first)
+                putchar(',');
+            first = false;
+
+            if (!isArray)
+            {
+                const uint64_t tag = reader.GetTag();
+
+                if (IsProfileTag(tag))
+                    printf("\"0x%08" PRIX32 ":%" PRIu32 "\":", ProfileIdFromTag(tag), TagNumFromTag(tag));
+                else if (IsContextTag(tag))
+                    printf("\"%" PRIu32 "\":", TagNumFromTag(tag));
+                else
+                    printf("\"\":");
+            }
+
+            err = PrintElementJSON(reader);
+            SuccessOrExit(err);
+        }
+        if (err != WEAVE_END_OF_TLV)
+            ExitNow();
+
+        err = reader.ExitContainer(outerContainerType);
+        SuccessOrExit(err);
+
+        putchar(isArray ? ']' : '}');
+        break;
+    }
+
+    case kTLVType_SignedInteger:
+    {
+        int64_t val;
+        err = reader.Get(val);
+        SuccessOrExit(err);
+        printf("%" PRIi64, val);
+        break;
+    }
+
+    case kTLVType_UnsignedInteger:
+    {
+        uint64_t val;
+        err = reader.Get(val);
+        SuccessOrExit(err);
+        printf("%" PRIu64, val);
+        break;
+    }
+
+    case kTLVType_Boolean:
+    {
+        bool val;
+        err = reader.Get(val);
+        SuccessOrExit(err);
+        printf("%s", val ? "true" : "false");
+        break;
+    }
+
+    case kTLVType_FloatingPointNumber:
+    {
+        double val;
+        err = reader.Get(val);
+        SuccessOrExit(err);
+        if (isfinite(val))
+            printf("%.17g", val);
+        else
+            printf("null");
+        break;
+    }
+
+    case kTLVType_UTF8String:
+    case kTLVType_ByteString:
+        err = PrintStringJSON(reader, type == kTLVType_ByteString);
+        break;
+
+    default:
+        printf("null");
+        break;
+    }
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR PrintStringJSON(TLVStreamReader& reader, bool isByteString)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint8_t piece[kStringPieceSize];
+    char encoded[(kStringPieceSize / 3) * 4];
+    uint32_t pieceLen;
+
+    putchar('"');
+
+    while (reader.HasMoreStringData())
+    {
+        err = reader.ReadStringPiece(piece, sizeof(piece), pieceLen);
+        SuccessOrExit(err);
+
+        if (isByteString)
+        {
+            // Only the final piece can be short, so padding only appears at the end.
+            fwrite(encoded, 1, nl::Base64Encode(piece, (uint16_t)pieceLen, encoded), stdout);
+            continue;
+        }
+
+        for (uint32_t i = 0; i < pieceLen; i++)
+        {
+            uint8_t ch = piece[i];
+
+            if (ch == '"' || ch == '\\')
+                printf("\\%c", ch);
+            else if (ch < 0x20)
+                printf("\\u%04x", ch);
+            else
+                putchar(ch);
+        }
+    }
+
+    putchar('"');
+
+exit:
+    return err;
+}
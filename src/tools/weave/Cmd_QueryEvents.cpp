@@ -0,0 +1,989 @@
+/*
+ *
+ *    Copyright (c) 2013-2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements the command handler for the 'weave' tool
+ *      that queries captured Weave event logs.
+ *
+ */
+
+#define __STDC_FORMAT_MACROS
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <Weave/Core/WeaveTLVDebug.hpp>
+#include <Weave/Profiles/data-management/DataManagement.h>
+
+#include "weave-tool.h"
+
+using namespace nl::Weave::TLV;
+using namespace nl::Weave::Profiles::DataManagement;
+
+#define CMD_NAME "weave query-events"
+
+enum
+{
+    kMaxProfileFilters  = 16,
+    kEventIndexVersion  = 1,
+};
+
+/**
+ * Index entry for one event, with the header fields that are implicit or
+ * delta-encoded in the log resolved to their values.
+ */
+struct EventIndexEntry
+{
+    uint64_t Offset;                    // Offset of the event structure in the log
+    uint64_t Id;
+    uint64_t SystemTimestamp;
+    uint64_t UTCTimestamp;
+    uint32_t Length;                    // Encoded length of the event structure
+    uint32_t ProfileId;
+    uint32_t Type;
+    uint8_t Importance;
+    uint8_t HasUTCTimestamp;
+    uint8_t Reserved[2];
+};
+
+/**
+ * Header of an index file.  The index is only used while the size and
+ * modification time of the log match those recorded in it.
+ *
+ * The header is followed by the entries, in log order, and by four
+ * orderings of the entries, each an array of entry positions.
+ */
+struct EventIndexHeader
+{
+    char Magic[4];
+    uint32_t Version;
+    uint64_t LogSize;
+    int64_t LogModTimeSec;
+    int64_t LogModTimeNSec;
+    uint32_t EventCount;
+    uint32_t Reserved;
+};
+
+enum EventOrder
+{
+    kEventOrder_Time,                   // By system timestamp
+    kEventOrder_UTCTime,                // By UTC timestamp
+    kEventOrder_Profile,                // By trait profile, event type and system timestamp
+    kEventOrder_Id,                     // By importance and event id
+
+    kEventOrder_Count
+};
+
+struct EventIndex
+{
+    EventIndexHeader *Header;
+    const EventIndexEntry *Entries;
+    const uint32_t *Orders[kEventOrder_Count];
+    size_t Size;
+    bool Mapped;
+};
+
+struct EventIndexBuilder
+{
+    const uint8_t *LogStart;
+    EventIndexEntry *Entries;
+    uint32_t EventCount;
+    uint32_t MaxEventCount;
+};
+
+static bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg);
+static bool HandleNonOptionArgs(const char *progName, int argc, char *argv[]);
+static bool ParseImportance(const char *str, uint8_t& importance);
+static bool ParseUInt64Range(const char *str, uint64_t& first, uint64_t& last);
+static bool BuildEventIndex(const uint8_t *log, uint64_t logSize, const struct stat& logStat, EventIndex& index);
+static bool LoadEventIndex(const char *fileName, const struct stat& logStat, EventIndex& index);
+static bool SaveEventIndex(const char *fileName, const EventIndex& index);
+static void FreeEventIndex(EventIndex& index);
+static WEAVE_ERROR IndexEvent(TLVReader& reader, EventDecodeContext& context, EventIndexBuilder& builder);
+static WEAVE_ERROR HandleEventElement(TLVReader& reader, void *appState);
+static WEAVE_ERROR IndexEventList(TLVReader& reader, EventIndexBuilder& builder);
+static bool QueryEventIndex(const EventIndex& index, uint32_t *& matches, uint32_t& matchCount);
+static void PrintEvent(const EventIndexEntry& entry, const uint8_t *log);
+static void _DumpWriter(const char *aFormat, ...);
+static double GetElapsedMS(const struct timespec& start);
+
+static OptionDef gCmdOptionDefs[] =
+{
+    { "profile",    kArgumentRequired, 'p' },
+    { "type",       kArgumentRequired, 't' },
+    { "importance", kArgumentRequired, 'i' },
+    { "event-id",   kArgumentRequired, 'e' },
+    { "time",       kArgumentRequired, 'T' },
+    { "utc-time",   kArgumentRequired, 'u' },
+    { "index",      kArgumentRequired, 'x' },
+    { "count",      kNoArgument,       'c' },
+    { "dump",       kNoArgument,       'd' },
+    { "verbose",    kNoArgument,       'V' },
+    { NULL }
+};
+
+static const char *const gCmdOptionHelp =
+    "   -p, --profile <profile-id>\n"
+    "\n"
+    "       Select events from the given trait profile (e.g. 0x235A0010).  May be\n"
+    "       given more than once.\n"
+    "\n"
+    "   -t, --type <event-type>\n"
+    "\n"
+    "       Select events of the given type.\n"
+    "\n"
+    "   -i, --importance <importance>\n"
+    "\n"
+    "       Select events of the given importance or higher: production-critical,\n"
+    "       production, info or debug.\n"
+    "\n"
+    "   -e, --event-id <first>[-<last>]\n"
+    "\n"
+    "       Select events with ids in the given range.  Event ids are counted\n"
+    "       separately for each importance.\n"
+    "\n"
+    "   -T, --time <first>[-<last>]\n"
+    "\n"
+    "       Select events with system timestamps, in milliseconds, in the given range.\n"
+    "\n"
+    "   -u, --utc-time <first>[-<last>]\n"
+    "\n"
+    "       Select events with UTC timestamps, in milliseconds since the epoch, in the\n"
+    "       given range.\n"
+    "\n"
+    "   -x, --index <file>\n"
+    "\n"
+    "       Keep the index of the event log in the given file.  The index is built\n"
+    "       when the file does not exist or is out of date, and reused otherwise, so\n"
+    "       that repeated queries take time proportional to the number of matches.\n"
+    "\n"
+    "   -c, --count\n"
+    "\n"
+    "       Print only the number of matching events.\n"
+    "\n"
+    "   -d, --dump\n"
+    "\n"
+    "       Print the TLV of each matching event.\n"
+    "\n"
+    "   -V, --verbose\n"
+    "\n"
+    "       Report the time taken to index the log and to run the query on stderr.\n"
+    "\n"
+    ;
+
+static OptionSet gCmdOptions =
+{
+    HandleOption,
+    gCmdOptionDefs,
+    "COMMAND OPTIONS",
+    gCmdOptionHelp
+};
+
+static HelpOptions gHelpOptions(
+    CMD_NAME,
+    "Usage: " CMD_NAME " [ <options...> ] <event-log-file>\n",
+    WEAVE_VERSION_STRING "\n" COPYRIGHT_STRING,
+    "Find events in a captured Weave event log.\n"
+    "\n"
+    "ARGUMENTS\n"
+    "\n"
+    "  <event-log-file>\n"
+    "\n"
+    "       A file containing a sequence of events, as fetched from the event\n"
+    "       log, or of WDM notifications carrying event lists.\n"
+    "\n"
+);
+
+static OptionSet *gCmdOptionSets[] =
+{
+    &gCmdOptions,
+    &gHelpOptions,
+    NULL
+};
+
+static const char *gLogFileName = NULL;
+static const char *gIndexFileName = NULL;
+static uint32_t gProfileIds[kMaxProfileFilters];
+static uint8_t gProfileIdCount = 0;
+static bool gFilterType = false;
+static uint32_t gType = 0;
+static uint8_t gMaxImportance = kImportanceType_Last;
+static bool gFilterId = false;
+static uint64_t gFirstId = 0;
+static uint64_t gLastId = UINT64_MAX;
+static bool gFilterTime = false;
+static uint64_t gFirstTime = 0;
+static uint64_t gLastTime = UINT64_MAX;
+static bool gFilterUTCTime = false;
+static uint64_t gFirstUTCTime = 0;
+static uint64_t gLastUTCTime = UINT64_MAX;
+static bool gCountOnly = false;
+static bool gDump = false;
+static bool gVerbose = false;
+
+static const char *const sImportanceNames[] = { "production-critical", "production", "info", "debug" };
+
+bool Cmd_QueryEvents(int argc, char *argv[])
+{
+    bool res = true;
+    int fd = -1;
+    struct stat st;
+    uint8_t *log = NULL;
+    EventIndex index;
+    uint32_t *matches = NULL;
+    uint32_t matchCount = 0;
+    struct timespec startTime;
+
+    memset(&index, 0, sizeof(index));
+
+    if (argc == 1)
+    {
+        gHelpOptions.PrintBriefUsage(stderr);
+        ExitNow(res = true);
+    }
+
+    if (!ParseArgs(CMD_NAME, argc, argv, gCmdOptionSets, HandleNonOptionArgs))
+    {
+        ExitNow(res = false);
+    }
+
+    fd = open(gLogFileName, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || fstat(fd, &st) < 0)
+    {
+        fprintf(stderr, "weave: Error reading %s: %s\n", gLogFileName, strerror(errno));
+        ExitNow(res = false);
+    }
+
+    if (st.st_size > 0)
+    {
+        log = static_cast<uint8_t *>(mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0));
+        if (log == MAP_FAILED)
+        {
+            log = NULL;
+            fprintf(stderr, "weave: Error reading %s: %s\n", gLogFileName, strerror(errno));
+            ExitNow(res = false);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    if (gIndexFileName != NULL && LoadEventIndex(gIndexFileName, st, index))
+    {
+        if (gVerbose)
+            fprintf(stderr, "Loaded index of %" PRIu32 " events in %.3f ms\n", index.Header->EventCount, GetElapsedMS(startTime));
+    }
+
+    else
+    {
+        if (!BuildEventIndex(log, st.st_size, st, index))
+            ExitNow(res = false);
+
+        if (gVerbose)
+            fprintf(stderr, "Indexed %" PRIu32 " events in %.3f ms\n", index.Header->EventCount, GetElapsedMS(startTime));
+
+        if (gIndexFileName != NULL && !SaveEventIndex(gIndexFileName, index))
+            ExitNow(res = false);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    if (!QueryEventIndex(index, matches, matchCount))
+        ExitNow(res = false);
+
+    if (gVerbose)
+        fprintf(stderr, "Found %" PRIu32 " matching events in %.3f ms\n", matchCount, GetElapsedMS(startTime));
+
+    if (gCountOnly)
+        printf("%" PRIu32 "\n", matchCount);
+    else
+        for (uint32_t i = 0; i < matchCount; i++)
+            PrintEvent(index.Entries[matches[i]], log);
+
+    if (fflush(stdout) != 0 || ferror(stdout))
+    {
+        fprintf(stderr, "weave: Error writing output: %s\n", strerror(errno));
+        ExitNow(res = false);
+    }
+
+exit:
+    if (matches != NULL)
+        free(matches);
+    FreeEventIndex(index);
+    if (log != NULL)
+        munmap(log, st.st_size);
+    if (fd >= 0)
+        close(fd);
+    return res;
+}
+
+bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg)
+{
+    uint64_t first, last;
+
+    switch (id)
+    {
+    case 'p':
+        if (gProfileIdCount == kMaxProfileFilters)
+        {
+            PrintArgError("%s: Too many profiles specified\n", progName);
+            return false;
+        }
+        if (!ParseInt(arg, gProfileIds[gProfileIdCount], 0))
+        {
+            PrintArgError("%s: Invalid value specified for profile id: %s\n", progName, arg);
+            return false;
+        }
+        gProfileIdCount++;
+        break;
+    case 't':
+        if (!ParseInt(arg, gType, 0))
+        {
+            PrintArgError("%s: Invalid value specified for event type: %s\n", progName, arg);
+            return false;
+        }
+        gFilterType = true;
+        break;
+    case 'i':
+        if (!ParseImportance(arg, gMaxImportance))
+        {
+            PrintArgError("%s: Invalid value specified for importance: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    case 'e':
+        if (!ParseUInt64Range(arg, first, last))
+        {
+            PrintArgError("%s: Invalid value specified for event id range: %s\n", progName, arg);
+            return false;
+        }
+        gFilterId = true;
+        gFirstId = first;
+        gLastId = last;
+        break;
+    case 'T':
+        if (!ParseUInt64Range(arg, first, last))
+        {
+            PrintArgError("%s: Invalid value specified for time range: %s\n", progName, arg);
+            return false;
+        }
+        gFilterTime = true;
+        gFirstTime = first;
+        gLastTime = last;
+        break;
+    case 'u':
+        if (!ParseUInt64Range(arg, first, last))
+        {
+            PrintArgError("%s: Invalid value specified for UTC time range: %s\n", progName, arg);
+            return false;
+        }
+        gFilterUTCTime = true;
+        gFirstUTCTime = first;
+        gLastUTCTime = last;
+        break;
+    case 'x':
+        gIndexFileName = arg;
+        break;
+    case 'c':
+        gCountOnly = true;
+        break;
+    case 'd':
+        gDump = true;
+        break;
+    case 'V':
+        gVerbose = true;
+        break;
+    default:
+        PrintArgError("%s: INTERNAL ERROR: Unhandled option: %s\n", progName, name);
+        return false;
+    }
+
+    return true;
+}
+
+bool HandleNonOptionArgs(const char *progName, int argc, char *argv[])
+{
+    if (argc == 0)
+    {
+        PrintArgError("%s: Please specify the name of the event log file.\n", progName);
+        return false;
+    }
+
+    if (argc > 1)
+    {
+        PrintArgError("%s: Unexpected argument: %s\n", progName, argv[1]);
+        return false;
+    }
+
+    gLogFileName = argv[0];
+
+    return true;
+}
+
+bool ParseImportance(const char *str, uint8_t& importance)
+{
+    for (uint8_t i = 0; i < sizeof(sImportanceNames) / sizeof(sImportanceNames[0]); i++)
+    {
+        if (strcasecmp(str, sImportanceNames[i]) == 0)
+        {
+            importance = kImportanceType_First + i;
+            return true;
+        }
+    }
+
+    return ParseInt(str, importance) && importance >= kImportanceType_First && importance <= kImportanceType_Last;
+}
+
+bool ParseUInt64Range(const char *str, uint64_t& first, uint64_t& last)
+{
+    char *end;
+
+    if (*str < '0' || *str > '9')
+        return false;
+
+    errno = 0;
+    first = strtoull(str, &end, 0);
+    if (errno != 0)
+        return false;
+
+    if (*end == 0)
+    {
+        last = first;
+        return true;
+    }
+
+    if (*end != '-')
+        return false;
+
+    str = end + 1;
+    if (*str < '0' || *str > '9')
+        return false;
+
+    last = strtoull(str, &end, 0);
+    return errno == 0 && *end == 0 && first <= last;
+}
+
+WEAVE_ERROR IndexEvent(TLVReader& reader, EventDecodeContext& context, EventIndexBuilder& builder)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    EventIndexEntry entry;
+    EventHeader header;
+
+    memset(&entry, 0, sizeof(entry));
+
+    // Events are anonymous structures, so their head is just the control byte.
+    entry.Offset = (reader.GetReadPoint() - 1) - builder.LogStart;
+
+    err = DecodeEventHeader(reader, context, header, HandleEventElement, &builder);
+    SuccessOrExit(err);
+
+    VerifyOrExit(!header.IsEventList, );
+
+    entry.Length = (uint32_t)((reader.GetReadPoint() - builder.LogStart) - entry.Offset);
+    entry.Id = header.Id;
+    entry.ProfileId = header.ProfileId;
+    entry.Type = header.Type;
+    entry.Importance = header.Importance;
+    if (header.Fields & kEventField_SystemTimestamp)
+        entry.SystemTimestamp = header.SystemTimestamp;
+    if (header.Fields & kEventField_UTCTimestamp)
+    {
+        entry.UTCTimestamp = header.UTCTimestamp;
+        entry.HasUTCTimestamp = true;
+    }
+
+    if (builder.EventCount == builder.MaxEventCount)
+    {
+        uint32_t newMaxEventCount = (builder.MaxEventCount != 0) ? builder.MaxEventCount * 2 : 1024;
+        EventIndexEntry *newEntries;
+
+        VerifyOrExit(newMaxEventCount > builder.MaxEventCount, err = WEAVE_ERROR_NO_MEMORY);
+
+        newEntries = (EventIndexEntry *)realloc(builder.Entries, newMaxEventCount * sizeof(EventIndexEntry));
+        VerifyOrExit(newEntries != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        builder.Entries = newEntries;
+        builder.MaxEventCount = newMaxEventCount;
+    }
+
+    builder.Entries[builder.EventCount++] = entry;
+
+exit:
+    return err;
+}
+
+/**
+ * Index the events of a WDM notification.  The other elements of an event
+ * are read from the log when it is printed.
+ */
+WEAVE_ERROR HandleEventElement(TLVReader& reader, void *appState)
+{
+    if (reader.GetTag() != ContextTag(NotificationRequest::kCsTag_EventList))
+        return WEAVE_NO_ERROR;
+
+    return IndexEventList(reader, *static_cast<EventIndexBuilder *>(appState));
+}
+
+WEAVE_ERROR IndexEventList(TLVReader& reader, EventIndexBuilder& builder)
+{
+    WEAVE_ERROR err;
+    EventDecodeContext context;
+    TLVType outerContainerType;
+
+    // As in EventProcessor::ParseEventList(), each list of events is decoded afresh.
+    memset(&context, 0, sizeof(context));
+
+    err = reader.EnterContainer(outerContainerType);
+    SuccessOrExit(err);
+
+    while ((err = reader.Next()) == WEAVE_NO_ERROR)
+    {
+        err = IndexEvent(reader, context, builder);
+        SuccessOrExit(err);
+    }
+    VerifyOrExit(err == WEAVE_END_OF_TLV, );
+
+    err = reader.ExitContainer(outerContainerType);
+
+exit:
+    return err;
+}
+
+static const EventIndexEntry *sSortEntries;
+static EventOrder sSortOrder;
+
+static void GetOrderKey(const EventIndexEntry& entry, EventOrder order, uint64_t key[3])
+{
+    switch (order)
+    {
+    case kEventOrder_Time:
+        key[0] = entry.SystemTimestamp;
+        key[1] = 0;
+        key[2] = 0;
+        break;
+    case kEventOrder_UTCTime:
+        key[0] = entry.UTCTimestamp;
+        key[1] = 0;
+        key[2] = 0;
+        break;
+    case kEventOrder_Profile:
+        key[0] = entry.ProfileId;
+        key[1] = entry.Type;
+        key[2] = entry.SystemTimestamp;
+        break;
+    default:
+        key[0] = entry.Importance;
+        key[1] = entry.Id;
+        key[2] = 0;
+        break;
+    }
+}
+
+static int CompareKeys(const uint64_t *a, const uint64_t *b, uint8_t keyLen)
+{
+    for (uint8_t i = 0; i < keyLen; i++)
+        if (a[i] != b[i])
+            return (a[i] < b[i]) ? -1 : 1;
+    return 0;
+}
+
+static int CompareEntries(const void *a, const void *b)
+{
+    const uint32_t posA = *(const uint32_t *)a, posB = *(const uint32_t *)b;
+    uint64_t keyA[3], keyB[3];
+    int res;
+
+    GetOrderKey(sSortEntries[posA], sSortOrder, keyA);
+    GetOrderKey(sSortEntries[posB], sSortOrder, keyB);
+
+    res = CompareKeys(keyA, keyB, 3);
+    if (res == 0)
+        res = (posA < posB) ? -1 : (posA > posB);
+    return res;
+}
+
+static int ComparePositions(const void *a, const void *b)
+{
+    const uint32_t posA = *(const uint32_t *)a, posB = *(const uint32_t *)b;
+
+    return (posA < posB) ? -1 : (posA > posB);
+}
+
+bool BuildEventIndex(const uint8_t *log, uint64_t logSize, const struct stat& logStat, EventIndex& index)
+{
+    bool res = true;
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    EventIndexBuilder builder;
+    EventDecodeContext context;
+    TLVReader reader;
+    uint64_t offset = 0;
+    uint8_t *storage;
+
+    memset(&builder, 0, sizeof(builder));
+    memset(&context, 0, sizeof(context));
+    builder.LogStart = log;
+
+    // Read each top-level element with a fresh reader, so that logs larger than a reader can count are handled.
+    while (offset < logSize)
+    {
+        uint64_t remaining = logSize - offset;
+
+        reader.Init(log + offset, (remaining < UINT32_MAX) ? (uint32_t)remaining : UINT32_MAX);
+
+        err = reader.Next();
+        SuccessOrExit(err);
+
+        err = IndexEvent(reader, context, builder);
+        SuccessOrExit(err);
+
+        offset = reader.GetReadPoint() - log;
+    }
+
+    index.Size = sizeof(EventIndexHeader) + builder.EventCount * (sizeof(EventIndexEntry) + kEventOrder_Count * sizeof(uint32_t));
+    storage = (uint8_t *)malloc(index.Size);
+    VerifyOrExit(storage != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+    index.Header = (EventIndexHeader *)storage;
+    memset(index.Header, 0, sizeof(EventIndexHeader));
+    memcpy(index.Header->Magic, "WEVX", 4);
+    index.Header->Version = kEventIndexVersion;
+    index.Header->LogSize = logSize;
+    index.Header->LogModTimeSec = logStat.st_mtim.tv_sec;
+    index.Header->LogModTimeNSec = logStat.st_mtim.tv_nsec;
+    index.Header->EventCount = builder.EventCount;
+
+    storage += sizeof(EventIndexHeader);
+    if (builder.EventCount != 0)
+        memcpy(storage, builder.Entries, builder.EventCount * sizeof(EventIndexEntry));
+    index.Entries = (const EventIndexEntry *)storage;
+    storage += builder.EventCount * sizeof(EventIndexEntry);
+
+    sSortEntries = index.Entries;
+    for (int order = 0; order < kEventOrder_Count; order++)
+    {
+        uint32_t *positions = (uint32_t *)storage;
+
+        for (uint32_t i = 0; i < builder.EventCount; i++)
+            positions[i] = i;
+
+        sSortOrder = (EventOrder)order;
+        qsort(positions, builder.EventCount, sizeof(uint32_t), CompareEntries);
+
+        index.Orders[order] = positions;
+        storage += builder.EventCount * sizeof(uint32_t);
+    }
+
+exit:
+    if (builder.Entries != NULL)
+        free(builder.Entries);
+    if (err != WEAVE_NO_ERROR)
+    {
+        fprintf(stderr, "weave: Error reading event at offset %" PRIu64 " of %s: %s\n", offset, gLogFileName, nl::ErrorStr(err));
+        res = false;
+    }
+    return res;
+}
+
+bool LoadEventIndex(const char *fileName, const struct stat& logStat, EventIndex& index)
+{
+    int fd;
+    struct stat st;
+    void *map;
+    const EventIndexHeader *header;
+    const uint8_t *p;
+
+    fd = open(fileName, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(EventIndexHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    // Rebuild the index if it does not match the log.
+    header = (const EventIndexHeader *)map;
+    if (memcmp(header->Magic, "WEVX", 4) != 0 || header->Version != kEventIndexVersion ||
+        header->LogSize != (uint64_t)logStat.st_size || header->LogModTimeSec != logStat.st_mtim.tv_sec ||
+        header->LogModTimeNSec != logStat.st_mtim.tv_nsec ||
+        (uint64_t)st.st_size != sizeof(EventIndexHeader) +
+                                    (uint64_t)header->EventCount * (sizeof(EventIndexEntry) + kEventOrder_Count * sizeof(uint32_t)))
+    {
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    index.Header = (EventIndexHeader *)map;
+    index.Size = st.st_size;
+    index.Mapped = true;
+
+    p = (const uint8_t *)map + sizeof(EventIndexHeader);
+    index.Entries = (const EventIndexEntry *)p;
+    p += header->EventCount * sizeof(EventIndexEntry);
+    for (int order = 0; order < kEventOrder_Count; order++)
+    {
+        index.Orders[order] = (const uint32_t *)p;
+        p += header->EventCount * sizeof(uint32_t);
+    }
+
+    // Rebuild the index if it refers to events outside the log, e.g. because it was damaged.
+    for (uint32_t i = 0; i < header->EventCount; i++)
+    {
+        const EventIndexEntry& entry = index.Entries[i];
+
+        if (entry.Offset > header->LogSize || entry.Length > header->LogSize - entry.Offset)
+            ExitNow(FreeEventIndex(index));
+
+        for (int order = 0; order < kEventOrder_Count; order++)
+            if (index.Orders[order][i] >= header->EventCount)
+                ExitNow(FreeEventIndex(index));
+    }
+
+exit:
+    return index.Header != NULL;
+}
+
+bool SaveEventIndex(const char *fileName, const EventIndex& index)
+{
+    bool res = true;
+    FILE *file;
+
+    file = fopen(fileName, "w+b");
+    if (file == NULL)
+    {
+        fprintf(stderr, "weave: Unable to create %s: %s\n", fileName, strerror(errno));
+        ExitNow(res = false);
+    }
+
+    if (fwrite(index.Header, 1, index.Size, file) != index.Size || fflush(file) != 0)
+    {
+        fprintf(stderr, "weave: Error writing %s: %s\n", fileName, strerror(errno));
+        ExitNow(res = false);
+    }
+
+exit:
+    if (file != NULL)
+        fclose(file);
+    if (!res)
+        unlink(fileName);
+    return res;
+}
+
+void FreeEventIndex(EventIndex& index)
+{
+    if (index.Header == NULL)
+        return;
+
+    if (index.Mapped)
+        munmap(index.Header, index.Size);
+    else
+        free(index.Header);
+
+    memset(&index, 0, sizeof(index));
+}
+
+/**
+ * Find the first position in an ordering whose key, compared on the first
+ * keyLen fields, is not less than (or, if upper is set, greater than) the
+ * given key.
+ */
+static uint32_t FindInOrder(const EventIndex& index, EventOrder order, const uint64_t *key, uint8_t keyLen, bool upper)
+{
+    const uint32_t *positions = index.Orders[order];
+    uint32_t low = 0, high = index.Header->EventCount;
+
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        uint64_t midKey[3];
+        int res;
+
+        GetOrderKey(index.Entries[positions[mid]], order, midKey);
+        res = CompareKeys(midKey, key, keyLen);
+
+        if (res < 0 || (upper && res == 0))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+static bool MatchesQuery(const EventIndexEntry& entry)
+{
+    bool profileMatches = (gProfileIdCount == 0);
+
+    for (uint8_t i = 0; i < gProfileIdCount && !profileMatches; i++)
+        profileMatches = (entry.ProfileId == gProfileIds[i]);
+
+    return profileMatches && entry.Importance <= gMaxImportance && (!gFilterType || entry.Type == gType) &&
+        (!gFilterId || (entry.Id >= gFirstId && entry.Id <= gLastId)) &&
+        (!gFilterTime || (entry.SystemTimestamp >= gFirstTime && entry.SystemTimestamp <= gLastTime)) &&
+        (!gFilterUTCTime || (entry.HasUTCTimestamp && entry.UTCTimestamp >= gFirstUTCTime && entry.UTCTimestamp <= gLastUTCTime));
+}
+
+static void AddMatches(const EventIndex& index, EventOrder order, uint32_t first, uint32_t last, uint32_t *matches, uint32_t& matchCount)
+{
+    for (uint32_t i = first; i < last; i++)
+    {
+        uint32_t pos = index.Orders[order][i];
+
+        if (MatchesQuery(index.Entries[pos]))
+            matches[matchCount++] = pos;
+    }
+}
+
+bool QueryEventIndex(const EventIndex& index, uint32_t *& matches, uint32_t& matchCount)
+{
+    const uint32_t eventCount = index.Header->EventCount;
+    uint64_t low[3], high[3];
+
+    matchCount = 0;
+    matches = (uint32_t *)malloc((eventCount != 0 ? eventCount : 1) * sizeof(uint32_t));
+    if (matches == NULL)
+    {
+        fprintf(stderr, "Memory allocation error\n");
+        return false;
+    }
+
+    // Scan only the range of the most selective ordering that covers the query.
+    if (gProfileIdCount != 0)
+    {
+        for (uint8_t i = 0; i < gProfileIdCount; i++)
+        {
+            uint8_t keyLen = gFilterType ? (gFilterTime ? 3 : 2) : 1;
+
+            // Skip duplicate profiles, whose events would otherwise be reported twice.
+            bool duplicate = false;
+            for (uint8_t j = 0; j < i; j++)
+                duplicate = duplicate || gProfileIds[j] == gProfileIds[i];
+            if (duplicate)
+                continue;
+
+            low[0] = high[0] = gProfileIds[i];
+            low[1] = high[1] = gType;
+            low[2] = gFirstTime;
+            high[2] = gLastTime;
+
+            AddMatches(index, kEventOrder_Profile, FindInOrder(index, kEventOrder_Profile, low, keyLen, false),
+                       FindInOrder(index, kEventOrder_Profile, high, keyLen, true), matches, matchCount);
+        }
+    }
+
+    else if (gFilterId)
+    {
+        for (uint8_t importance = kImportanceType_First; importance <= gMaxImportance; importance++)
+        {
+            low[0] = high[0] = importance;
+            low[1] = gFirstId;
+            high[1] = gLastId;
+
+            AddMatches(index, kEventOrder_Id, FindInOrder(index, kEventOrder_Id, low, 2, false),
+                       FindInOrder(index, kEventOrder_Id, high, 2, true), matches, matchCount);
+        }
+    }
+
+    else if (gFilterTime)
+    {
+        low[0] = gFirstTime;
+        high[0] = gLastTime;
+
+        AddMatches(index, kEventOrder_Time, FindInOrder(index, kEventOrder_Time, low, 1, false),
+                   FindInOrder(index, kEventOrder_Time, high, 1, true), matches, matchCount);
+    }
+
+    else if (gFilterUTCTime)
+    {
+        low[0] = gFirstUTCTime;
+        high[0] = gLastUTCTime;
+
+        AddMatches(index, kEventOrder_UTCTime, FindInOrder(index, kEventOrder_UTCTime, low, 1, false),
+                   FindInOrder(index, kEventOrder_UTCTime, high, 1, true), matches, matchCount);
+    }
+
+    else
+    {
+        for (uint32_t pos = 0; pos < eventCount; pos++)
+            if (MatchesQuery(index.Entries[pos]))
+                matches[matchCount++] = pos;
+    }
+
+    // Report the matches in log order.
+    qsort(matches, matchCount, sizeof(uint32_t), ComparePositions);
+
+    return true;
+}
+
+void PrintEvent(const EventIndexEntry& entry, const uint8_t *log)
+{
+    const char *importanceName = (entry.Importance >= kImportanceType_First && entry.Importance <= kImportanceType_Last) ?
+        sImportanceNames[entry.Importance - kImportanceType_First] : "unknown";
+
+    printf("%s id %" PRIu64 " time %" PRIu64, importanceName, entry.Id, entry.SystemTimestamp);
+    if (entry.HasUTCTimestamp)
+        printf(" utc %" PRIu64, entry.UTCTimestamp);
+    printf(" profile 0x%08" PRIX32 " type %" PRIu32 " offset %" PRIu64 "\n", entry.ProfileId, entry.Type, entry.Offset);
+
+    if (gDump)
+    {
+        TLVReader reader;
+
+        reader.Init(log + entry.Offset, entry.Length);
+        nl::Weave::TLV::Debug::Dump(reader, _DumpWriter);
+    }
+}
+
+static void _DumpWriter(const char *aFormat, ...)
+{
+    va_list args;
+
+    va_start(args, aFormat);
+
+    vprintf(aFormat, args);
+
+    va_end(args);
+}
+
+double GetElapsedMS(const struct timespec& start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start.tv_sec) * 1e3 + (now.tv_nsec - start.tv_nsec) / 1e6;
+}
@@ -0,0 +1,184 @@
+/*
+ *
+ *    Copyright (c) 2013-2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements utility functions for decoding captured
+ *      Weave event logs.
+ *
+ */
+
+#include <string.h>
+
+#include <Weave/Profiles/data-management/DataManagement.h>
+
+#include "weave-tool.h"
+
+using namespace nl::Weave::TLV;
+using namespace nl::Weave::Profiles::DataManagement;
+
+/**
+ * Decode the header of an event in an event log, on which the reader is
+ * positioned, resolving the fields that are implicit or delta-encoded in the
+ * log from the context of the events before it.
+ *
+ * The elements of the event that are not part of its header, including the
+ * event list of a WDM notification, are passed to the given handler, if any.
+ * The context is only advanced by events, not by notifications.
+ */
+WEAVE_ERROR DecodeEventHeader(TLVReader& reader, EventDecodeContext& context, EventHeader& header,
+                              EventElementHandler handler, void *appState)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TLVType outerContainerType;
+    bool hasImportance = false, hasType = false;
+    bool hasSystemTimestamp = false, hasUTCTimestamp = false;
+    uint64_t value;
+
+    VerifyOrExit(reader.GetTag() == AnonymousTag, err = WEAVE_ERROR_TLV_TAG_NOT_FOUND);
+    VerifyOrExit(reader.GetType() == kTLVType_Structure, err = WEAVE_ERROR_WRONG_TLV_TYPE);
+
+    memset(&header, 0, sizeof(header));
+
+    err = reader.EnterContainer(outerContainerType);
+    SuccessOrExit(err);
+
+    while ((err = reader.Next()) == WEAVE_NO_ERROR)
+    {
+        const uint64_t tag = reader.GetTag();
+
+        switch (IsContextTag(tag) ? TagNumFromTag(tag) : UINT32_MAX)
+        {
+        case Event::kCsTag_Importance:
+            err = reader.Get(header.Importance);
+            hasImportance = true;
+            break;
+
+        case Event::kCsTag_Id:
+            err = reader.Get(header.Id);
+            header.Fields |= kEventField_Id;
+            break;
+
+        case Event::kCsTag_Type:
+            err = reader.Get(header.Type);
+            hasType = true;
+            break;
+
+        case Event::kCsTag_SystemTimestamp:
+            err = reader.Get(header.SystemTimestamp);
+            header.Fields |= kEventField_SystemTimestamp;
+            hasSystemTimestamp = true;
+            break;
+
+        case Event::kCsTag_UTCTimestamp:
+            err = reader.Get(header.UTCTimestamp);
+            header.Fields |= kEventField_UTCTimestamp;
+            hasUTCTimestamp = true;
+            break;
+
+        case Event::kCsTag_DeltaSystemTime:
+            err = reader.Get(value);
+            header.SystemTimestamp = context.SystemTimestamp + (int64_t)value;
+            header.Fields |= kEventField_SystemTimestamp;
+            break;
+
+        case Event::kCsTag_DeltaUTCTime:
+            err = reader.Get(value);
+            header.UTCTimestamp = context.UTCTimestamp + (int64_t)value;
+            header.Fields |= kEventField_UTCTimestamp;
+            break;
+
+        case Event::kCsTag_TraitProfileId:
+            // Either the profile id, or an array of the profile id and the schema versions.
+            if (reader.GetType() == kTLVType_Array)
+            {
+                TLVType arrayContainerType;
+
+                err = reader.EnterContainer(arrayContainerType);
+                SuccessOrExit(err);
+                err = reader.Next();
+                SuccessOrExit(err);
+                err = reader.Get(header.ProfileId);
+                SuccessOrExit(err);
+                err = reader.ExitContainer(arrayContainerType);
+            }
+            else
+            {
+                err = reader.Get(header.ProfileId);
+            }
+            break;
+
+        case NotificationRequest::kCsTag_EventList:
+            // A WDM notification, rather than an event.
+            VerifyOrExit(reader.GetType() == kTLVType_Array, err = WEAVE_ERROR_WRONG_TLV_TYPE);
+            header.IsEventList = true;
+            if (handler != NULL)
+                err = handler(reader, appState);
+            break;
+
+        default:
+            if (handler != NULL)
+                err = handler(reader, appState);
+            break;
+        }
+
+        SuccessOrExit(err);
+    }
+    VerifyOrExit(err == WEAVE_END_OF_TLV, );
+
+    err = reader.ExitContainer(outerContainerType);
+    SuccessOrExit(err);
+
+    VerifyOrExit(!header.IsEventList, );
+
+    // Fill in the fields that were implicit in the encoding from the preceding events.
+    if (hasImportance)
+        context.Importance = header.Importance;
+    else
+        header.Importance = context.Importance;
+
+    if (header.Fields & kEventField_Id)
+    {
+        context.Id = header.Id;
+        context.Unresolved &= ~kEventField_Id;
+    }
+    else
+        header.Id = ++context.Id;
+
+    if (hasType)
+        context.Type = header.Type;
+    else
+        header.Type = context.Type;
+
+    if (header.Fields & kEventField_SystemTimestamp)
+        context.SystemTimestamp = header.SystemTimestamp;
+    else
+        header.SystemTimestamp = context.SystemTimestamp;
+    if (hasSystemTimestamp)
+        context.Unresolved &= ~kEventField_SystemTimestamp;
+
+    if (header.Fields & kEventField_UTCTimestamp)
+        context.UTCTimestamp = header.UTCTimestamp;
+    else
+        header.UTCTimestamp = context.UTCTimestamp;
+    if (hasUTCTimestamp)
+        context.Unresolved &= ~kEventField_UTCTimestamp;
+
+exit:
+    return err;
+}
@@ -34,6 +34,7 @@
 #include <ctype.h>
 #include <getopt.h>
 #include <time.h>
+#include <pthread.h>
 
 #include "weave-tool.h"
 
@@ -65,6 +66,24 @@ static const unsigned char *OBJ_get0_data(const ASN1_OBJECT *obj)
     return obj->data;
 }
 
+// Versions of OpenSSL before 1.1.0 are only safe to use from multiple threads
+// if the application supplies locking callbacks.
+
+static pthread_mutex_t *sOpenSSLLocks;
+
+static void OpenSSLLockingCallback(int mode, int n, const char *file, int line)
+{
+    if (mode & CRYPTO_LOCK)
+        pthread_mutex_lock(&sOpenSSLLocks[n]);
+    else
+        pthread_mutex_unlock(&sOpenSSLLocks[n]);
+}
+
+static unsigned long OpenSSLThreadIdCallback()
+{
+    return (unsigned long)pthread_self();
+}
+
 #endif
 
 bool InitOpenSSL()
@@ -83,6 +102,22 @@ bool InitOpenSSL()
     ERR_load_crypto_strings();
     OpenSSL_add_all_algorithms();
 
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L)
+    if (sOpenSSLLocks == NULL)
+    {
+        sOpenSSLLocks = (pthread_mutex_t *)OPENSSL_malloc(CRYPTO_num_locks() * sizeof(pthread_mutex_t));
+        if (sOpenSSLLocks == NULL)
+        {
+            fprintf(stderr, "Memory allocation error\n");
+            ExitNow(res = false);
+        }
+        for (int i = 0; i < CRYPTO_num_locks(); i++)
+            pthread_mutex_init(&sOpenSSLLocks[i], NULL);
+        CRYPTO_set_id_callback(OpenSSLThreadIdCallback);
+        CRYPTO_set_locking_callback(OpenSSLLockingCallback);
+    }
+#endif
+
     gNIDWeaveDeviceId = OBJ_create("1.3.6.1.4.1.41387.1.1", "WeaveDeviceId", "WeaveDeviceId");
     if (gNIDWeaveDeviceId == 0)
         ReportOpenSSLErrorAndExit("OBJ_create", res = false);
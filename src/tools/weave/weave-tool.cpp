@@ -65,6 +65,10 @@ static const char *const sHelp =
         "\n"
         "    print-tlv -- Print a Weave TLV object.\n"
         "\n"
+        "    export-events -- Export a Weave event log in columnar form.\n"
+        "\n"
+        "    query-events -- Find events in a Weave event log.\n"
+        "\n"
         "    version -- Print the program version and exit.\n"
         "\n"
         ;
@@ -141,6 +145,12 @@ int main(int argc, char *argv[])
     else if (strcasecmp(argv[1], "print-tlv") == 0 || strcasecmp(argv[1], "printtlv") == 0)
         res = Cmd_PrintTLV(argc - 1, argv + 1);
 
+    else if (strcasecmp(argv[1], "export-events") == 0 || strcasecmp(argv[1], "exportevents") == 0)
+        res = Cmd_ExportEvents(argc - 1, argv + 1);
+
+    else if (strcasecmp(argv[1], "query-events") == 0 || strcasecmp(argv[1], "queryevents") == 0)
+        res = Cmd_QueryEvents(argc - 1, argv + 1);
+
     else
         fprintf(stderr, "weave: Unrecognized command: %s\n", argv[1]);
 
@@ -79,6 +79,45 @@ enum KeyFormat
     kKeyFormat_Weave_Base64
 };
 
+// Header fields of an event in an event log
+enum
+{
+    kEventField_Id                              = 0x01,
+    kEventField_SystemTimestamp                 = 0x02,
+    kEventField_UTCTimestamp                    = 0x04,
+};
+
+/**
+ * State carried from one event to the next while decoding a list of events,
+ * following the rules in EventProcessor::UpdateContextQualifyHeader().
+ */
+struct EventDecodeContext
+{
+    uint64_t Id;
+    uint64_t SystemTimestamp;
+    uint64_t UTCTimestamp;
+    uint32_t Type;
+    uint8_t Importance;
+    uint8_t Unresolved;                         // kEventField_* flags of the values that are relative to an unknown base
+};
+
+/**
+ * Header of an event, as decoded by DecodeEventHeader().
+ */
+struct EventHeader
+{
+    uint64_t Id;
+    uint64_t SystemTimestamp;
+    uint64_t UTCTimestamp;
+    uint32_t ProfileId;
+    uint32_t Type;
+    uint8_t Importance;
+    uint8_t Fields;                             // kEventField_* flags of the fields encoded in the event, as values or deltas
+    bool IsEventList;                           // A WDM notification carrying a list of events, rather than an event
+};
+
+typedef WEAVE_ERROR (*EventElementHandler)(nl::Weave::TLV::TLVReader& reader, void *appState);
+
 extern bool Cmd_GenCACert(int argc, char *argv[]);
 extern bool Cmd_GenDeviceCert(int argc, char *argv[]);
 extern bool Cmd_GenCodeSigningCert(int argc, char *argv[]);
@@ -94,6 +133,8 @@ extern bool Cmd_GenProvisioningData(int argc, char *argv[]);
 extern bool Cmd_ValidateCert(int argc, char *argv[]);
 extern bool Cmd_PrintCert(int argc, char *argv[]);
 extern bool Cmd_PrintTLV(int argc, char *argv[]);
+extern bool Cmd_QueryEvents(int argc, char *argv[]);
+extern bool Cmd_ExportEvents(int argc, char *argv[]);
 
 extern bool ReadCert(const char *fileName, X509 *& cert);
 extern bool ReadCert(const char *fileName, X509 *& cert, CertFormat& origCertFmt);
@@ -140,6 +181,9 @@ extern bool ParseEUI64(const char *str, uint64_t& nodeId);
 extern bool ParseDateTime(const char *str, struct tm& date);
 extern bool ReadFileIntoMem(const char *fileName, uint8_t *& data, uint32_t &dataLen);
 
+extern WEAVE_ERROR DecodeEventHeader(nl::Weave::TLV::TLVReader& reader, EventDecodeContext& context, EventHeader& header,
+                                     EventElementHandler handler, void *appState);
+
 extern int gNIDWeaveDeviceId;
 extern int gNIDWeaveServiceEndpointId;
 extern int gNIDWeaveCAId;